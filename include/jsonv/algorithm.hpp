@@ -13,12 +13,19 @@
 #define __JSONV_ALGORITHM_HPP_INCLUDED__
 
 #include <jsonv/config.hpp>
+#include <jsonv/compiled_path.hpp>
 #include <jsonv/value.hpp>
 #include <jsonv/path.hpp>
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace jsonv
 {
@@ -206,11 +213,73 @@ struct JSONV_PUBLIC diff_result
 /** Find the differences and similarities between the structures of \a left and \a right. If \a left and \a right have
  *  a different \c kind (and the kind difference is not \c kind::integer and \c kind::decimal), \a left and \a right
  *  will be placed directly in the result. If they have the same \c kind and it is scalar, the values get a direct
- *  comparison. If they are the same, the result is moved to \c diff_result::same. If they are different, \a left and
- *  \a right are moved to \c diff_result::left and \c diff_result::right, respectively. For \c kind::array and
+ *  comparison. If they are the same, the result is copied to \c diff_result::same. If they are different, \a left and
+ *  \a right are copied to \c diff_result::left and \c diff_result::right, respectively. For \c kind::array and
  *  \c kind::object, the \c value elements are compared recursively.
+ *  
+ *  Every subtree of \a left and \a right is hashed once up front, so subtrees with different contents are told apart
+ *  without comparing them and only the parts in \c diff_result::same are compared all the way down.
+**/
+JSONV_PUBLIC diff_result diff(const value& left, const value& right);
+
+/** Find an RFC 6902 JSON Patch which turns \a from into \a to. The result is an array of operation objects, such as
+ *  <tt>{ "op": "replace", "path": "/items/3/price", "value": 5 }</tt>, which are meant to be applied in order. The
+ *  operations used are \c "add", \c "remove", \c "replace" and \c "move".
+ *  
+ *  Subtrees which are the same in \a from and \a to are skipped. The members of objects with the same key are compared
+ *  recursively. The elements of arrays are matched up by their contents, so an element which has only moved becomes a
+ *  \c "move" (instead of a series of replacements), and an element which is only in \a to or \a from becomes a single
+ *  \c "add" or \c "remove". The elements which keep their relative order (the longest such run) are never moved.
+ *  Elements which were changed in place are compared recursively if they stay at the same index.
+ *  
+ *  \code
+ *  diff_patch(parse(R"({ "a": [1, 2, 3], "b": "x" })"), parse(R"({ "a": [3, 1, 2], "c": "x" })"))
+ *  // [ { "from": "/a/2", "op": "move", "path": "/a/0" },
+ *  //   { "op": "remove", "path": "/b" },
+ *  //   { "op": "add", "path": "/c", "value": "x" } ]
+ *  \endcode
+**/
+JSONV_PUBLIC value diff_patch(const value& from, const value& to);
+
+/** Error thrown when a JSON Patch can not be applied.
+ *
+ *  \see apply_patch
+**/
+class JSONV_PUBLIC patch_error :
+        public std::runtime_error
+{
+public:
+    explicit patch_error(std::size_t operation_index, const std::string& message);
+
+    virtual ~patch_error() noexcept;
+
+    /** Get the index of the operation in the patch which could not be applied. **/
+    std::size_t operation_index() const;
+
+private:
+    std::size_t _operation_index;
+};
+
+/** Apply the RFC 6902 JSON Patch \a patch (an array of operations, like the ones \c diff_patch makes) to \a target. All
+ *  six operations (\c "add", \c "remove", \c "replace", \c "move", \c "copy" and \c "test") are supported and
+ *  \a target is changed in place.
+ *
+ *  The values along the path to the last location changed are remembered, so an operation on a location near the
+ *  previous one (a sibling, for instance) only walks the part of its path which is different instead of starting from
+ *  the root again.
+ *
+ *  \throws patch_error if an operation is malformed, refers to a location which does not exist or is a \c "test" which
+ *   does not match. The operations before it have already been applied to \a target, so if the patch has to succeed or
+ *   fail as a whole, apply it to a copy (which is cheap if \a target is \c value::make_shareable) and swap the copy in
+ *   when it succeeds.
 **/
-JSONV_PUBLIC diff_result diff(value left, value right);
+JSONV_PUBLIC void apply_patch(value& target, const value& patch);
+
+/** Apply the RFC 7396 JSON Merge Patch \a patch to \a target in place. If \a patch is an object, each of its members
+ *  is merged into the member of \a target with the same key (recursively) and members which are \c null remove the
+ *  key from \a target. If \a patch is anything else, it replaces \a target.
+**/
+JSONV_PUBLIC void apply_merge_patch(value& target, const value& patch);
 
 /** Run a function over the values in the \a input. The behavior of this function is different, depending on the \c kind
  *  of \a input. For scalar kinds (\c kind::integer, \c kind::null, etc), \a func is called once with the value. If
@@ -244,6 +313,97 @@ JSONV_PUBLIC value map(const std::function<value (value)>& func,
                        value&&                             input
                       );
 
+/** Like \c map, but \a func can be anything callable with a <tt>const value&</tt>. It is called directly instead of
+ *  through an \c std::function, so it can be inlined.
+**/
+template <typename FMap>
+value map(FMap&& func, const value& input)
+{
+    switch (input.kind())
+    {
+    case kind::boolean:
+    case kind::decimal:
+    case kind::integer:
+    case kind::null:
+    case kind::string:
+        return func(input);
+    case kind::array:
+    {
+        value out = array();
+        out.reserve(input.size());
+        for (const value& sub : input.as_array())
+            out.push_back(func(sub));
+        return out;
+    }
+    case kind::object:
+    {
+        value out = object();
+        for (const value::object_value_type& sub : input.as_object())
+            out.emplace_hint(out.end_object(), sub.first, func(sub.second));
+        return out;
+    }
+    default:
+        return null;
+    }
+}
+
+/** Like \c map with an rvalue \a input, but \a func can be anything callable with a \c value. It is called directly
+ *  instead of through an \c std::function, so it can be inlined.
+**/
+template <typename FMap>
+value map(FMap&& func, value&& input)
+{
+    switch (input.kind())
+    {
+    case kind::boolean:
+    case kind::decimal:
+    case kind::integer:
+    case kind::null:
+    case kind::string:
+        return func(std::move(input));
+    case kind::array:
+    {
+        value out = array();
+        out.reserve(input.size());
+        for (value& sub : input.as_array())
+            out.push_back(func(std::move(sub)));
+        input = null;
+        return out;
+    }
+    case kind::object:
+    {
+        value out = object();
+        for (value::object_value_type& sub : input.as_object())
+            out.emplace_hint(out.end_object(), sub.first, func(std::move(sub.second)));
+        input = null;
+        return out;
+    }
+    default:
+        return null;
+    }
+}
+
+/** Like \c map, but the elements of an \c array or \c object \a input are split among \a threads threads (all of the
+ *  hardware threads if it is 0). The result is the same as the result of \c map.
+ *  
+ *  \note
+ *  \a func is called on several threads at once, so it must be safe to call that way -- it must not change anything it
+ *  shares with other calls without synchronizing. If \a func throws, elements which have not been started are skipped
+ *  and the exception from the earliest part of \a input is rethrown once every thread has stopped.
+**/
+JSONV_PUBLIC value map_parallel(const std::function<value (const value&)>& func,
+                                const value&                               input,
+                                std::size_t                                threads = 0
+                               );
+
+/** Like \c map_parallel, but the elements of \a input are moved into \a func. Like the rvalue version of \c map, this
+ *  only provides a basic exception-safety guarantee.
+**/
+JSONV_PUBLIC value map_parallel(const std::function<value (value)>& func,
+                                value&&                             input,
+                                std::size_t                         threads = 0
+                               );
+
 /** Recursively walk the provided \a tree and call \a func for each item in the tree.
  *  
  *  \param tree The JSON value to traverse.
@@ -273,6 +433,187 @@ JSONV_PUBLIC void traverse(const value&
                            bool                                                   leafs_only = false
                           );
 
+namespace detail
+{
+
+/** The walk behind \c traverse. The elements of the path to \a tree are the back of \a elements, which borrow the keys
+ *  from the objects in the tree, so only growing \a elements ever allocates.
+**/
+template <typename FVisit>
+void traverse_view(const value& tree, FVisit& func, std::vector<path_element_view>& elements, bool leafs_only)
+{
+    if (!leafs_only || tree.empty() || (tree.kind() != kind::array && tree.kind() != kind::object))
+        func(path_view(elements.data(), elements.size()), tree);
+    
+    if (tree.kind() == kind::object)
+    {
+        for (const auto& field : tree.as_object())
+        {
+            elements.emplace_back(string_view(field.first));
+            traverse_view(field.second, func, elements, leafs_only);
+            elements.pop_back();
+        }
+    }
+    else if (tree.kind() == kind::array)
+    {
+        for (value::size_type idx = 0; idx < tree.size(); ++idx)
+        {
+            elements.emplace_back(idx);
+            traverse_view(tree[idx], func, elements, leafs_only);
+            elements.pop_back();
+        }
+    }
+}
+
+}
+
+/** Like \c traverse, but \a func can be anything callable with a \c path_view (or a <tt>const path&</tt>) and a
+ *  <tt>const value&</tt>. It is called directly instead of through an \c std::function, so it can be inlined. Taking
+ *  the \c path_view avoids building a \c path for each value; callbacks which take a \c path still work, but pay for
+ *  the copy.
+**/
+template <typename FVisit>
+void traverse(const value& tree, FVisit&& func, const path& base_path, bool leafs_only = false)
+{
+    std::vector<path_element_view> elements(base_path.begin(), base_path.end());
+    elements.reserve(elements.size() + 16);
+    detail::traverse_view(tree, func, elements, leafs_only);
+}
+
+/** Like \c traverse, but \a func can be anything callable with a \c path_view (or a <tt>const path&</tt>) and a
+ *  <tt>const value&</tt>.
+**/
+template <typename FVisit>
+void traverse(const value& tree, FVisit&& func, bool leafs_only = false)
+{
+    std::vector<path_element_view> elements;
+    elements.reserve(16);
+    detail::traverse_view(tree, func, elements, leafs_only);
+}
+
+/** Like \c traverse, but the subtrees of \a tree are split among \a threads threads (all of the hardware threads if it
+ *  is 0). Every value is visited exactly once, just as with \c traverse, but not in any particular order. The values
+ *  near the top of \a tree are visited on the calling thread, before the subtrees below them are handed out.
+ *  
+ *  \note
+ *  \a func is called on several threads at once, so it must be safe to call that way. If \a func throws, subtrees which
+ *  have not been started are skipped and one of the exceptions is rethrown once every thread has stopped.
+**/
+JSONV_PUBLIC void traverse_parallel(const value&                                           tree,
+                                    const std::function<void (const path&, const value&)>& func,
+                                    const path&                                            base_path,
+                                    bool                                                   leafs_only = false,
+                                    std::size_t                                            threads    = 0
+                                   );
+
+JSONV_PUBLIC void traverse_parallel(const value&                                           tree,
+                                    const std::function<void (const path&, const value&)>& func,
+                                    bool                                                   leafs_only = false,
+                                    std::size_t                                            threads    = 0
+                                   );
+
+/** Find the value at each of the \a paths in \a tree with a single walk of it. Paths which share a prefix only follow
+ *  that prefix once, so this is much cheaper than calling \c value::at_path for each path when there are many paths
+ *  into the same part of the tree.
+ *  
+ *  \returns A pointer into \a tree for each of the \a paths (in the same order). It is \c nullptr if there is nothing
+ *           at that path, either because a key or index does not exist or because a value on the way is the wrong
+ *           \c kind.
+**/
+JSONV_PUBLIC std::vector<const value*> select(const value& tree, const std::vector<path>& paths);
+
+/** Add up the numbers in the array \a source. Elements which are not numbers are skipped. Integers are added up
+ *  exactly, so the sum is a \c kind::integer unless it does not fit in one (then it is the nearest decimal). If there
+ *  are any decimals, the sum is a \c kind::decimal; decimals are not added up in any particular order, so the last bits
+ *  can differ from adding them one at a time.
+ *  
+ *  An array which has its numbers packed (see \c value::pack_numbers) is added up a few at a time with SIMD
+ *  instructions. Other arrays are walked with plain pointers.
+ *  
+ *  \throws kind_error if \a source is not an array.
+**/
+JSONV_PUBLIC value sum(const value& source);
+
+/** Add up the numbers which \a query matches in \a from (such as <tt>.rows[*].price</tt> for the \c "price" of each
+ *  object in the \c "rows" array), the same way as \c sum of an array.
+**/
+JSONV_PUBLIC value sum(const value& from, const compiled_path& query);
+
+/** Get the smallest number in the array \a source or \c null if there are no numbers in it. Elements which are not
+ *  numbers are skipped. Like \c sum, packed arrays are gone through with SIMD instructions. Which number is the
+ *  smallest is not specified if there are any NaNs.
+ *  
+ *  \throws kind_error if \a source is not an array.
+**/
+JSONV_PUBLIC value min(const value& source);
+
+/** Get the smallest number which \a query matches in \a from, the same way as \c min of an array. **/
+JSONV_PUBLIC value min(const value& from, const compiled_path& query);
+
+/** Get the largest number in the array \a source. This is the opposite of \c min. **/
+JSONV_PUBLIC value max(const value& source);
+
+/** Get the largest number which \a query matches in \a from, the same way as \c max of an array. **/
+JSONV_PUBLIC value max(const value& from, const compiled_path& query);
+
+/** Count the elements of the array \a source which \a pred (called with a <tt>const value&</tt>) returns \c true for.
+ *  The elements of a packed array are given to \a pred without unpacking the array.
+ *  
+ *  \throws kind_error if \a source is not an array.
+**/
+template <typename FPredicate>
+std::size_t count_if(const value& source, FPredicate&& pred)
+{
+    if (source.kind() != kind::array)
+        detail::throw_kind_error(kind::array, source.kind());
+    
+    std::size_t count = 0;
+    std::size_t size  = source.size();
+    if (const std::int64_t* integers = source.packed_integers())
+    {
+        for (std::size_t idx = 0; idx < size; ++idx)
+            count += pred(value(integers[idx])) ? 1 : 0;
+    }
+    else if (const double* decimals = source.packed_decimals())
+    {
+        for (std::size_t idx = 0; idx < size; ++idx)
+            count += pred(value(decimals[idx])) ? 1 : 0;
+    }
+    else
+    {
+        const value* elements = source.array_data();
+        for (std::size_t idx = 0; idx < size; ++idx)
+            count += pred(elements[idx]) ? 1 : 0;
+    }
+    return count;
+}
+
+/** Count the values which \a query matches in \a from which \a pred returns \c true for. **/
+template <typename FPredicate>
+std::size_t count_if(const value& from, const compiled_path& query, FPredicate&& pred)
+{
+    std::size_t count = 0;
+    for (const value* match : query.match(from))
+        count += pred(*match) ? 1 : 0;
+    return count;
+}
+
+/** Split the elements of the array \a source into groups by what \a key matches in each of them. The result is an
+ *  object with a member for each key, which is an array of the elements with that key (in the order they are in
+ *  \a source). String keys are used as they are and other keys are encoded, so the string \c "1" and the integer \c 1
+ *  are the same group. Elements which \a key does not match anything in are left out.
+ *  
+ *  \example
+ *  \code
+ *  value by_user = group_by(events, compiled_path::create(".user"));
+ *  for (const auto& group : by_user.as_object())
+ *      std::cout << group.first << ": " << sum(group.second, compiled_path::create("[*].bytes")) << std::endl;
+ *  \endcode
+ *  
+ *  \throws kind_error if \a source is not an array.
+**/
+JSONV_PUBLIC value group_by(const value& source, const compiled_path& key);
+
 /** This class is used in \c merge_explicit for defining what the function should do in the cases of conflicts. **/
 class JSONV_PUBLIC merge_rules
 {
@@ -296,6 +637,14 @@ public:
      *  \param b is the right-hand \c value to merge.
     **/
     virtual value resolve_type_conflict(path&& current_path, value&& a, value&& b) const = 0;
+
+    /** Called by \c merge_into when merging a \c kind::object and the two objects share a key. The result of the merge
+     *  goes into \a a.
+     *
+     *  The default implementation assigns the result of \c resolve_same_key to \a a. Override this if the keys can be
+     *  merged in place, as \c recursive_merge_rules does.
+    **/
+    virtual void resolve_same_key_into(path&& current_path, value& a, value&& b) const;
 };
 
 /** An implementation of \c merge_rules that allows you to bind whatever functions you want to resolve conflicts. **/
@@ -345,6 +694,9 @@ public:
     /** Recursively calls \c merge_explicit with the two values. **/
     virtual value resolve_same_key(path&& current_path, value&& a, value&& b) const override;
 
+    /** Recursively calls \c merge_into with the two values. **/
+    virtual void resolve_same_key_into(path&& current_path, value& a, value&& b) const override;
+
     /** Calls \c coerce_merge to combine the values. **/
     virtual value resolve_type_conflict(path&& current_path, value&& a, value&& b) const override;
 };
@@ -392,6 +744,38 @@ value merge_explicit(const merge_rules& rules, path current_path, value a, value
                          );
 }
 
+/** Merge \a source into \a target, following the same rules as \c merge_explicit. Instead of building a new tree, this
+ *  changes \a target: the members of \a source with keys \a target does not have are moved over whole, the elements of
+ *  arrays are moved onto the end and only the members with keys in both are merged (with
+ *  \c merge_rules::resolve_same_key_into). Laying several overlays over a large tree this way only allocates for the
+ *  parts which are actually merged.
+ *
+ *  \code
+ *  jsonv::value config = load("defaults.json");
+ *  for (jsonv::value& overlay : overlays)
+ *      jsonv::merge_into(config, std::move(overlay), jsonv::recursive_merge_rules());
+ *  \endcode
+ *
+ *  \param target is the \c value to merge into. It always holds the result, even when \a rules resolve a conflict by
+ *                replacing it with something else.
+ *  \param source is the \c value to merge from. Its contents are moved out, so it is left in an unspecified state.
+ *  \param rules are the rules to merge with (see \c merge_rules).
+ *  \param current_path The current \c path into the \c value that we are merging, used in the same way as the path
+ *                      given to \c merge_explicit.
+ *
+ *  \note
+ *  This only provides a basic exception-safety guarantee: if \a rules throw, \a target and \a source are left with
+ *  whatever was merged before the exception.
+**/
+JSONV_PUBLIC void merge_into(value&             target,
+                             value&&            source,
+                             const merge_rules& rules,
+                             path               current_path = path()
+                            );
+
+/** Merge \a source into \a target with \c throwing_merge_rules. **/
+JSONV_PUBLIC void merge_into(value& target, value&& source);
+
 /** Merges all the provided \a values into a single \c value. If there are any key or type conflicts, an exception will
  *  be thrown.
 **/
@@ -428,7 +812,17 @@ public:
     enum class code
     {
         /** Encountered a number which is NaN or Infinity. **/
-        non_finite_number
+        non_finite_number,
+        /** A value had a \c kind its \c schema does not allow. **/
+        wrong_kind,
+        /** A number was outside of the range its \c schema allows. **/
+        out_of_range,
+        /** The size of a string, array or object was outside of the range its \c schema allows. **/
+        wrong_size,
+        /** An object was missing a key its \c schema requires. **/
+        missing_key,
+        /** An object had a key its \c schema does not know about. **/
+        unexpected_key,
     };
 
 public:
@@ -459,6 +853,9 @@ JSONV_PUBLIC std::ostream& operator<<(std::ostream& os, const validation_error::
  *  lead to the encoder outputting invalid JSON text, which is completely unacceptable. Use this funciton to check that
  *  there will be no information loss when encoding.
  *
+ *  When \a val comes from \c parse, setting \c parse_options::require_finite_numbers makes the parser do this check as
+ *  it goes, so the tree does not have to be walked again.
+ *
  *  \throws validation_error if \a val contains an unrepresentable value.
 **/
 JSONV_PUBLIC void validate(const value& val);
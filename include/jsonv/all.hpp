@@ -155,7 +155,7 @@ namespace jsonv
  *  different iterator types in JSON Voorhees. They are aptly-named \c object_iterator and \c array_iterator. The access
  *  methods for these iterators are \c begin_object / \c end_object and \c begin_array / \c end_array, respectively.
  *  The object interface behaves exactly like you would expect a \c std::map<std::string,jsonv::value> to, while the
- *  array interface behaves just like a \c std::deque<jsonv::value> would.
+ *  array interface behaves just like a \c std::vector<jsonv::value> would.
  *  
  *  \code
  *  #include <jsonv/value.hpp>
@@ -667,7 +667,7 @@ namespace jsonv
  *  int main()
  *  {
  *      jsonv::traverse(jsonv::parse(std::cin),
- *                      [] (const jsonv::path& path, const jsonv::value& value)
+ *                      [] (const jsonv::path_view& path, const jsonv::value& value)
  *                      {
  *                          std::cout << path << "=" << value << std::endl;
  *                      },
@@ -724,20 +724,44 @@ namespace jsonv
 }
 
 #include "algorithm.hpp"
+#include "array_stream.hpp"
+#include "cbor.hpp"
 #include "coerce.hpp"
+#include "columnar.hpp"
+#include "compiled_path.hpp"
+#include "compress.hpp"
 #include "config.hpp"
+#include "coroutine.hpp"
 #include "demangle.hpp"
 #include "encode.hpp"
+#include "encode_static.hpp"
+#include "expected.hpp"
+#include "fd_encoder.hpp"
 #include "forward.hpp"
+#include "frozen_value.hpp"
 #include "functional.hpp"
+#include "key_dictionary.hpp"
+#include "lazy_value.hpp"
+#include "memory_usage.hpp"
+#include "msgpack.hpp"
+#include "ndjson_writer.hpp"
 #include "parse.hpp"
+#include "parse_cache.hpp"
+#include "parse_lines.hpp"
 #include "path.hpp"
+#include "query.hpp"
+#include "schema.hpp"
 #include "serialization.hpp"
 #include "serialization_builder.hpp"
+#include "serialization_static.hpp"
 #include "serialization_util.hpp"
+#include "stats.hpp"
 #include "string_view.hpp"
 #include "tokenizer.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 #include "value.hpp"
+#include "value_index.hpp"
+#include "writer.hpp"
 
 #endif/*__JSONV_ALL_HPP_INCLUDED__*/
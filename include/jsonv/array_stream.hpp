@@ -0,0 +1,157 @@
+/** \file jsonv/array_stream.hpp
+ *  Parse the elements of a huge array one at a time.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_ARRAY_STREAM_HPP_INCLUDED__
+#define __JSONV_ARRAY_STREAM_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/path.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+#include <iosfwd>
+#include <iterator>
+#include <memory>
+
+namespace jsonv
+{
+
+class tokenizer;
+
+/** A single pass over the elements of an array in a document, where each element is parsed as its own \c value when
+ *  the range reaches it. Only the current element is kept in memory, so a document like <tt>[ {...}, {...}, ... ]</tt>
+ *  with millions of records can be processed from a stream. The array is either the whole document or the one at a
+ *  \c path in it; everything the path does not lead to is skipped without being parsed. Nothing after the end of the
+ *  array is read.
+ *
+ *  The \c parse_options are used to parse each element, except \c parse_options::complete_parse and
+ *  \c parse_options::require_document, since an element is not a whole document.
+ *
+ *  \see array_stream
+**/
+class JSONV_PUBLIC array_range
+{
+public:
+    class iterator;
+
+public:
+    /** Read the array at \a at in the document in \a input, which must outlive this instance. **/
+    explicit array_range(std::istream& input, path at = path(), const parse_options& options = parse_options());
+
+    /** Read the array at \a at in the document starting at the next token of \a input, which must outlive this
+     *  instance. When the range has reached its end, the \c ] which closes the array is the current token of \a input.
+    **/
+    explicit array_range(tokenizer& input, path at = path(), const parse_options& options = parse_options());
+
+    array_range(array_range&&) noexcept;
+    array_range& operator=(array_range&&) noexcept;
+    ~array_range() noexcept;
+
+    /** Get an iterator to the current element, finding the array and parsing the first element if that has not been
+     *  done already. Since the input is only read once, every call of \c begin refers to the same position.
+     *
+     *  \throws parse_error if the input is not valid JSON.
+     *  \throws std::out_of_range if nothing is at the path.
+     *  \throws kind_error if the value at the path is not an array.
+    **/
+    iterator begin();
+    iterator end();
+
+    /** The (zero-based) index of the current element in the array. **/
+    std::size_t index() const
+    {
+        return _parsed - 1;
+    }
+
+private:
+    /** Move to the first token of the array at \c _path. **/
+    void find_array();
+
+    /** Parse the next element into \c _current.
+     *
+     *  \returns \c false (and sets \c _finished) if the end of the array has been reached.
+    **/
+    bool next();
+
+private:
+    std::unique_ptr<tokenizer> _owned_tokens; //!< When reading from a stream, the tokenizer for it.
+    tokenizer*                 _tokens;
+    path                       _path;
+    parse_options              _options;
+    value                      _current;
+    std::size_t                _parsed;       //!< The number of elements parsed so far.
+    bool                       _started;
+    bool                       _finished;
+};
+
+/** Iterates over the elements of an \c array_range. Incrementing the iterator parses the next element, which can throw
+ *  \c parse_error.
+**/
+class JSONV_PUBLIC array_range::iterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = value;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const value*;
+    using reference         = const value&;
+
+public:
+    iterator() :
+            _owner(nullptr)
+    { }
+
+    reference operator*() const  { return _owner->_current; }
+    pointer   operator->() const { return &_owner->_current; }
+
+    iterator& operator++()
+    {
+        if (!_owner->next())
+            _owner = nullptr;
+        return *this;
+    }
+
+    bool operator==(const iterator& other) const { return _owner == other._owner; }
+    bool operator!=(const iterator& other) const { return _owner != other._owner; }
+
+private:
+    friend class array_range;
+
+    explicit iterator(array_range* owner) :
+            _owner(owner)
+    { }
+
+private:
+    array_range* _owner;
+};
+
+/** Parse the elements of the array at \a at in \a input one at a time.
+ *
+ *  \example "array_stream"
+ *  \code
+ *  std::ifstream export_file("orders.json");  // { "orders": [ {...}, {...}, ... ] }
+ *  for (const jsonv::value& order : jsonv::array_stream(export_file, jsonv::path({ "orders" })))
+ *      handle(order);
+ *  \endcode
+**/
+JSONV_PUBLIC array_range array_stream(std::istream&        input,
+                                      path                 at      = path(),
+                                      const parse_options& options = parse_options()
+                                     );
+JSONV_PUBLIC array_range array_stream(tokenizer&           input,
+                                      path                 at      = path(),
+                                      const parse_options& options = parse_options()
+                                     );
+
+}
+
+#endif/*__JSONV_ARRAY_STREAM_HPP_INCLUDED__*/
@@ -0,0 +1,143 @@
+/** \file jsonv/cbor.hpp
+ *  Encoding and parsing values as CBOR (RFC 8949), a binary format with the same data model as JSON. There is no
+ *  number formatting or string escaping in either direction, and the output is usually a good deal smaller than the
+ *  text.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_CBOR_HPP_INCLUDED__
+#define __JSONV_CBOR_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/encode.hpp>
+#include <jsonv/forward.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jsonv
+{
+
+/** An encoder which writes CBOR instead of JSON text. Integers use the smallest encoding which holds them and
+ *  decimals use the smallest floating-point width which holds them exactly. Unlike JSON, CBOR can represent infinity
+ *  and NaN, so those are written as they are.
+ *
+ *  Arrays and objects written by \c encode have their size up front. Containers written through a \c writer (or by
+ *  handing this to \c parse) do not have a known size, so they are written with CBOR's indefinite-length encoding,
+ *  which costs one byte more.
+ *
+ *  Like \c buffer_encoder, output is gathered in a buffer and handed off when it fills up or \c flush is called.
+ *
+ *  \example "cbor_encoder"
+ *  \code
+ *  std::string out;
+ *  {
+ *      jsonv::cbor_encoder encoder(out);
+ *      encoder.encode(some_value);
+ *  }
+ *  jsonv::value back = jsonv::parse_cbor(out);
+ *  \endcode
+**/
+class JSONV_PUBLIC cbor_encoder :
+        public encoder
+{
+public:
+    /** Called with the encoded bytes when the buffer is full or is flushed. **/
+    using flush_function = std::function<void (string_view)>;
+
+public:
+    /** Create an instance which appends to \a output. The bytes are in \a output after \c flush is called (or this
+     *  instance is destroyed).
+    **/
+    explicit cbor_encoder(std::string& output);
+
+    /** Create an instance which hands its output to \a flush in chunks of (at most) \a chunk_size bytes. **/
+    explicit cbor_encoder(flush_function flush, std::size_t chunk_size = 4096);
+
+    virtual ~cbor_encoder() noexcept;
+
+    /** Hand the buffered output to the flush function. **/
+    void flush();
+
+    /** The number of bytes which have been written to the buffer since it was last flushed. **/
+    std::size_t size() const;
+
+protected:
+    virtual void write_null() override;
+
+    virtual void write_object_begin() override;
+
+    virtual void write_object_begin_sized(std::size_t count) override;
+
+    virtual void write_object_end() override;
+
+    virtual void write_object_key(string_view key) override;
+
+    virtual void write_object_delimiter() override;
+
+    virtual void write_array_begin() override;
+
+    virtual void write_array_begin_sized(std::size_t count) override;
+
+    virtual void write_array_end() override;
+
+    virtual void write_array_delimiter() override;
+
+    virtual void write_string(string_view value) override;
+
+    virtual void write_integer(std::int64_t value) override;
+
+    virtual void write_decimal(double value) override;
+
+    virtual void write_boolean(bool value) override;
+
+private:
+    void write_head(unsigned major, std::uint64_t argument);
+
+    void write_float(unsigned info, std::uint64_t bits, std::size_t bytes);
+
+    void write_end();
+
+private:
+    std::unique_ptr<detail::output_buffer> _buffer;
+    /** For each open container, was it written with an indefinite length (so its end needs a "break")? **/
+    std::vector<bool>                      _open_indefinite;
+};
+
+/** Encode \a source as CBOR.
+ *
+ *  \see cbor_encoder
+**/
+JSONV_PUBLIC std::string encode_cbor(const value& source);
+
+/** Build a \c value from the CBOR in \a input.
+ *
+ *  Text strings, integers, floating-point numbers (of any width), \c true, \c false and \c null are read as the
+ *  matching \c kind. CBOR's \c undefined is read as \c null, tags are skipped (the tagged item is read as if the tag
+ *  was not there) and both definite and indefinite lengths are allowed. Integers which do not fit in an
+ *  \c std::int64_t become decimals. Byte strings, map keys which are not text and other simple values have no JSON
+ *  equivalent, so they are errors. Text strings are not checked for valid UTF-8.
+ *
+ *  Of the \a options, \c max_structure_depth, \c complete_parse and \c require_finite_numbers are respected. Problems
+ *  are always thrown immediately: there is no way to find the next item in malformed binary input. The reported
+ *  location is on line 1, with the offset into \a input as the character (and one more than that as the column).
+ *
+ *  \throws parse_error if \a input is not valid CBOR or has something which can not be represented as a \c value.
+**/
+JSONV_PUBLIC value parse_cbor(string_view input, const parse_options& options = parse_options());
+
+}
+
+#endif/*__JSONV_CBOR_HPP_INCLUDED__*/
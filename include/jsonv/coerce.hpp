@@ -63,6 +63,16 @@ JSONV_PUBLIC std::nullptr_t coerce_null(const value& from);
 **/
 JSONV_PUBLIC std::map<std::string, value> coerce_object(const value& from);
 
+/** Like \c coerce_object, but the values are moved out of \a from instead of copied. **/
+JSONV_PUBLIC std::map<std::string, value> coerce_object(value&& from);
+
+/** Coerce \a from into a view of its contents. Unlike \c coerce_object, nothing is copied; the view refers into
+ *  \a from, so it is only good for as long as \a from is not changed.
+ *  
+ *  \throws kind_error if \a from is not \c kind::object.
+**/
+JSONV_PUBLIC value::const_object_view coerce_object_view(const value& from);
+
 /** Coerce \a from into a \c vector.
  *  
  *  \returns a vector of the contents of \a from.
@@ -70,11 +80,24 @@ JSONV_PUBLIC std::map<std::string, value> coerce_object(const value& from);
 **/
 JSONV_PUBLIC std::vector<value> coerce_array(const value& from);
 
+/** Like \c coerce_array, but the elements are moved out of \a from instead of copied. **/
+JSONV_PUBLIC std::vector<value> coerce_array(value&& from);
+
+/** Coerce \a from into a view of its contents. Unlike \c coerce_array, nothing is copied; the view refers into
+ *  \a from, so it is only good for as long as \a from is not changed.
+ *  
+ *  \throws kind_error if \a from is not \c kind::array.
+**/
+JSONV_PUBLIC value::const_array_view coerce_array_view(const value& from);
+
 /** Coerce \a from into an \c std::string. If \a from is already \c kind::string, the value is simply returned. If
  *  \a from is any other \c kind, the result will be the same as \c to_string.
 **/
 JSONV_PUBLIC std::string coerce_string(const value& from);
 
+/** Like \c coerce_string, but if \a from is already a \c kind::string, the contents are moved out of it. **/
+JSONV_PUBLIC std::string coerce_string(value&& from);
+
 /** Coerce \a from into an integer. If \a from is a \c decimal lower than the minimum of \c std::int64_t or higher than
  *  the maximum of \c std::int64_t, it is clamped to the lowest or highest value, respectively.
  *  
@@ -121,6 +144,18 @@ JSONV_PUBLIC double coerce_decimal(const value& from);
 **/
 JSONV_PUBLIC bool coerce_boolean(const value& from);
 
+/** \{
+ *  Coerce \a x in place, replacing it with the result of the matching \c coerce_X function. A value which already has
+ *  the target kind is left alone, so nothing is copied. If the conversion throws, \a x is not changed.
+ *  
+ *  \throws kind_error in the same cases as the matching \c coerce_X function.
+**/
+JSONV_PUBLIC void coerce_string_to(value& x);
+JSONV_PUBLIC void coerce_integer_to(value& x);
+JSONV_PUBLIC void coerce_decimal_to(value& x);
+JSONV_PUBLIC void coerce_boolean_to(value& x);
+/** \} **/
+
 /** Combines \a a and \a b in any way possible. The result kind is \e usually based on the kind of \a a and loosely
  *  follows what ECMAScript does when you call \c + on two values (sort of). If you are looking for "predictable", this
  *  is not the function for you. If you are looking for convenience, this is it.
@@ -0,0 +1,224 @@
+/** \file jsonv/columnar.hpp
+ *  Converting arrays of objects into typed columns.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_COLUMNAR_HPP_INCLUDED__
+#define __JSONV_COLUMNAR_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace jsonv
+{
+
+class array_range;
+
+/** The type of the values in a \c column. Columns start out as \c null and are widened as values of other kinds are
+ *  added: \c integer becomes \c decimal when a decimal is added to it and any column becomes \c json when it gets a
+ *  value which does not fit its type (or an array or object).
+**/
+enum class column_type
+{
+    null,       //!< Nothing but nulls (or missing values) so far.
+    boolean,
+    integer,
+    decimal,
+    string,
+    json,       //!< The compact JSON encoding of each value, as a string.
+};
+
+JSONV_PUBLIC std::ostream& operator<<(std::ostream& os, const column_type& type);
+
+/** The values of one member across all of the rows of a \c columnar_table. The buffers follow the layouts of Apache
+ *  Arrow, so they can be handed to an Arrow array (or anything else which reads that format) without being converted:
+ *
+ *   - \c validity is a bitmap with a bit for each row (least significant bit first), which is 1 where the row has a
+ *     value. Rows without one are \c null in the input or did not have the member at all.
+ *   - \c boolean columns are a bitmap in \c booleans.
+ *   - \c integer and \c decimal columns are a value for each row in \c integers or \c decimals (0 for null rows).
+ *   - \c string and \c json columns are dictionary-encoded: \c indices has an index for each row (0 for null rows) into
+ *     the dictionary, which is the UTF-8 text \c dictionary_data split at \c dictionary_offsets (an Arrow \c utf8
+ *     array with one more offset than entries).
+**/
+class JSONV_PUBLIC column
+{
+public:
+    explicit column(std::string name);
+
+    const std::string& name() const         { return _name; }
+    column_type        type() const         { return _type; }
+
+    /** The number of rows. **/
+    std::size_t        size() const         { return _size; }
+
+    /** The number of rows without a value. **/
+    std::size_t        null_count() const   { return _null_count; }
+
+    /** Does the row at \a row have a value? **/
+    bool valid(std::size_t row) const
+    {
+        return (_validity[row / 8] >> (row % 8)) & 1U;
+    }
+
+    const std::vector<std::uint8_t>& validity() const           { return _validity; }
+    const std::vector<std::uint8_t>& booleans() const           { return _booleans; }
+    const std::vector<std::int64_t>& integers() const           { return _integers; }
+    const std::vector<double>&       decimals() const           { return _decimals; }
+    const std::vector<std::int32_t>& indices() const            { return _indices; }
+    const std::vector<std::int32_t>& dictionary_offsets() const { return _offsets; }
+    const std::string&               dictionary_data() const    { return _data; }
+
+    /** The number of entries in the dictionary of a \c string or \c json column. **/
+    std::size_t dictionary_size() const
+    {
+        return _offsets.size() - 1;
+    }
+
+    /** Get the text of the dictionary entry \a idx. **/
+    string_view dictionary_entry(std::size_t idx) const
+    {
+        return string_view(_data.data() + _offsets[idx], std::size_t(_offsets[idx + 1] - _offsets[idx]));
+    }
+
+    /** Get the value in the row at \a row (\c null if it does not have one). **/
+    value at(std::size_t row) const;
+
+private:
+    friend class columnar_builder;
+
+    void append_null();
+    void append(const value& x, std::unordered_map<std::string, std::int32_t>& dictionary);
+    void append_valid();
+    void append_entry(string_view text, std::unordered_map<std::string, std::int32_t>& dictionary);
+
+    /** Change the type to \a type, converting the values of the rows so far. **/
+    void widen(column_type type, std::unordered_map<std::string, std::int32_t>& dictionary);
+
+private:
+    std::string               _name;
+    column_type               _type;
+    std::size_t               _size;
+    std::size_t               _null_count;
+    std::vector<std::uint8_t> _validity;
+    std::vector<std::uint8_t> _booleans;
+    std::vector<std::int64_t> _integers;
+    std::vector<double>       _decimals;
+    std::vector<std::int32_t> _indices;
+    std::vector<std::int32_t> _offsets;
+    std::string               _data;
+};
+
+/** An array of objects stored as a \c column for each member (struct of arrays instead of array of structs). The
+ *  columns are in the order their members were first seen.
+ *
+ *  \see to_columnar
+**/
+class JSONV_PUBLIC columnar_table
+{
+public:
+    columnar_table();
+
+    /** The number of rows. **/
+    std::size_t rows() const
+    {
+        return _rows;
+    }
+
+    const std::vector<column>& columns() const
+    {
+        return _columns;
+    }
+
+    /** Get the column for the member \a name.
+     *
+     *  \throws std::out_of_range if no row had a member named \a name.
+    **/
+    const column& at(string_view name) const;
+
+    /** Get the row at \a row back as an object. Members which the row did not have (or which were \c null) are left
+     *  out.
+    **/
+    value row(std::size_t row) const;
+
+private:
+    friend class columnar_builder;
+
+    std::size_t         _rows;
+    std::vector<column> _columns;
+};
+
+/** Builds a \c columnar_table one row at a time, so rows can come from anywhere (such as an \c array_stream) and do
+ *  not all need to be in memory as \c value instances. The types of the columns are worked out from the rows as they
+ *  are added; when a column has to be widened, the rows it already has are converted once.
+**/
+class JSONV_PUBLIC columnar_builder
+{
+public:
+    columnar_builder();
+
+    /** Add \a row as the next row. Each of its members goes into the column with its name, which is created (with
+     *  \c null for every row before it) the first time the member is seen.
+     *
+     *  \throws kind_error if \a row is not an object.
+     *  \throws std::length_error if the text of a dictionary goes over the 2 GiB which 32-bit offsets can refer to.
+    **/
+    void add_row(const value& row);
+
+    /** The number of rows added so far. **/
+    std::size_t rows() const
+    {
+        return _table._rows;
+    }
+
+    /** Get the table of the rows added so far, leaving this builder empty. **/
+    columnar_table finish();
+
+private:
+    columnar_table                                               _table;
+    std::unordered_map<std::string, std::size_t>                 _by_name;
+    std::vector<std::unordered_map<std::string, std::int32_t>>   _dictionaries;
+};
+
+/** Convert \a array_of_objects into a table with a column for each member of the objects.
+ *
+ *  \example
+ *  \code
+ *  jsonv::columnar_table table = jsonv::to_columnar(jsonv::parse(export_text));
+ *  const jsonv::column& price = table.at("price");
+ *  if (price.type() == jsonv::column_type::decimal)
+ *      load_float64(price.decimals().data(), price.validity().data(), price.size());
+ *  \endcode
+ *
+ *  \throws kind_error if \a array_of_objects is not an array or has an element which is not an object.
+**/
+JSONV_PUBLIC columnar_table to_columnar(const value& array_of_objects);
+
+/** Convert the elements of \a rows into a table as they are parsed. Only one element is in memory as a \c value at a
+ *  time, so converting a huge export takes memory for the columns and not for the document.
+ *
+ *  \example
+ *  \code
+ *  std::ifstream export_file("orders.json");
+ *  jsonv::columnar_table table = jsonv::to_columnar(jsonv::array_stream(export_file, jsonv::path({ "orders" })));
+ *  \endcode
+**/
+JSONV_PUBLIC columnar_table to_columnar(array_range&& rows);
+
+}
+
+#endif/*__JSONV_COLUMNAR_HPP_INCLUDED__*/
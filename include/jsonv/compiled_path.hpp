@@ -0,0 +1,108 @@
+/** \file jsonv/compiled_path.hpp
+ *  Path queries which are parsed once and can match more than one location.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_COMPILED_PATH_HPP_INCLUDED__
+#define __JSONV_COMPILED_PATH_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/forward.hpp>
+#include <jsonv/path.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace jsonv
+{
+
+/** A path query which has been parsed ahead of time, so evaluating it against a \c value does no parsing at all. The
+ *  syntax is that of \c path::create with a few additions from JSONPath:
+ *
+ *   - <tt>.*</tt> and <tt>[*]</tt> match every value in an object or an array.
+ *   - <tt>..</tt> followed by a key, <tt>*</tt> or a bracketed element matches that element at any depth below the
+ *     current value (including in the current value itself).
+ *
+ *  \code
+ *  jsonv::compiled_path prices = jsonv::compiled_path::create(".orders[*].items..price");
+ *  for (const jsonv::value* price : prices.match(message))
+ *      total += price->as_decimal();
+ *  \endcode
+ *
+ *  Matches are returned in document order. Values which do not have the right kind for an element (an index into a
+ *  string, for instance) are not matches, so unlike \c value::at_path, evaluation never throws.
+**/
+class JSONV_PUBLIC compiled_path
+{
+public:
+    using size_type = std::size_t;
+
+public:
+    /** Create a query which matches exactly what \a p refers to. **/
+    compiled_path(const path& p = path());
+
+    /** Parse a query from the text \a specification.
+     *
+     *  \throws std::invalid_argument if the \a specification is not valid.
+    **/
+    static compiled_path create(string_view specification);
+
+    /** Does this query refer to a single location (it has no wildcards or recursive descent)? **/
+    bool exact() const;
+
+    /** Get every value in \a from which this query matches. The pointers refer into \a from. **/
+    std::vector<const value*> match(const value& from) const;
+    std::vector<value*>       match(value& from) const;
+
+    /** Get the first value in \a from which this query matches.
+     *
+     *  \returns The first match or \c nullptr if nothing matched.
+    **/
+    const value* find(const value& from) const;
+    value*       find(value& from) const;
+
+private:
+    enum class step_kind : unsigned char
+    {
+        element,     //!< A key or index (in \c elem)
+        wildcard,    //!< Every child of an object or array
+        descendants, //!< The current value and every value below it
+    };
+
+    struct step
+    {
+        step_kind    kind;
+        path_element elem;
+    };
+
+    friend JSONV_PUBLIC std::ostream& operator<<(std::ostream&, const compiled_path&);
+
+    /** Call \a on_match with each value under \a from matched by the steps starting at \a idx until it returns
+     *  \c false.
+     *
+     *  \returns \c false if \a on_match asked to stop.
+    **/
+    template <typename TValue, typename FMatch>
+    bool evaluate(size_type idx, TValue& from, const FMatch& on_match) const;
+
+private:
+    std::vector<step> _steps;
+};
+
+/** Write \a query in the syntax \c compiled_path::create reads. **/
+JSONV_PUBLIC std::ostream& operator<<(std::ostream&, const compiled_path& query);
+
+JSONV_PUBLIC std::string to_string(const compiled_path& query);
+
+}
+
+#endif/*__JSONV_COMPILED_PATH_HPP_INCLUDED__*/
@@ -0,0 +1,250 @@
+/** \file jsonv/compress.hpp
+ *  Compressing encoded output and decompressing input as it streams through, in fixed-size chunks, so neither side
+ *  ever holds the whole uncompressed text.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_COMPRESS_HPP_INCLUDED__
+#define __JSONV_COMPRESS_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <utility>
+
+namespace jsonv
+{
+
+/** The container formats a \c compressor can write. **/
+enum class compression : unsigned char
+{
+    /** The format of \c gzip files and of HTTP's <tt>Content-Encoding: gzip</tt>. **/
+    gzip,
+    /** The zlib format (RFC 1950), which is HTTP's <tt>Content-Encoding: deflate</tt>. **/
+    zlib,
+};
+
+/** Compresses a stream of bytes with DEFLATE, handing the compressed bytes to a flush function in chunks of
+ *  \c chunk_size as they are produced.
+ *
+ *  Compression is done with zlib, which is only available if the library was built with it (the \c USE_ZLIB option
+ *  of the CMake build). Otherwise, the constructor throws \c std::runtime_error.
+**/
+class JSONV_PUBLIC compressor
+{
+public:
+    /** Called with the compressed bytes. **/
+    using flush_function = std::function<void (string_view)>;
+
+    /** Use zlib's default compression level (currently 6). **/
+    static constexpr int default_level = -1;
+
+public:
+    /** Create an instance which hands output in the given \a format to \a output. The \a level goes from 0 (no
+     *  compression) to 9 (the smallest output).
+    **/
+    explicit compressor(flush_function output,
+                        compression    format     = compression::gzip,
+                        int            level      = default_level,
+                        std::size_t    chunk_size = 16384
+                       );
+
+    compressor(const compressor&) = delete;
+    compressor& operator=(const compressor&) = delete;
+
+    ~compressor() noexcept;
+
+    /** Compress \a data. Compressed output is only handed off when a full chunk of it is ready.
+     *
+     *  \throws std::logic_error if this has already been \c finish ed (unless \a data is empty).
+    **/
+    void write(string_view data);
+
+    /** Hand off everything written so far in a form the other side can decompress right away, without ending the
+     *  stream. This costs a few bytes and some compression, so it is only worth doing at points where the receiver
+     *  should see the output (such as the end of a chunk of an HTTP response).
+    **/
+    void flush();
+
+    /** End the stream, handing off the rest of the compressed output (including the trailer of the format). Calling
+     *  this again does nothing.
+    **/
+    void finish();
+
+private:
+    struct impl;
+    std::unique_ptr<impl> _impl;
+};
+
+/** Decompresses a stream of gzip or zlib data (which one is detected from the header), handing the plain bytes to a
+ *  flush function in chunks of at most \c chunk_size. Concatenated gzip members (as produced by appending to a
+ *  \c .gz log file) are read as one stream.
+ *
+ *  The plain chunks can go straight to an \c incremental_parser, so a compressed request body is parsed without ever
+ *  being fully decompressed in memory.
+ *
+ *  \example "decompressor"
+ *  \code
+ *  jsonv::incremental_parser parser;
+ *  jsonv::decompressor       inflate([&] (jsonv::string_view plain) { parser.feed(plain); });
+ *  while (connection.has_more())
+ *      inflate.write(connection.read_some());
+ *  inflate.finish();
+ *  jsonv::value body = parser.finish();
+ *  \endcode
+ *
+ *  Like \c compressor, this needs the library to be built with zlib.
+**/
+class JSONV_PUBLIC decompressor
+{
+public:
+    /** Called with the decompressed bytes. **/
+    using flush_function = std::function<void (string_view)>;
+
+public:
+    explicit decompressor(flush_function output, std::size_t chunk_size = 16384);
+
+    decompressor(const decompressor&) = delete;
+    decompressor& operator=(const decompressor&) = delete;
+
+    ~decompressor() noexcept;
+
+    /** Decompress the next piece of \a compressed data.
+     *
+     *  \throws std::runtime_error if the data is not valid gzip or zlib data.
+    **/
+    void write(string_view compressed);
+
+    /** Signal the end of the compressed data.
+     *
+     *  \throws std::runtime_error if the compressed stream was cut off.
+    **/
+    void finish();
+
+private:
+    struct impl;
+    std::unique_ptr<impl> _impl;
+};
+
+/** A \c std::streambuf which reads gzip or zlib data from another stream and gives out the decompressed bytes, a chunk
+ *  at a time. Wrap it in an \c std::istream to give compressed input to anything which reads from a stream, such as
+ *  \c parse, a \c tokenizer or \c parse_lines.
+ *
+ *  \example "decompress_streambuf"
+ *  \code
+ *  std::ifstream                file("events.json.gz", std::ios::binary);
+ *  jsonv::decompress_streambuf  plain(file);
+ *  std::istream                 input(&plain);
+ *  jsonv::value                 events = jsonv::parse(input);
+ *  \endcode
+ *
+ *  Invalid or cut-off compressed data throws \c std::runtime_error from inside the stream, which an \c std::istream
+ *  turns into \c std::ios::badbit (and only rethrows if \c badbit is in its exception mask).
+**/
+class JSONV_PUBLIC decompress_streambuf :
+        public std::streambuf
+{
+public:
+    /** Read compressed data from \a source, which must outlive this instance. **/
+    explicit decompress_streambuf(std::istream& source, std::size_t chunk_size = 16384);
+
+    virtual ~decompress_streambuf() noexcept;
+
+protected:
+    virtual int_type underflow() override;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> _impl;
+};
+
+namespace detail
+{
+
+/** Holds the \c compressor of a \c compressed_encoder, so it exists before the encoder which writes into it. **/
+struct compressed_encoder_base
+{
+    template <typename... TArgs>
+    explicit compressed_encoder_base(TArgs&&... args) :
+            _compressor(std::forward<TArgs>(args)...)
+    { }
+
+    jsonv::compressor _compressor;
+};
+
+}
+
+/** An encoder which compresses the output of \c TInner as it is written. \c TInner is any encoder which can be
+ *  constructed from a flush function and a chunk size, like \c buffer_encoder, \c cbor_encoder or
+ *  \c msgpack_encoder. Only one chunk of the uncompressed output is held at a time.
+ *
+ *  \example "compressed_encoder"
+ *  \code
+ *  jsonv::compressed_encoder<jsonv::buffer_encoder> encoder([&] (jsonv::string_view chunk) { socket.send(chunk); });
+ *  encoder.encode(response);
+ *  encoder.finish();
+ *  \endcode
+**/
+template <typename TInner>
+class compressed_encoder :
+        private detail::compressed_encoder_base,
+        public TInner
+{
+public:
+    /** Called with the compressed bytes. **/
+    using flush_function = jsonv::compressor::flush_function;
+
+public:
+    /** Create an instance which hands \a output the compressed output of a \c TInner in the given \a format. **/
+    explicit compressed_encoder(flush_function output,
+                                compression    format     = compression::gzip,
+                                int            level      = jsonv::compressor::default_level,
+                                std::size_t    chunk_size = 16384
+                               ) :
+            detail::compressed_encoder_base(std::move(output), format, level, chunk_size),
+            TInner([this] (string_view chunk) { this->_compressor.write(chunk); }, chunk_size)
+    { }
+
+    /** Finishes the stream if \c finish has not been called. Like the other encoders, a failure to do so can not be
+     *  reported, so call \c finish explicitly if the flush function can throw.
+    **/
+    ~compressed_encoder() noexcept
+    {
+        try
+        {
+            finish();
+        }
+        catch (...)
+        { }
+    }
+
+    /** Get the underlying \c compressor, which can be used to \c compressor::flush what has been written so far
+     *  (after flushing this encoder).
+    **/
+    jsonv::compressor& compressor()
+    {
+        return this->_compressor;
+    }
+
+    /** Flush the encoder and end the compressed stream. Nothing can be encoded after this. **/
+    void finish()
+    {
+        TInner::flush();
+        this->_compressor.finish();
+    }
+};
+
+}
+
+#endif/*__JSONV_COMPRESS_HPP_INCLUDED__*/
@@ -139,6 +139,18 @@
 #   endif
 #endif
 
+/** \def JSONV_COLD
+ *  \brief Mark that a function is rarely called (such as one which only throws an exception), so calls to it are moved
+ *  out of the way of the code around them.
+**/
+#ifndef JSONV_COLD
+#   if defined(__GNUC__)
+#       define JSONV_COLD __attribute__((cold))
+#   else
+#       define JSONV_COLD
+#   endif
+#endif
+
 /** \def JSONV_INTEGER_ALTERNATES_LIST
  *  \brief An item list of types to also consider as an integer.
  *  This mostly exists to help resolve the C-induced type ambiguity for the literal \c 0. It most prefers to be an
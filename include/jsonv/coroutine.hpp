@@ -0,0 +1,342 @@
+/** \file jsonv/coroutine.hpp
+ *  Awaitable parsing and encoding for C++20 coroutines, so a large document is read or written a chunk at a time
+ *  without blocking the thread the coroutine runs on.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_COROUTINE_HPP_INCLUDED__
+#define __JSONV_COROUTINE_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+
+/** \def JSONV_COROUTINES
+ *  \brief Are the coroutine functions of this header available? Everything in it is inline over \c incremental_parser
+ *  and \c writer, so they are whenever the code including it is compiled with coroutine support (C++20), no matter
+ *  which standard the library itself was built with.
+**/
+#ifndef JSONV_COROUTINES
+#   if defined(__cpp_impl_coroutine) && defined(__has_include)
+#       if __has_include(<coroutine>)
+#           define JSONV_COROUTINES 1
+#       endif
+#   endif
+#endif
+#ifndef JSONV_COROUTINES
+#   define JSONV_COROUTINES 0
+#endif
+
+#if JSONV_COROUTINES
+
+#include <jsonv/encode.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/string_view.hpp>
+#include <jsonv/value.hpp>
+#include <jsonv/writer.hpp>
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jsonv
+{
+
+template <typename T = void>
+class task;
+
+namespace detail
+{
+
+template <typename T>
+class task_promise_base
+{
+public:
+    /** Resumes whoever is awaiting the task (if anyone). **/
+    struct final_awaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename TPromise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> self) noexcept
+        {
+            std::coroutine_handle<> next = self.promise()._continuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept
+        { }
+    };
+
+public:
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    final_awaiter final_suspend() const noexcept { return {}; }
+
+    void unhandled_exception() noexcept
+    {
+        _error = std::current_exception();
+    }
+
+    void rethrow_if_failed() const
+    {
+        if (_error)
+            std::rethrow_exception(_error);
+    }
+
+    std::coroutine_handle<> _continuation;
+    std::exception_ptr      _error;
+};
+
+template <typename T>
+class task_promise :
+        public task_promise_base<T>
+{
+public:
+    task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& result)
+    {
+        _result.emplace(std::forward<U>(result));
+    }
+
+    T take_result()
+    {
+        this->rethrow_if_failed();
+        return std::move(*_result);
+    }
+
+private:
+    std::optional<T> _result;
+};
+
+template <>
+class task_promise<void> :
+        public task_promise_base<void>
+{
+public:
+    task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept
+    { }
+
+    void take_result() const
+    {
+        rethrow_if_failed();
+    }
+};
+
+}
+
+/** The result of \c async_parse and \c async_encode: a coroutine which does not start until it is \c co_await ed, then
+ *  gives the awaiting coroutine its result (or exception). The awaiting coroutine is resumed on whatever thread the
+ *  task finishes on, with no scheduling of its own, so it fits into any executor or reactor.
+**/
+template <typename T>
+class task
+{
+public:
+    using promise_type = detail::task_promise<T>;
+
+public:
+    task(task&& src) noexcept :
+            _handle(std::exchange(src._handle, nullptr))
+    { }
+
+    task& operator=(task&& src) noexcept
+    {
+        if (this != &src)
+        {
+            if (_handle)
+                _handle.destroy();
+            _handle = std::exchange(src._handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~task() noexcept
+    {
+        if (_handle)
+            _handle.destroy();
+    }
+
+    auto operator co_await() && noexcept
+    {
+        struct awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise()._continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume()
+            {
+                return handle.promise().take_result();
+            }
+        };
+        return awaiter{ _handle };
+    }
+
+private:
+    friend class detail::task_promise<T>;
+
+    explicit task(std::coroutine_handle<promise_type> handle) noexcept :
+            _handle(handle)
+    { }
+
+private:
+    std::coroutine_handle<promise_type> _handle;
+};
+
+namespace detail
+{
+
+template <typename T>
+task<T> task_promise<T>::get_return_object() noexcept
+{
+    return task<T>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+inline task<void> task_promise<void>::get_return_object() noexcept
+{
+    return task<void>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+}
+
+/** Parse a document which is read from \a source a chunk at a time with an \c incremental_parser. \a source is anything
+ *  with a \c read_some() function returning an awaitable whose result converts to a \c string_view, with an empty chunk
+ *  meaning the end of the input. Each chunk only needs to stay valid until the next \c read_some. Reading stops as soon
+ *  as the document is complete. \a source must outlive the returned task.
+ *
+ *  \example "async_parse"
+ *  \code
+ *  jsonv::task<> handle(connection& conn)
+ *  {
+ *      jsonv::value request = co_await jsonv::async_parse(conn);
+ *      co_await jsonv::async_encode(respond_to(request), conn);
+ *  }
+ *  \endcode
+ *
+ *  \throws parse_error from awaiting the task, as \c incremental_parser::feed and \c incremental_parser::finish do.
+**/
+template <typename TSource>
+task<value> async_parse(TSource& source, parse_options options = parse_options())
+{
+    incremental_parser parser(options);
+    while (true)
+    {
+        string_view chunk = co_await source.read_some();
+        if (chunk.empty() || parser.feed(chunk))
+            break;
+    }
+    co_return parser.finish();
+}
+
+/** Encode \a source to \a sink, handing over the text whenever at least \a chunk_size bytes of it have been encoded.
+ *  \a sink is anything with a \c write(string_view) function returning an awaitable; the text only needs to stay valid
+ *  until that is resumed. Unlike \c encoder::encode, the nesting of \a source is walked with an explicit stack, so the
+ *  encoding stops in the middle of a large array or object while \a sink is busy. Both \a source and \a sink must
+ *  outlive the returned task and nothing may change \a source until it finishes.
+**/
+template <typename TSink>
+task<> async_encode(const value& source, TSink& sink, std::size_t chunk_size = 64 * 1024)
+{
+    struct frame
+    {
+        const value*                 container;
+        value::const_array_iterator  array_position;
+        value::const_object_iterator object_position;
+    };
+
+    std::string        chunk;
+    buffer_encoder     encoder(chunk);
+    writer             out(encoder);
+    std::vector<frame> open;
+
+    // write the scalar or the start of the container
+    auto start = [&] (const value& item)
+    {
+        if (item.kind() == kind::array)
+        {
+            out.begin_array();
+            open.push_back(frame{ &item, item.begin_array(), {} });
+        }
+        else if (item.kind() == kind::object)
+        {
+            out.begin_object();
+            open.push_back(frame{ &item, {}, item.begin_object() });
+        }
+        else
+        {
+            out.value(item);
+        }
+    };
+
+    start(source);
+    while (!open.empty())
+    {
+        frame& top = open.back();
+        if (top.container->kind() == kind::array)
+        {
+            if (top.array_position == top.container->end_array())
+            {
+                out.end_array();
+                open.pop_back();
+            }
+            else
+            {
+                const value& item = *top.array_position;
+                ++top.array_position;
+                start(item);
+            }
+        }
+        else
+        {
+            if (top.object_position == top.container->end_object())
+            {
+                out.end_object();
+                open.pop_back();
+            }
+            else
+            {
+                const auto& entry = *top.object_position;
+                ++top.object_position;
+                out.key(entry.first);
+                start(entry.second);
+            }
+        }
+
+        // the encoder flushes into chunk on its own as its buffer fills up
+        if (chunk.size() + encoder.size() >= chunk_size)
+        {
+            encoder.flush();
+            co_await sink.write(string_view(chunk));
+            chunk.clear();
+        }
+    }
+
+    encoder.flush();
+    if (!chunk.empty())
+        co_await sink.write(string_view(chunk));
+}
+
+}
+
+#endif/*JSONV_COROUTINES*/
+
+#endif/*__JSONV_COROUTINE_HPP_INCLUDED__*/
@@ -0,0 +1,203 @@
+/** \file jsonv/detail/flat_map.hpp
+ *  An associative container kept as a sorted vector, used for object storage when \c JSONV_OBJECT_FLAT_STORAGE is set.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_FLAT_MAP_HPP_INCLUDED__
+#define __JSONV_DETAIL_FLAT_MAP_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** A map of unique keys stored contiguously in key order. Lookups are a binary search over one block of memory and
+ *  iteration is a walk over it, which beats chasing the nodes of an \c std::map for small maps. Inserting or erasing
+ *  moves the elements after the position, so it is linear in the size of the map.
+ *
+ *  Unlike \c std::map, the \c value_type has a non-const key (changing it through an iterator breaks the map), and
+ *  inserting or erasing invalidates every iterator and reference into the map.
+**/
+template <typename TKey, typename TValue, typename TCompare = std::less<TKey>>
+class flat_map
+{
+public:
+    using key_type       = TKey;
+    using mapped_type    = TValue;
+    using value_type     = std::pair<TKey, TValue>;
+    using size_type      = std::size_t;
+    using iterator       = value_type*;
+    using const_iterator = const value_type*;
+
+public:
+    flat_map() = default;
+
+    template <typename TInputIterator>
+    flat_map(TInputIterator first, TInputIterator last)
+    {
+        for ( ; first != last; ++first)
+            insert(value_type(*first));
+    }
+
+    iterator       begin()       { return _items.data(); }
+    const_iterator begin() const { return _items.data(); }
+    iterator       end()         { return _items.data() + _items.size(); }
+    const_iterator end()   const { return _items.data() + _items.size(); }
+
+    bool      empty() const { return _items.empty(); }
+    size_type size()  const { return _items.size(); }
+    size_type capacity() const { return _items.capacity(); }
+
+    TCompare key_comp() const { return TCompare(); }
+
+    // The lookups take any key type which \c TCompare can compare with a \c key_type.
+
+    template <typename UKey>
+    iterator lower_bound(const UKey& key)
+    {
+        return const_cast<iterator>(static_cast<const flat_map&>(*this).lower_bound(key));
+    }
+
+    template <typename UKey>
+    const_iterator lower_bound(const UKey& key) const
+    {
+        return std::lower_bound(begin(), end(), key,
+                                [] (const value_type& entry, const UKey& k) { return TCompare()(entry.first, k); }
+                               );
+    }
+
+    template <typename UKey>
+    iterator find(const UKey& key)
+    {
+        return const_cast<iterator>(static_cast<const flat_map&>(*this).find(key));
+    }
+
+    template <typename UKey>
+    const_iterator find(const UKey& key) const
+    {
+        const_iterator iter = lower_bound(key);
+        return iter != end() && !TCompare()(key, iter->first) ? iter : end();
+    }
+
+    template <typename UKey>
+    size_type count(const UKey& key) const
+    {
+        return find(key) == end() ? 0U : 1U;
+    }
+
+    template <typename UKey>
+    mapped_type& at(const UKey& key)
+    {
+        return const_cast<mapped_type&>(static_cast<const flat_map&>(*this).at(key));
+    }
+
+    template <typename UKey>
+    const mapped_type& at(const UKey& key) const
+    {
+        const_iterator iter = find(key);
+        if (iter == end())
+            throw std::out_of_range("flat_map::at");
+        return iter->second;
+    }
+
+    template <typename UKey>
+    mapped_type& operator[](UKey&& key)
+    {
+        iterator iter = lower_bound(key);
+        if (iter == end() || TCompare()(key, iter->first))
+            iter = emplace_at(iter, value_type(std::forward<UKey>(key), mapped_type()));
+        return iter->second;
+    }
+
+    std::pair<iterator, bool> insert(value_type entry)
+    {
+        iterator iter = lower_bound(entry.first);
+        if (iter != end() && !TCompare()(entry.first, iter->first))
+            return { iter, false };
+        return { emplace_at(iter, std::move(entry)), true };
+    }
+
+    template <typename... TArgs>
+    iterator emplace_hint(const_iterator hint, TArgs&&... args)
+    {
+        return insert(hint, value_type(std::forward<TArgs>(args)...));
+    }
+
+    void reserve(size_type count)
+    {
+        _items.reserve(count);
+    }
+
+    /** Insert \a entry, starting from the \a hint if it is the right place. **/
+    iterator insert(const_iterator hint, value_type entry)
+    {
+        const_iterator first = begin();
+        const_iterator last  = end();
+        bool after_prev  = hint == first || TCompare()((hint - 1)->first, entry.first);
+        bool before_next = hint == last  || TCompare()(entry.first, hint->first);
+        if (after_prev && before_next)
+            return emplace_at(const_cast<iterator>(hint), std::move(entry));
+        return insert(std::move(entry)).first;
+    }
+
+    template <typename UKey,
+              typename = typename std::enable_if<!std::is_convertible<const UKey&, const_iterator>::value>::type
+             >
+    size_type erase(const UKey& key)
+    {
+        const_iterator iter = find(key);
+        if (iter == end())
+            return 0U;
+        erase(iter);
+        return 1U;
+    }
+
+    iterator erase(const_iterator position)
+    {
+        return erase(position, position + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        auto offset = first - begin();
+        _items.erase(_items.begin() + offset, _items.begin() + (last - begin()));
+        return begin() + offset;
+    }
+
+    void clear()
+    {
+        _items.clear();
+    }
+
+private:
+    iterator emplace_at(iterator position, value_type&& entry)
+    {
+        auto offset = position - begin();
+        _items.insert(_items.begin() + offset, std::move(entry));
+        return begin() + offset;
+    }
+
+private:
+    std::vector<value_type> _items;
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_FLAT_MAP_HPP_INCLUDED__*/
@@ -0,0 +1,70 @@
+/** \file jsonv/detail/node_allocator.hpp
+ *  A standard allocator over the thread-local pool used for the storage of values.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_NODE_ALLOCATOR_HPP_INCLUDED__
+#define __JSONV_DETAIL_NODE_ALLOCATOR_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+
+#include <cstddef>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Get \a size bytes of storage. Blocks which have been released on this thread are reused before asking the global
+ *  heap, so building and throwing away value trees over and over does not go to \c malloc and \c free for every node.
+**/
+JSONV_PUBLIC void* node_allocate(std::size_t size);
+
+/** Release storage from \a node_allocate. This can be called from any thread. **/
+JSONV_PUBLIC void node_deallocate(void* p, std::size_t size) noexcept;
+
+/** A standard allocator which uses \c node_allocate, for the containers inside of arrays and objects. **/
+template <typename T>
+struct node_allocator
+{
+    using value_type = T;
+
+    node_allocator() noexcept = default;
+
+    template <typename U>
+    node_allocator(const node_allocator<U>&) noexcept
+    { }
+
+    T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(node_allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t count) noexcept
+    {
+        node_deallocate(p, count * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const node_allocator<U>&) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const node_allocator<U>&) const noexcept
+    {
+        return false;
+    }
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_NODE_ALLOCATOR_HPP_INCLUDED__*/
@@ -0,0 +1,71 @@
+/** \file jsonv/detail/token_stream.hpp
+ *  Helpers for walking the structure of a document in a \c tokenizer, used when extracting values from tokens.
+ *  
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_TOKEN_STREAM_HPP_INCLUDED__
+#define __JSONV_DETAIL_TOKEN_STREAM_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/forward.hpp>
+
+#include <string>
+
+namespace jsonv
+{
+namespace detail
+{
+
+// All of these functions work on the "current value" of a tokenizer: the value whose first token is current. When they
+// return, the last token of the value they looked at is current, which is where the next value is looked for.
+
+/** Move \a from to the next token which is not whitespace or a comment.
+ *  
+ *  \returns \a from.
+ *  \throws parse_error if the input ends first.
+**/
+JSONV_PUBLIC tokenizer& next_token(tokenizer& from);
+
+/** Parse the current value of \a from into a \c value.
+ *  
+ *  \throws parse_error if the value is not valid JSON.
+**/
+JSONV_PUBLIC value parse_current(tokenizer& from);
+
+/** Parse the current value of \a from into a \c value with the given \a options. Since the current value is not a
+ *  whole document, \a options must not have \c parse_options::complete_parse or \c parse_options::require_document
+ *  set.
+ *  
+ *  \throws parse_error if the value is not valid JSON.
+**/
+JSONV_PUBLIC value parse_current(tokenizer& from, const parse_options& options);
+
+/** Skip over the current value of \a from. This only matches brackets; it does not check the contents. **/
+JSONV_PUBLIC void skip_current(tokenizer& from);
+
+/** Move to the next element of an array. \a first says if the current token is the \c [ which opens the array or the
+ *  last token of the previous element.
+ *  
+ *  \returns \c true with the first token of the element current or \c false with the closing \c ] current.
+ *  \throws parse_error if the array is malformed.
+**/
+JSONV_PUBLIC bool next_array_element(tokenizer& from, bool first);
+
+/** Move to the value of the next entry of an object, decoding its key into \a key. \a first says if the current token
+ *  is the \c { which opens the object or the last token of the previous value.
+ *  
+ *  \returns \c true with the first token of the value current or \c false with the closing \c } current.
+ *  \throws parse_error if the object is malformed.
+**/
+JSONV_PUBLIC bool next_object_entry(tokenizer& from, bool first, std::string& key);
+
+}
+}
+
+#endif/*__JSONV_DETAIL_TOKEN_STREAM_HPP_INCLUDED__*/
@@ -16,21 +16,47 @@
 #include <jsonv/forward.hpp>
 #include <jsonv/string_view.hpp>
 
+#include <cstddef>
+#include <functional>
 #include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace jsonv
 {
 
-/** An encoder is responsible for writing values to some form of output. **/
+namespace detail
+{
+
+class compact_writer;
+class event_parser;
+class output_buffer;
+
+}
+
+/** An encoder is responsible for writing values to some form of output. Besides \c encode, an encoder can be given to
+ *  \c parse to receive the contents of a document without building a \c value.
+**/
 class JSONV_PUBLIC encoder
 {
 public:
     virtual ~encoder() noexcept;
     
-    /** Encode some source value into this encoder. This is the only useful entry point to this class. **/
+    /** Encode some source value into this encoder. This is the only useful entry point to this class.
+     *  
+     *  Each piece of \a source is a virtual call. When the kind of output is known at compile time, \c encode_static
+     *  with a plain writer class avoids that.
+    **/
     void encode(const jsonv::value& source);
     
+    /** Encode \a source like \c encode does, adding the counts and times of what was written to \a stats. **/
+    void encode(const jsonv::value& source, encode_stats& stats);
+    
 protected:
+    friend class detail::event_parser;
+    friend class writer;
+    
     /** Write the null value.
      *  
      *  \code
@@ -47,6 +73,13 @@ protected:
     **/
     virtual void write_object_begin() = 0;
     
+    /** Write the opening of an object which is known to have \a count entries. This is called by \c encode, which
+     *  always knows the size; other sources of output (such as a \c writer) call \c write_object_begin. Formats which
+     *  store the size of a container ahead of its contents can use it. The default implementation calls
+     *  \c write_object_begin.
+    **/
+    virtual void write_object_begin_sized(std::size_t count);
+    
     /** Write the closing of an object value.
      *  
      *  \code
@@ -79,6 +112,13 @@ protected:
     **/
     virtual void write_array_begin() = 0;
     
+    /** Write the opening of an array which is known to have \a count elements. The default implementation calls
+     *  \c write_array_begin.
+     *  
+     *  \see write_object_begin_sized
+    **/
+    virtual void write_array_begin_sized(std::size_t count);
+    
     /** Write the closing of an array value.
      *  
      *  \code
@@ -134,6 +174,18 @@ protected:
      *  \endcode
     **/
     virtual void write_boolean(bool value) = 0;
+    
+    /** Write \a text, the JSON encoding of an array or object built by \c raw_json or the text of a number kept by
+     *  \c parse_options::numbers::lazy, in place of the value. Encoders for anything other than JSON text should leave
+     *  this alone.
+     *  
+     *  \returns \c true if \a text was written; \c false (the default) to have the value walked and written piece by
+     *           piece like any other.
+    **/
+    virtual bool write_raw_json(string_view text);
+    
+private:
+    class virtual_writer;
 };
 
 /** An encoder that outputs to an \c std::ostream. This implementation is used for \c operator<< on a \c value.
@@ -179,14 +231,22 @@ protected:
     
     virtual void write_integer(std::int64_t value) override;
     
-    /** When a special value is given, this will output \c null. **/
+    /** Write the shortest text which parses back to exactly \a value, regardless of the precision or locale of the
+     *  stream. When a special value is given, this will output \c null.
+    **/
     virtual void write_decimal(double value) override;
     
     virtual void write_boolean(bool value) override;
     
+    /** Write \a text as it is, unless \c ensure_ascii is set and \a text has non-ASCII characters. **/
+    virtual bool write_raw_json(string_view text) override;
+    
 protected:
     std::ostream& output();
     
+    /** Is \c ensure_ascii set? **/
+    bool ensure_ascii() const;
+    
 private:
     std::ostream& _output;
     bool          _ensure_ascii;
@@ -200,6 +260,9 @@ private:
  *  encoder.encode(some_value);
  *  encoder.encode(another_value);
  *  \endcode
+ *  
+ *  The text is collected in memory and written to the stream as each top-level value is finished (or every 64 KiB for
+ *  large ones), instead of a piece at a time. The stream is not flushed.
 **/
 class JSONV_PUBLIC ostream_pretty_encoder :
         public ostream_encoder
@@ -208,8 +271,22 @@ public:
     /** Create an instance which places text into \a output. **/
     explicit ostream_pretty_encoder(std::ostream& output, std::size_t indent_size = 2);
     
+    /** Writes anything which has not been written yet (which only happens when encoding was cut off). **/
     virtual ~ostream_pretty_encoder() noexcept;
     
+    /** If set to true, arrays which only contain scalars (no objects or arrays) are kept on a single line:
+     *  
+     *  \code
+     *  {
+     *    "name": "sample",
+     *    "points": [1, 2, 3.5, 4]
+     *  }
+     *  \endcode
+     *  
+     *  This is off by default, which puts every element on its own line.
+    **/
+    void compact_arrays(bool value);
+    
 protected:
     virtual void write_null() override;
     
@@ -235,15 +312,34 @@ protected:
     
     virtual void write_boolean(bool value) override;
     
+    /** Only writes the text of numbers, since arrays and objects would not be indented. **/
+    virtual bool write_raw_json(string_view text) override;
+    
 private:
     void write_prefix();
     
     void write_eol();
     
+    /** Called after writing the end of a value, to write out \c _text once a top-level value is done. **/
+    void write_value_end();
+    
+    /** Put the elements of the array being kept on one line on their own lines, since it turned out to contain a
+     *  container.
+    **/
+    void expand_compact();
+    
+    void flush_text();
+    
 private:
-    std::size_t   _indent;
-    std::size_t   _indent_size;
-    bool          _defer_indent;
+    std::size_t              _indent;
+    std::size_t              _indent_size;
+    std::size_t              _depth;
+    bool                     _defer_indent;
+    bool                     _compact_arrays;
+    std::string              _text;             //!< Output which has not been written to the stream yet
+    std::string              _eol;              //!< A newline followed by (at least) \c _indent spaces
+    std::size_t              _compact_start;    //!< Where in \c _text the array being kept on one line starts
+    std::vector<std::size_t> _compact_elements; //!< Where in \c _text each of its elements start
 };
 
 /** An encoder that outputs to an \c std::ostream. This encoder uses ISO 8-bit encoding **/
@@ -256,8 +352,207 @@ public:
 
 protected:
 	virtual void write_string(string_view value) override;
+
+	/** Only writes \a text if it is all ASCII, which is the same in ISO 8-bit encoding. **/
+	virtual bool write_raw_json(string_view text) override;
+};
+
+/** An encoder which writes compact JSON (the same text as \c ostream_encoder) into a block of memory, without going
+ *  through an \c std::ostream. There is no sentry, locale or virtual \c streambuf call for each piece of output -- most
+ *  writes are a bounds check and a copy.
+ *  
+ *  Output is gathered in a buffer and handed off when the buffer fills up or \c flush is called. The destructor
+ *  flushes as well, but it can not report a failure to do so, so call \c flush explicitly if the flush function can
+ *  throw.
+ *  
+ *  \example "buffer_encoder"
+ *  \code
+ *  std::string out;
+ *  {
+ *      jsonv::buffer_encoder encoder(out);
+ *      encoder.encode(some_value);
+ *  }
+ *  
+ *  jsonv::buffer_encoder chunked([&] (jsonv::string_view chunk) { socket.send(chunk.data(), chunk.size()); });
+ *  chunked.encode(some_value);
+ *  chunked.flush();
+ *  \endcode
+**/
+class JSONV_PUBLIC buffer_encoder :
+        public encoder
+{
+public:
+    /** Called with the encoded text when the buffer is full or is flushed. **/
+    using flush_function = std::function<void (string_view)>;
+    
+public:
+    /** Create an instance which appends to \a output. The text is in \a output after \c flush is called (or this
+     *  instance is destroyed).
+    **/
+    explicit buffer_encoder(std::string& output);
+    
+    /** Create an instance which writes into the \a size bytes at \a buffer, calling \a flush with the contents each time
+     *  the buffer fills up. If \a flush is empty, writing more than \a size bytes throws \c std::length_error and the
+     *  output stays in \a buffer (see \c size).
+    **/
+    buffer_encoder(char* buffer, std::size_t size, flush_function flush = flush_function());
+    
+    /** Create an instance which hands its output to \a flush in chunks of (at most) \a chunk_size bytes. **/
+    explicit buffer_encoder(flush_function flush, std::size_t chunk_size = 4096);
+    
+    virtual ~buffer_encoder() noexcept;
+    
+    /** \see ostream_encoder::ensure_ascii **/
+    void ensure_ascii(bool value);
+    
+    /** Hand the buffered output to the flush function. **/
+    void flush();
+    
+    /** The number of bytes which have been written to the buffer since it was last flushed. **/
+    std::size_t size() const;
+    
+    /** Like \c encode, but the work is split among \a threads threads (all of the hardware threads if it is 0). The
+     *  output is exactly what \c encode would write.
+     *  
+     *  The elements of one large array or object are split up: starting from \a source, this goes down into the
+     *  largest child container for as long as it is larger than its parent, so a document like
+     *  <tt>{"meta": {...}, "rows": [...]}</tt> is split at \c "rows". Each range of elements is encoded into a
+     *  separate block of memory and the blocks are written out in order, so this needs memory for about as much text
+     *  as the split container encodes to. Values which are too small to be worth splitting are encoded on the calling
+     *  thread.
+     *  
+     *  \a source is read from several threads at once, so nothing may change it while this runs.
+    **/
+    void encode_parallel(const value& source, std::size_t threads = 0);
+    
+protected:
+    virtual void write_null() override;
+    
+    virtual void write_object_begin() override;
+    
+    virtual void write_object_end() override;
+    
+    virtual void write_object_key(string_view key) override;
+    
+    virtual void write_object_delimiter() override;
+    
+    virtual void write_array_begin() override;
+    
+    virtual void write_array_end() override;
+    
+    virtual void write_array_delimiter() override;
+    
+    virtual void write_string(string_view value) override;
+    
+    virtual void write_integer(std::int64_t value) override;
+    
+    /** \see ostream_encoder::write_decimal **/
+    virtual void write_decimal(double value) override;
+    
+    virtual void write_boolean(bool value) override;
+    
+    /** \see ostream_encoder::write_raw_json **/
+    virtual bool write_raw_json(string_view text) override;
+    
+    /** Write into the \a size bytes at \a buffer from now on, instead of the current buffer. This may only be called
+     *  from the flush function, so an encoder which hands off whole blocks (such as \c fd_encoder) can keep writing
+     *  into another one without waiting for the last to be used up.
+    **/
+    void use_buffer(char* buffer, std::size_t size);
+    
+    /** Throw away everything written after the first \a size bytes since the last flush (see \c size), such as the
+     *  beginning of a value which could not be finished. What has been flushed already can not be taken back.
+    **/
+    void truncate(std::size_t size);
+    
+private:
+    detail::compact_writer writer();
+    
+    /** Encode \c spine[depth], which contains \c spine[depth + 1], with the elements of the last one split up. **/
+    void encode_spine(const std::vector<const value*>& spine, std::size_t depth, std::size_t threads);
+    
+    void encode_elements_parallel(const value& container, std::size_t threads);
+    
+private:
+    std::unique_ptr<detail::output_buffer> _buffer;
+    bool                                   _ensure_ascii;
+};
+
+/** Get the exact number of characters a \c buffer_encoder (or \c ostream_encoder) with the given \a ensure_ascii
+ *  setting writes for \a source. This walks the value without writing anything, so it is useful for filling in a
+ *  \c Content-Length or sizing the block given to a \c buffer_encoder which writes into fixed memory.
+ *  
+ *  \see to_string
+**/
+JSONV_PUBLIC std::size_t encoded_size(const value& source, bool ensure_ascii = true);
+
+/** Like \c to_string, but the encoding is split among \a threads threads (all of the hardware threads if it is 0).
+ *  
+ *  \see buffer_encoder::encode_parallel
+**/
+JSONV_PUBLIC std::string to_string_parallel(const value& source, std::size_t threads = 0);
+
+/** Writes values as canonical JSON, as described by RFC 8785 (the JSON Canonicalization Scheme), so equal values are
+ *  always written as the same bytes. This is what signing a document or addressing it by the hash of its text needs.
+ *  There is no whitespace, the members of objects are sorted by the UTF-16 code units of their keys, strings only
+ *  escape what JSON requires (using the short forms where there is one) and numbers are written the way ECMAScript
+ *  writes them (so \c 1e+21, \c 0.000001 and \c 1e-7).
+ *  
+ *  Every number is a \c double in canonical JSON, so an integer a \c double can not hold exactly (past 2^53) is
+ *  written as the nearest one.
+ *  
+ *  Unlike the other encoders, this is not an \c encoder: the order of the members of an object comes from the whole
+ *  \c value instead of the order the pieces are written in. Since \c value keeps the members of an object sorted, they
+ *  only need to be sorted again if the keys have characters which sort differently in UTF-16 than in UTF-8.
+ *  
+ *  \example "canonical_encoder"
+ *  \code
+ *  jsonv::value doc = jsonv::parse(R"({"b": [1.0, 2e1], "a": "\u00e9"})");
+ *  std::string  text = jsonv::to_canonical_string(doc); // {"a":"é","b":[1,20]}
+ *  \endcode
+ *  
+ *  \see https://tools.ietf.org/html/rfc8785
+**/
+class JSONV_PUBLIC canonical_encoder
+{
+public:
+    /** Create an instance which appends to \a output. **/
+    explicit canonical_encoder(std::string& output);
+    
+    /** Create an instance which writes each encoded value to \a output. **/
+    explicit canonical_encoder(std::ostream& output);
+    
+    ~canonical_encoder() noexcept;
+    
+    /** If set, the text of each object and array with shareable storage (see \c value::make_shareable) is kept with the
+     *  storage, so encoding the same tree (or a copy which shares storage with it) again only copies the text of every
+     *  part which has not changed since. Each container keeps the text of everything in it, so this takes memory for
+     *  the encoded size of the tree for every level of it. The default is \c false.
+    **/
+    void cache_subtrees(bool value);
+    
+    /** Write the canonical text of \a source.
+     *  
+     *  \throws std::domain_error if \a source has a NaN or infinite number, which JSON can not represent.
+     *  \throws std::invalid_argument if a string in \a source is not valid UTF-8.
+    **/
+    void encode(const value& source);
+    
+private:
+    void write(const value& source, std::string& out) const;
+    
+private:
+    std::string*  _string;
+    std::ostream* _stream;
+    bool          _cache_subtrees;
 };
 
+/** Get the canonical JSON text of \a source.
+ *  
+ *  \see canonical_encoder
+**/
+JSONV_PUBLIC std::string to_canonical_string(const value& source);
+
 }
 
 #endif/*__JSONV_ENCODE_HPP_INCLUDED__*/
@@ -0,0 +1,152 @@
+/** \file jsonv/encode_static.hpp
+ *  Encoding a \c value with a writer whose type is known at compile time, so each token is an inlinable call instead of
+ *  a virtual one.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_ENCODE_STATIC_HPP_INCLUDED__
+#define __JSONV_ENCODE_STATIC_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace jsonv
+{
+
+/** Walk \a source, giving each piece of it to \a out. This is the same walk \c encoder::encode does (which is built on
+ *  it), but \c TWriter is a plain class, so the compiler can inline its members into the loop.
+ *  
+ *  \c TWriter must have these members, which are like the ones of \c encoder with the same names:
+ *  
+ *  \code
+ *  void write_null();
+ *  void write_boolean(bool value);
+ *  void write_integer(std::int64_t value);
+ *  void write_decimal(double value);
+ *  void write_string(jsonv::string_view value);
+ *  void write_array_begin(std::size_t count);
+ *  void write_array_delimiter();
+ *  void write_array_end();
+ *  void write_object_begin(std::size_t count);
+ *  void write_object_key(jsonv::string_view key);
+ *  void write_object_delimiter();
+ *  void write_object_end();
+ *  
+ *  // Given the text of values made by raw_json and of numbers kept by parse_options::numbers::lazy -- return false to
+ *  // have the value walked (or the number converted) instead
+ *  bool write_raw_json(jsonv::string_view text);
+ *  \endcode
+ *  
+ *  \example "encode_static"
+ *  \code
+ *  struct number_counter
+ *  {
+ *      std::size_t count = 0;
+ *  
+ *      void write_integer(std::int64_t) { ++count; }
+ *      void write_decimal(double)       { ++count; }
+ *      // ...and empty versions of the rest
+ *  };
+ *  
+ *  number_counter counter;
+ *  jsonv::encode_static(document, counter);
+ *  \endcode
+**/
+template <typename TWriter>
+void encode_static(const value& source, TWriter& out)
+{
+    if (const std::string* encoded = detail::encoded_json(source))
+        if (out.write_raw_json(*encoded))
+            return;
+    
+    switch (source.kind())
+    {
+    case kind::array:
+        out.write_array_begin(source.size());
+        if (const std::int64_t* integers = source.packed_integers())
+        {
+            // Packed numbers are written straight out of their buffer instead of being made into values first
+            for (std::size_t idx = 0, count = source.size(); idx < count; ++idx)
+            {
+                if (idx > 0)
+                    out.write_array_delimiter();
+                out.write_integer(integers[idx]);
+            }
+        }
+        else if (const double* decimals = source.packed_decimals())
+        {
+            for (std::size_t idx = 0, count = source.size(); idx < count; ++idx)
+            {
+                if (idx > 0)
+                    out.write_array_delimiter();
+                out.write_decimal(decimals[idx]);
+            }
+        }
+        else
+        {
+            bool first = true;
+            for (const value& sub : source.as_array())
+            {
+                if (first)
+                    first = false;
+                else
+                    out.write_array_delimiter();
+                encode_static(sub, out);
+            }
+        }
+        out.write_array_end();
+        break;
+    case kind::boolean:
+        out.write_boolean(source.as_boolean());
+        break;
+    case kind::decimal:
+        {
+            char        text[detail::max_lazy_number_length];
+            std::size_t length = detail::lazy_number_text(source, text);
+            if (length == 0 || !out.write_raw_json(string_view(text, length)))
+                out.write_decimal(source.as_decimal());
+        }
+        break;
+    case kind::integer:
+        out.write_integer(source.as_integer());
+        break;
+    case kind::null:
+        out.write_null();
+        break;
+    case kind::object:
+        out.write_object_begin(source.size());
+        {
+            bool first = true;
+            for (const value::object_value_type& entry : source.as_object())
+            {
+                if (first)
+                    first = false;
+                else
+                    out.write_object_delimiter();
+                
+                out.write_object_key(entry.first);
+                encode_static(entry.second, out);
+            }
+        }
+        out.write_object_end();
+        break;
+    case kind::string:
+        out.write_string(source.as_string_view());
+        break;
+    }
+}
+
+}
+
+#endif/*__JSONV_ENCODE_STATIC_HPP_INCLUDED__*/
@@ -0,0 +1,97 @@
+/** \file jsonv/expected.hpp
+ *  A value or the reason there is not one, for the functions which report failures without throwing.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_EXPECTED_HPP_INCLUDED__
+#define __JSONV_EXPECTED_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/optional.hpp>
+
+#include <utility>
+
+namespace jsonv
+{
+
+/** How much a function like \c try_parse or \c try_extract says about a failure. **/
+enum class failure_details
+{
+    /** Only the error code (and whatever else is cheap to know). No message is formatted and no partial result is
+     *  kept, which is what makes these functions cheaper than catching the exception of the throwing version.
+    **/
+    code,
+    /** Also the exception the throwing version would have thrown, with its messages (and partial result). This costs
+     *  at least as much as the throwing version.
+    **/
+    full,
+};
+
+/** Either a \c T or an \c E saying why there is not one (like \c std::expected). \c E must be default-constructible;
+ *  that is what \c error gives when there is a value.
+**/
+template <typename T, typename E>
+class expected
+{
+public:
+    using value_type = T;
+    using error_type = E;
+
+public:
+    expected(T x) :
+            _value(std::move(x))
+    { }
+
+    expected(E error) :
+            _error(std::move(error))
+    { }
+
+    bool has_value() const
+    {
+        return bool(_value);
+    }
+
+    explicit operator bool() const
+    {
+        return has_value();
+    }
+
+    /** Get the value.
+     *
+     *  \throws bad_optional_access if there is not one.
+    **/
+    T&       value() &       { return _value.value(); }
+    const T& value() const & { return _value.value(); }
+    T&&      value() &&      { return std::move(_value.value()); }
+
+    T&       operator*() &       { return *_value; }
+    const T& operator*() const & { return *_value; }
+    T*       operator->()        { return &*_value; }
+    const T* operator->() const  { return &*_value; }
+
+    template <typename U>
+    T value_or(U&& otherwise) const &
+    {
+        return _value ? *_value : T(std::forward<U>(otherwise));
+    }
+
+    /** Why there is no value (or a default-constructed \c E if there is one). **/
+    const E& error() const
+    {
+        return _error;
+    }
+
+private:
+    optional<T> _value;
+    E           _error;
+};
+
+}
+
+#endif/*__JSONV_EXPECTED_HPP_INCLUDED__*/
@@ -0,0 +1,83 @@
+/** \file jsonv/fd_encoder.hpp
+ *  An encoder which writes compact JSON straight to a file descriptor.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_FD_ENCODER_HPP_INCLUDED__
+#define __JSONV_FD_ENCODER_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/encode.hpp>
+
+#include <cstddef>
+#include <memory>
+
+namespace jsonv
+{
+
+namespace detail
+{
+
+class fd_writer;
+
+}
+
+/** A \c buffer_encoder which writes to a file descriptor (a file, pipe or socket) in large blocks, without going
+ *  through an \c std::ostream. The blocks are page-aligned and a multiple of the page size, which suits files opened
+ *  with \c O_DIRECT as well as ordinary ones.
+ *
+ *  With \c background set, the blocks are written by a separate thread: the encoder fills one block while the earlier
+ *  ones are being written, and every block which is waiting when the writer comes around is written with a single
+ *  \c writev. Encoding only waits if all of the blocks are waiting to be written. A failure to write is thrown from
+ *  the next call to \c encode or \c flush after it happens (and from every one after that).
+ *
+ *  The file descriptor is not closed by this.
+ *
+ *  \example "fd_encoder"
+ *  \code
+ *  int fd = ::open("dump.json", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+ *  {
+ *      jsonv::fd_encoder encoder(fd, 1 << 20, true);
+ *      encoder.encode(huge_result);
+ *      encoder.flush();
+ *  }
+ *  ::close(fd);
+ *  \endcode
+**/
+class JSONV_PUBLIC fd_encoder :
+        public buffer_encoder
+{
+public:
+    /** Create an instance which writes to \a fd in blocks of \a block_size bytes (rounded up to the page size).
+     *
+     *  \param background If set, write from a separate thread while the next blocks are filled in.
+    **/
+    explicit fd_encoder(int fd, std::size_t block_size = 1 << 20, bool background = false);
+
+    /** Flushes (and waits for the writer thread), but can not report a failure to do so -- call \c flush explicitly
+     *  before this is destroyed to find out about problems.
+    **/
+    virtual ~fd_encoder() noexcept;
+
+    /** Write everything encoded so far and wait until it has been.
+     *
+     *  \throws std::system_error if writing to the file descriptor failed.
+    **/
+    void flush();
+
+private:
+    explicit fd_encoder(std::unique_ptr<detail::fd_writer> writer);
+
+private:
+    std::unique_ptr<detail::fd_writer> _writer;
+};
+
+}
+
+#endif/*__JSONV_FD_ENCODER_HPP_INCLUDED__*/
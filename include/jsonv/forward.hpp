@@ -16,26 +16,33 @@ namespace jsonv
 
 class adapter;
 template <typename T> class adapter_builder;
+class canonical_encoder;
 class encoder;
+struct encode_stats;
 class extractor;
 class extraction_context;
 class formats;
 class formats_builder;
+class key_dictionary;
 enum class kind : unsigned char;
 class kind_error;
 template <typename T, typename TMember> class member_adapter_builder;
+struct memory_breakdown;
 class parse_error;
 class parse_options;
+struct parse_stats;
 class path;
 class path_element;
 enum class path_element_kind : unsigned char;
 template <typename TPointer> class polymorphic_adapter_builder;
+class schema;
 class serializer;
 class serialization_context;
 class tokenizer;
 enum class token_kind : unsigned int;
 class value;
 struct version;
+class writer;
 
 }
 
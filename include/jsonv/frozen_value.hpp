@@ -0,0 +1,340 @@
+/** \file jsonv/frozen_value.hpp
+ *  A compact, read-only form of a JSON document which is stored in a single block of memory.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_FROZEN_VALUE_HPP_INCLUDED__
+#define __JSONV_FROZEN_VALUE_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/path.hpp>
+#include <jsonv/string_view.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace jsonv
+{
+
+namespace detail
+{
+
+class shared_memory;
+
+}
+
+/** A read-only JSON document (or some part of one) which is laid out as a "tape" instead of a tree of nodes. Every
+ *  value is one or two 64-bit words in a single array: the word for a container records where the container ends, so
+ *  its siblings can be reached without looking inside of it, small integers and short strings fit into one word and
+ *  the contents of all the strings are kept together in one buffer (with repeated object keys stored only once). A
+ *  document takes about as much memory as its serialized form and reading it touches memory in order, which makes this
+ *  a good fit for keeping a large number of documents around which are looked at, but never changed.
+ *
+ *  Copying a \c frozen_value is cheap, since every copy (and every \c frozen_value taken from it) refers to the same
+ *  document. Objects keep their entries in the order they were written and looking up a key or an array index is a
+ *  walk over the entries before it. A document can be written to a file with \c save and mapped back into memory with
+ *  \c load_frozen, which skips parsing altogether.
+ *
+ *  \example "frozen_value"
+ *  \code
+ *  jsonv::frozen_value doc = jsonv::parse_frozen(text);
+ *  jsonv::string_view  id  = doc.at("user").at("id").as_string();
+ *  std::int64_t        ts  = doc.at_path(".events[0].ts").as_integer();
+ *  \endcode
+**/
+class JSONV_PUBLIC frozen_value
+{
+public:
+    using size_type = value::size_type;
+
+    class array_iterator;
+    class object_iterator;
+
+public:
+    /** Create an instance with \c kind::null. **/
+    frozen_value();
+
+    /** Create a frozen copy of \a source. **/
+    explicit frozen_value(const value& source);
+
+    frozen_value(const frozen_value&);
+    frozen_value& operator=(const frozen_value&);
+    frozen_value(frozen_value&&) noexcept;
+    frozen_value& operator=(frozen_value&&) noexcept;
+    ~frozen_value() noexcept;
+
+    /** Get the \c kind of this value. **/
+    jsonv::kind kind() const;
+
+    /** Build a \c value with the same contents as this one. **/
+    value to_value() const;
+
+    /** Get the element of this array at \a idx.
+     *
+     *  \throws kind_error if this is not an array.
+     *  \throws std::out_of_range if \a idx is past the end of the array.
+    **/
+    frozen_value at(size_type idx) const;
+    frozen_value operator[](size_type idx) const;
+
+    /** Get the value of this object with the given \a key. If there are duplicate keys, the first one is used.
+     *
+     *  \throws kind_error if this is not an object.
+     *  \throws std::out_of_range if the \a key is not in the object.
+    **/
+    frozen_value at(string_view key) const;
+    frozen_value operator[](string_view key) const;
+
+    /** Count the number of entries with the given \a key in this object.
+     *
+     *  \throws kind_error if this is not an object.
+    **/
+    size_type count(string_view key) const;
+
+    /** Find the first entry of this object with the given \a key.
+     *
+     *  \returns An iterator to the entry or \c end_object if there is not one.
+     *  \throws kind_error if this is not an object.
+    **/
+    object_iterator find(string_view key) const;
+
+    /** Get the value at the given \a path.
+     *
+     *  \throws std::out_of_range if any element of the path does not exist.
+     *  \throws kind_error if any element of the path does not match the \c kind it is looking at.
+    **/
+    frozen_value at_path(const path& p) const;
+    frozen_value at_path(string_view p) const;
+
+    /** Get the number of elements in an array or object or the length of a string. This is constant-time.
+     *
+     *  \throws kind_error if this is not an array, object or string.
+    **/
+    size_type size() const;
+
+    /** Iterate over the elements of an array. The iterators are forward iterators.
+     *
+     *  \throws kind_error if this is not an array.
+    **/
+    array_iterator begin_array() const;
+    array_iterator end_array() const;
+
+    /** Iterate over the entries of an object, in the order they were written. The iterators are forward iterators.
+     *
+     *  \throws kind_error if this is not an object.
+    **/
+    object_iterator begin_object() const;
+    object_iterator end_object() const;
+
+    /** Get the contents of a string. The view refers into the document and is valid as long as any \c frozen_value
+     *  which refers to the document is.
+     *
+     *  \throws kind_error if this is not a string.
+    **/
+    string_view as_string() const;
+
+    /** \throws kind_error if this is not an integer. **/
+    std::int64_t as_integer() const;
+
+    /** Get the value of a decimal or integer as a \c double.
+     *
+     *  \throws kind_error if this is not a decimal or an integer.
+    **/
+    double as_decimal() const;
+
+    /** \throws kind_error if this is not a boolean. **/
+    bool as_boolean() const;
+
+    /** Get the number of bytes of memory used by the whole document this value is a part of. **/
+    std::size_t memory_size() const;
+
+    /** Write this value to \a out in a binary form which \c load_frozen can map back into memory without parsing it.
+     *  The form is the tape and strings of the document as they are in memory, behind a header with a version and the
+     *  byte order, so it can only be loaded on machines with the same byte order. If this is a value from inside of a
+     *  larger document, only its part of the tape is written, but all of the strings are.
+    **/
+    void save(std::ostream& out) const;
+
+private:
+    struct document;
+    class builder;
+
+    friend JSONV_PUBLIC frozen_value parse_frozen(const string_view&, const parse_options&);
+    friend class frozen_segment;
+    friend JSONV_PUBLIC frozen_value load_frozen(const std::string&);
+    friend JSONV_PUBLIC frozen_value attach_frozen(const std::string&);
+
+    frozen_value(std::shared_ptr<const document> doc, std::size_t position);
+
+    void check_kind(jsonv::kind expected) const;
+
+    /** The position of the word after this value on the tape. **/
+    std::size_t next() const;
+
+    /** The number of bytes \c write_image gives. **/
+    std::size_t image_size() const;
+
+    /** Give the saved form of this value to \a write, a piece at a time. **/
+    void write_image(const std::function<void (const char*, std::size_t)>& write) const;
+
+    /** Use the saved form of a document in \a image, which \a memory keeps alive. \a source names where it came from
+     *  for errors.
+    **/
+    static frozen_value load_image(std::shared_ptr<const void> memory, string_view image, const std::string& source);
+
+private:
+    std::shared_ptr<const document> _doc;
+    std::size_t                     _position;  //!< The position of the first word of this value on the tape.
+};
+
+/** Parse \a input straight into a \c frozen_value, without building a \c value first.
+ *
+ *  \throws parse_error if there are problems with \a input, as \c parse does.
+**/
+JSONV_PUBLIC frozen_value parse_frozen(const string_view& input, const parse_options& options = parse_options());
+
+/** Load a document written by \c frozen_value::save from the file at \a path. The file is memory-mapped (with \c mmap
+ *  or \c MapViewOfFile) and used right where it is, so this takes the same short time no matter how large the document
+ *  is and pages of it are only read when they are looked at. The mapping stays open as long as any \c frozen_value
+ *  from the document is alive.
+ *
+ *  \warning
+ *  Only the header and the size of the file are checked, so the file has to be one which \c frozen_value::save wrote
+ *  (and has not been changed since). Loading something else can read past the end of the mapping.
+ *
+ *  \throws std::system_error if the file could not be opened or mapped.
+ *  \throws std::runtime_error if the file is not a saved \c frozen_value, was saved by an unsupported version or on a
+ *                             machine with a different byte order.
+**/
+JSONV_PUBLIC frozen_value load_frozen(const std::string& path);
+
+/** A document which is kept in a named shared-memory segment, so that other processes on the same host can read it
+ *  with \c attach_frozen instead of each parsing and keeping a copy of their own. The segment holds the same form
+ *  \c frozen_value::save writes, so attaching to it takes the same short time no matter how large the document is,
+ *  and every process reads the same physical memory.
+ *
+ *  \example "frozen_segment"
+ *  \code
+ *  // in the parent process, before starting the workers
+ *  jsonv::frozen_segment config("my-service-config", jsonv::parse_frozen(text));
+ *
+ *  // in each worker
+ *  jsonv::frozen_value doc = jsonv::attach_frozen("my-service-config");
+ *  \endcode
+ *
+ *  \note
+ *  On POSIX systems, the name is removed when the \c frozen_segment is destroyed: processes which have already attached
+ *  keep their mapping, but no more can attach. On Windows, the segment is kept until the last process which has it
+ *  mapped lets go of it.
+**/
+class JSONV_PUBLIC frozen_segment
+{
+public:
+    /** Copy \a doc into a new segment called \a name.
+     *
+     *  \throws std::system_error if the segment could not be created, including when one called \a name already exists.
+    **/
+    frozen_segment(const std::string& name, const frozen_value& doc);
+
+    frozen_segment(const frozen_segment&) = delete;
+    frozen_segment& operator=(const frozen_segment&) = delete;
+
+    ~frozen_segment() noexcept;
+
+    const std::string& name() const;
+
+    /** Get the document, read from this process's mapping of the segment. **/
+    frozen_value get() const;
+
+private:
+    std::string                            _name;
+    std::shared_ptr<detail::shared_memory> _memory;
+};
+
+/** Attach to the shared-memory segment called \a name, which a \c frozen_segment (possibly in another process) made.
+ *  The segment is mapped read-only and stays mapped as long as any \c frozen_value from it is alive.
+ *
+ *  \throws std::system_error if there is no segment called \a name or it could not be mapped.
+ *  \throws std::runtime_error if the segment does not hold a \c frozen_value.
+**/
+JSONV_PUBLIC frozen_value attach_frozen(const std::string& name);
+
+/** Iterates over the elements of an array \c frozen_value. **/
+class JSONV_PUBLIC frozen_value::array_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = frozen_value;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const frozen_value*;
+    using reference         = const frozen_value&;
+
+public:
+    reference operator*() const  { return _current; }
+    pointer   operator->() const { return &_current; }
+
+    array_iterator& operator++();
+    array_iterator  operator++(int);
+
+    bool operator==(const array_iterator& other) const { return _current._position == other._current._position; }
+    bool operator!=(const array_iterator& other) const { return _current._position != other._current._position; }
+
+private:
+    friend class frozen_value;
+
+    array_iterator(const frozen_value& parent, std::size_t position);
+
+private:
+    frozen_value _current;
+};
+
+/** Iterates over the entries of an object \c frozen_value. **/
+class JSONV_PUBLIC frozen_value::object_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = std::pair<string_view, frozen_value>;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const value_type*;
+    using reference         = const value_type&;
+
+public:
+    reference operator*() const  { return _current; }
+    pointer   operator->() const { return &_current; }
+
+    object_iterator& operator++();
+    object_iterator  operator++(int);
+
+    bool operator==(const object_iterator& other) const { return _position == other._position; }
+    bool operator!=(const object_iterator& other) const { return _position != other._position; }
+
+private:
+    friend class frozen_value;
+
+    object_iterator(const frozen_value& parent, std::size_t position, std::size_t end);
+
+    void load();
+
+private:
+    value_type  _current;
+    std::size_t _position;  //!< The position of the key of the current entry.
+    std::size_t _end;       //!< The position just past the end of the object.
+};
+
+}
+
+#endif/*__JSONV_FROZEN_VALUE_HPP_INCLUDED__*/
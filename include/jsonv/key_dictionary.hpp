@@ -0,0 +1,79 @@
+/** \file jsonv/key_dictionary.hpp
+ *  A dictionary of object keys which can be shared between parses.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_KEY_DICTIONARY_HPP_INCLUDED__
+#define __JSONV_KEY_DICTIONARY_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace jsonv
+{
+
+/** Remembers the decoded form of object keys, so a parser which sees the same key text again can take the decoded key
+ *  from the dictionary instead of decoding and validating it another time. Every key in the dictionary is stored
+ *  once and lives as long as the dictionary does, so pointers returned from \c find and \c insert can be compared to
+ *  tell if two keys are the same.
+ *
+ *  A dictionary is safe to use from multiple threads at once, so the same one can be used by \c parse_lines_parallel or
+ *  a parallel \c parse. Keys are stored by the text which appears in the source, so a dictionary should only be shared
+ *  between parses with the same \c parse_options::string_encoding. To keep untrusted input from growing it without
+ *  bound, a dictionary stops accepting new keys once it has \c max_size of them.
+ *
+ *  \see parse_options::keys
+**/
+class JSONV_PUBLIC key_dictionary
+{
+public:
+    using size_type = std::size_t;
+
+public:
+    /** Create an empty dictionary which will hold up to \a max_keys keys. **/
+    explicit key_dictionary(size_type max_keys = 4096);
+
+    key_dictionary(const key_dictionary&) = delete;
+    key_dictionary& operator=(const key_dictionary&) = delete;
+
+    ~key_dictionary() noexcept;
+
+    /** Find the decoded key for the \a encoded source text (the contents of the string token without the quotes).
+     *
+     *  \returns The interned key or \c nullptr if \a encoded has not been seen.
+    **/
+    const std::string* find(string_view encoded) const;
+
+    /** Remember that \a encoded decodes to \a decoded. If \a encoded is already in the dictionary, the existing key is
+     *  kept.
+     *
+     *  \returns The interned key or \c nullptr if the dictionary is full.
+    **/
+    const std::string* insert(string_view encoded, std::string decoded);
+
+    /** The number of keys in the dictionary. **/
+    size_type size() const;
+
+    /** The number of keys the dictionary will hold before it stops accepting new ones. **/
+    size_type max_size() const;
+
+private:
+    struct impl;
+
+private:
+    std::unique_ptr<impl> _impl;
+};
+
+}
+
+#endif/*__JSONV_KEY_DICTIONARY_HPP_INCLUDED__*/
@@ -0,0 +1,230 @@
+/** \file jsonv/lazy_value.hpp
+ *  A read-only view of a JSON document which only parses the parts of it which are looked at.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_LAZY_VALUE_HPP_INCLUDED__
+#define __JSONV_LAZY_VALUE_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/path.hpp>
+#include <jsonv/string_view.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace jsonv
+{
+
+/** A read-only view of some part of a JSON document which builds \c value instances only for the parts that are
+ *  accessed. Creating a \c lazy_value indexes the structural characters of the document and matches up its brackets,
+ *  which is much faster than parsing it; looking up a child skips over its siblings without looking inside of them.
+ *  This is useful when only a few fields of a large document are needed.
+ *
+ *  Only the structure of a document is checked when a \c lazy_value is created. Problems inside of a subtree (such as a
+ *  malformed number) are found when that subtree is converted with \c to_value. Comments are not supported, since a
+ *  comment can contain anything.
+ *
+ *  \example "lazy_value"
+ *  \code
+ *  jsonv::lazy_value message(text);
+ *  std::string   user = message.at("user").at("id").as_string();
+ *  std::int64_t  ts   = message.at_path(".events[0].ts").as_integer();
+ *  \endcode
+**/
+class JSONV_PUBLIC lazy_value
+{
+public:
+    using size_type = value::size_type;
+
+    class array_iterator;
+    class object_iterator;
+
+public:
+    /** Create a view of the document in \a input. The contents of \a input are not copied, so they must outlive this
+     *  instance and every \c lazy_value taken from it.
+     *
+     *  \throws parse_error if the brackets in \a input do not match up or there is data after the document.
+    **/
+    explicit lazy_value(string_view input, const parse_options& options = parse_options());
+
+    /** Create a view of the document in \a input, which is kept alive by this instance and every \c lazy_value taken
+     *  from it.
+     *
+     *  \throws parse_error if the brackets in \a input do not match up or there is data after the document.
+    **/
+    explicit lazy_value(std::shared_ptr<const std::string> input, const parse_options& options = parse_options());
+
+    lazy_value(const lazy_value&);
+    lazy_value& operator=(const lazy_value&);
+    lazy_value(lazy_value&&) noexcept;
+    lazy_value& operator=(lazy_value&&) noexcept;
+    ~lazy_value() noexcept;
+
+    /** Get the \c kind of this value, which is determined by looking at the first few characters of its text. **/
+    jsonv::kind kind() const;
+
+    /** Get the JSON text of this value. **/
+    string_view text() const;
+
+    /** Parse this value (and everything under it) into a \c value.
+     *
+     *  \throws parse_error if there is a problem with the text of this value. The locations of the problems are
+     *                      relative to the start of \c text.
+    **/
+    value to_value() const;
+
+    /** Get the element of this array at \a idx.
+     *
+     *  \throws kind_error if this is not an array.
+     *  \throws std::out_of_range if \a idx is past the end of the array.
+    **/
+    lazy_value at(size_type idx) const;
+    lazy_value operator[](size_type idx) const;
+
+    /** Get the value of this object with the given \a key. If there are duplicate keys, the first one is used.
+     *
+     *  \throws kind_error if this is not an object.
+     *  \throws std::out_of_range if the \a key is not in the object.
+    **/
+    lazy_value at(string_view key) const;
+    lazy_value operator[](string_view key) const;
+
+    /** Count the number of entries with the given \a key in this object.
+     *
+     *  \throws kind_error if this is not an object.
+    **/
+    size_type count(string_view key) const;
+
+    /** Get the value at the given \a path.
+     *
+     *  \throws std::out_of_range if any element of the path does not exist.
+     *  \throws kind_error if any element of the path does not match the \c kind it is looking at.
+    **/
+    lazy_value at_path(const path& p) const;
+    lazy_value at_path(string_view p) const;
+
+    /** Get the number of elements in an array or object or the length of a string. Arrays and objects are counted by
+     *  stepping over their elements, so this is linear in the number of elements.
+     *
+     *  \throws kind_error if this is not an array, object or string.
+    **/
+    size_type size() const;
+
+    /** Iterate over the elements of an array. The iterators are forward iterators.
+     *
+     *  \throws kind_error if this is not an array.
+    **/
+    array_iterator begin_array() const;
+    array_iterator end_array() const;
+
+    /** Iterate over the entries of an object, in the order they appear in the document. The iterators are forward
+     *  iterators.
+     *
+     *  \throws kind_error if this is not an object.
+    **/
+    object_iterator begin_object() const;
+    object_iterator end_object() const;
+
+    /** Shortcuts for \c to_value followed by the matching \c value accessor. **/
+    std::string  as_string() const;
+    std::int64_t as_integer() const;
+    double       as_decimal() const;
+    bool         as_boolean() const;
+
+private:
+    struct document;
+
+    lazy_value(std::shared_ptr<const document> doc, std::size_t begin, std::size_t end, std::size_t position);
+
+    void check_kind(jsonv::kind expected) const;
+
+private:
+    std::shared_ptr<const document> _doc;
+    std::size_t                     _begin;     //!< The offset of the start of \c text in the document.
+    std::size_t                     _end;       //!< The offset of the end of \c text in the document.
+    std::size_t                     _position;  //!< The position of the first character in the structural index.
+};
+
+/** Iterates over the elements of an array \c lazy_value. **/
+class JSONV_PUBLIC lazy_value::array_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = lazy_value;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const lazy_value*;
+    using reference         = const lazy_value&;
+
+public:
+    reference operator*() const  { return _current; }
+    pointer   operator->() const { return &_current; }
+
+    array_iterator& operator++();
+    array_iterator  operator++(int);
+
+    bool operator==(const array_iterator& other) const { return _cursor == other._cursor; }
+    bool operator!=(const array_iterator& other) const { return _cursor != other._cursor; }
+
+private:
+    friend class lazy_value;
+
+    array_iterator(const lazy_value& parent, std::size_t cursor);
+
+    void load();
+
+private:
+    lazy_value  _current;
+    std::size_t _cursor;    //!< The position of the structural before the current element.
+    std::size_t _next;      //!< The position of the structural after the current element.
+    std::size_t _close;     //!< The position of the closing bracket.
+};
+
+/** Iterates over the entries of an object \c lazy_value. **/
+class JSONV_PUBLIC lazy_value::object_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = std::pair<std::string, lazy_value>;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const value_type*;
+    using reference         = const value_type&;
+
+public:
+    reference operator*() const  { return _current; }
+    pointer   operator->() const { return &_current; }
+
+    object_iterator& operator++();
+    object_iterator  operator++(int);
+
+    bool operator==(const object_iterator& other) const { return _cursor == other._cursor; }
+    bool operator!=(const object_iterator& other) const { return _cursor != other._cursor; }
+
+private:
+    friend class lazy_value;
+
+    object_iterator(const lazy_value& parent, std::size_t cursor);
+
+    void load();
+
+private:
+    value_type  _current;
+    std::size_t _cursor;    //!< The position of the structural before the current entry.
+    std::size_t _next;      //!< The position of the structural after the current entry.
+    std::size_t _close;     //!< The position of the closing brace.
+};
+
+}
+
+#endif/*__JSONV_LAZY_VALUE_HPP_INCLUDED__*/
@@ -0,0 +1,64 @@
+/** \file jsonv/memory_usage.hpp
+ *  Accounting for the heap memory behind a \c value.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_MEMORY_USAGE_HPP_INCLUDED__
+#define __JSONV_MEMORY_USAGE_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+
+namespace jsonv
+{
+
+/** The heap memory used by a \c value tree, as reported by \c memory_usage. The byte counts are what the library asks
+ *  its allocator for, so they do not include the bookkeeping of \c malloc itself.
+**/
+struct JSONV_PUBLIC memory_breakdown
+{
+    /** The contents of strings and object keys which are too long to be stored inside of their \c std::string. Strings
+     *  which refer into a parse buffer (see \c parse_options::strings) are not counted, since the buffer is not owned by
+     *  the tree.
+    **/
+    std::size_t string_bytes = 0;
+
+    /** The storage for the entries of objects: the nodes of the \c std::map or the block of a flat object (see
+     *  \c JSONV_OBJECT_FLAT_STORAGE), which includes the \c value of each entry.
+    **/
+    std::size_t object_bytes = 0;
+
+    /** The blocks which hold the elements of arrays, including their unused capacity. **/
+    std::size_t array_bytes = 0;
+
+    /** The fixed-size storage behind each object, array and string value. **/
+    std::size_t header_bytes = 0;
+
+    /** The number of separate allocations all of the above is spread across. **/
+    std::size_t allocations = 0;
+
+    /** The sum of all of the byte counts. **/
+    std::size_t total_bytes() const
+    {
+        return string_bytes + object_bytes + array_bytes + header_bytes;
+    }
+
+    memory_breakdown& operator+=(const memory_breakdown& other);
+};
+
+/** Work out how much heap memory the tree under \a source uses. This walks the whole tree. Storage which \a source
+ *  shares with other values (see \c value::make_shareable) is counted in full, as if \a source were its only owner.
+**/
+JSONV_PUBLIC memory_breakdown memory_usage(const value& source);
+
+}
+
+#endif/*__JSONV_MEMORY_USAGE_HPP_INCLUDED__*/
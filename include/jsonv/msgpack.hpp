@@ -0,0 +1,145 @@
+/** \file jsonv/msgpack.hpp
+ *  Encoding and parsing values as MessagePack, a binary format with the same data model as JSON.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_MSGPACK_HPP_INCLUDED__
+#define __JSONV_MSGPACK_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/encode.hpp>
+#include <jsonv/forward.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jsonv
+{
+
+/** An encoder which writes MessagePack instead of JSON text. Integers, strings, arrays and maps use the smallest
+ *  format which holds them and decimals are written as 32-bit floats when that is exact. Infinity and NaN are written
+ *  as they are.
+ *
+ *  MessagePack always stores the size of an array or map before its contents. Containers written by \c encode have a
+ *  known size, so they go straight to the output. Containers written through a \c writer (or by handing this to
+ *  \c parse) do not, so their contents are held in memory until they are closed.
+ *
+ *  Like \c buffer_encoder, output is gathered in a buffer and handed off when it fills up or \c flush is called.
+**/
+class JSONV_PUBLIC msgpack_encoder :
+        public encoder
+{
+public:
+    /** Called with the encoded bytes when the buffer is full or is flushed. **/
+    using flush_function = std::function<void (string_view)>;
+
+public:
+    /** Create an instance which appends to \a output. The bytes are in \a output after \c flush is called (or this
+     *  instance is destroyed).
+    **/
+    explicit msgpack_encoder(std::string& output);
+
+    /** Create an instance which hands its output to \a flush in chunks of (at most) \a chunk_size bytes. **/
+    explicit msgpack_encoder(flush_function flush, std::size_t chunk_size = 4096);
+
+    virtual ~msgpack_encoder() noexcept;
+
+    /** Hand the buffered output to the flush function. Containers which are still open are not part of it. **/
+    void flush();
+
+    /** The number of bytes which have been written to the buffer since it was last flushed. **/
+    std::size_t size() const;
+
+protected:
+    virtual void write_null() override;
+
+    virtual void write_object_begin() override;
+
+    virtual void write_object_begin_sized(std::size_t count) override;
+
+    virtual void write_object_end() override;
+
+    virtual void write_object_key(string_view key) override;
+
+    virtual void write_object_delimiter() override;
+
+    virtual void write_array_begin() override;
+
+    virtual void write_array_begin_sized(std::size_t count) override;
+
+    virtual void write_array_end() override;
+
+    virtual void write_array_delimiter() override;
+
+    virtual void write_string(string_view value) override;
+
+    virtual void write_integer(std::int64_t value) override;
+
+    virtual void write_decimal(double value) override;
+
+    virtual void write_boolean(bool value) override;
+
+private:
+    struct open_container
+    {
+        bool        is_object;
+        bool        sized;
+        std::size_t count; //!< The entries written so far (only kept for containers without a size)
+        std::size_t start; //!< Where the contents start in \c _pending
+    };
+
+    /** A value (or an object key) is starting, so count it as an entry of the innermost container. **/
+    void start_entry(bool is_key);
+
+    void begin_container(bool is_object, bool sized, std::size_t count);
+
+    void end_container();
+
+    void write_bytes(const char* data, std::size_t length);
+
+private:
+    std::unique_ptr<detail::output_buffer> _buffer;
+    std::vector<open_container>            _open;
+    /** The number of entries in \c _open without a size. While there are any, output goes to \c _pending. **/
+    std::size_t                            _unsized_open;
+    std::string                            _pending;
+};
+
+/** Encode \a source as MessagePack.
+ *
+ *  \see msgpack_encoder
+**/
+JSONV_PUBLIC std::string encode_msgpack(const value& source);
+
+/** Build a \c value from the MessagePack in \a input.
+ *
+ *  Strings, integers, floats, booleans and \c nil are read as the matching \c kind. Integers which do not fit in an
+ *  \c std::int64_t become decimals. Binary data, extension types and map keys which are not strings have no JSON
+ *  equivalent, so they are errors. Strings are not checked for valid UTF-8.
+ *
+ *  Of the \a options, \c max_structure_depth, \c complete_parse, \c require_finite_numbers and \c string_storage are
+ *  respected. Since strings in MessagePack never need decoding, \c parse_options::strings::borrow and
+ *  \c parse_options::strings::share make every string refer into \a input (or a shared copy of it) instead of
+ *  copying it. Like \c parse_cbor, problems are always thrown immediately and the reported location is on line 1,
+ *  with the offset into \a input as the character.
+ *
+ *  \throws parse_error if \a input is not valid MessagePack or has something which can not be represented as a
+ *                      \c value.
+**/
+JSONV_PUBLIC value parse_msgpack(string_view input, const parse_options& options = parse_options());
+
+}
+
+#endif/*__JSONV_MSGPACK_HPP_INCLUDED__*/
@@ -0,0 +1,103 @@
+/** \file jsonv/ndjson_writer.hpp
+ *  Writing newline-delimited JSON from many threads at once.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_NDJSON_WRITER_HPP_INCLUDED__
+#define __JSONV_NDJSON_WRITER_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/forward.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+
+namespace jsonv
+{
+
+namespace detail
+{
+
+class ndjson_state;
+
+}
+
+/** Writes newline-delimited JSON (one compact document per line, also known as NDJSON or JSON Lines) to a single
+ *  output from any number of threads. Each thread which writes gets a buffer of its own, so encoding a line only locks
+ *  that buffer (which nothing else wants, except for \c flush). Once a buffer is half full, its whole lines are handed
+ *  to the output together, which is the only time threads wait on each other.
+ *
+ *  Lines from one thread come out in the order that thread wrote them, but lines from different threads are mixed in
+ *  batches, not in the order they were written.
+ *
+ *  \example "ndjson_writer"
+ *  \code
+ *  jsonv::ndjson_writer events(std::cout);
+ *  // on any thread
+ *  events.write(jsonv::object({ { "event", "login" }, { "user", user_id } }));
+ *  events.write_with([&] (jsonv::writer& out)
+ *                    {
+ *                        out.begin_object();
+ *                        out.key("event").value("logout");
+ *                        out.key("user").value(user_id);
+ *                        out.end_object();
+ *                    }
+ *                   );
+ *  // once all of the threads are done
+ *  events.flush();
+ *  \endcode
+**/
+class JSONV_PUBLIC ndjson_writer
+{
+public:
+    /** Called with a batch of whole lines, newlines included. Only one thread calls it at a time. **/
+    using sink_function = std::function<void (string_view)>;
+
+public:
+    /** Create an instance which writes to \a output, which must outlive this instance. Each thread's buffer is
+     *  \a batch_size bytes.
+    **/
+    explicit ndjson_writer(std::ostream& output, std::size_t batch_size = 64 * 1024);
+
+    /** Create an instance which hands batches of lines to \a sink. Each thread's buffer is \a batch_size bytes. **/
+    explicit ndjson_writer(sink_function sink, std::size_t batch_size = 64 * 1024);
+
+    ndjson_writer(const ndjson_writer&) = delete;
+    ndjson_writer& operator=(const ndjson_writer&) = delete;
+
+    /** Flushes, but can not report a failure to do so -- call \c flush explicitly before this is destroyed to find out
+     *  about problems. Nothing may be writing when this is destroyed.
+    **/
+    ~ndjson_writer() noexcept;
+
+    /** Write \a line (encoded compactly) and a newline. **/
+    void write(const value& line);
+
+    /** Write a line by calling \a write with a \c writer for it. \a write must write exactly one complete document.
+     *
+     *  \throws std::logic_error if \a write did not complete a document. Anything \a write throws is thrown as it is. In
+     *   either case, none of the line is written.
+    **/
+    void write_with(const std::function<void (writer&)>& write);
+
+    /** Hand everything which every thread has written so far to the output. This can be called while other threads are
+     *  writing, but only the lines which are done when it gets to each buffer are sure to be included.
+    **/
+    void flush();
+
+private:
+    std::shared_ptr<detail::ndjson_state> _state;
+};
+
+}
+
+#endif/*__JSONV_NDJSON_WRITER_HPP_INCLUDED__*/
@@ -12,12 +12,20 @@
 #define __JSONV_PARSE_HPP_INCLUDED__
 
 #include <jsonv/config.hpp>
+#include <jsonv/expected.hpp>
+#include <jsonv/forward.hpp>
+#include <jsonv/optional.hpp>
+#include <jsonv/path.hpp>
 #include <jsonv/string_view.hpp>
 #include <jsonv/value.hpp>
 
+#include <chrono>
 #include <cstddef>
 #include <deque>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace jsonv
 {
@@ -172,6 +180,33 @@ public:
         decimal,
         /** Strictly comply with the JSON specification for numbers -- no leading zeros! **/
         strict,
+        /** Like \c strict, but a number which is not an \c int64_t (it has a fraction or an exponent or is too large)
+         *  keeps the text it was written as instead of being converted. \c value::as_decimal converts the text each
+         *  time it is called and encoding the value writes the text back unchanged, so a parse and encode never loses
+         *  precision (and costs nothing for numbers which are never looked at). The text is packed into the \c value
+         *  itself, so nothing refers to the input; numbers longer than 28 characters do not fit and are converted right
+         *  away, as are all numbers when \c require_finite_numbers is set.
+        **/
+        lazy,
+    };
+    
+    /** How should the contents of strings be stored in the parsed \c value? **/
+    enum class strings
+    {
+        /** Copy the contents of every string into the \c value which holds it. **/
+        copy,
+        /** Strings which do not need decoding (ASCII strings without escape sequences) refer directly into the input
+         *  instead of being copied. The input must outlive the parsed \c value and everything copied from it. This
+         *  only applies when parsing a \c string_view or a range of characters -- input from an \c std::istream or a
+         *  \c tokenizer is always copied.
+        **/
+        borrow,
+        /** Like \c borrow, but the input is first copied into a single buffer which is shared by every string that
+         *  refers into it. There are no requirements on the lifetime of the input and a document with many strings is
+         *  copied once instead of many times, but the whole buffer is kept in memory as long as any of the strings
+         *  that refer into it.
+        **/
+        share,
     };
     
 public:
@@ -264,6 +299,125 @@ public:
     bool comments() const;
     parse_options& comments(bool);
     
+    /** How should the contents of strings be stored? By default, this is \c strings::copy. Even when borrowing, calling
+     *  \c value::as_string on a string which refers into the input makes a copy of it the first time it is called;
+     *  use \c value::as_string_view to avoid that.
+    **/
+    strings string_storage() const;
+    parse_options& string_storage(strings);
+    
+    /** The paths to keep from the parsed document. By default, this is empty, which keeps the entire document. When
+     *  there are paths, only the values at (or under) one of them are put in the result; everything else is skipped
+     *  over by token without being decoded, so pulling a few fields out of a huge document takes memory proportional
+     *  to the fields. Skipped values are only checked for matching brackets.
+     *  
+     *  The structure leading to a selected value is kept, so \c value::at_path works for each selected path which
+     *  exists in the document. To keep indices stable, array elements before a selected index are replaced with
+     *  \c null and elements after the last selected index are dropped.
+     *  
+     *  \example
+     *  \code
+     *  parse(huge_text, parse_options().select({ path::create(".user.id"), path::create(".events[0]") }))
+     *  \endcode
+     *  
+     *  Only the \c parse functions which return a \c value look at this -- \c incremental_parser and the \c parse
+     *  functions which call an \c encoder see the whole document.
+    **/
+    const std::vector<path>& selection() const;
+    parse_options& select(std::vector<path> paths);
+    
+    /** The number of threads to parse with. By default, this is 1. If it is 0, the number of hardware threads is used.
+     *  
+     *  When this is more than 1 and the document is a large top-level array, the \c parse functions which take a
+     *  \c string_view or range of characters find the boundaries of the array's elements with a quick structural scan
+     *  and parse the elements on separate threads. Everything else (input from an \c std::istream or \c tokenizer,
+     *  small documents, documents with comments or a \c selection) is parsed on the calling thread. If there are any
+     *  problems in the document, it is parsed again on the calling thread so they are reported exactly as usual.
+    **/
+    size_type parallelism() const;
+    parse_options& parallelism(size_type threads);
+    
+    /** The dictionary to intern object keys with. By default, there is none and every key is decoded on its own. Keys
+     *  which are already in the dictionary are copied out of it instead of being decoded again, and keys which are not
+     *  are added to it, so a dictionary shared between the parses of a stream of similar documents saves the work of
+     *  decoding and validating the same keys over and over.
+     *  
+     *  The \c incremental_parser and every \c parse function use this, but \c lazy_value does not.
+     *  
+     *  \see key_dictionary
+    **/
+    const std::shared_ptr<key_dictionary>& keys() const;
+    parse_options& keys(std::shared_ptr<key_dictionary> dictionary);
+    
+    /** Should numbers which are too large to represent (such as \c 1e999, which would become infinity) be parse
+     *  errors? By default, this is \c false. Turning it on does the check \c validate makes while parsing, so there is
+     *  no need to walk the result again.
+    **/
+    bool require_finite_numbers() const;
+    parse_options& require_finite_numbers(bool);
+    
+    /** Should arrays which only hold integers or only hold decimals (such as a vector of features) have their elements
+     *  packed (see \c value::pack_numbers)? By default, this is \c false. A document which is mostly long arrays of
+     *  numbers takes about half of the memory when this is on and encoding it does not need to make the elements into
+     *  \c value instances; the first lookup of an element in an array does.
+    **/
+    bool pack_numbers() const;
+    parse_options& pack_numbers(bool);
+    
+    /** The \c schema the parsed value is checked against. By default, there is none. Each value is checked as soon as
+     *  it has been parsed, so a mismatch is reported as a \c parse_error at the place in the input it was found (and
+     *  with \c on_error::fail_immediately, parsing stops right there). There is no separate pass over the result.
+     *  
+     *  Only the \c parse functions which return a \c value look at this. Objects and arrays which are filtered by a
+     *  \c selection are not checked, since the parts of them which are skipped are never seen.
+    **/
+    const std::shared_ptr<const schema>& validation_schema() const;
+    parse_options& validation_schema(std::shared_ptr<const schema> rules);
+    
+    /** The \c parse_stats which the counts and times of each phase of parsing are added to. By default, there is none
+     *  and nothing is measured. The same instance can be given to many parses (one at a time) to add them all up.
+     *  
+     *  The \c parse functions which return a \c value or call an \c encoder look at this, but \c incremental_parser
+     *  does not. A document is not split between threads (see \c parallelism) while its stats are being collected.
+    **/
+    const std::shared_ptr<parse_stats>& stats() const;
+    parse_options& stats(std::shared_ptr<parse_stats> collector);
+    
+    /** The maximum number of values (including every array, object and member of them) in the parsed document. By
+     *  default, this is 0, which means there is no limit.
+     *  
+     *  This and the other budgets (\c max_string_length, \c max_object_members, \c max_bytes and \c max_parse_time)
+     *  are for input which can not be trusted: a document which goes over any of them stops the parse right where it
+     *  happens with a \c parse_limit_error, whatever the \c failure_mode is. They are checked as the document is
+     *  built, so only the \c parse functions which return a \c value look at them, and a budgeted document is not
+     *  split between threads (see \c parallelism). Values which are skipped over by a \c selection do not count.
+    **/
+    size_type max_nodes() const;
+    parse_options& max_nodes(size_type limit);
+    
+    /** The maximum length of a string or object key, in characters of the input between the quotes (so an escape
+     *  sequence counts for all of its characters). By default, this is 0, which means there is no limit.
+    **/
+    size_type max_string_length() const;
+    parse_options& max_string_length(size_type limit);
+    
+    /** The maximum number of members of any one object. By default, this is 0, which means there is no limit. **/
+    size_type max_object_members() const;
+    parse_options& max_object_members(size_type limit);
+    
+    /** The maximum memory the parsed document can take up, in bytes. This is an estimate made as cheaply as possible:
+     *  each value counts for \c sizeof(value), each string for the characters of its input and each object member for
+     *  a \c std::string to hold the key. By default, this is 0, which means there is no limit.
+    **/
+    std::size_t max_bytes() const;
+    parse_options& max_bytes(std::size_t limit);
+    
+    /** The longest a single parse can take, starting when the \c parse function is called. The clock is checked every
+     *  few hundred tokens, so a parse can run a little over. By default, this is 0, which means there is no limit.
+    **/
+    std::chrono::nanoseconds max_parse_time() const;
+    parse_options& max_parse_time(std::chrono::nanoseconds limit);
+    
 private:
     // For the purposes of ABI compliance, most modifications to the variables in this class should bump the minor
     // version number.
@@ -276,8 +430,116 @@ private:
     bool        _require_document = false;
     bool        _complete_parse   = true;
     bool        _comments         = true;
+    strings     _string_storage   = strings::copy;
+    std::vector<path> _selection;
+    size_type   _parallelism      = 1;
+    std::shared_ptr<key_dictionary> _keys;
+    bool        _require_finite   = false;
+    bool        _pack_numbers     = false;
+    std::shared_ptr<const schema> _schema;
+    std::shared_ptr<parse_stats> _stats;
+    size_type   _max_nodes        = 0;
+    size_type   _max_string_len   = 0;
+    size_type   _max_members      = 0;
+    std::size_t _max_bytes        = 0;
+    std::chrono::nanoseconds _max_parse_time = std::chrono::nanoseconds(0);
+};
+
+/** The budgets of \c parse_options which a document can go over. **/
+enum class parse_limit
+{
+    nodes,              //!< \c parse_options::max_nodes
+    string_length,      //!< \c parse_options::max_string_length
+    object_members,     //!< \c parse_options::max_object_members
+    bytes,              //!< \c parse_options::max_bytes
+    time,               //!< \c parse_options::max_parse_time
+};
+
+/** Get the name of the \c parse_options setting for \a which. **/
+JSONV_PUBLIC std::ostream& operator<<(std::ostream& os, const parse_limit& which);
+
+/** Thrown when a document goes over one of the budgets of \c parse_options (such as \c parse_options::max_nodes). Parsing
+ *  stops as soon as that happens, so the last of the \c problems is the one which says where, and the partial result
+ *  is always \c null.
+**/
+class JSONV_PUBLIC parse_limit_error :
+        public parse_error
+{
+public:
+    parse_limit_error(parse_limit which, problem_list problems);
+    
+    virtual ~parse_limit_error() noexcept;
+    
+    /** The budget which was gone over. **/
+    parse_limit limit() const;
+    
+private:
+    parse_limit _limit;
+};
+
+/** Why \c try_parse failed. Each \c parse_error message the parser can give has one of these. **/
+enum class parse_errc : unsigned char
+{
+    none,
+    unexpected_end,         //!< The input ended before the document did (or had nothing in it).
+    invalid_token,          //!< Something which can not start a value.
+    invalid_literal,        //!< A misspelled \c true, \c false or \c null.
+    invalid_number,
+    invalid_string,         //!< A string which could not be decoded (see \c parse_options::string_encoding).
+    missing_separator,      //!< Something other than a \c , or the end after an element or member.
+    missing_key,            //!< Something other than a string where an object key should be.
+    missing_colon,          //!< Something other than a \c : after an object key.
+    trailing_comma,         //!< See \c parse_options::comma_policy.
+    duplicate_key,
+    comment,                //!< See \c parse_options::comments.
+    too_deep,               //!< See \c parse_options::max_structure_depth.
+    trailing_data,          //!< See \c parse_options::complete_parse.
+    not_a_document,         //!< See \c parse_options::require_document.
+    schema_mismatch,        //!< See \c parse_options::validation_schema.
+    limit_exceeded,         //!< One of the budgets of \c parse_limit.
 };
 
+/** Get the name of \a code. **/
+JSONV_PUBLIC std::ostream& operator<<(std::ostream& os, const parse_errc& code);
+
+/** Where and why \c try_parse failed. **/
+struct JSONV_PUBLIC parse_failure
+{
+    parse_errc  code   = parse_errc::none;
+    
+    /** The character index into the input of the token where the problem was found. **/
+    std::size_t offset = 0;
+    
+    /** The \c parse_error which \c parse throws for the input (only with \c failure_details::full). **/
+    std::shared_ptr<const parse_error> details;
+};
+
+using parse_result = expected<value, parse_failure>;
+
+/** Like \c parse, but problems are returned instead of thrown. By default (\a details of \c failure_details::code),
+ *  parsing stops at the first problem without formatting a message, building a partial result or unwinding the stack,
+ *  so malformed input costs less to reject than it does to parse. Since it stops at the first problem, the
+ *  \c parse_options::failure_mode of \a options does not matter (\c on_error::ignore is not ignored).
+ *  
+ *  With \c failure_details::full, a failed input is parsed again the way \c parse would, so the \c parse_failure::details
+ *  have every message and the partial result.
+ *  
+ *  \example
+ *  \code
+ *  jsonv::parse_result result = jsonv::try_parse(request_body);
+ *  if (!result)
+ *      return reject(400, result.error().code, result.error().offset);
+ *  handle(*result);
+ *  \endcode
+ *  
+ *  \throws std::bad_alloc (and anything else which is not a problem with the input, such as an error in the
+ *          \c parse_options) just like \c parse does.
+**/
+parse_result JSONV_PUBLIC try_parse(string_view                input,
+                                    const parse_options&       options = parse_options(),
+                                    failure_details            details = failure_details::code
+                                   );
+
 /** Reads a JSON value from the input stream.
  *  
  *  \note
@@ -304,12 +566,109 @@ value JSONV_PUBLIC parse(std::istream& input, const parse_options& = parse_optio
 **/
 value JSONV_PUBLIC parse(const string_view& input, const parse_options& = parse_options());
 
+/** Parse \a input into \a target, which is overwritten. This is the same as <tt>target = parse(input, options)</tt>,
+ *  except the storage of the old \a target is reused: wherever the new document has an array, object or string in the
+ *  same place as the old one did, it is refilled instead of being freed and allocated again. Entries of objects are
+ *  matched up by key and elements of arrays by index, and strings keep their capacity. This is meant for parsing the
+ *  same shape of document over and over (such as polling a status endpoint), where most of the tree stays the same.
+ *  
+ *  Storage which is shared with another \c value (see \c value::make_shareable) is never changed; parsing with a
+ *  \c parse_options::selection or in parallel (see \c parse_options::parallelism) reuses less (or nothing).
+ *  
+ *  \example "parse_into(value&, const string_view&, const parse_options&)"
+ *  \code
+ *  jsonv::value status;
+ *  while (poll(message))
+ *  {
+ *      jsonv::parse_into(status, message);
+ *      update(status);
+ *  }
+ *  \endcode
+ *  
+ *  \throws parse_error if an error is found in the JSON. \a target is left \c null.
+**/
+void JSONV_PUBLIC parse_into(value& target, const string_view& input, const parse_options& = parse_options());
+
+/** Where the text of a document was changed: the \c removed bytes starting at \c offset were replaced by \c inserted
+ *  bytes, which start at the same \c offset in the new text.
+**/
+struct JSONV_PUBLIC edit_range
+{
+    std::size_t offset;
+    std::size_t removed;
+    std::size_t inserted;
+};
+
+/** Bring \a tree up to date with \a new_text, which is the text \a tree was parsed from with the \a edit made to it.
+ *  The new text is tokenized (but not decoded) to find the smallest array or object around the edit; only that
+ *  container is parsed again and every other part of \a tree is kept as it was. If the edit is not inside of a
+ *  container, changed the structure around it (such as moving where an enclosing container ends) or the containers
+ *  around it do not match \a tree, all of \a new_text is parsed instead -- so the result is always the same as
+ *  <tt>parse(new_text, options)</tt>.
+ *  
+ *  \example "reparse(value&, string_view, const edit_range&, const parse_options&)"
+ *  \code
+ *  text.replace(offset, removed, replacement);
+ *  jsonv::reparse(config, text, { offset, removed, replacement.size() });
+ *  \endcode
+ *  
+ *  \throws parse_error if an error is found in \a new_text, as \c parse would.
+**/
+void JSONV_PUBLIC reparse(value&               tree,
+                          string_view          new_text,
+                          const edit_range&    edit,
+                          const parse_options& = parse_options()
+                         );
+
 /** Construct a JSON value from the given input in `[begin, end)`.
  *
  *  \throws parse_error if an error is found in the JSON.
 **/
 value JSONV_PUBLIC parse(const char* begin, const char* end, const parse_options& = parse_options());
 
+/** Check that \a input is a document which \c parse would accept with the same \a options, without building a \c value
+ *  or decoding any strings (they are only checked). This is much cheaper than parsing and throwing the result away, so
+ *  it is useful for rejecting malformed input early.
+ *  
+ *  Only the syntax is checked: duplicate keys in an object and the \c parse_options::validation_schema are not (and the
+ *  \c parse_options::failure_mode does not matter), so a few documents which pass can still fail to \c parse.
+ *  
+ *  \see validate_syntax
+**/
+bool JSONV_PUBLIC is_valid(string_view input, const parse_options& = parse_options());
+
+/** Like \c is_valid, but tell where the problem is.
+ *  
+ *  \returns The first problem with \a input (with a message like \c parse would give) or \c nullopt if there are none.
+**/
+optional<parse_error::problem> JSONV_PUBLIC validate_syntax(string_view input, const parse_options& = parse_options());
+
+/** Reads a JSON value from the file at \a path. The file is memory-mapped (with \c mmap or \c MapViewOfFile) and
+ *  tokenized straight from the mapping, so it is never copied. With \c parse_options::strings::borrow or
+ *  \c parse_options::strings::share, strings in the result refer into the mapping, which is kept open for as long as
+ *  any of them are alive.
+ *  
+ *  \throws std::system_error if the file could not be opened or mapped.
+ *  \throws parse_error if an error is found in the JSON. If the \a options allow for it, the \c parse_error will
+ *                      contain a partial result.
+**/
+value JSONV_PUBLIC parse_file(const std::string& path, const parse_options& = parse_options());
+
+/** Build a value from a fragment of JSON which has already been encoded, such as a cached sub-document which is
+ *  embedded in many responses. The result is an ordinary \c value, but if it is an array or object, it remembers
+ *  \a text: \c encoder::encode writes that text as it is instead of walking the value again (for encoders which write
+ *  JSON -- see \c encoder::write_raw_json). Copies of the result keep the text, so combining this with
+ *  \c value::make_shareable makes putting the fragment into a larger document and encoding it cheap. The text is
+ *  dropped as soon as the value is changed (or a reference into it is given out).
+ *  
+ *  Since it will be written out verbatim, \a text is parsed strictly (like \c parse_options::create_strict, except any
+ *  kind of value is allowed at the top level). Whitespace around the value is trimmed. Strings in the result refer into
+ *  the kept text instead of copying it.
+ *  
+ *  \throws parse_error if \a text is not a valid JSON value.
+**/
+value JSONV_PUBLIC raw_json(std::string text);
+
 /** Reads a JSON value from a buffered \c tokenizer. This less convenient function is useful when setting
  *  \c parse_options::complete_parse to \c false.
  *  
@@ -326,6 +685,172 @@ value JSONV_PUBLIC parse(const char* begin, const char* end, const parse_options
 **/
 value JSONV_PUBLIC parse(tokenizer& input, const parse_options& = parse_options());
 
+/** Parse a JSON document from \a input, calling \a handler for each part of it instead of building a \c value. The
+ *  \a handler sees the same sequence of calls \c encoder::encode would have made for the parsed value, so an
+ *  \c ostream_encoder can reformat a document without ever holding all of it in memory. Values are handed over as soon
+ *  as they are parsed, which means duplicate keys in an object are passed along instead of being reported.
+ *  
+ *  If there are problems with the document and the failure mode is not \c parse_options::on_error::fail_immediately,
+ *  the \a handler is still given a balanced document (open arrays and objects are closed and invalid values are
+ *  replaced with \c null) before the \c parse_error is thrown.
+ *  
+ *  \example "parse(const string_view&, encoder&, const parse_options&)"
+ *  Minify a document.
+ *  \code
+ *  std::ostringstream out;
+ *  jsonv::ostream_encoder encoder(out);
+ *  jsonv::parse(input, encoder);
+ *  \endcode
+ *  
+ *  \throws parse_error if an error is found in the JSON. The \c partial_result of the error is always \c null.
+**/
+void JSONV_PUBLIC parse(tokenizer& input, encoder& handler, const parse_options& = parse_options());
+
+/** \see parse(tokenizer&, encoder&, const parse_options&) **/
+void JSONV_PUBLIC parse(std::istream& input, encoder& handler, const parse_options& = parse_options());
+
+/** \see parse(tokenizer&, encoder&, const parse_options&) **/
+void JSONV_PUBLIC parse(const string_view& input, encoder& handler, const parse_options& = parse_options());
+
+/** Like \c parse(const string_view&, encoder&, const parse_options&), but the text of each number is handed to
+ *  \c encoder::write_raw_json as it is instead of being converted and written back out (encoders which do not take it
+ *  get the converted number as usual). Strings are only decoded if they have escapes or non-ASCII characters in them,
+ *  so the \a handler re-escapes them only as much as its own options call for. This is the way to pretty-print or
+ *  re-encode a document without loss or the cost of converting numbers.
+ *  
+ *  \example "reformat(const string_view&, encoder&, const parse_options&)"
+ *  \code
+ *  std::ostringstream out;
+ *  jsonv::ostream_pretty_encoder pretty(out);
+ *  jsonv::reformat(input, pretty);
+ *  \endcode
+ *  
+ *  \throws parse_error if an error is found in the JSON.
+**/
+void JSONV_PUBLIC reformat(const string_view& input, encoder& handler, const parse_options& = parse_options());
+
+/** Append \a input to \a out with all of the whitespace and comments (if \c parse_options::comments allows them) taken
+ *  out. The text of every other token is copied exactly as it is, so nothing is decoded or converted: the document is
+ *  only checked the way \c is_valid does. The output is never longer than the input.
+ *  
+ *  \throws parse_error if \a input is not valid (see \c validate_syntax). Some of the output might already have been
+ *                      appended to \a out.
+**/
+void JSONV_PUBLIC minify(string_view input, std::string& out, const parse_options& = parse_options());
+
+
+/** A parser for many documents, one after another, with the same options. Parsing with one is the same as calling
+ *  \c parse(const string_view&, const parse_options&) with its \c options, except the \c parse_options are only copied
+ *  once and the scratch space used to track the nesting of a document is kept between calls instead of being allocated
+ *  for every document. This helps when parsing a stream of small documents (such as messages off of a queue), where
+ *  that setup is a noticeable part of the time spent parsing.
+ *  
+ *  A \c parser is not thread-safe -- use one per thread.
+ *  
+ *  \example "parser"
+ *  \code
+ *  jsonv::parser parser(jsonv::parse_options::create_strict());
+ *  while (queue.pop(message))
+ *      handle(parser.parse(message));
+ *  \endcode
+**/
+class JSONV_PUBLIC parser
+{
+public:
+    explicit parser(const parse_options& options = parse_options());
+    
+    parser(parser&&) noexcept;
+    parser& operator=(parser&&) noexcept;
+    
+    ~parser() noexcept;
+    
+    /** The options every document is parsed with. **/
+    const parse_options& options() const;
+    
+    /** Parse the document in \a input.
+     *  
+     *  \throws parse_error if an error is found in the JSON. The parser is still usable afterwards.
+    **/
+    value parse(const string_view& input);
+    
+    /** Parse the document in \a input into \a target, reusing the storage of the old \a target.
+     *  
+     *  \see parse_into(value&, const string_view&, const parse_options&)
+     *  
+     *  \throws parse_error if an error is found in the JSON. \a target is left \c null.
+    **/
+    void parse_into(value& target, const string_view& input);
+    
+private:
+    struct data;
+    
+private:
+    std::unique_ptr<data> _data;
+};
+
+
+/** A parser which is given its input in chunks as they become available, such as the non-contiguous buffers an event
+ *  loop hands out for the body of a request. Each chunk is tokenized as soon as it is fed and the result is built with
+ *  an explicit stack instead of recursion. The only input which is copied is a token which straddles two chunks.
+ *  
+ *  The \c parse_options it respects are \c failure_mode, \c max_failures, \c string_encoding, \c number_encoding,
+ *  \c comma_policy, \c max_structure_depth, \c require_document, \c complete_parse, \c comments, \c keys and
+ *  \c require_finite_numbers. The rest (\c select, \c validation_schema, \c stats, \c pack_numbers, \c parallelism
+ *  and the size and time budgets) are ignored, and strings are always copied, whatever the \c string_storage.
+ *  
+ *  Problems found with \c parse_options::on_error::fail_immediately are thrown from \c feed as soon as they are found;
+ *  otherwise, they are collected and thrown from \c finish.
+ *  
+ *  \example "incremental_parser"
+ *  \code
+ *  jsonv::incremental_parser parser;
+ *  while (!parser.feed(connection.read_some()))
+ *  { }
+ *  jsonv::value body = parser.finish();
+ *  \endcode
+**/
+class JSONV_PUBLIC incremental_parser
+{
+public:
+    /** Create a parser for a single document using the given \a options. **/
+    explicit incremental_parser(const parse_options& options = parse_options());
+    
+    incremental_parser(incremental_parser&&) noexcept;
+    incremental_parser& operator=(incremental_parser&&) noexcept;
+    
+    ~incremental_parser() noexcept;
+    
+    /** Tokenize and parse the next \a chunk of input. The contents of \a chunk are not referred to after this call.
+     *  
+     *  \returns \c true if the document is \c complete. Input after the end of the document is checked to only be
+     *           whitespace if \c parse_options::complete_parse is set and ignored if it is not.
+     *  \throws parse_error if a problem is found and the failure mode is \c parse_options::on_error::fail_immediately.
+    **/
+    bool feed(string_view chunk);
+    
+    /** Has a full document been seen? A document with a scalar at the root (such as \c 12) is not complete until the
+     *  input after it is seen or \c finish is called, since the next chunk might continue it (\c 123).
+    **/
+    bool complete() const;
+    
+    /** Signal the end of the input and get the parsed value. After this call, the parser is \c reset and can be used to
+     *  parse a new document.
+     *  
+     *  \throws parse_error if the input did not contain a complete document or if there were any problems (unless the
+     *                      failure mode is \c parse_options::on_error::ignore).
+    **/
+    value finish();
+    
+    /** Forget everything that has been fed so far and start parsing a new document with the same options. **/
+    void reset();
+    
+private:
+    struct data;
+    
+private:
+    std::unique_ptr<data> _data;
+};
+
 }
 
 #endif/*__JSONV_PARSE_HPP_INCLUDED__*/
@@ -0,0 +1,97 @@
+/** \file jsonv/parse_cache.hpp
+ *  A cache of parsed documents for input which is seen over and over.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_PARSE_CACHE_HPP_INCLUDED__
+#define __JSONV_PARSE_CACHE_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/string_view.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+#include <memory>
+
+namespace jsonv
+{
+
+/** Remembers the result of parsing input text, so parsing byte-for-byte the same text again (such as a configuration
+ *  payload which is sent thousands of times) gives back the earlier result instead of parsing it another time. Entries
+ *  are found by a hash of the full text and then compared byte-for-byte, so a hash collision never gives the wrong
+ *  result.
+ *
+ *  The cached values have been through \c value::make_shareable, so the \c value handed out from \c parse is a copy
+ *  which takes constant time and shares its storage with the cache; changing it does not change what the cache holds.
+ *  When the cache is holding more than \c max_bytes (the length of the text plus the \c memory_usage of its value for
+ *  every entry), the least-recently used entries are dropped. A document too large to fit is parsed, but not kept.
+ *
+ *  A cache is safe to use from multiple threads at once. Text which fails to parse is not remembered.
+ *
+ *  \example "parse_cache"
+ *  \code
+ *  static jsonv::parse_cache feature_flags(1024 * 1024);
+ *  jsonv::value flags = feature_flags.parse(request.body());
+ *  \endcode
+**/
+class JSONV_PUBLIC parse_cache
+{
+public:
+    using size_type = std::size_t;
+
+public:
+    /** Create an empty cache which holds up to \a max_bytes of entries and parses with \a options. The
+     *  \c parse_options::string_storage of \c parse_options::strings::borrow is treated as \c share, since a cached
+     *  value can not refer into text which belongs to the caller.
+    **/
+    explicit parse_cache(size_type max_bytes = 16 * 1024 * 1024, const parse_options& options = parse_options());
+
+    parse_cache(const parse_cache&) = delete;
+    parse_cache& operator=(const parse_cache&) = delete;
+
+    ~parse_cache() noexcept;
+
+    /** Get the parsed value of \a input, parsing it if it is not in the cache.
+     *
+     *  \throws parse_error if \a input is not in the cache and parsing it fails.
+    **/
+    value parse(string_view input);
+
+    /** Drop all of the entries. **/
+    void clear();
+
+    /** The number of documents in the cache. **/
+    size_type size() const;
+
+    /** The number of bytes the entries in the cache are counted as. **/
+    size_type bytes() const;
+
+    /** The number of bytes the cache holds before it starts dropping entries. **/
+    size_type max_bytes() const;
+
+    /** The number of calls to \c parse which were answered from the cache. **/
+    size_type hits() const;
+
+    /** The number of calls to \c parse which had to parse their input. **/
+    size_type misses() const;
+
+    /** The options documents are parsed with. **/
+    const parse_options& options() const;
+
+private:
+    struct impl;
+
+private:
+    std::unique_ptr<impl> _impl;
+};
+
+}
+
+#endif/*__JSONV_PARSE_CACHE_HPP_INCLUDED__*/
@@ -0,0 +1,165 @@
+/** \file jsonv/parse_lines.hpp
+ *  Parsing of newline-delimited JSON, where each line of the input is a separate document.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_PARSE_LINES_HPP_INCLUDED__
+#define __JSONV_PARSE_LINES_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/string_view.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace jsonv
+{
+
+/** A single pass over the documents of newline-delimited JSON input (also known as NDJSON or JSON Lines). Each line
+ *  is parsed as its own document when the range reaches it; lines which are empty or only contain whitespace are
+ *  skipped. Problems are reported with the line number and character offset of the full input.
+ *
+ *  \see parse_lines
+**/
+class JSONV_PUBLIC line_range
+{
+public:
+    class iterator;
+
+public:
+    /** Read documents from \a input, which must outlive this instance. **/
+    explicit line_range(std::istream& input, const parse_options& options = parse_options());
+
+    /** Read documents from \a input, which must outlive this instance. **/
+    explicit line_range(string_view input, const parse_options& options = parse_options());
+
+    line_range(line_range&&) noexcept;
+    line_range& operator=(line_range&&) noexcept;
+    ~line_range() noexcept;
+
+    /** Get an iterator to the current document, parsing the first one if it has not been already. Since the input is
+     *  only read once, every call of \c begin refers to the same position.
+     *
+     *  \throws parse_error if the line of the first document could not be parsed.
+    **/
+    iterator begin();
+    iterator end();
+
+    /** The (one-based) line number of the current document. **/
+    std::size_t line() const
+    {
+        return _line;
+    }
+
+private:
+    /** Parse the next non-blank line into \c _current.
+     *
+     *  \returns \c false (and sets \c _finished) if the end of the input has been reached.
+    **/
+    bool next();
+
+private:
+    std::istream* _stream;
+    string_view   _text;
+    std::size_t   _position;    //!< The offset of the next line in the input.
+    std::string   _buffer;      //!< When reading from \c _stream, the current line.
+    parse_options _options;
+    value         _current;
+    std::size_t   _line;
+    std::size_t   _next_line;
+    bool          _started;
+    bool          _finished;
+};
+
+/** Iterates over the documents of a \c line_range. Incrementing the iterator parses the next document, which can throw
+ *  \c parse_error.
+**/
+class JSONV_PUBLIC line_range::iterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = value;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const value*;
+    using reference         = const value&;
+
+public:
+    iterator() :
+            _owner(nullptr)
+    { }
+
+    reference operator*() const  { return _owner->_current; }
+    pointer   operator->() const { return &_owner->_current; }
+
+    iterator& operator++()
+    {
+        if (!_owner->next())
+            _owner = nullptr;
+        return *this;
+    }
+
+    bool operator==(const iterator& other) const { return _owner == other._owner; }
+    bool operator!=(const iterator& other) const { return _owner != other._owner; }
+
+private:
+    friend class line_range;
+
+    explicit iterator(line_range* owner) :
+            _owner(owner)
+    { }
+
+private:
+    line_range* _owner;
+};
+
+/** Parse each line of \a input as a separate JSON document.
+ *
+ *  \example "NDJSON"
+ *  \code
+ *  std::ifstream log("events.ndjson");
+ *  for (const jsonv::value& event : jsonv::parse_lines(log))
+ *      handle(event);
+ *  \endcode
+**/
+JSONV_PUBLIC line_range parse_lines(std::istream& input, const parse_options& options = parse_options());
+JSONV_PUBLIC line_range parse_lines(string_view input, const parse_options& options = parse_options());
+
+/** Parse each line of \a input as a separate JSON document with a pool of \a threads workers. The input is split into
+ *  chunks on line boundaries, which are handed out to the workers a batch at a time; \a on_document is called with
+ *  each document in the order they appear in the input, from the calling thread, as each batch completes. Since
+ *  documents are delivered as they are parsed, memory use does not depend on the size of the input. To process a
+ *  file, memory-map it and pass the mapping's contents as \a input.
+ *
+ *  \param threads The number of workers to use, including the calling thread. If this is 0, the number of hardware
+ *                 threads is used.
+ *
+ *  \throws parse_error for the first line (in input order) which could not be parsed. Every document before it will
+ *                      have been delivered to \a on_document.
+**/
+JSONV_PUBLIC void parse_lines_parallel(string_view                         input,
+                                       const std::function<void (value)>& on_document,
+                                       const parse_options&                options = parse_options(),
+                                       std::size_t                         threads = 0
+                                      );
+
+/** Like \c parse_lines_parallel with a callback, but collect every document into a vector, in input order. **/
+JSONV_PUBLIC std::vector<value> parse_lines_parallel(string_view          input,
+                                                     const parse_options& options = parse_options(),
+                                                     std::size_t          threads = 0
+                                                    );
+
+}
+
+#endif/*__JSONV_PARSE_LINES_HPP_INCLUDED__*/
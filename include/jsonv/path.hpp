@@ -115,6 +115,125 @@ JSONV_PUBLIC std::ostream& operator<<(std::ostream&, const path&);
 
 JSONV_PUBLIC std::string to_string(const path&);
 
+/** Like a \c path_element, but the key is borrowed instead of copied, so it is only valid as long as whatever holds the
+ *  key.
+**/
+class JSONV_PUBLIC path_element_view
+{
+public:
+    path_element_view(std::size_t idx) noexcept :
+            _kind(path_element_kind::array_index),
+            _index(idx)
+    { }
+    
+    path_element_view(string_view key) noexcept :
+            _kind(path_element_kind::object_key),
+            _index(0),
+            _key(key)
+    { }
+    
+    path_element_view(const path_element& elem);
+    
+    path_element_kind kind() const
+    {
+        return _kind;
+    }
+    
+    /** \throws kind_error if this is not an \c array_index. **/
+    std::size_t index() const;
+    
+    /** \throws kind_error if this is not an \c object_key. **/
+    string_view key() const;
+    
+    /** Copy this into a \c path_element which owns its key. **/
+    path_element to_element() const;
+    
+    bool operator==(const path_element_view&) const;
+    bool operator!=(const path_element_view&) const;
+    
+private:
+    path_element_kind _kind;
+    std::size_t       _index;
+    string_view       _key;
+};
+
+JSONV_PUBLIC std::ostream& operator<<(std::ostream&, const path_element_view&);
+
+JSONV_PUBLIC std::string to_string(const path_element_view&);
+
+/** A \c path which refers to elements held somewhere else instead of owning them. This is what \c traverse gives its
+ *  callback, so walking a tree does not need to allocate a \c path for every value in it. A \c path_view is only valid
+ *  until the callback returns; use \c to_path to keep it.
+**/
+class JSONV_PUBLIC path_view
+{
+public:
+    using value_type     = path_element_view;
+    using size_type      = std::size_t;
+    using const_iterator = const path_element_view*;
+    using iterator       = const_iterator;
+    
+public:
+    /** Creates an empty view. **/
+    path_view() noexcept :
+            _elements(nullptr),
+            _size(0)
+    { }
+    
+    /** Creates a view of the \a size elements starting at \a elements. **/
+    path_view(const path_element_view* elements, size_type size) noexcept :
+            _elements(elements),
+            _size(size)
+    { }
+    
+    size_type size() const
+    {
+        return _size;
+    }
+    
+    bool empty() const
+    {
+        return _size == 0;
+    }
+    
+    const_iterator begin() const
+    {
+        return _elements;
+    }
+    
+    const_iterator end() const
+    {
+        return _elements + _size;
+    }
+    
+    const path_element_view& operator[](size_type idx) const
+    {
+        return _elements[idx];
+    }
+    
+    const path_element_view& back() const
+    {
+        return _elements[_size - 1];
+    }
+    
+    /** Copy the elements into a \c path which owns them. **/
+    path to_path() const;
+    
+    /** Allows callbacks which take a <tt>const path&</tt> to be given a \c path_view (at the cost of copying it). **/
+    operator path() const;
+    
+    bool operator==(const path_view&) const;
+    bool operator!=(const path_view&) const;
+    
+private:
+    const path_element_view* _elements;
+    size_type                _size;
+};
+
+JSONV_PUBLIC std::ostream& operator<<(std::ostream&, const path_view&);
+
+JSONV_PUBLIC std::string to_string(const path_view&);
+
 }
 
 #endif/*__JSONV_PATH_HPP_INCLUDED__*/
@@ -0,0 +1,122 @@
+/** \file jsonv/query.hpp
+ *  Filters in a subset of the \c jq language, which can run directly on the tokens of a document too large to parse.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_QUERY_HPP_INCLUDED__
+#define __JSONV_QUERY_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/forward.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jsonv
+{
+
+class encoder;
+class tokenizer;
+
+namespace detail
+{
+
+struct query_node;
+
+}
+
+/** A compiled filter in a subset of the language of <a href="https://stedolan.github.io/jq/">jq</a>. Like \c jq, a
+ *  filter takes a value and produces zero or more values. The supported parts of the language are:
+ *
+ *   - Paths: \c ., \c .key, \c ."key", \c .[2], \c .[-1], \c .[] and chains of them like \c .rows[].name
+ *   - Combining filters: \c a | b, \c a, b and parentheses
+ *   - Construction: \c [f], <tt>{id, name: .full_name, "key": f, (f): g}</tt> and the literals \c null, \c true,
+ *     \c false, numbers and strings
+ *   - Arithmetic on numbers (\c + \c - \c * \c / \c %), \c + on strings, arrays and objects and \c - on arrays
+ *   - Comparison (\c == \c != \c < \c <= \c > \c >=, which order values as \c value::compare does) and \c and, \c or
+ *   - \c select(f), \c map(f), \c length, \c keys, \c not and \c empty
+ *
+ *  When run on a \c tokenizer, the leading path of the filter (the <tt>.rows[]</tt> of
+ *  <tt>.rows[] | select(.x > 1)</tt>) is followed on the tokens themselves: everything it does not lead to is skipped
+ *  without being parsed and only the values it leads to are parsed, one at a time, and handed to the rest of the
+ *  filter. So filtering the records of a multi-gigabyte export only ever holds one record in memory.
+ *
+ *  \example "query"
+ *  \code
+ *  std::ifstream          file("export.json");
+ *  jsonv::tokenizer       tokens(file);
+ *  jsonv::ostream_encoder out(std::cout);
+ *  jsonv::query::compile(".rows[] | select(.status == \"failed\") | {id, error}").run(tokens, out);
+ *  \endcode
+**/
+class JSONV_PUBLIC query
+{
+public:
+    using size_type = std::size_t;
+
+    /** Called with every result of a filter, in order. **/
+    using result_handler = std::function<void (const value&)>;
+
+public:
+    /** Compile \a program into a filter.
+     *
+     *  \throws std::invalid_argument if \a program is not valid or uses something outside of the supported subset.
+    **/
+    static query compile(string_view program);
+
+    /** The text the filter was compiled from. **/
+    const std::string& program() const;
+
+    /** The number of steps of the leading path which are followed on the tokens when running on a \c tokenizer. If this
+     *  is \c 0, every document is parsed in full before it is filtered.
+    **/
+    size_type streamed_steps() const;
+
+    /** Run the filter on \a input.
+     *
+     *  \throws kind_error if the filter is used on a value of the wrong kind (such as <tt>.key</tt> on an array).
+    **/
+    std::vector<value> run(const value& input) const;
+
+    /** Run the filter on \a input, calling \a on_result with each result. **/
+    void run(const value& input, const result_handler& on_result) const;
+
+    /** Run the filter on every document in \a input (any number of them, separated by whitespace, as \c jq reads them),
+     *  calling \a on_result with each result.
+     *
+     *  \returns The number of results.
+     *  \throws parse_error if the input is not valid JSON.
+     *  \throws kind_error if the filter is used on a value of the wrong kind.
+    **/
+    size_type run(tokenizer& input, const result_handler& on_result) const;
+
+    /** Run the filter on every document in \a input like \c run(tokenizer&, const result_handler&) does, writing the
+     *  results as the elements of a single array to \a out. Each result is written as soon as it is found.
+     *
+     *  \returns The number of results.
+    **/
+    size_type run(tokenizer& input, encoder& out) const;
+
+private:
+    query() = default;
+
+private:
+    std::shared_ptr<const detail::query_node> _root;         //!< The whole filter.
+    std::shared_ptr<const detail::query_node> _rest;         //!< What is left of the filter after the streamed steps.
+    std::vector<const detail::query_node*>    _stream_steps; //!< The leading path steps, outermost first (in _root).
+    std::string                               _program;
+};
+
+}
+
+#endif/*__JSONV_QUERY_HPP_INCLUDED__*/
@@ -0,0 +1,131 @@
+/** \file jsonv/schema.hpp
+ *  A light schema for checking the shape of a \c value -- the kinds of values, the keys of objects and the ranges of
+ *  numbers and sizes -- either after the fact or while it is parsed.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_SCHEMA_HPP_INCLUDED__
+#define __JSONV_SCHEMA_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/algorithm.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace jsonv
+{
+
+/** The rules for a \c value and (for objects and arrays) the values inside of it. A default-constructed \c schema
+ *  accepts anything; each rule narrows what is accepted.
+ *
+ *  \code
+ *  jsonv::schema item = jsonv::schema()
+ *                       .kinds({ jsonv::kind::object })
+ *                       .required("sku",   jsonv::schema().kinds({ jsonv::kind::string }).min_size(1))
+ *                       .required("price", jsonv::schema().kinds({ jsonv::kind::decimal }).minimum(0))
+ *                       .member("tags",    jsonv::schema().kinds({ jsonv::kind::array })
+ *                                                         .elements(jsonv::schema().kinds({ jsonv::kind::string }))
+ *                              );
+ *  item.validate(x);
+ *  \endcode
+ *
+ *  This is far from JSON Schema -- it is meant for checking the structure a program expects. To check a document while
+ *  it is being parsed (instead of walking it again afterwards), see \c parse_options::validation_schema.
+**/
+class JSONV_PUBLIC schema
+{
+public:
+    using size_type = value::size_type;
+
+public:
+    /** Create a schema which accepts any \c value. **/
+    schema();
+
+    ~schema() noexcept;
+
+    /** Only accept values with one of the \a allowed kinds. Allowing \c kind::decimal also allows \c kind::integer,
+     *  since JSON does not tell the difference between \c 1 and \c 1.0.
+    **/
+    schema& kinds(std::initializer_list<kind> allowed);
+
+    /** Does this schema accept values with the kind \a x? **/
+    bool allows(kind x) const;
+
+    /** Only accept numbers which are at least \a x. Values which are not numbers are not affected. **/
+    schema& minimum(double x);
+
+    /** Only accept numbers which are at most \a x. Values which are not numbers are not affected. **/
+    schema& maximum(double x);
+
+    /** Only accept strings (counting bytes), arrays and objects with a size of at least \a x. **/
+    schema& min_size(size_type x);
+
+    /** Only accept strings (counting bytes), arrays and objects with a size of at most \a x. **/
+    schema& max_size(size_type x);
+
+    /** Objects must have the \a key and its value must match \a rules. **/
+    schema& required(std::string key, schema rules = schema());
+
+    /** If objects have the \a key, its value must match \a rules. **/
+    schema& member(std::string key, schema rules);
+
+    /** Should objects be allowed to have keys which are not \c required or a \c member? This is allowed by default. **/
+    schema& additional_keys(bool allow);
+
+    /** Every element of arrays must match \a rules. **/
+    schema& elements(schema rules);
+
+    /** Get the rules for the value with \a key in an object.
+     *
+     *  \returns The rules given to \c required or \c member or \c nullptr if the value is not restricted.
+    **/
+    const schema* find_member(const std::string& key) const;
+
+    /** Get the rules for the elements of an array (or \c nullptr if they are not restricted). **/
+    const schema* element_rules() const;
+
+    /** Check \a x against the rules of this schema, but not the values inside of it (which is what \c find_member and
+     *  \c element_rules are for).
+     *
+     *  \returns \c true if \a x is acceptable. If it is not, \a failure is set to the reason.
+    **/
+    bool check(const value& x, validation_error::code& failure) const;
+
+    /** Check \a x and everything inside of it against this schema.
+     *
+     *  \throws validation_error with the path of the first value which does not match.
+    **/
+    void validate(const value& x) const;
+
+private:
+    struct member_rules
+    {
+        std::shared_ptr<const schema> rules;
+        bool                          required;
+    };
+
+private:
+    std::uint8_t                         _kinds;
+    double                               _minimum;
+    double                               _maximum;
+    size_type                            _min_size;
+    size_type                            _max_size;
+    std::map<std::string, member_rules>  _members;
+    bool                                 _additional_keys;
+    std::shared_ptr<const schema>        _elements;
+};
+
+}
+
+#endif/*__JSONV_SCHEMA_HPP_INCLUDED__*/
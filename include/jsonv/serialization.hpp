@@ -15,9 +15,12 @@
 #include <jsonv/config.hpp>
 #include <jsonv/detail/nested_exception.hpp>
 #include <jsonv/detail/scope_exit.hpp>
+#include <jsonv/detail/token_stream.hpp>
+#include <jsonv/expected.hpp>
 #include <jsonv/path.hpp>
 #include <jsonv/value.hpp>
 
+#include <functional>
 #include <memory>
 #include <new>
 #include <typeinfo>
@@ -34,8 +37,11 @@ namespace jsonv
  *  Serialization components are responsible for conversion between a C++ type and a JSON \c value.
 **/
 
+class encoder;
 class extractor;
+class tokenizer;
 class value;
+class writer;
 class extraction_context;
 class serialization_context;
 
@@ -151,6 +157,9 @@ public:
     /** Create a new \c extraction_error from the given \a context and \a message. **/
     explicit extraction_error(const extraction_context& context, const std::string& message);
     
+    /** Create a new \c extraction_error for something which went wrong at \a where. **/
+    explicit extraction_error(jsonv::path where, const std::string& message);
+    
     virtual ~extraction_error() noexcept;
     
     /** Get the path this extraction error came from. **/
@@ -182,6 +191,32 @@ private:
     std::string     _type_name;
 };
 
+/** Why \c try_extract failed. The code is for the innermost failure (the one the nested exceptions of the
+ *  \c extraction_error lead to).
+**/
+enum class extract_errc : unsigned char
+{
+    none,
+    no_extractor,       //!< The \c formats have no \c extractor for a type (\c no_extractor).
+    kind_mismatch,      //!< A value had the wrong kind for its type (\c kind_error).
+    out_of_range,       //!< A member or element which was needed is not there (\c std::out_of_range).
+    invalid,            //!< An extractor rejected a value (an \c extraction_error or any other exception).
+};
+
+/** Get the name of \a code. **/
+JSONV_PUBLIC std::ostream& operator<<(std::ostream& os, const extract_errc& code);
+
+/** Why \c try_extract failed. **/
+struct JSONV_PUBLIC extract_failure
+{
+    extract_errc code = extract_errc::none;
+    
+    /** The \c extraction_error which \c extract throws, with the path of the failure (only with
+     *  \c failure_details::full).
+    **/
+    std::shared_ptr<const extraction_error> details;
+};
+
 /** Thrown when \c formats::to_json does not have a \c serializer for the provided type. **/
 class JSONV_PUBLIC no_serializer :
         public std::runtime_error
@@ -229,6 +264,31 @@ public:
                          const value&              from,
                          void*                     into
                         ) const = 0;
+    
+    /** Extract the type from \a from, which the caller has no more use for. Implementations are free to move strings,
+     *  arrays and objects out of \a from instead of copying them; whatever is left in it is destroyed by the caller.
+     *  
+     *  The default implementation calls the \c const version of \c extract.
+    **/
+    virtual void extract(const extraction_context& context,
+                         value&&                   from,
+                         void*                     into
+                        ) const;
+    
+    /** Extract the type from the value which starts at the current token of \a from, without building a \c value for
+     *  it first. When this returns, the last token of the value must be current.
+     *  
+     *  The default implementation parses the value and calls the \c value version of \c extract.
+     *  
+     *  \param context The same as in the \c value version of \c extract.
+     *  \param from The input to extract from. The functions in \c jsonv/detail/token_stream.hpp help with walking
+     *              the structure of the value.
+     *  \param into The same as in the \c value version of \c extract.
+    **/
+    virtual void extract(const extraction_context& context,
+                         tokenizer&                from,
+                         void*                     into
+                        ) const;
 };
 
 /** A \c serializer holds the method for converting an arbitrary C++ type into a \c value. **/
@@ -254,6 +314,20 @@ public:
     virtual value to_json(const serialization_context& context,
                           const void*                  from
                          ) const = 0;
+    
+    /** Write the JSON for the value in the given region of memory straight to \a out. For a type with many fields, this
+     *  can be quite a bit faster than encoding the result of \c to_json, since it does not build a \c value.
+     *  
+     *  The default implementation encodes the result of \c to_json.
+     *  
+     *  \param context The same as in \c to_json.
+     *  \param from The same as in \c to_json.
+     *  \param out The encoder to write the value to. Exactly one value must be written.
+    **/
+    virtual void encode(const serialization_context& context,
+                        const void*                  from,
+                        encoder&                     out
+                       ) const;
 };
 
 /** An \c adapter is both an \c extractor and a \c serializer. It is made with the idea that for \e most types, you want
@@ -340,10 +414,16 @@ public:
      *  \note
      *  This function actually returns a \e copy of the global \c formats, so modifications do not affect the actual
      *  instance. If you wish to alter the global formats, use \c set_global.
+     *  
+     *  \note
+     *  Contexts made with their default constructor do not call this. They refer to the global instance directly, which
+     *  costs nothing more than reading a pointer, so they can be made on many threads at once without contention.
     **/
     static formats global();
     
-    /** Set the \c global \c formats instance.
+    /** Set the \c global \c formats instance. This is safe to call while other threads are extracting or encoding with
+     *  the global formats. Every instance which has been made global is kept alive until the program exits, since
+     *  contexts on other threads might still be using it.
      *
      *  \returns the previous value of the global formats instance.
     **/
@@ -399,6 +479,29 @@ public:
                  const extraction_context& context
                 ) const;
     
+    /** Extract the provided \a type from the value at the current token of \a from into an area of memory. Like the
+     *  \c value version, prefer \c extraction_context::extract or the free function \c jsonv::extract.
+     *  
+     *  \throws no_extractor if an \c extractor for \a type could not be found.
+     *  \see extractor::extract
+    **/
+    /** Extract the provided \a type from \a from, which can have its contents moved out of it.
+     *  
+     *  \throws no_extractor if an \c extractor for \a type could not be found.
+     *  \see extractor::extract
+    **/
+    void extract(const std::type_info&     type,
+                 value&&                   from,
+                 void*                     into,
+                 const extraction_context& context
+                ) const;
+    
+    void extract(const std::type_info&     type,
+                 tokenizer&                from,
+                 void*                     into,
+                 const extraction_context& context
+                ) const;
+    
     /** Get the \c extractor for the given \a type.
      *  
      *  \throws no_extractor if an \c extractor for \a type could not be found.
@@ -422,6 +525,18 @@ public:
                   const serialization_context& context
                  ) const;
     
+    /** Encode the provided value \a from straight to \a out, without building a \c value. Like \c to_json, prefer
+     *  \c serialization_context::encode or the free function \c jsonv::encode.
+     *  
+     *  \throws no_serializer if a \c serializer for \a type could not be found.
+     *  \see serializer::encode
+    **/
+    void encode(const std::type_info&        type,
+                const void*                  from,
+                const serialization_context& context,
+                encoder&                     out
+               ) const;
+    
     /** Gets the \c serializer for the given \a type.
      *  
      *  \throws no_serializer if a \c serializer for \a type could not be found.
@@ -490,11 +605,18 @@ public:
     bool operator!=(const formats& other) const;
     
 private:
+    friend class context_base;
+    
     struct data;
     
+    /** Tag for creating an instance without any \c data, which can not be used for anything. **/
+    struct empty_tag { };
+    
 private:
     explicit formats(std::vector<std::shared_ptr<const data>> bases);
     
+    explicit formats(empty_tag) noexcept;
+    
 private:
     std::shared_ptr<data> _data;
 };
@@ -503,7 +625,9 @@ private:
 class JSONV_PUBLIC context_base
 {
 public:
-    /** Create a new instance using the default \c formats (\c formats::global). **/
+    /** Create a new instance using the default \c formats (\c formats::global). The instance refers to the global
+     *  \c formats without copying it.
+    **/
     context_base();
     
     /** Create a new instance using the given \a fmt, \a ver and \a p. **/
@@ -512,12 +636,24 @@ public:
                           const void*           userdata = nullptr
                          );
     
+    /** Create a new instance which uses \a fmt without copying it, so no reference count is touched. The \c formats
+     *  must outlive this instance (and any copy of it).
+    **/
+    explicit context_base(std::reference_wrapper<const jsonv::formats> fmt,
+                          const jsonv::version&                        ver      = jsonv::version(1),
+                          const void*                                  userdata = nullptr
+                         );
+    
+    context_base(const context_base& src);
+    
+    context_base& operator=(const context_base& src);
+    
     virtual ~context_base() noexcept = 0;
     
     /** Get the \c formats object backing extraction and encoding. **/
     const jsonv::formats& formats() const
     {
-        return _formats;
+        return *_formats_ref;
     }
     
     /** Get the version this \c extraction_context was created with. **/
@@ -533,9 +669,10 @@ public:
     }
     
 private:
-    jsonv::formats _formats;
-    jsonv::version _version;
-    const void*    _user_data;
+    jsonv::formats        _formats;     //!< The formats this instance owns (empty when it refers to another)
+    const jsonv::formats* _formats_ref; //!< The formats this instance uses (either \c _formats or borrowed)
+    jsonv::version        _version;
+    const void*           _user_data;
 };
 
 class JSONV_PUBLIC extraction_context :
@@ -552,14 +689,46 @@ public:
                                 const void*           userdata = nullptr
                                );
     
+    /** Create a new instance which uses \a fmt without copying it (see \c context_base). **/
+    explicit extraction_context(std::reference_wrapper<const jsonv::formats> fmt,
+                                const jsonv::version&                        ver      = jsonv::version(),
+                                jsonv::path                                  p        = jsonv::path(),
+                                const void*                                  userdata = nullptr
+                               );
+    
+    /** Copy \a src. The copy does not refer to the context \a src was created from, so it can outlive it. **/
+    extraction_context(const extraction_context& src);
+    
+    extraction_context& operator=(const extraction_context& src);
+    
     virtual ~extraction_context() noexcept;
     
     /** Get the current \c path this \c extraction_context is extracting for. This is useful when debugging and
      *  generating error messages.
+     *  
+     *  \note
+     *  The contexts for the elements of a value only refer to the context of their parent and the path is put together
+     *  on each call (so that nothing is allocated for it unless something goes wrong).
+    **/
+    jsonv::path path() const;
+    
+    /** The number of threads \c extract_elements can split the elements of a large array among. By default, this is 1.
+     *  If it is 0, the number of hardware threads is used. Element contexts (from \c extract_sub and friends) inherit
+     *  it from the context they were made from, except in \c extract_elements itself when it uses more than one thread.
+     *  
+     *  \note
+     *  The extractors for the elements are called concurrently, so they must not change anything shared without
+     *  synchronization. All of the extractors in this library (and the ones made with \c formats_builder) are safe.
     **/
-    const jsonv::path& path() const
+    std::size_t parallelism() const
+    {
+        return _parallelism;
+    }
+    
+    extraction_context& parallelism(std::size_t threads)
     {
-        return _path;
+        _parallelism = threads;
+        return *this;
     }
     
     /** Attempt to extract a \c T from \a from using the \c formats associated with this context.
@@ -583,6 +752,50 @@ public:
                  void*                     into
                 ) const;
     
+    /** Attempt to extract a \c T from \a from using the \c formats associated with this context. Where the extractor
+     *  supports it, strings and containers are moved out of \a from instead of being copied.
+     *  
+     *  \tparam T is the type to extract from \a from. It must be movable.
+     *  
+     *  \throws extraction_error if anything goes wrong when attempting to extract a value.
+    **/
+    template <typename T>
+    T extract(value&& from) const
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type place[1];
+        T* ptr = reinterpret_cast<T*>(place);
+        extract(typeid(T), std::move(from), static_cast<void*>(ptr));
+        auto destroy = detail::on_scope_exit([ptr] { ptr->~T(); });
+        return std::move(*ptr);
+    }
+    
+    void extract(const std::type_info& type,
+                 value&&               from,
+                 void*                 into
+                ) const;
+    
+    /** Attempt to extract a \c T from the value at the current token of \a from using the \c formats associated with
+     *  this context. When this returns, the last token of the value is current.
+     *  
+     *  \tparam T is the type to extract from \a from. It must be movable.
+     *  
+     *  \throws extraction_error if anything goes wrong when attempting to extract a value.
+    **/
+    template <typename T>
+    T extract(tokenizer& from) const
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type place[1];
+        T* ptr = reinterpret_cast<T*>(place);
+        extract(typeid(T), from, static_cast<void*>(ptr));
+        auto destroy = detail::on_scope_exit([ptr] { ptr->~T(); });
+        return std::move(*ptr);
+    }
+    
+    void extract(const std::type_info& type,
+                 tokenizer&            from,
+                 void*                 into
+                ) const;
+    
     /** Attempt to extract a \c T from <tt>from.at_path(subpath)</tt> using the \c formats associated with this context.
      *  
      *  \tparam T is the type to extract from \a from. It must be movable.
@@ -610,18 +823,200 @@ public:
     template <typename T>
     T extract_sub(const value& from, path_element elem) const
     {
-        return extract_sub<T>(from, jsonv::path({ elem }));
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type place[1];
+        T* ptr = reinterpret_cast<T*>(place);
+        extract_sub(typeid(T), from, std::move(elem), static_cast<void*>(ptr));
+        auto destroy = detail::on_scope_exit([ptr] { ptr->~T(); });
+        return std::move(*ptr);
+    }
+    
+    void extract_sub(const std::type_info& type, const value& from, path_element elem, void* into) const;
+    
+    /** Attempt to extract a \c T from the element \a elem of \a from, moving the contents out of that element. Only
+     *  that element is changed, so this can be called for each element of the same value.
+     *  
+     *  \tparam T is the type to extract from \a from. It must be movable.
+     *  
+     *  \throws extraction_error if anything goes wrong when attempting to extract a value.
+    **/
+    template <typename T>
+    T extract_sub(value&& from, path_element elem) const
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type place[1];
+        T* ptr = reinterpret_cast<T*>(place);
+        extract_sub(typeid(T), std::move(from), std::move(elem), static_cast<void*>(ptr));
+        auto destroy = detail::on_scope_exit([ptr] { ptr->~T(); });
+        return std::move(*ptr);
+    }
+    
+    void extract_sub(const std::type_info& type, value&& from, path_element elem, void* into) const;
+    
+    /** Attempt to extract a \c T from \a element, which is the element \a elem of the value being extracted. This is
+     *  \c extract_sub for when \a element has already been looked up.
+     *  
+     *  \tparam T is the type to extract from \a element. It must be movable.
+     *  
+     *  \throws extraction_error if anything goes wrong when attempting to extract a value.
+    **/
+    template <typename T>
+    T extract_element(const value& element, path_element elem) const
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type place[1];
+        T* ptr = reinterpret_cast<T*>(place);
+        extract_element(typeid(T), element, std::move(elem), static_cast<void*>(ptr));
+        auto destroy = detail::on_scope_exit([ptr] { ptr->~T(); });
+        return std::move(*ptr);
+    }
+    
+    void extract_element(const std::type_info& type, const value& element, path_element elem, void* into) const;
+    
+    /** Like the \c const version of \c extract_element, but the contents of \a element can be moved out of it. **/
+    template <typename T>
+    T extract_element(value&& element, path_element elem) const
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type place[1];
+        T* ptr = reinterpret_cast<T*>(place);
+        extract_element(typeid(T), std::move(element), std::move(elem), static_cast<void*>(ptr));
+        auto destroy = detail::on_scope_exit([ptr] { ptr->~T(); });
+        return std::move(*ptr);
+    }
+    
+    void extract_element(const std::type_info& type, value&& element, path_element elem, void* into) const;
+    
+    /** Attempt to extract a \c T from the value at the current token of \a from, which is the element \a elem of the
+     *  value being extracted. This is like \c extract, except error messages will include \a elem in the path.
+     *  
+     *  \tparam T is the type to extract from \a from. It must be movable.
+     *  
+     *  \throws extraction_error if anything goes wrong when attempting to extract a value.
+    **/
+    template <typename T>
+    T extract_sub(tokenizer& from, path_element elem) const
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type place[1];
+        T* ptr = reinterpret_cast<T*>(place);
+        extract_sub(typeid(T), from, std::move(elem), static_cast<void*>(ptr));
+        auto destroy = detail::on_scope_exit([ptr] { ptr->~T(); });
+        return std::move(*ptr);
     }
     
+    void extract_sub(const std::type_info& type, tokenizer& from, path_element elem, void* into) const;
+    
+    /** Extract every element of the array \a from as a \c T and call \a insert with each of them (as a \c T&&), in
+     *  order. When \c parallelism allows it and the array is large enough to be worth it, the elements are extracted on
+     *  several threads; \a insert is always called on the calling thread, once every element has been extracted.
+     *  
+     *  \tparam TValue is \c const \c value& or \c value -- for an rvalue \a from, the contents of the elements are
+     *                 moved out of it like in \c extract_sub.
+     *  
+     *  \throws extraction_error if anything goes wrong when extracting any element. If more than one element fails,
+     *   the error is for the first of them (exactly as if they were extracted in order), and \a insert is not called.
+    **/
+    template <typename T, typename TValue, typename FInsert>
+    void extract_elements(TValue&& from, FInsert&& insert) const
+    {
+        using storage_type = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+        
+        std::size_t                     count = from.size();
+        std::unique_ptr<storage_type[]> place(new storage_type[count]);
+        T*                              elements = reinterpret_cast<T*>(place.get());
+        extract_elements(typeid(T),
+                         std::forward<TValue>(from),
+                         static_cast<void*>(elements),
+                         sizeof(T),
+                         [] (void* p) { static_cast<T*>(p)->~T(); }
+                        );
+        
+        std::size_t idx = 0U;
+        auto destroy = detail::on_scope_exit([&]
+                                             {
+                                                 for (; idx < count; ++idx)
+                                                     elements[idx].~T();
+                                             }
+                                            );
+        for (; idx < count; ++idx)
+        {
+            insert(std::move(elements[idx]));
+            elements[idx].~T();
+        }
+    }
+    
+    /** Extract every element of the array \a from into the array of \a size byte objects at \a into. If this throws,
+     *  nothing is left in \a into (every element which was extracted is destroyed with \a destroy).
+    **/
+    void extract_elements(const std::type_info& type,
+                          const value&          from,
+                          void*                 into,
+                          std::size_t           size,
+                          void                  (*destroy)(void*)
+                         ) const;
+    
+    void extract_elements(const std::type_info& type,
+                          value&&               from,
+                          void*                 into,
+                          std::size_t           size,
+                          void                  (*destroy)(void*)
+                         ) const;
+    
+    /** Like \c extract, but a failure is returned instead of thrown. With \a details of \c failure_details::code, the
+     *  \c extraction_error thrown on the way out of the extractors does not format its message or work out its path,
+     *  which is most of what a failed \c extract costs (the exceptions thrown by the extractors themselves are still
+     *  thrown and caught).
+     *  
+     *  \tparam T is the type to extract from \a from. It must be movable.
+    **/
+    template <typename T>
+    expected<T, extract_failure> try_extract(const value& from, failure_details details = failure_details::code)
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type place[1];
+        T* ptr = reinterpret_cast<T*>(place);
+        extract_failure failure = try_extract(typeid(T), from, static_cast<void*>(ptr), details);
+        if (failure.code != extract_errc::none)
+            return failure;
+        auto destroy = detail::on_scope_exit([ptr] { ptr->~T(); });
+        return std::move(*ptr);
+    }
+    
+    /** Extract a \a type from \a from into \a into. If this fails, nothing is left in \a into.
+     *  
+     *  \returns An \c extract_failure with a \c code of \c extract_errc::none on success.
+    **/
+    extract_failure try_extract(const std::type_info& type, const value& from, void* into, failure_details details);
+    
+    /** Is this the context (or an element context from the context) of a \c try_extract which only wants the code of a
+     *  failure? An \c extraction_error made for such a context skips formatting its message, since nothing will see it.
+    **/
+    bool quiet() const
+    {
+        return _quiet;
+    }
+    
+    /** If this context is for a \c try_extract, record \a code as the reason it failed (unless a reason has already
+     *  been recorded). Extractors do not need to call this, since the exceptions they throw are classified for them.
+    **/
+    void record_failure(extract_errc code) const;
+    
 private:
-    jsonv::path _path;
+    /** Create the context for extracting the element of the value \a parent is extracting at \a subpath or \a elem
+     *  (exactly one of them is set). Both must outlive this instance.
+    **/
+    extraction_context(const extraction_context& parent, const jsonv::path* subpath, const path_element* elem);
+    
+private:
+    jsonv::path               _path;    //!< The path of a context with no parent.
+    const extraction_context* _parent;
+    const jsonv::path*        _subpath;
+    const path_element*       _elem;
+    std::size_t               _parallelism;
+    extract_failure*          _failure; //!< Where \c try_extract wants the reason for a failure (or \c nullptr).
+    bool                      _quiet;
 };
 
 /** Extract a C++ value from \a from using the provided \a fmts. **/
 template <typename T>
 T extract(const value& from, const formats& fmts)
 {
-    extraction_context context(fmts);
+    extraction_context context(std::cref(fmts));
     return context.extract<T>(from);
 }
 
@@ -633,6 +1028,79 @@ T extract(const value& from)
     return context.extract<T>(from);
 }
 
+/** Extract a C++ value from \a from using the provided \a fmts. Since \a from is not needed afterwards, extractors which
+ *  support it (such as the defaults for strings and the adapters for containers) move their contents out of it instead
+ *  of copying them.
+**/
+template <typename T>
+T extract(value&& from, const formats& fmts)
+{
+    extraction_context context(std::cref(fmts));
+    return context.extract<T>(std::move(from));
+}
+
+/** Extract a C++ value from \a from using the provided \a fmts, returning a failure instead of throwing it.
+ *  
+ *  \example
+ *  \code
+ *  auto order = jsonv::try_extract<order_request>(body, order_formats);
+ *  if (!order)
+ *      return reject(400, order.error().code);
+ *  submit(*order);
+ *  \endcode
+ *  
+ *  \see extraction_context::try_extract
+**/
+template <typename T>
+expected<T, extract_failure> try_extract(const value&    from,
+                                         const formats&  fmts,
+                                         failure_details details = failure_details::code
+                                        )
+{
+    extraction_context context(std::cref(fmts));
+    return context.try_extract<T>(from, details);
+}
+
+/** Extract a C++ value from \a from using \c jsonv::formats::global(), returning a failure instead of throwing it. **/
+template <typename T>
+expected<T, extract_failure> try_extract(const value& from, failure_details details = failure_details::code)
+{
+    extraction_context context;
+    return context.try_extract<T>(from, details);
+}
+
+/** Extract a C++ value from \a from using \c jsonv::formats::global(), moving contents out of it where possible. **/
+template <typename T>
+T extract(value&& from)
+{
+    extraction_context context;
+    return context.extract<T>(std::move(from));
+}
+
+/** Extract a C++ value from the next value in \a from using the provided \a fmts. Extractors which support it (such as
+ *  the ones made by \c formats_builder and for containers) read their fields straight from the tokens, so a \c value
+ *  is never built for the whole input. When this returns, the last token of the value is current, so another call will
+ *  extract the value after it.
+ *  
+ *  \throws extraction_error if anything goes wrong when attempting to extract a value (including problems with the
+ *   JSON in it).
+ *  \throws parse_error if \a from has no more values.
+**/
+template <typename T>
+T extract(tokenizer& from, const formats& fmts)
+{
+    extraction_context context(std::cref(fmts));
+    return context.extract<T>(detail::next_token(from));
+}
+
+/** Extract a C++ value from the next value in \a from using \c jsonv::formats::global(). **/
+template <typename T>
+T extract(tokenizer& from)
+{
+    extraction_context context;
+    return context.extract<T>(detail::next_token(from));
+}
+
 class JSONV_PUBLIC serialization_context :
         public context_base
 {
@@ -646,6 +1114,12 @@ public:
                                    const void*           userdata = nullptr
                                   );
     
+    /** Create a new instance which uses \a fmt without copying it (see \c context_base). **/
+    explicit serialization_context(std::reference_wrapper<const jsonv::formats> fmt,
+                                   const jsonv::version&                        ver      = jsonv::version(),
+                                   const void*                                  userdata = nullptr
+                                  );
+    
     virtual ~serialization_context() noexcept;
     
     /** Convenience function for converting a C++ object into a JSON value.
@@ -663,13 +1137,41 @@ public:
      *  \see formats::to_json
     **/
     value to_json(const std::type_info& type, const void* from) const;
+    
+    /** Convenience function for writing a C++ object straight to an encoder.
+     *  
+     *  \see formats::encode
+    **/
+    template <typename T>
+    void encode(const T& from, encoder& out) const
+    {
+        encode(typeid(T), static_cast<const void*>(&from), out);
+    }
+    
+    /** Dynamically write a type straight to an encoder.
+     *  
+     *  \see formats::encode
+    **/
+    void encode(const std::type_info& type, const void* from, encoder& out) const;
+    
+    /** Write a C++ object as the next value of \a out. This is meant for implementations of \c serializer::encode with
+     *  members or elements of their own.
+    **/
+    template <typename T>
+    void encode(const T& from, writer& out) const
+    {
+        encode(typeid(T), static_cast<const void*>(&from), out);
+    }
+    
+    /** Dynamically write a type as the next value of \a out. **/
+    void encode(const std::type_info& type, const void* from, writer& out) const;
 };
 
 /** Encode a JSON \c value from \a from using the provided \a fmts. **/
 template <typename T>
 value to_json(const T& from, const formats& fmts)
 {
-    serialization_context context(fmts);
+    serialization_context context(std::cref(fmts));
     return context.to_json(from);
 }
 
@@ -681,6 +1183,24 @@ value to_json(const T& from)
     return context.to_json(from);
 }
 
+/** Write the JSON for \a from straight to \a out using the provided \a fmts. The output is the same value as encoding
+ *  \c to_json(from, fmts), but is produced without building it first.
+**/
+template <typename T>
+void encode(const T& from, encoder& out, const formats& fmts)
+{
+    serialization_context context(std::cref(fmts));
+    context.encode(from, out);
+}
+
+/** Write the JSON for \a from straight to \a out using \c jsonv::formats::global(). **/
+template <typename T>
+void encode(const T& from, encoder& out)
+{
+    serialization_context context;
+    context.encode(from, out);
+}
+
 /** \} **/
 
 }
@@ -16,6 +16,8 @@
 #include <jsonv/serialization.hpp>
 #include <jsonv/serialization_util.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <deque>
 #include <map>
 #include <memory>
@@ -681,11 +683,42 @@ public:
     virtual ~member_adapter() noexcept
     { }
 
-    virtual void mutate(const extraction_context& context, const value& from, T& out) const = 0;
+    /** The names this member is extracted from, most preferred first. **/
+    virtual const std::vector<std::string>& extract_names() const = 0;
+
+    /** Set this member from \a entry, which is the value for \a key in the object \a from. **/
+    virtual void mutate(const extraction_context& context,
+                        const value&              from,
+                        const std::string&        key,
+                        const value&              entry,
+                        T&                        out
+                       ) const = 0;
+
+    /** Set this member from \a entry, the value for \a key, moving the contents out of it. This is only used when
+     *  \c can_stream is \c true, since the object \a entry came from is not available.
+    **/
+    virtual void mutate(const extraction_context& context, const std::string& key, value&& entry, T& out) const = 0;
+
+    /** Set this member from the current value of \a from, which is the value for \a key in the object being extracted.
+    **/
+    virtual void mutate(const extraction_context& context, tokenizer& from, string_view key, T& out) const = 0;
+
+    /** Set this member when none of its names are in the object \a from (which is \c null when extracting from a
+     *  \c tokenizer).
+     *
+     *  \throws extraction_error if this member is required.
+    **/
+    virtual void mutate_missing(const extraction_context& context, const value& from, T& out) const = 0;
 
     virtual void to_json(const serialization_context& context, const T& from, value& out) const = 0;
 
-    virtual bool has_extract_key(string_view key) const = 0;
+    /** Write the key and value for this member to \a out (if it should be encoded). **/
+    virtual void encode(const serialization_context& context, const T& from, writer& out) const = 0;
+
+    /** Can this member be extracted without the entire object (with \c mutate from a \c tokenizer or a moved
+     *  \c value)? This is \c false when the default value needs to see the entire object.
+    **/
+    virtual bool can_stream() const = 0;
 };
 
 template <typename T, typename TMember>
@@ -710,29 +743,50 @@ public:
                                )
     { }
 
-    virtual void mutate(const extraction_context& context, const value& from, T& out) const override
+    virtual const std::vector<std::string>& extract_names() const override
     {
-        value::const_object_iterator iter;
-        for (const auto& name : _names)
-            if ((iter = from.find(name)) != from.end_object())
-                break;
-
-        bool use_default = false;
-        if (iter == from.end_object())
-        {
-            use_default = bool(_default_value);
-            if (!use_default)
-                throw extraction_error(context, std::string("Missing required field ") + _names.at(0));
-        }
-        else if (_default_on_null && iter->second.kind() == kind::null)
-        {
-            use_default = true;
-        }
+        return _names;
+    }
 
-        if (use_default)
+    virtual void mutate(const extraction_context& context,
+                        const value&              from,
+                        const std::string&        key,
+                        const value&              entry,
+                        T&                        out
+                       ) const override
+    {
+        if (_default_on_null && entry.kind() == kind::null)
             _set_value(out, _default_value(context, from));
         else
-            _set_value(out, context.extract_sub<TMember>(from, iter->first));
+            _set_value(out, context.extract_element<TMember>(entry, key));
+    }
+
+    virtual void mutate(const extraction_context& context, const std::string& key, value&& entry, T& out) const override
+    {
+        if (_default_on_null && entry.kind() == kind::null)
+            _set_value(out, _default_value(context, value()));
+        else
+            _set_value(out, context.extract_element<TMember>(std::move(entry), key));
+    }
+
+    virtual void mutate(const extraction_context& context, tokenizer& from, string_view key, T& out) const override
+    {
+        if (_default_on_null && from.current().kind == token_kind::null)
+            _set_value(out, _default_value(context, value()));
+        else
+            _set_value(out, context.extract_sub<TMember>(from, path_element(key)));
+    }
+
+    virtual void mutate_missing(const extraction_context& context, const value& from, T& out) const override
+    {
+        if (!_default_value)
+            throw extraction_error(context, std::string("Missing required field ") + _names.at(0));
+        _set_value(out, _default_value(context, from));
+    }
+
+    virtual bool can_stream() const override
+    {
+        return !_default_value || !_default_uses_input;
     }
 
     virtual void to_json(const serialization_context& context, const T& from, value& out) const override
@@ -741,9 +795,13 @@ public:
             out.insert({ _names.at(0), context.to_json(_get_value(from)) });
     }
 
-    virtual bool has_extract_key(string_view key) const override
+    virtual void encode(const serialization_context& context, const T& from, writer& out) const override
     {
-        return std::any_of(begin(_names), end(_names), [key] (const std::string& name) { return name == key; });
+        if (should_encode(context, from))
+        {
+            out.key(_names.at(0));
+            context.encode(_get_value(from), out);
+        }
     }
 
     void add_encode_check(std::function<bool (const serialization_context&, const TMember&)> check)
@@ -784,9 +842,10 @@ public:
         });
     }
 
-    void default_value(std::function<TMember (const extraction_context&, const value&)>&& create)
+    void default_value(std::function<TMember (const extraction_context&, const value&)>&& create, bool uses_input)
     {
-        _default_value = std::move(create);
+        _default_value      = std::move(create);
+        _default_uses_input = uses_input;
     }
 
     void default_on_null(bool on)
@@ -805,7 +864,7 @@ private:
 
 private:
     template <typename U, typename UMember>
-    friend class member_adapter_builder;
+    friend class jsonv::member_adapter_builder;
 
 private:
     std::vector<std::string>                                           _names;
@@ -814,6 +873,7 @@ private:
     std::function<bool (const serialization_context&, const TMember&)> _should_encode;
     std::function<TMember (const extraction_context&, const value&)>   _default_value;
     bool                                                               _default_on_null = false;
+    bool                                                               _default_uses_input = false;
     std::function<TMember (TMember&&)>                                 _extract_mutate;
 };
 
@@ -840,6 +900,7 @@ public:
     member_adapter_builder& alternate_name(std::string name)
     {
         _adapter->_names.emplace_back(std::move(name));
+        detail::adapter_builder_dsl<T>::owner->_adapter->index_keys();
         return *this;
     }
 
@@ -872,7 +933,7 @@ public:
     **/
     member_adapter_builder& default_value(std::function<TMember (const extraction_context&, const value&)> create)
     {
-        _adapter->default_value(std::move(create));
+        _adapter->default_value(std::move(create), true);
         return *this;
     }
 
@@ -881,7 +942,8 @@ public:
     **/
     member_adapter_builder& default_value(TMember value)
     {
-        return default_value([value] (const extraction_context&, const jsonv::value&) { return value; });
+        _adapter->default_value([value] (const extraction_context&, const jsonv::value&) { return value; }, false);
+        return *this;
     }
 
     /** Should a \c kind::null for a key be interpreted as a missing value? **/
@@ -996,6 +1058,7 @@ public:
             );
         member_adapter_builder<T, TMember> builder(formats_builder_dsl::owner, this, ptr.get());
         _adapter->_members.emplace_back(std::move(ptr));
+        _adapter->index_keys();
         return builder;
     }
 
@@ -1011,6 +1074,7 @@ public:
             );
         member_adapter_builder<T, TMember> builder(formats_builder_dsl::owner, this, ptr.get());
         _adapter->_members.emplace_back(std::move(ptr));
+        _adapter->index_keys();
         return builder;
     }
 
@@ -1090,18 +1154,9 @@ public:
         adapter_impl* adapter = _adapter;
         return pre_extract([adapter, handler] (const extraction_context& context, const value& from)
         {
-            auto is_key = [adapter] (string_view key) -> bool
-                          {
-                              return std::any_of(begin(adapter->_members), end(adapter->_members),
-                                                 [key] (const std::unique_ptr<detail::member_adapter<T>>& mem)
-                                                 {
-                                                     return mem->has_extract_key(key);
-                                                 }
-                                                );
-                          };
             std::set<std::string> extra_keys;
             for (const auto& pair : from.as_object())
-                if (!is_key(pair.first))
+                if (!adapter->has_key(pair.first))
                     extra_keys.insert(pair.first);
             if (!extra_keys.empty())
                 handler(context, from, std::move(extra_keys));
@@ -1126,13 +1181,87 @@ private:
                 return _create_default(context);
 
             T out;
-            for (const auto& member : _members)
-                member->mutate(context, from, out);
+            if (_members.empty())
+                return finish(context, std::move(out));
 
-            if (_post_extract)
-                out = _post_extract(context, std::move(out));
+            // Find the entry for every member in one pass over the object, then set them in the order of declaration
+            match_state                               state(_members.size());
+            std::vector<value::const_object_iterator> entries(_members.size());
+            for (auto iter = from.begin_object(); iter != from.end_object(); ++iter)
+                for (std::size_t idx : match(state, iter->first))
+                    entries[idx] = iter;
 
-            return out;
+            for (std::size_t idx = 0U; idx < _members.size(); ++idx)
+            {
+                if (state.found(idx))
+                    _members[idx]->mutate(context, from, entries[idx]->first, entries[idx]->second, out);
+                else
+                    _members[idx]->mutate_missing(context, from, out);
+            }
+
+            return finish(context, std::move(out));
+        }
+
+        virtual T create(const extraction_context& context, value&& from) const override
+        {
+            // Some default values need to see the whole object, so nothing can be moved out of it before they run
+            if (!from.is_object() || !can_stream())
+                return create(context, static_cast<const value&>(from));
+
+            if (_pre_extract)
+                _pre_extract(context, from);
+
+            T                                   out;
+            match_state                         state(_members.size());
+            std::vector<value::object_iterator> entries(_members.size());
+            for (auto iter = from.begin_object(); iter != from.end_object(); ++iter)
+                for (std::size_t idx : match(state, iter->first))
+                    entries[idx] = iter;
+
+            for (std::size_t idx = 0U; idx < _members.size(); ++idx)
+            {
+                if (state.found(idx))
+                    _members[idx]->mutate(context, entries[idx]->first, std::move(entries[idx]->second), out);
+                else
+                    _members[idx]->mutate_missing(context, value(), out);
+            }
+
+            return finish(context, std::move(out));
+        }
+
+        virtual T create(const extraction_context& context, tokenizer& from) const override
+        {
+            // pre_extract functions and some default values need to see the whole object
+            if (_pre_extract || from.current().kind != token_kind::object_begin || !can_stream())
+                return create(context, detail::parse_current(from));
+
+            T           out;
+            match_state state(_members.size());
+            std::string key;
+            for (bool first = true; detail::next_object_entry(from, first, key); first = false)
+            {
+                const std::vector<std::size_t>& matches = match(state, key);
+                if (matches.empty())
+                {
+                    detail::skip_current(from);
+                }
+                else if (matches.size() == 1U)
+                {
+                    _members[matches[0]]->mutate(context, from, key, out);
+                }
+                else
+                {
+                    value entry = detail::parse_current(from);
+                    for (std::size_t idx : matches)
+                        _members[idx]->mutate(context, value(), key, entry, out);
+                }
+            }
+
+            for (std::size_t idx = 0U; idx < _members.size(); ++idx)
+                if (!state.found(idx))
+                    _members[idx]->mutate_missing(context, value(), out);
+
+            return finish(context, std::move(out));
         }
 
         virtual value to_json(const serialization_context& context, const T& from) const override
@@ -1143,13 +1272,171 @@ private:
             return out;
         }
 
+        virtual void encode(const serialization_context& context, const T& from, writer& out) const override
+        {
+            out.begin_object();
+            for (const auto& member : _members)
+                member->encode(context, from, out);
+            out.end_object();
+        }
+
+        /** Rebuild \c _keys from the names of \c _members. This must be called whenever a name is added. **/
+        void index_keys()
+        {
+            _keys.clear();
+            for (std::size_t idx = 0U; idx < _members.size(); ++idx)
+            {
+                const std::vector<std::string>& names = _members[idx]->extract_names();
+                for (std::size_t preference = 0U; preference < names.size(); ++preference)
+                    _keys.push_back({ names[preference], idx, preference, 0U });
+            }
+            std::sort(_keys.begin(), _keys.end(), key_less());
+            for (std::size_t idx = _keys.size(); idx > 0U; --idx)
+            {
+                key_entry& entry = _keys[idx - 1];
+                entry.group_end  = idx < _keys.size() && _keys[idx].name == entry.name ? _keys[idx].group_end : idx;
+            }
+            
+            _guesses.reset(new std::atomic<std::size_t>[_keys.size()]);
+            for (std::size_t idx = 0U; idx < _keys.size(); ++idx)
+                _guesses[idx].store(no_guess(), std::memory_order_relaxed);
+        }
+
+        bool has_key(string_view key) const
+        {
+            return std::binary_search(_keys.begin(), _keys.end(), key, key_less());
+        }
+
+    private:
+        /** An entry in the dispatch table from a key to the member extracted from it. **/
+        struct key_entry
+        {
+            std::string name;
+            std::size_t member;
+            std::size_t preference; //!< The position of \c name in the names of the member (lower is preferred).
+            std::size_t group_end;  //!< One past the last entry in \c _keys with the same \c name.
+        };
+
+        struct key_less
+        {
+            bool operator()(const key_entry& a, const key_entry& b) const { return a.name < b.name; }
+            bool operator()(const key_entry& a, string_view b)      const { return string_view(a.name) < b; }
+            bool operator()(string_view a,      const key_entry& b) const { return a < string_view(b.name); }
+        };
+
+        /** Which key each member has been extracted from so far in a single object. **/
+        struct match_state
+        {
+            explicit match_state(std::size_t member_count) :
+                    preferences(member_count, not_found())
+            { }
+
+            static std::size_t not_found()
+            {
+                return std::size_t(-1);
+            }
+
+            bool found(std::size_t idx) const
+            {
+                return preferences[idx] != not_found();
+            }
+
+            std::vector<std::size_t> preferences;  //!< The preference of the key each member was found with
+            std::vector<std::size_t> matches;      //!< The result of the last \c match
+            std::size_t              position = 0; //!< The number of keys passed to \c match so far
+        };
+
+        static std::size_t no_guess()
+        {
+            return std::size_t(-1);
+        }
+
+        /** Find the position in \c _keys of the first entry for \a key at the \a position-th key of an object. Objects
+         *  from a single producer almost always have their keys in the same order, so the entry found for each position
+         *  is remembered and checked first the next time; only when that guess is wrong are the \c _keys searched.
+        **/
+        std::size_t find_key(std::size_t position, string_view key) const
+        {
+            if (position >= _keys.size())
+            {
+                // an object with more keys than there are names can not have its order remembered
+                auto iter = std::lower_bound(_keys.begin(), _keys.end(), key, key_less());
+                return iter != _keys.end() && string_view(iter->name) == key ? std::size_t(iter - _keys.begin())
+                                                                             : no_guess();
+            }
+            
+            std::atomic<std::size_t>& guess = _guesses[position];
+            std::size_t               first = guess.load(std::memory_order_relaxed);
+            if (first != no_guess() && string_view(_keys[first].name) == key)
+                return first;
+            
+            auto iter = std::lower_bound(_keys.begin(), _keys.end(), key, key_less());
+            if (iter != _keys.end() && string_view(iter->name) == key)
+            {
+                first = std::size_t(iter - _keys.begin());
+                guess.store(first, std::memory_order_relaxed);
+                return first;
+            }
+            else
+            {
+                return no_guess();
+            }
+        }
+
+        /** Find the members which should be extracted from \a key, given the keys which have already been seen in
+         *  \a state. As with \c value::find on each name, the first occurrence of the most preferred name of a member
+         *  wins.
+        **/
+        const std::vector<std::size_t>& match(match_state& state, string_view key) const
+        {
+            state.matches.clear();
+            std::size_t first = find_key(state.position++, key);
+            if (first == no_guess())
+                return state.matches;
+            
+            for (auto iter = _keys.begin() + first; iter != _keys.begin() + _keys[first].group_end; ++iter)
+            {
+                if (iter->preference < state.preferences[iter->member])
+                {
+                    state.preferences[iter->member] = iter->preference;
+                    state.matches.push_back(iter->member);
+                }
+            }
+            return state.matches;
+        }
+
+        bool can_stream() const
+        {
+            using std::begin;
+            using std::end;
+
+            return std::all_of(begin(_members), end(_members),
+                               [] (const std::unique_ptr<detail::member_adapter<T>>& mem) { return mem->can_stream(); }
+                              );
+        }
+
+        T finish(const extraction_context& context, T&& out) const
+        {
+            if (_post_extract)
+                return _post_extract(context, std::move(out));
+            else
+                return std::move(out);
+        }
+
+    public:
         std::deque<std::unique_ptr<detail::member_adapter<T>>> _members;
+        std::vector<key_entry>                                 _keys;
+        std::unique_ptr<std::atomic<std::size_t>[]>            _guesses;   //!< The key guessed at each position.
         pre_extract_func                                       _pre_extract;
         post_extract_func                                      _post_extract;
         std::function<T (const extraction_context&)>           _create_default;
         bool                                                   _default_on_null;
     };
 
+private:
+    template <typename U, typename UMember>
+    friend class member_adapter_builder;
+
 private:
     adapter_impl* _adapter;
 };
@@ -0,0 +1,321 @@
+/** \file jsonv/serialization_static.hpp
+ *  An \c adapter for plain structures whose members are listed at compile time, so that extracting and encoding them
+ *  does not go through \c std::function or a virtual call for each member.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_SERIALIZATION_STATIC_HPP_INCLUDED__
+#define __JSONV_SERIALIZATION_STATIC_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/serialization.hpp>
+#include <jsonv/serialization_util.hpp>
+#include <jsonv/writer.hpp>
+
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace jsonv
+{
+
+/** \addtogroup Serialization
+ *  \{
+**/
+
+namespace detail
+{
+
+/** How \c static_member converts a member of type \c T. By default, it goes through the \c formats of the context like
+ *  everything else. The specializations convert directly, exactly like the extractors and serializers in
+ *  \c formats::defaults do.
+**/
+template <typename T, typename = void>
+struct static_conversion :
+        std::false_type
+{ };
+
+template <typename T>
+struct static_conversion<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> :
+        std::true_type
+{
+    static T extract(const jsonv::value& from)
+    {
+        return T(from.as_integer());
+    }
+
+    static jsonv::value to_json(T from)
+    {
+        return jsonv::value(static_cast<std::int64_t>(from));
+    }
+};
+
+template <typename T>
+struct static_conversion<T, typename std::enable_if<std::is_floating_point<T>::value>::type> :
+        std::true_type
+{
+    static T extract(const jsonv::value& from)
+    {
+        return T(from.as_decimal());
+    }
+
+    static jsonv::value to_json(T from)
+    {
+        return jsonv::value(static_cast<double>(from));
+    }
+};
+
+template <>
+struct static_conversion<bool> :
+        std::true_type
+{
+    static bool extract(const jsonv::value& from)
+    {
+        return from.as_boolean();
+    }
+
+    static jsonv::value to_json(bool from)
+    {
+        return jsonv::value(from);
+    }
+};
+
+template <>
+struct static_conversion<std::string> :
+        std::true_type
+{
+    static std::string extract(const jsonv::value& from)
+    {
+        return from.as_string();
+    }
+
+    static std::string extract(jsonv::value&& from)
+    {
+        return from.take_string();
+    }
+
+    static jsonv::value to_json(const std::string& from)
+    {
+        return jsonv::value(from);
+    }
+};
+
+}
+
+/** A member of a \c static_adapter: the data member \a Member of \c T, which is extracted from and encoded to the key
+ *  \c name. This is usually made with \c JSONV_STATIC_MEMBER.
+ *
+ *  Members which are integers, floating-point numbers, \c bool or \c std::string are converted directly (in the same
+ *  way as \c formats::defaults does), so the compiler can see all the way through. Members of any other type are
+ *  extracted and encoded with the \c formats of the context.
+**/
+template <typename T, typename TMember, TMember T::*Member>
+class static_member
+{
+public:
+    using object_type = T;
+    using member_type = TMember;
+
+public:
+    constexpr explicit static_member(const char* name) :
+            _name(name)
+    { }
+
+    constexpr const char* name() const
+    {
+        return _name;
+    }
+
+    /** Set the member of \a out from the entry for \c name in the object \a from. When \c TValue is not \c const, the
+     *  contents of the entry are moved out of \a from.
+     *
+     *  \throws extraction_error if \a from has no entry for \c name or it can not be converted.
+    **/
+    template <typename TValue>
+    void extract(const extraction_context& context, TValue& from, T& out) const
+    {
+        auto iter = from.find(_name);
+        if (iter == from.end_object())
+            throw extraction_error(context, std::string("Missing required field ") + _name);
+        assign(context, std::move(iter->second), out.*Member, conversion());
+    }
+
+    void to_json(const serialization_context& context, const T& from, value& out) const
+    {
+        out.insert({ _name, to_json(context, from.*Member, conversion()) });
+    }
+
+    void encode(const serialization_context& context, const T& from, writer& out) const
+    {
+        out.key(_name);
+        encode(context, from.*Member, out, conversion());
+    }
+
+private:
+    using conversion = detail::static_conversion<TMember>;
+
+    template <typename TValue>
+    void assign(const extraction_context& context, TValue&& entry, TMember& member, std::true_type) const
+    {
+        try
+        {
+            member = conversion::extract(std::forward<TValue>(entry));
+        }
+        catch (const std::exception& ex)
+        {
+            throw extraction_error(context.path() + path_element(_name), ex.what());
+        }
+    }
+
+    template <typename TValue>
+    void assign(const extraction_context& context, TValue&& entry, TMember& member, std::false_type) const
+    {
+        member = context.extract_element<TMember>(std::forward<TValue>(entry), _name);
+    }
+
+    static value to_json(const serialization_context&, const TMember& member, std::true_type)
+    {
+        return conversion::to_json(member);
+    }
+
+    static value to_json(const serialization_context& context, const TMember& member, std::false_type)
+    {
+        return context.to_json(member);
+    }
+
+    static void encode(const serialization_context&, const TMember& member, writer& out, std::true_type)
+    {
+        out.value(member);
+    }
+
+    static void encode(const serialization_context& context, const TMember& member, writer& out, std::false_type)
+    {
+        context.encode(member, out);
+    }
+
+private:
+    const char* _name;
+};
+
+/** Make a \c static_member for the data member \a member_ of \a type_, using the name of the member as the key. **/
+#define JSONV_STATIC_MEMBER(type_, member_) \
+    JSONV_STATIC_MEMBER_NAMED(type_, member_, #member_)
+
+/** Make a \c static_member for the data member \a member_ of \a type_ with the key \a name_. **/
+#define JSONV_STATIC_MEMBER_NAMED(type_, member_, name_) \
+    ::jsonv::static_member<type_, decltype(type_::member_), &type_::member_>(name_)
+
+/** An \c adapter for a default-constructible \c T with a fixed list of \a TMembers (each a \c static_member). The
+ *  members are converted in a loop the compiler unrolls, so converting a small structure costs little more than the
+ *  conversion of its fields. All members are required when extracting and keys which are not members are ignored. For
+ *  anything fancier (alternate names, default values, versioning), use \c formats_builder.
+ *
+ *  \example "Serialization: static_adapter"
+ *  \code
+ *  struct point
+ *  {
+ *      double      x;
+ *      double      y;
+ *      std::string label;
+ *  };
+ *
+ *  static const auto point_adapter = jsonv::make_static_adapter<point>(JSONV_STATIC_MEMBER(point, x),
+ *                                                                      JSONV_STATIC_MEMBER(point, y),
+ *                                                                      JSONV_STATIC_MEMBER_NAMED(point, label, "name")
+ *                                                                     );
+ *  jsonv::formats fmt = jsonv::formats::compose({ jsonv::formats::defaults() });
+ *  fmt.register_adapter(&point_adapter);
+ *  \endcode
+**/
+template <typename T, typename... TMembers>
+class static_adapter :
+        public adapter_for<T>
+{
+public:
+    explicit static_adapter(TMembers... members) :
+            _members(std::move(members)...)
+    { }
+
+protected:
+    virtual T create(const extraction_context& context, const value& from) const override
+    {
+        T out;
+        extract_members(context, from, out, std::index_sequence_for<TMembers...>());
+        return out;
+    }
+
+    virtual T create(const extraction_context& context, value&& from) const override
+    {
+        T out;
+        extract_members(context, from, out, std::index_sequence_for<TMembers...>());
+        return out;
+    }
+
+    virtual value to_json(const serialization_context& context, const T& from) const override
+    {
+        value out = object();
+        to_json_members(context, from, out, std::index_sequence_for<TMembers...>());
+        return out;
+    }
+
+    virtual void encode(const serialization_context& context, const T& from, writer& out) const override
+    {
+        out.begin_object();
+        encode_members(context, from, out, std::index_sequence_for<TMembers...>());
+        out.end_object();
+    }
+
+private:
+    using expand = int[];
+
+    template <typename TValue, std::size_t... Idx>
+    void extract_members(const extraction_context& context, TValue& from, T& out, std::index_sequence<Idx...>) const
+    {
+        (void) expand { 0, (std::get<Idx>(_members).extract(context, from, out), 0)... };
+    }
+
+    template <std::size_t... Idx>
+    void to_json_members(const serialization_context& context,
+                         const T&                     from,
+                         value&                       out,
+                         std::index_sequence<Idx...>
+                        ) const
+    {
+        (void) expand { 0, (std::get<Idx>(_members).to_json(context, from, out), 0)... };
+    }
+
+    template <std::size_t... Idx>
+    void encode_members(const serialization_context& context,
+                        const T&                     from,
+                        writer&                      out,
+                        std::index_sequence<Idx...>
+                       ) const
+    {
+        (void) expand { 0, (std::get<Idx>(_members).encode(context, from, out), 0)... };
+    }
+
+private:
+    std::tuple<TMembers...> _members;
+};
+
+/** Create a \c static_adapter for \c T with the given \a members. **/
+template <typename T, typename... TMembers>
+static_adapter<T, TMembers...> make_static_adapter(TMembers... members)
+{
+    return static_adapter<T, TMembers...>(std::move(members)...);
+}
+
+/** \} **/
+
+}
+
+#endif/*__JSONV_SERIALIZATION_STATIC_HPP_INCLUDED__*/
@@ -17,11 +17,17 @@
 #include <jsonv/demangle.hpp>
 #include <jsonv/functional.hpp>
 #include <jsonv/serialization.hpp>
+#include <jsonv/tokenizer.hpp>
+#include <jsonv/writer.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <initializer_list>
 #include <functional>
 #include <map>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 namespace jsonv
 {
@@ -88,8 +94,40 @@ public:
         new(into) T(create(context, from));
     }
     
+    virtual void extract(const extraction_context& context,
+                         value&&                   from,
+                         void*                     into
+                        ) const override
+    {
+        new(into) T(create(context, std::move(from)));
+    }
+    
+    virtual void extract(const extraction_context& context,
+                         tokenizer&                from,
+                         void*                     into
+                        ) const override
+    {
+        new(into) T(create(context, from));
+    }
+    
 protected:
     virtual T create(const extraction_context& context, const value& from) const = 0;
+    
+    /** Create a \c T from \a from, which can have its contents moved out of it (see \c extractor::extract). The
+     *  default implementation calls the \c const version of \c create.
+    **/
+    virtual T create(const extraction_context& context, value&& from) const
+    {
+        return create(context, static_cast<const value&>(from));
+    }
+    
+    /** Create a \c T from the current value of \a from (see \c extractor::extract). The default implementation parses
+     *  the value and calls the \c value version of \c create.
+    **/
+    virtual T create(const extraction_context& context, tokenizer& from) const
+    {
+        return create(context, detail::parse_current(from));
+    }
 };
 
 template <typename T, typename FExtract>
@@ -166,10 +204,25 @@ public:
         return to_json(context, *static_cast<const T*>(from));
     }
     
+    virtual void encode(const serialization_context& context,
+                        const void*                  from,
+                        encoder&                     out
+                       ) const override
+    {
+        writer w(out);
+        encode(context, *static_cast<const T*>(from), w);
+    }
+    
 protected:
     virtual value to_json(const serialization_context& context,
                           const T&                     from
                          ) const = 0;
+    
+    /** Write \a from as the next value of \a out. The default implementation writes the result of \c to_json. **/
+    virtual void encode(const serialization_context& context, const T& from, writer& out) const
+    {
+        out.value(to_json(context, from));
+    }
 };
 
 template <typename T, typename FToJson>
@@ -232,6 +285,22 @@ public:
         new(into) T(create(context, from));
     }
     
+    virtual void extract(const extraction_context& context,
+                         value&&                   from,
+                         void*                     into
+                        ) const override
+    {
+        new(into) T(create(context, std::move(from)));
+    }
+    
+    virtual void extract(const extraction_context& context,
+                         tokenizer&                from,
+                         void*                     into
+                        ) const override
+    {
+        new(into) T(create(context, from));
+    }
+    
     virtual value to_json(const serialization_context& context,
                           const void*                  from
                          ) const override
@@ -239,10 +308,41 @@ public:
         return to_json(context, *static_cast<const T*>(from));
     }
     
+    virtual void encode(const serialization_context& context,
+                        const void*                  from,
+                        encoder&                     out
+                       ) const override
+    {
+        writer w(out);
+        encode(context, *static_cast<const T*>(from), w);
+    }
+    
 protected:
     virtual T create(const extraction_context& context, const value& from) const = 0;
     
+    /** Create a \c T from \a from, which can have its contents moved out of it (see \c extractor::extract). The
+     *  default implementation calls the \c const version of \c create.
+    **/
+    virtual T create(const extraction_context& context, value&& from) const
+    {
+        return create(context, static_cast<const value&>(from));
+    }
+    
+    /** Create a \c T from the current value of \a from (see \c extractor::extract). The default implementation parses
+     *  the value and calls the \c value version of \c create.
+    **/
+    virtual T create(const extraction_context& context, tokenizer& from) const
+    {
+        return create(context, detail::parse_current(from));
+    }
+    
     virtual value to_json(const serialization_context& context, const T& from) const = 0;
+    
+    /** Write \a from as the next value of \a out. The default implementation writes the result of \c to_json. **/
+    virtual void encode(const serialization_context& context, const T& from, writer& out) const
+    {
+        out.value(to_json(context, from));
+    }
 };
 
 template <typename T, typename FExtract, typename FToJson>
@@ -353,6 +453,22 @@ protected:
             return TOptional(context.extract<element_type>(from));
     }
 
+    virtual TOptional create(const extraction_context& context, value&& from) const override
+    {
+        if (from.is_null())
+            return TOptional();
+        else
+            return TOptional(context.extract<element_type>(std::move(from)));
+    }
+
+    virtual TOptional create(const extraction_context& context, tokenizer& from) const override
+    {
+        if (from.current().kind == token_kind::null)
+            return TOptional();
+        else
+            return TOptional(context.extract<element_type>(from));
+    }
+
     virtual value to_json(const serialization_context& context, const TOptional& from) const override
     {
         if (from)
@@ -360,6 +476,14 @@ protected:
         else
             return value();
     }
+
+    virtual void encode(const serialization_context& context, const TOptional& from, writer& out) const override
+    {
+        if (from)
+            context.encode(*from, out);
+        else
+            out.null();
+    }
 };
 
 /** An adapter for container types. This is for convenience of creating an \c adapter for things like \c std::vector,
@@ -381,7 +505,43 @@ protected:
         
         TContainer out;
         from.as_array(); // get nice error if input is not an array
-        for (value::size_type idx = 0U; idx < from.size(); ++idx)
+        reserve(out, from.size(), 0);
+        if (context.parallelism() != 1)
+            context.extract_elements<element_type>(from,
+                                                   [&out] (element_type&& x) { out.insert(end(out), std::move(x)); }
+                                                  );
+        else
+            for (value::size_type idx = 0U; idx < from.size(); ++idx)
+                out.insert(end(out), context.extract_sub<element_type>(from, idx));
+        return out;
+    }
+    
+    virtual TContainer create(const extraction_context& context, value&& from) const override
+    {
+        using std::end;
+        
+        TContainer out;
+        from.as_array(); // get nice error if input is not an array
+        reserve(out, from.size(), 0);
+        if (context.parallelism() != 1)
+            context.extract_elements<element_type>(std::move(from),
+                                                   [&out] (element_type&& x) { out.insert(end(out), std::move(x)); }
+                                                  );
+        else
+            for (value::size_type idx = 0U; idx < from.size(); ++idx)
+                out.insert(end(out), context.extract_sub<element_type>(std::move(from), idx)); // only moves element idx
+        return out;
+    }
+    
+    virtual TContainer create(const extraction_context& context, tokenizer& from) const override
+    {
+        using std::end;
+        
+        if (from.current().kind != token_kind::array_begin)
+            return create(context, detail::parse_current(from)); // same error as the value version
+        
+        TContainer out;
+        for (value::size_type idx = 0U; detail::next_array_element(from, idx == 0U); ++idx)
             out.insert(end(out), context.extract_sub<element_type>(from, idx));
         return out;
     }
@@ -393,6 +553,25 @@ protected:
             out.push_back(context.to_json(x));
         return out;
     }
+    
+    virtual void encode(const serialization_context& context, const TContainer& from, writer& out) const override
+    {
+        out.begin_array();
+        for (const element_type& x : from)
+            context.encode(x, out);
+        out.end_array();
+    }
+    
+private:
+    template <typename U>
+    static auto reserve(U& out, std::size_t count, int) -> decltype(out.reserve(count), void())
+    {
+        out.reserve(count);
+    }
+    
+    template <typename U>
+    static void reserve(U&, std::size_t, long)
+    { }
 };
 
 /** An adapter for "wrapper" types.
@@ -412,10 +591,25 @@ protected:
         return TWrapper(context.extract<element_type>(from));
     }
 
+    virtual TWrapper create(const extraction_context& context, value&& from) const override
+    {
+        return TWrapper(context.extract<element_type>(std::move(from)));
+    }
+
+    virtual TWrapper create(const extraction_context& context, tokenizer& from) const override
+    {
+        return TWrapper(context.extract<element_type>(from));
+    }
+
     virtual value to_json(const serialization_context& context, const TWrapper& from) const override
     {
         return context.to_json(element_type(from));
     }
+
+    virtual void encode(const serialization_context& context, const TWrapper& from, writer& out) const override
+    {
+        context.encode(element_type(from), out);
+    }
 };
 
 /** An adapter for enumeration types. The most common use of this is to map \c enum values in C++ to string values in a
@@ -573,16 +767,13 @@ public:
     template <typename T>
     void add_subtype(match_predicate pred)
     {
-        _subtype_ctors.emplace_back(std::move(pred),
-                                    [] (const extraction_context& context, const value& value)
-                                    {
-                                        return TPointer(new T(context.extract<T>(value)));
-                                    }
-                                   );
+        _unkeyed_subtypes.push_back(_subtype_ctors.size());
+        add_subtype_ctor<T>(std::move(pred));
     }
     
     /** Add a subtype which can be transformed into \c TPointer which will be called if given a JSON \c value with
-     *  \c kind::object which has a member with \a key and the provided \a expected_value.
+     *  \c kind::object which has a member with \a key and the provided \a expected_value. Keyed subtypes are found with
+     *  a single hash lookup per distinct \a key, so the cost of extraction does not grow with the number of subtypes.
      *  
      *  \see add_subtype
     **/
@@ -595,6 +786,14 @@ public:
         if (!_serialization_actions.emplace(tidx, std::make_tuple(key, expected_value, action)).second)
             throw duplicate_type_error("polymorphic_adapter subtype", std::type_index(typeid(T)));
 
+        auto keyed_iter = std::find_if(_keyed_subtypes.begin(), _keyed_subtypes.end(),
+                                       [&] (const keyed_subtypes& keyed) { return keyed.first == key; }
+                                      );
+        if (keyed_iter == _keyed_subtypes.end())
+            keyed_iter = _keyed_subtypes.emplace(_keyed_subtypes.end(), key, subtype_table());
+        // If the key and value are already taken, the earlier subtype is the one which will always match
+        keyed_iter->second.emplace(expected_value, _subtype_ctors.size());
+
         match_predicate op = [key, expected_value] (const extraction_context&, const value& value)
                              {
                                  if (!value.is_object())
@@ -603,7 +802,7 @@ public:
                                  return iter != value.end_object()
                                      && iter->second == expected_value;
                              };
-        return add_subtype<T>(op);
+        add_subtype_ctor<T>(std::move(op));
     }
     
     /** When extracting a C++ value, should \c kind::null in JSON automatically become a default-constructed \c TPointer
@@ -639,14 +838,36 @@ protected:
         if (_check_null_input && from.is_null())
             return TPointer();
         
-        auto iter = std::find_if(begin(_subtype_ctors), end(_subtype_ctors),
-                                 [&] (const std::pair<match_predicate, create_function>& pair)
-                                 {
-                                     return pair.first(context, from);
-                                 }
-                                );
-        if (iter != end(_subtype_ctors))
-            return iter->second(context, from);
+        // Subtypes are matched in the order they were added: the keyed ones are looked up directly and only the
+        // predicates of unkeyed subtypes added before the best keyed match need to be called.
+        std::size_t match = _subtype_ctors.size();
+        if (from.is_object())
+        {
+            for (const keyed_subtypes& keyed : _keyed_subtypes)
+            {
+                auto field = from.find(keyed.first);
+                if (field == from.end_object())
+                    continue;
+                
+                auto subtype = keyed.second.find(field->second);
+                if (subtype != keyed.second.end())
+                    match = std::min(match, subtype->second);
+            }
+        }
+        
+        for (std::size_t idx : _unkeyed_subtypes)
+        {
+            if (idx >= match)
+                break;
+            if (_subtype_ctors[idx].first(context, from))
+            {
+                match = idx;
+                break;
+            }
+        }
+        
+        if (match != _subtype_ctors.size())
+            return _subtype_ctors[match].second(context, from);
         else
             throw extraction_error(context,
                                    std::string("No discriminators matched JSON value: ") + to_string(from)
@@ -703,10 +924,27 @@ protected:
 private:
     using create_function = std::function<TPointer (const extraction_context&, const value&)>;
     
+    /** Index in \c _subtype_ctors of the subtype for each expected value of a discrimination key. **/
+    using subtype_table  = std::unordered_map<value, std::size_t>;
+    using keyed_subtypes = std::pair<std::string, subtype_table>;
+    
+    template <typename T>
+    void add_subtype_ctor(match_predicate pred)
+    {
+        _subtype_ctors.emplace_back(std::move(pred),
+                                    [] (const extraction_context& context, const value& value)
+                                    {
+                                        return TPointer(new T(context.extract<T>(value)));
+                                    }
+                                   );
+    }
+    
 private:
     using serialization_action = std::tuple<std::string, value, keyed_subtype_action>;
 
     std::vector<std::pair<match_predicate, create_function>> _subtype_ctors;
+    std::vector<keyed_subtypes>                              _keyed_subtypes;
+    std::vector<std::size_t>                                 _unkeyed_subtypes;
     std::map<std::type_index, serialization_action>          _serialization_actions;
     bool                                                     _check_null_input  = false;
     bool                                                     _check_null_output = false;
@@ -0,0 +1,146 @@
+/** \file jsonv/stats.hpp
+ *  Counts and timings of the phases of parsing and encoding.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_STATS_HPP_INCLUDED__
+#define __JSONV_STATS_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/forward.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+
+namespace jsonv
+{
+
+/** What the parses given a \c parse_options::stats did, added up over all of them. This is meant to be collected in
+ *  production to see which shapes of input are expensive, so it is cheap enough to leave on: each token costs a few
+ *  additions and a pair of clock reads.
+ *
+ *  An instance is not safe to share between parses running on separate threads at the same time.
+ *
+ *  \example
+ *  \code
+ *  auto stats = std::make_shared<jsonv::parse_stats>();
+ *  jsonv::value x = jsonv::parse(text, jsonv::parse_options().stats(stats));
+ *  std::clog << *stats << std::endl;
+ *  \endcode
+**/
+struct JSONV_PUBLIC parse_stats
+{
+    using size_type = std::size_t;
+    using duration  = std::chrono::nanoseconds;
+
+    /** The number of documents parsed. **/
+    size_type documents = 0;
+
+    /** The number of tokens of each \c token_kind (including whitespace and comments), by the index of the kind's bit.
+     *  Use \c tokens to look them up.
+    **/
+    std::array<size_type, 12> token_counts = {};
+
+    /** The bytes between the quotes of string tokens (values and keys). **/
+    size_type string_bytes = 0;
+
+    /** The bytes of number tokens. **/
+    size_type number_bytes = 0;
+
+    /** The deepest nesting of arrays and objects: \c 0 for a document which is a single scalar, \c 1 for a flat array
+     *  and so on.
+    **/
+    size_type max_depth = 0;
+
+    /** The time from the start to the end of each parse. **/
+    duration total_time = duration(0);
+
+    /** The time spent finding the next token. **/
+    duration tokenize_time = duration(0);
+
+    /** The time spent decoding the contents of strings. Strings which are borrowed from the input (see
+     *  \c parse_options::strings) or found in a \c parse_options::keys dictionary are not decoded.
+    **/
+    duration string_time = duration(0);
+
+    /** The time spent converting number tokens. **/
+    duration number_time = duration(0);
+
+    /** The number of tokens which were any of the \a kinds (which can be several kinds combined with \c |). **/
+    size_type tokens(token_kind kinds) const;
+
+    /** The number of tokens of every kind. **/
+    size_type total_tokens() const;
+
+    /** The time spent on everything else: checking the structure, building the \c value (or calling the \c encoder) and
+     *  checking a \c parse_options::validation_schema.
+    **/
+    duration build_time() const;
+
+    /** Count a token of \a kind. **/
+    void add_token(token_kind kind);
+
+    parse_stats& operator+=(const parse_stats& other);
+};
+
+/** Print \a stats as a JSON object, which is convenient for logging. **/
+JSONV_PUBLIC std::ostream& operator<<(std::ostream& os, const parse_stats& stats);
+
+/** What the calls to \c encoder::encode given an \c encode_stats did, added up over all of them. Like \c parse_stats,
+ *  this is cheap enough to leave on and not safe to share between threads.
+**/
+struct JSONV_PUBLIC encode_stats
+{
+    using size_type = std::size_t;
+    using duration  = std::chrono::nanoseconds;
+
+    /** The number of values encoded (calls to \c encoder::encode). **/
+    size_type documents = 0;
+
+    /** The number of values of each \c kind, by the kind's value. Use \c values to look them up. **/
+    std::array<size_type, 7> value_counts = {};
+
+    /** The number of object keys (which are not counted as strings). **/
+    size_type keys = 0;
+
+    /** The bytes of the strings and keys, before they were encoded. **/
+    size_type string_bytes = 0;
+
+    /** The deepest nesting of arrays and objects, counted like \c parse_stats::max_depth. **/
+    size_type max_depth = 0;
+
+    /** The time from the start to the end of each encode. **/
+    duration total_time = duration(0);
+
+    /** The time spent writing strings and keys. **/
+    duration string_time = duration(0);
+
+    /** The time spent writing integers and decimals. **/
+    duration number_time = duration(0);
+
+    /** The number of values of \a of_kind. **/
+    size_type values(kind of_kind) const;
+
+    /** The number of values of every kind. **/
+    size_type total_values() const;
+
+    /** The time spent on everything else: walking the \c value and writing the structure and the other scalars. **/
+    duration structure_time() const;
+
+    encode_stats& operator+=(const encode_stats& other);
+};
+
+/** Print \a stats as a JSON object, which is convenient for logging. **/
+JSONV_PUBLIC std::ostream& operator<<(std::ostream& os, const encode_stats& stats);
+
+}
+
+#endif/*__JSONV_STATS_HPP_INCLUDED__*/
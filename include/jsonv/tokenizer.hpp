@@ -23,6 +23,13 @@
 namespace jsonv
 {
 
+namespace detail
+{
+
+class structural_index;
+
+}
+
 /** The kind of token that was encountered in a \c tokenizer. The tokenizer will is parsing this information anyway, so
  *  it is easy to expose.
 **/
@@ -101,12 +108,17 @@ class JSONV_PUBLIC tokenizer
 public:
     using size_type = std::vector<char>::size_type;
     
-    /// \deprecated
-    /// See \ref buffer_reserve.
+    /** Get the default size of the buffer a \c tokenizer reading from an \c std::istream starts with.
+     *  
+     *  \see buffer_reserve
+    **/
     static size_type min_buffer_size();
     
-    /// \deprecated
-    /// See \ref buffer_reserve.
+    /** Set the default size of the buffer a \c tokenizer reading from an \c std::istream starts with. This does not
+     *  affect existing instances.
+     *  
+     *  \see buffer_reserve
+    **/
     static void set_min_buffer_size(size_type sz);
     
     /** A representation of what this tokenizer has. **/
@@ -121,16 +133,34 @@ public:
         }
     };
     
+    /** A location in the input. **/
+    struct location
+    {
+        size_type line;      //!< The line of the input, starting at 1
+        size_type column;    //!< The column in the \c line, starting at 1
+        size_type character; //!< The number of characters from the beginning of the input
+    };
+    
 public:
     /// Construct a tokenizer to read the given non-owned \a input.
     explicit tokenizer(string_view input);
 
-    /// Construct a tokenizer from the provided \a input.
+    /** Construct a tokenizer which reads from the provided \a input as tokens are requested. Input is kept in a
+     *  bounded buffer (see \c buffer_reserve), so tokens of a large document are available as soon as they arrive
+     *  and the memory used does not depend on the length of the input. The buffer will only grow past its size if a
+     *  single token does not fit in it.
+     *  
+     *  \note
+     *  Unlike a \c tokenizer constructed from a \c string_view, the \c text of a \c token is only valid until the next
+     *  call to \c next. The \a input must outlive this \c tokenizer.
+    **/
     explicit tokenizer(std::istream& input);
     
     ~tokenizer() noexcept;
     
-    /// Get the input this instance is reading from.
+    /** Get the input this instance is reading from. For a \c tokenizer constructed from an \c std::istream, this is
+     *  the portion of the input currently in the buffer.
+    **/
     const string_view& input() const;
     
     /** Attempt to go to the next token in the input stream. The contents of \c current will be cleared.
@@ -140,6 +170,28 @@ public:
     **/
     bool next();
     
+    /** Go through up to \a max_tokens more tokens of the input, copying each one whose kind has none of the flags in
+     *  \a skip into \a out. This does the same as calling \c next in a loop, but without a call per token, so a
+     *  consumer which looks at every token (such as a validator) can work through the input in batches. Passing
+     *  <tt>token_kind::whitespace | token_kind::comment</tt> as \a skip leaves only the tokens which matter to the
+     *  structure of the document. When this returns, \c current is the last token gone through, which might have
+     *  been skipped.
+     *  
+     *  For a \c tokenizer reading from an \c std::istream, the batch ends early when the buffer has to be refilled
+     *  (since that moves the text of the tokens before it), so the \c text of every token in \a out stays valid until
+     *  the next call to \c next or \c next_batch.
+     *  
+     *  \returns The number of tokens put into \a out; this is only \c 0 if the end of the input was reached.
+    **/
+    size_type next_batch(token* out, size_type max_tokens, token_kind skip = token_kind::unknown);
+    
+    /** Fill the array \a out with the next tokens of the input. \see next_batch **/
+    template <std::size_t N>
+    size_type next_batch(token (&out)[N], token_kind skip = token_kind::unknown)
+    {
+        return next_batch(out, N, skip);
+    }
+    
     /** Get the current token and its associated \c token_kind.
      *  
      *  \returns The current token.
@@ -147,18 +199,36 @@ public:
     **/
     const token& current() const;
     
-    /// \deprecated
-    /// Calling this function has no effect and will be removed in 2.0.
+    /** Get the location of the \c current token in the input or the end of the input if \c next has returned
+     *  \c false. Lines and columns are not tracked while tokenizing, but are counted from the previous call to this
+     *  function, so calling this occasionally (such as when reporting an error) is cheap.
+    **/
+    location current_location() const;
+    
+    /** Ensure the buffer used to read from an \c std::istream can hold at least \a sz characters. This has no effect
+     *  on a \c tokenizer constructed from a \c string_view.
+    **/
     void buffer_reserve(size_type sz);
     
 private:
-    explicit tokenizer(std::shared_ptr<std::string> input);
+    struct stream_state;
+    
+    bool refill();
+    
+    /** Move to the next token; see \c next. If \a may_refill is \c false, this stops (returning \c false) when more
+     *  input needs to be read from the stream first.
+    **/
+    bool advance(bool may_refill);
     
 private:
-    string_view           _input;
-    const char*           _position;
-    token                 _current;  //!< The current token
-    std::shared_ptr<void> _track;    //!< Used to track input data when needed (\c std::istream constructor)
+    string_view                                     _input;
+    const char*                                     _position;
+    token                                           _current;      //!< The current token
+    std::shared_ptr<const detail::structural_index> _index;        //!< Structural index of large inputs (or null)
+    std::size_t                                     _index_cursor; //!< The position of \c _position in \c _index
+    std::shared_ptr<stream_state>                   _stream;       //!< The buffer state (\c std::istream only)
+    mutable const char*                             _location_ptr; //!< The position \c _location refers to
+    mutable location                                _location;     //!< Last result of \c current_location
 };
 
 }
@@ -0,0 +1,93 @@
+/** \file jsonv/trace.hpp
+ *  Callbacks at the start and end of parsing, extraction and encoding, for attributing the time spent in JSON to
+ *  whatever a distributed tracing system is following.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_TRACE_HPP_INCLUDED__
+#define __JSONV_TRACE_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+
+#include <cstddef>
+#include <iosfwd>
+#include <typeinfo>
+
+namespace jsonv
+{
+
+/** The operations a \c tracer is told about. **/
+enum class trace_operation : unsigned char
+{
+    /** One of the \c parse functions which return a \c value or call an \c encoder. **/
+    parse,
+    /** \c formats::extract (which is what \c extract and \c extraction_context::extract end up calling). **/
+    extract,
+    /** \c formats::to_json (what \c to_json and \c serialization_context::to_json call). **/
+    to_json,
+    /** \c encoder::encode of a \c value or \c formats::encode of a C++ object straight to an \c encoder. **/
+    encode,
+};
+
+JSONV_PUBLIC std::ostream& operator<<(std::ostream&, const trace_operation&);
+
+/** What a \c tracer is told about an operation. **/
+struct JSONV_PUBLIC trace_span
+{
+    trace_operation       operation;
+    std::size_t           bytes; //!< The size of the text being parsed, or \c 0 if it is not known up front
+    const std::type_info* type;  //!< The C++ type being extracted or serialized (\c nullptr for \c value operations)
+};
+
+/** Receives a call at the start and end of each top-level \c trace_operation. Operations which happen inside of one of
+ *  the same kind on the same thread (such as the extraction of each member of a structure being extracted) are part of
+ *  the outer one, so they are not reported. Operations of other kinds are, so the \c parse of a \c lazy_value in the
+ *  middle of an extraction is a span inside of the extraction's.
+ *
+ *  \c begin and \c end are called on the thread doing the work, with the same \c trace_span, so a tracer can keep a
+ *  per-thread stack of the spans it has opened. \c end is also called when the operation fails with an exception (while
+ *  it unwinds), so neither function may throw.
+ *
+ *  \example
+ *  \code
+ *  class otel_tracer : public jsonv::tracer
+ *  {
+ *  public:
+ *      virtual void begin(const jsonv::trace_span& span) override { ... start a child span of the current one ... }
+ *      virtual void end(const jsonv::trace_span& span) override   { ... end it ... }
+ *  };
+ *
+ *  static otel_tracer tracer_instance;
+ *  jsonv::set_tracer(&tracer_instance);
+ *  \endcode
+**/
+class JSONV_PUBLIC tracer
+{
+public:
+    virtual ~tracer() noexcept;
+
+    virtual void begin(const trace_span& span) noexcept = 0;
+
+    virtual void end(const trace_span& span) noexcept = 0;
+};
+
+/** Install \a handler as the \c tracer for the whole program, or remove the current one with \c nullptr. The
+ *  \a handler is not owned and must stay alive until it has been removed and every operation which had started with
+ *  it has finished. Without a tracer, the cost of tracing is loading a pointer at the start of each operation.
+ *
+ *  \returns The tracer which was installed before.
+**/
+JSONV_PUBLIC tracer* set_tracer(tracer* handler);
+
+/** Get the \c tracer installed by \c set_tracer (or \c nullptr if there is none). **/
+JSONV_PUBLIC tracer* get_tracer();
+
+}
+
+#endif/*__JSONV_TRACE_HPP_INCLUDED__*/
@@ -14,7 +14,10 @@
 #include <jsonv/config.hpp>
 #include <jsonv/string_view.hpp>
 #include <jsonv/detail/basic_view.hpp>
+#include <jsonv/detail/flat_map.hpp>
+#include <jsonv/detail/node_allocator.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <initializer_list>
@@ -22,17 +25,30 @@
 #include <iterator>
 #include <functional>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <utility>
 
+/** \def JSONV_OBJECT_FLAT_STORAGE
+ *  Set this to 1 to store the entries of objects in a sorted, contiguous array (\c jsonv::detail::flat_map) instead of
+ *  an \c std::map. Finding a key and iterating are faster for small objects, but inserting into and erasing from large
+ *  objects is slower, and every insert or erase invalidates the iterators and references into the object. The key of
+ *  \c value::object_value_type is not \c const when this is set. This changes the ABI, so the library and everything
+ *  using it must agree on it.
+**/
+#ifndef JSONV_OBJECT_FLAT_STORAGE
+#   define JSONV_OBJECT_FLAT_STORAGE 0
+#endif
+
 namespace jsonv
 {
 
 class path;
 class value;
 class object_node_handle;
+struct memory_breakdown;
 
 namespace detail
 {
@@ -40,6 +56,7 @@ namespace detail
 class object_impl;
 class array_impl;
 class string_impl;
+class reusable_storage;
 
 union value_storage
 {
@@ -55,6 +72,49 @@ union value_storage
     { }
 };
 
+/** The ordering of the keys of objects. This is the same order as \c std::less<std::string>, but it is transparent, so
+ *  looking up a key from a \c string_view does not need to make an \c std::string out of it.
+**/
+struct object_key_less
+{
+    using is_transparent = void;
+    
+    bool operator()(string_view a, string_view b) const
+    {
+        int rc = std::char_traits<char>::compare(a.data(), b.data(), a.size() < b.size() ? a.size() : b.size());
+        return rc < 0 || (rc == 0 && a.size() < b.size());
+    }
+};
+
+/** Create a \c kind::string which refers to \a contents instead of copying it. If \a owner is set, the value keeps it
+ *  alive. This is used by \c parse for \c parse_options::strings::borrow and \c parse_options::strings::share.
+**/
+value make_borrowed_string(string_view contents, std::shared_ptr<const void> owner);
+
+/** Remember \a text as the JSON encoding of \a target if it is an array or object (nothing is kept for other kinds).
+ *  The text is forgotten as soon as \a target is changed (or a reference into it is given out). This is used by
+ *  \c raw_json.
+**/
+void set_encoded_json(value& target, std::shared_ptr<const std::string> text);
+
+/** Get the text given to \c set_encoded_json for \a source, or \c nullptr if it has none. **/
+JSONV_PUBLIC const std::string* encoded_json(const value& source);
+
+/** The longest number text which \c make_lazy_number can keep. **/
+static constexpr std::size_t max_lazy_number_length = 28;
+
+/** Create a \c kind::decimal which keeps \a text (a valid JSON number of at most \c max_lazy_number_length characters)
+ *  and only converts it when it is asked for. This is used by \c parse for \c parse_options::numbers::lazy.
+**/
+value make_lazy_number(string_view text);
+
+/** Copy the text \a source was created from by \c make_lazy_number into \a out, which must have room for
+ *  \c max_lazy_number_length characters.
+ *
+ *  \returns the length of the text, or \c 0 if \a source is not a number which kept its text.
+**/
+JSONV_PUBLIC std::size_t lazy_number_text(const value& source, char* out);
+
 }
 
 /** \defgroup Value
@@ -98,6 +158,19 @@ public:
     virtual ~kind_error() noexcept;
 };
 
+namespace detail
+{
+
+/** Throw the \c kind_error for finding a value of the \a actual kind where a value of the \a expected kind is needed.
+ *  This is out of line (and cold), so the inline accessors of \c value are only a comparison and a branch.
+ *  
+ *  \throws kind_error always.
+**/
+JSONV_PUBLIC JSONV_NO_RETURN JSONV_COLD
+void throw_kind_error(kind expected, kind actual);
+
+}
+
 /** Represents a single JSON value, which can be any one of a potential \c kind, each behaving slightly differently.
  *  Instances will vary their behavior based on their kind -- functions will throw a \c kind_error if the operation does
  *  not apply to the value's kind. For example, it does not make sense to call \c find on an \c integer.
@@ -117,8 +190,8 @@ public:
  *     the cases where it makes sense (for example: \c empty and \c size), but in general, string manipulation should be
  *     done after calling \c as_string.
  *   - \c kind::array
- *     An array behaves like a \c std::deque because it is ultimately backed by one. If you feel the documentation is
- *     lacking, read this: http://en.cppreference.com/w/cpp/container/deque.
+ *     An array behaves like a \c std::vector because it is ultimately backed by one. If you feel the documentation is
+ *     lacking, read this: http://en.cppreference.com/w/cpp/container/vector.
  *   - \c kind::object
  *     An object behaves lake a \c std::map because it is ultimately backed by one. If you feel the documentation is
  *     lacking, read this: http://en.cppreference.com/w/cpp/container/map. This library follows the recommendation in
@@ -397,14 +470,31 @@ public:
         TIterator _impl;
     };
     
+    /** The container which holds the entries of a \c kind::object. The nodes of the \c std::map come from the same
+     *  thread-local pool as the rest of the storage of values, so trees which are changed a lot do not fragment the
+     *  global heap.
+     *  
+     *  \see JSONV_OBJECT_FLAT_STORAGE
+    **/
+#if JSONV_OBJECT_FLAT_STORAGE
+    typedef detail::flat_map<std::string, value, detail::object_key_less> object_storage_type;
+#else
+    typedef std::map<std::string,
+                     value,
+                     detail::object_key_less,
+                     detail::node_allocator<std::pair<const std::string, value>>
+                    >
+            object_storage_type;
+#endif
+    
     /** The type of value stored when \c kind is \c kind::object. **/
-    typedef std::pair<const std::string, value>                        object_value_type;
+    typedef object_storage_type::value_type                            object_value_type;
     
     /** The \c object_iterator is applicable when \c kind is \c kind::object. It allows you to use algorithms as if
      *  a \c value was a normal associative container.
     **/
-    typedef basic_object_iterator<object_value_type,       std::map<std::string, value>::iterator>       object_iterator;
-    typedef basic_object_iterator<const object_value_type, std::map<std::string, value>::const_iterator> const_object_iterator;
+    typedef basic_object_iterator<object_value_type,       object_storage_type::iterator>       object_iterator;
+    typedef basic_object_iterator<const object_value_type, object_storage_type::const_iterator> const_object_iterator;
     
     /** If \c kind is \c kind::object, an \c object_view allows you to access a value as an associative container.
      *  This is most useful for range-based for loops.
@@ -441,6 +531,9 @@ public:
     
     /** Create a \c kind::string with the given \a value. **/
     value(const std::string& value);
+    
+    /** Create a \c kind::string which takes over the contents of \a value instead of copying them. **/
+    value(std::string&& value);
 
     /** Create a \c kind::string with the given \a value. **/
     value(const string_view& value);
@@ -502,8 +595,18 @@ public:
     **/
     const std::string& as_string() const;
     
+    /** Take the contents of this string, leaving this value \c null. The characters are moved out unless they are
+     *  shared with another value (or borrowed from the input of a parse), in which case they are copied.
+     *  
+     *  \throws kind_error if this value does not represent a string.
+    **/
+    std::string take_string();
+    
     /** Tests if this \c kind is \c kind::string. **/
-    bool is_string() const;
+    bool is_string() const
+    {
+        return _kind == jsonv::kind::string;
+    }
 
     /** Get this value as a \c string_view. It is your responsibility to ensure the \c value instance remains valid.
      *
@@ -525,7 +628,10 @@ public:
     int64_t as_integer() const;
     
     /** Tests if this \c kind is \c kind::integer. **/
-    bool is_integer() const;
+    bool is_integer() const
+    {
+        return _kind == jsonv::kind::integer;
+    }
     
     /** Get this value as a decimal. If the value's underlying kind is actually an integer type, cast the integer to a
      *  double before returning. This ignores the potential loss of precision.
@@ -535,7 +641,10 @@ public:
     double as_decimal() const;
     
     /** Tests if this \c kind is \c kind::integer or \c kind::decimal. **/
-    bool is_decimal() const;
+    bool is_decimal() const
+    {
+        return _kind == jsonv::kind::decimal || _kind == jsonv::kind::integer;
+    }
     
     /** Get this value as a boolean.
      *  
@@ -544,16 +653,43 @@ public:
     bool as_boolean() const;
     
     /** Tests if this \c kind is \c kind::boolean. **/
-    bool is_boolean() const;
+    bool is_boolean() const
+    {
+        return _kind == jsonv::kind::boolean;
+    }
+    
+    /** Get the contents of this value as a \c T without checking its kind, for code which has already checked it (with
+     *  \c kind or one of the \c is_ functions). \c T is \c int64_t for \c kind::integer, \c double for
+     *  \c kind::decimal, \c bool for \c kind::boolean or \c string_view for \c kind::string. Getting the wrong one is
+     *  undefined behavior, except when \c JSONV_DEBUG is set, where it throws a \c kind_error.
+     *  
+     *  \code
+     *  int64_t total = 0;
+     *  for (const value& x : values.as_array())
+     *      if (x.kind() == kind::integer)
+     *          total += x.get_unchecked<int64_t>();
+     *  \endcode
+    **/
+    template <typename T>
+    T get_unchecked() const;
     
     /** Tests if this \c kind is \c kind::array. **/
-    bool is_array() const;
+    bool is_array() const
+    {
+        return _kind == jsonv::kind::array;
+    }
     
     /** Tests if this \c kind is \c kind::object. **/
-    bool is_object() const;
+    bool is_object() const
+    {
+        return _kind == jsonv::kind::object;
+    }
     
     /** Tests if this \c kind is \c kind::null. **/
-    bool is_null() const;
+    bool is_null() const
+    {
+        return _kind == jsonv::kind::null;
+    }
     
     /** Resets this value to null. **/
     void clear();
@@ -610,6 +746,19 @@ public:
     /** Swap the value this instance represents with \a other. **/
     void swap(value& other) noexcept;
     
+    /** Let copies of this value share its storage (and the storage of everything under it) instead of copying it. After
+     *  this, copying the value takes constant time, no matter how big it is; changing a copy gives only the objects
+     *  and arrays on the path to the change storage of their own, so the other copies do not see it. This is meant
+     *  for handing out snapshots of a large tree which is rarely changed.
+     *  
+     *  Member functions which give out a non-const reference or iterator into an object or array (such as
+     *  \c operator[] and \c begin_object) stop that container from being shared again, so changes made through them
+     *  can never be seen by a copy. References and iterators which were taken \e before calling this must not be used
+     *  to change the value. Since changing a value which shares its storage moves it to a new storage, doing so also
+     *  invalidates the references and iterators into it.
+    **/
+    void make_shareable();
+    
     /** Compares two JSON values for equality. Two JSON values are equal if and only if all of the following conditions
      *  apply:
      *  
@@ -699,12 +848,57 @@ public:
     value& at(size_type idx);
     const value& at(size_type idx) const;
     
+    /** Get a pointer to the first element of this array. The elements are stored contiguously, so the range
+     *  [\c array_data(), \c array_data() + \c size()) can be walked with plain pointers, which is much faster than an
+     *  \c array_iterator for large arrays. Like the references returned from \c operator[], it is invalidated by
+     *  anything which changes the size of the array.
+     *  
+     *  \throws kind_error if the kind is not an array.
+    **/
+    value*       array_data();
+    const value* array_data() const;
+    
+    /** Store the elements of this array packed if they are all integers or all decimals: as a plain buffer of
+     *  \c std::int64_t or \c double, which takes half of the memory of the \c value instances and can be handed to
+     *  numeric code by \c packed_integers or \c packed_decimals. Nothing else changes -- the first time an element is
+     *  looked at, the elements are made into \c value instances again (the buffer is kept, so that also takes memory
+     *  for both). Changing the array drops the buffer, except for adding a number of the same kind with \c push_back.
+     *  
+     *  \returns \c true if the elements are packed; \c false if they are not all integers or all decimals or if there
+     *           are fewer than 8 of them (which take less memory as they are).
+     *  \throws kind_error if the kind is not an array.
+     *  
+     *  \see parse_options::pack_numbers
+    **/
+    bool pack_numbers();
+    
+    /** Get the elements of this array if they are packed as integers (see \c pack_numbers). There are \c size of them
+     *  and they stay valid until the array is changed.
+     *  
+     *  \returns The first element or \c nullptr if this is not an array of packed integers.
+    **/
+    const std::int64_t* packed_integers() const;
+    
+    /** Like \c packed_integers, but for an array of decimals. **/
+    const double* packed_decimals() const;
+    
     /** Push \a item to the back of this array.
      *  
      *  \throws kind_error if the kind is not an array.
     **/
     void push_back(value item);
     
+    /** Add a new element to the back of this array, constructed from \a args.
+     *  
+     *  \returns A reference to the new element.
+     *  \throws kind_error if the kind is not an array.
+    **/
+    template <typename... TArgs>
+    value& emplace_back(TArgs&&... args)
+    {
+        return emplace_back_value(value(std::forward<TArgs>(args)...));
+    }
+    
     /** Pop an item off the back of this array.
      *  
      *  \throws kind_error if the kind is not an array.
@@ -712,7 +906,8 @@ public:
     **/
     void pop_back();
     
-    /** Push \a item to the front of this array.
+    /** Push \a item to the front of this array. This moves every other element, so it takes time linear in the
+     *  size of the array.
      *  
      *  \throws kind_error if the kind is not an array.
     **/
@@ -731,18 +926,24 @@ public:
     **/
     array_iterator insert(const_array_iterator position, value item);
     
-    /** Insert the range defined by [\a first, \a last) at \a position in this array.
+    /** Insert the range defined by [\a first, \a last) at \a position in this array. The elements are appended and
+     *  then rotated into place, so this takes time linear in the size of the array and the range. Use an
+     *  \c std::move_iterator to move the elements in instead of copying them.
      *  
      *  \throws kind_error if the kind is not an array.
     **/
     template <typename TForwardIterator>
     array_iterator insert(const_array_iterator position, TForwardIterator first, TForwardIterator last)
     {
-        difference_type orig_offset = std::distance(const_array_iterator(begin_array()), position);
+        difference_type offset   = std::distance(const_array_iterator(begin_array()), position);
+        size_type       old_size = size();
         
-        for (difference_type offset = orig_offset ; first != last; ++first, ++offset)
-            insert(begin_array() + offset, *first);
-        return begin_array() + orig_offset;
+        reserve(old_size + size_type(std::distance(first, last)));
+        for ( ; first != last; ++first)
+            emplace_back_value(value(*first));
+        value* data = array_data();
+        std::rotate(data + offset, data + old_size, data + size());
+        return begin_array() + offset;
     }
     
     /** Assign \a count elements to this array with \a val.
@@ -781,6 +982,14 @@ public:
     **/
     void resize(size_type count, const value& val = value());
     
+    /** Make room for at least \a count elements in this array or entries in this object, so adding that many does not
+     *  allocate again. This does nothing for objects unless \c JSONV_OBJECT_FLAT_STORAGE is set, since the nodes of an
+     *  \c std::map can not be allocated ahead of time.
+     *  
+     *  \throws kind_error if the kind is not an array or object.
+    **/
+    void reserve(size_type count);
+    
     /** Erase the item at this array's \a position.
      * 
      *  \throws kind_error if the kind is not an array.
@@ -819,34 +1028,41 @@ public:
      *  
      *  \throws kind_error if the kind is not an object.
     **/
-    value& operator[](const std::string& key);
+    value& operator[](string_view key);
     value& operator[](std::string&& key);
     value& operator[](const std::wstring& key);
     
+    /** This is a template so that \c x[0] still picks the array overload. **/
+    template <typename TChar, typename = typename std::enable_if<std::is_same<TChar, char>::value>::type>
+    value& operator[](const TChar* key)
+    {
+        return (*this)[string_view(key)];
+    }
+    
     /** Get the value associated with the given \a key of this object.
      *  
      *  \throws kind_error if the kind is not an object.
      *  \throws std::out_of_range if the \a key is not in this object.
     **/
-    value& at(const std::string& key);
+    value& at(string_view key);
     value& at(const std::wstring& key);
-    const value& at(const std::string& key) const;
+    const value& at(string_view key) const;
     const value& at(const std::wstring& key) const;
     
     /** Check if the given \a key exists in this object.
      *  
      *  \throws kind_error if the kind is not an object.
     **/
-    size_type count(const std::string& key) const;
+    size_type count(string_view key) const;
     size_type count(const std::wstring& key) const;
     
     /** Attempt to locate a key-value pair with the provided \a key in this object.
      *  
      *  \throws kind_error if the kind is not an object.
     **/
-    object_iterator       find(const std::string& key);
+    object_iterator       find(string_view key);
     object_iterator       find(const std::wstring& key);
-    const_object_iterator find(const std::string& key)  const;
+    const_object_iterator find(string_view key)  const;
     const_object_iterator find(const std::wstring& key) const;
     
     /// \{
@@ -859,14 +1075,22 @@ public:
     object_iterator insert(const_object_iterator hint, std::pair<std::string, value>  pair);
     object_iterator insert(const_object_iterator hint, std::pair<std::wstring, value> pair);
     
-    /// Insert range defined by [\a first, \a last) into this object.
+    /// Insert range defined by [\a first, \a last) into this object. Each entry is added at the end of the object
+    /// first, so a range which is already in key order (such as the entries of another object) is inserted in linear
+    /// time. The entries are moved from if the range is of rvalues (such as through an \c std::move_iterator).
     ///
     /// \throws kind_error if the kind is not an object.
     template <typename TForwardIterator>
     void insert(TForwardIterator first, TForwardIterator last)
     {
         for ( ; first != last; ++first)
-            insert(*first);
+        {
+            auto&& entry = *first;
+            emplace_hint(end_object(),
+                         std::forward<decltype(entry)>(entry).first,
+                         std::forward<decltype(entry)>(entry).second
+                        );
+        }
     }
 
     /// Insert the contents of \a handle. If \a handle is empty, this does nothing.
@@ -896,12 +1120,32 @@ public:
     void insert(std::initializer_list<std::pair<std::wstring, value>> items);
     /// \}
     
+    /// \{
+    /// Add an entry to this object with the given \a key and a value constructed from \a args, without building an
+    /// \c object_value_type first. If there is already an entry with the \a key, the object is not changed. If a
+    /// \a hint is given and the entry belongs right before it, this takes amortized constant time.
+    ///
+    /// \returns The entry with the \a key and (for the version without a hint) whether it was added.
+    /// \throws kind_error if the kind is not an object.
+    template <typename... TArgs>
+    std::pair<object_iterator, bool> emplace(std::string key, TArgs&&... args)
+    {
+        return emplace_entry(std::move(key), value(std::forward<TArgs>(args)...));
+    }
+    
+    template <typename... TArgs>
+    object_iterator emplace_hint(const_object_iterator hint, std::string key, TArgs&&... args)
+    {
+        return emplace_entry(hint, std::move(key), value(std::forward<TArgs>(args)...));
+    }
+    /// \}
+    
     /// \{
     /// Erase the item with the given \a key.
     ///
     /// \returns 1 if \a key was erased; 0 if it did not.
     /// \throws kind_error if the kind is not an object.
-    size_type erase(const std::string&  key);
+    size_type erase(string_view         key);
     size_type erase(const std::wstring& key);
     
     /// Erase the item at the given \a position.
@@ -983,15 +1227,90 @@ public:
     
     /** \} **/
     
+private:
+    value& emplace_back_value(value&& item);
+    std::pair<object_iterator, bool> emplace_entry(std::string&& key, value&& item);
+    object_iterator emplace_entry(const_object_iterator hint, std::string&& key, value&& item);
+    
+    /** Convert the text of a number from \c detail::make_lazy_number. **/
+    double lazy_decimal() const;
+    
 private:
     friend JSONV_PUBLIC value array();
     friend JSONV_PUBLIC value object();
+    friend value detail::make_borrowed_string(string_view, std::shared_ptr<const void>);
+    friend void detail::set_encoded_json(value&, std::shared_ptr<const std::string>);
+    friend const std::string* detail::encoded_json(const value&);
+    friend value detail::make_lazy_number(string_view);
+    friend std::size_t detail::lazy_number_text(const value&, char*);
+    friend struct std::hash<value>;
+    friend class detail::reusable_storage;
+    friend class canonical_encoder;
+    friend JSONV_PUBLIC memory_breakdown memory_usage(const value&);
     
 private:
     detail::value_storage _data;
     jsonv::kind           _kind;
+    // The text of a number from detail::make_lazy_number is packed 4 bits to a character into _data and _text (which
+    // would otherwise be padding), so the value does not depend on the parsed text. _text_size is 0 for other values.
+    std::uint8_t          _text_size = 0;
+    std::uint8_t          _text[6]   = {};
 };
 
+inline int64_t value::as_integer() const
+{
+    if (_kind != jsonv::kind::integer)
+        detail::throw_kind_error(jsonv::kind::integer, _kind);
+    return _data.integer;
+}
+
+inline double value::as_decimal() const
+{
+    if (_kind == jsonv::kind::decimal)
+        return _text_size ? lazy_decimal() : _data.decimal;
+    else if (_kind == jsonv::kind::integer)
+        return double(_data.integer);
+    else
+        detail::throw_kind_error(jsonv::kind::decimal, _kind);
+}
+
+inline bool value::as_boolean() const
+{
+    if (_kind != jsonv::kind::boolean)
+        detail::throw_kind_error(jsonv::kind::boolean, _kind);
+    return _data.boolean;
+}
+
+template <>
+inline int64_t value::get_unchecked<int64_t>() const
+{
+    if (JSONV_DEBUG && _kind != jsonv::kind::integer)
+        detail::throw_kind_error(jsonv::kind::integer, _kind);
+    return _data.integer;
+}
+
+template <>
+inline double value::get_unchecked<double>() const
+{
+    if (JSONV_DEBUG && _kind != jsonv::kind::decimal)
+        detail::throw_kind_error(jsonv::kind::decimal, _kind);
+    return _text_size ? lazy_decimal() : _data.decimal;
+}
+
+template <>
+inline bool value::get_unchecked<bool>() const
+{
+    if (JSONV_DEBUG && _kind != jsonv::kind::boolean)
+        detail::throw_kind_error(jsonv::kind::boolean, _kind);
+    return _data.boolean;
+}
+
+/** The characters of a string live in storage which is not visible here (it might be borrowed from the parsed text), so
+ *  this one is not inline.
+**/
+template <>
+string_view value::get_unchecked<string_view>() const;
+
 /** An instance with \c kind::null. This is intended to be used for convenience and readability (as opposed to using the
  *  default constructor of \c value.
 **/
@@ -1104,11 +1423,13 @@ namespace std
 {
 
 /** Explicit specialization of \c std::hash for \c jsonv::value types so you can store a \c value in an unordered
- *  container. Hashing results depend on the \c kind for the provided value -- most kinds directly use the hasher for
- *  their kind (hashing a \c jsonv::value for integer \c 5 should have the same hash value as directly hashing the same
- *  integer). For aggregate kinds \c array and \c object, hashing visits every sub-element recursively. This might be
- *  expensive, but is required when storing multiple values with similar layouts in the a set (which is the most common
- *  use case).
+ *  container. Values which compare equal hash the same (so integer \c 5 and decimal \c 5.0 do); the hash of an
+ *  \c array or \c object depends on the order of its elements and mixes the keys and values of objects together, so
+ *  containers with the same members in different places do not collide.
+ *  
+ *  For aggregate kinds \c array and \c object, hashing visits every sub-element recursively. If the value has been
+ *  through \c value::make_shareable, the hash of each container is remembered until it is next changed, so hashing the
+ *  same (or a shared copy of the same) tree again is constant-time.
 **/
 template <>
 struct JSONV_PUBLIC hash<jsonv::value>
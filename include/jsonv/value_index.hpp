@@ -0,0 +1,128 @@
+/** \file jsonv/value_index.hpp
+ *  A hash index over the elements of an array of objects, for looking elements up by the values of their fields.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_VALUE_INDEX_HPP_INCLUDED__
+#define __JSONV_VALUE_INDEX_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/compiled_path.hpp>
+#include <jsonv/path.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace jsonv
+{
+
+/** An index over the elements of an array (usually an array of objects), keyed by the values found at one or more
+ *  \c path s into each element. Looking up the elements with a given key is a single hash lookup instead of a scan of
+ *  the whole array.
+ *
+ *  \code
+ *  jsonv::value_index by_sku(catalog, jsonv::path::create(".sku"));
+ *  std::size_t idx = by_sku.find("A-1234");
+ *  if (idx != jsonv::value_index::npos)
+ *      std::cout << catalog[idx] << std::endl;
+ *  \endcode
+ *
+ *  With a single key path, the key of an element is the value at that path. With several, it is an array of the values
+ *  at each of the paths (in order), so lookups are done with an array too. Elements which do not have a value at
+ *  every key path are not indexed.
+ *
+ *  The index refers to the array it was built over, which must outlive it. It does not see changes to the array by
+ *  itself -- tell it about them with \c insert, \c erase and \c update (or start over with \c rebuild). Appending to
+ *  the array and updating elements take constant time; inserting or erasing anywhere else has to renumber the elements
+ *  after it, which takes linear time.
+**/
+class JSONV_PUBLIC value_index
+{
+public:
+    using size_type = std::size_t;
+
+    /** Returned from \c find when there is no element with the key. **/
+    static constexpr size_type npos = size_type(-1);
+
+public:
+    /** Index the elements of the array \a source by the value at \a key_path.
+     *
+     *  \throws kind_error if \a source is not an array.
+    **/
+    value_index(const value& source, const path& key_path);
+
+    /** Index the elements of the array \a source by the values at \a key_paths.
+     *
+     *  \throws kind_error if \a source is not an array.
+     *  \throws std::invalid_argument if \a key_paths is empty.
+    **/
+    value_index(const value& source, const std::vector<path>& key_paths);
+
+    value_index(const value_index&) = delete;
+    value_index& operator=(const value_index&) = delete;
+
+    value_index(value_index&&) = default;
+    value_index& operator=(value_index&&) = default;
+
+    /** The number of distinct keys in the index. **/
+    size_type size() const;
+
+    /** Get the index of the first element of the array with the given \a key.
+     *
+     *  \returns The index of the element or \c npos if no element has \a key.
+    **/
+    size_type find(const value& key) const;
+
+    /** Get the indexes of every element of the array with the given \a key, in increasing order. **/
+    const std::vector<size_type>& find_all(const value& key) const;
+
+    /** Get the number of elements of the array with the given \a key. **/
+    size_type count(const value& key) const;
+
+    /** Get the key of the element at \a idx, as it was when the index last saw it.
+     *
+     *  \returns A pointer to the key or \c nullptr if the element is not indexed.
+    **/
+    const value* key_of(size_type idx) const;
+
+    /** Tell the index that an element was inserted into the array at \a idx. **/
+    void insert(size_type idx);
+
+    /** Tell the index that the element at \a idx was erased from the array. **/
+    void erase(size_type idx);
+
+    /** Tell the index that the element at \a idx was changed. **/
+    void update(size_type idx);
+
+    /** Index the whole array again from the start. **/
+    void rebuild();
+
+private:
+    using entry_map = std::unordered_map<value, std::vector<size_type>>;
+    using entry     = entry_map::value_type;
+
+    /** Get the key of \a element into \a out. Returns \c false if the element does not have one. **/
+    bool element_key(const value& element, value& out) const;
+
+    void add(size_type idx);
+
+    void remove(size_type idx);
+
+private:
+    const value*               _source;
+    std::vector<compiled_path> _key_paths;
+    entry_map                  _entries;
+    std::vector<entry*>        _element_entries; //!< The entry for each element of the array (\c nullptr if none)
+};
+
+}
+
+#endif/*__JSONV_VALUE_INDEX_HPP_INCLUDED__*/
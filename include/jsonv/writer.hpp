@@ -0,0 +1,158 @@
+/** \file jsonv/writer.hpp
+ *  Writing a JSON document to an \c encoder a piece at a time, without building a \c value first.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_WRITER_HPP_INCLUDED__
+#define __JSONV_WRITER_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/forward.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace jsonv
+{
+
+/** Writes a single JSON document to an \c encoder one piece at a time. The \c writer keeps track of which objects and
+ *  arrays are open and writes the delimiters between their elements, so the output is produced as it is generated and
+ *  does not need to fit in memory as a \c value.
+ *
+ *  Every call is checked against the structure written so far: writing a value in an object without a \c key first,
+ *  closing an array with \c end_object, writing a \c key outside of an object or writing anything after the document
+ *  is \c complete throws \c std::logic_error without writing anything.
+ *
+ *  \example "writer"
+ *  \code
+ *  jsonv::ostream_encoder encoder(std::cout);
+ *  jsonv::writer out(encoder);
+ *  out.begin_object();
+ *  out.key("rows").begin_array();
+ *  while (cursor.next())
+ *  {
+ *      out.begin_object();
+ *      out.key("id").value(cursor.id());
+ *      out.key("name").value(cursor.name());
+ *      out.end_object();
+ *  }
+ *  out.end_array();
+ *  out.end_object();
+ *  \endcode
+**/
+class JSONV_PUBLIC writer
+{
+public:
+    /** Create an instance which writes to \a out. The \a out encoder must outlive this instance. **/
+    explicit writer(encoder& out);
+
+    writer(const writer&) = delete;
+    writer& operator=(const writer&) = delete;
+
+    ~writer() noexcept;
+
+    writer& begin_object();
+
+    /** \throws std::logic_error if the innermost open value is not an object or a \c key was written without a value
+     *   following it.
+    **/
+    writer& end_object();
+
+    writer& begin_array();
+
+    /** \throws std::logic_error if the innermost open value is not an array. **/
+    writer& end_array();
+
+    /** Write the \a key for the next value in the current object.
+     *
+     *  \throws std::logic_error if the innermost open value is not an object or the previous \c key has not been given a
+     *   value yet.
+    **/
+    writer& key(string_view key);
+
+    /** Write an entire \c value in the current position. **/
+    writer& value(const jsonv::value& value);
+
+    writer& value(std::nullptr_t);
+
+    writer& value(bool value);
+
+    writer& value(string_view value);
+
+    writer& value(const std::string& value);
+
+    writer& value(const char* value);
+
+    template <typename TInteger>
+    typename std::enable_if<std::is_integral<TInteger>::value && !std::is_same<TInteger, bool>::value, writer&>::type
+    value(TInteger value)
+    {
+        return write_integer(static_cast<std::int64_t>(value));
+    }
+
+    template <typename TDecimal>
+    typename std::enable_if<std::is_floating_point<TDecimal>::value, writer&>::type
+    value(TDecimal value)
+    {
+        return write_decimal(static_cast<double>(value));
+    }
+
+    /** Write \c null in the current position. **/
+    writer& null();
+
+    /** Write a value in the current position by calling \a write with the underlying \c encoder. This is for code which
+     *  writes to an \c encoder on its own (like \c serializer::encode). \a write must write exactly one value.
+    **/
+    template <typename FWrite>
+    writer& value_with(FWrite&& write)
+    {
+        before_value();
+        write(_out);
+        after_value();
+        return *this;
+    }
+
+    /** The number of objects and arrays which are currently open. **/
+    std::size_t depth() const;
+
+    /** Has an entire document been written? **/
+    bool complete() const;
+
+private:
+    struct frame
+    {
+        bool object;    //!< Is this an object (as opposed to an array)?
+        bool empty;     //!< Have no elements been written yet?
+        bool has_key;   //!< For objects: has the key for the next value been written?
+    };
+
+private:
+    writer& write_integer(std::int64_t value);
+    writer& write_decimal(double value);
+    writer& write_string(string_view value);
+
+    /** Check that a value can be written here and write the delimiter before it if one is needed. **/
+    void before_value();
+
+    /** Note that a value (or the end of an object or array) has been written here. **/
+    void after_value();
+
+private:
+    encoder&           _out;
+    std::vector<frame> _stack;
+    bool               _complete;
+};
+
+}
+
+#endif/*__JSONV_WRITER_HPP_INCLUDED__*/
@@ -0,0 +1,49 @@
+/** \file
+ *  
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "core.hpp"
+
+// Boost.JSON is built into this file rather than linked, so it works with Boost installs which do not have the
+// compiled library (and it must only be included by one file of the program)
+#include <boost/json/src.hpp>
+
+#include <string>
+
+namespace json_benchmark
+{
+
+class boost_json_benchmark_suite :
+        public typed_benchmark_suite<boost::json::value>
+{
+public:
+    boost_json_benchmark_suite() :
+            typed_benchmark_suite<boost::json::value>("Boost.JSON")
+    { }
+    
+    virtual bool encode_test(const value_ptr& value, bool pretty) const override
+    {
+        // Boost.JSON has no pretty printer
+        if (pretty)
+            return false;
+        
+        std::string out = boost::json::serialize(*std::static_pointer_cast<const boost::json::value>(value));
+        static_cast<void>(out);
+        return true;
+    }
+    
+protected:
+    virtual boost::json::value parse(const std::string& source) const
+    {
+        return boost::json::parse(source);
+    }
+    
+} boost_json_benchmark_suite_instance;
+
+}
@@ -39,4 +39,22 @@ benchmark_suite::benchmark_suite(std::string name) :
 benchmark_suite::~benchmark_suite() noexcept
 { }
 
+bool benchmark_suite::encode_test(const value_ptr&, bool) const
+{
+    return false;
+}
+
+bool benchmark_suite::extract_test(const value_ptr&) const
+{
+    return false;
+}
+
+benchmark_suite::value_ptr benchmark_suite::create_records(const value_ptr&) const
+{
+    return nullptr;
+}
+
+void benchmark_suite::to_json_test(const value_ptr&) const
+{ }
+
 }
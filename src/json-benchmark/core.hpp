@@ -41,6 +41,38 @@ public:
     
     virtual value_ptr create_value(const std::string& source) const = 0;
     
+    /** Encode \a value (from \c create_value) as JSON text, either compact or \a pretty.
+     *  
+     *  \returns \c false if this suite does not support encoding. The default implementation does not.
+    **/
+    virtual bool encode_test(const value_ptr& value, bool pretty) const;
+    
+    /** Convert \a records (from \c create_value) into the C++ structures of this suite. The document is an array of
+     *  orders, each of which looks like:
+     *  
+     *  \code
+     *  {
+     *    "id": 1042,
+     *    "customer": { "name": "aaaa", "email": "aaaa@example.com" },
+     *    "total": 51.5,
+     *    "paid": true,
+     *    "items": [ { "sku": "aaaaaaaa", "quantity": 3, "price": 17.25 } ],
+     *    "tags": [ "aaa", "aaaaa" ]
+     *  }
+     *  \endcode
+     *  
+     *  \returns \c false if this suite does not support extraction. The default implementation does not.
+    **/
+    virtual bool extract_test(const value_ptr& records) const;
+    
+    /** Create the C++ structures \c extract_test would for \a records, which are the input to \c to_json_test. The
+     *  default implementation returns \c nullptr, meaning \c to_json_test is not supported.
+    **/
+    virtual value_ptr create_records(const value_ptr& records) const;
+    
+    /** Convert the structures in \a records (from \c create_records) back into values of this suite. **/
+    virtual void to_json_test(const value_ptr& records) const;
+    
 private:
     std::string _name;
 };
@@ -0,0 +1,508 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "generator.hpp"
+
+#include <jsonv/encode.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace json_benchmark
+{
+
+using namespace jsonv;
+
+namespace
+{
+
+static const char* const common_words[] =
+{
+    "the", "request", "failed", "user", "session", "started", "completed", "with", "error", "cache", "miss", "for",
+    "connection", "timeout", "after", "retry", "payment", "accepted", "order", "shipped", "to", "from", "new",
+    "account", "created", "invalid", "token", "refreshed", "upstream", "returned", "queue", "depth", "is", "high",
+    "worker", "restarted", "config", "reloaded", "and", "of", "in", "on", "at", "disk", "usage", "above", "limit",
+};
+
+static const char* const non_ascii_words[] =
+{
+    "café", "naïve", "Zürich", "São", "Paulo", "Ærøskøbing", "façade", "東京", "数据", "Привет", "Ελλάδα", "שלום",
+    "مرحبا", "→", "—", "€", "😀", "🚀", "✓",
+};
+
+static const char* const escaped_characters[] = { "\"", "\\", "\n", "\t", "\r", "\x01", "\x1f" };
+
+static const char* const common_keys[] =
+{
+    "id", "name", "type", "status", "created_at", "updated_at", "user_id", "email", "description", "tags", "value",
+    "count", "enabled", "url", "message", "level", "timestamp", "host", "service", "version", "data", "items",
+    "total", "price", "currency", "label", "key", "parent_id", "owner", "source", "target", "score", "metadata",
+    "attributes", "children", "title", "path", "size", "duration_ms", "region",
+};
+
+static const char* const first_names[] =
+{
+    "Alice", "Bob", "Carlos", "Dmitri", "Eun-ji", "Fatima", "Günther", "Hiroshi", "Ingrid", "José", "Kwame", "Léa",
+    "Mei", "Nikolai", "Olúwadámilọ́lá", "Priya", "Quentin", "Renée", "Søren", "Tomás",
+};
+
+static const char* const last_names[] =
+{
+    "Anderson", "Brown", "Chen", "Dubois", "Eriksson", "Fernández", "García", "Hernández", "Ivanov", "Jäger", "Kim",
+    "López", "Müller", "Nakamura", "O'Brien", "Petrov", "Rossi", "Smith", "Takahashi", "Żeromski",
+};
+
+static const char* const cities[] =
+{
+    "Portland", "Reykjavík", "München", "Montréal", "São Paulo", "Kraków", "Tokyo", "Zürich", "Austin", "Lagos",
+};
+
+static const char* const services[] = { "api-gateway", "auth", "billing", "search", "inventory", "notifications" };
+static const char* const log_levels[] = { "DEBUG", "INFO", "INFO", "INFO", "INFO", "WARN", "ERROR" };
+static const char* const currencies[] = { "USD", "EUR", "JPY", "GBP", "BRL" };
+static const char* const roles[]      = { "admin", "editor", "viewer", "billing", "support" };
+static const char* const categories[] = { "park", "school", "river", "road", "building", "boundary", "lake" };
+static const char* const countries[]  = { "US", "DE", "CA", "BR", "PL", "JP", "CH", "NG", "IS" };
+
+static const std::int64_t http_statuses[] = { 200, 200, 200, 200, 201, 204, 301, 304, 400, 401, 404, 429, 500, 503 };
+
+/** Produces everything random about a document. Only the output of \c std::mt19937_64 is used, since it is the same
+ *  everywhere (unlike the standard distributions).
+**/
+class generator
+{
+public:
+    explicit generator(const generator_settings& settings) :
+            _settings(settings),
+            _rng(settings.seed)
+    { }
+
+    value document()
+    {
+        switch (_settings.shape)
+        {
+        case document_shape::logs:
+            return records([this] { return log_record(); });
+        case document_shape::api:
+            return api_response();
+        case document_shape::geojson:
+            return object({ { "type", "FeatureCollection" }, { "features", records([this] { return feature(); }) } });
+        case document_shape::random:
+        default:
+            return random_document();
+        }
+    }
+
+private:
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Randomness                                                                                                     //
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /** A number in <tt>[0, count)</tt>. **/
+    std::size_t below(std::size_t count)
+    {
+        return static_cast<std::size_t>(_rng() % count);
+    }
+
+    std::int64_t between(std::int64_t low, std::int64_t high)
+    {
+        return low + static_cast<std::int64_t>(_rng() % static_cast<std::uint64_t>(high - low + 1));
+    }
+
+    /** A number in <tt>[0, 1)</tt>. **/
+    double unit()
+    {
+        return static_cast<double>(_rng() >> 11) / 9007199254740992.0;
+    }
+
+    double real(double low, double high)
+    {
+        return low + (high - low) * unit();
+    }
+
+    bool chance(double probability)
+    {
+        return unit() < probability;
+    }
+
+    /** A geometrically-distributed count with the given \a mean. **/
+    std::size_t geometric(double mean)
+    {
+        if (mean <= 0.0)
+            return 0;
+        double p = 1.0 / (mean + 1.0);
+        return static_cast<std::size_t>(std::floor(std::log(1.0 - unit()) / std::log(1.0 - p)));
+    }
+
+    template <typename T, std::size_t N>
+    T pick(const T (&values)[N])
+    {
+        return values[below(N)];
+    }
+
+    static double round_to(double x, int digits)
+    {
+        double scale = std::pow(10.0, digits);
+        return std::round(x * scale) / scale;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Scalars                                                                                                        //
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    std::string sentence(std::size_t words)
+    {
+        std::string out;
+        for (std::size_t idx = 0; idx < words; ++idx)
+        {
+            if (idx > 0)
+                out += ' ';
+            out += chance(_settings.non_ascii_fraction) ? pick(non_ascii_words) : pick(common_words);
+            if (chance(_settings.escape_fraction))
+                out += pick(escaped_characters);
+        }
+        return out;
+    }
+
+    std::string key()
+    {
+        std::string out = pick(common_keys);
+        if (chance(_settings.unusual_key_fraction))
+        {
+            out += '_';
+            out += pick(common_words);
+            out += '_';
+            out += std::to_string(below(100));
+        }
+        return out;
+    }
+
+    std::string hex(std::size_t digits)
+    {
+        static const char digit_chars[] = "0123456789abcdef";
+        std::string out(digits, '0');
+        for (char& c : out)
+            c = digit_chars[below(16)];
+        return out;
+    }
+
+    std::string timestamp()
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof buffer, "2018-%02d-%02dT%02d:%02d:%02d.%03dZ",
+                      int(between(1, 12)), int(between(1, 28)), int(between(0, 23)), int(between(0, 59)),
+                      int(between(0, 59)), int(between(0, 999))
+                     );
+        return buffer;
+    }
+
+    std::string person_name()
+    {
+        return std::string(pick(first_names)) + " " + pick(last_names);
+    }
+
+    std::int64_t integer()
+    {
+        double which = unit();
+        if (which < 0.50)
+            return between(0, 100);
+        else if (which < 0.75)
+            return between(1000, 10000000);
+        else if (which < 0.90)
+            return between(1500000000000, 1550000000000);
+        else if (which < 0.95)
+            return -between(1, 1000);
+        else
+            return static_cast<std::int64_t>(_rng() >> 1);
+    }
+
+    double decimal()
+    {
+        double which = unit();
+        if (which < 0.35)
+            return price();
+        else if (which < 0.65)
+            return round_to(real(-500.0, 500.0), int(between(1, 3)));
+        else if (which < 0.85)
+            return unit();
+        else
+            return real(1.0, 10.0) * std::pow(10.0, double(between(-20, 20)));
+    }
+
+    double price()
+    {
+        return round_to(real(0.5, 500.0), 2);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Shapes                                                                                                         //
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /** An array of whatever \a make_record returns, until the array is as long as the target. **/
+    template <typename FMakeRecord>
+    value records(FMakeRecord make_record)
+    {
+        value       out   = array();
+        std::size_t bytes = 2;
+        while (bytes < _settings.target_bytes)
+        {
+            out.push_back(make_record());
+            bytes += encoded_size(out[out.size() - 1], false) + 1;
+        }
+        return out;
+    }
+
+    value log_record()
+    {
+        value attributes = object();
+        for (std::size_t count = below(5); count > 0; --count)
+            attributes[key()] = chance(0.5) ? value(sentence(1 + below(3))) : value(integer());
+
+        return object({
+                        { "timestamp",  timestamp() },
+                        { "level",      pick(log_levels) },
+                        { "service",    pick(services) },
+                        { "host",       "web-" + std::to_string(below(40)) + ".us-east-1.internal" },
+                        { "request_id", hex(32) },
+                        { "status",     pick(http_statuses) },
+                        { "latency_ms", round_to(std::exp(real(0.0, 8.0)), 3) },
+                        { "message",    sentence(4 + below(20)) },
+                        { "attributes", std::move(attributes) },
+                      });
+    }
+
+    value user()
+    {
+        value tags = array();
+        for (std::size_t count = geometric(2.0); count > 0; --count)
+            tags.push_back(pick(common_words));
+
+        value user_roles = array();
+        for (std::size_t count = 1 + below(3); count > 0; --count)
+            user_roles.push_back(pick(roles));
+
+        value orders = array();
+        for (std::size_t order_count = geometric(1.5); order_count > 0; --order_count)
+        {
+            value  items = array();
+            double total = 0.0;
+            for (std::size_t item_count = 1 + geometric(2.0); item_count > 0; --item_count)
+            {
+                double item_price = price();
+                auto   quantity   = between(1, 5);
+                total += item_price * double(quantity);
+                items.push_back(object({ { "sku",      "SKU-" + hex(8) },
+                                         { "quantity", quantity },
+                                         { "price",    item_price },
+                                       }));
+            }
+            orders.push_back(object({ { "id",       integer() },
+                                      { "total",    round_to(total, 2) },
+                                      { "currency", pick(currencies) },
+                                      { "items",    std::move(items) },
+                                    }));
+        }
+
+        std::string name = person_name();
+        std::string email;
+        for (char c : name)
+            if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z'))
+                email += char(c | 0x20);
+        email += "@example.com";
+
+        return object({
+                        { "id",         between(1, 10000000) },
+                        { "uuid",       hex(8) + "-" + hex(4) + "-" + hex(4) + "-" + hex(4) + "-" + hex(12) },
+                        { "name",       std::move(name) },
+                        { "email",      std::move(email) },
+                        { "active",     chance(0.8) },
+                        { "created_at", timestamp() },
+                        { "score",      round_to(real(0.0, 100.0), 2) },
+                        { "bio",        chance(0.3) ? value(null) : value(sentence(5 + below(30))) },
+                        { "roles",      std::move(user_roles) },
+                        { "tags",       std::move(tags) },
+                        { "address",
+                          object({ { "street",      std::to_string(between(1, 9999)) + " " + pick(last_names) + " St" },
+                                   { "city",        pick(cities) },
+                                   { "postal_code", std::to_string(between(10000, 99999)) },
+                                   { "country",     pick(countries) },
+                                   { "location",    object({ { "lat", round_to(real(-90.0, 90.0), 6) },
+                                                             { "lng", round_to(real(-180.0, 180.0), 6) },
+                                                           })
+                                   },
+                                 })
+                        },
+                        { "orders",     std::move(orders) },
+                      });
+    }
+
+    value api_response()
+    {
+        value       data  = records([this] { return user(); });
+        std::size_t count = data.size();
+        return object({
+                        { "data",  std::move(data) },
+                        { "meta",  object({ { "page",         1 },
+                                            { "per_page",     count },
+                                            { "total",        count * 12 },
+                                            { "generated_at", timestamp() },
+                                          })
+                        },
+                        { "links", object({ { "self", "https://api.example.com/v2/users?page=1" },
+                                            { "next", "https://api.example.com/v2/users?page=2" },
+                                          })
+                        },
+                      });
+    }
+
+    /** A walk of \a count points starting near (\a lon, \a lat), with the usual 6 digits of precision. **/
+    value coordinates(std::size_t count, double lon, double lat, bool close)
+    {
+        value out = array();
+        for (std::size_t idx = 0; idx < count; ++idx)
+        {
+            lon += real(-0.01, 0.01);
+            lat += real(-0.01, 0.01);
+            out.push_back(array({ round_to(lon, 6), round_to(lat, 6) }));
+        }
+        if (close && count > 0)
+            out.push_back(out[0]);
+        return out;
+    }
+
+    value feature()
+    {
+        double lon  = real(-180.0, 180.0);
+        double lat  = real(-85.0, 85.0);
+        double kind = unit();
+
+        value geometry;
+        if (kind < 0.4)
+            geometry = object({ { "type", "Point" },
+                                { "coordinates", array({ round_to(lon, 6), round_to(lat, 6) }) },
+                              });
+        else if (kind < 0.7)
+            geometry = object({ { "type", "LineString" },
+                                { "coordinates", coordinates(2 + geometric(20.0), lon, lat, false) },
+                              });
+        else
+            geometry = object({ { "type", "Polygon" },
+                                { "coordinates", array({ coordinates(3 + geometric(40.0), lon, lat, true) }) },
+                              });
+
+        value properties = object({ { "name",     std::string(pick(cities)) + " " + pick(categories) },
+                                    { "category", pick(categories) },
+                                  });
+        if (chance(0.5))
+            properties["population"] = between(100, 5000000);
+        if (chance(0.3))
+            properties["area_km2"] = round_to(real(0.1, 1000.0), 3);
+        if (chance(0.2))
+            properties["note"] = sentence(3 + below(10));
+
+        return object({ { "type",       "Feature" },
+                        { "id",         integer() },
+                        { "geometry",   std::move(geometry) },
+                        { "properties", std::move(properties) },
+                      });
+    }
+
+    value random_value(std::size_t depth)
+    {
+        bool   containers = depth < _settings.max_depth;
+        double which      = unit();
+        if (depth < 2 || (containers && which < 0.15))
+        {
+            value out = object();
+            for (std::size_t count = 1 + geometric(6.0); count > 0; --count)
+                out[key()] = random_value(depth + 1);
+            return out;
+        }
+        else if (containers && which < 0.30)
+        {
+            value out = array();
+            for (std::size_t count = geometric(_settings.mean_array_length); count > 0; --count)
+                out.push_back(random_value(depth + 1));
+            return out;
+        }
+        else if (which < 0.60)
+        {
+            return chance(0.2) ? timestamp() : sentence(1 + geometric(6.0));
+        }
+        else if (which < 0.85)
+        {
+            return chance(_settings.integer_fraction) ? value(integer()) : value(decimal());
+        }
+        else if (which < 0.95)
+        {
+            return chance(0.5);
+        }
+        else
+        {
+            return null;
+        }
+    }
+
+    value random_document()
+    {
+        value       out   = object();
+        std::size_t bytes = 2;
+        while (bytes < _settings.target_bytes)
+        {
+            std::string name  = key() + "_" + std::to_string(out.size());
+            value&      child = out[name];
+            child = random_value(1);
+            bytes += name.size() + encoded_size(child, false) + 4;
+        }
+        return out;
+    }
+
+private:
+    const generator_settings& _settings;
+    std::mt19937_64           _rng;
+};
+
+}
+
+document_shape parse_document_shape(const std::string& name)
+{
+    const auto& names = document_shape_names();
+    for (std::size_t idx = 0; idx < names.size(); ++idx)
+        if (names[idx] == name)
+            return static_cast<document_shape>(idx);
+    throw std::invalid_argument("Unknown document shape \"" + name + "\"");
+}
+
+const std::vector<std::string>& document_shape_names()
+{
+    static const std::vector<std::string> names = { "random", "logs", "api", "geojson" };
+    return names;
+}
+
+value generate_document(const generator_settings& settings)
+{
+    return generator(settings).document();
+}
+
+std::string generate_encoded(const generator_settings& settings, bool pretty)
+{
+    value              doc = generate_document(settings);
+    std::ostringstream encoded;
+    if (pretty)
+        ostream_pretty_encoder(encoded).encode(doc);
+    else
+        ostream_encoder(encoded).encode(doc);
+    return encoded.str();
+}
+
+}
@@ -0,0 +1,96 @@
+/** \file
+ *  Generation of benchmark documents which look like the JSON real programs see.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSON_BENCHMARK_GENERATOR_HPP_INCLUDED__
+#define __JSON_BENCHMARK_GENERATOR_HPP_INCLUDED__
+
+#include <jsonv/value.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace json_benchmark
+{
+
+/** The overall structure of a generated document. **/
+enum class document_shape
+{
+    /** Objects and arrays nested at random, with values of every kind. **/
+    random,
+    /** An array of structured log records: timestamps, levels, messages and a few attributes each. **/
+    logs,
+    /** A paged REST API response: a \c "data" array of user records with nested addresses, orders and tags. **/
+    api,
+    /** A GeoJSON \c FeatureCollection of points, lines and polygons, so mostly arrays of coordinates. **/
+    geojson,
+};
+
+/** Get the \c document_shape with the \a name (as listed by \c document_shape_names).
+ *
+ *  \throws std::invalid_argument if there is no shape with that name.
+**/
+document_shape parse_document_shape(const std::string& name);
+
+/** The names of every \c document_shape, for usage messages. **/
+const std::vector<std::string>& document_shape_names();
+
+/** Everything about a generated document. The defaults are meant to look like typical web traffic. **/
+struct generator_settings
+{
+    document_shape shape = document_shape::random;
+
+    /** The generator is completely determined by the seed (it does not use the standard library's distributions, which
+     *  differ between implementations), so the same settings always give the same document.
+    **/
+    std::uint64_t seed = 1;
+
+    /** Records (or top-level members) are added until the encoded document is at least this many bytes. **/
+    std::size_t target_bytes = 4 * 1024 * 1024;
+
+    /** The fraction of the words in strings which contain non-ASCII UTF-8 (accents, CJK, emoji). **/
+    double non_ascii_fraction = 0.05;
+
+    /** The fraction of the words in strings which are followed by a character which must be escaped (quotes,
+     *  backslashes, newlines, tabs and control characters).
+    **/
+    double escape_fraction = 0.02;
+
+    /** The fraction of object keys which are made up (like \c "retry_count_3") instead of coming from the common
+     *  vocabulary, so key lookups see some variety.
+    **/
+    double unusual_key_fraction = 0.1;
+
+    /** The mean length of arrays in \c document_shape::random. Lengths are geometrically distributed, so most arrays
+     *  are short and some are long.
+    **/
+    double mean_array_length = 8.0;
+
+    /** The deepest nesting of \c document_shape::random. **/
+    std::size_t max_depth = 6;
+
+    /** Numbers in \c document_shape::random are integers with this probability and decimals otherwise. Integers are a
+     *  mix of small counts, identifiers and epoch timestamps; decimals are a mix of prices (2 digits after the point),
+     *  measurements, full-precision ratios and values with exponents.
+    **/
+    double integer_fraction = 0.6;
+};
+
+/** Generate the document described by \a settings. **/
+jsonv::value generate_document(const generator_settings& settings);
+
+/** Generate and encode the document described by \a settings. **/
+std::string generate_encoded(const generator_settings& settings, bool pretty = true);
+
+}
+
+#endif/*__JSON_BENCHMARK_GENERATOR_HPP_INCLUDED__*/
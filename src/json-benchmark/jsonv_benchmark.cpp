@@ -12,9 +12,73 @@
 
 #include <jsonv/all.hpp>
 
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
 namespace json_benchmark
 {
 
+namespace
+{
+
+struct customer
+{
+    std::string name;
+    std::string email;
+};
+
+struct line_item
+{
+    std::string  sku;
+    std::int64_t quantity;
+    double       price;
+};
+
+struct order
+{
+    std::int64_t             id;
+    customer                 buyer;
+    double                   total;
+    bool                     paid;
+    std::vector<line_item>   items;
+    std::vector<std::string> tags;
+};
+
+using order_list = std::vector<order>;
+
+static const jsonv::formats& order_formats()
+{
+    static const jsonv::formats instance =
+        jsonv::formats::compose
+        ({
+            jsonv::formats_builder()
+                .type<customer>()
+                    .member("name",  &customer::name)
+                    .member("email", &customer::email)
+                .type<line_item>()
+                    .member("sku",      &line_item::sku)
+                    .member("quantity", &line_item::quantity)
+                    .member("price",    &line_item::price)
+                .type<order>()
+                    .member("id",       &order::id)
+                    .member("customer", &order::buyer)
+                    .member("total",    &order::total)
+                    .member("paid",     &order::paid)
+                    .member("items",    &order::items)
+                    .member("tags",     &order::tags)
+                .register_container<std::vector<line_item>>()
+                .register_container<std::vector<std::string>>()
+                .register_container<order_list>()
+                .check_references(jsonv::formats::defaults()),
+            jsonv::formats::defaults()
+        });
+    return instance;
+}
+
+}
+
 class jsonv_benchmark_suite :
         public typed_benchmark_suite<jsonv::value>
 {
@@ -23,6 +87,47 @@ public:
             typed_benchmark_suite<jsonv::value>("JSONV")
     { }
     
+    virtual bool encode_test(const value_ptr& value, bool pretty) const override
+    {
+        const jsonv::value& source = *std::static_pointer_cast<const jsonv::value>(value);
+        if (pretty)
+        {
+            std::ostringstream out;
+            jsonv::ostream_pretty_encoder encoder(out);
+            encoder.encode(source);
+        }
+        else
+        {
+            std::string out;
+            jsonv::buffer_encoder encoder(out);
+            encoder.encode(source);
+            encoder.flush();
+        }
+        return true;
+    }
+    
+    virtual bool extract_test(const value_ptr& records) const override
+    {
+        order_list x = jsonv::extract<order_list>(*std::static_pointer_cast<const jsonv::value>(records),
+                                                  order_formats()
+                                                 );
+        static_cast<void>(x);
+        return true;
+    }
+    
+    virtual value_ptr create_records(const value_ptr& records) const override
+    {
+        return std::make_shared<order_list>(
+                    jsonv::extract<order_list>(*std::static_pointer_cast<const jsonv::value>(records), order_formats())
+               );
+    }
+    
+    virtual void to_json_test(const value_ptr& records) const override
+    {
+        jsonv::value x = jsonv::to_json(*std::static_pointer_cast<const order_list>(records), order_formats());
+        static_cast<void>(x);
+    }
+    
 protected:
     virtual jsonv::value parse(const std::string& source) const
     {
@@ -9,116 +9,35 @@
  *  \author Travis Gockel (travis@gockelhut.com)
 **/
 #include "core.hpp"
+#include "generator.hpp"
+
+#include "../jsonv-tests/allocation_counter.hpp"
 
 #include <jsonv/all.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <mutex>
+#include <numeric>
 #include <random>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
+#include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 
 using namespace jsonv;
 
-struct generated_json_settings
-{
-    std::uniform_int_distribution<int> kind_distribution{0, 6};
-    
-    template <typename TRng>
-    jsonv::kind kind(TRng& rng, std::size_t current_depth)
-    {
-        if (current_depth < 2)
-            return jsonv::kind::object;
-        
-        auto k = static_cast<jsonv::kind>(kind_distribution(rng));
-        if (current_depth > 5 && (k == jsonv::kind::array || k == jsonv::kind::object))
-            return kind(rng, current_depth);
-        else
-            return k;
-    }
-    
-    std::uniform_int_distribution<std::size_t> array_length_distribution{0, 100};
-    template <typename TRng>
-    std::size_t array_length(TRng& rng)
-    {
-        return array_length_distribution(rng);
-    }
-    
-    std::uniform_int_distribution<std::size_t> object_size_distribution{5, 25};
-    template <typename TRng>
-    std::size_t object_size(TRng& rng)
-    {
-        return object_size_distribution(rng);
-    }
-    
-    std::uniform_int_distribution<std::int64_t> string_length_distribution{0, 100};
-    template <typename TRng>
-    std::size_t string_length(TRng& rng)
-    {
-        return string_length_distribution(rng);
-    }
-    
-    
-    std::normal_distribution<> decimal_distribution{1.0, 40.0};
-    template <typename TRng>
-    double decimal(TRng& rng)
-    {
-        return decimal_distribution(rng);
-    }
-    
-    std::uniform_int_distribution<std::int64_t> integer_distribution{~0};
-    template <typename TRng>
-    std::int64_t integer(TRng& rng)
-    {
-        return integer_distribution(rng);
-    }
-};
-
-template <typename TRng, typename TSettings>
-jsonv::value generate_json(TRng& rng, TSettings& settings, std::size_t current_depth = 0)
-{
-    switch (settings.kind(rng, current_depth))
-    {
-        case kind::array:
-        {
-            value out = array();
-            std::size_t len = settings.array_length(rng);
-            for (std::size_t idx = 0; idx < len; ++idx)
-                out.push_back(generate_json(rng, settings, current_depth + 1));
-            return out;
-        }
-        case kind::boolean:
-            return !(rng() & 1);
-        case kind::decimal:
-            return settings.decimal(rng);
-        case kind::integer:
-            return settings.integer(rng);
-        case kind::string:
-            // TODO: Improve this
-            return std::string(settings.string_length(rng), 'a');
-        case kind::object:
-        {
-            value out = object();
-            std::size_t len = settings.object_size(rng);
-            for (std::size_t idx = 1; idx <= len; ++idx)
-            {
-                // TODO: Improve
-                std::string key(idx, 'a');
-                value val = generate_json(rng, settings, current_depth + 1);
-                out.insert({ std::move(key), std::move(val) });
-            }
-            return out;
-        }
-        case kind::null:
-        default:
-            return null;
-    }
-}
-
 class stopwatch
 {
 public:
@@ -165,68 +84,686 @@ public:
     {
         ++tick_count;
         total_time += dur;
+        samples.push_back(dur);
     }
     
 public:
-    std::size_t tick_count;
-    duration    total_time;
+    std::size_t           tick_count;
+    duration              total_time;
+    std::vector<duration> samples;
+};
+
+/** The timings of one test (or of one test over every corpus file). **/
+struct test_result
+{
+    std::string                      suite;
+    std::string                      test;
+    std::string                      corpus;
+    std::size_t                      total_bytes = 0; //!< The size of the input of all of the runs together
+    std::vector<stopwatch::duration> samples;
+    jsonv_test::allocation_stats     allocations;     //!< The allocations of one run
+    
+    double seconds(stopwatch::duration dur) const
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(dur).count();
+    }
+    
+    stopwatch::duration total() const
+    {
+        return std::accumulate(samples.begin(), samples.end(), stopwatch::duration(0));
+    }
+    
+    double mean() const
+    {
+        return seconds(total()) / double(samples.size());
+    }
+    
+    /** The megabytes of input handled per second, over all of the runs. **/
+    double throughput() const
+    {
+        return double(total_bytes) / (1024.0 * 1024.0) / seconds(total());
+    }
+    
+    /** The time of the run at \a fraction (from 0 to 1) of the way from the fastest to the slowest, by the nearest rank
+     *  method.
+    **/
+    double percentile(double fraction) const
+    {
+        std::vector<stopwatch::duration> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        std::size_t rank = std::size_t(std::ceil(fraction * double(sorted.size())));
+        return seconds(sorted[rank == 0 ? 0 : rank - 1]);
+    }
+    
+    value to_json() const
+    {
+        return object({ { "suite",           suite                                      },
+                        { "test",            test                                       },
+                        { "corpus",          corpus                                     },
+                        { "bytes",           std::int64_t(total_bytes / samples.size()) },
+                        { "runs",            std::int64_t(samples.size())               },
+                        { "mean_s",          mean()                                     },
+                        { "mb_per_s",        throughput()                               },
+                        { "p50_s",           percentile(0.50)                           },
+                        { "p90_s",           percentile(0.90)                           },
+                        { "p99_s",           percentile(0.99)                           },
+                        { "max_s",           percentile(1.00)                           },
+                        { "allocations",     std::int64_t(allocations.count)            },
+                        { "allocated_bytes", std::int64_t(allocations.bytes)            },
+                        { "peak_bytes",      std::int64_t(allocations.peak_bytes)       },
+                        { "samples_s",       sample_seconds()                           },
+                      }
+                     );
+    }
+    
+    value sample_seconds() const
+    {
+        value out = array();
+        for (stopwatch::duration sample : samples)
+            out.push_back(seconds(sample));
+        return out;
+    }
 };
 
-static std::string get_encoded_json()
+/** A \c test_result as loaded from the JSON of an earlier run, for \c --baseline. **/
+struct baseline_result
+{
+    double              mean;
+    std::size_t         allocations;
+    std::vector<double> samples;
+};
+
+/** Get the critical value of Student's t distribution for a two-sided 95% interval with \a df degrees of freedom. **/
+static double t_critical_95(double df)
+{
+    static const double table[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                     2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                     2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+                                   };
+    if (!(df < double(sizeof table / sizeof table[0])))
+        return 1.96;
+    
+    // rounding down is the wider interval, which errs on the side of not flagging a regression
+    std::size_t idx = std::size_t(std::max(1.0, std::floor(df)));
+    return table[idx - 1];
+}
+
+static void mean_and_variance(const std::vector<double>& samples, double& mean, double& variance)
+{
+    mean = std::accumulate(samples.begin(), samples.end(), 0.0) / double(samples.size());
+    variance = 0.0;
+    for (double x : samples)
+        variance += (x - mean) * (x - mean);
+    variance = samples.size() > 1 ? variance / double(samples.size() - 1) : 0.0;
+}
+
+static std::map<std::string, baseline_result> load_baseline(const std::string& path)
 {
-    std::ifstream in("temp.json");
-    if (in.good())
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("Could not read " + path);
+    
+    value                                  saved = parse(in);
+    std::map<std::string, baseline_result> out;
+    for (const value& result : saved.at("results").as_array())
     {
-        std::stringstream buff;
-        buff << in.rdbuf();
-        return buff.str();
+        baseline_result& entry = out[result.at("suite").as_string() + "/" + result.at("test").as_string() + " "
+                                     + result.at("corpus").as_string()
+                                    ];
+        entry.mean        = result.at("mean_s").as_decimal();
+        entry.allocations = std::size_t(result.at("allocations").as_integer());
+        if (result.count("samples_s"))
+            for (const value& sample : result.at("samples_s").as_array())
+                entry.samples.push_back(sample.as_decimal());
+    }
+    return out;
+}
+
+/** Compare \a results to the \a baseline, printing each change in the mean time (with its 95% confidence interval, by
+ *  Welch's t-test) and allocations.
+ *  
+ *  \returns The number of results which are slower by more than \a threshold (a fraction of the time of the baseline)
+ *            with 95% confidence, or which make more than \a threshold more allocations.
+**/
+static std::size_t compare_to_baseline(const std::vector<test_result>&               results,
+                                       const std::map<std::string, baseline_result>& baseline,
+                                       double                                        threshold
+                                      )
+{
+    std::size_t regressions = 0;
+    std::cout << std::endl << "Compared to the baseline (change in mean time, 95% interval):" << std::endl;
+    for (const test_result& result : results)
+    {
+        std::string name = result.suite + "/" + result.test + " " + result.corpus;
+        auto        old  = baseline.find(name);
+        if (old == baseline.end())
+            continue;
+        
+        std::vector<double> current;
+        for (stopwatch::duration sample : result.samples)
+            current.push_back(result.seconds(sample));
+        
+        double new_mean, new_variance, old_mean, old_variance;
+        mean_and_variance(current, new_mean, new_variance);
+        if (old->second.samples.empty())
+        {
+            old_mean     = old->second.mean;
+            old_variance = 0.0;
+        }
+        else
+        {
+            mean_and_variance(old->second.samples, old_mean, old_variance);
+        }
+        
+        // Welch's t-test, with the Welch-Satterthwaite approximation of the degrees of freedom
+        std::size_t new_count   = current.size();
+        std::size_t old_count   = old->second.samples.size();
+        double      new_term    = new_variance / double(new_count);
+        double      old_term    = old_count == 0 ? 0.0 : old_variance / double(old_count);
+        double      error       = std::sqrt(new_term + old_term);
+        double      denominator = (new_count > 1 ? new_term * new_term / double(new_count - 1) : 0.0)
+                                + (old_count > 1 ? old_term * old_term / double(old_count - 1) : 0.0);
+        double      df          = denominator > 0.0 ? (new_term + old_term) * (new_term + old_term) / denominator
+                                                    : std::numeric_limits<double>::infinity();
+        double      margin      = t_critical_95(df) * error;
+        double      change      = (new_mean - old_mean) / old_mean;
+        double      low         = (new_mean - old_mean - margin) / old_mean;
+        double      high        = (new_mean - old_mean + margin) / old_mean;
+        
+        bool slower    = low > threshold;
+        bool allocates = double(result.allocations.count) > double(old->second.allocations) * (1.0 + threshold);
+        if (slower || allocates)
+            ++regressions;
+        
+        std::cout << name << '\t' << std::showpos << change * 100.0 << "% [" << low * 100.0 << "%, "
+                  << high * 100.0 << "%]" << std::noshowpos
+                  << "\tallocations " << old->second.allocations << " -> " << result.allocations.count
+                  << (slower ? "\tSLOWER" : "") << (allocates ? "\tMORE ALLOCATIONS" : "")
+                  << std::endl;
     }
+    return regressions;
+}
+
+static void print_result(const test_result& result)
+{
+    std::cout << result.suite << '/' << result.test << '\t' << result.corpus
+              << "\tmean=" << result.mean()
+              << "\tMB/s=" << result.throughput()
+              << "\tp50=" << result.percentile(0.50)
+              << "\tp90=" << result.percentile(0.90)
+              << "\tp99=" << result.percentile(0.99)
+              << "\tmax=" << result.percentile(1.00)
+              << "\tallocations=" << result.allocations.count
+              << "\tallocated=" << result.allocations.bytes
+              << "\tpeak=" << result.allocations.peak_bytes
+              << std::endl;
+}
+
+/** A document to run the parse and encode tests on. **/
+struct corpus_file
+{
+    std::string name;
+    std::string text;
+};
+
+static std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("Could not read " + path);
+    std::stringstream buff;
+    buff << in.rdbuf();
+    return buff.str();
+}
+
+/** Get the files of \a path, which is either a single file or a directory of \c .json files. **/
+static std::vector<corpus_file> load_corpus(const std::string& path)
+{
+    namespace fs = boost::filesystem;
     
-    std::ostringstream encoded_stream;
-    ostream_pretty_encoder out(encoded_stream);
+    std::vector<corpus_file> out;
+    if (fs::is_directory(path))
+    {
+        std::vector<fs::path> paths;
+        for (fs::directory_iterator iter(path); iter != fs::directory_iterator(); ++iter)
+            if (fs::is_regular_file(iter->path()) && iter->path().extension() == ".json")
+                paths.push_back(iter->path());
+        std::sort(paths.begin(), paths.end());
+        for (const fs::path& file : paths)
+            out.push_back({ file.filename().string(), read_file(file.string()) });
+    }
+    else
+    {
+        out.push_back({ fs::path(path).filename().string(), read_file(path) });
+    }
+    return out;
+}
+
+/** Generate the document of orders described by \c benchmark_suite::extract_test. **/
+static std::string get_encoded_records(std::size_t count)
+{
     std::mt19937_64 rng{std::random_device()()};
-    generated_json_settings settings;
-    value val = generate_json(rng, settings);
-    out.encode(val);
-    std::string encoded = encoded_stream.str();
-    
-    // save the string to a file in case we want to re-use it
-    std::ofstream file("temp.json", std::ofstream::out | std::ofstream::trunc);
-    file << encoded;
-    return encoded;
+    std::uniform_int_distribution<std::size_t> length_distribution{1, 10};
+    std::uniform_int_distribution<std::int64_t> quantity_distribution{1, 20};
+    std::uniform_real_distribution<double> price_distribution{0.5, 200.0};
+    
+    value records = array();
+    records.reserve(count);
+    for (std::size_t idx = 0; idx < count; ++idx)
+    {
+        std::string name(length_distribution(rng) + 2, 'a');
+        
+        value items = array();
+        double total = 0.0;
+        for (std::size_t item_count = length_distribution(rng); item_count > 0; --item_count)
+        {
+            std::int64_t quantity = quantity_distribution(rng);
+            double       price    = price_distribution(rng);
+            total += double(quantity) * price;
+            items.push_back(object({ { "sku",      std::string(8, char('a' + item_count)) },
+                                     { "quantity", quantity                                },
+                                     { "price",    price                                   },
+                                   }
+                                  )
+                           );
+        }
+        
+        value tags = array();
+        for (std::size_t tag_count = length_distribution(rng) / 3; tag_count > 0; --tag_count)
+            tags.push_back(std::string(length_distribution(rng), 'a'));
+        
+        records.push_back(object({ { "id",       std::int64_t(idx)                                              },
+                                   { "customer", object({ { "name", name }, { "email", name + "@example.com" } }) },
+                                   { "total",    total                                                          },
+                                   { "paid",     !(rng() & 1)                                                   },
+                                   { "items",    std::move(items)                                               },
+                                   { "tags",     std::move(tags)                                                },
+                                 }
+                                )
+                         );
+    }
+    return to_string(records);
+}
+
+/** Time \a loop_count runs of \a test for the test \a name over the \a bytes of input in \a corpus. If the first run of
+ *  \a test returns \c false, the suite does not support the test and nothing is recorded.
+**/
+template <typename FTest>
+static void run_test(std::vector<test_result>& results,
+                     const std::string&        suite,
+                     const std::string&        name,
+                     const std::string&        corpus,
+                     std::size_t               bytes,
+                     int                       loop_count,
+                     const FTest&              test
+                    )
+{
+    std::string                  display = suite + "/" + name + " " + corpus;
+    stopwatch                    watch;
+    jsonv_test::allocation_stats allocations;
+    for (int idx = 1; idx <= loop_count; ++idx)
+    {
+        bool supported;
+        {
+            // counting allocations is a few atomic operations each, which is included in the time of every run
+            jsonv_test::allocation_counter counter;
+            {
+                auto ticker = watch.start();
+                supported = test();
+            }
+            allocations = counter.stats();
+        }
+        if (!supported)
+            return;
+        
+        std::cout << '\r' << display << "..." << idx << '/' << loop_count;
+        std::cout.flush();
+    }
+    std::cout << '\r';
+    
+    test_result result;
+    result.suite       = suite;
+    result.test        = name;
+    result.corpus      = corpus;
+    result.total_bytes = bytes * watch.samples.size();
+    result.samples     = std::move(watch.samples);
+    result.allocations = allocations;
+    print_result(result);
+    results.push_back(std::move(result));
+}
+
+/** Combine the results of each test of a suite over all of the corpus files into one result (with the corpus \c "*"),
+ *  so the throughput is over everything and the percentiles over every run.
+**/
+static std::vector<test_result> summarize(const std::vector<test_result>& results, std::size_t corpus_count)
+{
+    std::vector<test_result> out;
+    if (corpus_count < 2)
+        return out;
+    
+    for (const test_result& result : results)
+    {
+        auto same_test = [&] (const test_result& x) { return x.suite == result.suite && x.test == result.test; };
+        auto match     = std::find_if(out.begin(), out.end(), same_test);
+        if (match == out.end())
+        {
+            test_result summary;
+            summary.suite  = result.suite;
+            summary.test   = result.test;
+            summary.corpus = "*";
+            out.push_back(std::move(summary));
+            match = out.end() - 1;
+        }
+        
+        // the allocations of going through each file once
+        match->total_bytes += result.total_bytes;
+        match->samples.insert(match->samples.end(), result.samples.begin(), result.samples.end());
+        match->allocations.count      += result.allocations.count;
+        match->allocations.bytes      += result.allocations.bytes;
+        match->allocations.peak_bytes  = std::max(match->allocations.peak_bytes, result.allocations.peak_bytes);
+    }
+    return out;
+}
+
+/** Run \a test \a loop_count times on each of \a threads threads at once. \a test is given the index of the thread
+ *  running it, so each thread can work on its own inputs.
+ *  
+ *  \returns The time from starting all of the threads until the last of them is done.
+**/
+static stopwatch::duration run_threads(std::size_t                             threads,
+                                       int                                     loop_count,
+                                       const std::function<void (std::size_t)>& test
+                                      )
+{
+    std::mutex              lock;
+    std::condition_variable start_signal;
+    bool                    started = false;
+    
+    std::vector<std::thread> workers;
+    for (std::size_t thread_idx = 0; thread_idx < threads; ++thread_idx)
+        workers.emplace_back([&, thread_idx]
+                             {
+                                 {
+                                     std::unique_lock<std::mutex> guard(lock);
+                                     start_signal.wait(guard, [&] { return started; });
+                                 }
+                                 for (int idx = 0; idx < loop_count; ++idx)
+                                     test(thread_idx);
+                             }
+                            );
+    
+    stopwatch watch;
+    {
+        auto ticker = watch.start();
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            started = true;
+        }
+        start_signal.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+    return watch.total_time;
+}
+
+/** Time \a test (a test of \a suite with \a loop_count runs over the \a bytes of input in \a corpus) on each of
+ *  the \a thread_counts and print the throughput of all of the threads together. The efficiency is the throughput as
+ *  a fraction of the throughput of one thread times the number of threads, so shared state which the threads contend
+ *  for shows up as an efficiency which falls as threads are added. If \a test returns \c false when it is run to warm
+ *  up, the suite does not support the test and nothing is printed.
+**/
+static void run_scaling(const std::string&                       suite,
+                        const std::string&                       name,
+                        const std::string&                       corpus,
+                        std::size_t                              bytes,
+                        const std::vector<std::size_t>&          thread_counts,
+                        int                                      loop_count,
+                        const std::function<bool (std::size_t)>& test
+                       )
+{
+    if (!test(0))
+        return;
+    
+    double single_throughput = 0.0;
+    for (std::size_t threads : thread_counts)
+    {
+        stopwatch::duration elapsed    = run_threads(threads, loop_count, [&] (std::size_t idx) { test(idx); });
+        double              seconds    = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+        double              throughput = double(bytes) * double(loop_count) * double(threads) / seconds;
+        if (threads == thread_counts.front())
+            single_throughput = throughput / double(threads);
+        
+        std::cout << suite << "/" << name << '\t' << corpus
+                  << "\tthreads=" << threads
+                  << "\tMB/s=" << throughput / 1e6
+                  << "\tspeedup=" << throughput / single_throughput
+                  << "\tefficiency=" << 100.0 * throughput / (single_throughput * double(threads)) << '%'
+                  << std::endl;
+    }
+}
+
+/** Run the parse, encode and extract tests of \a suite on 1 to \a max_threads threads, each working on its own
+ *  copy of the input.
+**/
+static void run_scaling_tests(const json_benchmark::benchmark_suite& suite,
+                              const std::vector<corpus_file>&        corpus,
+                              const std::string&                     encoded_records,
+                              std::size_t                            max_threads,
+                              int                                    loop_count
+                             )
+{
+    using value_ptr = json_benchmark::benchmark_suite::value_ptr;
+    
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+    
+    std::cout << std::endl;
+    for (const corpus_file& file : corpus)
+    {
+        std::vector<std::string> texts(max_threads, file.text);
+        std::vector<value_ptr>   values;
+        for (const std::string& text : texts)
+            values.push_back(suite.create_value(text));
+        
+        std::size_t size = file.text.size();
+        run_scaling(suite.name(), "parse", file.name, size, thread_counts, loop_count,
+                    [&] (std::size_t idx) { suite.parse_test(texts[idx]); return true; }
+                   );
+        run_scaling(suite.name(), "encode", file.name, size, thread_counts, loop_count,
+                    [&] (std::size_t idx) { return suite.encode_test(values[idx], false); }
+                   );
+    }
+    
+    std::vector<value_ptr> records;
+    for (std::size_t idx = 0; idx < max_threads; ++idx)
+        records.push_back(suite.create_value(encoded_records));
+    run_scaling(suite.name(), "extract", "records", encoded_records.size(), thread_counts, loop_count,
+                [&] (std::size_t idx) { return suite.extract_test(records[idx]); }
+               );
+}
+
+static void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--corpus PATH]... [--generate SHAPE]... [--seed N] [--size BYTES]\n"
+                 "           [--json FILE] [--baseline FILE [--threshold PERCENT]] [--threads N] [SUITE [LOOP_COUNT]]\n"
+                 "\n"
+                 "  --corpus PATH  Parse and encode the file at PATH, or every .json file in the directory\n"
+                 "                 PATH, instead of a generated document. This can be given more than once.\n"
+                 "  --generate SHAPE\n"
+                 "                 Parse and encode a generated document shaped like SHAPE: \"random\" (the default\n"
+                 "                 when there is no --corpus), \"logs\", \"api\" or \"geojson\". This can be given more\n"
+                 "                 than once.\n"
+                 "  --seed N       The seed of the generated documents (1 by default). The same seed always generates\n"
+                 "                 the same documents.\n"
+                 "  --size BYTES   The (approximate) size of each generated document (4 MiB by default).\n"
+                 "  --json FILE    Also write the results to FILE as JSON.\n"
+                 "  --baseline FILE\n"
+                 "                 Compare the results to the ones written to FILE by --json in an earlier run.\n"
+                 "                 The exit status is 2 if any test is slower than the baseline by more than the\n"
+                 "                 threshold with 95% confidence, or allocates more than the threshold more.\n"
+                 "  --threshold PERCENT\n"
+                 "                 The regression threshold for --baseline (5 by default).\n"
+                 "  --threads N    Instead of the usual tests, run parse, encode and extract on 1, 2, 4... up to N\n"
+                 "                 threads at once (each with its own copy of the input) and show how the\n"
+                 "                 throughput scales. Allocations are not counted in this mode.\n"
+                 "  SUITE          Only run the suite with this name (such as \"JSONV\").\n"
+                 "  LOOP_COUNT     The number of times to run each test (10 by default).\n";
 }
 
 int main(int argc, char** argv)
 {
     using namespace json_benchmark;
     
+    std::vector<std::string> corpus_paths;
+    std::vector<std::string> generate_shapes;
+    generator_settings       generate_settings;
+    std::string              json_path;
+    std::string              baseline_path;
+    double                   threshold = 0.05;
+    std::size_t              max_threads = 0;
+    std::vector<std::string> positional;
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        std::string arg = argv[idx];
+        if (arg == "--corpus" && idx + 1 < argc)
+        {
+            corpus_paths.emplace_back(argv[++idx]);
+        }
+        else if (arg == "--generate" && idx + 1 < argc)
+        {
+            generate_shapes.emplace_back(argv[++idx]);
+        }
+        else if (arg == "--seed" && idx + 1 < argc)
+        {
+            generate_settings.seed = boost::lexical_cast<std::uint64_t>(argv[++idx]);
+        }
+        else if (arg == "--size" && idx + 1 < argc)
+        {
+            generate_settings.target_bytes = boost::lexical_cast<std::size_t>(argv[++idx]);
+        }
+        else if (arg == "--json" && idx + 1 < argc)
+        {
+            json_path = argv[++idx];
+        }
+        else if (arg == "--baseline" && idx + 1 < argc)
+        {
+            baseline_path = argv[++idx];
+        }
+        else if (arg == "--threshold" && idx + 1 < argc)
+        {
+            threshold = boost::lexical_cast<double>(argv[++idx]) / 100.0;
+        }
+        else if (arg == "--threads" && idx + 1 < argc)
+        {
+            max_threads = boost::lexical_cast<std::size_t>(argv[++idx]);
+        }
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            print_usage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+        else
+        {
+            positional.push_back(arg);
+        }
+    }
+    
     std::string filter;
-    if (argc >= 2)
-        filter = argv[1];
+    if (positional.size() >= 1)
+        filter = positional[0];
     
     int loop_count = 10;
-    if (argc >= 3)
-        loop_count = boost::lexical_cast<int>(argv[2]);
+    if (positional.size() >= 2)
+        loop_count = boost::lexical_cast<int>(positional[1]);
     
-    std::string encoded = get_encoded_json();
+    std::vector<corpus_file> corpus;
+    for (const std::string& path : corpus_paths)
+        for (corpus_file& file : load_corpus(path))
+            corpus.push_back(std::move(file));
+    if (corpus.empty() && generate_shapes.empty())
+        generate_shapes.emplace_back("random");
+    for (const std::string& shape : generate_shapes)
+    {
+        generate_settings.shape = parse_document_shape(shape);
+        corpus.push_back({ "generated-" + shape, generate_encoded(generate_settings) });
+    }
+    std::string encoded_records = get_encoded_records(2000);
+    
+    if (max_threads > 0)
+    {
+        // the allocation counters are shared by every thread, so counting would be the bottleneck
+        jsonv_test::allocation_counter::set_counting(false);
+        for (const benchmark_suite* suite : benchmark_suite::all())
+            if (filter.empty() || filter == suite->name())
+                run_scaling_tests(*suite, corpus, encoded_records, max_threads, loop_count);
+        return 0;
+    }
     
+    std::vector<test_result> results;
     for (const benchmark_suite* suite : benchmark_suite::all())
     {
         if (!filter.empty() && filter != suite->name())
             continue;
         
         std::cout << std::endl;
-        stopwatch watch;
-        for (int idx = 1; idx <= loop_count; ++idx)
+        std::vector<test_result> suite_results;
+        for (const corpus_file& file : corpus)
         {
-            std::cout << '\r' << suite->name() << "..." << idx << '/' << loop_count;
-            std::cout.flush();
-            auto ticker = watch.start();
-            suite->parse_test(encoded);
+            std::size_t size = file.text.size();
+            run_test(suite_results, suite->name(), "parse", file.name, size, loop_count,
+                     [&] { suite->parse_test(file.text); return true; }
+                    );
+            
+            benchmark_suite::value_ptr val = suite->create_value(file.text);
+            run_test(suite_results, suite->name(), "encode", file.name, size, loop_count,
+                     [&] { return suite->encode_test(val, false); }
+                    );
+            run_test(suite_results, suite->name(), "encode_pretty", file.name, size, loop_count,
+                     [&] { return suite->encode_test(val, true); }
+                    );
         }
-        std::cout << std::endl;
+        for (test_result& summary : summarize(suite_results, corpus.size()))
+        {
+            print_result(summary);
+            suite_results.push_back(std::move(summary));
+        }
+        
+        std::size_t records_size = encoded_records.size();
+        benchmark_suite::value_ptr records_val = suite->create_value(encoded_records);
+        run_test(suite_results, suite->name(), "extract", "records", records_size, loop_count,
+                 [&] { return suite->extract_test(records_val); }
+                );
+        if (benchmark_suite::value_ptr records = suite->create_records(records_val))
+            run_test(suite_results, suite->name(), "to_json", "records", records_size, loop_count,
+                     [&] { suite->to_json_test(records); return true; }
+                    );
+        
+        for (test_result& result : suite_results)
+            results.push_back(std::move(result));
+    }
+    
+    if (!json_path.empty())
+    {
+        value out = array();
+        for (const test_result& result : results)
+            out.push_back(result.to_json());
         
-        auto average = std::chrono::duration_cast<std::chrono::duration<double>>(watch.total_time) / watch.tick_count;
-        std::cout << suite->name() << '\t' << average.count();// << std::endl;
+        std::ofstream file(json_path, std::ofstream::out | std::ofstream::trunc);
+        ostream_pretty_encoder encoder(file);
+        encoder.compact_arrays(true);
+        encoder.encode(object({ { "loop_count", loop_count }, { "results", out } }));
+        file << std::endl;
+    }
+    
+    if (!baseline_path.empty())
+    {
+        std::size_t regressions = compare_to_baseline(results, load_baseline(baseline_path), threshold);
+        if (regressions > 0)
+        {
+            std::cout << regressions << " regression(s) of more than " << threshold * 100.0 << '%' << std::endl;
+            return 2;
+        }
     }
 }
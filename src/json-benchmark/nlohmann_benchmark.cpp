@@ -0,0 +1,43 @@
+/** \file
+ *  
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "core.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+
+namespace json_benchmark
+{
+
+class nlohmann_benchmark_suite :
+        public typed_benchmark_suite<nlohmann::json>
+{
+public:
+    nlohmann_benchmark_suite() :
+            typed_benchmark_suite<nlohmann::json>("nlohmann")
+    { }
+    
+    virtual bool encode_test(const value_ptr& value, bool pretty) const override
+    {
+        std::string out = std::static_pointer_cast<const nlohmann::json>(value)->dump(pretty ? 4 : -1);
+        static_cast<void>(out);
+        return true;
+    }
+    
+protected:
+    virtual nlohmann::json parse(const std::string& source) const
+    {
+        return nlohmann::json::parse(source);
+    }
+    
+} nlohmann_benchmark_suite_instance;
+
+}
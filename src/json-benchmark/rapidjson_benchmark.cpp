@@ -0,0 +1,62 @@
+/** \file
+ *  
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "core.hpp"
+
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <stdexcept>
+
+namespace json_benchmark
+{
+
+using rapidjson_value = std::shared_ptr<rapidjson::Document>;
+
+class rapidjson_benchmark_suite :
+        public typed_benchmark_suite<rapidjson_value>
+{
+public:
+    rapidjson_benchmark_suite() :
+            typed_benchmark_suite<rapidjson_value>("RapidJSON")
+    { }
+    
+    virtual bool encode_test(const value_ptr& value, bool pretty) const override
+    {
+        const rapidjson::Document& source = *std::static_pointer_cast<const rapidjson::Document>(value);
+        rapidjson::StringBuffer out;
+        if (pretty)
+        {
+            rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(out);
+            source.Accept(writer);
+        }
+        else
+        {
+            rapidjson::Writer<rapidjson::StringBuffer> writer(out);
+            source.Accept(writer);
+        }
+        return true;
+    }
+    
+protected:
+    virtual rapidjson_value parse(const std::string& source) const
+    {
+        rapidjson_value x = std::make_shared<rapidjson::Document>();
+        x->Parse(source.c_str(), source.size());
+        if (x->HasParseError())
+            throw std::runtime_error("Failed to parse");
+        return x;
+    }
+    
+} rapidjson_benchmark_suite_instance;
+
+}
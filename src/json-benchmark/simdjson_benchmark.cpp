@@ -0,0 +1,58 @@
+/** \file
+ *  
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "core.hpp"
+
+#include <simdjson.h>
+
+#include <string>
+
+namespace json_benchmark
+{
+
+/** A parsed document only refers to the memory of the parser which made it, so the two are kept together. **/
+struct simdjson_document
+{
+    simdjson::dom::parser  parser;
+    simdjson::dom::element root;
+};
+
+using simdjson_value = std::shared_ptr<simdjson_document>;
+
+class simdjson_benchmark_suite :
+        public typed_benchmark_suite<simdjson_value>
+{
+public:
+    simdjson_benchmark_suite() :
+            typed_benchmark_suite<simdjson_value>("simdjson")
+    { }
+    
+    virtual bool encode_test(const value_ptr& value, bool pretty) const override
+    {
+        const simdjson::dom::element& source = std::static_pointer_cast<const simdjson_document>(value)->root;
+        std::string out = pretty ? simdjson::prettify(source) : simdjson::minify(source);
+        static_cast<void>(out);
+        return true;
+    }
+    
+protected:
+    /** Every parse gets a new parser, like the other suites start from nothing on every parse. Reusing a parser (the
+     *  way simdjson is meant to be used in a loop) skips the allocation of its buffers.
+    **/
+    virtual simdjson_value parse(const std::string& source) const
+    {
+        simdjson_value x = std::make_shared<simdjson_document>();
+        x->root = x->parser.parse(source);
+        return x;
+    }
+    
+} simdjson_benchmark_suite_instance;
+
+}
@@ -0,0 +1,320 @@
+/** \file
+ *  Micro-benchmarks of the kernels of parsing and encoding on controlled inputs, so a change in the end-to-end numbers
+ *  of \c json-benchmark can be traced to the piece responsible for it.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/parse.hpp>
+#include <jsonv/tokenizer.hpp>
+#include <jsonv/detail/number_convert.hpp>
+#include <jsonv/detail/token_patterns.hpp>
+#include <jsonv-tests/stopwatch.hpp>
+
+#include "../jsonv/char_convert.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jsonv_microbench
+{
+
+using namespace jsonv;
+using jsonv_test::stopwatch;
+
+/** Keep the optimizer from dropping the computation of \a x. **/
+template <typename T>
+static void keep(const T& x)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&x) : "memory");
+#else
+    static const volatile void* sink;
+    sink = &x;
+#endif
+}
+
+/** A kernel run on one input. Each call of \c run is one operation, which handles \c bytes of input. **/
+struct microbench
+{
+    std::string           kernel;
+    std::string           input;
+    std::size_t           bytes;
+    std::function<void()> run;
+};
+
+/** Run \a bench in batches which take at least \a min_batch_time and print the fastest time an operation took in any
+ *  of the \a batches. The fastest is the one least disturbed by everything else the machine is doing.
+**/
+static void measure(const microbench& bench, std::chrono::nanoseconds min_batch_time, std::size_t batches)
+{
+    // calibrate the operations in a batch (which also warms up the caches)
+    std::size_t ops = 1;
+    while (true)
+    {
+        auto start = stopwatch::clock::now();
+        for (std::size_t idx = 0; idx < ops; ++idx)
+            bench.run();
+        if (stopwatch::clock::now() - start >= min_batch_time || ops >= (std::size_t(1) << 30))
+            break;
+        ops *= 2;
+    }
+
+    double best = 0.0;
+    for (std::size_t batch = 0; batch < batches; ++batch)
+    {
+        stopwatch timer;
+        {
+            JSONV_TEST_TIME(timer);
+            for (std::size_t idx = 0; idx < ops; ++idx)
+                bench.run();
+        }
+        double op_ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(timer.get().sum).count()) / ops;
+        if (batch == 0 || op_ns < best)
+            best = op_ns;
+    }
+
+    std::cout << std::left << std::setw(16) << bench.kernel << std::setw(36) << bench.input
+              << std::right << std::setw(12) << std::fixed << std::setprecision(1) << best << " ns/op";
+    if (bench.bytes > 0)
+        std::cout << std::setw(10) << std::setprecision(0) << (bench.bytes / best * 1e3) << " MB/s";
+    std::cout << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Inputs                                                                                                             //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** The contents of a string (without the quotes) of \a length characters, where one in every \a escape_every is an
+ *  escape sequence (in the encoded form, if \a encoded) or a character which needs one. A zero \a escape_every has no
+ *  escapes at all.
+**/
+static std::string string_contents(std::size_t length, std::size_t escape_every, bool encoded)
+{
+    static const char* const escapes[] = { "\\n", "\\\"", "\\u00e9", "\\t", "\\\\", "\\u2603" };
+    static const char* const decoded[] = { "\n",  "\"",   "\xc3\xa9", "\t", "\\",   "\xe2\x98\x83" };
+
+    std::string out;
+    std::size_t next_escape = 0;
+    for (std::size_t idx = 0; idx < length; ++idx)
+    {
+        if (escape_every > 0 && idx % escape_every == escape_every - 1)
+        {
+            out += encoded ? escapes[next_escape] : decoded[next_escape];
+            next_escape = (next_escape + 1) % (sizeof escapes / sizeof escapes[0]);
+        }
+        else
+        {
+            out += char('a' + idx % 26);
+        }
+    }
+    return out;
+}
+
+/** The description of a string of \a length with an escape every \a escape_every characters. **/
+static std::string describe_string(std::size_t length, std::size_t escape_every)
+{
+    return "length=" + std::to_string(length)
+         + (escape_every == 0 ? std::string(" no escapes") : " escape/" + std::to_string(escape_every));
+}
+
+/** A document of arrays nested \a depth deep, each holding a few numbers and strings, repeated until it is about
+ *  \a size bytes long.
+**/
+static std::string nested_document(std::size_t depth, std::size_t size)
+{
+    std::string one;
+    for (std::size_t level = 0; level < depth; ++level)
+        one += "[1, \"x\", ";
+    one += "true";
+    for (std::size_t level = 0; level < depth; ++level)
+        one += ", -2.5]";
+
+    std::string out = "[";
+    while (out.size() < size)
+    {
+        if (out.size() > 1)
+            out += ", ";
+        out += one;
+    }
+    return out + "]";
+}
+
+/** A number with \a digits significant digits (and a fraction and exponent if \a decimal). **/
+static std::string number_text(std::size_t digits, bool decimal)
+{
+    std::string out;
+    for (std::size_t idx = 0; idx < digits; ++idx)
+        out += char('1' + idx % 9);
+    if (decimal && digits > 1)
+        out.insert(1, ".");
+    if (decimal)
+        out += "e-7";
+    return out;
+}
+
+static std::vector<microbench> all_benchmarks()
+{
+    std::vector<microbench> out;
+
+    for (std::size_t depth : { 1, 8, 64 })
+    {
+        auto source = std::make_shared<std::string>(nested_document(depth, 64 * 1024));
+        out.push_back({ "tokenizer::next", "depth=" + std::to_string(depth) + " 64KiB", source->size(),
+                        [source]
+                        {
+                            tokenizer tokens(*source);
+                            std::size_t count = 0;
+                            while (tokens.next())
+                                ++count;
+                            keep(count);
+                        }
+                      });
+    }
+
+    std::vector<std::pair<std::string, std::string>> tokens =
+        {
+            { "true",      "true" },
+            { "[",         "[" },
+            { "123456",    "123456" },
+            { "-1.25e+10", "-1.25e+10" },
+        };
+    for (std::size_t length : { 16, 256 })
+        for (std::size_t escape_every : { 0, 8 })
+            tokens.push_back({ "string " + describe_string(length, escape_every),
+                               '"' + string_contents(length, escape_every, true) + '"'
+                             });
+    for (const auto& token : tokens)
+    {
+        // the token is followed by something, like it would be in a document
+        auto source = std::make_shared<std::string>(token.second + ",");
+        out.push_back({ "attempt_match", token.first, token.second.size(),
+                        [source]
+                        {
+                            token_kind  kind;
+                            std::size_t length;
+                            auto result = detail::attempt_match(source->data(), source->data() + source->size(),
+                                                                kind, length
+                                                               );
+                            keep(result);
+                            keep(length);
+                        }
+                      });
+    }
+
+    auto decode = detail::get_string_decoder(parse_options::encoding::utf8);
+    for (std::size_t length : { 8, 64, 1024 })
+    {
+        for (std::size_t escape_every : { 0, 16, 2 })
+        {
+            auto encoded = std::make_shared<std::string>(string_contents(length, escape_every, true));
+            out.push_back({ "string_decode", describe_string(length, escape_every), encoded->size(),
+                            [encoded, decode]
+                            {
+                                std::string x = decode(*encoded);
+                                keep(x);
+                            }
+                          });
+
+            auto plain = std::make_shared<std::string>(string_contents(length, escape_every, false));
+            auto buffer = std::make_shared<std::string>();
+            out.push_back({ "string_encode", describe_string(length, escape_every), plain->size(),
+                            [plain, buffer]
+                            {
+                                buffer->clear();
+                                detail::string_encode(*buffer, *plain);
+                                keep(*buffer);
+                            }
+                          });
+        }
+    }
+
+    for (bool decimal : { false, true })
+    {
+        for (std::size_t digits : { 1, 4, 8, 17, 19, 25 })
+        {
+            auto text = std::make_shared<std::string>(number_text(digits, decimal));
+            out.push_back({ "parse_number", *text, text->size(),
+                            [text]
+                            {
+                                std::int64_t integer;
+                                double       decimal;
+                                auto result = detail::convert_number(*text, integer, decimal);
+                                keep(result);
+                                keep(integer);
+                                keep(decimal);
+                            }
+                          });
+        }
+    }
+
+    for (double value : { 3.0, 0.1, 2.5e-3, 123456.789, 1.0 / 3.0, 6.02214076e23, 4.9e-324 })
+    {
+        char text[detail::max_formatted_decimal_length];
+        out.push_back({ "write_decimal", std::string(text, detail::format_decimal(text, value)), 0,
+                        [value]
+                        {
+                            char        buffer[detail::max_formatted_decimal_length];
+                            std::size_t length = detail::format_decimal(buffer, value);
+                            keep(buffer);
+                            keep(length);
+                        }
+                      });
+    }
+
+    return out;
+}
+
+static int usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--min-time MS] [--batches N] [FILTER]\n"
+                 "\n"
+                 "  FILTER         Only run the kernels whose name contains FILTER.\n"
+                 "  --min-time MS  The shortest time a batch of operations takes (default 20).\n"
+                 "  --batches N    The number of batches; the fastest operation of any of them is shown (default 5).\n";
+    return 1;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    using namespace jsonv_microbench;
+
+    std::string filter;
+    long        min_time_ms = 20;
+    long        batches     = 5;
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        std::string arg = argv[idx];
+        if (arg == "--min-time" && idx + 1 < argc)
+            min_time_ms = std::atol(argv[++idx]);
+        else if (arg == "--batches" && idx + 1 < argc)
+            batches = std::atol(argv[++idx]);
+        else if (!arg.empty() && arg[0] == '-')
+            return usage(argv[0]);
+        else
+            filter = arg;
+    }
+    if (min_time_ms <= 0 || batches <= 0)
+        return usage(argv[0]);
+
+    for (const microbench& bench : all_benchmarks())
+    {
+        if (bench.kernel.find(filter) == std::string::npos)
+            continue;
+        measure(bench, std::chrono::milliseconds(min_time_ms), std::size_t(batches));
+    }
+}
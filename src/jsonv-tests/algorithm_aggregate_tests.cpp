@@ -0,0 +1,115 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/algorithm.hpp>
+#include <jsonv/compiled_path.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/value.hpp>
+
+#include <cstdint>
+#include <limits>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+TEST(aggregate_sum)
+{
+    ensure_eq(value(0), sum(array()));
+    ensure_eq(value(6), sum(array({ 1, "two", 2, null, 3 })));
+    ensure_eq(kind::decimal, sum(array({ 1, 2.5 })).kind());
+    ensure_eq(3.5, sum(array({ 1, 2.5 })).as_decimal());
+    ensure_throws(kind_error, sum(object()));
+
+    // packed arrays (with an odd number of elements, so the last is not in a SIMD lane) add up the same
+    value integers = array();
+    value decimals = array();
+    for (int idx = -50; idx <= 100; ++idx)
+    {
+        integers.push_back(idx * 1000003);
+        decimals.push_back(idx * 0.5);
+    }
+    value expected_integers = sum(integers);
+    ensure(integers.pack_numbers());
+    ensure(decimals.pack_numbers());
+    ensure_eq(expected_integers, sum(integers));
+    ensure_eq(1887.5, sum(decimals).as_decimal());
+
+    // sums which do not fit in an integer become decimals, but going over and back is still exact
+    const std::int64_t big = std::numeric_limits<std::int64_t>::max();
+    value over = array({ big, big, big, big, big, big, big, big, 1 });
+    ensure(over.pack_numbers());
+    ensure_eq(kind::decimal, sum(over).kind());
+    value back = array({ big, big, big, big, -big, -big, -big, -big, 1 });
+    ensure(back.pack_numbers());
+    ensure_eq(value(1), sum(back));
+    ensure_eq(value(1), sum(array({ big, big, -big, -big, 1, "x" })));
+}
+
+TEST(aggregate_min_max)
+{
+    ensure_eq(null, min(array({ "a", null })));
+    ensure_eq(value(-3), min(array({ 4, -3, "x", 7 })));
+    ensure_eq(value(7), max(array({ 4, -3, "x", 7 })));
+    ensure_eq(value(-3.5), min(array({ 4, -3, -3.5 })));
+    ensure_eq(value(4), max(array({ 4, -3, 3.5 })));
+
+    value integers = array();
+    value decimals = array();
+    for (int idx = 0; idx < 101; ++idx)
+    {
+        integers.push_back((idx * 37) % 101 - 50);
+        decimals.push_back(((idx * 37) % 101 - 50) * 0.25);
+    }
+    ensure(integers.pack_numbers());
+    ensure(decimals.pack_numbers());
+    ensure_eq(value(-50), min(integers));
+    ensure_eq(value(50), max(integers));
+    ensure_eq(value(-12.5), min(decimals));
+    ensure_eq(value(12.5), max(decimals));
+}
+
+TEST(aggregate_projection)
+{
+    value orders = parse(R"({ "rows": [ { "id": 1, "total": 10, "user": "a" },
+                                        { "id": 2, "total": 2.5, "user": "b" },
+                                        { "id": 3, "user": "a" },
+                                        { "id": 4, "total": 7, "user": 1 } ] })");
+    compiled_path totals = compiled_path::create(".rows[*].total");
+    ensure_eq(19.5, sum(orders, totals).as_decimal());
+    ensure_eq(value(2.5), min(orders, totals));
+    ensure_eq(value(10), max(orders, totals));
+    ensure_eq(2U, count_if(orders, totals, [] (const value& x) { return x.kind() == kind::integer; }));
+
+    value rows = orders.at("rows");
+    ensure_eq(3U, count_if(rows, [] (const value& x) { return x.count("total") > 0; }));
+
+    value by_user = group_by(rows, compiled_path::create(".user"));
+    ensure_eq(3U, by_user.size());
+    ensure_eq(2U, by_user.at("a").size());
+    ensure_eq(value(3), by_user.at("a")[1].at("id"));
+    ensure_eq(value(2), by_user.at("b")[0].at("id"));
+    ensure_eq(value(4), by_user.at("1")[0].at("id"));
+}
+
+TEST(aggregate_count_if_packed)
+{
+    value numbers = array();
+    for (int idx = 0; idx < 20; ++idx)
+        numbers.push_back(idx);
+    ensure(numbers.pack_numbers());
+    ensure_eq(10U, count_if(numbers, [] (const value& x) { return x.as_integer() % 2 == 0; }));
+    ensure(numbers.packed_integers() != nullptr);
+}
+
+}
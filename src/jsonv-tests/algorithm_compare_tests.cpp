@@ -11,8 +11,12 @@
 #include "test.hpp"
 
 #include <jsonv/algorithm.hpp>
+#include <jsonv/parse.hpp>
 #include <jsonv/value.hpp>
 
+#include <functional>
+#include <vector>
+
 namespace jsonv_test
 {
 
@@ -41,4 +45,54 @@ TEST(compare_icase_empty)
     ensure_lt(compare_icase("", "a"), 0);
 }
 
+
+static int sign(int x)
+{
+    return x < 0 ? -1 : x > 0 ? 1 : 0;
+}
+
+TEST(compare_matches_traits)
+{
+    std::vector<value> values = { null, true, false, 1, 2.5, -7, 2, "", "a", "ab", "b",
+                                  parse("[]"), parse("[1, 2, 3]"), parse("[1, 2]"), parse("[1, 2.0, 4]"),
+                                  parse("[1, \"x\", [2]]"), parse("[1, \"x\", [3]]"),
+                                  parse("{}"), parse(R"({"a": 1})"), parse(R"({"a": 1, "b": 2})"),
+                                  parse(R"({"a": 2})"), parse(R"({"b": 1})"), parse(R"({"a": [1, {"c": null}]})"),
+                                };
+    for (const value& a : values)
+    {
+        for (const value& b : values)
+        {
+            int expected = sign(compare(a, b, compare_traits()));
+            ensure_eq(expected, sign(compare(a, b)));
+            ensure_eq(expected == 0, a == b);
+            ensure_eq(expected != 0, a != b);
+            ensure_eq(expected < 0, a < b);
+        }
+    }
+}
+
+TEST(compare_shared_storage)
+{
+    value a = parse(R"({"list": [1, 2, 3, 4], "name": "some string which is not short", "sub": {"x": 1}})");
+    a.make_shareable();
+    const value b = a;
+    ensure_eq(0, compare(a, b));
+    ensure(a == b);
+    ensure(a.at("list") == b.at("list"));
+    
+    // Remembered hashes which differ mean the values differ
+    value c = parse(R"({"list": [1, 2, 3, 5], "name": "some string which is not short", "sub": {"x": 1}})");
+    c.make_shareable();
+    std::hash<value> hasher;
+    ensure(hasher(a) != hasher(c));
+    ensure(a != c);
+    ensure_lt(compare(a, c), 0);
+    
+    value d = b;
+    d["list"][3] = 5;
+    ensure(d == c);
+    ensure(d != b);
+}
+
 }
@@ -69,4 +69,78 @@ private:
     std::deque<std::unique_ptr<unit_test>> _tests;
 } json_diff_test_initializer_instance(test_path("diffs"));
 
+/** Get the result of applying \a ops to a copy of \a target. **/
+static value patched(value target, const value& ops)
+{
+    apply_patch(target, ops);
+    return target;
+}
+
+TEST(diff_const_inputs)
+{
+    const value left  = parse(R"({ "a": [1, 2, { "x": 1 }], "b": "same", "c": true })");
+    const value right = parse(R"({ "a": [1, 3, { "x": 1 }], "b": "same", "d": null })");
+    
+    diff_result result = diff(left, right);
+    ensure_eq(parse(R"({ "b": "same" })"), result.same);
+    ensure_eq(parse(R"({ "a": [null, 2, null], "c": true })"), result.left);
+    ensure_eq(parse(R"({ "a": [null, 3, null], "d": null })"), result.right);
+    ensure_eq(parse(R"({ "a": [1, 2, { "x": 1 }], "b": "same", "c": true })"), left);
+}
+
+TEST(diff_patch_simple)
+{
+    value from = parse(R"({ "a": [1, 2, 3], "b": "x", "k~/": { "n": 5.0 } })");
+    value to   = parse(R"({ "a": [3, 1, 2], "c": "x", "k~/": { "n": 6 } })");
+    value ops  = diff_patch(from, to);
+    ensure_eq(parse(R"([ { "op": "move",    "from": "/a/2", "path": "/a/0" },
+                         { "op": "remove",  "path": "/b" },
+                         { "op": "replace", "path": "/k~0~1/n", "value": 6 },
+                         { "op": "add",     "path": "/c", "value": "x" }
+                       ]
+                      )"
+                   ),
+              ops
+             );
+    ensure_eq(to, patched(from, ops));
+    
+    ensure_eq(array(), diff_patch(from, from));
+    ensure_eq(parse(R"([ { "op": "replace", "path": "", "value": [] } ])"), diff_patch(from, array()));
+}
+
+TEST(diff_patch_arrays)
+{
+    auto check = [this] (const char* from_source, const char* to_source, std::size_t expected_ops)
+                 {
+                     value from = parse(from_source);
+                     value to   = parse(to_source);
+                     value ops  = diff_patch(from, to);
+                     ensure_eq(to, patched(from, ops));
+                     ensure_eq(expected_ops, ops.size());
+                 };
+    
+    check("[1, 2, 3, 4]",            "[2, 3, 4, 1]",            1);
+    check("[1, 2, 3, 4]",            "[4, 1, 2, 3]",            1);
+    check("[1, 2, 3, 4]",            "[4, 3, 2, 1]",            3);
+    check("[1, 2, 3]",               "[1, 3]",                  1);
+    check("[1, 3]",                  "[1, 2, 3]",               1);
+    check("[1, 2, 3]",               "[]",                      3);
+    check("[]",                      "[1, 2]",                  2);
+    check("[{ \"a\": 1 }, 2]",       "[{ \"a\": 2 }, 2]",       1);
+    check("[{ \"a\": 1 }, 2, 3]",    "[3, { \"a\": 1 }, 2, 7]", 2);
+    check("[1, 1, 2, 1]",            "[1, 2, 1, 1]",            1);
+    check("[\"x\", 1, \"y\", 2]",    "[2, \"z\", 1]",           3);
+    
+    value from = array();
+    value to   = array();
+    for (int idx = 0; idx < 200; ++idx)
+    {
+        from.push_back(object({ { "id", idx }, { "tags", array({ idx % 7, idx % 11 }) } }));
+        if (idx % 13 != 0)
+            to.push_back(idx % 17 == 0 ? value(idx) : from[idx]);
+    }
+    std::rotate(to.begin_array(), to.begin_array() + 50, to.end_array());
+    ensure_eq(to, patched(from, diff_patch(from, to)));
+}
+
 }
@@ -13,6 +13,8 @@
 #include <jsonv/algorithm.hpp>
 #include <jsonv/value.hpp>
 
+#include <stdexcept>
+
 namespace jsonv_test
 {
 
@@ -66,4 +68,59 @@ TEST(map_object_rvalue)
     ensure_eq(result, object({ { "one", 2 }, { "two", 4 } }));
 }
 
+TEST(map_template_callable)
+{
+    int   factor = 3;
+    value init   = array({ 1, 2, 3 });
+    value result = map([factor] (const value& x) { return x.as_integer() * factor; }, init);
+    ensure_eq(result, array({ 3, 6, 9 }));
+    
+    result = map([factor] (value x) { return x.as_integer() * factor; }, value(object({ { "a", 1 }, { "b", 2 } })));
+    ensure_eq(result, object({ { "a", 3 }, { "b", 6 } }));
+}
+
+TEST(map_parallel)
+{
+    value array_init  = array();
+    value object_init = object();
+    for (int idx = 0; idx < 1000; ++idx)
+    {
+        array_init.push_back(idx);
+        object_init[std::to_string(idx)] = idx;
+    }
+    auto func = [] (const value& x) { return x.as_integer() * 2; };
+    
+    for (const value& init : { array_init, object_init, value(5) })
+    {
+        value expected = map(func, init);
+        ensure_eq(expected, map_parallel(func, init, 4));
+        ensure_eq(expected, map_parallel(func, init, 1));
+        ensure_eq(expected, map_parallel(func, init));
+        
+        value moved = init;
+        ensure_eq(expected, map_parallel([] (value x) { return x.as_integer() * 2; }, std::move(moved), 4));
+        if (init.kind() != kind::integer)
+            ensure_eq(moved, value(null));
+    }
+}
+
+TEST(map_parallel_throws)
+{
+    value init = array();
+    for (int idx = 0; idx < 1000; ++idx)
+        init.push_back(idx);
+    
+    ensure_throws(std::runtime_error,
+                  map_parallel([] (const value& x) -> value
+                               {
+                                   if (x.as_integer() % 100 == 99)
+                                       throw std::runtime_error("bad element");
+                                   return x;
+                               },
+                               init,
+                               4
+                              )
+                 );
+}
+
 }
@@ -17,6 +17,8 @@
 #include <jsonv/value.hpp>
 
 #include <fstream>
+#include <stdexcept>
+#include <string>
 
 namespace jsonv_test
 {
@@ -27,6 +29,36 @@ TEST(merge_single)
     ensure_eq(jsonv::null, x);
 }
 
+TEST(merge_into_splices)
+{
+    std::string  long_text(100, 'x');
+    jsonv::value target = jsonv::parse(R"({ "a": { "b": 1, "c": [1] }, "d": "keep" })");
+    jsonv::value source = jsonv::object({ { "a", jsonv::object({ { "c", jsonv::array({ 2 }) }, { "e", long_text } }) },
+                                          { "f", jsonv::array({ long_text }) },
+                                        }
+                                       );
+    const char* e_text = source.at_path(".a.e").as_string().c_str();
+    const char* f_text = source.at_path(".f[0]").as_string().c_str();
+    
+    jsonv::merge_into(target, std::move(source), jsonv::recursive_merge_rules());
+    jsonv::value expected = jsonv::object({ { "a", jsonv::object({ { "b", 1 },
+                                                                   { "c", jsonv::array({ 1, 2 }) },
+                                                                   { "e", long_text },
+                                                                 }
+                                                                )
+                                            },
+                                            { "d", "keep" },
+                                            { "f", jsonv::array({ long_text }) },
+                                          }
+                                         );
+    ensure_eq(expected, target);
+    ensure(e_text == target.at_path(".a.e").as_string().c_str());
+    ensure(f_text == target.at_path(".f[0]").as_string().c_str());
+    
+    jsonv::value other = jsonv::object({ { "d", "again" } });
+    ensure_throws(std::logic_error, jsonv::merge_into(target, std::move(other)));
+}
+
 template <typename TMergeRules>
 class json_merge_test :
         public unit_test
@@ -53,6 +85,10 @@ public:
             jsonv::value result = jsonv::merge_explicit(rules, jsonv::path(), a, b);
             ensure(!expect_failure);
             ensure_eq(expected, result);
+            
+            jsonv::value in_place = a;
+            jsonv::merge_into(in_place, jsonv::value(b), rules);
+            ensure_eq(expected, in_place);
         }
         catch (...)
         {
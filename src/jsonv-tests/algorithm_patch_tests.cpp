@@ -0,0 +1,112 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/algorithm.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/value.hpp>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+TEST(apply_patch_operations)
+{
+    value target = parse(R"({ "a": { "b": [1, 2, 3], "c": "x" }, "k/~": 1 })");
+    apply_patch(target,
+                parse(R"([ { "op": "test",    "path": "/a/c",       "value": "x"      },
+                           { "op": "add",     "path": "/a/b/1",     "value": 10       },
+                           { "op": "add",     "path": "/a/b/-",     "value": 20       },
+                           { "op": "remove",  "path": "/a/b/0"                        },
+                           { "op": "replace", "path": "/a/c",       "value": { "d": 1 } },
+                           { "op": "copy",    "from": "/a/c",       "path": "/e"      },
+                           { "op": "move",    "from": "/a/b/3",     "path": "/a/c/f"  },
+                           { "op": "move",    "from": "/k~1~0",     "path": "/a/b/0"  },
+                           { "op": "add",     "path": "/a/",        "value": null     }
+                         ]
+                        )"
+                     )
+               );
+    ensure_eq(parse(R"({ "a": { "b": [1, 10, 2, 3], "c": { "d": 1, "f": 20 }, "": null }, "e": { "d": 1 } })"),
+              target
+             );
+    
+    apply_patch(target,
+                parse(R"([ { "op": "replace", "path": "", "value": [1] }, { "op": "add", "path": "/0", "value": 0 } ])")
+               );
+    ensure_eq(array({ 0, 1 }), target);
+}
+
+TEST(apply_patch_errors)
+{
+    const value original = parse(R"({ "a": [1, 2], "b": { "c": 1 } })");
+    auto        failed_at = [&] (const char* patch_source)
+                            {
+                                value target = original;
+                                try
+                                {
+                                    apply_patch(target, parse(patch_source));
+                                }
+                                catch (const patch_error& err)
+                                {
+                                    return int(err.operation_index());
+                                }
+                                return -1;
+                            };
+    
+    ensure_eq(-1, failed_at(R"([])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "test", "path": "/a/0", "value": 2 } ])"));
+    ensure_eq(1,  failed_at(R"([ { "op": "remove", "path": "/a/1" }, { "op": "remove", "path": "/a/1" } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "add", "path": "/a/3", "value": 1 } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "add", "path": "/a/01", "value": 1 } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "add", "path": "/x/y", "value": 1 } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "add", "path": "a", "value": 1 } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "add", "path": "/b/c/d", "value": 1 } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "replace", "path": "/b/d", "value": 1 } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "move", "from": "/b", "path": "/b/c" } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "remove", "path": "/a/-" } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "remove", "path": "/b/~2" } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "frobnicate", "path": "/a" } ])"));
+    ensure_eq(0,  failed_at(R"([ { "path": "/a" } ])"));
+    ensure_eq(0,  failed_at(R"([ { "op": "add", "path": "/a/0" } ])"));
+    ensure_eq(0,  failed_at(R"({})"));
+}
+
+TEST(apply_patch_diff_round_trip)
+{
+    value from = array();
+    for (int idx = 0; idx < 50; ++idx)
+        from.push_back(object({ { "id", idx }, { "children", array({ idx, idx * 2 }) } }));
+    value to = from;
+    to[3]["children"].push_back(7);
+    to.erase(to.begin_array() + 10);
+    to.push_back(to[0]);
+    to[20]["id"] = "twenty";
+    
+    value target = from;
+    apply_patch(target, diff_patch(from, to));
+    ensure_eq(to, target);
+}
+
+TEST(apply_merge_patch)
+{
+    value target = parse(R"({ "a": "b", "c": { "d": "e", "f": "g" }, "h": [1] })");
+    apply_merge_patch(target,
+                      parse(R"({ "a": "z", "c": { "f": null, "x": { "y": 1 } }, "h": { "i": null }, "j": null })")
+                     );
+    ensure_eq(parse(R"({ "a": "z", "c": { "d": "e", "x": { "y": 1 } }, "h": {} })"), target);
+    
+    apply_merge_patch(target, array({ 1 }));
+    ensure_eq(array({ 1 }), target);
+}
+
+}
@@ -0,0 +1,166 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "allocation_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+
+namespace jsonv_test
+{
+
+namespace
+{
+
+std::atomic<std::size_t> total_count { 0 };
+std::atomic<std::size_t> total_bytes { 0 };
+std::atomic<std::size_t> live_bytes  { 0 };
+std::atomic<std::size_t> peak_bytes  { 0 };
+std::atomic<bool>        counting    { true };
+
+/** Each block starts with its size, padded out so the memory given out is aligned like \c std::malloc 's. **/
+constexpr std::size_t header_size = alignof(std::max_align_t);
+
+void* counted_allocate(std::size_t size) noexcept
+{
+    void* block = std::malloc(header_size + size);
+    if (!block)
+        return nullptr;
+
+    // blocks allocated while not counting are marked with a zero size, so freeing them is not counted either
+    if (!counting.load(std::memory_order_relaxed))
+    {
+        *static_cast<std::size_t*>(block) = 0;
+        return static_cast<char*>(block) + header_size;
+    }
+
+    *static_cast<std::size_t*>(block) = size;
+    total_count.fetch_add(1, std::memory_order_relaxed);
+    total_bytes.fetch_add(size, std::memory_order_relaxed);
+    std::size_t live = live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::size_t peak = peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    { }
+
+    return static_cast<char*>(block) + header_size;
+}
+
+void* counted_allocate_or_throw(std::size_t size)
+{
+    void* out = counted_allocate(size);
+    while (!out)
+    {
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+        out = counted_allocate(size);
+    }
+    return out;
+}
+
+void counted_free(void* ptr) noexcept
+{
+    if (!ptr)
+        return;
+
+    void* block = static_cast<char*>(ptr) - header_size;
+    if (std::size_t size = *static_cast<std::size_t*>(block))
+        live_bytes.fetch_sub(size, std::memory_order_relaxed);
+    std::free(block);
+}
+
+}
+
+allocation_counter::allocation_counter() :
+        _start_count(total_count.load()),
+        _start_bytes(total_bytes.load()),
+        _start_live(live_bytes.load())
+{
+    peak_bytes.store(_start_live);
+}
+
+void allocation_counter::set_counting(bool enabled)
+{
+    counting.store(enabled);
+}
+
+allocation_stats allocation_counter::stats() const
+{
+    allocation_stats out;
+    out.count      = total_count.load() - _start_count;
+    out.bytes      = total_bytes.load() - _start_bytes;
+    std::size_t peak = peak_bytes.load();
+    out.peak_bytes = peak > _start_live ? peak - _start_live : 0;
+    return out;
+}
+
+std::ostream& operator<<(std::ostream& os, const allocation_stats& x)
+{
+    os << "{\"allocations\": " << x.count;
+    os << ", \"bytes\": "      << x.bytes;
+    os << ", \"peak_bytes\": " << x.peak_bytes;
+    os << '}';
+    return os;
+}
+
+}
+
+void* operator new(std::size_t size)
+{
+    return jsonv_test::counted_allocate_or_throw(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return jsonv_test::counted_allocate_or_throw(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return jsonv_test::counted_allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return jsonv_test::counted_allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    jsonv_test::counted_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    jsonv_test::counted_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    jsonv_test::counted_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    jsonv_test::counted_free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    jsonv_test::counted_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    jsonv_test::counted_free(ptr);
+}
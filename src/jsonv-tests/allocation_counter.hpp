@@ -0,0 +1,64 @@
+/** \file
+ *  Counting the allocations made through the global \c operator \c new.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_TESTS_ALLOCATION_COUNTER_HPP_INCLUDED__
+#define __JSONV_TESTS_ALLOCATION_COUNTER_HPP_INCLUDED__
+
+#include <cstddef>
+#include <iosfwd>
+
+namespace jsonv_test
+{
+
+/** Allocations made while an \c allocation_counter was running. **/
+struct allocation_stats
+{
+    std::size_t count      = 0; //!< The number of calls to \c operator \c new
+    std::size_t bytes      = 0; //!< The bytes asked for by those calls
+    std::size_t peak_bytes = 0; //!< The most bytes which were allocated (and not freed) since the start at once
+};
+
+std::ostream& operator<<(std::ostream&, const allocation_stats&);
+
+/** Measures the allocations made (on any thread) from when it is created. Linking \c allocation_counter.cpp into a
+ *  program replaces the global \c operator \c new and \c operator \c delete with versions which keep the totals.
+ *
+ *  The peak is tracked globally, so only one of these should be running at a time.
+ *
+ *  \code
+ *  allocation_counter counter;
+ *  jsonv::value val = jsonv::parse(text);
+ *  std::cout << counter.stats().count << " allocations" << std::endl;
+ *  \endcode
+**/
+class allocation_counter
+{
+public:
+    allocation_counter();
+
+    /** Turn counting on or off for the whole program (it starts on). Counting is a few operations on shared atomics for
+     *  every allocation, which is what multi-threaded code contends on when it is on; while it is off, allocations are
+     *  not counted at all.
+    **/
+    static void set_counting(bool enabled);
+
+    /** Get the allocations since this was created. **/
+    allocation_stats stats() const;
+
+private:
+    std::size_t _start_count;
+    std::size_t _start_bytes;
+    std::size_t _start_live;
+};
+
+}
+
+#endif/*__JSONV_TESTS_ALLOCATION_COUNTER_HPP_INCLUDED__*/
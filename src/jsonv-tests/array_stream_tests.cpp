@@ -0,0 +1,84 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/array_stream.hpp>
+#include <jsonv/tokenizer.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace jsonv;
+
+TEST(array_stream_root)
+{
+    std::istringstream input(R"([ {"id": 1}, [2, 3], "four", 5, null ])");
+    array_range        elements_range = array_stream(input);
+    value              elements       = array();
+    std::size_t        expected_index = 0;
+    for (auto iter = elements_range.begin(); iter != elements_range.end(); ++iter)
+        elements.push_back(*iter);
+    ensure_eq(parse(R"([ {"id": 1}, [2, 3], "four", 5, null ])"), elements);
+
+    std::istringstream again(R"([[1], [2], [3]])");
+    array_range        range = array_stream(again);
+    for (const value& element : range)
+    {
+        ensure_eq(expected_index, range.index());
+        ensure_eq(array({ int(++expected_index) }), element);
+    }
+    ensure_eq(3U, expected_index);
+
+    std::istringstream empty("  [ ] ");
+    array_range        empty_range = array_stream(empty);
+    ensure(empty_range.begin() == empty_range.end());
+}
+
+TEST(array_stream_path)
+{
+    std::string input = R"({
+        "meta": { "records": ["not", "these"] },
+        "pages": [ { "records": [] }, { "skip": [1, {"records": 2}], "records": [ {"n": 1}, {"n": 2} ] } ],
+        "after": "this is never read
+    )";
+
+    // nothing after the end of the array is looked at, so the broken text after it does not matter
+    tokenizer tokens(input);
+    value     found = array();
+    for (const value& element : array_stream(tokens, path::create(".pages[1].records")))
+        found.push_back(element);
+    ensure_eq(parse(R"([{"n": 1}, {"n": 2}])"), found);
+    ensure(tokens.current().kind == token_kind::array_end);
+}
+
+TEST(array_stream_errors)
+{
+    auto first_of = [] (const std::string& text, const char* at)
+                    {
+                        std::istringstream input(text);
+                        array_range        range = array_stream(input, path::create(at));
+                        return *range.begin();
+                    };
+
+    ensure_throws(kind_error, first_of(R"({"a": 1})", ""));
+    ensure_throws(kind_error, first_of(R"({"a": 1})", ".a"));
+    ensure_throws(kind_error, first_of(R"([[1]])", ".a"));
+    ensure_throws(std::out_of_range, first_of(R"({"a": [1]})", ".b"));
+    ensure_throws(std::out_of_range, first_of(R"([[1]])", "[1]"));
+    ensure_throws(parse_error, first_of(R"({"a" [1]})", ".a"));
+
+    std::istringstream broken(R"([1, {"a": }, 3])");
+    array_range        range = array_stream(broken);
+    auto               iter  = range.begin();
+    ensure_eq(value(1), *iter);
+    ensure_throws(parse_error, ++iter);
+}
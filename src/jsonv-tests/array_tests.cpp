@@ -11,10 +11,14 @@
 #include "test.hpp"
 
 #include <jsonv/array.hpp>
+#include <jsonv/encode.hpp>
+#include <jsonv/memory_usage.hpp>
 #include <jsonv/parse.hpp>
 
 #include <algorithm>
+#include <iterator>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 TEST(array)
@@ -212,6 +216,129 @@ TEST(array_multi_insertion)
     ensure_eq(arr, array({ 0, 1, 2, 3, 4, 5 }));
 }
 
+TEST(array_emplace_and_range_insert)
+{
+    jsonv::value arr = jsonv::array();
+    arr.reserve(4);
+    const jsonv::value* data = arr.array_data();
+    jsonv::value& added = arr.emplace_back("one");
+    arr.emplace_back(2);
+    arr.emplace_back();
+    ensure_eq("one", added.as_string());
+    ensure(arr.array_data() == data);
+    ensure_eq(jsonv::array({ "one", 2, jsonv::null }), arr);
+    
+    std::vector<jsonv::value> items = { 10, "a string which is too long to be stored inline", 12 };
+    arr.insert(arr.begin_array() + 1, std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+    ensure_eq(jsonv::array({ "one", 10, "a string which is too long to be stored inline", 12, 2, jsonv::null }), arr);
+    ensure(items[1].is_null());
+    
+    std::vector<int> numbers = { 7, 8 };
+    arr.insert(arr.end_array(), numbers.begin(), numbers.end());
+    ensure_eq(8, arr.at(7).as_integer());
+    ensure_throws(jsonv::kind_error, jsonv::value("x").reserve(1));
+}
+
+TEST(array_data_contiguous)
+{
+    jsonv::value arr = jsonv::array();
+    for (int idx = 0; idx < 1000; ++idx)
+        arr.push_back(idx);
+    arr.push_front(-1);
+    
+    const jsonv::value* data = arr.array_data();
+    for (jsonv::value::size_type idx = 0; idx < arr.size(); ++idx)
+        ensure(&data[idx] == &arr[idx]);
+    ensure_eq(-1, data[0].as_integer());
+    ensure_eq(999, data[1000].as_integer());
+    ensure_throws(jsonv::kind_error, jsonv::value(5).array_data());
+}
+
+TEST(array_pack_numbers)
+{
+    using namespace jsonv;
+    const parse_options options = parse_options().pack_numbers(true);
+    value doc = parse(R"({
+                           "ints":   [1, 2, 3, 4, 5, 6, 7, 8, 9],
+                           "points": [[1.5, -2.5, 3.25, 4.0, 0.5, 6.5, 7.5, 8.5],
+                                      [0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5]],
+                           "mixed":  [1, 2.5, 3, 4, 5, 6, 7, 8, 9],
+                           "few":    [1, 2, 3]
+                         })",
+                      options
+                     );
+    const value& ints = doc.at("ints");
+    ensure(ints.packed_integers() != nullptr);
+    ensure(ints.packed_decimals() == nullptr);
+    ensure(doc.at("points").at(0).packed_decimals() != nullptr);
+    ensure(doc.at("points").packed_integers() == nullptr);
+    ensure(doc.at("mixed").packed_integers() == nullptr);
+    ensure(doc.at("few").packed_integers() == nullptr);
+    ensure(value(5).packed_integers() == nullptr);
+    ensure_throws(kind_error, value(5).pack_numbers());
+
+    // packed arrays are not different from any other
+    value unpacked = parse(to_string(doc));
+    ensure_eq(R"({"few":[1,2,3],"ints":[1,2,3,4,5,6,7,8,9],"mixed":[1,2.5,3,4,5,6,7,8,9],)"
+              R"("points":[[1.5,-2.5,3.25,4,0.5,6.5,7.5,8.5],[0.5,1.5,2.5,3.5,4.5,5.5,6.5,7.5]]})",
+              to_string(doc)
+             );
+    ensure(doc.at("points").at(1).packed_decimals() != nullptr);
+    ensure(memory_usage(doc).total_bytes() < memory_usage(unpacked).total_bytes());
+    ensure_eq(unpacked, doc);
+    ensure_eq(std::hash<value>()(unpacked), std::hash<value>()(doc));
+    ensure_eq(unpacked.at("ints"), ints);
+
+    // looking at an element keeps the buffer until the array is changed
+    const std::int64_t* packed = ints.packed_integers();
+    ensure_eq(2, ints[1].as_integer());
+    ensure_eq(9U, ints.size());
+    ensure(packed == ints.packed_integers());
+    ensure_eq(3, packed[2]);
+
+    value copy = ints;
+    copy.push_back(10);
+    ensure(copy.packed_integers() != nullptr);
+    copy.push_back("eleven");
+    ensure(copy.packed_integers() == nullptr);
+    ensure_eq(array({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, "eleven" }), copy);
+    ensure_eq(9U, ints.size());
+
+    value built = array({ 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5 });
+    ensure(built.pack_numbers());
+    built[0] = 9;
+    ensure(built.packed_decimals() == nullptr);
+    ensure_eq(value(9), built[0]);
+    ensure(!built.pack_numbers());
+}
+
+TEST(array_pack_numbers_shared)
+{
+    using namespace jsonv;
+    value numbers = array();
+    for (int idx = 0; idx < 10000; ++idx)
+        numbers.push_back(idx * 0.5);
+    ensure(numbers.pack_numbers());
+    numbers.make_shareable();
+
+    // every thread looks the elements up at once, which makes values out of the buffer in one of them
+    std::vector<double>      sums(4, 0.0);
+    std::vector<std::thread> threads;
+    for (std::size_t thread = 0; thread < sums.size(); ++thread)
+        threads.emplace_back([&, thread]
+                             {
+                                 value copy = numbers;
+                                 for (const value& x : copy.as_array())
+                                     sums[thread] += x.as_decimal();
+                             }
+                            );
+    for (std::thread& thread : threads)
+        thread.join();
+    for (double sum : sums)
+        ensure_eq(0.5 * 9999 * 10000 / 2, sum);
+    ensure(numbers.packed_decimals() != nullptr);
+}
+
 TEST(array_iterate_over_temp)
 {
     using namespace jsonv;
@@ -9,6 +9,7 @@
  *  \author Travis Gockel (travis@gockelhut.com)
 **/
 #include "test.hpp"
+#include "allocation_counter.hpp"
 #include "chrono_io.hpp"
 #include "filesystem_util.hpp"
 #include "stopwatch.hpp"
@@ -30,16 +31,22 @@ static const unsigned iterations = JSONV_DEBUG ? 1 : 100;
 template <typename THolster, typename FLoader>
 static void run_test(FLoader load, const std::string& from)
 {
-    stopwatch timer;
+    stopwatch        timer;
+    allocation_stats allocations;
     for (unsigned cnt = 0; cnt < iterations; ++cnt)
     {
         THolster src_data{load(from)};
         {
-            JSONV_TEST_TIME(timer);
-            parse(src_data);
+            // the allocations are the same every time, so they are only counted for one parse (including freeing it)
+            allocation_counter counter;
+            {
+                JSONV_TEST_TIME(timer);
+                parse(src_data);
+            }
+            allocations = counter.stats();
         }
     }
-    std::cout << timer.get();
+    std::cout << timer.get() << ' ' << allocations;
 }
 
 template <typename THolster>
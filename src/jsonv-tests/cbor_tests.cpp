@@ -0,0 +1,203 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/cbor.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/value.hpp>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+namespace
+{
+
+static std::string from_hex(const std::string& hex)
+{
+    std::string out;
+    for (std::size_t idx = 0; idx + 1 < hex.size(); idx += 2)
+        out.push_back(static_cast<char>(std::stoi(hex.substr(idx, 2), nullptr, 16)));
+    return out;
+}
+
+static std::string to_hex(const std::string& bytes)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (char c : bytes)
+    {
+        out.push_back(digits[static_cast<unsigned char>(c) >> 4]);
+        out.push_back(digits[static_cast<unsigned char>(c) & 0xf]);
+    }
+    return out;
+}
+
+}
+
+TEST(cbor_encode_examples)
+{
+    // From Appendix A of RFC 8949
+    std::vector<std::pair<value, std::string>> examples =
+    {
+        { 0,                                    "00"                         },
+        { 23,                                   "17"                         },
+        { 24,                                   "1818"                       },
+        { 100,                                  "1864"                       },
+        { 1000,                                 "1903e8"                     },
+        { 1000000,                              "1a000f4240"                 },
+        { std::int64_t(1000000000000),          "1b000000e8d4a51000"         },
+        { -1,                                   "20"                         },
+        { -100,                                 "3863"                       },
+        { -1000,                                "3903e7"                     },
+        { std::numeric_limits<std::int64_t>::min(), "3b7fffffffffffffff"     },
+        { 0.0,                                  "f90000"                     },
+        { -0.0,                                 "f98000"                     },
+        { 1.0,                                  "f93c00"                     },
+        { 1.1,                                  "fb3ff199999999999a"         },
+        { 1.5,                                  "f93e00"                     },
+        { 65504.0,                              "f97bff"                     },
+        { 100000.0,                             "fa47c35000"                 },
+        { 3.4028234663852886e+38,               "fa7f7fffff"                 },
+        { 1.0e+300,                             "fb7e37e43c8800759c"         },
+        { 5.960464477539063e-8,                 "f90001"                     },
+        { 0.00006103515625,                     "f90400"                     },
+        { -4.0,                                 "f9c400"                     },
+        { -4.1,                                 "fbc010666666666666"         },
+        { std::numeric_limits<double>::infinity(),  "f97c00"                 },
+        { -std::numeric_limits<double>::infinity(), "f9fc00"                 },
+        { std::numeric_limits<double>::quiet_NaN(), "f97e00"                 },
+        { false,                                "f4"                         },
+        { true,                                 "f5"                         },
+        { null,                                 "f6"                         },
+        { "",                                   "60"                         },
+        { "a",                                  "6161"                       },
+        { "IETF",                               "6449455446"                 },
+        { "\xc3\xbc",                           "62c3bc"                     },
+        { array(),                              "80"                         },
+        { array({ 1, 2, 3 }),                   "83010203"                   },
+        { object(),                             "a0"                         },
+        { object({ { "a", 1 }, { "b", array({ 2, 3 }) } }), "a26161016162820203" },
+    };
+
+    for (const auto& example : examples)
+    {
+        ensure_eq(example.second, to_hex(encode_cbor(example.first)));
+        value back = parse_cbor(from_hex(example.second));
+        // compare does not consider infinity equal to itself (or NaN to anything)
+        if (example.first.kind() == kind::decimal && std::isnan(example.first.as_decimal()))
+            ensure(std::isnan(back.as_decimal()));
+        else if (example.first.kind() == kind::decimal && std::isinf(example.first.as_decimal()))
+            ensure(example.first.as_decimal() == back.as_decimal());
+        else
+            ensure_eq(example.first, back);
+    }
+}
+
+TEST(cbor_parse_examples)
+{
+    ensure_eq(value(1363896240), parse_cbor(from_hex("c11a514b67b0")));
+    ensure_eq(null, parse_cbor(from_hex("f7")));
+    ensure_eq(value(18446744073709551615.0), parse_cbor(from_hex("1bffffffffffffffff")));
+    ensure_eq(value(-18446744073709551616.0), parse_cbor(from_hex("3bffffffffffffffff")));
+    ensure_eq(value(1.0), parse_cbor(from_hex("fb3ff0000000000000")));
+    ensure_eq(value(100000.0), parse_cbor(from_hex("fa47c35000")));
+
+    // Indefinite lengths
+    ensure_eq(array(), parse_cbor(from_hex("9fff")));
+    ensure_eq(parse("[1, [2, 3], [4, 5]]"), parse_cbor(from_hex("9f018202039f0405ffff")));
+    ensure_eq(parse(R"({"a": 1, "b": [2, 3]})"), parse_cbor(from_hex("bf61610161629f0203ffff")));
+    ensure_eq(value("streaming"), parse_cbor(from_hex("7f657374726561646d696e67ff")));
+    ensure_eq(parse(R"({"Fun": true, "Amt": -2})"), parse_cbor(from_hex("bf6346756ef563416d7421ff")));
+}
+
+TEST(cbor_round_trip)
+{
+    value source = parse(R"({
+                              "name": "some name which is longer than twenty-three bytes",
+                              "numbers": [0, -1, 255, 256, 65535, 65536, 4294967296, -4294967297, 0.1, 2.5e-310],
+                              "nested": [{"a": null}, {"b": [true, false]}, [], {}],
+                              "empty": ""
+                            })");
+    ensure_eq(source, parse_cbor(encode_cbor(source)));
+
+    // Output handed to a flush function comes out the same, however small the chunks are
+    std::string chunked;
+    {
+        cbor_encoder encoder([&] (string_view chunk) { chunked.append(chunk.data(), chunk.size()); }, 16);
+        encoder.encode(source);
+    }
+    ensure_eq(encode_cbor(source), chunked);
+
+    // Containers of an unknown size (from parse or a writer) are written with indefinite lengths
+    std::string streamed;
+    {
+        cbor_encoder encoder(streamed);
+        parse(R"({"a": [1, 2]})", encoder);
+    }
+    ensure_eq(std::string("bf61619f0102ffff"), to_hex(streamed));
+    ensure_eq(parse(R"({"a": [1, 2]})"), parse_cbor(streamed));
+}
+
+TEST(cbor_parse_errors)
+{
+    ensure_throws(parse_error, parse_cbor(""));
+    ensure_throws(parse_error, parse_cbor(from_hex("1a00")));
+    ensure_throws(parse_error, parse_cbor(from_hex("6461")));
+    ensure_throws(parse_error, parse_cbor(from_hex("4161")));                 // byte string
+    ensure_throws(parse_error, parse_cbor(from_hex("a10102")));               // key is not text
+    ensure_throws(parse_error, parse_cbor(from_hex("ff")));
+    ensure_throws(parse_error, parse_cbor(from_hex("820102ff")));             // break in a definite array
+    ensure_throws(parse_error, parse_cbor(from_hex("bf6161ff")));             // key without a value
+    ensure_throws(parse_error, parse_cbor(from_hex("9bffffffffffffffff00"))); // size larger than the input
+    ensure_throws(parse_error, parse_cbor(from_hex("1c")));                   // reserved
+    ensure_throws(parse_error, parse_cbor(from_hex("f0")));                   // unassigned simple value
+    ensure_throws(parse_error, parse_cbor(from_hex("7f01ff")));               // chunk is not text
+    ensure_throws(parse_error, parse_cbor(from_hex("9fc0ff")));               // tag without an item
+
+    ensure_throws(parse_error, parse_cbor(from_hex("0000")));
+    ensure_eq(value(0), parse_cbor(from_hex("0000"), parse_options().complete_parse(false)));
+
+    std::string deep = from_hex("81818180");
+    ensure_eq(parse("[[[[]]]]"), parse_cbor(deep));
+    ensure_throws(parse_error, parse_cbor(deep, parse_options().max_structure_depth(3)));
+
+    ensure_throws(parse_error, parse_cbor(from_hex("f97c00"), parse_options().require_finite_numbers(true)));
+
+    // every nested header claims the rest of the input, which adds up to far more than the input
+    std::string oversized;
+    for (std::uint32_t rest = 199995; oversized.size() < 200000; rest -= 5)
+    {
+        oversized += '\x9a';
+        for (int shift = 24; shift >= 0; shift -= 8)
+            oversized += char((rest >> shift) & 0xffU);
+    }
+    ensure_throws(parse_error, parse_cbor(oversized));
+
+    try
+    {
+        parse_cbor(from_hex("8201f0"));
+        throw std::runtime_error("Should have thrown");
+    }
+    catch (const parse_error& err)
+    {
+        ensure_eq(2U, err.problems().front().character());
+    }
+}
+
+}
@@ -270,3 +270,50 @@ TEST(string_decode_invalid_utf8_start)
 {
     ensure_throws(decode_error, string_decode_static("\xfe is not a UTF-8 start"));
 }
+
+static std::string string_encode_static(const std::string& source, bool ensure_ascii)
+{
+    std::ostringstream ss;
+    jsonv::detail::string_encode(ss, source, ensure_ascii);
+    return ss.str();
+}
+
+TEST(string_encode_escapes)
+{
+    ensure_eq(R"(a\"b\\c\/d\te\u0001\u007f)", string_encode_static("a\"b\\c/d\te\x01\x7f"));
+    ensure_eq(R"(\u00e4\u2622\ud800\udc00)", string_encode_static("\xc3\xa4\xe2\x98\xa2\xf0\x90\x80\x80"));
+    ensure_eq("\xc3\xa4\\n\xe2\x98\xa2\\u0001", string_encode_static("\xc3\xa4\n\xe2\x98\xa2\x01", false));
+
+    // Bytes which are not valid UTF-8 are written as the code of the byte
+    ensure_eq(R"(\u00ffx\u00e2\u0098)", string_encode_static("\xffx\xe2\x98"));
+}
+
+TEST(string_encode_long_non_ascii)
+{
+    // Enough escapes in a row to fill the batch they are gathered in several times over, with ASCII runs mixed in
+    std::string source;
+    std::string expected;
+    for (int idx = 0; idx < 500; ++idx)
+    {
+        source   += "\xe6\x97\xa5\xe6\x9c\xac";
+        expected += "\\u65e5\\u672c";
+        if (idx % 37 == 0)
+        {
+            source   += "abc\"";
+            expected += "abc\\\"";
+        }
+    }
+    ensure_eq(expected, string_encode_static(source));
+    ensure_eq(expected.size(), jsonv::detail::string_encoded_size(source));
+
+    std::string appended;
+    jsonv::detail::string_encode(appended, source);
+    ensure_eq(expected, appended);
+}
+
+TEST(string_iso_encode)
+{
+    std::ostringstream ss;
+    jsonv::detail::string_iso_encode(ss, "caf\xe9 \"au\" lait/\n\x01");
+    ensure_eq("caf\xe9 \\\"au\\\" lait\\/\\n\x01", ss.str());
+}
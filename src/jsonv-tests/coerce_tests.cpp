@@ -12,7 +12,10 @@
 
 #include <jsonv/coerce.hpp>
 
+#include <iterator>
 #include <limits>
+#include <string>
+#include <utility>
 
 namespace jsonv_test
 {
@@ -63,6 +66,41 @@ TEST(coerce_array_invalid)
     ensure_throws(kind_error, coerce_array(null));
 }
 
+TEST(coerce_views)
+{
+    value obj = object({ { "x", 1 }, { "y", "two" } });
+    auto  obj_view = coerce_object_view(obj);
+    ensure_eq(2, std::distance(obj_view.begin(), obj_view.end()));
+    ensure(&obj_view.begin()->second == &obj.at("x"));
+    ensure_throws(kind_error, coerce_object_view(array()));
+    
+    value arr = array({ 1, "blah", 5.6 });
+    auto  arr_view = coerce_array_view(arr);
+    ensure_eq(3, std::distance(arr_view.begin(), arr_view.end()));
+    ensure(&*arr_view.begin() == &arr[0]);
+    ensure_throws(kind_error, coerce_array_view(object()));
+}
+
+TEST(coerce_containers_move)
+{
+    std::string long_string(100, 'x');
+    value       obj = object({ { "x", long_string } });
+    const char* original = obj.at("x").as_string().c_str();
+    auto        out_obj = coerce_object(std::move(obj));
+    ensure(original == out_obj.at("x").as_string().c_str());
+    
+    value arr = array({ long_string, 2 });
+    original = arr[0].as_string().c_str();
+    auto out_arr = coerce_array(std::move(arr));
+    ensure_eq(2U, out_arr.size());
+    ensure(original == out_arr[0].as_string().c_str());
+    
+    value str = long_string;
+    original = str.as_string().c_str();
+    ensure(original == coerce_string(std::move(str)).c_str());
+    ensure_throws(kind_error, coerce_array(value(object())));
+}
+
 TEST(coerce_string_valid)
 {
     ensure_eq(coerce_string(null), "null");
@@ -239,4 +277,27 @@ TEST(coerce_nulls)
     ensure_throws(kind_error, coerce_null(false));
 }
 
+
+TEST(coerce_in_place)
+{
+    value x = "12";
+    coerce_integer_to(x);
+    ensure_eq(value(12), x);
+    coerce_decimal_to(x);
+    ensure_eq(kind::decimal, x.kind());
+    coerce_boolean_to(x);
+    ensure_eq(value(true), x);
+    coerce_string_to(x);
+    ensure_eq(value("true"), x);
+    
+    // Failed conversions leave the value alone
+    ensure_throws(kind_error, coerce_integer_to(x));
+    ensure_eq(value("true"), x);
+    
+    value already = "some string which is long enough to not be stored inline";
+    const char* original = already.as_string().c_str();
+    coerce_string_to(already);
+    ensure(original == already.as_string().c_str());
+}
+
 }
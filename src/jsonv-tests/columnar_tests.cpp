@@ -0,0 +1,113 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/array_stream.hpp>
+#include <jsonv/columnar.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/value.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+static const char columnar_sample[] =
+    R"({ "rows": [ { "id": 1, "price": 10,   "name": "apple",  "ok": true  },
+                   { "id": 2, "price": 2.5,  "name": "pear",   "ok": false, "tags": [ "x" ] },
+                   { "id": 3,                "name": "apple",  "ok": null  },
+                   { "id": 4, "price": 7,    "name": 4,        "tags": { "y": 1 } } ] })";
+
+TEST(columnar_types)
+{
+    columnar_table table = to_columnar(parse(columnar_sample).at("rows"));
+    ensure_eq(4U, table.rows());
+    ensure_eq(5U, table.columns().size());
+    ensure_eq(column_type::integer, table.at("id").type());
+    ensure_eq(column_type::decimal, table.at("price").type());
+    ensure_eq(column_type::json,    table.at("name").type());
+    ensure_eq(column_type::boolean, table.at("ok").type());
+    ensure_eq(column_type::json,    table.at("tags").type());
+    ensure_throws(std::out_of_range, table.at("missing"));
+
+    const column& id = table.at("id");
+    ensure_eq(0U, id.null_count());
+    ensure_eq(4, id.integers()[3]);
+
+    // the integers before the first decimal are converted
+    const column& price = table.at("price");
+    ensure_eq(1U, price.null_count());
+    ensure(!price.valid(2));
+    ensure_eq(10.0, price.decimals()[0]);
+    ensure_eq(7.0, price.decimals()[3]);
+    ensure_eq(std::uint8_t(0x0b), price.validity()[0]);
+
+    const column& ok = table.at("ok");
+    ensure_eq(2U, ok.null_count());
+    ensure_eq(std::uint8_t(0x01), ok.booleans()[0]);
+
+    // members first seen in later rows are null before them
+    const column& tags = table.at("tags");
+    ensure(!tags.valid(0));
+    ensure_eq(parse(R"({ "y": 1 })"), tags.at(3));
+}
+
+TEST(columnar_dictionary)
+{
+    columnar_builder builder;
+    for (const char* name : { "apple", "pear", "apple", "apple", "fig" })
+        builder.add_row(object({ { "name", name } }));
+    builder.add_row(object());
+    ensure_throws(kind_error, builder.add_row(array()));
+    ensure_eq(6U, builder.rows());
+
+    columnar_table table = builder.finish();
+    ensure_eq(0U, builder.rows());
+    const column& name = table.at("name");
+    ensure_eq(column_type::string, name.type());
+    ensure_eq(3U, name.dictionary_size());
+    ensure_eq(4U, name.dictionary_offsets().size());
+    ensure_eq(std::string("applepearfig"), name.dictionary_data());
+    ensure_eq(std::string("pear"), std::string(name.dictionary_entry(1)));
+    ensure_eq(0, name.indices()[3]);
+    ensure_eq(2, name.indices()[4]);
+    ensure_eq(value("fig"), name.at(4));
+    ensure_eq(null, name.at(5));
+    ensure_throws(std::out_of_range, name.at(6));
+}
+
+TEST(columnar_rows_round_trip)
+{
+    value          rows  = parse(columnar_sample).at("rows");
+    columnar_table table = to_columnar(rows);
+    ensure_eq(object({ { "id", 3 }, { "name", "apple" } }), table.row(2));
+    ensure_eq(2.5, table.row(1).at("price").as_decimal());
+    ensure_eq(rows[3], table.row(3));
+    ensure_throws(std::out_of_range, table.row(4));
+    ensure_throws(kind_error, to_columnar(object()));
+}
+
+TEST(columnar_stream)
+{
+    std::istringstream input(columnar_sample);
+    columnar_table     streamed = to_columnar(array_stream(input, path({ "rows" })));
+    columnar_table     whole    = to_columnar(parse(columnar_sample).at("rows"));
+    ensure_eq(whole.rows(), streamed.rows());
+    ensure_eq(whole.columns().size(), streamed.columns().size());
+    for (std::size_t row = 0; row < whole.rows(); ++row)
+        ensure_eq(whole.row(row), streamed.row(row));
+}
+
+}
@@ -0,0 +1,168 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/compress.hpp>
+#include <jsonv/encode.hpp>
+#include <jsonv/msgpack.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/value.hpp>
+
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+#if JSONV_ZLIB
+
+namespace
+{
+
+static value compress_sample()
+{
+    value rows = array();
+    for (int idx = 0; idx < 2000; ++idx)
+        rows.push_back(object({ { "id", idx }, { "name", "row #" + std::to_string(idx) }, { "even", idx % 2 == 0 } }));
+    return object({ { "rows", rows } });
+}
+
+static std::string gzip(const std::string& plain)
+{
+    std::string out;
+    compressor deflate([&] (string_view chunk) { out.append(chunk.data(), chunk.size()); });
+    deflate.write(plain);
+    deflate.finish();
+    return out;
+}
+
+static std::string gunzip(const std::string& compressed)
+{
+    std::string out;
+    decompressor inflate([&] (string_view chunk) { out.append(chunk.data(), chunk.size()); });
+    inflate.write(compressed);
+    inflate.finish();
+    return out;
+}
+
+}
+
+TEST(compressed_encoder_round_trip)
+{
+    value       source = compress_sample();
+    std::string compressed;
+    {
+        compressed_encoder<buffer_encoder> encoder([&] (string_view chunk)
+                                                   {
+                                                       ensure(chunk.size() <= 256U);
+                                                       compressed.append(chunk.data(), chunk.size());
+                                                   },
+                                                   compression::gzip,
+                                                   9,
+                                                   256
+                                                  );
+        encoder.encode(source);
+        encoder.finish();
+    }
+    ensure_eq(std::string("\x1f\x8b"), compressed.substr(0, 2));
+    ensure(compressed.size() < to_string(source).size() / 4);
+    ensure_eq(to_string(source), gunzip(compressed));
+
+    std::string zlib;
+    {
+        auto append = [&] (string_view chunk) { zlib.append(chunk.data(), chunk.size()); };
+        compressed_encoder<msgpack_encoder> encoder(append, compression::zlib);
+        encoder.encode(source);
+    }
+    ensure_eq('\x78', zlib[0]);
+    ensure_eq(source, parse_msgpack(gunzip(zlib)));
+}
+
+TEST(compressor_flush)
+{
+    std::string out;
+    compressor  deflate([&] (string_view chunk) { out.append(chunk.data(), chunk.size()); });
+    deflate.write("[1, 2, ");
+    deflate.flush();
+
+    std::string plain;
+    decompressor inflate([&] (string_view chunk) { plain.append(chunk.data(), chunk.size()); });
+    inflate.write(out);
+    ensure_eq(std::string("[1, 2, "), plain);
+
+    std::size_t flushed = out.size();
+    deflate.write("3]");
+    deflate.finish();
+    deflate.finish();
+    inflate.write(string_view(out).substr(flushed));
+    inflate.finish();
+    ensure_eq(std::string("[1, 2, 3]"), plain);
+    ensure_throws(std::logic_error, deflate.write("more"));
+}
+
+TEST(decompressor_into_incremental_parser)
+{
+    value       source     = compress_sample();
+    std::string compressed = gzip(to_string(source));
+
+    incremental_parser parser;
+    decompressor       inflate([&] (string_view chunk) { parser.feed(chunk); }, 100);
+    for (std::size_t idx = 0; idx < compressed.size(); idx += 7)
+        inflate.write(compressed.substr(idx, 7));
+    inflate.finish();
+    ensure_eq(source, parser.finish());
+}
+
+TEST(decompress_streambuf_parse)
+{
+    value                source = compress_sample();
+    std::istringstream   compressed(gzip(to_string(source)));
+    decompress_streambuf plain(compressed, 64);
+    std::istream         input(&plain);
+    ensure_eq(source, parse(input));
+
+    // Appended gzip members read as one stream
+    std::istringstream   members(gzip("[1, ") + gzip("2]"));
+    decompress_streambuf joined(members);
+    std::istream         joined_input(&joined);
+    ensure_eq(array({ 1, 2 }), parse(joined_input));
+}
+
+TEST(decompress_errors)
+{
+    ensure_throws(std::runtime_error, gunzip("this is not compressed"));
+
+    std::string compressed = gzip("[1, 2, 3]");
+    ensure_throws(std::runtime_error, gunzip(compressed.substr(0, compressed.size() - 3)));
+    ensure_throws(std::runtime_error, gunzip(""));
+
+    std::istringstream   cut(compressed.substr(0, compressed.size() / 2));
+    decompress_streambuf plain(cut);
+    std::istream         input(&plain);
+    input.exceptions(std::ios::badbit);
+    ensure_throws(std::runtime_error, parse(input));
+}
+
+#else
+
+TEST(compress_without_zlib)
+{
+    ensure_throws(std::runtime_error, compressor([] (string_view) { }));
+    ensure_throws(std::runtime_error, decompressor([] (string_view) { }));
+}
+
+#endif
+
+}
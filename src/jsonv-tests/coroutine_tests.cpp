@@ -0,0 +1,178 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/coroutine.hpp>
+
+#if JSONV_COROUTINES
+
+#include <jsonv/parse.hpp>
+#include <jsonv/value.hpp>
+
+#include <coroutine>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+namespace
+{
+
+/** Stands in for a reactor: every read and write suspends the coroutine, which is resumed by \c run. **/
+struct fake_reactor
+{
+    std::coroutine_handle<> pending;
+
+    struct suspend
+    {
+        fake_reactor& reactor;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> awaiting) noexcept { reactor.pending = awaiting; }
+        void await_resume() const noexcept { }
+    };
+
+    void run()
+    {
+        while (auto next = std::exchange(pending, nullptr))
+            next.resume();
+    }
+};
+
+/** Hands out \c chunks one at a time, then an empty one. **/
+struct chunk_source
+{
+    fake_reactor&            reactor;
+    std::vector<std::string> chunks;
+    std::size_t              reads = 0;
+
+    struct read_awaiter : fake_reactor::suspend
+    {
+        chunk_source& source;
+
+        string_view await_resume()
+        {
+            std::size_t idx = source.reads++;
+            return idx < source.chunks.size() ? string_view(source.chunks[idx]) : string_view();
+        }
+    };
+
+    read_awaiter read_some()
+    {
+        return read_awaiter{ { reactor }, *this };
+    }
+};
+
+struct string_sink
+{
+    fake_reactor&            reactor;
+    std::vector<std::string> writes;
+
+    fake_reactor::suspend write(string_view text)
+    {
+        writes.emplace_back(text.data(), text.size());
+        return fake_reactor::suspend{ reactor };
+    }
+};
+
+/** A coroutine which starts right away and runs \a work, keeping its exception in \a error. **/
+struct detached
+{
+    struct promise_type
+    {
+        detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() { }
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+}
+
+TEST(async_parse_chunks)
+{
+    fake_reactor reactor;
+    chunk_source source{ reactor, { R"({"a": [1, 2)", R"(, 3], "b": "x)", R"(yz"} )", "this is never read" } };
+    value        result;
+    bool         finished = false;
+
+    // the coroutine refers to the lambda's captures, so the lambda has to outlive it
+    auto body = [&] () -> detached
+    {
+        result   = co_await async_parse(source);
+        finished = true;
+    };
+    body();
+    ensure(!finished);
+    reactor.run();
+
+    ensure(finished);
+    ensure_eq(3U, source.reads);
+    ensure_eq(parse(R"({"a": [1, 2, 3], "b": "xyz"})"), result);
+}
+
+TEST(async_parse_failure)
+{
+    fake_reactor reactor;
+    chunk_source source{ reactor, { "[1, 2" } };
+    bool         failed = false;
+
+    auto body = [&] () -> detached
+    {
+        try
+        {
+            co_await async_parse(source);
+        }
+        catch (const parse_error&)
+        {
+            failed = true;
+        }
+    };
+    body();
+    reactor.run();
+
+    ensure(failed);
+}
+
+TEST(async_encode_chunks)
+{
+    value source = array();
+    for (int idx = 0; idx < 100; ++idx)
+        source.push_back(object({ { "id", idx }, { "name", "item " + std::to_string(idx) } }));
+
+    fake_reactor reactor;
+    string_sink  sink{ reactor, {} };
+    bool         finished = false;
+
+    auto body = [&] () -> detached
+    {
+        co_await async_encode(source, sink, 256);
+        finished = true;
+    };
+    body();
+    reactor.run();
+
+    ensure(finished);
+    ensure(sink.writes.size() > 1);
+    std::string text;
+    for (const std::string& chunk : sink.writes)
+        text += chunk;
+    ensure_eq(to_string(source), text);
+}
+
+}
+
+#endif/*JSONV_COROUTINES*/
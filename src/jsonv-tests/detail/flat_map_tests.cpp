@@ -0,0 +1,83 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv-tests/test.hpp>
+
+#include <jsonv/detail/flat_map.hpp>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace jsonv_test
+{
+
+using namespace jsonv::detail;
+
+TEST(flat_map_matches_std_map)
+{
+    std::mt19937 prng(8675309);
+    std::uniform_int_distribution<int> pick_key(0, 40);
+    std::uniform_int_distribution<int> pick_op(0, 3);
+
+    flat_map<std::string, int> flat;
+    std::map<std::string, int> expected;
+    for (int idx = 0; idx < 2000; ++idx)
+    {
+        std::string key = std::to_string(pick_key(prng));
+        switch (pick_op(prng))
+        {
+        case 0:
+            ensure_eq(expected.insert({ key, idx }).second, flat.insert({ key, idx }).second);
+            break;
+        case 1:
+            ensure_eq(expected.erase(key), flat.erase(key));
+            break;
+        case 2:
+            expected[key] = idx;
+            flat[key]     = idx;
+            break;
+        default:
+            flat.insert(flat.lower_bound(key), { key, idx });
+            expected.insert(expected.lower_bound(key), { key, idx });
+            break;
+        }
+
+        ensure_eq(expected.size(), flat.size());
+        ensure(std::equal(expected.begin(), expected.end(), flat.begin(),
+                          [] (const std::pair<const std::string, int>& a, const std::pair<std::string, int>& b)
+                          {
+                              return a.first == b.first && a.second == b.second;
+                          }
+                         )
+              );
+    }
+}
+
+TEST(flat_map_lookup)
+{
+    flat_map<std::string, int> flat;
+    flat.insert({ "b", 2 });
+    flat.insert(flat.end(), { "a", 1 });
+    flat.insert(flat.end(), { "c", 3 });
+
+    ensure_eq(1, flat.at("a"));
+    ensure_eq(1U, flat.count("c"));
+    ensure_eq(0U, flat.count("d"));
+    ensure(flat.find("d") == flat.end());
+    ensure_throws(std::out_of_range, flat.at("d"));
+    ensure_eq(std::string("b"), flat.erase(flat.begin())->first);
+    ensure(flat.erase(flat.begin(), flat.end()) == flat.end());
+    ensure(flat.empty());
+}
+
+}
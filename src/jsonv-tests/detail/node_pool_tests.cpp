@@ -0,0 +1,97 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv-tests/test.hpp>
+
+#include <jsonv/detail/node_pool.hpp>
+#include <jsonv/array.hpp>
+#include <jsonv/object.hpp>
+#include <jsonv/parse.hpp>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+using namespace jsonv::detail;
+
+TEST(node_pool_reuse)
+{
+    void* first = node_allocate(40);
+    std::memset(first, 0xab, 40);
+    node_deallocate(first, 40);
+    // the freed block is handed back out for anything in the same size class
+    void* second = node_allocate(33);
+    ensure(first == second);
+    node_deallocate(second, 33);
+
+    void* big = node_allocate(4096);
+    node_deallocate(big, 4096);
+    node_deallocate(nullptr, 16);
+}
+
+TEST(node_pool_cross_thread)
+{
+    // Trees built on one thread and destroyed on another end up in the destroying thread's cache
+    std::vector<value> trees;
+    for (int idx = 0; idx < 100; ++idx)
+        trees.push_back(parse(R"({"a": [1, "two", {"three": [3]}], "b": "a string which does not fit inline"})"));
+    value expected = trees.front();
+
+    std::thread([&trees] { trees.clear(); }).join();
+    for (int idx = 0; idx < 100; ++idx)
+        trees.push_back(object({ { "a", array({ 1, "two", object({ { "three", array({ 3 }) } }) }) },
+                                 { "b", "a string which does not fit inline" }
+                               }
+                              )
+                       );
+    for (const value& tree : trees)
+        ensure_eq(expected, tree);
+}
+
+TEST(node_pool_object_nodes_cross_thread)
+{
+    // The map nodes of objects are built on one thread and freed on another, member by member and all at once
+    auto build = []
+                 {
+                     value obj = object();
+                     for (int idx = 0; idx < 64; ++idx)
+                         obj["key " + std::to_string(idx)] = idx;
+                     return obj;
+                 };
+
+    std::vector<value> objects;
+    std::thread([&] { for (int idx = 0; idx < 50; ++idx) objects.push_back(build()); }).join();
+    value expected = build();
+    for (const value& obj : objects)
+        ensure_eq(expected, obj);
+
+    std::thread([&objects]
+                {
+                    for (value& obj : objects)
+                        for (int idx = 0; idx < 64; idx += 2)
+                            obj.erase("key " + std::to_string(idx));
+                }
+               ).join();
+    for (const value& obj : objects)
+        ensure_eq(32U, obj.size());
+
+    objects.clear();
+    for (int idx = 0; idx < 50; ++idx)
+        objects.push_back(build());
+    for (const value& obj : objects)
+        ensure_eq(expected, obj);
+}
+
+}
@@ -0,0 +1,186 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv-tests/test.hpp>
+
+#include <jsonv/detail/number_convert.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+using namespace jsonv::detail;
+
+/** Are the two the same double, down to the bits? **/
+static bool same_double(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof a) == 0;
+}
+
+#define ensure_integer(expected, text)                                                                                 \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        std::int64_t integer_ = 0;                                                                                     \
+        double       decimal_ = 0.0;                                                                                   \
+        ensure(convert_number(text, integer_, decimal_) == number_convert_result::integer);                           \
+        ensure_eq(std::int64_t(expected), integer_);                                                                   \
+    } while (false)
+
+#define ensure_decimal(expected, text)                                                                                 \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        std::int64_t integer_ = 0;                                                                                     \
+        double       decimal_ = 0.0;                                                                                   \
+        ensure(convert_number(text, integer_, decimal_) == number_convert_result::decimal);                           \
+        ensure(same_double(expected, decimal_));                                                                       \
+    } while (false)
+
+TEST(number_convert_integers)
+{
+    ensure_integer(0, "0");
+    ensure_integer(0, "-0");
+    ensure_integer(7, "007");
+    ensure_integer(-12345, "-12345");
+    ensure_integer(std::numeric_limits<std::int64_t>::max(), "9223372036854775807");
+    ensure_integer(std::numeric_limits<std::int64_t>::min(), "-9223372036854775808");
+    // the bits of values above 2^63 are kept
+    ensure_integer(-1, "18446744073709551615");
+}
+
+TEST(number_convert_integer_overflow)
+{
+    ensure_decimal(18446744073709551616.0, "18446744073709551616");
+    ensure_decimal(-9223372036854775809.0, "-9223372036854775809");
+    ensure_decimal(1e30, "1000000000000000000000000000000");
+}
+
+TEST(number_convert_decimals)
+{
+    ensure_decimal(0.1, "0.1");
+    ensure_decimal(-0.0, "-0.0");
+    ensure_decimal(0.0, "0e999999999999");
+    ensure_decimal(1.5e300, "1.5e300");
+    ensure_decimal(12e25, "12e25");
+    ensure_decimal(4.9406564584124654e-324, "4.9406564584124654E-324");
+    ensure_decimal(2.2250738585072011e-308, "2.2250738585072011e-308");
+    ensure_decimal(9007199254740993.0, "9007199254740993.0");
+    ensure_decimal(0.30000000000000004, "0.30000000000000004");
+    ensure_decimal(std::numeric_limits<double>::infinity(), "1e400");
+    ensure_decimal(0.0, "1e-400");
+}
+
+TEST(number_convert_invalid)
+{
+    std::int64_t integer;
+    double       decimal;
+    for (const char* text : { "", "-", "1.", ".5", "1e", "1e+", "--1", "1x", "0x10", "1.5.5" })
+        ensure(convert_number(text, integer, decimal) == number_convert_result::invalid);
+}
+
+TEST(number_convert_matches_strtod)
+{
+    std::mt19937_64 prng(20180101);
+    std::uniform_int_distribution<int> pick_digit(0, 9);
+    std::uniform_int_distribution<int> pick_length(1, 25);
+    std::uniform_int_distribution<int> pick_short_length(1, 8);
+    std::uniform_int_distribution<int> pick_exponent(-330, 310);
+    std::uniform_int_distribution<int> pick_small_exponent(-40, 40);
+    for (std::size_t trial = 0; trial < 20000; ++trial)
+    {
+        // Half of the trials are short enough for the fast path
+        bool short_form = trial % 2 == 0;
+        auto length     = [&] { return short_form ? pick_short_length(prng) : pick_length(prng); };
+        
+        std::string text = prng() % 2 ? "-" : "";
+        for (int idx = length(); idx > 0; --idx)
+            text += char('0' + pick_digit(prng));
+        text += '.';
+        for (int idx = length(); idx > 0; --idx)
+            text += char('0' + pick_digit(prng));
+        if (prng() % 2)
+            text += "e" + std::to_string(short_form ? pick_small_exponent(prng) : pick_exponent(prng));
+        
+        ensure_decimal(std::strtod(text.c_str(), nullptr), text);
+    }
+}
+
+TEST(format_integer_extremes)
+{
+    char text[max_formatted_integer_length];
+    for (std::int64_t value : { std::int64_t(0), std::int64_t(7), std::int64_t(-7), std::int64_t(10), std::int64_t(99),
+                                std::int64_t(100), std::int64_t(-1234567890),
+                                std::numeric_limits<std::int64_t>::max(), std::numeric_limits<std::int64_t>::min()
+                              }
+        )
+    {
+        ensure_eq(std::to_string(value), std::string(text, format_integer(text, value)));
+    }
+}
+
+TEST(format_decimal_shortest)
+{
+    char text[max_formatted_decimal_length];
+    auto format = [&] (double value) { return std::string(text, format_decimal(text, value)); };
+    ensure_eq("0.1",                     format(0.1));
+    ensure_eq("0.30000000000000004",     format(0.1 + 0.2));
+    ensure_eq("3",                       format(3.0));
+    ensure_eq("-0.5",                    format(-0.5));
+    ensure_eq("1e+21",                   format(1e21));
+    ensure_eq("5e-324",                  format(std::numeric_limits<double>::denorm_min()));
+    ensure_eq("1.7976931348623157e+308", format(std::numeric_limits<double>::max()));
+    ensure_eq("123456.789",              format(123456.789));
+}
+
+TEST(format_decimal_round_trips)
+{
+    std::mt19937_64 prng(42);
+    char text[max_formatted_decimal_length];
+    for (std::size_t trial = 0; trial < 20000; ++trial)
+    {
+        // Random bits cover every exponent; the ratio covers the "ordinary" values metrics tend to have
+        double value;
+        if (trial % 2)
+        {
+            std::uint64_t bits = prng();
+            std::memcpy(&value, &bits, sizeof value);
+            if (value != value || value - value != 0.0)
+                continue;
+        }
+        else
+        {
+            value = double(prng() % 1000000) / double(prng() % 1000 + 1);
+        }
+        
+        std::size_t length = format_decimal(text, value);
+        ensure(length < max_formatted_decimal_length);
+        
+        std::int64_t integer = 0;
+        double       decimal = 0.0;
+        switch (convert_number(string_view(text, length), integer, decimal))
+        {
+        case number_convert_result::integer:
+            ensure_eq(value, double(integer));
+            break;
+        case number_convert_result::decimal:
+            ensure(same_double(value, decimal));
+            break;
+        default:
+            ensure(false);
+        }
+    }
+}
+
+}
@@ -0,0 +1,75 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv-tests/test.hpp>
+
+#include <jsonv/detail/string_scan.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+namespace jsonv_test
+{
+
+using namespace jsonv::detail;
+
+static bool reference_is_special(char c, bool stop_at_high_bytes, bool stop_at_control)
+{
+    unsigned char u = static_cast<unsigned char>(c);
+    return c == '\\'
+        || (stop_at_high_bytes && u >= 0x80)
+        || (stop_at_control && (u < 0x20 || u == 0x7f));
+}
+
+static bool reference_needs_escape(char c)
+{
+    unsigned char u = static_cast<unsigned char>(c);
+    return u < 0x20 || u >= 0x7f || c == '\"' || c == '\\' || c == '/';
+}
+
+TEST(string_scan_random)
+{
+    // Special characters are rare so that the vectorized scans have long runs to skip over, and the trials start at
+    // every offset so the special character lands at every position within a block
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789 \"\\\x01\x7f\xc3\xa4\xff/~\x1f";
+    std::mt19937 prng(8675309);
+    std::uniform_int_distribution<std::size_t> pick_plain(0, 36);
+    std::uniform_int_distribution<std::size_t> pick_any(0, sizeof alphabet - 2);
+    std::uniform_int_distribution<std::size_t> pick_size(0, 100);
+    std::uniform_int_distribution<int>         pick_rare(0, 40);
+    for (std::size_t trial = 0; trial < 2000; ++trial)
+    {
+        std::string input(pick_size(prng), ' ');
+        for (char& c : input)
+            c = alphabet[pick_rare(prng) == 0 ? pick_any(prng) : pick_plain(prng)];
+
+        for (std::size_t offset = 0; offset <= input.size(); ++offset)
+        {
+            const char* begin = input.data() + offset;
+            const char* end   = input.data() + input.size();
+
+            ensure(std::find_if(begin, end, [] (char c) { return c == '\"' || c == '\\'; })
+                   == find_quote_or_backslash(begin, end)
+                  );
+            ensure(std::find_if(begin, end, reference_needs_escape) == find_string_escape(begin, end));
+            for (int flags = 0; flags < 4; ++flags)
+            {
+                bool high    = flags & 1;
+                bool control = flags & 2;
+                ensure(std::find_if(begin, end, [=] (char c) { return reference_is_special(c, high, control); })
+                       == find_string_special(begin, end, high, control)
+                      );
+            }
+        }
+    }
+}
+
+}
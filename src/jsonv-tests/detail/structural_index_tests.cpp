@@ -0,0 +1,123 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv-tests/test.hpp>
+
+#include <jsonv/detail/structural_index.hpp>
+#include <jsonv/detail/token_patterns.hpp>
+#include <jsonv/tokenizer.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+using namespace jsonv::detail;
+
+/** The obvious byte-at-a-time implementation of what the \c structural_index should find. **/
+static std::vector<structural_index::size_type> reference_structural_offsets(const std::string& input)
+{
+    std::vector<structural_index::size_type> out;
+    bool in_string = false;
+    bool escaped   = false;
+    for (std::size_t idx = 0; idx < input.size(); ++idx)
+    {
+        char c = input[idx];
+        if (c == '\"' && !escaped)
+        {
+            in_string = !in_string;
+            out.push_back(structural_index::size_type(idx));
+        }
+        else if (!in_string && std::string("{}[]:,").find(c) != std::string::npos)
+        {
+            // escapes only have meaning inside of a string
+            out.push_back(structural_index::size_type(idx));
+        }
+        escaped = c == '\\' && !escaped;
+    }
+    return out;
+}
+
+TEST(structural_index_simple)
+{
+    std::string input = R"({"a": [1, "b\"]", {"c:": null}]})";
+    structural_index index(input);
+    ensure(index.offsets() == reference_structural_offsets(input));
+}
+
+TEST(structural_index_empty)
+{
+    structural_index index(string_view(""));
+    ensure(index.offsets().empty());
+}
+
+TEST(structural_index_random)
+{
+    // Inputs are built from a small alphabet so runs of backslashes and quotes straddle block boundaries often
+    static const char alphabet[] = "\\\\\\\"\"{}[]:,a ";
+    std::mt19937 prng(8675309);
+    std::uniform_int_distribution<std::size_t> pick_char(0, sizeof alphabet - 2);
+    std::uniform_int_distribution<std::size_t> pick_size(0, 300);
+    for (std::size_t trial = 0; trial < 2000; ++trial)
+    {
+        std::string input(pick_size(prng), ' ');
+        for (char& c : input)
+            c = alphabet[pick_char(prng)];
+
+        structural_index index(input);
+        ensure(index.offsets() == reference_structural_offsets(input));
+    }
+}
+
+TEST(structural_index_find_string_end)
+{
+    std::string input = R"(["abc", "d\\", "\"e", 1])";
+    structural_index index(input);
+    std::size_t cursor = 0;
+    std::size_t close;
+
+    ensure(index.find_string_end(1, cursor, close));
+    ensure_eq(5U, close);
+    ensure(index.find_string_end(8, cursor, close));
+    ensure_eq(12U, close);
+    ensure(index.find_string_end(15, cursor, close));
+    ensure_eq(19U, close);
+    ensure(!index.find_string_end(22, cursor, close));
+}
+
+TEST(tokenizer_structural_index_matches_byte_scan)
+{
+    // Make an input large enough for the tokenizer to build an index, with some garbage and comments to throw off the
+    // index's idea of where strings are
+    std::string input = "[";
+    for (std::size_t idx = 0; idx < 500; ++idx)
+        input += R"({"key\\": "va\"lue", "n": -1.5e3, /* " */ "x": [true, false, null]}, )";
+    input += R"(\"unterminated)";
+
+    tokenizer tokens(input);
+    const char* position = input.data();
+    while (tokens.next())
+    {
+        token_kind  kind;
+        std::size_t length;
+        if (attempt_match(position, input.data() + input.size(), kind, length) == match_result::unmatched)
+            kind = kind | token_kind::parse_error_indicator;
+
+        ensure_eq(kind, tokens.current().kind);
+        ensure_eq(string_view(position, length), tokens.current().text);
+        position += length;
+    }
+    ensure(position == input.data() + input.size());
+}
+
+}
@@ -11,13 +11,17 @@
 #include "test.hpp"
 
 #include <jsonv/encode.hpp>
+#include <jsonv/encode_static.hpp>
 #include <jsonv/parse.hpp>
 #include <jsonv/value.hpp>
 
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include <locale>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 
 namespace jsonv_test
 {
@@ -39,6 +43,59 @@ TEST(encode_pretty_print)
     encoder.encode(val);
 }
 
+TEST(encode_pretty_compact_arrays)
+{
+    auto val = jsonv::parse(R"({ "a": [1, [2.5, "x", null], [[]], [3, {}]], "b": [true] })");
+    std::string expanded = "{\n"
+                           "  \"a\": [\n"
+                           "    1,\n"
+                           "    [\n"
+                           "      2.5,\n"
+                           "      \"x\",\n"
+                           "      null\n"
+                           "    ],\n"
+                           "    [\n"
+                           "      []\n"
+                           "    ],\n"
+                           "    [\n"
+                           "      3,\n"
+                           "      {}\n"
+                           "    ]\n"
+                           "  ],\n"
+                           "  \"b\": [\n"
+                           "    true\n"
+                           "  ]\n"
+                           "}";
+    std::ostringstream pretty;
+    jsonv::ostream_pretty_encoder(pretty).encode(val);
+    ensure_eq(expanded, pretty.str());
+    
+    std::string compact = "{\n"
+                          "  \"a\": [\n"
+                          "    1,\n"
+                          "    [2.5, \"x\", null],\n"
+                          "    [\n"
+                          "      []\n"
+                          "    ],\n"
+                          "    [\n"
+                          "      3,\n"
+                          "      {}\n"
+                          "    ]\n"
+                          "  ],\n"
+                          "  \"b\": [true]\n"
+                          "}";
+    std::ostringstream compacted;
+    {
+        jsonv::ostream_pretty_encoder encoder(compacted);
+        encoder.compact_arrays(true);
+        encoder.encode(val);
+        ensure_eq(compact, compacted.str());
+        encoder.encode(jsonv::array({ 1, 2 }));
+    }
+    ensure_eq(compact + "[1, 2]", compacted.str());
+    ensure_eq(val, jsonv::parse(compact));
+}
+
 TEST(encode_nan)
 {
     auto val = jsonv::parse(k_some_json);
@@ -104,4 +161,288 @@ TEST(encode_invalid_utf8_uses_replacement_at_end)
     ensure_eq(output, "\"\\u00e8\"");
 }
 
+static std::string ostream_encode(const jsonv::value& val, bool ensure_ascii = true)
+{
+    std::ostringstream ss;
+    jsonv::ostream_encoder encoder(ss);
+    encoder.ensure_ascii(ensure_ascii);
+    encoder.encode(val);
+    return ss.str();
+}
+
+static jsonv::value buffer_encode_sample()
+{
+    jsonv::value val = jsonv::parse(k_some_json);
+    val["h"] = jsonv::array({ 0.5, -1.25e-300, 3.0, 1e21, 123456789.0, std::numeric_limits<std::int64_t>::min(),
+                              std::numeric_limits<std::int64_t>::max(), 0, -7
+                            });
+    val["i"] = "tab\there \"quoted\" back\\slash / \x01 J\xc3\xa4ne \xf0\x9f\x98\x80 \xff";
+    val["k\ney"] = std::nan("");
+    return val;
+}
+
+TEST(encode_buffer_matches_ostream)
+{
+    jsonv::value val = buffer_encode_sample();
+    ensure_eq(ostream_encode(val), jsonv::to_string(val));
+    
+    std::string out = "prefix:";
+    {
+        jsonv::buffer_encoder encoder(out);
+        encoder.ensure_ascii(false);
+        encoder.encode(val);
+    }
+    ensure_eq("prefix:" + ostream_encode(val, false), out);
+}
+
+TEST(encode_buffer_chunks)
+{
+    jsonv::value val = buffer_encode_sample();
+    std::string  out;
+    std::size_t  chunks = 0;
+    jsonv::buffer_encoder encoder([&] (jsonv::string_view chunk)
+                                  {
+                                      ensure(chunk.size() <= 16U);
+                                      out.append(chunk.data(), chunk.size());
+                                      ++chunks;
+                                  },
+                                  16
+                                 );
+    encoder.encode(val);
+    encoder.flush();
+    ensure_eq(0U, encoder.size());
+    ensure_eq(jsonv::to_string(val), out);
+    ensure(chunks > out.size() / 16);
+}
+
+TEST(encode_buffer_fixed)
+{
+    char buffer[16];
+    jsonv::buffer_encoder encoder(buffer, sizeof buffer);
+    encoder.encode(jsonv::array({ 1, "two", jsonv::null }));
+    ensure_eq(std::string(R"([1,"two",null])"), std::string(buffer, encoder.size()));
+    ensure_throws(std::length_error, encoder.encode(jsonv::value("too long for what is left")));
+}
+
+TEST(encode_raw_json)
+{
+    const jsonv::value raw = jsonv::raw_json(" {\"b\": [1,  2.50], \"a\":\"x\"}\n");
+    ensure_eq(jsonv::parse(R"({"a": "x", "b": [1, 2.5]})"), raw);
+    ensure_eq(jsonv::value("x"), raw.at("a"));
+    
+    // The fragment is written as it was given, wherever it ends up
+    jsonv::value doc   = jsonv::object({ { "raw", raw }, { "list", jsonv::array({ raw, 3 }) } });
+    std::string  expected = R"({"list":[{"b": [1,  2.50], "a":"x"},3],"raw":{"b": [1,  2.50], "a":"x"}})";
+    ensure_eq(expected, jsonv::to_string(doc));
+    std::string buffered;
+    {
+        jsonv::buffer_encoder encoder(buffered);
+        encoder.encode(doc);
+    }
+    ensure_eq(expected, buffered);
+    
+    std::ostringstream pretty;
+    jsonv::ostream_pretty_encoder(pretty).encode(doc);
+    ensure_eq(doc, jsonv::parse(pretty.str()));
+    
+    // Changing a copy drops the text, but not from the original
+    jsonv::value changed = raw;
+    changed["c"] = 1;
+    ensure_eq(std::string(R"({"a":"x","b":[1,2.5],"c":1})"), jsonv::to_string(changed));
+    jsonv::value shared = raw;
+    shared.make_shareable();
+    ensure_eq(std::string(R"({"b": [1,  2.50], "a":"x"})"), jsonv::to_string(jsonv::value(shared)));
+    
+    // Non-ASCII text is only written as it is when the encoder allows it
+    jsonv::value utf8 = jsonv::raw_json("[\"J\xc3\xa4ne\"]");
+    ensure_eq(std::string(R"(["J\u00e4ne"])"), jsonv::to_string(utf8));
+    std::string unescaped;
+    {
+        jsonv::buffer_encoder encoder(unescaped);
+        encoder.ensure_ascii(false);
+        encoder.encode(utf8);
+    }
+    ensure_eq(std::string("[\"J\xc3\xa4ne\"]"), unescaped);
+    
+    ensure_eq(jsonv::value(2.5), jsonv::raw_json(" 2.50 "));
+    ensure_throws(jsonv::parse_error, jsonv::raw_json("{,}"));
+    ensure_throws(jsonv::parse_error, jsonv::raw_json("[1] [2]"));
+    ensure_throws(jsonv::parse_error, jsonv::raw_json("/* comment */ [1]"));
+    ensure_throws(jsonv::parse_error, jsonv::raw_json("  "));
+}
+
+namespace
+{
+
+/** An \c encode_static writer which writes a token name for each call. **/
+struct token_writer
+{
+    std::string tokens;
+    
+    void write_null()                      { tokens += "n"; }
+    void write_boolean(bool value)         { tokens += value ? "t" : "f"; }
+    void write_integer(std::int64_t value) { tokens += "i" + std::to_string(value); }
+    void write_decimal(double)             { tokens += "d"; }
+    void write_string(jsonv::string_view)  { tokens += "s"; }
+    void write_array_begin(std::size_t n)  { tokens += "[" + std::to_string(n); }
+    void write_array_delimiter()           { tokens += ","; }
+    void write_array_end()                 { tokens += "]"; }
+    void write_object_begin(std::size_t n) { tokens += "{" + std::to_string(n); }
+    void write_object_key(jsonv::string_view key) { tokens += "k" + std::string(key.data(), key.size()); }
+    void write_object_delimiter()          { tokens += ";"; }
+    void write_object_end()                { tokens += "}"; }
+    bool write_raw_json(jsonv::string_view text)
+    {
+        tokens += "r" + std::string(text.data(), text.size());
+        return true;
+    }
+};
+
+}
+
+TEST(encode_static_writer)
+{
+    jsonv::value val = jsonv::parse(R"({ "a": [1, 2.5, "x", null, true], "b": { "c": false } })");
+    token_writer out;
+    jsonv::encode_static(val, out);
+    ensure_eq(std::string("{2ka[5i1,d,s,n,t];kb{1kcf}}"), out.tokens);
+    
+    token_writer raw;
+    jsonv::encode_static(jsonv::array({ 0, jsonv::raw_json("[1, 2]") }), raw);
+    ensure_eq(std::string("[2i0,r[1, 2]]"), raw.tokens);
+    
+    // The virtual path goes through the same walk
+    std::ostringstream ss;
+    ss << val;
+    ensure_eq(ss.str(), jsonv::to_string(val));
+}
+
+TEST(encode_encoded_size)
+{
+    jsonv::value val = buffer_encode_sample();
+    ensure_eq(ostream_encode(val).size(), jsonv::encoded_size(val));
+    ensure_eq(ostream_encode(val, false).size(), jsonv::encoded_size(val, false));
+    ensure_eq(ostream_encode(val), jsonv::to_string(val));
+    
+    for (const jsonv::value& scalar : { jsonv::value(), jsonv::value(true), jsonv::value(false), jsonv::value(-12),
+                                        jsonv::value(0.1), jsonv::value(std::nan("")), jsonv::value(""),
+                                        jsonv::array(), jsonv::object()
+                                      }
+        )
+        ensure_eq(ostream_encode(scalar).size(), jsonv::encoded_size(scalar));
+    
+    jsonv::value raw = jsonv::object({ { "utf8", jsonv::raw_json("[\"J\xc3\xa4ne\"]") },
+                                       { "ascii", jsonv::raw_json("{ \"a\" : 1 }") }
+                                     });
+    ensure_eq(jsonv::to_string(raw).size(), jsonv::encoded_size(raw));
+    ensure_eq(std::string(R"({"ascii":{ "a" : 1 },"utf8":["J\u00e4ne"]})"), jsonv::to_string(raw));
+    ensure_eq(ostream_encode(raw, false).size(), jsonv::encoded_size(raw, false));
+}
+
+TEST(encode_parallel)
+{
+    jsonv::value rows = jsonv::array();
+    jsonv::value wide = jsonv::object();
+    for (int idx = 0; idx < 1000; ++idx)
+    {
+        rows.push_back(jsonv::object({ { "id", idx }, { "name", "J\xc3\xa4ne #" + std::to_string(idx) },
+                                       { "score", idx / 7.0 }, { "tags", jsonv::array({ idx % 3 == 0, jsonv::null }) }
+                                     }
+                                    )
+                      );
+        wide["key" + std::to_string(idx)] = idx;
+    }
+    rows.push_back(jsonv::raw_json("{ \"raw\" : true }"));
+    
+    jsonv::value doc = jsonv::object({ { "meta", jsonv::object({ { "count", 1001 } }) }, { "rows", rows } });
+    for (const jsonv::value& val : { doc, rows, wide, jsonv::array({ 1, 2, 3 }), jsonv::value(5), jsonv::array() })
+    {
+        ensure_eq(jsonv::to_string(val), jsonv::to_string_parallel(val, 4));
+        ensure_eq(jsonv::to_string(val), jsonv::to_string_parallel(val, 1));
+    }
+    
+    std::string out;
+    {
+        jsonv::buffer_encoder encoder([&] (jsonv::string_view chunk) { out.append(chunk.data(), chunk.size()); }, 64);
+        encoder.ensure_ascii(false);
+        encoder.encode_parallel(doc, 3);
+    }
+    ensure_eq(ostream_encode(doc, false), out);
+}
+
+TEST(encode_canonical)
+{
+    // the examples from RFC 8785 (section 3.2.3 and appendix B)
+    jsonv::value keys = jsonv::object({ { "\xe2\x82\xac", "Euro Sign" },
+                                        { "\r", "Carriage Return" },
+                                        { "\xef\xac\xb3", "Hebrew Letter Dalet With Dagesh" },
+                                        { "1", "One" },
+                                        { "\xf0\x9f\x98\x80", "Emoji: Grinning Face" },
+                                        { "\xc2\x80", "Control" },
+                                        { "\xc3\xb6", "Latin Small Letter O With Diaeresis" },
+                                      }
+                                     );
+    ensure_eq("{\"\\r\":\"Carriage Return\",\"1\":\"One\",\"\xc2\x80\":\"Control\","
+              "\"\xc3\xb6\":\"Latin Small Letter O With Diaeresis\",\"\xe2\x82\xac\":\"Euro Sign\","
+              "\"\xf0\x9f\x98\x80\":\"Emoji: Grinning Face\",\"\xef\xac\xb3\":\"Hebrew Letter Dalet With Dagesh\"}",
+              jsonv::to_canonical_string(keys)
+             );
+
+    auto number = [] (double x) { return jsonv::to_canonical_string(x); };
+    ensure_eq("0", number(0.0));
+    ensure_eq("0", number(-0.0));
+    ensure_eq("5e-324", number(5e-324));
+    ensure_eq("-1.7976931348623157e+308", number(-1.7976931348623157e308));
+    ensure_eq("9007199254740992", number(9007199254740992.0));
+    ensure_eq("295147905179352830000", number(295147905179352830000.0));
+    ensure_eq("1e+21", number(1e21));
+    ensure_eq("1e+23", number(1e23));
+    ensure_eq("0.000001", number(0.000001));
+    ensure_eq("1e-7", number(1e-7));
+    ensure_eq("333333333.3333333", number(333333333.3333333));
+    ensure_eq("4.5", number(4.50));
+    ensure_eq("0.002", number(2e-3));
+    ensure_eq("-12.25", number(-12.25));
+    ensure_eq("9007199254740992", jsonv::to_canonical_string(std::int64_t(9007199254740993)));
+    ensure_eq("-42", jsonv::to_canonical_string(-42));
+
+    ensure_eq("{\"a\":[1,20,\"\\u000f\x7f/\\\"\\\\\\n\",true,null],\"b\":{}}",
+              jsonv::to_canonical_string(jsonv::parse("{ \"b\": {}, \"a\": [1.0, 2e1, \"\\u000f\x7f\\/\\\"\\\\\\n\", "
+                                                      "true, null] }"
+                                                     )
+                                        )
+             );
+
+    ensure_throws(std::domain_error, number(std::numeric_limits<double>::quiet_NaN()));
+    ensure_throws(std::domain_error, number(std::numeric_limits<double>::infinity()));
+    ensure_throws(std::invalid_argument, jsonv::to_canonical_string("\xff"));
+    ensure_throws(std::invalid_argument, jsonv::to_canonical_string("\xc0\xaf"));
+    ensure_throws(std::invalid_argument, jsonv::to_canonical_string(jsonv::object({ { "\xed\xa0\x80", 1 } })));
+}
+
+TEST(encode_canonical_cache_subtrees)
+{
+    jsonv::value doc = jsonv::parse(R"({"z": {"list": [3, 2, 1], "name": "x"}, "a": [{"b": 1.5}]})");
+    doc.make_shareable();
+
+    std::ostringstream os;
+    jsonv::canonical_encoder encoder(os);
+    encoder.cache_subtrees(true);
+    encoder.encode(doc);
+    std::string first = os.str();
+    ensure_eq(R"({"a":[{"b":1.5}],"z":{"list":[3,2,1],"name":"x"}})", first);
+
+    // a copy shares the kept text, but changing it must not use the text of what it was a copy of
+    jsonv::value changed = doc;
+    changed.at("z").at("list").push_back(0);
+    os.str("");
+    encoder.encode(changed);
+    ensure_eq(R"({"a":[{"b":1.5}],"z":{"list":[3,2,1,0],"name":"x"}})", os.str());
+
+    os.str("");
+    encoder.encode(doc);
+    ensure_eq(first, os.str());
+    ensure_eq(first, jsonv::to_canonical_string(doc));
+}
+
 }
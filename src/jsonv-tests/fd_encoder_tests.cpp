@@ -0,0 +1,94 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/encode.hpp>
+#include <jsonv/fd_encoder.hpp>
+#include <jsonv/value.hpp>
+
+#include <string>
+#include <system_error>
+
+#if !defined(_WIN32)
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+namespace
+{
+
+static value fd_sample()
+{
+    value rows = array();
+    for (int idx = 0; idx < 3000; ++idx)
+        rows.push_back(object({ { "id", idx }, { "name", "row #" + std::to_string(idx) } }));
+    return object({ { "rows", rows } });
+}
+
+/** Encode \a source to a temporary file with an \c fd_encoder and read back what was written. **/
+static std::string encode_through_file(const value& source, std::size_t block_size, bool background)
+{
+    char path[] = "/tmp/jsonv-fd-encoder-XXXXXX";
+    int  fd     = ::mkstemp(path);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Could not create a temporary file");
+    ::unlink(path);
+
+    {
+        fd_encoder encoder(fd, block_size, background);
+        encoder.encode(source);
+        encoder.encode(source);
+        encoder.flush();
+    }
+
+    std::string out;
+    char        buffer[4096];
+    ::lseek(fd, 0, SEEK_SET);
+    for (ssize_t got; (got = ::read(fd, buffer, sizeof buffer)) > 0; )
+        out.append(buffer, std::size_t(got));
+    ::close(fd);
+    return out;
+}
+
+}
+
+TEST(fd_encoder_file)
+{
+    value       source = fd_sample();
+    std::string expected = to_string(source) + to_string(source);
+    ensure_eq(expected, encode_through_file(source, 1, false));
+    ensure_eq(expected, encode_through_file(source, 1, true));
+    ensure_eq(expected, encode_through_file(source, 1 << 20, true));
+}
+
+TEST(fd_encoder_bad_fd)
+{
+    fd_encoder sync(-1, 4096);
+    sync.encode(array({ 1, 2, 3 }));
+    ensure_throws(std::system_error, sync.flush());
+
+    // more blocks than the writer has, so encoding has to wait for one which failed to be written
+    fd_encoder background(-1, 4096, true);
+    ensure_throws(std::system_error, background.encode(fd_sample()));
+    ensure_throws(std::system_error, background.flush());
+    ensure_throws(std::system_error, background.flush());
+}
+
+}
+
+#endif
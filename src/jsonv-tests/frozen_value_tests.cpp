@@ -0,0 +1,191 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/frozen_value.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/detail/scope_exit.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace jsonv;
+
+static const std::string frozen_sample =
+    R"({ "user": { "id": "u-17", "name": "Jäne" },
+         "events": [ { "ts": 1500, "tags": ["a", "b,]"] }, { "ts": -2.5e1, "tags": [] } ],
+         "big": [ 9223372036854775807, -9223372036854775808, -36028797018963968 ],
+         "flag": true,
+         "off": false,
+         "we\"ird": null
+       })";
+
+TEST(frozen_value_navigation)
+{
+    frozen_value doc = parse_frozen(frozen_sample);
+    ensure_eq(kind::object, doc.kind());
+    ensure_eq(string_view("u-17"), doc.at("user").at("id").as_string());
+    ensure_eq(string_view("J\xc3\xa4ne"), doc["user"]["name"].as_string());
+    ensure_eq(1500, doc.at("events").at(0).at("ts").as_integer());
+    ensure_eq(1500.0, doc.at("events").at(0).at("ts").as_decimal());
+    ensure_eq(-25.0, doc.at("events").at(1).at("ts").as_decimal());
+    ensure_eq(kind::decimal, doc.at_path(".events[1].ts").kind());
+    ensure_eq(string_view("b,]"), doc.at_path(".events[0].tags[1]").as_string());
+    ensure_eq(std::numeric_limits<std::int64_t>::max(), doc.at_path(".big[0]").as_integer());
+    ensure_eq(std::numeric_limits<std::int64_t>::min(), doc.at_path(".big[1]").as_integer());
+    ensure_eq(-36028797018963968, doc.at_path(".big[2]").as_integer());
+    ensure_eq(kind::null, doc.at("we\"ird").kind());
+    ensure(doc.at("flag").as_boolean());
+    ensure(!doc.at("off").as_boolean());
+    ensure_eq(6U, doc.size());
+    ensure_eq(0U, doc.at_path(".events[1].tags").size());
+    ensure_eq(3U, doc.at_path(".events[0].tags[1]").size());
+    ensure(doc.find("nope") == doc.end_object());
+    ensure_eq(string_view("flag"), doc.find("flag")->first);
+}
+
+TEST(frozen_value_matches_value)
+{
+    value        source = parse(frozen_sample);
+    frozen_value parsed = parse_frozen(frozen_sample);
+    frozen_value copied(source);
+    ensure_eq(source, parsed.to_value());
+    ensure_eq(source, copied.to_value());
+    ensure_eq(source.at("events"), parsed.at("events").to_value());
+    ensure_eq(value(), frozen_value().to_value());
+    ensure_eq(value(5), frozen_value(value(5)).to_value());
+}
+
+TEST(frozen_value_iterate)
+{
+    frozen_value doc = parse_frozen(R"({"b": [1, "two", [3], {"four": 4}, null], "a\n": {}})");
+    std::vector<std::string> keys;
+    for (auto iter = doc.begin_object(); iter != doc.end_object(); ++iter)
+        keys.push_back(std::string(iter->first));
+    ensure(keys == std::vector<std::string>({ "b", "a\n" }));
+
+    std::vector<kind> kinds;
+    for (auto iter = doc.at("b").begin_array(); iter != doc.at("b").end_array(); ++iter)
+        kinds.push_back(iter->kind());
+    ensure(kinds == std::vector<kind>({ kind::integer, kind::string, kind::array, kind::object, kind::null }));
+    ensure(doc.at("a\n").begin_object() == doc.at("a\n").end_object());
+}
+
+TEST(frozen_value_outlives_parent)
+{
+    frozen_value child;
+    {
+        frozen_value doc = parse_frozen(R"({"a": [10, "twenty"]})");
+        child = doc.at("a");
+    }
+    ensure_eq(10, child.at(0).as_integer());
+    ensure_eq(string_view("twenty"), child.at(1).as_string());
+}
+
+TEST(frozen_value_shares_keys)
+{
+    std::string same     = "[";
+    std::string distinct = "[";
+    for (int idx = 0; idx < 100; ++idx)
+    {
+        same     += std::string(idx ? "," : "") + R"({"a fairly long key name": 1})";
+        distinct += std::string(idx ? "," : "") + R"({"a fairly long key n)" + std::to_string(100 + idx) + R"(": 1})";
+    }
+    same     += "]";
+    distinct += "]";
+
+    // the repeated key is only stored once, which saves the 2 KB the other 99 copies would take
+    frozen_value doc = parse_frozen(same);
+    ensure_eq(100U, doc.size());
+    ensure_eq(string_view("a fairly long key name"), doc.at(99).begin_object()->first);
+    ensure(doc.memory_size() + 2000 < parse_frozen(distinct).memory_size());
+}
+
+TEST(frozen_value_errors)
+{
+    ensure_throws(parse_error, parse_frozen("[1, 2"));
+    ensure_throws(parse_error, parse_frozen("{} []"));
+
+    frozen_value doc = parse_frozen(R"({"a": [1, 2], "b": "x"})");
+    ensure_throws(kind_error,        doc.at(0));
+    ensure_throws(kind_error,        doc.at("a").at("x"));
+    ensure_throws(kind_error,        doc.at("b").as_integer());
+    ensure_throws(kind_error,        doc.at("a").at(0).size());
+    ensure_throws(std::out_of_range, doc.at("a").at(2));
+    ensure_throws(std::out_of_range, doc.at("c"));
+}
+
+/** Save \a source to a file, load it back and remove the file. **/
+static frozen_value save_and_load(const frozen_value& source)
+{
+    const std::string path = "frozen_value_tests.jsonvfz";
+    auto remove_file = detail::on_scope_exit([&] { std::remove(path.c_str()); });
+    {
+        std::ofstream out(path, std::ios::binary);
+        source.save(out);
+    }
+    return load_frozen(path);
+}
+
+TEST(frozen_value_save_load)
+{
+    value        source = parse(frozen_sample);
+    frozen_value doc    = parse_frozen(frozen_sample);
+
+    frozen_value loaded = save_and_load(doc);
+    ensure_eq(source, loaded.to_value());
+    ensure_eq(string_view("b,]"), loaded.at_path(".events[0].tags[1]").as_string());
+    ensure_eq(std::numeric_limits<std::int64_t>::min(), loaded.at_path(".big[1]").as_integer());
+
+    // a value from the middle of a document is moved to the front of the tape it is saved with
+    frozen_value events = save_and_load(doc.at("events"));
+    ensure_eq(source.at("events"), events.to_value());
+    ensure_eq(-25.0, events.at(1).at("ts").as_decimal());
+
+    ensure_eq(value(5), save_and_load(frozen_value(value(5))).to_value());
+}
+
+TEST(frozen_value_load_errors)
+{
+    const std::string path = "frozen_value_tests_bad.jsonvfz";
+    auto remove_file = detail::on_scope_exit([&] { std::remove(path.c_str()); });
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << frozen_sample;
+    }
+    ensure_throws(std::runtime_error, load_frozen(path));
+    ensure_throws(std::system_error,  load_frozen("no-such-file.jsonvfz"));
+}
+
+TEST(frozen_value_shared_memory)
+{
+    value              source = parse(frozen_sample);
+    const std::string  name   = "jsonv-tests-frozen-" + std::to_string(std::uintptr_t(&source));
+    frozen_value       attached;
+    {
+        frozen_segment segment(name, parse_frozen(frozen_sample));
+        ensure_eq(source, segment.get().to_value());
+        ensure_throws(std::system_error, frozen_segment(name, segment.get()));
+
+        attached = attach_frozen(name);
+        ensure_eq(source, attached.to_value());
+    }
+
+    // the mapping outlives the segment, even though the name is gone
+    ensure_eq(string_view("u-17"), attached.at("user").at("id").as_string());
+    ensure_throws(std::system_error, attach_frozen(name));
+}
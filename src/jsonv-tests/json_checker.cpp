@@ -14,6 +14,7 @@
 #include <jsonv/parse.hpp>
 
 #include <fstream>
+#include <iterator>
 #include <memory>
 
 #include <jsonv-tests/filesystem_util.hpp>
@@ -48,6 +49,12 @@ private:
         {
             jsonv::parse(file, _options);
         }
+        
+        // Checking only the syntax has to come to the same conclusion
+        file.clear();
+        file.seekg(0);
+        std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        ensure_eq(!_expect_failure, jsonv::is_valid(contents, _options));
     }
     
 private:
@@ -0,0 +1,108 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/lazy_value.hpp>
+#include <jsonv/parse.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace jsonv;
+
+static const std::string lazy_sample =
+    R"({ "user": { "id": "u-17", "name": "Jäne" },
+         "events": [ { "ts": 1500, "tags": ["a", "b,]"] }, { "ts": -2.5e1, "tags": [] } ],
+         "flag": true,
+         "we\"ird": null
+       })";
+
+TEST(lazy_value_navigation)
+{
+    lazy_value doc(lazy_sample);
+    ensure_eq(kind::object, doc.kind());
+    ensure_eq("u-17", doc.at("user").at("id").as_string());
+    ensure_eq("J\xc3\xa4ne", doc["user"]["name"].as_string());
+    ensure_eq(1500, doc.at("events").at(0).at("ts").as_integer());
+    ensure_eq(-25.0, doc.at("events").at(1).at("ts").as_decimal());
+    ensure_eq(kind::decimal, doc.at_path(".events[1].ts").kind());
+    ensure_eq("b,]", doc.at_path(".events[0].tags[1]").as_string());
+    ensure_eq(kind::null, doc.at("we\"ird").kind());
+    ensure(doc.at("flag").as_boolean());
+    ensure_eq(string_view("[]"), doc.at_path(".events[1].tags").text());
+    ensure_eq(4U, doc.size());
+    ensure_eq(2U, doc.at("events").size());
+    ensure_eq(3U, doc.at_path(".events[0].tags[1]").size());
+}
+
+TEST(lazy_value_matches_parse)
+{
+    lazy_value doc(lazy_sample);
+    ensure_eq(parse(lazy_sample), doc.to_value());
+    ensure_eq(parse(lazy_sample).at("events"), doc.at("events").to_value());
+}
+
+TEST(lazy_value_iterate_array)
+{
+    lazy_value doc(R"([1, "two", [3], {"four": 4}, null ])");
+    std::vector<kind> kinds;
+    for (auto iter = doc.begin_array(); iter != doc.end_array(); ++iter)
+        kinds.push_back(iter->kind());
+    ensure(kinds == std::vector<kind>({ kind::integer, kind::string, kind::array, kind::object, kind::null }));
+    ensure_eq(0U, lazy_value("[ ]").size());
+}
+
+TEST(lazy_value_iterate_object)
+{
+    lazy_value doc(R"({"b": 1, "a\n": [2], "b": 3})");
+    std::vector<std::string> keys;
+    for (auto iter = doc.begin_object(); iter != doc.end_object(); ++iter)
+        keys.push_back(iter->first);
+    ensure(keys == std::vector<std::string>({ "b", "a\n", "b" }));
+    ensure_eq(2U, doc.count("b"));
+    ensure_eq(1, doc.at("b").as_integer());
+    ensure_eq(value(2), doc.at("a\n").at(0).to_value());
+    ensure_eq(0U, lazy_value("{}").size());
+}
+
+TEST(lazy_value_shared_input)
+{
+    auto       input = std::make_shared<const std::string>(R"({"a": [10, 20]})");
+    lazy_value child = lazy_value(input).at("a").at(1);
+    input.reset();
+    ensure_eq(20, child.as_integer());
+}
+
+TEST(lazy_value_errors)
+{
+    ensure_throws(parse_error, lazy_value(""));
+    ensure_throws(parse_error, lazy_value("[1, 2"));
+    ensure_throws(parse_error, lazy_value("[1, 2}"));
+    ensure_throws(parse_error, lazy_value("{} []"));
+    ensure_throws(parse_error, lazy_value("5", parse_options::create_strict()));
+
+    lazy_value doc(R"({"a": [1, 2], "b": 1x})");
+    ensure_throws(kind_error,        doc.at(0));
+    ensure_throws(kind_error,        doc.at("a").at("x"));
+    ensure_throws(std::out_of_range, doc.at("a").at(2));
+    ensure_throws(std::out_of_range, doc.at("c"));
+    ensure_throws(parse_error,       doc.at("b").to_value());
+    ensure_eq(2U, doc.at("a").size());
+}
+
+TEST(lazy_value_trailing_comma)
+{
+    ensure_eq(2U, lazy_value("[1, 2,]").size());
+    ensure_throws(parse_error, lazy_value("[1, 2,]", parse_options::create_strict()).size());
+    ensure_throws(parse_error, lazy_value("[1 2]").at(0).kind());
+}
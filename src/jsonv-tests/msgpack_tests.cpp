@@ -0,0 +1,175 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/msgpack.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/value.hpp>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+namespace
+{
+
+static std::string from_hex(const std::string& hex)
+{
+    std::string out;
+    for (std::size_t idx = 0; idx + 1 < hex.size(); idx += 2)
+        out.push_back(static_cast<char>(std::stoi(hex.substr(idx, 2), nullptr, 16)));
+    return out;
+}
+
+static std::string to_hex(const std::string& bytes)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (char c : bytes)
+    {
+        out.push_back(digits[static_cast<unsigned char>(c) >> 4]);
+        out.push_back(digits[static_cast<unsigned char>(c) & 0xf]);
+    }
+    return out;
+}
+
+}
+
+TEST(msgpack_encode_examples)
+{
+    std::vector<std::pair<value, std::string>> examples =
+    {
+        { 0,                                        "00"                 },
+        { 127,                                      "7f"                 },
+        { 128,                                      "cc80"               },
+        { 256,                                      "cd0100"             },
+        { 65536,                                    "ce00010000"         },
+        { std::int64_t(4294967296),                 "cf0000000100000000" },
+        { -1,                                       "ff"                 },
+        { -32,                                      "e0"                 },
+        { -33,                                      "d0df"               },
+        { -129,                                     "d1ff7f"             },
+        { -32769,                                   "d2ffff7fff"         },
+        { std::numeric_limits<std::int64_t>::min(), "d38000000000000000" },
+        { 1.5,                                      "ca3fc00000"         },
+        { 1.1,                                      "cb3ff199999999999a" },
+        { false,                                    "c2"                 },
+        { true,                                     "c3"                 },
+        { null,                                     "c0"                 },
+        { "",                                       "a0"                 },
+        { "a",                                      "a161"               },
+        { std::string(32, 'x'),                     "d920" + to_hex(std::string(32, 'x')) },
+        { std::string(256, 'x'),                    "da0100" + to_hex(std::string(256, 'x')) },
+        { array(),                                  "90"                 },
+        { array({ 1, 2, 3 }),                       "93010203"           },
+        { object(),                                 "80"                 },
+        { object({ { "a", 1 }, { "b", array({ 2, 3 }) } }), "82a16101a162920203" },
+    };
+
+    for (const auto& example : examples)
+    {
+        ensure_eq(example.second, to_hex(encode_msgpack(example.first)));
+        ensure_eq(example.first, parse_msgpack(from_hex(example.second)));
+    }
+
+    value big_array = array();
+    for (int idx = 0; idx < 16; ++idx)
+        big_array.push_back(idx);
+    ensure_eq(std::string("dc0010"), to_hex(encode_msgpack(big_array)).substr(0, 6));
+    ensure_eq(big_array, parse_msgpack(encode_msgpack(big_array)));
+}
+
+TEST(msgpack_round_trip)
+{
+    value source = parse(R"({
+                              "name": "some name which is longer than thirty-one bytes",
+                              "numbers": [0, -1, 255, 256, 65535, 65536, 4294967296, -4294967297, 0.1, 2.5e-310],
+                              "nested": [{"a": null}, {"b": [true, false]}, [], {}],
+                              "empty": ""
+                            })");
+    ensure_eq(source, parse_msgpack(encode_msgpack(source)));
+
+    std::string chunked;
+    {
+        msgpack_encoder encoder([&] (string_view chunk) { chunked.append(chunk.data(), chunk.size()); }, 16);
+        encoder.encode(source);
+    }
+    ensure_eq(encode_msgpack(source), chunked);
+
+    // Containers of an unknown size are held until they close, then come out the same as sized ones
+    std::string streamed;
+    {
+        msgpack_encoder encoder(streamed);
+        parse(R"({"a": [1, 2], "b": {}, "c": [[], [3]]})", encoder);
+    }
+    ensure_eq(encode_msgpack(parse(R"({"a": [1, 2], "b": {}, "c": [[], [3]]})")), streamed);
+}
+
+TEST(msgpack_parse_strings_zero_copy)
+{
+    std::string input = from_hex("92a3616263a3646566");
+
+    value borrowed = parse_msgpack(input, parse_options().string_storage(parse_options::strings::borrow));
+    ensure_eq(parse(R"(["abc", "def"])"), borrowed);
+    ensure(borrowed[0].as_string_view().data() == input.data() + 2);
+
+    value shared = parse_msgpack(input, parse_options().string_storage(parse_options::strings::share));
+    input.assign(input.size(), '\0');
+    ensure_eq(parse(R"(["abc", "def"])"), shared);
+
+    value copied = parse_msgpack(from_hex("a3616263"));
+    ensure_eq(value("abc"), copied);
+}
+
+TEST(msgpack_parse_errors)
+{
+    ensure_throws(parse_error, parse_msgpack(""));
+    ensure_throws(parse_error, parse_msgpack(from_hex("cd00")));
+    ensure_throws(parse_error, parse_msgpack(from_hex("a461")));
+    ensure_throws(parse_error, parse_msgpack(from_hex("c1")));                 // never used
+    ensure_throws(parse_error, parse_msgpack(from_hex("c40161")));             // binary
+    ensure_throws(parse_error, parse_msgpack(from_hex("d40100")));             // extension
+    ensure_throws(parse_error, parse_msgpack(from_hex("810102")));             // key is not a string
+    ensure_throws(parse_error, parse_msgpack(from_hex("92c0")));               // missing element
+    ensure_throws(parse_error, parse_msgpack(from_hex("ddffffffff00")));       // size larger than the input
+
+    ensure_throws(parse_error, parse_msgpack(from_hex("0000")));
+    ensure_eq(value(0), parse_msgpack(from_hex("0000"), parse_options().complete_parse(false)));
+
+    std::string deep = from_hex("91919190");
+    ensure_eq(parse("[[[[]]]]"), parse_msgpack(deep));
+    ensure_throws(parse_error, parse_msgpack(deep, parse_options().max_structure_depth(3)));
+
+    // every nested header claims the rest of the input, which adds up to far more than the input
+    std::string oversized;
+    for (std::uint32_t rest = 199995; oversized.size() < 200000; rest -= 5)
+    {
+        oversized += '\xdd';
+        for (int shift = 24; shift >= 0; shift -= 8)
+            oversized += char((rest >> shift) & 0xffU);
+    }
+    ensure_throws(parse_error, parse_msgpack(oversized));
+
+    ensure_throws(parse_error,
+                  parse_msgpack(from_hex("ca7f800000"), parse_options().require_finite_numbers(true))
+                 );
+    ensure(std::isinf(parse_msgpack(from_hex("ca7f800000")).as_decimal()));
+    ensure_eq(value(18446744073709551615.0), parse_msgpack(from_hex("cfffffffffffffffff")));
+}
+
+}
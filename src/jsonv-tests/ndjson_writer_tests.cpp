@@ -0,0 +1,96 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/ndjson_writer.hpp>
+#include <jsonv/object.hpp>
+#include <jsonv/parse_lines.hpp>
+#include <jsonv/writer.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace jsonv;
+
+TEST(ndjson_writer_single_thread)
+{
+    std::ostringstream out;
+    {
+        ndjson_writer lines(out);
+        lines.write(object({ { "a", 1 } }));
+        lines.write("two");
+        lines.write_with([] (writer& line) { line.begin_array().value(3).null().end_array(); });
+
+        // nothing is written until the buffer fills up or is flushed
+        ensure_eq(std::string(), out.str());
+        lines.flush();
+        ensure_eq(std::string("{\"a\":1}\n\"two\"\n[3,null]\n"), out.str());
+        lines.write(4);
+    }
+    ensure_eq(std::string("{\"a\":1}\n\"two\"\n[3,null]\n4\n"), out.str());
+}
+
+TEST(ndjson_writer_failed_lines)
+{
+    // the batches are small, so the long line spills out of the block before it fails
+    std::string   out;
+    ndjson_writer lines([&out] (string_view chunk) { out.append(chunk.data(), chunk.size()); }, 64);
+    lines.write(1);
+    ensure_throws(std::runtime_error,
+                  lines.write_with([] (writer& line)
+                                   {
+                                       line.begin_array();
+                                       for (int idx = 0; idx < 100; ++idx)
+                                           line.value(idx);
+                                       throw std::runtime_error("stop");
+                                   }
+                                  )
+                 );
+    ensure_throws(std::logic_error, lines.write_with([] (writer& line) { line.begin_object(); }));
+    lines.write(2);
+    lines.flush();
+    ensure_eq(std::string("1\n2\n"), out);
+}
+
+TEST(ndjson_writer_threads)
+{
+    static const int threads = 4;
+    static const int count   = 5000;
+
+    std::string out;
+    {
+        ndjson_writer lines([&out] (string_view chunk) { out.append(chunk.data(), chunk.size()); }, 1024);
+        std::vector<std::thread> workers;
+        for (int thread = 0; thread < threads; ++thread)
+            workers.emplace_back([&lines, thread]
+                                 {
+                                     for (int idx = 0; idx < count; ++idx)
+                                         lines.write(object({ { "thread", thread }, { "idx", idx } }));
+                                 }
+                                );
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    // every line is whole and the lines of each thread are in order
+    std::vector<int> next(threads, 0);
+    for (const value& line : parse_lines(out))
+    {
+        int thread = int(line.at("thread").as_integer());
+        ensure_eq(next[thread], line.at("idx").as_integer());
+        ++next[thread];
+    }
+    for (int thread = 0; thread < threads; ++thread)
+        ensure_eq(count, next[thread]);
+}
@@ -14,8 +14,10 @@
 #include <jsonv/object.hpp>
 #include <jsonv/parse.hpp>
 
+#include <iterator>
 #include <string>
 #include <utility>
+#include <vector>
 
 TEST(object)
 {
@@ -195,6 +197,59 @@ TEST(object_wide_keys)
     ensure_eq(nobj, wobj);
 }
 
+TEST(object_string_view_lookup)
+{
+    auto obj = jsonv::object({ { "a", 1 }, { "ab", 2 }, { "\xc3\xa9", 3 } });
+    std::string          buffer = "abc";
+    jsonv::string_view   key(buffer.data(), 2);
+    const jsonv::value&  cobj   = obj;
+
+    ensure_eq(2, obj.at(key).as_integer());
+    ensure_eq(2, cobj.at(key).as_integer());
+    ensure_eq(1U, obj.count(key));
+    ensure(cobj.find(jsonv::string_view(buffer.data(), 3)) == cobj.end_object());
+    ensure_throws(std::out_of_range, cobj.at(jsonv::string_view(buffer.data(), 3)));
+
+    const char* name = "ab";
+    ensure_eq(2, obj[name].as_integer());
+    obj[jsonv::string_view(buffer)] = 4;
+    ensure_eq(4U, obj.size());
+    ensure_eq(1U, obj.erase(key));
+    ensure_eq(0U, obj.erase(key));
+
+    // keys with the high bit set sort after ASCII, the same as std::string does
+    ensure_eq("\xc3\xa9", (--obj.end_object())->first);
+}
+
+TEST(object_emplace)
+{
+    jsonv::value obj = jsonv::object();
+    obj.reserve(3);
+    auto rc = obj.emplace("b", 2);
+    ensure(rc.second);
+    ensure_eq("b", rc.first->first);
+    ensure(!obj.emplace("b", 3).second);
+    ensure_eq(2, obj.at("b").as_integer());
+    
+    auto iter = obj.emplace_hint(obj.end_object(), "c", "three");
+    ensure_eq("three", iter->second.as_string());
+    obj.emplace_hint(obj.end_object(), "a");
+    ensure_eq(jsonv::object({ { "a", jsonv::null }, { "b", 2 }, { "c", "three" } }), obj);
+    
+    std::vector<std::pair<std::string, jsonv::value>> source = { { "d", 4 },
+                                                                 { "b", 5 },
+                                                                 { "e", "a string which is long" }
+                                                               };
+    obj.insert(std::make_move_iterator(source.begin()), std::make_move_iterator(source.end()));
+    ensure_eq(5U, obj.size());
+    ensure_eq(2, obj.at("b").as_integer());
+    ensure(source[2].second.is_null());
+    
+    jsonv::value copy = jsonv::object();
+    copy.insert(obj.begin_object(), obj.end_object());
+    ensure_eq(obj, copy);
+}
+
 TEST(parse_empty_object)
 {
     auto obj = jsonv::parse("{}");
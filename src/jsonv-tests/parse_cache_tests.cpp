@@ -0,0 +1,88 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/parse_cache.hpp>
+
+#include <string>
+
+using namespace jsonv;
+
+TEST(parse_cache_hits)
+{
+    parse_cache cache;
+    std::string input = R"({"flags": {"a": true, "b": false}, "list": [1, 2, 3]})";
+
+    value first = cache.parse(input);
+    ensure_eq(parse(input), first);
+    ensure_eq(0U, cache.hits());
+    ensure_eq(1U, cache.misses());
+    ensure_eq(1U, cache.size());
+
+    // the same bytes from a different buffer are found
+    value second = cache.parse(std::string(input));
+    ensure_eq(first, second);
+    ensure_eq(1U, cache.hits());
+    ensure(static_cast<const value&>(first).at("list").array_data()
+           == static_cast<const value&>(second).at("list").array_data()
+          );
+
+    // changing what was handed out does not change the cache
+    second["list"].push_back(4);
+    ensure_eq(parse(input), cache.parse(input));
+
+    ensure_eq(value(5), cache.parse("5"));
+    ensure_eq(2U, cache.size());
+    cache.clear();
+    ensure_eq(0U, cache.size());
+    ensure_eq(0U, cache.bytes());
+}
+
+TEST(parse_cache_errors_not_kept)
+{
+    parse_cache cache;
+    ensure_throws(parse_error, cache.parse("[1, 2"));
+    ensure_throws(parse_error, cache.parse("[1, 2"));
+    ensure_eq(0U, cache.size());
+}
+
+TEST(parse_cache_evicts_least_recent)
+{
+    std::string a = R"(["a", 1])";
+    std::string b = R"(["b", 2])";
+    std::string c = R"(["c", 3])";
+
+    parse_cache sizer;
+    sizer.parse(a);
+    std::size_t entry_bytes = sizer.bytes();
+    ensure(entry_bytes > a.size());
+
+    parse_cache cache(2 * entry_bytes);
+    cache.parse(a);
+    cache.parse(b);
+    cache.parse(a);
+    cache.parse(c);
+    ensure_eq(2U, cache.size());
+    ensure(cache.bytes() <= cache.max_bytes());
+
+    // b was the least recently used, so it was dropped
+    std::size_t hits = cache.hits();
+    cache.parse(a);
+    cache.parse(c);
+    ensure_eq(hits + 2, cache.hits());
+    cache.parse(b);
+    ensure_eq(hits + 2, cache.hits());
+
+    // a document too large for the cache is still parsed
+    parse_cache tiny(1);
+    ensure_eq(parse(a), tiny.parse(a));
+    ensure_eq(0U, tiny.size());
+}
@@ -0,0 +1,114 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/array.hpp>
+#include <jsonv/object.hpp>
+#include <jsonv/parse_lines.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace jsonv;
+
+static const std::string sample_lines = "{\"a\": 1}\n"
+                                        "\n"
+                                        "[1, 2]\r\n"
+                                        "  \t\n"
+                                        "\"three\"\n"
+                                        "4";
+
+static const std::vector<value> sample_documents = { object({ { "a", 1 } }), array({ 1, 2 }), "three", 4 };
+
+TEST(parse_lines_string)
+{
+    std::vector<value>       docs;
+    std::vector<std::size_t> lines;
+    line_range range = parse_lines(sample_lines);
+    for (auto iter = range.begin(); iter != range.end(); ++iter)
+    {
+        docs.push_back(*iter);
+        lines.push_back(range.line());
+    }
+    ensure(docs == sample_documents);
+    ensure(lines == std::vector<std::size_t>({ 1, 3, 5, 6 }));
+}
+
+TEST(parse_lines_stream)
+{
+    std::istringstream stream(sample_lines);
+    std::vector<value> docs;
+    for (const value& doc : parse_lines(stream))
+        docs.push_back(doc);
+    ensure(docs == sample_documents);
+}
+
+TEST(parse_lines_empty)
+{
+    line_range range = parse_lines("\n\n  \n");
+    ensure(range.begin() == range.end());
+}
+
+TEST(parse_lines_error_location)
+{
+    std::istringstream stream("[1]\n[2]\n[3, bogus]\n[4]");
+    line_range         range = parse_lines(stream);
+    auto               iter  = range.begin();
+    ++iter;
+    try
+    {
+        ++iter;
+        ensure(false);
+    }
+    catch (const parse_error& err)
+    {
+        ensure_eq(3U, err.problems().front().line());
+        ensure_eq(12U, err.problems().front().character());
+    }
+}
+
+TEST(parse_lines_parallel_matches)
+{
+    // Make enough input to be split into several chunks
+    std::string        input;
+    std::vector<value> expected;
+    for (int idx = 0; idx < 100000; ++idx)
+    {
+        input += "{\"idx\": " + std::to_string(idx) + ", \"name\": \"entry number " + std::to_string(idx) + "\"}\n";
+        expected.push_back(object({ { "idx", idx }, { "name", "entry number " + std::to_string(idx) } }));
+        if (idx % 1000 == 0)
+            input += "\n";
+    }
+
+    ensure(expected == parse_lines_parallel(input, parse_options(), 3));
+    ensure(expected == parse_lines_parallel(input));
+    ensure(sample_documents == parse_lines_parallel(sample_lines, parse_options(), 2));
+}
+
+TEST(parse_lines_parallel_error)
+{
+    std::string input;
+    for (int idx = 0; idx < 200000; ++idx)
+        input += idx == 150000 ? "[bogus]\n" : "[1, 2, 3, 4, 5, 6, 7, 8, 9, 10]\n";
+
+    std::size_t delivered = 0;
+    try
+    {
+        parse_lines_parallel(input, [&] (value) { ++delivered; }, parse_options(), 4);
+        ensure(false);
+    }
+    catch (const parse_error& err)
+    {
+        ensure_eq(150001U, err.problems().front().line());
+    }
+    ensure_eq(150000U, delivered);
+}
@@ -9,13 +9,21 @@
  *  \author Travis Gockel (travis@gockelhut.com)
 **/
 #include "test.hpp"
+#include "filesystem_util.hpp"
 
 #include <jsonv/array.hpp>
+#include <jsonv/encode.hpp>
+#include <jsonv/key_dictionary.hpp>
 #include <jsonv/parse.hpp>
 #include <jsonv/object.hpp>
 #include <jsonv/tokenizer.hpp>
 
+#include <cmath>
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <system_error>
 
 using namespace jsonv;
 
@@ -261,6 +269,23 @@ TEST_PARSE(depth)
     ensure_throws(parse_error, parse(src, parse_options::create_strict()));
 }
 
+TEST_PARSE(depth_deep)
+{
+    // Deep enough that a recursive parser would need a very large stack
+    const std::size_t depth = 10000;
+    std::string src = std::string(depth, '[') + std::string(depth, ']');
+    value       result = parse(src);
+    
+    std::size_t  found   = 0;
+    const value* current = &result;
+    for (; current->kind() == kind::array && !current->empty(); current = &current->at(0))
+        ++found;
+    ensure_eq(depth - 1, found);
+    
+    ensure_throws(parse_error, parse(src, parse_options().max_structure_depth(depth)));
+    parse(src, parse_options().max_structure_depth(depth + 1));
+}
+
 TEST_PARSE(literal)
 {
     value v = "[1, 2, 3, 4]"_json;
@@ -298,3 +323,691 @@ TEST_PARSE(invalid_utf8_input)
 {
     ensure_throws(jsonv::parse_error, jsonv::parse("\"\xe4\""));
 }
+
+TEST_PARSE(problem_location)
+{
+    try
+    {
+        parse_options options = parse_options()
+                                .failure_mode(parse_options::on_error::collect_all);
+        parse("[1,\n 2,\n  bogus,\n   3, bogus]", options);
+        ensure(false);
+    }
+    catch (const jsonv::parse_error& err)
+    {
+        ensure_eq(3U, err.problems().front().line());
+        ensure_eq(3U, err.problems().front().column());
+        ensure_eq(10U, err.problems().front().character());
+        ensure_eq(4U, err.problems().back().line());
+        ensure_eq(13U, err.problems().back().column());
+        ensure_eq(29U, err.problems().back().character());
+    }
+}
+
+static bool points_into(const std::string& buffer, string_view contents)
+{
+    return buffer.data() <= contents.data() && contents.data() + contents.size() <= buffer.data() + buffer.size();
+}
+
+TEST_PARSE(strings_borrow)
+{
+    std::string input = R"({"plain": "abc", "escaped": "a\nb", "list": ["x", "yz"]})";
+    value result = parse(input, parse_options().string_storage(parse_options::strings::borrow));
+    
+    ensure(points_into(input, result.at("plain").as_string_view()));
+    ensure(points_into(input, result.at("list").at(1).as_string_view()));
+    ensure(!points_into(input, result.at("escaped").as_string_view()));
+    ensure_eq("a\nb", result.at("escaped").as_string());
+    ensure_eq(parse(input), result);
+    
+    // as_string makes a copy
+    ensure_eq("abc", result.at("plain").as_string());
+    ensure(!points_into(input, result.at("plain").as_string()));
+}
+
+TEST_PARSE(strings_borrow_unicode_copied)
+{
+    std::string input = "[\"caf\xc3\xa9\"]";
+    value result = parse(input, parse_options().string_storage(parse_options::strings::borrow));
+    ensure(!points_into(input, result.at(0).as_string_view()));
+    ensure_eq(parse(input), result);
+}
+
+TEST_PARSE(strings_share)
+{
+    value copy;
+    {
+        std::string input = R"({"a": "abc", "b": ["def"]})";
+        value result = parse(input, parse_options().string_storage(parse_options::strings::share));
+        ensure(!points_into(input, result.at("a").as_string_view()));
+        copy = result.at("b");
+    }
+    ensure_eq(array({ "def" }), copy);
+    ensure_eq(3U, copy.at(0).size());
+}
+
+namespace
+{
+
+/** Counts the calls made by \c parse instead of building anything. **/
+class counting_encoder :
+        public encoder
+{
+public:
+    std::size_t scalars    = 0;
+    std::size_t containers = 0;
+    std::size_t keys       = 0;
+    std::size_t open       = 0;
+    
+protected:
+    virtual void write_null() override                      { ++scalars; }
+    virtual void write_object_begin() override              { ++containers; ++open; }
+    virtual void write_object_end() override                { --open; }
+    virtual void write_object_key(string_view) override     { ++keys; }
+    virtual void write_object_delimiter() override          { }
+    virtual void write_array_begin() override               { ++containers; ++open; }
+    virtual void write_array_end() override                 { --open; }
+    virtual void write_array_delimiter() override           { }
+    virtual void write_string(string_view) override         { ++scalars; }
+    virtual void write_integer(std::int64_t) override       { ++scalars; }
+    virtual void write_decimal(double) override             { ++scalars; }
+    virtual void write_boolean(bool) override               { ++scalars; }
+};
+
+}
+
+TEST_PARSE(encoder_reformat)
+{
+    const char* input = R"( { "foo" : [1, 2.5, "three", [ ], {}],
+                              "bar" : { "a": true, "b": false, "c": null } } )";
+    std::ostringstream out;
+    ostream_encoder encoder(out);
+    parse(input, encoder);
+    // keys come out in document order instead of the sorted order of an object
+    ensure_eq(std::string(R"({"foo":[1,2.5,"three",[],{}],"bar":{"a":true,"b":false,"c":null}})"), out.str());
+    ensure_eq(parse(input), parse(out.str()));
+}
+
+TEST_PARSE(encoder_reformat_keeps_numbers)
+{
+    const char* input = R"([0.10000000000000000001, 1E400, 7, "caf\u00e9", "plain"])";
+    std::ostringstream out;
+    ostream_encoder encoder(out);
+    reformat(input, encoder);
+    ensure_eq(std::string(R"([0.10000000000000000001,1E400,7,"caf\u00e9","plain"])"), out.str());
+    
+    // encoders which do not take the text still get the numbers
+    counting_encoder counter;
+    reformat(input, counter);
+    ensure_eq(5U, counter.scalars);
+    
+    ensure_throws(parse_error, reformat("[01]", encoder, parse_options::create_strict()));
+}
+
+/** Make the edit to \a text which replaces \a removed (the first time it appears after \a after) with \a inserted. **/
+static edit_range edit_text(std::string& text, const std::string& removed, const std::string& inserted,
+                            const std::string& after = ""
+                           )
+{
+    std::size_t offset = text.find(removed, text.find(after) + after.size());
+    text.replace(offset, removed.size(), inserted);
+    return { offset, removed.size(), inserted.size() };
+}
+
+TEST_PARSE(reparse)
+{
+    std::string text = R"({"a": [1, 2, 3], "b": {"c": "a string long enough to be on the heap"}, "d": [[1], [2]]})";
+    value       tree = parse(text);
+    const char* kept = tree.at("b").at("c").as_string().data();
+    
+    // only the array around the edit is parsed again
+    reparse(tree, text, edit_text(text, "2", "20"));
+    ensure_eq(parse(text), tree);
+    ensure(kept == tree.at("b").at("c").as_string().data());
+    
+    reparse(tree, text, edit_text(text, "heap", "stack"));
+    ensure_eq(parse(text), tree);
+    
+    // this moves where [1] ends, so the arrays around it do not match any more
+    reparse(tree, text, edit_text(text, "], [", ", ", "\"d\": [[1"));
+    ensure_eq(parse(text), tree);
+    ensure_eq(1U, tree.at("d").size());
+    
+    // an edit to the key of an entry or the brackets of the root changes the whole document
+    reparse(tree, text, edit_text(text, "\"a\"", "\"e\""));
+    ensure_eq(parse(text), tree);
+    std::size_t old_size = text.size();
+    text = "[" + text + "]";
+    reparse(tree, text, { 0, old_size, text.size() });
+    ensure_eq(parse(text), tree);
+    
+    ensure_throws(parse_error, reparse(tree, text, edit_text(text, "20", "2 0")));
+    
+    // the sibling after the array around the edit closes at the same depth, but its size is not the one to check
+    text = R"({"a":[[1],[2]],"b":[9,9]})";
+    tree = parse(text);
+    reparse(tree, text, edit_text(text, "1],[2", "1,2"));
+    ensure_eq(parse(text), tree);
+    ensure_eq(1U, tree.at("a").size());
+}
+
+TEST_PARSE(minify)
+{
+    std::string out = "x";
+    minify(" { \"a\" : [ 1.50 , \"b \\u0041\" , true ] , /* note */ \"c\" : null }\n", out);
+    ensure_eq(std::string(R"(x{"a":[1.50,"b \u0041",true],"c":null})"), out);
+    
+    ensure_throws(parse_error, minify("[1, 2", out));
+    ensure_throws(parse_error, minify("[1 /* no */]", out, parse_options().comments(false)));
+    
+    // a stray '/' is not a comment to drop, so it fails just like it does in parse
+    ensure_throws(parse_error, minify("[1,/2]", out));
+    ensure_throws(parse_error, minify("/null", out));
+    ensure_throws(parse_error, minify("[1] /", out));
+    
+    out.clear();
+    minify("[1]  [2]", out, parse_options().complete_parse(false));
+    ensure_eq(std::string("[1]"), out);
+}
+
+TEST_PARSE(encoder_counts)
+{
+    counting_encoder counter;
+    parse(R"({"a": [1, 2, {"b": null}], "c": "d"})", counter);
+    ensure_eq(4U, counter.scalars);
+    ensure_eq(3U, counter.containers);
+    ensure_eq(3U, counter.keys);
+    ensure_eq(0U, counter.open);
+}
+
+TEST_PARSE(encoder_errors)
+{
+    counting_encoder counter;
+    ensure_throws(parse_error,
+                  parse("[1, [2, {\"a\": 3", counter, parse_options().failure_mode(parse_options::on_error::collect_all))
+                 );
+    // everything opened was closed
+    ensure_eq(3U, counter.containers);
+    ensure_eq(0U, counter.open);
+    
+    ensure_throws(parse_error, parse("12", counter, parse_options::create_strict()));
+    ensure_throws(parse_error, parse("[1] 2", counter));
+    ensure_throws(parse_error, parse("", counter));
+}
+
+TEST_PARSE(encoder_incomplete_parse)
+{
+    std::string input = "[1] {\"a\": 2} 3";
+    tokenizer tokens(input);
+    parse_options options = parse_options().complete_parse(false);
+    for (std::size_t expected_containers : { 1, 1, 0 })
+    {
+        counting_encoder counter;
+        parse(tokens, counter, options);
+        ensure_eq(1U, counter.scalars);
+        ensure_eq(expected_containers, counter.containers);
+    }
+}
+
+static value parse_incrementally(string_view input, std::size_t chunk_size, const parse_options& options = parse_options())
+{
+    incremental_parser parser(options);
+    for (std::size_t offset = 0; offset < input.size(); offset += chunk_size)
+        parser.feed(input.substr(offset, std::min(chunk_size, input.size() - offset)));
+    return parser.finish();
+}
+
+TEST(incremental_parser_matches_parse)
+{
+    const char* inputs[] =
+    {
+        R"({"foo": 4, "bar": [2, 3, 4, "5"], "raz": {}})",
+        R"([-1.25e+3, 12345678901234, true, false, null, "a\"b\\cé", [[[]]], {"x": {"y": [{}]}}])",
+        "  \t[1,\r\n 2 /* comment */, \"three\"]  \n",
+        "12",
+        "\"str\\\\\"",
+        "[]   ",
+    };
+    parse_options options = parse_options().comments(true);
+    for (const char* input : inputs)
+    {
+        value expected = parse(input, options);
+        for (std::size_t chunk_size : { 1, 2, 3, 7, 1000 })
+            ensure_eq(expected, parse_incrementally(input, chunk_size, options));
+    }
+}
+
+TEST(incremental_parser_complete)
+{
+    incremental_parser parser;
+    ensure(!parser.feed(R"({"a": [1, 2)"));
+    ensure(!parser.complete());
+    ensure(parser.feed("]}  "));
+    ensure(parser.complete());
+    ensure_eq(object({ { "a", array({ 1, 2 }) } }), parser.finish());
+    
+    // finish resets the parser for the next document
+    ensure(!parser.complete());
+    ensure(parser.feed("[true]"));
+    ensure_eq(array({ true }), parser.finish());
+}
+
+TEST(incremental_parser_scalar_root)
+{
+    incremental_parser parser;
+    ensure(!parser.feed("12"));
+    ensure(!parser.feed("3"));
+    ensure_eq(value(123), parser.finish());
+}
+
+TEST(incremental_parser_errors)
+{
+    ensure_throws(parse_error, parse_incrementally("[1,]", 1, parse_options::create_strict()));
+    ensure_throws(parse_error, parse_incrementally(R"({"a": 1,})", 2, parse_options::create_strict()));
+    ensure_throws(parse_error, parse_incrementally("[1] [2]", 1));
+    ensure_throws(parse_error, parse_incrementally("", 1));
+    ensure_throws(parse_error, parse_incrementally("[1, 2", 1));
+    ensure_eq(array({ 1 }), parse_incrementally("[1,]", 1));
+    ensure_eq(array({ 1 }), parse_incrementally("[1] [2]", 1, parse_options().complete_parse(false)));
+    
+    try
+    {
+        parse_incrementally("[1, 2, bogus", 3, parse_options().failure_mode(parse_options::on_error::collect_all));
+        ensure(false);
+    }
+    catch (const parse_error& err)
+    {
+        ensure_eq(array({ 1, 2, null }), err.partial_result());
+    }
+    
+    incremental_parser parser;
+    ensure_throws(parse_error, parser.feed("[1, }"));
+}
+
+TEST(incremental_parser_problem_location)
+{
+    try
+    {
+        parse_incrementally("[1,\n 2,\n  bogus,\n   3, bogus]", 1,
+                            parse_options().failure_mode(parse_options::on_error::collect_all)
+                           );
+        ensure(false);
+    }
+    catch (const jsonv::parse_error& err)
+    {
+        ensure_eq(3U, err.problems().front().line());
+        ensure_eq(3U, err.problems().front().column());
+        ensure_eq(10U, err.problems().front().character());
+    }
+}
+
+TEST_PARSE(select_paths)
+{
+    std::string input = R"({ "user": { "id": "u-17", "name": "Jäne", "roles": ["a", "b"] },
+                             "events": [ { "ts": 1, "x": [1, {"y": 2}] }, { "ts": 2 }, { "ts": 3 } ],
+                             "huge": [[[{"a": "}]"}]]], "extra": 1.5 })";
+    
+    auto  options = parse_options().select({ path::create(".user.id"), path::create(".events[1].ts") });
+    value result  = parse(input, options);
+    ensure_eq(object({ { "user",   object({ { "id", "u-17" } }) },
+                       { "events", array({ null, object({ { "ts", 2 } }) }) }
+                     }),
+              result
+             );
+    ensure_eq(parse(input).at_path(".events[1].ts"), result.at_path(".events[1].ts"));
+    
+    // A selected value is kept whole and selecting the root keeps everything
+    ensure_eq(object({ { "user", parse(input).at("user") } }),
+              parse(input, parse_options().select({ path({ "user" }) }))
+             );
+    ensure_eq(parse(input), parse(input, parse_options().select({ path(), path::create(".user.id") })));
+    
+    // Streams are filtered the same way
+    std::istringstream stream(input);
+    ensure_eq(result, parse(stream, options));
+}
+
+TEST_PARSE(select_missing)
+{
+    auto options = parse_options().select({ path::create(".a[3]"), path::create(".b.c") });
+    ensure_eq(object({ { "a", array({ null, null }) }, { "b", object() } }),
+              parse(R"({"a": [1, 2], "b": {"x": 5}})", options)
+             );
+    ensure_eq(object({ { "b", 7 } }), parse(R"({"b": 7})", options));
+    ensure_eq(array(), parse(R"([1, 2])", options));
+}
+
+TEST_PARSE(select_errors)
+{
+    auto options = parse_options().select({ path::create(".a") });
+    ensure_throws(parse_error, parse(R"({"a": 1, "b": [1, 2})", options));
+    ensure_throws(parse_error, parse(R"({"a": 1, "b": [1, 2])", options));
+    ensure_throws(parse_error, parse(R"({"a": 1, "b": })", options));
+    
+    // Values which are skipped are not decoded
+    ensure_eq(object({ { "a", 1 } }), parse(R"({"a": 1, "b": [tru, "\x"]})", options));
+}
+
+TEST_PARSE(budgets)
+{
+    std::string input = R"({"a": [1, 2, 3], "bb": "xyz", "c": {"d": null}})";
+    auto limit_of = [&] (parse_options options) -> optional<parse_limit>
+                    {
+                        try
+                        {
+                            parse(input, options.failure_mode(parse_options::on_error::collect_all));
+                            return nullopt;
+                        }
+                        catch (const parse_limit_error& err)
+                        {
+                            return err.limit();
+                        }
+                    };
+    
+    // there are 8 values, the longest string is 3 characters and the largest object has 3 members
+    ensure_eq(parse(input), parse(input, parse_options().max_nodes(8)
+                                                        .max_string_length(3)
+                                                        .max_object_members(3)
+                                                        .max_bytes(1 << 20)
+                                                        .max_parse_time(std::chrono::seconds(10))
+                                 )
+             );
+    ensure(parse_limit::nodes          == limit_of(parse_options().max_nodes(7)));
+    ensure(parse_limit::string_length  == limit_of(parse_options().max_string_length(2)));
+    ensure(parse_limit::object_members == limit_of(parse_options().max_object_members(2)));
+    ensure(parse_limit::bytes          == limit_of(parse_options().max_bytes(4 * sizeof(value))));
+    
+    // the parse stops right where the budget was gone over
+    try
+    {
+        parse(input, parse_options().max_nodes(2));
+        ensure(false);
+    }
+    catch (const parse_limit_error& err)
+    {
+        ensure(null == err.partial_result());
+        ensure_eq(1U, err.problems().size());
+        ensure_eq(7U, err.problems().front().character());
+    }
+    
+    // the clock is only checked every so often, so it takes a longer document to run out of time
+    std::string large = "[";
+    for (int idx = 0; idx < 10000; ++idx)
+        large += "[1, 2], ";
+    large += "[]]";
+    ensure_throws(parse_limit_error, parse(large, parse_options().max_parse_time(std::chrono::nanoseconds(1))));
+    ensure_eq(10001U, parse(large, parse_options().max_parse_time(std::chrono::seconds(10))).size());
+}
+
+TEST_PARSE(try_parse)
+{
+    parse_result good = try_parse(R"({"a": [1, 2]})");
+    ensure(good.has_value());
+    ensure_eq(parse(R"({"a": [1, 2]})"), *good);
+    ensure_eq(parse_errc::none, good.error().code);
+    
+    auto failure_of = [] (string_view input, parse_options options) -> parse_failure
+                      {
+                          parse_result result = try_parse(input, options);
+                          return result ? parse_failure() : result.error();
+                      };
+    ensure_eq(parse_errc::unexpected_end,    failure_of("", parse_options()).code);
+    ensure_eq(parse_errc::unexpected_end,    failure_of(R"({"a": [1, 2)", parse_options()).code);
+    ensure_eq(parse_errc::invalid_token,     failure_of("[nul]", parse_options()).code);
+    ensure_eq(parse_errc::missing_colon,     failure_of(R"({"a" 1})", parse_options()).code);
+    ensure_eq(parse_errc::missing_separator, failure_of("[1 2]", parse_options()).code);
+    ensure_eq(parse_errc::trailing_comma,    failure_of("[1,]", parse_options::create_strict()).code);
+    ensure_eq(parse_errc::not_a_document,    failure_of("1", parse_options::create_strict()).code);
+    ensure_eq(parse_errc::limit_exceeded,    failure_of("[1, 2, 3]", parse_options().max_nodes(2)).code);
+    
+    // only the first problem is reported, at the token where it was found
+    parse_failure failure = failure_of(R"({"a": [1 2], "b": x})", parse_options());
+    ensure_eq(parse_errc::missing_separator, failure.code);
+    ensure_eq(9U, failure.offset);
+    ensure(!failure.details);
+    
+    // the failure mode does not matter
+    ensure_eq(parse_errc::duplicate_key,
+              failure_of(R"({"a": 1, "a": 2})", parse_options().failure_mode(parse_options::on_error::ignore)).code
+             );
+    
+    // details are only there when they are asked for
+    parse_result detailed = try_parse("[1 2]",
+                                      parse_options().failure_mode(parse_options::on_error::collect_all),
+                                      failure_details::full
+                                     );
+    ensure(!detailed);
+    ensure(detailed.error().details != nullptr);
+    ensure_eq(1U, detailed.error().details->problems().size());
+    ensure_eq(kind::array, detailed.error().details->partial_result().kind());
+    ensure_throws(std::exception, detailed.value());
+}
+
+TEST_PARSE(parallel_array)
+{
+    // Make a document large enough to be split up
+    std::string input = "[";
+    for (int idx = 0; idx < 20000; ++idx)
+        input += R"({"idx": )" + std::to_string(idx) + R"(, "name": "entry, [number] \"x\"", "tags": [1, {"a": null}]},)";
+    input += " ]";
+    
+    value expected = parse(input);
+    ensure_eq(20000U, expected.size());
+    ensure_eq(expected, parse(input, parse_options().parallelism(4)));
+    ensure_eq(expected, parse(input, parse_options().parallelism(0)));
+    ensure_eq(expected, parse(input, parse_options().parallelism(3).string_storage(parse_options::strings::share)));
+    
+    // Problems are reported the same way as a serial parse
+    ensure_throws(parse_error, parse(input, parse_options::create_strict().parallelism(4)));
+    std::string broken = input;
+    broken.replace(broken.size() / 2, 4, "bad}");
+    ensure_throws(parse_error, parse(broken, parse_options().parallelism(4)));
+    
+    // A comment hiding a bracket has to be parsed serially
+    std::string commented = input;
+    commented.insert(1, "/* \" ] */");
+    ensure_eq(expected, parse(commented, parse_options().parallelism(4)));
+}
+
+TEST_PARSE(require_finite_numbers)
+{
+    parse_options options = parse_options().require_finite_numbers(true);
+    ensure(std::isinf(parse("1e999").as_decimal()));
+    ensure_throws(parse_error, parse("1e999", options));
+    ensure_throws(parse_error, parse("[1, -1e999]", options));
+    ensure_eq(value(1e300), parse("1e300", options));
+}
+
+TEST_PARSE(numbers_lazy)
+{
+    parse_options     options = parse_options().number_encoding(parse_options::numbers::lazy);
+    const std::string input   = R"([1.10,2.5E3,0.1000000000000000055511151,12345678901234567890123,7,-0.0])";
+    value             numbers = parse(input, options);
+    
+    ensure_eq(input, to_string(numbers));
+    ensure_eq(parse(input), numbers);
+    ensure_eq(1.1, numbers[0].as_decimal());
+    ensure_eq(2500.0, numbers[1].get_unchecked<double>());
+    ensure_eq(kind::decimal, numbers[3].kind());
+    ensure_eq(kind::integer, numbers[4].kind());
+    ensure(std::signbit(numbers[5].as_decimal()));
+    
+    // the text goes along with copies, but not with packing or things which are not JSON text
+    value copy = numbers;
+    ensure_eq(input, to_string(copy));
+    ensure_eq("1.1", to_canonical_string(copy[0]));
+    std::ostringstream pretty;
+    ostream_pretty_encoder(pretty).encode(copy[0]);
+    ensure_eq("1.10", pretty.str());
+    copy[0] = 3.5;
+    ensure_eq("3.5", to_string(copy[0]));
+    ensure_eq("1.10", to_string(numbers[0]));
+    
+    // numbers too long to keep and ones which have to be checked for being finite are converted right away
+    ensure_eq("[0.1,1e300]",
+              to_string(parse("[0.100000000000000000000000000000000000,1e300]", options.require_finite_numbers(false)))
+             );
+    ensure_eq("1e+300", to_string(parse("1e300", parse_options(options).require_finite_numbers(true))));
+    
+    ensure_throws(parse_error, parse("[01.5]", options));
+}
+
+TEST_PARSE(file)
+{
+    std::string   path = jsonv_test::test_path("canada.json");
+    std::ifstream stream(path);
+    value         expected = parse(stream);
+    
+    ensure_eq(expected, parse_file(path));
+    
+    value borrowed = parse_file(path, parse_options().string_storage(parse_options::strings::borrow));
+    ensure_eq(expected, borrowed);
+    
+    ensure_throws(std::system_error, parse_file(jsonv_test::test_path("no-such-file.json")));
+}
+
+TEST_PARSE(key_dictionary)
+{
+    auto          keys    = std::make_shared<key_dictionary>(3);
+    parse_options options = parse_options().keys(keys);
+    
+    std::string input = R"({"a": 1, "b\u00e4": {"a": 2, "c": [{"d": 3}]}})";
+    ensure_eq(parse(input), parse(input, options));
+    ensure_eq(parse(input), parse(input, options));
+    ensure_eq(3U, keys->size());
+    ensure_eq(std::string("b\xc3\xa4"), *keys->find("b\\u00e4"));
+    ensure(keys->find("d") == nullptr);
+    ensure(keys->find("a") == keys->insert("a", "a"));
+    
+    ensure_eq(parse(input), parse_incrementally(input, 5, options));
+    
+    // Keys which fail to decode are not remembered
+    auto bad_keys = std::make_shared<key_dictionary>();
+    ensure_throws(parse_error, parse(R"({"\uzzzz": 1})", parse_options().keys(bad_keys)));
+    ensure_eq(0U, bad_keys->size());
+}
+
+TEST_PARSE(reusable_parser)
+{
+    jsonv::parser parser(parse_options::create_strict());
+    ensure_eq(parse_options::create_strict().max_structure_depth(), parser.options().max_structure_depth());
+    
+    std::string deep = R"({"a": [1, [2, [3, {"b": [4]}]]], "c": "x"})";
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        ensure_eq(parse(deep), parser.parse(deep));
+        ensure_eq(array({ 5 }), parser.parse("[5]"));
+    }
+    
+    // a failure in the middle of a document does not leave anything behind for the next one
+    ensure_throws(parse_error, parser.parse(R"({"a": [1, [2, )"));
+    ensure_throws(parse_error, parser.parse("[1, 2,]"));
+    ensure_eq(parse(deep), parser.parse(deep));
+    
+    jsonv::parser borrowing(parse_options().string_storage(parse_options::strings::borrow));
+    std::string   text = R"(["abc"])";
+    ensure(points_into(text, borrowing.parse(text).at(0).as_string_view()));
+}
+
+TEST_PARSE(into_reuses_storage)
+{
+    const std::string first  = R"({"name": "a string too long for small-string storage", "list": [1, "x", {"k": 2}]})";
+    const std::string second = R"({"name": "another long string which fits in the same", "list": [3, "y", {"k": 4}]})";
+    
+    value target = parse(first);
+    const char*  name_data = target.at("name").as_string().data();
+    const value* elements  = &target.at("list").at(0);
+    
+    parse_into(target, second);
+    ensure_eq(parse(second), target);
+    ensure(name_data == target.at("name").as_string().data());
+    ensure(elements == &target.at("list").at(0));
+    
+    // a copy shares the old tree, so that is left alone
+    value copy = target;
+    copy.make_shareable();
+    parse_into(target, first);
+    ensure_eq(parse(second), copy);
+    ensure_eq(parse(first), target);
+    
+    // a different shape drops what is not there any more
+    jsonv::parser parser;
+    parser.parse_into(target, R"({"list": [true], "name": [], "extra": "e"})");
+    ensure_eq(parse(R"({"list": [true], "name": [], "extra": "e"})"), target);
+    parser.parse_into(target, "[1, 2]");
+    ensure_eq(array({ 1, 2 }), target);
+    
+    ensure_throws(parse_error, parse_into(target, R"({"a": 1, "a": 2})"));
+    ensure_eq(null, target);
+}
+
+TEST_PARSE(validate_syntax)
+{
+    ensure(is_valid(R"({"a": [1, 2.5e3, "xä", true, null], "b": {}})"));
+    ensure(!is_valid(""));
+    ensure(!is_valid("[1, 2"));
+    ensure(!is_valid(R"({"a" 1})"));
+    ensure(!is_valid(R"(["\uzzzz"])"));
+    ensure(!is_valid("[1.]"));
+    ensure(!is_valid("[1] 2"));
+    
+    // the options change what is valid the same way they change what parses
+    ensure(is_valid("[1, 2,]"));
+    ensure(!is_valid("[1, 2,]", parse_options().comma_policy(parse_options::commas::strict)));
+    ensure(is_valid("[01]"));
+    ensure(!is_valid("[01]", parse_options::create_strict()));
+    ensure(is_valid("[-0.5]", parse_options::create_strict()));
+    ensure(!is_valid("5", parse_options::create_strict()));
+    ensure(is_valid("[1] 2", parse_options().complete_parse(false)));
+    ensure(!is_valid("[1e999]", parse_options().require_finite_numbers(true)));
+    ensure(!is_valid("[[[1]]]", parse_options().max_structure_depth(3)));
+    ensure(!is_valid("[1 /* c */]", parse_options().comments(false)));
+    
+    // duplicate keys are not a syntax problem
+    ensure(is_valid(R"({"a": 1, "a": 2})"));
+    
+    ensure(!validate_syntax("[1, 2]"));
+    auto problem = validate_syntax("[1,\n 2 3]");
+    ensure(bool(problem));
+    ensure_eq(2U, problem->line());
+    ensure_eq(4U, problem->column());
+    ensure_eq(7U, problem->character());
+    ensure_throws(parse_error, parse("[1,\n 2 3]"));
+    
+    // a '/' which does not start a comment is an invalid token, not a comment to skip
+    for (const char* input : { "/null", "[1,/2]", "1/", "\"\\u007f\"/", "{\"a\": /1}" })
+    {
+        ensure(!is_valid(input));
+        ensure_throws(parse_error, parse(input));
+        auto stray = validate_syntax(input);
+        ensure(bool(stray));
+        try
+        {
+            parse(input);
+        }
+        catch (const parse_error& err)
+        {
+            ensure_eq(err.problems().front().character(), stray->character());
+        }
+    }
+    
+    // with a complete parse, a root which is not a document is found at the end (where parse finds it)
+    for (const char* input : { "1", "  1  ", "\"abc\" " })
+    {
+        parse_options options = parse_options().require_document(true);
+        for (bool complete : { true, false })
+        {
+            auto root = validate_syntax(input, options.complete_parse(complete));
+            ensure(bool(root));
+            try
+            {
+                parse(input, options);
+                ensure(false);
+            }
+            catch (const parse_error& err)
+            {
+                ensure_eq(err.problems().front().character(), root->character());
+            }
+        }
+    }
+}
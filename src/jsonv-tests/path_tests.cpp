@@ -12,11 +12,17 @@
 #include "filesystem_util.hpp"
 
 #include <jsonv/algorithm.hpp>
+#include <jsonv/compiled_path.hpp>
 #include <jsonv/parse.hpp>
 #include <jsonv/path.hpp>
 #include <jsonv/value.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace jsonv_test
 {
@@ -142,6 +148,121 @@ TEST(path_traverse)
             );
 }
 
+TEST(path_traverse_view)
+{
+    value tree;
+    {
+        std::ifstream stream(test_path("paths.json").c_str());
+        tree = parse(stream);
+    }
+    
+    std::size_t visited = 0;
+    traverse(tree,
+             [&] (const path_view& p, const value& x)
+             {
+                 ++visited;
+                 ensure_eq(to_string(p), x.as_string());
+                 ensure_eq(to_string(p.to_path()), x.as_string());
+                 ensure_eq(x, tree.at_path(p.to_path()));
+             },
+             true
+            );
+    ensure_gt(visited, 0U);
+    
+    // the base path is part of every view
+    value inner = object({ { "b", array({ 1 }) } });
+    std::vector<path> paths;
+    traverse(inner, [&] (const path_view& p, const value&) { paths.push_back(p); }, path({ "a" }));
+    ensure_eq(3U, paths.size());
+    ensure_eq(path::create(".a.b[0]"), paths.back());
+    
+    path_element_view key(string_view("b"));
+    ensure(key == path_element_view(path_element("b")));
+    ensure(key != path_element_view(std::size_t(0)));
+    ensure_throws(kind_error, key.index());
+}
+
+TEST(path_select)
+{
+    value tree;
+    {
+        std::ifstream stream(test_path("paths.json").c_str());
+        tree = parse(stream);
+    }
+    
+    std::vector<path> paths;
+    traverse(tree, [&] (const path& p, const value&) { paths.push_back(p); });
+    std::reverse(paths.begin(), paths.end());
+    std::size_t found_count = paths.size();
+    paths.push_back(paths.back() + "missing");
+    paths.push_back(path({ "not", "here" }));
+    paths.push_back(path({ 100 }));
+    paths.push_back(paths.front());
+    
+    std::vector<const value*> selected = select(tree, paths);
+    ensure_eq(paths.size(), selected.size());
+    for (std::size_t idx = 0; idx < found_count; ++idx)
+        ensure(selected[idx] == &tree.at_path(paths[idx]));
+    ensure(selected[found_count]     == nullptr);
+    ensure(selected[found_count + 1] == nullptr);
+    ensure(selected[found_count + 2] == nullptr);
+    ensure(selected[found_count + 3] == selected[0]);
+}
+
+static std::vector<std::pair<std::string, const value*>> collect_traverse(const value& tree,
+                                                                          bool         leafs_only,
+                                                                          std::size_t  threads
+                                                                         )
+{
+    std::mutex                                        visited_lock;
+    std::vector<std::pair<std::string, const value*>> visited;
+    auto visit = [&] (const path& p, const value& x)
+                 {
+                     std::lock_guard<std::mutex> lock(visited_lock);
+                     visited.emplace_back(to_string(p), &x);
+                 };
+    if (threads == 1)
+        traverse(tree, visit, leafs_only);
+    else
+        traverse_parallel(tree, visit, leafs_only, threads);
+    std::sort(visited.begin(), visited.end());
+    return visited;
+}
+
+TEST(path_traverse_parallel)
+{
+    value tree;
+    {
+        std::ifstream stream(test_path("paths.json").c_str());
+        tree = parse(stream);
+    }
+    value wide = array();
+    for (int idx = 0; idx < 100; ++idx)
+        wide.push_back(idx % 3 == 0 ? tree : value(idx));
+    
+    for (const value* subject : { &tree, &wide })
+    {
+        for (bool leafs_only : { false, true })
+        {
+            auto expected = collect_traverse(*subject, leafs_only, 1);
+            ensure(expected == collect_traverse(*subject, leafs_only, 4));
+            ensure(expected == collect_traverse(*subject, leafs_only, 0));
+        }
+    }
+    
+    ensure_throws(std::runtime_error,
+                  traverse_parallel(wide,
+                                    [] (const path&, const value& x)
+                                    {
+                                        if (x == 50)
+                                            throw std::runtime_error("fifty");
+                                    },
+                                    false,
+                                    4
+                                   )
+                 );
+}
+
 TEST(path_append_key)
 {
     path p;
@@ -234,4 +355,76 @@ TEST(path_combines)
     ensure_eq(goal, a);
 }
 
+static std::vector<value> compiled_path_values(const char* specification, const value& from)
+{
+    std::vector<value> out;
+    for (const value* match : compiled_path::create(specification).match(from))
+        out.push_back(*match);
+    return out;
+}
+
+TEST(compiled_path_matches)
+{
+    value doc = parse(R"({ "orders": [ { "id": 1, "items": [ { "price": 2 }, { "price": 3 } ] },
+                                       { "id": 2, "items": [], "refund": { "price": 4 } },
+                                       { "id": 3 }
+                                     ],
+                           "price": 5,
+                           "a b": [ 6 ]
+                         })");
+    
+    ensure(compiled_path_values(".orders[1].id", doc) == std::vector<value>({ 2 }));
+    ensure(compiled_path_values(".orders[*].id", doc) == std::vector<value>({ 1, 2, 3 }));
+    ensure(compiled_path_values(".orders.*.id", doc) == std::vector<value>({ 1, 2, 3 }));
+    ensure(compiled_path_values(".orders[*].items[*].price", doc) == std::vector<value>({ 2, 3 }));
+    ensure(compiled_path_values(".orders..price", doc) == std::vector<value>({ 2, 3, 4 }));
+    // a value comes before the values inside of it
+    ensure(compiled_path_values("..price", doc) == std::vector<value>({ 5, 2, 3, 4 }));
+    ensure(compiled_path_values("..[0].id", doc) == std::vector<value>({ 1 }));
+    ensure(compiled_path_values(R"(["a b"][*])", doc) == std::vector<value>({ 6 }));
+    ensure(compiled_path_values(".orders[7].id", doc).empty());
+    ensure(compiled_path_values(".price.id", doc).empty());
+    ensure(compiled_path_values(".price[0]", doc).empty());
+    ensure_eq(18U, compiled_path_values("..*", doc).size());
+    
+    // matches refer into the document
+    compiled_path ids = compiled_path::create(".orders[*].id");
+    ensure(&doc.at_path(".orders[2].id") == ids.match(doc).back());
+    for (value* id : ids.match(doc))
+        *id = id->as_integer() * 10;
+    ensure_eq(value(30), doc.at_path(".orders[2].id"));
+    
+    ensure(ids.find(doc) == &doc.at_path(".orders[0].id"));
+    ensure(compiled_path::create(".nothing..id").find(doc) == nullptr);
+}
+
+TEST(compiled_path_exact)
+{
+    path p = path::create(".a[1][\"b c\"]");
+    compiled_path query(p);
+    ensure(query.exact());
+    ensure_eq(to_string(p), to_string(query));
+    
+    value doc = parse(R"({ "a": [ 0, { "b c": true } ] })");
+    ensure(query.find(doc) == &doc.at_path(p));
+    
+    ensure(!compiled_path::create(".a[*]").exact());
+    ensure(!compiled_path::create("..b").exact());
+}
+
+TEST(compiled_path_to_string)
+{
+    for (const char* specification : { ".a.b[3]", ".a.*", ".a..b", "..*", "..[2]", ".a..*.c" })
+        ensure_eq(std::string(specification), to_string(compiled_path::create(specification)));
+    ensure_eq(".a.*", to_string(compiled_path::create(".a[*]")));
+}
+
+TEST(compiled_path_parse_invalid)
+{
+    ensure_throws(std::invalid_argument, compiled_path::create(".a#"));
+    ensure_throws(std::invalid_argument, compiled_path::create(".a.."));
+    ensure_throws(std::invalid_argument, compiled_path::create(".a...b"));
+    ensure_throws(std::invalid_argument, compiled_path::create("[*"));
+}
+
 }
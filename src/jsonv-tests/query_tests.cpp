@@ -0,0 +1,205 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/encode.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/query.hpp>
+#include <jsonv/tokenizer.hpp>
+#include <jsonv/value.hpp>
+
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+namespace
+{
+
+const std::string sample = R"({
+    "rows": [
+        { "id": 1, "name": "alpha", "score": 7.5, "tags": ["a", "b"] },
+        { "id": 2, "name": "beta",  "score": 3,   "tags": [] },
+        { "id": 3, "name": "gamma", "score": 9,   "tags": ["c"], "extra": { "deep": [1, 2, 3] } }
+    ],
+    "total": 3
+})";
+
+/** Run \a program on \a input both as a parsed \c value and on its tokens, collecting the results into arrays. **/
+value run_value(const std::string& program, const std::string& input)
+{
+    value out = array();
+    for (const value& x : query::compile(program).run(parse(input)))
+        out.push_back(x);
+    return out;
+}
+
+value run_tokens(const std::string& program, const std::string& input)
+{
+    value     out = array();
+    tokenizer tokens(input);
+    query::compile(program).run(tokens, [&] (const value& x) { out.push_back(x); });
+    return out;
+}
+
+}
+
+TEST(query_paths)
+{
+    ensure_eq(array({ parse(sample) }), run_value(".", sample));
+    ensure_eq(array({ 3 }), run_value(".total", sample));
+    ensure_eq(array({ "alpha", "beta", "gamma" }), run_value(".rows[].name", sample));
+    ensure_eq(array({ "gamma" }), run_value(".rows[-1].name", sample));
+    ensure_eq(array({ 2 }), run_value(".rows[1][\"id\"]", sample));
+    ensure_eq(array({ null, null, 3 }), run_value(".rows[].extra.deep[2]", sample));
+    ensure_eq(array({ null }), run_value(".missing.key", sample));
+    ensure_eq(array({ null }), run_value(".rows[10]", sample));
+    ensure_eq(array({ "a", "b", "c" }), run_value(".rows[].tags[]", sample));
+}
+
+TEST(query_filters)
+{
+    ensure_eq(array({ object({ { "id", 1 }, { "n", "alpha" } }),
+                                   object({ { "id", 3 }, { "n", "gamma" } })
+                                 }
+                                ),
+              run_value(".rows[] | select(.score > 5) | {id, n: .name}", sample)
+             );
+    ensure_eq(array({ array({ 2, 0, 1 }) }), run_value(".rows | map(.tags | length)", sample));
+    ensure_eq(array({ array({ 1, 3 }) }), run_value("[.rows[] | select(.tags | length > 0) | .id]", sample));
+    ensure_eq(array({ "alpha", 1, "beta", 2 }),
+              run_value(".rows[] | select(.id < 3 and (.name == \"alpha\" or .score == 3)) | .name, .id", sample)
+             );
+    ensure_eq(array({ object({ { "alpha", 8.5 } }) }),
+              run_value(".rows[0] | {(.name): .score + 1}", sample)
+             );
+    ensure_eq(array({ array({ "rows", "total" }) }), run_value("keys", sample));
+    ensure_eq(array(), run_value(".rows[] | empty", sample));
+}
+
+TEST(query_tokens_match_values)
+{
+    static const char* const programs[] =
+    {
+        ".",
+        ".total",
+        ".rows[].name",
+        ".rows[-1].name",
+        ".rows[1][\"id\"]",
+        ".rows[].extra.deep[2]",
+        ".missing.key",
+        ".rows[10]",
+        ".rows[].tags[]",
+        ".rows[] | select(.score > 5) | {id, n: .name}",
+        ".rows | map(.tags | length)",
+        ".[] | length",
+        ".rows[2].extra[]",
+    };
+    for (const char* program : programs)
+        ensure_eq(run_value(program, sample), run_tokens(program, sample));
+}
+
+TEST(query_arithmetic)
+{
+    auto eval = [] (const std::string& program) { return query::compile(program).run(null).at(0); };
+    ensure_eq(value(7), eval("1 + 2 * 3"));
+    ensure_eq(value(9), eval("(1 + 2) * 3"));
+    ensure_eq(value(2), eval("4 / 2"));
+    ensure_eq(value(2.5), eval("5 / 2"));
+    ensure_eq(value(1), eval("7 % 3"));
+    ensure_eq(value(-3), eval("-3"));
+    ensure_eq(value("ab"), eval("\"a\" + \"b\""));
+    ensure_eq(array({ 1, 3 }), eval("[1, 2, 3] - [2]"));
+    ensure_eq(object({ { "a", 1 }, { "b", 3 } }), eval("{a: 1, b: 2} + {b: 3}"));
+    ensure_eq(value(true), eval("1 == 1.0"));
+    ensure_eq(value(5), eval("\"h\\u00e9llo\" | length"));
+    ensure_eq(array({ 11, 12, 21, 22 }), eval("[(1, 2) + (10, 20)]"));
+    ensure_throws(std::domain_error, eval("1 / 0"));
+    ensure_throws(kind_error, eval("{} - 1"));
+}
+
+TEST(query_arithmetic_overflow)
+{
+    auto eval = [] (const std::string& program, const value& input)
+                {
+                    return query::compile(program).run(input).at(0);
+                };
+    const value smallest = object({ { "x", std::numeric_limits<std::int64_t>::min() } });
+    const value largest  = object({ { "x", std::numeric_limits<std::int64_t>::max() } });
+
+    // integer results which do not fit become decimals instead of wrapping around (or trapping)
+    ensure_eq(value(9223372036854775808.0), eval(".x / -1", smallest));
+    ensure_eq(value(0), eval(".x % -1", smallest));
+    ensure_eq(value(9223372036854775808.0), eval("-.x", smallest));
+    ensure_eq(value(9223372036854775808.0), eval(".x | length", smallest));
+    ensure_eq(value(9223372036854775808.0), eval(".x + 1", largest));
+    ensure_eq(value(-9223372036854775810.0), eval(".x - 2", smallest));
+    ensure_eq(value(18446744073709551614.0), eval(".x * 2", largest));
+    ensure_eq(value(-18446744073709551614.0), eval(".x * -2", largest));
+    ensure_eq(value(9223372036854775808.0), eval(".x * -1", smallest));
+    ensure_eq(kind::decimal, eval(".x + 1", largest).kind());
+
+    // results which do fit stay integers
+    ensure_eq(value(std::numeric_limits<std::int64_t>::min() + 1), eval(".x + 1", smallest));
+    ensure_eq(value(std::numeric_limits<std::int64_t>::max() - 1), eval(".x - 1", largest));
+    ensure_eq(value(std::numeric_limits<std::int64_t>::min()), eval(".x * 1", smallest));
+    ensure_eq(value(-std::numeric_limits<std::int64_t>::max()), eval(".x / -1", largest));
+    ensure_eq(value(std::numeric_limits<std::int64_t>::min()), eval("-.x - 1", largest));
+    ensure_eq(kind::integer, eval("-.x - 1", largest).kind());
+
+    // integer literals too large for 64 bits are decimals
+    ensure_eq(kind::decimal, eval("99999999999999999999", null).kind());
+    ensure_eq(value(1e20), eval("100000000000000000000", null));
+    ensure_eq(value(9223372036854775807), eval("9223372036854775807", null));
+    ensure_eq(value(3), eval("3 % 100000000000000000000", null));
+}
+
+TEST(query_errors)
+{
+    ensure_throws(std::invalid_argument, query::compile(""));
+    ensure_throws(std::invalid_argument, query::compile(".a |"));
+    ensure_throws(std::invalid_argument, query::compile(".."));
+    ensure_throws(std::invalid_argument, query::compile("reduce .[] as $x (0; . + $x)"));
+    ensure_throws(std::invalid_argument, query::compile("\"unterminated"));
+    ensure_throws(std::invalid_argument, query::compile("[1, 2"));
+
+    ensure_throws(kind_error, query::compile(".a").run(array({ 1 })));
+    ensure_throws(kind_error, query::compile(".[0]").run(object()));
+    ensure_throws(kind_error, query::compile(".[]").run(5));
+
+    std::string input = R"({"a": [1, 2]})";
+    tokenizer   tokens(input);
+    ensure_throws(kind_error, query::compile(".a.b").run(tokens, [] (const value&) { }));
+}
+
+TEST(query_streaming)
+{
+    ensure_eq(2U, query::compile(".rows[] | select(.score > 5)").streamed_steps());
+    ensure_eq(3U, query::compile(".rows[].name").streamed_steps());
+    ensure_eq(0U, query::compile("[.rows[]]").streamed_steps());
+    ensure_eq(0U, query::compile(".a, .b").streamed_steps());
+
+    // every document in the input is filtered, as jq does on a stream of them
+    std::istringstream input("{\"id\": 1, \"ok\": true}\n{\"id\": 2}\n\n{\"id\": 3, \"ok\": false}");
+    tokenizer          tokens(input);
+    std::ostringstream os;
+    ostream_encoder    encoder(os);
+    ensure_eq(2U, query::compile(".id | select(. != 2)").run(tokens, encoder));
+    ensure_eq("[1,3]", os.str());
+}
+
+}
@@ -0,0 +1,128 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/algorithm.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/schema.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+namespace
+{
+
+static schema order_schema()
+{
+    return schema()
+           .kinds({ kind::object })
+           .required("id", schema().kinds({ kind::integer }).minimum(1))
+           .required("items",
+                     schema().kinds({ kind::array })
+                             .min_size(1)
+                             .elements(schema().kinds({ kind::object })
+                                               .required("sku", schema().kinds({ kind::string }).max_size(8))
+                                               .member("price", schema().kinds({ kind::decimal }).minimum(0))
+                                               .additional_keys(false)
+                                      )
+                    )
+           .member("note", schema().kinds({ kind::string, kind::null }));
+}
+
+}
+
+TEST(schema_validate)
+{
+    schema rules = order_schema();
+    rules.validate(parse(R"({"id": 1, "items": [{"sku": "a", "price": 2}, {"sku": "b"}], "extra": true})"));
+    rules.validate(parse(R"({"id": 4, "items": [{"sku": "abcdefgh", "price": 0.5}], "note": null})"));
+    ensure(schema().allows(kind::string));
+    ensure(rules.find_member("sku") == nullptr);
+    ensure(rules.find_member("items")->element_rules() != nullptr);
+
+    using code = validation_error::code;
+    auto expect_failure = [&] (const char* input, code expected, const char* where)
+                          {
+                              try
+                              {
+                                  rules.validate(parse(input));
+                              }
+                              catch (const validation_error& err)
+                              {
+                                  ensure_eq(expected, err.error_code());
+                                  ensure_eq(path::create(where), err.path());
+                                  return;
+                              }
+                              throw std::runtime_error(std::string("Should have failed: ") + input);
+                          };
+    expect_failure(R"([])",                                          code::wrong_kind,     "");
+    expect_failure(R"({"id": 1.5, "items": [{"sku": "a"}]})",        code::wrong_kind,     ".id");
+    expect_failure(R"({"id": 0, "items": [{"sku": "a"}]})",          code::out_of_range,   ".id");
+    expect_failure(R"({"id": 1, "items": []})",                      code::wrong_size,     ".items");
+    expect_failure(R"({"id": 1})",                                   code::missing_key,    "");
+    expect_failure(R"({"id": 1, "items": [{"sku": "a", "x": 1}]})",  code::unexpected_key, ".items[0]");
+    expect_failure(R"({"id": 1, "items": [{"sku": "123456789"}]})",  code::wrong_size,     ".items[0].sku");
+    expect_failure(R"({"id": 1, "items": [{"sku": "a", "price": -1}]})",
+                   code::out_of_range,
+                   ".items[0].price"
+                  );
+}
+
+TEST(schema_parse_options)
+{
+    auto          rules   = std::make_shared<const schema>(order_schema());
+    parse_options options = parse_options().validation_schema(rules);
+
+    std::string good = R"({"id": 3, "items": [{"sku": "a", "price": 2}], "note": "hi"})";
+    ensure_eq(parse(good), parse(good, options));
+    ensure_throws(parse_error, parse(R"({"id": 3, "items": [{"sku": 5}]})", options));
+    ensure_throws(parse_error, parse(R"({"id": 3, "items": [{"sku": "a"}], "note": 1})", options));
+    ensure_throws(parse_error, parse(R"({"id": 3})", options));
+
+    // Every problem is reported when collecting them all
+    try
+    {
+        parse(R"({"id": -3, "items": [{"sku": 5}, {"sku": "b", "y": 1}]})",
+              parse_options(options).failure_mode(parse_options::on_error::collect_all)
+             );
+        throw std::runtime_error("Should have thrown");
+    }
+    catch (const parse_error& err)
+    {
+        ensure_eq(3U, err.problems().size());
+    }
+}
+
+TEST(schema_parse_parallel_array)
+{
+    std::string input = "[";
+    for (int idx = 0; idx < 20000; ++idx)
+        input += R"({"sku": "s)" + std::to_string(idx % 1000) + R"(", "price": 1},)";
+    input += R"({"sku": "last"}])";
+
+    schema row = schema().kinds({ kind::object }).required("sku", schema().kinds({ kind::string }).max_size(4));
+    auto   rules = std::make_shared<const schema>(schema().kinds({ kind::array }).elements(row));
+    ensure_eq(parse(input), parse(input, parse_options().parallelism(4).validation_schema(rules)));
+
+    auto too_small = std::make_shared<const schema>(schema().kinds({ kind::array }).elements(row).max_size(100));
+    ensure_throws(parse_error, parse(input, parse_options().parallelism(4).validation_schema(too_small)));
+
+    input.insert(input.size() - 3, "x");
+    ensure_throws(parse_error, parse(input, parse_options().parallelism(4).validation_schema(rules)));
+}
+
+}
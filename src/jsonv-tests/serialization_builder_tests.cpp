@@ -12,6 +12,7 @@
 
 #include "test.hpp"
 
+#include <jsonv/encode.hpp>
 #include <jsonv/parse.hpp>
 #include <jsonv/serialization_builder.hpp>
 #include <jsonv/serialization_optional.hpp>
@@ -316,6 +317,181 @@ TEST(serialization_builder_encode_checks)
     ensure_eq(expected, encoded);
 }
 
+TEST(serialization_builder_encode_direct)
+{
+    formats fmt = formats_builder()
+                    .type<person>()
+                        .member("firstname",        &person::firstname)
+                        .member("middle_name",      &person::middle_name)
+                        .member("lastname",         &person::lastname)
+                        .member("age",              &person::age)
+                            .encode_if([] (const serialization_context&, int age) { return age > 20; })
+                        .member("favorite_numbers", &person::favorite_numbers)
+                        .member("winning_numbers",  &person::winning_numbers)
+                    .register_optional<optional<std::string>>()
+                    #if JSONV_COMPILER_SUPPORTS_TEMPLATE_TEMPLATES
+                    .register_containers<long, std::set, std::vector>()
+                    .register_containers<person, std::vector>()
+                    #else
+                    .register_container<std::set<long>>()
+                    .register_container<std::vector<long>>()
+                    .register_container<std::vector<person>>()
+                    #endif
+                    .compose_checked(formats::defaults())
+                ;
+
+    std::vector<person> people = { person("Bob", "Builder", 29, { 1, 2 }, { 3 }, std::string("the")),
+                                   person("Wendy", "\"Q\"", 20)
+                                 };
+    std::string out;
+    {
+        buffer_encoder encoder(out);
+        encode(people, encoder, fmt);
+    }
+    ensure_eq(to_json(people, fmt), parse(out));
+    ensure_eq(std::string(R"({"firstname":"Bob","middle_name":"the","lastname":"Builder","age":29,)")
+                        + R"("favorite_numbers":[1,2],"winning_numbers":[3]})",
+              out.substr(1, out.find('}') )
+             );
+}
+
+TEST(serialization_builder_extract_tokenizer)
+{
+    formats fmt = formats_builder()
+                    .type<person>()
+                        .member("firstname",        &person::firstname)
+                            .alternate_name("first")
+                        .member("middle_name",      &person::middle_name)
+                            .default_value(nullopt)
+                            .default_on_null()
+                        .member("lastname",         &person::lastname)
+                        .member("age",              &person::age)
+                        .member("favorite_numbers", &person::favorite_numbers)
+                            .default_value(std::set<long>{})
+                        .member("winning_numbers",  &person::winning_numbers)
+                            .default_value(std::vector<long>{})
+                    .register_optional<optional<std::string>>()
+                    #if JSONV_COMPILER_SUPPORTS_TEMPLATE_TEMPLATES
+                    .register_containers<long, std::set, std::vector>()
+                    .register_containers<person, std::vector>()
+                    #else
+                    .register_container<std::set<long>>()
+                    .register_container<std::vector<long>>()
+                    .register_container<std::vector<person>>()
+                    #endif
+                    .compose_checked(formats::defaults())
+                ;
+
+    std::string text = R"([
+                            { "first": "Bob", "lastname": "Builder", "age": 29, "firstname": "Robert",
+                              "ignored": { "a": [1, {"b": "}]"}], "c": null },
+                              "favorite_numbers": [ 1, 2 ], "middle_name": null
+                            },
+                            { "winning_numbers": [3], "age": 20, "first": "Wendy", "lastname": "Q",
+                              "middle_name": "the"
+                            }
+                          ]
+                          [ { "firstname": "Lonely", "lastname": "Person", "age": 1 } ])";
+    tokenizer tokens(text);
+    auto people = extract<std::vector<person>>(tokens, fmt);
+    ensure(extract<std::vector<person>>(parse(text.substr(0, text.find("]\n") + 1)), fmt) == people);
+    ensure_eq(2U, people.size());
+    ensure_eq(person("Robert", "Builder", 29, { 1, 2 }), people.at(0));
+    ensure_eq(person("Wendy", "Q", 20, {}, { 3 }, std::string("the")), people.at(1));
+
+    auto more = extract<std::vector<person>>(tokens, fmt);
+    ensure_eq(1U, more.size());
+    ensure_eq(person("Lonely", "Person", 1), more.at(0));
+    ensure_throws(parse_error, extract<std::vector<person>>(tokens, fmt));
+
+    tokenizer missing(string_view(R"([{ "firstname": "Bob", "lastname": "Builder" }])"));
+    ensure_throws(extraction_error, extract<std::vector<person>>(missing, fmt));
+
+    tokenizer wrong_type(string_view(R"([{ "firstname": "Bob", "lastname": "Builder", "age": "old" }])"));
+    try
+    {
+        extract<std::vector<person>>(wrong_type, fmt);
+        ensure(false);
+    }
+    catch (const extraction_error& ex)
+    {
+        ensure_eq(path::create("[0].age"), ex.path());
+    }
+
+    tokenizer not_array(string_view(R"({ "firstname": "Bob" })"));
+    ensure_throws(extraction_error, extract<std::vector<person>>(not_array, fmt));
+}
+
+TEST(serialization_builder_extract_key_dispatch)
+{
+    struct pair_type
+    {
+        int64_t a;
+        int64_t b;
+    };
+
+    formats fmt = formats_builder()
+                    .type<pair_type>()
+                        .member("a", &pair_type::a)
+                            .alternate_name("x")
+                        .member("b", &pair_type::b)
+                            .alternate_name("a")
+                    .compose_checked(formats::defaults())
+                ;
+
+    auto check = [&] (const std::string& text, int64_t a, int64_t b)
+                 {
+                     pair_type from_value = extract<pair_type>(parse(text), fmt);
+                     tokenizer tokens(text);
+                     pair_type from_tokens = extract<pair_type>(tokens, fmt);
+                     return from_value.a == a && from_value.b == b && from_tokens.a == a && from_tokens.b == b;
+                 };
+    ensure(check(R"({ "a": 1, "b": 2 })", 1, 2));
+    ensure(check(R"({ "x": 1, "a": 2 })", 2, 2));
+    ensure(check(R"({ "b": 1, "x": 2, "z": 3 })", 2, 1));
+    ensure(check(R"({ "a": 1 })", 1, 1));
+    ensure_throws(extraction_error, extract<pair_type>(parse(R"({ "x": 1 })"), fmt));
+}
+
+TEST(serialization_builder_extract_key_order_changes)
+{
+    struct triple
+    {
+        int64_t a;
+        int64_t b;
+        int64_t c;
+    };
+
+    formats fmt = formats_builder()
+                    .type<triple>()
+                        .member("a", &triple::a)
+                        .member("b", &triple::b)
+                            .alternate_name("a")
+                        .member("c", &triple::c)
+                            .default_value(0)
+                    .compose_checked(formats::defaults())
+                ;
+
+    // the order of keys remembered from one object must never change the result for the next
+    auto check = [&] (const std::string& text, int64_t a, int64_t b, int64_t c)
+                 {
+                     triple from_value = extract<triple>(parse(text), fmt);
+                     tokenizer tokens(text);
+                     triple from_tokens = extract<triple>(tokens, fmt);
+                     return from_value.a == a && from_value.b == b && from_value.c == c
+                         && from_tokens.a == a && from_tokens.b == b && from_tokens.c == c;
+                 };
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        ensure(check(R"({ "a": 1, "b": 2, "c": 3 })", 1, 2, 3));
+        ensure(check(R"({ "a": 1, "b": 2, "c": 3 })", 1, 2, 3));
+        ensure(check(R"({ "c": 3, "a": 1, "b": 2 })", 1, 2, 3));
+        ensure(check(R"({ "z": 9, "b": 2, "a": 1 })", 1, 2, 0));
+        ensure(check(R"({ "a": 1, "y": 8, "z": 9, "w": 7, "c": 3, "b": 2 })", 1, 2, 3));
+        ensure(check(R"({ "a": 1 })", 1, 1, 0));
+    }
+}
+
 TEST(serialization_builder_check_references_fails)
 {
     formats_builder builder;
@@ -743,6 +919,30 @@ TEST(serialization_builder_polymorphic_direct)
     ensure_throws(duplicate_type_error, make_bad_fmts());
 }
 
+TEST(serialization_builder_polymorphic_keyed_order)
+{
+    formats fmts = formats::compose
+                   ({
+                       formats_builder()
+                           .polymorphic_type<std::unique_ptr<base>>("type")
+                               .subtype<c_derived>([] (const value& v) { return v.is_object() && v.count("force_c"); })
+                               .subtype<a_derived>("a")
+                               .subtype<b_derived>("b")
+                           .type<a_derived>(a_derived::json_adapt)
+                           .type<b_derived>(b_derived::json_adapt)
+                           .type<c_derived>(c_derived::json_adapt)
+                           .check_references(formats::defaults()),
+                       formats::defaults()
+                   });
+
+    ensure_eq("a", extract<std::unique_ptr<base>>(object({{ "type", "a" }}), fmts)->get());
+    ensure_eq("b", extract<std::unique_ptr<base>>(object({{ "type", "b" }}), fmts)->get());
+    // The predicate was added before the keyed subtypes, so it is still checked first
+    ensure_eq("c", extract<std::unique_ptr<base>>(object({{ "type", "a" }, { "force_c", true }}), fmts)->get());
+    ensure_throws(extraction_error, extract<std::unique_ptr<base>>(object({{ "type", "z" }}), fmts));
+    ensure_throws(extraction_error, extract<std::unique_ptr<base>>(array({ "a" }), fmts));
+}
+
 TEST(serialization_builder_duplicate_type_actions)
 {
     // Make one adapter that serializes and deserializes an int directly.
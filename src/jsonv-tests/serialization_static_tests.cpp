@@ -0,0 +1,147 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/encode.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/serialization_builder.hpp>
+#include <jsonv/serialization_static.hpp>
+
+#include <string>
+#include <vector>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+namespace
+{
+
+struct sample
+{
+    std::string       name;
+    int               age;
+    double            height;
+    bool              active;
+    std::vector<long> numbers;
+
+    bool operator==(const sample& other) const
+    {
+        return name    == other.name
+            && age     == other.age
+            && height  == other.height
+            && active  == other.active
+            && numbers == other.numbers;
+    }
+};
+
+static const auto sample_adapter = make_static_adapter<sample>(JSONV_STATIC_MEMBER(sample, name),
+                                                               JSONV_STATIC_MEMBER(sample, age),
+                                                               JSONV_STATIC_MEMBER_NAMED(sample, height, "height_m"),
+                                                               JSONV_STATIC_MEMBER(sample, active),
+                                                               JSONV_STATIC_MEMBER(sample, numbers)
+                                                              );
+
+static formats sample_formats()
+{
+    formats local = formats_builder()
+                        .register_container<std::vector<long>>()
+                        .compose_checked(formats::defaults());
+    formats out = formats::compose({ local });
+    out.register_adapter(&sample_adapter);
+    return out;
+}
+
+}
+
+TEST(serialization_static_round_trip)
+{
+    formats fmt = sample_formats();
+    sample  s{ "Bob", 29, 1.75, true, { 1, 2, 3 } };
+    value   expected = object({ { "name",     "Bob"                },
+                                { "age",      29                   },
+                                { "height_m", 1.75                 },
+                                { "active",   true                 },
+                                { "numbers",  array({ 1, 2, 3 })   },
+                              }
+                             );
+
+    ensure_eq(expected, to_json(s, fmt));
+    ensure(s == extract<sample>(expected, fmt));
+
+    std::string encoded;
+    {
+        buffer_encoder out(encoded);
+        encode(s, out, fmt);
+    }
+    ensure_eq(expected, parse(encoded));
+
+    value extra = expected;
+    extra["ignored"] = "anything";
+    ensure(s == extract<sample>(extra, fmt));
+}
+
+TEST(serialization_static_errors)
+{
+    formats fmt = sample_formats();
+    value   input = object({ { "name",     "Bob"                },
+                             { "age",      "twenty-nine"        },
+                             { "height_m", 1.75                 },
+                             { "active",   true                 },
+                             { "numbers",  array({ 1, "two" })  },
+                           }
+                          );
+
+    try
+    {
+        extract<sample>(input, fmt);
+        throw std::runtime_error("Should have thrown");
+    }
+    catch (const extraction_error& err)
+    {
+        ensure_eq(path::create(".age"), err.path());
+    }
+
+    input["age"] = 29;
+    try
+    {
+        extract<sample>(input, fmt);
+        throw std::runtime_error("Should have thrown");
+    }
+    catch (const extraction_error& err)
+    {
+        ensure_eq(path::create(".numbers[1]"), err.path());
+    }
+
+    input.erase("numbers");
+    ensure_throws(extraction_error, extract<sample>(input, fmt));
+}
+
+TEST(serialization_static_extract_moves)
+{
+    formats     fmt = sample_formats();
+    std::string long_name(100, 'x');
+    value       input = object({ { "name",     long_name            },
+                                 { "age",      29                   },
+                                 { "height_m", 1.75                 },
+                                 { "active",   false                },
+                                 { "numbers",  array()              },
+                               }
+                              );
+    const char* original = input["name"].as_string().c_str();
+
+    sample s = extract<sample>(std::move(input), fmt);
+    ensure_eq(long_name, s.name);
+    ensure(original == s.name.c_str());
+}
+
+}
@@ -18,11 +18,13 @@
 #include <jsonv/detail/scope_exit.hpp>
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <tuple>
 #include <typeinfo>
 #include <typeindex>
 #include <utility>
+#include <vector>
 
 namespace jsonv_test
 {
@@ -203,6 +205,25 @@ TEST(extract_object_search)
     ensure_eq(my_thing(1, 2, "thing"), res);
 }
 
+TEST(extract_object_search_sees_later_registration)
+{
+    formats base_fmts;
+    formats middle   = formats::compose({ base_fmts });
+    formats fmts     = formats::compose({ formats::defaults(), middle });
+    ensure_throws(no_extractor, fmts.get_extractor(typeid(my_thing)));
+
+    // registering in a root after it has been composed (and searched) is seen by everything built on it
+    base_fmts.register_extractor(my_thing::get_extractor());
+    my_thing res = extract<my_thing>(parse(R"({ "a": 1, "b": 2, "c": "thing" })"), fmts);
+    ensure_eq(my_thing(1, 2, "thing"), res);
+
+    // the nearest registration still wins
+    static extractor_construction<my_thing> other_extractor;
+    middle.register_extractor(&other_extractor);
+    ensure(&fmts.get_extractor(typeid(my_thing)) == &other_extractor);
+    ensure(&base_fmts.get_extractor(typeid(my_thing)) == my_thing::get_extractor());
+}
+
 TEST(extract_object_with_globals)
 {
     {
@@ -216,6 +237,35 @@ TEST(extract_object_with_globals)
     ensure_eq(my_thing(1, 2, "thing"), res);
 }
 
+TEST(context_formats_borrowing)
+{
+    formats fmt = formats::compose({ formats::defaults() });
+    formats::set_global(fmt);
+    auto reset_global_on_exit = jsonv::detail::on_scope_exit([] { formats::reset_global(); });
+    
+    // Default contexts refer to the global formats itself; formats::global still hands out a copy
+    ensure(extraction_context().formats() == fmt);
+    ensure(serialization_context().formats() == fmt);
+    ensure(formats::global() != fmt);
+    
+    extraction_context borrowed(std::cref(fmt));
+    ensure(&borrowed.formats() == &fmt);
+    extraction_context borrowed_copy(borrowed);
+    ensure(&borrowed_copy.formats() == &fmt);
+    
+    extraction_context owned(fmt);
+    ensure(&owned.formats() != &fmt);
+    extraction_context owned_copy(owned);
+    ensure(&owned_copy.formats() != &owned.formats());
+    ensure(owned_copy.formats() == fmt);
+    owned_copy = borrowed;
+    ensure(&owned_copy.formats() == &fmt);
+    ensure_eq(5, owned_copy.extract<int>(value(5)));
+    
+    ensure(formats::reset_global() == fmt);
+    ensure(extraction_context().formats() != fmt);
+}
+
 TEST(extract_coerce)
 {
     value val = parse(R"({
@@ -244,6 +294,107 @@ TEST(extract_coerce)
     // some coercing...
     ensure_eq("5", cxt.extract_sub<std::string>(val, "i"));
     ensure_eq(10, cxt.extract_sub<int>(val, "s"));
+    
+    // strings are moved out of values the caller is done with
+    value       str = std::string(100, 'x');
+    const char* original = str.as_string().c_str();
+    ensure(original == cxt.extract<std::string>(std::move(str)).c_str());
+    ensure_eq("4.5", cxt.extract<std::string>(value(4.5)));
+}
+
+TEST(extract_sub_context_path)
+{
+    std::vector<path>               seen;
+    std::vector<extraction_context> kept;
+    auto element_extractor = make_extractor([&] (const extraction_context& context, const value&) -> unassociated
+                                            {
+                                                seen.push_back(context.path());
+                                                kept.push_back(context);
+                                                return unassociated();
+                                            }
+                                           );
+    container_adapter<std::vector<unassociated>> container_extractor;
+    formats locals = formats::compose({ formats::defaults() });
+    locals.register_extractor(&element_extractor);
+    locals.register_adapter(&container_extractor);
+
+    value val = parse(R"({ "a": [ {}, { "b": [ 1 ] } ] })");
+    extraction_context cxt(locals, version(), path::create(".root"));
+    ensure_eq(2U, cxt.extract_sub<std::vector<unassociated>>(val, "a").size());
+    cxt.extract_sub<std::vector<unassociated>>(val, path::create(".a[1].b"));
+    ensure_eq(3U, seen.size());
+    ensure_eq(path::create(".root.a[0]"),      seen.at(0));
+    ensure_eq(path::create(".root.a[1]"),      seen.at(1));
+    ensure_eq(path::create(".root.a[1].b[0]"), seen.at(2));
+
+    // copies do not refer to the contexts they came from, which are gone by now
+    for (std::size_t idx = 0U; idx < kept.size(); ++idx)
+        ensure_eq(seen.at(idx), kept.at(idx).path());
+
+    try
+    {
+        cxt.extract_sub<int>(val.at("a"), 2);
+        ensure(false);
+    }
+    catch (const extraction_error& extract_err)
+    {
+        ensure_eq(path::create(".root[2]"), extract_err.path());
+    }
+}
+
+TEST(extract_moves_from_rvalue)
+{
+    container_adapter<std::vector<std::string>> strings_adapter;
+    formats locals = formats::compose({ formats::defaults() });
+    locals.register_adapter(&strings_adapter);
+
+    value       val     = array({ std::string(100, 'a'), std::string(100, 'b') });
+    const char* storage = val[0].as_string().data();
+    value       kept    = val;
+
+    auto strings = extract<std::vector<std::string>>(std::move(val), locals);
+    ensure_eq(2U, strings.size());
+    ensure_eq(std::string(100, 'b'), strings.at(1));
+    ensure(storage == strings.at(0).data());
+    ensure(val.at(0).is_null());
+
+    // extracting from a copy leaves the original alone
+    ensure(strings == extract<std::vector<std::string>>(value(kept), locals));
+    ensure_eq(std::string(100, 'a'), kept.at(0).as_string());
+}
+
+TEST(extract_elements_parallel)
+{
+    container_adapter<std::vector<std::string>>              strings_adapter;
+    container_adapter<std::vector<std::vector<std::string>>> nested_adapter;
+    formats locals = formats::compose({ formats::defaults() });
+    locals.register_adapter(&strings_adapter);
+    locals.register_adapter(&nested_adapter);
+
+    value val = array();
+    for (int idx = 0; idx < 10000; ++idx)
+        val.push_back(array({ std::to_string(idx), std::string(idx % 50, 'x') }));
+
+    extraction_context serial(locals);
+    extraction_context parallel(locals);
+    parallel.parallelism(4);
+    auto expected = serial.extract<std::vector<std::vector<std::string>>>(val);
+    ensure(expected == parallel.extract<std::vector<std::vector<std::string>>>(val));
+    ensure(expected == parallel.extract<std::vector<std::vector<std::string>>>(value(val)));
+    ensure_eq("9999", expected.at(9999).at(0));
+
+    // the error is for the first bad element, no matter which thread got to its element first
+    val[7500][1] = 1;
+    val[2500][0] = 2;
+    try
+    {
+        parallel.extract<std::vector<std::vector<std::string>>>(val);
+        ensure(false);
+    }
+    catch (const extraction_error& extract_err)
+    {
+        ensure_eq(path::create("[2500][0]"), extract_err.path());
+    }
 }
 
 // Tests that even if we throw a completely bogus exception type, the extraction_context wraps it in an extraction_error
@@ -260,6 +411,39 @@ TEST(extractor_throws_random_thing)
     ensure_throws(extraction_error, cxt.extract_sub<unassociated>(val, "a"));
 }
 
+TEST(try_extract)
+{
+    formats locals = formats::compose({ formats::defaults() });
+    locals.register_extractor(my_thing::get_extractor());
+    
+    auto good = try_extract<my_thing>(parse(R"({ "a": 1, "b": 2, "c": "x" })"), locals);
+    ensure(good.has_value());
+    ensure_eq(my_thing(1, 2, "x"), *good);
+    
+    auto failure_of = [&locals] (const value& from) -> extract_failure
+                      {
+                          auto result = try_extract<my_thing>(from, locals);
+                          return result ? extract_failure() : result.error();
+                      };
+    ensure_eq(extract_errc::kind_mismatch, failure_of(parse(R"({ "a": 1, "b": "2", "c": "x" })")).code);
+    ensure_eq(extract_errc::out_of_range,  failure_of(parse(R"({ "a": 1, "c": "x" })")).code);
+    ensure_eq(extract_errc::no_extractor,  try_extract<unassociated>(value(1), locals).error().code);
+    ensure(!try_extract<unassociated>(value(1), locals).error().details);
+    
+    static auto thrower = make_extractor([] (const value& from) -> unassociated { throw from; });
+    formats throwing;
+    throwing.register_extractor(&thrower);
+    ensure_eq(extract_errc::invalid, try_extract<unassociated>(value(1), throwing).error().code);
+    
+    // with full details, the error is the one extract would have thrown
+    extraction_context cxt(locals, version(), path::create(".root"));
+    auto detailed = cxt.try_extract<my_thing>(parse(R"({ "a": 1, "b": [], "c": "x" })"), failure_details::full);
+    ensure_eq(extract_errc::kind_mismatch, detailed.error().code);
+    ensure(detailed.error().details != nullptr);
+    ensure_eq(path::create(".root.b"), detailed.error().details->path());
+    ensure(!cxt.quiet());
+}
+
 TEST(serialize_basics)
 {
     serialization_context cxt(formats::defaults());
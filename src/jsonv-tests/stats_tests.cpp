@@ -0,0 +1,88 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/encode.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/stats.hpp>
+#include <jsonv/tokenizer.hpp>
+#include <jsonv/value.hpp>
+
+#include <memory>
+#include <sstream>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+TEST(parse_stats_counts)
+{
+    auto  stats  = std::make_shared<parse_stats>();
+    value parsed = parse(R"({"name": "a\nb", "values": [1, 2.5, [true, null]]})", parse_options().stats(stats));
+    ensure_eq(1U, stats->documents);
+    ensure_eq(3U, stats->tokens(token_kind::string));
+    ensure_eq(2U, stats->tokens(token_kind::number));
+    ensure_eq(2U, stats->tokens(token_kind::array_begin));
+    ensure_eq(3U, stats->tokens(token_kind::array_begin | token_kind::object_begin));
+    ensure_eq(std::size_t(4 + 4 + 6), stats->string_bytes);
+    ensure_eq(4U, stats->number_bytes);
+    ensure_eq(3U, stats->max_depth);
+    ensure(stats->total_time >= stats->tokenize_time + stats->string_time + stats->number_time);
+
+    // the same stats add up over parses, including ones into an encoder
+    std::ostringstream out;
+    ostream_encoder    encoder(out);
+    parse("[[[[\"x\"]]]]", encoder, parse_options().stats(stats));
+    ensure_eq(2U, stats->documents);
+    ensure_eq(std::size_t(4 + 4 + 6 + 1), stats->string_bytes);
+    ensure_eq(4U, stats->max_depth);
+
+    // parsing without stats leaves them alone
+    parse("[1, 2, 3]");
+    ensure_eq(2U, stats->documents);
+
+    std::ostringstream printed;
+    printed << *stats;
+    value summary = parse(printed.str());
+    ensure_eq(2, summary.at("documents").as_integer());
+    ensure_eq(4, summary.at("tokens").at("string").as_integer());
+}
+
+TEST(encode_stats_counts)
+{
+    value source = parse(R"({"name": "abc", "values": [1, 2.5, [true, null, "de"]]})");
+
+    encode_stats       stats;
+    std::ostringstream out;
+    ostream_encoder    encoder(out);
+    encoder.encode(source, stats);
+    ensure_eq(to_string(source), out.str());
+
+    ensure_eq(1U, stats.documents);
+    ensure_eq(2U, stats.keys);
+    ensure_eq(2U, stats.values(kind::string));
+    ensure_eq(1U, stats.values(kind::integer));
+    ensure_eq(1U, stats.values(kind::decimal));
+    ensure_eq(2U, stats.values(kind::array));
+    ensure_eq(1U, stats.values(kind::object));
+    ensure_eq(9U, stats.total_values());
+    ensure_eq(std::size_t(4 + 6 + 3 + 2), stats.string_bytes);
+    ensure_eq(3U, stats.max_depth);
+
+    encode_stats twice = stats;
+    twice += stats;
+    ensure_eq(2U, twice.documents);
+    ensure_eq(18U, twice.total_values());
+    ensure_eq(3U, twice.max_depth);
+}
+
+}
@@ -97,6 +97,26 @@ TEST(wide_strings)
     ensure(narrow.as_wstring() == wide.as_wstring());
 }
 
+TEST(wide_strings_round_trip)
+{
+    using namespace jsonv;
+    
+    // long enough to cover the runs of ASCII copied in blocks, broken up by 2, 3 and 4 byte sequences
+    std::string  ascii(100, 'x');
+    std::string  narrow = ascii + u8"\u00e9" + ascii + u8"\u2603" + ascii + u8"\U0001F600";
+    std::wstring wide   = std::wstring(100, L'x') + L"\u00e9" + std::wstring(100, L'x') + L"\u2603"
+                        + std::wstring(100, L'x') + wchar_t(0xd83d) + wchar_t(0xde00);
+    
+    ensure(value(narrow).as_wstring() == wide);
+    ensure_eq(narrow, value(wide).as_string());
+    ensure(value(ascii).as_wstring() == std::wstring(100, L'x'));
+    ensure_eq(std::string(), value(std::wstring()).as_string());
+    
+    ensure_throws(std::range_error, value(ascii + "\xc3").as_wstring());
+    ensure_throws(std::range_error, value(std::wstring(20, L'x') + wchar_t(0xd83d)));
+    ensure_throws(std::range_error, value(std::wstring(20, L'x') + wchar_t(0xde00) + L"x"));
+}
+
 TEST(string_view_construction)
 {
     using namespace jsonv;
@@ -106,3 +126,37 @@ TEST(string_view_construction)
 
     ensure_eq(cp, sv);
 }
+
+TEST(string_move_construction)
+{
+    using namespace jsonv;
+
+    std::string long_text(100, 'x');
+    const char* storage = long_text.data();
+    value       moved(std::move(long_text));
+
+    ensure_eq(std::string(100, 'x'), moved.as_string());
+    // the contents were taken over instead of copied
+    ensure(storage == moved.as_string().data());
+}
+
+TEST(string_take)
+{
+    using namespace jsonv;
+
+    value       text(std::string(100, 'x'));
+    const char* storage = text.as_string().data();
+    std::string taken   = text.take_string();
+    ensure_eq(std::string(100, 'x'), taken);
+    ensure(storage == taken.data());
+    ensure(text.is_null());
+
+    // a string shared with another value is copied
+    value original(std::string(100, 'y'));
+    original.make_shareable();
+    value copy = original;
+    ensure_eq(std::string(100, 'y'), copy.take_string());
+    ensure_eq(std::string(100, 'y'), original.as_string());
+
+    ensure_throws(kind_error, copy.take_string());
+}
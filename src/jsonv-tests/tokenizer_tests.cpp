@@ -11,9 +11,13 @@
 #include "test.hpp"
 
 #include <jsonv/tokenizer.hpp>
+#include <jsonv/detail/scope_exit.hpp>
 
 #include <random>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace jsonv_test
 {
@@ -62,4 +66,128 @@ TEST(tokenizer_string)
     ensure_eq(found.text, "\"true\"");
 }
 
+
+/** Tokenize \a input from an \c std::istream with a tiny buffer, so tokens regularly straddle refills. **/
+static std::vector<std::pair<std::string, token_kind>> tokenize_stream(const std::string& input)
+{
+    auto old_size = tokenizer::min_buffer_size();
+    tokenizer::set_min_buffer_size(7);
+    auto restore = detail::on_scope_exit([old_size] { tokenizer::set_min_buffer_size(old_size); });
+
+    std::istringstream istream(input);
+    tokenizer tokens(istream);
+    std::vector<std::pair<std::string, token_kind>> out;
+    while (tokens.next())
+        out.emplace_back(std::string(tokens.current().text), tokens.current().kind);
+    return out;
+}
+
+TEST(tokenizer_stream_matches_string_view)
+{
+    std::string input = R"({"a": [1, 2.5e10, -3], "long-key-that-does-not-fit": "a string \" with escapes",)"
+                        R"( "literals": [true, false, null], /* comment */ "x": tru})";
+    tokenizer whole(input);
+    std::vector<std::pair<std::string, token_kind>> expected;
+    while (whole.next())
+        expected.emplace_back(std::string(whole.current().text), whole.current().kind);
+
+    auto found = tokenize_stream(input);
+    ensure_eq(expected.size(), found.size());
+    for (std::size_t idx = 0; idx < expected.size(); ++idx)
+    {
+        ensure_eq(expected[idx].first, found[idx].first);
+        ensure_eq(expected[idx].second, found[idx].second);
+    }
+}
+
+TEST(tokenizer_next_batch)
+{
+    std::string input = R"({"a": [1, 2.5e10, -3], "long-key-that-does-not-fit": "a string \" with escapes",)"
+                        R"( /* comment */ "literals": [true, false, null]})";
+    const token_kind skip = token_kind::whitespace | token_kind::comment;
+    tokenizer whole(input);
+    std::vector<std::pair<std::string, token_kind>> expected;
+    while (whole.next())
+        if ((whole.current().kind & skip) == token_kind::unknown)
+            expected.emplace_back(std::string(whole.current().text), whole.current().kind);
+
+    auto old_size = tokenizer::min_buffer_size();
+    tokenizer::set_min_buffer_size(7);
+    auto restore = detail::on_scope_exit([old_size] { tokenizer::set_min_buffer_size(old_size); });
+
+    std::istringstream istream(input);
+    tokenizer from_string(input);
+    tokenizer from_stream(istream);
+    for (tokenizer* tokens : { &from_string, &from_stream })
+    {
+        std::vector<std::pair<std::string, token_kind>> found;
+        tokenizer::token batch[4];
+        while (auto count = tokens->next_batch(batch, skip))
+        {
+            ensure(count <= 4U);
+            for (tokenizer::size_type idx = 0; idx < count; ++idx)
+                found.emplace_back(std::string(batch[idx].text), batch[idx].kind);
+        }
+        ensure_eq(expected.size(), found.size());
+        for (std::size_t idx = 0; idx < expected.size(); ++idx)
+        {
+            ensure_eq(expected[idx].first, found[idx].first);
+            ensure_eq(expected[idx].second, found[idx].second);
+        }
+        ensure_eq(0U, tokens->next_batch(batch));
+    }
+}
+
+TEST(tokenizer_next_batch_keeps_malformed_comment)
+{
+    // a stray '/' looks like a comment, but it is a broken one, so it is not skipped with the comments
+    const token_kind skip = token_kind::whitespace | token_kind::comment;
+    tokenizer tokens("[1, /2] /* fine */");
+    tokenizer::token batch[8];
+    auto count = tokens.next_batch(batch, skip);
+    ensure_eq(6U, count);
+    ensure_eq("/", std::string(batch[3].text));
+    ensure(token_kind::unknown != (batch[3].kind & token_kind::parse_error_indicator));
+    ensure_eq(token_kind::array_end, batch[5].kind);
+}
+
+TEST(tokenizer_stream_buffer_reserve)
+{
+    std::string input = "[\"" + std::string(100, 'x') + "\", 1]";
+    std::istringstream istream(input);
+    tokenizer tokens(istream);
+    tokens.buffer_reserve(3);
+    tokens.buffer_reserve(1000);
+    ensure(tokens.next());
+    ensure_eq(token_kind::array_begin, tokens.current().kind);
+    ensure(tokens.next());
+    ensure_eq(token_kind::string, tokens.current().kind);
+    ensure_eq(102U, tokens.current().text.size());
+}
+
+TEST(tokenizer_current_location)
+{
+    std::string input = "[1,\n  2,\r\n  3]";
+    std::istringstream istream(input);
+    tokenizer tokens(istream);
+    tokenizer::location loc = tokens.current_location();
+    ensure_eq(1U, loc.line);
+    ensure_eq(1U, loc.column);
+    ensure_eq(0U, loc.character);
+
+    while (tokens.next() && tokens.current().text != "3")
+    { }
+    loc = tokens.current_location();
+    ensure_eq(4U, loc.line);
+    ensure_eq(3U, loc.column);
+    ensure_eq(12U, loc.character);
+
+    while (tokens.next())
+    { }
+    loc = tokens.current_location();
+    ensure_eq(4U, loc.line);
+    ensure_eq(5U, loc.column);
+    ensure_eq(input.size(), loc.character);
+}
+
 }
@@ -0,0 +1,100 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/encode.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/serialization.hpp>
+#include <jsonv/serialization_builder.hpp>
+#include <jsonv/trace.hpp>
+#include <jsonv/value.hpp>
+#include <jsonv/detail/scope_exit.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+namespace
+{
+
+/** Writes each call as a line like "begin parse 9" or "end extract". **/
+class recording_tracer :
+        public tracer
+{
+public:
+    virtual void begin(const trace_span& span) noexcept override
+    {
+        bool is_vector = span.type && *span.type == typeid(std::vector<int>);
+        events << "begin " << span.operation << ' ' << span.bytes << (is_vector ? " v" : "") << '\n';
+    }
+
+    virtual void end(const trace_span& span) noexcept override
+    {
+        events << "end " << span.operation << '\n';
+    }
+
+    std::ostringstream events;
+};
+
+}
+
+TEST(trace_spans)
+{
+    formats fmts = formats::compose({ formats_builder().register_container<std::vector<int>>(), formats::defaults() });
+
+    recording_tracer spans;
+    {
+        tracer* previous = set_tracer(&spans);
+        auto    restore  = detail::on_scope_exit([previous] { set_tracer(previous); });
+        ensure(get_tracer() == &spans);
+
+        value              source  = parse("[1, 2, 3]");
+        std::vector<int>   numbers = extract<std::vector<int>>(source, fmts);
+        value              back    = to_json(numbers, fmts);
+        std::ostringstream text;
+        ostream_encoder    encoder(text);
+        encoder.encode(back);
+        ensure_eq(std::string("[1,2,3]"), text.str());
+    }
+    parse("[4]");
+
+    // the extraction and serialization of the elements are inside of the spans for the whole vector
+    ensure_eq(std::string("begin parse 9\n"
+                          "end parse\n"
+                          "begin extract 0 v\n"
+                          "end extract\n"
+                          "begin to_json 0 v\n"
+                          "end to_json\n"
+                          "begin encode 0\n"
+                          "end encode\n"
+                         ),
+              spans.events.str()
+             );
+}
+
+TEST(trace_span_ends_on_failure)
+{
+    recording_tracer spans;
+    {
+        tracer* previous = set_tracer(&spans);
+        auto    restore  = detail::on_scope_exit([previous] { set_tracer(previous); });
+        ensure_throws(parse_error, parse("[1, 2"));
+    }
+
+    ensure_eq(std::string("begin parse 5\nend parse\n"), spans.events.str());
+}
+
+}
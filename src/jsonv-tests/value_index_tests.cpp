@@ -0,0 +1,97 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/parse.hpp>
+#include <jsonv/value.hpp>
+#include <jsonv/value_index.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+namespace jsonv_test
+{
+
+using namespace jsonv;
+
+TEST(value_index_find)
+{
+    value catalog = parse(R"([ { "sku": "a", "size": 1 },
+                               { "sku": "b", "size": 2 },
+                               { "nosku": true },
+                               { "sku": "a", "size": 2 },
+                               { "sku": 5 }
+                             ]
+                            )"
+                         );
+    value_index by_sku(catalog, path::create(".sku"));
+    ensure_eq(3U, by_sku.size());
+    ensure_eq(0U, by_sku.find("a"));
+    ensure(std::vector<std::size_t>({ 0, 3 }) == by_sku.find_all("a"));
+    ensure_eq(2U, by_sku.count("a"));
+    ensure_eq(1U, by_sku.find("b"));
+    ensure_eq(4U, by_sku.find(5.0));
+    ensure_eq(value_index::npos, by_sku.find("c"));
+    ensure(by_sku.find_all("c").empty());
+    ensure(by_sku.key_of(2) == nullptr);
+    ensure_eq(value("b"), *by_sku.key_of(1));
+
+    value_index by_both(catalog, { path::create(".sku"), path::create(".size") });
+    ensure_eq(3U, by_both.find(array({ "a", 2 })));
+    ensure_eq(value_index::npos, by_both.find(array({ "b", 1 })));
+    ensure_eq(value_index::npos, by_both.find("a"));
+
+    ensure_throws(kind_error,            value_index(value("x"), path::create(".sku")));
+    ensure_throws(std::invalid_argument, value_index(catalog, std::vector<path>()));
+}
+
+TEST(value_index_updates)
+{
+    value catalog = array();
+    for (int idx = 0; idx < 10; ++idx)
+        catalog.push_back(object({ { "id", idx } }));
+    value_index by_id(catalog, path::create(".id"));
+
+    catalog.push_back(object({ { "id", 10 } }));
+    by_id.insert(10);
+    ensure_eq(10U, by_id.find(10));
+
+    catalog.insert(catalog.begin_array() + 2, object({ { "id", 100 } }));
+    by_id.insert(2);
+    ensure_eq(2U,  by_id.find(100));
+    ensure_eq(1U,  by_id.find(1));
+    ensure_eq(3U,  by_id.find(2));
+    ensure_eq(11U, by_id.find(10));
+
+    catalog.erase(catalog.begin_array());
+    by_id.erase(0);
+    ensure_eq(value_index::npos, by_id.find(0));
+    ensure_eq(1U,  by_id.find(100));
+    ensure_eq(10U, by_id.find(10));
+
+    catalog[1]["id"] = 5;
+    by_id.update(1);
+    ensure_eq(value_index::npos, by_id.find(100));
+    ensure(std::vector<std::size_t>({ 1, 5 }) == by_id.find_all(5));
+
+    catalog[1].erase("id");
+    by_id.update(1);
+    ensure_eq(5U, by_id.find(5));
+
+    ensure_throws(std::out_of_range, by_id.insert(3));
+    ensure_throws(std::out_of_range, by_id.erase(20));
+
+    catalog[4]["id"] = "changed";
+    by_id.rebuild();
+    ensure_eq(4U, by_id.find("changed"));
+}
+
+}
@@ -129,6 +129,27 @@ TEST(is_operations)
     ensure(nul.is_null());
 }
 
+TEST(as_operations)
+{
+    jsonv::value in_ = 5;
+    jsonv::value num = 2.5;
+    jsonv::value bol = true;
+    jsonv::value str = "x";
+
+    ensure_eq(5, in_.as_integer());
+    ensure_eq(5.0, in_.as_decimal());
+    ensure_eq(2.5, num.as_decimal());
+    ensure(bol.as_boolean());
+    ensure_throws(jsonv::kind_error, num.as_integer());
+    ensure_throws(jsonv::kind_error, str.as_decimal());
+    ensure_throws(jsonv::kind_error, in_.as_boolean());
+
+    ensure_eq(5, in_.get_unchecked<std::int64_t>());
+    ensure_eq(2.5, num.get_unchecked<double>());
+    ensure(bol.get_unchecked<bool>());
+    ensure_eq(jsonv::string_view("x"), str.get_unchecked<jsonv::string_view>());
+}
+
 TEST(hash_set_operations)
 {
     jsonv::value num = 2.9;
@@ -145,3 +166,115 @@ TEST(hash_set_operations)
     ensure_eq(0U, set.count(str));
     ensure_eq(5U, set.size());
 }
+
+TEST(hash_consistent_with_equality)
+{
+    std::hash<jsonv::value> hasher;
+    ensure_eq(jsonv::value(5), jsonv::value(5.0));
+    ensure_eq(hasher(5), hasher(5.0));
+    ensure_eq(hasher(jsonv::parse(R"({"a": [1, "x"], "b": null})")),
+              hasher(jsonv::object({ { "b", jsonv::null }, { "a", jsonv::array({ 1, "x" }) } }))
+             );
+    
+    // these all used to collide
+    ensure(hasher(jsonv::object({ { "a", "b" } })) != hasher(jsonv::object({ { "b", "a" } })));
+    ensure(hasher(jsonv::array({ 1, 1 })) != hasher(jsonv::array({ 2, 2 })));
+    ensure(hasher(jsonv::array()) != hasher(jsonv::object()));
+    ensure(hasher(jsonv::array({ jsonv::array() })) != hasher(jsonv::array()));
+}
+
+TEST(hash_cached_until_change)
+{
+    std::hash<jsonv::value> hasher;
+    jsonv::value doc = jsonv::parse(R"({"list": [1, 2, 3], "nested": {"name": "x"}})");
+    doc.make_shareable();
+    std::size_t before = hasher(doc);
+    ensure_eq(before, hasher(doc));
+    
+    jsonv::value copy = doc;
+    ensure_eq(before, hasher(copy));
+    copy.at("list").push_back(4);
+    ensure(hasher(copy) != before);
+    ensure_eq(hasher(jsonv::parse(R"({"list": [1, 2, 3, 4], "nested": {"name": "x"}})")), hasher(copy));
+    ensure_eq(before, hasher(doc));
+    
+    doc.make_shareable();
+    doc.erase("nested");
+    ensure_eq(hasher(jsonv::parse(R"({"list": [1, 2, 3]})")), hasher(doc));
+}
+
+TEST(value_memory_usage)
+{
+    using namespace jsonv;
+    
+    ensure_eq(0U, memory_usage(value(5)).total_bytes());
+    ensure_eq(0U, memory_usage(null).allocations);
+    
+    std::string long_string(100, 'x');
+    value doc = object({ { "short", "s" },
+                         { "long",  long_string },
+                         { "list",  array({ 1, 2, 3 }) },
+                         { "a key which is longer than the inline buffer of a string", object() }
+                       }
+                      );
+    memory_breakdown usage = memory_usage(doc);
+    ensure(usage.string_bytes >= 100 + 56);
+    ensure(usage.array_bytes >= 3 * sizeof(value));
+    ensure(usage.object_bytes >= 4 * sizeof(value));
+    ensure(usage.header_bytes > 0);
+    // 2 objects, 1 array with its block, 2 strings with 1 long one, 1 long key -- and the object entries
+    ensure(usage.allocations >= 8);
+    ensure_eq(usage.string_bytes + usage.object_bytes + usage.array_bytes + usage.header_bytes, usage.total_bytes());
+    
+    doc.at("list").push_back(4);
+    ensure(memory_usage(doc).array_bytes >= 4 * sizeof(value));
+    ensure(memory_usage(doc).total_bytes() > usage.total_bytes());
+}
+
+TEST(value_shareable_copies)
+{
+    using namespace jsonv;
+    
+    value original = parse(R"({"list": [1, 2, 3], "nested": {"names": ["a", "b"]}, "n": 4})");
+    value expected = original;
+    original.make_shareable();
+    
+    value copy = original;
+    // the storage is shared, so the elements are at the same address
+    ensure(static_cast<const value&>(copy).at("list").array_data()
+           == static_cast<const value&>(original).at("list").array_data()
+          );
+    
+    copy["list"].push_back(4);
+    copy.at("nested").at("names")[0] = "changed";
+    ensure_eq(expected, original);
+    ensure_eq(array({ 1, 2, 3, 4 }), copy.at("list"));
+    ensure_eq("changed", copy.at_path(".nested.names[0]").as_string());
+    
+    // a reference taken from the copy stops its container from being shared again
+    value& names     = copy.at("nested").at("names");
+    value  snapshot  = copy;
+    names.push_back("c");
+    ensure_eq(2U, snapshot.at_path(".nested.names").size());
+    ensure_eq(3U, copy.at_path(".nested.names").size());
+}
+
+TEST(value_shareable_erase_const_iterator)
+{
+    using namespace jsonv;
+    
+    value original = object({ { "a", 1 }, { "b", 2 }, { "c", 3 } });
+    original.make_shareable();
+    value copy = original;
+    
+    // this iterator refers to the storage shared with original
+    value::const_object_iterator iter = static_cast<const value&>(copy).find("b");
+    copy.erase(iter);
+    ensure_eq(object({ { "a", 1 }, { "c", 3 } }), copy);
+    ensure_eq(3U, original.size());
+    
+    value copy2 = original;
+    copy2.erase(static_cast<const value&>(copy2).begin_object(), static_cast<const value&>(copy2).find("c"));
+    ensure_eq(object({ { "c", 3 } }), copy2);
+    ensure_eq(3U, original.size());
+}
@@ -0,0 +1,94 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "test.hpp"
+
+#include <jsonv/encode.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/value.hpp>
+#include <jsonv/writer.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace jsonv;
+
+TEST(writer_matches_encode)
+{
+    value expected = parse(R"({"rows": [{"id": 1, "name": "a\"b", "score": 2.5, "ok": true, "none": null},
+                                       {"id": 2, "tags": ["x", []], "nested": {}}],
+                              "count": 2, "meta": {"source": "db"}})");
+
+    std::string out;
+    {
+        buffer_encoder encoder(out);
+        writer w(encoder);
+        w.begin_object();
+        w.key("count").value(2);
+        w.key("meta").value(object({ { "source", "db" } }));
+        w.key("rows").begin_array();
+        w.begin_object()
+            .key("id").value(1L)
+            .key("name").value("a\"b")
+            .key("none").value(nullptr)
+            .key("ok").value(true)
+            .key("score").value(2.5f)
+            .end_object();
+        w.begin_object()
+            .key("id").value(std::uint8_t(2))
+            .key("nested").begin_object().end_object()
+            .key("tags").begin_array().value(std::string("x")).begin_array().end_array().end_array()
+            .end_object();
+        ensure_eq(2U, w.depth());
+        w.end_array();
+        w.end_object();
+        ensure(w.complete());
+        ensure_eq(0U, w.depth());
+    }
+    ensure_eq(to_string(expected), out);
+}
+
+TEST(writer_scalar_document)
+{
+    std::ostringstream ss;
+    ostream_encoder    encoder(ss);
+    writer             w(encoder);
+    ensure(!w.complete());
+    w.value(string_view("just a string"));
+    ensure(w.complete());
+    ensure_eq(std::string("\"just a string\""), ss.str());
+}
+
+TEST(writer_malformed)
+{
+    std::ostringstream ss;
+    ostream_encoder    encoder(ss);
+
+    writer array_writer(encoder);
+    array_writer.begin_array();
+    ensure_throws(std::logic_error, array_writer.key("k"));
+    ensure_throws(std::logic_error, array_writer.end_object());
+    array_writer.end_array();
+    ensure_throws(std::logic_error, array_writer.null());
+    ensure_throws(std::logic_error, array_writer.end_array());
+
+    writer object_writer(encoder);
+    object_writer.begin_object();
+    ensure_throws(std::logic_error, object_writer.value(1));
+    object_writer.key("a");
+    ensure_throws(std::logic_error, object_writer.key("b"));
+    ensure_throws(std::logic_error, object_writer.end_object());
+    ensure_throws(std::logic_error, object_writer.end_array());
+    object_writer.value(1);
+    object_writer.end_object();
+
+    ensure_eq(std::string(R"([]{"a":1})"), ss.str());
+}
@@ -0,0 +1,394 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/algorithm.hpp>
+#include <jsonv/compiled_path.hpp>
+#include <jsonv/value.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define JSONV_AGGREGATE_SSE2 1
+#   include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#   define JSONV_AGGREGATE_NEON 1
+#   include <arm_neon.h>
+#endif
+
+namespace jsonv
+{
+
+namespace
+{
+
+/** The most integers a single SIMD lane adds up before its sums are moved into an \c integer_sum, which keeps the high
+ *  and low halves of the lane from overflowing.
+**/
+static constexpr std::size_t lane_block_size = std::size_t(1) << 29;
+
+/** An exact sum of integers, kept as <tt>high * 2^32 + low</tt> so that it can not overflow. **/
+struct integer_sum
+{
+    std::int64_t  high = 0;
+    std::uint64_t low  = 0;     //!< Less than 2^32 (except in the middle of \c add_halves).
+
+    void add(std::int64_t x)
+    {
+        high += x >> 32;
+        low  += std::uint64_t(x) & 0xffffffffU;
+        normalize();
+    }
+
+    /** Add the sums of the (logical) high and low halves of \a count integers, \a negatives of which are negative. **/
+    void add_halves(std::uint64_t high_sum, std::uint64_t low_sum, std::uint64_t negatives)
+    {
+        // The high half of a negative number is 2^32 more than its (arithmetic) high half
+        high += std::int64_t(high_sum - (negatives << 32));
+        low  += low_sum;
+        normalize();
+    }
+
+    void normalize()
+    {
+        high += std::int64_t(low >> 32);
+        low  &= 0xffffffffU;
+    }
+
+    double decimal() const
+    {
+        return double(high) * 4294967296.0 + double(low);
+    }
+
+    value result() const
+    {
+        if (high >= -(std::int64_t(1) << 31) && high < (std::int64_t(1) << 31))
+            return std::int64_t((std::uint64_t(high) << 32) | low);
+        else
+            return decimal();
+    }
+};
+
+struct sum_fold
+{
+    integer_sum integers;
+    double      decimals     = 0.0;
+    bool        any_decimals = false;
+
+    void add(const value& x)
+    {
+        if (x.kind() == kind::integer)
+        {
+            integers.add(x.as_integer());
+        }
+        else if (x.kind() == kind::decimal)
+        {
+            decimals     += x.as_decimal();
+            any_decimals  = true;
+        }
+    }
+
+    void add_integers(const std::int64_t* data, std::size_t count)
+    {
+        std::size_t idx = 0;
+#if JSONV_AGGREGATE_SSE2
+        const __m128i low_mask = _mm_set_epi32(0, -1, 0, -1);
+        while (count - idx >= 2)
+        {
+            std::size_t block_end = idx + std::min((count - idx) & ~std::size_t(1), 2 * lane_block_size);
+            __m128i     highs     = _mm_setzero_si128();
+            __m128i     lows      = _mm_setzero_si128();
+            __m128i     negatives = _mm_setzero_si128();
+            for (; idx < block_end; idx += 2)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + idx));
+                highs     = _mm_add_epi64(highs, _mm_srli_epi64(x, 32));
+                lows      = _mm_add_epi64(lows, _mm_and_si128(x, low_mask));
+                negatives = _mm_add_epi64(negatives, _mm_srli_epi64(x, 63));
+            }
+
+            std::uint64_t high_lanes[2];
+            std::uint64_t low_lanes[2];
+            std::uint64_t negative_lanes[2];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(high_lanes), highs);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(low_lanes), lows);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(negative_lanes), negatives);
+            integers.add_halves(high_lanes[0] + high_lanes[1],
+                                low_lanes[0] + low_lanes[1],
+                                negative_lanes[0] + negative_lanes[1]
+                               );
+        }
+#elif JSONV_AGGREGATE_NEON
+        const uint64x2_t low_mask = vdupq_n_u64(0xffffffffU);
+        while (count - idx >= 2)
+        {
+            std::size_t block_end = idx + std::min((count - idx) & ~std::size_t(1), 2 * lane_block_size);
+            uint64x2_t  highs     = vdupq_n_u64(0);
+            uint64x2_t  lows      = vdupq_n_u64(0);
+            uint64x2_t  negatives = vdupq_n_u64(0);
+            for (; idx < block_end; idx += 2)
+            {
+                uint64x2_t x = vreinterpretq_u64_s64(vld1q_s64(data + idx));
+                highs        = vaddq_u64(highs, vshrq_n_u64(x, 32));
+                lows         = vaddq_u64(lows, vandq_u64(x, low_mask));
+                negatives    = vaddq_u64(negatives, vshrq_n_u64(x, 63));
+            }
+            integers.add_halves(vaddvq_u64(highs), vaddvq_u64(lows), vaddvq_u64(negatives));
+        }
+#endif
+        for (; idx < count; ++idx)
+            integers.add(data[idx]);
+    }
+
+    void add_decimals(const double* data, std::size_t count)
+    {
+        if (count == 0)
+            return;
+
+        std::size_t idx   = 0;
+        double      total = 0.0;
+#if JSONV_AGGREGATE_SSE2
+        __m128d first  = _mm_setzero_pd();
+        __m128d second = _mm_setzero_pd();
+        for (; count - idx >= 4; idx += 4)
+        {
+            first  = _mm_add_pd(first, _mm_loadu_pd(data + idx));
+            second = _mm_add_pd(second, _mm_loadu_pd(data + idx + 2));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(first, second));
+        total = lanes[0] + lanes[1];
+#elif JSONV_AGGREGATE_NEON
+        float64x2_t first  = vdupq_n_f64(0.0);
+        float64x2_t second = vdupq_n_f64(0.0);
+        for (; count - idx >= 4; idx += 4)
+        {
+            first  = vaddq_f64(first, vld1q_f64(data + idx));
+            second = vaddq_f64(second, vld1q_f64(data + idx + 2));
+        }
+        total = vaddvq_f64(vaddq_f64(first, second));
+#endif
+        for (; idx < count; ++idx)
+            total += data[idx];
+
+        decimals     += total;
+        any_decimals  = true;
+    }
+
+    value result() const
+    {
+        return any_decimals ? value(integers.decimal() + decimals) : integers.result();
+    }
+};
+
+/** Finds the largest number if \c Max is set; the smallest otherwise. **/
+template <bool Max>
+struct extreme_fold
+{
+    bool         any_integers = false;
+    std::int64_t integer      = 0;
+    bool         any_decimals = false;
+    double       decimal      = 0.0;
+
+    template <typename T>
+    static bool better(T x, T best)
+    {
+        return Max ? best < x : x < best;
+    }
+
+    void add(const value& x)
+    {
+        if (x.kind() == kind::integer)
+        {
+            std::int64_t current = x.as_integer();
+            if (!any_integers || better(current, integer))
+                integer = current;
+            any_integers = true;
+        }
+        else if (x.kind() == kind::decimal)
+        {
+            double current = x.as_decimal();
+            if (!any_decimals || better(current, decimal))
+                decimal = current;
+            any_decimals = true;
+        }
+    }
+
+    void add_integers(const std::int64_t* data, std::size_t count)
+    {
+        if (count == 0)
+            return;
+
+        // Independent lanes, which the compiler can vectorize where there are 64-bit comparisons
+        std::int64_t lanes[4] = { data[0], data[0], data[0], data[0] };
+        std::size_t  idx      = 0;
+        for (; count - idx >= 4; idx += 4)
+            for (std::size_t lane = 0; lane < 4; ++lane)
+                lanes[lane] = better(data[idx + lane], lanes[lane]) ? data[idx + lane] : lanes[lane];
+        for (; idx < count; ++idx)
+            lanes[0] = better(data[idx], lanes[0]) ? data[idx] : lanes[0];
+
+        for (std::int64_t lane : lanes)
+        {
+            if (!any_integers || better(lane, integer))
+                integer = lane;
+            any_integers = true;
+        }
+    }
+
+    void add_decimals(const double* data, std::size_t count)
+    {
+        if (count == 0)
+            return;
+
+        std::size_t idx  = 0;
+        double      best = data[0];
+#if JSONV_AGGREGATE_SSE2
+        if (count >= 2)
+        {
+            __m128d lanes = _mm_loadu_pd(data);
+            for (idx = 2; count - idx >= 2; idx += 2)
+                lanes = Max ? _mm_max_pd(lanes, _mm_loadu_pd(data + idx)) : _mm_min_pd(lanes, _mm_loadu_pd(data + idx));
+            double parts[2];
+            _mm_storeu_pd(parts, lanes);
+            best = better(parts[1], parts[0]) ? parts[1] : parts[0];
+        }
+#elif JSONV_AGGREGATE_NEON
+        if (count >= 2)
+        {
+            float64x2_t lanes = vld1q_f64(data);
+            for (idx = 2; count - idx >= 2; idx += 2)
+                lanes = Max ? vmaxq_f64(lanes, vld1q_f64(data + idx)) : vminq_f64(lanes, vld1q_f64(data + idx));
+            best = Max ? vmaxvq_f64(lanes) : vminvq_f64(lanes);
+        }
+#endif
+        for (; idx < count; ++idx)
+            best = better(data[idx], best) ? data[idx] : best;
+
+        if (!any_decimals || better(best, decimal))
+            decimal = best;
+        any_decimals = true;
+    }
+
+    value result() const
+    {
+        if (any_integers && any_decimals)
+        {
+            value a = integer;
+            value b = decimal;
+            int   c = a.compare(b);
+            return (Max ? c >= 0 : c <= 0) ? a : b;
+        }
+        else if (any_integers)
+        {
+            return integer;
+        }
+        else if (any_decimals)
+        {
+            return decimal;
+        }
+        else
+        {
+            return null;
+        }
+    }
+};
+
+template <typename TFold>
+value fold_array(const value& source)
+{
+    if (source.kind() != kind::array)
+        detail::throw_kind_error(kind::array, source.kind());
+
+    TFold       fold;
+    std::size_t size = source.size();
+    if (const std::int64_t* integers = source.packed_integers())
+    {
+        fold.add_integers(integers, size);
+    }
+    else if (const double* decimals = source.packed_decimals())
+    {
+        fold.add_decimals(decimals, size);
+    }
+    else
+    {
+        const value* elements = source.array_data();
+        for (std::size_t idx = 0; idx < size; ++idx)
+            fold.add(elements[idx]);
+    }
+    return fold.result();
+}
+
+template <typename TFold>
+value fold_matches(const value& from, const compiled_path& query)
+{
+    TFold fold;
+    for (const value* match : query.match(from))
+        fold.add(*match);
+    return fold.result();
+}
+
+}
+
+value sum(const value& source)
+{
+    return fold_array<sum_fold>(source);
+}
+
+value sum(const value& from, const compiled_path& query)
+{
+    return fold_matches<sum_fold>(from, query);
+}
+
+value min(const value& source)
+{
+    return fold_array<extreme_fold<false>>(source);
+}
+
+value min(const value& from, const compiled_path& query)
+{
+    return fold_matches<extreme_fold<false>>(from, query);
+}
+
+value max(const value& source)
+{
+    return fold_array<extreme_fold<true>>(source);
+}
+
+value max(const value& from, const compiled_path& query)
+{
+    return fold_matches<extreme_fold<true>>(from, query);
+}
+
+value group_by(const value& source, const compiled_path& key)
+{
+    if (source.kind() != kind::array)
+        detail::throw_kind_error(kind::array, source.kind());
+
+    value        out      = object();
+    std::size_t  size     = source.size();
+    const value* elements = source.array_data();
+    for (std::size_t idx = 0; idx < size; ++idx)
+    {
+        const value* found = key.find(elements[idx]);
+        if (!found)
+            continue;
+
+        value& group = found->kind() == kind::string ? out[found->as_string()] : out[to_string(*found)];
+        if (group.kind() != kind::array)
+            group = array();
+        group.push_back(elements[idx]);
+    }
+    return out;
+}
+
+}
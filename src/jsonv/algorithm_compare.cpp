@@ -11,14 +11,122 @@
 #include <jsonv/algorithm.hpp>
 #include <jsonv/value.hpp>
 
+#include "detail/fallthrough.hpp"
+
 #include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace jsonv
 {
 
+static int compare_strict(const value& a, const value& b);
+
+static int compare_sizes(std::size_t a, std::size_t b)
+{
+    return a == b ? 0 : a < b ? -1 : 1;
+}
+
+static int compare_strict_strings(string_view a, string_view b)
+{
+    // Copies of a shareable value (and strings borrowed from the same place) refer to the same characters
+    if (a.data() == b.data())
+        return compare_sizes(a.size(), b.size());
+    
+    std::size_t common = a.size() < b.size() ? a.size() : b.size();
+    if (int rc = std::char_traits<char>::compare(a.data(), b.data(), common))
+        return rc < 0 ? -1 : 1;
+    return compare_sizes(a.size(), b.size());
+}
+
+static int compare_strict_arrays(const value& a, const value& b)
+{
+    const value* aiter = a.array_data();
+    const value* biter = b.array_data();
+    std::size_t  asize = a.size();
+    std::size_t  bsize = b.size();
+    
+    // Copies of a shareable value refer to the same storage
+    if (aiter == biter && asize == bsize)
+        return 0;
+    
+    const value* aend = aiter + (asize < bsize ? asize : bsize);
+    for ( ; aiter != aend; ++aiter, ++biter)
+    {
+        // Arrays of integers are common enough to be worth comparing without the switch for each element
+        if (aiter->kind() == kind::integer && biter->kind() == kind::integer)
+        {
+            std::int64_t x = aiter->as_integer();
+            std::int64_t y = biter->as_integer();
+            if (x != y)
+                return x < y ? -1 : 1;
+        }
+        else if (int cmp = compare_strict(*aiter, *biter))
+        {
+            return cmp;
+        }
+    }
+    return compare_sizes(asize, bsize);
+}
+
+static int compare_strict_objects(const value& a, const value& b)
+{
+    auto aiter = a.begin_object();
+    auto biter = b.begin_object();
+    auto aend  = a.end_object();
+    auto bend  = b.end_object();
+    
+    // Copies of a shareable value refer to the same storage, so their first entries are the same
+    if (a.size() == b.size() && (aiter == aend || &*aiter == &*biter))
+        return 0;
+    
+    for ( ; aiter != aend && biter != bend; ++aiter, ++biter)
+    {
+        if (int cmp = compare_strict_strings(aiter->first, biter->first))
+            return cmp;
+        if (int cmp = compare_strict(aiter->second, biter->second))
+            return cmp;
+    }
+    return aiter == aend ? biter == bend ? 0 : -1
+                         : 1;
+}
+
+/** The same ordering as \c compare with \c compare_traits, without going through the traits for every element. **/
+static int compare_strict(const value& a, const value& b)
+{
+    if (&a == &b)
+        return 0;
+    
+    if (int kindcmp = compare_traits::compare_kinds(a.kind(), b.kind()))
+        return kindcmp;
+    
+    switch (a.kind())
+    {
+    case kind::null:
+        return 0;
+    case kind::boolean:
+        return compare_traits::compare_booleans(a.as_boolean(), b.as_boolean());
+    case kind::integer:
+        if (b.kind() == kind::integer)
+            return compare_traits::compare_integers(a.as_integer(), b.as_integer());
+        JSONV_FALLTHROUGH();
+    case kind::decimal:
+        return compare_traits::compare_decimals(a.as_decimal(), b.as_decimal());
+    case kind::string:
+        return compare_strict_strings(a.as_string_view(), b.as_string_view());
+    case kind::array:
+        return compare_strict_arrays(a, b);
+    case kind::object:
+        return compare_strict_objects(a, b);
+    default:
+        return -1;
+    }
+}
+
 int compare(const value& a, const value& b)
 {
-    return compare(a, b, compare_traits());
+    return compare_strict(a, b);
 }
 
 struct compare_traits_icase :
@@ -11,20 +11,89 @@
 #include <jsonv/algorithm.hpp>
 #include <jsonv/value.hpp>
 
+#include "detail/hash.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace jsonv
 {
 
-diff_result diff(value left, value right)
+namespace
+{
+
+/** Hashes of the objects and arrays in a tree, each worked out once from the hashes of its children. Scalars are
+ *  cheap to hash and are not remembered. Values which compare equal always hash the same.
+**/
+class subtree_hashes
+{
+public:
+    std::uint64_t operator()(const value& x)
+    {
+        if (x.kind() != kind::array && x.kind() != kind::object)
+            return std::hash<value>()(x);
+        
+        auto iter = _hashes.find(&x);
+        if (iter != _hashes.end())
+            return iter->second;
+        
+        std::uint64_t out;
+        if (x.kind() == kind::object)
+        {
+            out = detail::hash_combine(seed_object, x.size());
+            for (const auto& field : x.as_object())
+            {
+                std::uint64_t key = detail::hash_bytes(field.first.data(), field.first.size(), seed_key);
+                out = detail::hash_combine(detail::hash_combine(out, key), (*this)(field.second));
+            }
+        }
+        else
+        {
+            out = detail::hash_combine(seed_array, x.size());
+            for (const value& elem : x.as_array())
+                out = detail::hash_combine(out, (*this)(elem));
+        }
+        _hashes.emplace(&x, out);
+        return out;
+    }
+    
+    /** Are \a a and \a b equal? Values with different hashes are not compared at all. **/
+    bool equal(const value& a, const value& b)
+    {
+        return (*this)(a) == (*this)(b) && a == b;
+    }
+    
+private:
+    static constexpr std::uint64_t seed_array  = 0x27d4eb2f165667c5ULL;
+    static constexpr std::uint64_t seed_object = 0x85ebca77c2b2ae63ULL;
+    static constexpr std::uint64_t seed_key    = 0x165667b19e3779f9ULL;
+    
+private:
+    std::unordered_map<const value*, std::uint64_t> _hashes;
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// diff                                                                                                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static diff_result diff_impl(subtree_hashes& hashes, const value& left, const value& right)
 {
     diff_result result;
-    if (left == right)
+    if (hashes.equal(left, right))
     {
-        result.same = std::move(left);
+        result.same = left;
     }
     else if (left.kind() != right.kind())
     {
-        result.left  = std::move(left);
-        result.right = std::move(right);
+        result.left  = left;
+        result.right = right;
     }
     else switch (left.kind())
     {
@@ -33,8 +102,8 @@ diff_result diff(value left, value right)
     case kind::integer:
     case kind::null:
     case kind::string:
-        result.left = std::move(left);
-        result.right = std::move(right);
+        result.left = left;
+        result.right = right;
         break;
     case kind::array:
         result.same = array();
@@ -42,61 +111,277 @@ diff_result diff(value left, value right)
         result.right = array();
         for (value::size_type idx = 0; idx < std::min(left.size(), right.size()); ++idx)
         {
-            diff_result subresult = diff(std::move(left.at(idx)), std::move(right.at(idx)));
+            diff_result subresult = diff_impl(hashes, left[idx], right[idx]);
             result.same.push_back(std::move(subresult.same));
             result.left.push_back(std::move(subresult.left));
             result.right.push_back(std::move(subresult.right));
         }
 
         if (left.size() > right.size())
-            result.left.insert(result.left.end_array(),
-                               std::make_move_iterator(left.begin_array() + right.size()),
-                               std::make_move_iterator(left.end_array())
-                              );
+            result.left.insert(result.left.end_array(), left.begin_array() + right.size(), left.end_array());
         else if (left.size() < right.size())
-            result.right.insert(result.right.end_array(),
-                                std::make_move_iterator(right.begin_array() + left.size()),
-                                std::make_move_iterator(right.end_array())
-                               );
+            result.right.insert(result.right.end_array(), right.begin_array() + left.size(), right.end_array());
         break;
     case kind::object:
         result.same = object();
         result.left = object();
         result.right = object();
-        for (value::object_iterator liter = left.begin_object();
-             liter != left.end_object();
-             liter = left.erase(liter)
-            )
+        for (const auto& lfield : left.as_object())
         {
-            auto riter = right.find(liter->first);
+            auto riter = right.find(lfield.first);
             if (riter == right.end_object())
             {
-                result.left.insert({ liter->first, std::move(liter->second) });
+                result.left.insert({ lfield.first, lfield.second });
             }
-            else if (liter->second == riter->second)
+            else if (hashes.equal(lfield.second, riter->second))
             {
-                result.same[liter->first] = std::move(liter->second);
-                right.erase(riter);
+                result.same[lfield.first] = lfield.second;
             }
             else
             {
-                diff_result subresult = diff(std::move(liter->second), std::move(riter->second));
-                result.left[liter->first] = std::move(subresult.left);
-                result.right[liter->first] = std::move(subresult.right);
-                right.erase(riter);
+                diff_result subresult = diff_impl(hashes, lfield.second, riter->second);
+                result.left[lfield.first] = std::move(subresult.left);
+                result.right[lfield.first] = std::move(subresult.right);
             }
         }
 
-        for (value::object_iterator riter = right.begin_object();
-             riter != right.end_object();
-             riter = right.erase(riter)
-            )
+        for (const auto& rfield : right.as_object())
         {
-            result.right.insert({ riter->first, std::move(riter->second) });
+            if (left.count(rfield.first) == 0)
+                result.right.insert({ rfield.first, rfield.second });
         }
         break;
     }
     return result;
 }
 
+diff_result diff(const value& left, const value& right)
+{
+    subtree_hashes hashes;
+    return diff_impl(hashes, left, right);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// diff_patch                                                                                                         //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+class patch_builder
+{
+public:
+    void diff(const value& from, const value& to, const std::string& pointer)
+    {
+        if (_hashes.equal(from, to))
+            return;
+        
+        if (from.kind() != to.kind() || (from.kind() != kind::array && from.kind() != kind::object))
+            add_operation("replace", pointer, &to);
+        else if (from.kind() == kind::object)
+            diff_object(from, to, pointer);
+        else
+            diff_array(from, to, pointer);
+    }
+    
+    value take()
+    {
+        return std::move(_ops);
+    }
+    
+private:
+    /** Append \a key to the JSON Pointer \a pointer, escaping \c '~' and \c '/' as RFC 6901 says to. **/
+    static std::string pointer_to(const std::string& pointer, string_view key)
+    {
+        std::string out = pointer;
+        out.reserve(out.size() + key.size() + 1);
+        out += '/';
+        for (char c : key)
+        {
+            if (c == '~')
+                out += "~0";
+            else if (c == '/')
+                out += "~1";
+            else
+                out += c;
+        }
+        return out;
+    }
+    
+    static std::string pointer_to(const std::string& pointer, std::size_t idx)
+    {
+        return pointer + '/' + std::to_string(idx);
+    }
+    
+    void add_operation(const char* op, std::string pointer, const value* val = nullptr)
+    {
+        value operation = object({ { "op", op }, { "path", std::move(pointer) } });
+        if (val)
+            operation.insert({ "value", *val });
+        _ops.push_back(std::move(operation));
+    }
+    
+    void add_move(std::string from_pointer, std::string pointer)
+    {
+        _ops.push_back(object({ { "op",   "move"                  },
+                                { "from", std::move(from_pointer) },
+                                { "path", std::move(pointer)      },
+                              }
+                             )
+                      );
+    }
+    
+    void diff_object(const value& from, const value& to, const std::string& pointer)
+    {
+        for (const auto& field : from.as_object())
+        {
+            auto iter = to.find(field.first);
+            if (iter == to.end_object())
+                add_operation("remove", pointer_to(pointer, field.first));
+            else
+                diff(field.second, iter->second, pointer_to(pointer, field.first));
+        }
+        
+        for (const auto& field : to.as_object())
+        {
+            if (from.count(field.first) == 0)
+                add_operation("add", pointer_to(pointer, field.first), &field.second);
+        }
+    }
+    
+    /** Turn the array \a from into \a to. Each element of \a to is matched with the first unused element of \a from
+     *  with the same contents. The matched elements of \a from in the longest run which is already in the order of
+     *  \a to stay where they are and the others are moved. Elements of \a from which are not matched with anything are
+     *  either changed in place (when \a to has an unmatched element at the same index) or removed.
+    **/
+    void diff_array(const value& from, const value& to, const std::string& pointer)
+    {
+        // match the elements of to with elements of from
+        std::unordered_map<std::uint64_t, std::vector<std::size_t>> unmatched;
+        for (std::size_t idx = from.size(); idx > 0; --idx)
+            unmatched[_hashes(from[idx - 1])].push_back(idx - 1);
+        
+        std::vector<std::size_t> match_of(to.size(), npos);
+        std::vector<char>        from_matched(from.size(), false);
+        for (std::size_t idx = 0; idx < to.size(); ++idx)
+        {
+            auto bucket = unmatched.find(_hashes(to[idx]));
+            if (bucket == unmatched.end())
+                continue;
+            
+            auto candidate = std::find_if(bucket->second.rbegin(),
+                                          bucket->second.rend(),
+                                          [&] (std::size_t from_idx) { return from[from_idx] == to[idx]; }
+                                         );
+            if (candidate != bucket->second.rend())
+            {
+                match_of[idx] = *candidate;
+                from_matched[*candidate] = true;
+                bucket->second.erase(std::next(candidate).base());
+            }
+        }
+        
+        std::vector<char> stays = longest_increasing(match_of, from.size());
+        
+        // the current contents of the array being patched -- the index into from for each element or npos for elements
+        // which are already what they should be
+        std::vector<std::size_t> current(from.size());
+        for (std::size_t idx = 0; idx < current.size(); ++idx)
+            current[idx] = idx;
+        
+        for (std::size_t idx = 0; idx < to.size(); ++idx)
+        {
+            std::size_t from_idx = match_of[idx];
+            if (from_idx != npos && stays[from_idx])
+            {
+                // get everything between here and the element out of the way -- it is either not needed or will be
+                // moved into place later
+                while (current[idx] != from_idx)
+                {
+                    if (from_matched[current[idx]])
+                    {
+                        add_move(pointer_to(pointer, idx), pointer_to(pointer, current.size() - 1));
+                        std::rotate(current.begin() + idx, current.begin() + idx + 1, current.end());
+                    }
+                    else
+                    {
+                        add_operation("remove", pointer_to(pointer, idx));
+                        current.erase(current.begin() + idx);
+                    }
+                }
+            }
+            else if (from_idx != npos)
+            {
+                auto iter = std::find(current.begin() + idx, current.end(), from_idx);
+                if (iter != current.begin() + idx)
+                {
+                    add_move(pointer_to(pointer, std::size_t(iter - current.begin())), pointer_to(pointer, idx));
+                    std::rotate(current.begin() + idx, iter, iter + 1);
+                }
+            }
+            else if (idx < current.size() && !from_matched[current[idx]])
+            {
+                diff(from[current[idx]], to[idx], pointer_to(pointer, idx));
+            }
+            else
+            {
+                add_operation("add", pointer_to(pointer, idx), &to[idx]);
+                current.insert(current.begin() + idx, npos);
+            }
+            current[idx] = npos;
+        }
+        
+        for (std::size_t idx = current.size(); idx > to.size(); --idx)
+            add_operation("remove", pointer_to(pointer, idx - 1));
+    }
+    
+    /** Find the longest run of elements of \a match_of (ignoring \c npos) which increase.
+     *  
+     *  \returns For each of the \a from_size elements of \c from, if it is part of that run.
+    **/
+    static std::vector<char> longest_increasing(const std::vector<std::size_t>& match_of, std::size_t from_size)
+    {
+        // tails[length - 1] is the index into match_of of the smallest end of an increasing run of that length
+        std::vector<std::size_t> tails;
+        std::vector<std::size_t> previous(match_of.size(), npos);
+        for (std::size_t idx = 0; idx < match_of.size(); ++idx)
+        {
+            if (match_of[idx] == npos)
+                continue;
+            
+            auto iter = std::lower_bound(tails.begin(),
+                                         tails.end(),
+                                         match_of[idx],
+                                         [&] (std::size_t tail, std::size_t x) { return match_of[tail] < x; }
+                                        );
+            if (iter != tails.begin())
+                previous[idx] = *std::prev(iter);
+            if (iter == tails.end())
+                tails.push_back(idx);
+            else
+                *iter = idx;
+        }
+        
+        std::vector<char> out(from_size, false);
+        for (std::size_t idx = tails.empty() ? npos : tails.back(); idx != npos; idx = previous[idx])
+            out[match_of[idx]] = true;
+        return out;
+    }
+    
+private:
+    subtree_hashes _hashes;
+    value          _ops = array();
+};
+
+}
+
+value diff_patch(const value& from, const value& to)
+{
+    patch_builder builder;
+    builder.diff(from, to, std::string());
+    return builder.take();
+}
+
 }
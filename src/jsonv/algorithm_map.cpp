@@ -11,6 +11,11 @@
 #include <jsonv/algorithm.hpp>
 #include <jsonv/value.hpp>
 
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <vector>
+
 namespace jsonv
 {
 
@@ -78,4 +83,122 @@ value map(const std::function<value (value)>& func,
     }
 }
 
+/** Each thread gets about this many parts of the input to work on, so a thread with cheap elements can take on
+ *  more.
+**/
+static constexpr std::size_t parallel_parts_per_thread = 8;
+
+/** Fill in \a out with \c func(elements[idx]) for each element, splitting the work among \a threads. **/
+template <typename TElement, typename FApply>
+static void map_elements_parallel(const std::vector<TElement>& elements,
+                                  std::vector<value>&          out,
+                                  std::size_t                  threads,
+                                  const FApply&                apply
+                                 )
+{
+    threads = detail::resolve_threads(threads);
+    std::size_t parts = std::min(elements.size(), threads * parallel_parts_per_thread);
+    out.resize(elements.size());
+    detail::run_parallel(parts,
+                         threads,
+                         [&] (std::size_t part)
+                         {
+                             std::size_t first = elements.size() * part / parts;
+                             std::size_t last  = elements.size() * (part + 1) / parts;
+                             for (std::size_t idx = first; idx < last; ++idx)
+                                 out[idx] = apply(elements[idx]);
+                         }
+                        );
+}
+
+value map_parallel(const std::function<value (const value&)>& func,
+                   const value&                               input,
+                   std::size_t                                threads
+                  )
+{
+    std::vector<value> results;
+    switch (input.kind())
+    {
+    case kind::array:
+    {
+        std::vector<const value*> elements;
+        elements.reserve(input.size());
+        for (const value& sub : input.as_array())
+            elements.push_back(&sub);
+        map_elements_parallel(elements, results, threads, [&] (const value* sub) { return func(*sub); });
+        
+        value out = array();
+        out.reserve(results.size());
+        for (value& result : results)
+            out.push_back(std::move(result));
+        return out;
+    }
+    case kind::object:
+    {
+        std::vector<const value::object_value_type*> elements;
+        elements.reserve(input.size());
+        for (const value::object_value_type& sub : input.as_object())
+            elements.push_back(&sub);
+        map_elements_parallel(elements,
+                              results,
+                              threads,
+                              [&] (const value::object_value_type* sub) { return func(sub->second); }
+                             );
+        
+        value out = object();
+        for (std::size_t idx = 0; idx < elements.size(); ++idx)
+            out.emplace_hint(out.end_object(), elements[idx]->first, std::move(results[idx]));
+        return out;
+    }
+    default:
+        return map(func, input);
+    }
+}
+
+value map_parallel(const std::function<value (value)>& func,
+                   value&&                             input,
+                   std::size_t                         threads
+                  )
+{
+    std::vector<value> results;
+    switch (input.kind())
+    {
+    case kind::array:
+    {
+        std::vector<value*> elements;
+        elements.reserve(input.size());
+        for (value& sub : input.as_array())
+            elements.push_back(&sub);
+        map_elements_parallel(elements, results, threads, [&] (value* sub) { return func(std::move(*sub)); });
+        input = null;
+        
+        value out = array();
+        out.reserve(results.size());
+        for (value& result : results)
+            out.push_back(std::move(result));
+        return out;
+    }
+    case kind::object:
+    {
+        std::vector<value::object_value_type*> elements;
+        elements.reserve(input.size());
+        for (value::object_value_type& sub : input.as_object())
+            elements.push_back(&sub);
+        map_elements_parallel(elements,
+                              results,
+                              threads,
+                              [&] (value::object_value_type* sub) { return func(std::move(sub->second)); }
+                             );
+        
+        value out = object();
+        for (std::size_t idx = 0; idx < elements.size(); ++idx)
+            out.emplace_hint(out.end_object(), elements[idx]->first, std::move(results[idx]));
+        input = null;
+        return out;
+    }
+    default:
+        return map(func, std::move(input));
+    }
+}
+
 }
@@ -11,7 +11,9 @@
 #include <jsonv/algorithm.hpp>
 #include <jsonv/coerce.hpp>
 
+#include <iterator>
 #include <stdexcept>
+#include <string>
 
 #include "detail/fallthrough.hpp"
 
@@ -20,6 +22,11 @@ namespace jsonv
 
 merge_rules::~merge_rules() noexcept = default;
 
+void merge_rules::resolve_same_key_into(path&& current_path, value& a, value&& b) const
+{
+    a = resolve_same_key(std::move(current_path), std::move(a), std::move(b));
+}
+
 dynamic_merge_rules::dynamic_merge_rules(same_key_function same_key, type_conflict_function type_conflict) :
         same_key(std::move(same_key)),
         type_conflict(std::move(type_conflict))
@@ -53,77 +60,96 @@ value recursive_merge_rules::resolve_same_key(path&& current_path, value&& a, va
     return merge_explicit(*this, std::move(current_path), std::move(a), std::move(b));
 }
 
+void recursive_merge_rules::resolve_same_key_into(path&& current_path, value& a, value&& b) const
+{
+    merge_into(a, std::move(b), *this, std::move(current_path));
+}
+
 value recursive_merge_rules::resolve_type_conflict(path&&, value&& a, value&& b) const
 {
     return coerce_merge(std::move(a), std::move(b));
 }
 
-value merge_explicit(const merge_rules& rules,
-                     path               current_path,
-                     value              a,
-                     value              b
-                    )
+void merge_into(value& target, value&& source, const merge_rules& rules, path current_path)
 {
-    if (  a.kind() != b.kind()
-       && !(   (a.kind() == kind::integer && b.kind() == kind::decimal)
-            || (a.kind() == kind::decimal && b.kind() == kind::integer)
+    if (  target.kind() != source.kind()
+       && !(   (target.kind() == kind::integer && source.kind() == kind::decimal)
+            || (target.kind() == kind::decimal && source.kind() == kind::integer)
            )
        )
-        return rules.resolve_type_conflict(std::move(current_path), std::move(a), std::move(b));
+    {
+        target = rules.resolve_type_conflict(std::move(current_path), std::move(target), std::move(source));
+        return;
+    }
 
-    switch (a.kind())
+    switch (target.kind())
     {
         case kind::object:
-        {
-            value out = object();
-            for (value::object_iterator iter = a.begin_object(); iter != a.end_object(); iter = a.erase(iter))
+            for (value::object_iterator iter = source.begin_object(); iter != source.end_object(); ++iter)
             {
-                auto iter_b = b.find(iter->first);
-                if (iter_b == b.end_object())
+                auto iter_target = target.find(iter->first);
+                if (iter_target == target.end_object())
                 {
-                    out.insert({ iter->first, std::move(iter->second) });
+                    // moving the value moves the whole subtree without copying anything under it
+                    target.emplace(iter->first, std::move(iter->second));
                 }
                 else
                 {
-                    out.insert({ iter->first,
-                                 rules.resolve_same_key(current_path + iter->first,
-                                                        std::move(iter->second),
-                                                        std::move(iter_b->second)
-                                                       )
-                               }
-                              );
-                    b.erase(iter_b);
+                    current_path.push_back(path_element(iter->first));
+                    rules.resolve_same_key_into(path(current_path), iter_target->second, std::move(iter->second));
+                    current_path.pop_back();
                 }
             }
-
-            for (value::object_iterator iter = b.begin_object(); iter != b.end_object(); ++iter)
-            {
-                out.insert({ iter->first, std::move(iter->second) });
-            }
-
-            return out;
-        }
+            return;
         case kind::array:
-            a.insert(a.end_array(), std::make_move_iterator(b.begin_array()), std::make_move_iterator(b.end_array()));
-            return a;
+            target.insert(target.end_array(),
+                          std::make_move_iterator(source.begin_array()),
+                          std::make_move_iterator(source.end_array())
+                         );
+            return;
         case kind::boolean:
-            return a.as_boolean() || b.as_boolean();
+            target = target.as_boolean() || source.as_boolean();
+            return;
         case kind::integer:
-            if (b.kind() == kind::integer)
-                return a.as_integer() + b.as_integer();
-            // fall through to decimal handler if b is a decimal
+            if (source.kind() == kind::integer)
+            {
+                target = target.as_integer() + source.as_integer();
+                return;
+            }
+            // fall through to decimal handler if source is a decimal
             JSONV_FALLTHROUGH();
         case kind::decimal:
-            return a.as_decimal() + b.as_decimal();
+            target = target.as_decimal() + source.as_decimal();
+            return;
         case kind::null:
-            return a;
+            return;
         case kind::string:
-            return a.as_string() + b.as_string();
+        {
+            std::string out = target.take_string();
+            out.append(source.as_string());
+            target = std::move(out);
+            return;
+        }
         default:
-            throw kind_error(std::string("Invalid kind ") + to_string(a.kind()));
+            throw kind_error(std::string("Invalid kind ") + to_string(target.kind()));
     }
 }
 
+void merge_into(value& target, value&& source)
+{
+    merge_into(target, std::move(source), throwing_merge_rules());
+}
+
+value merge_explicit(const merge_rules& rules,
+                     path               current_path,
+                     value              a,
+                     value              b
+                    )
+{
+    merge_into(a, std::move(b), rules, std::move(current_path));
+    return a;
+}
+
 value merge_explicit(const merge_rules&, const path&, value a)
 {
     return a;
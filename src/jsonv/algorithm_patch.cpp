@@ -0,0 +1,353 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/algorithm.hpp>
+#include <jsonv/value.hpp>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jsonv
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// patch_error                                                                                                        //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+patch_error::patch_error(std::size_t operation_index, const std::string& message) :
+        runtime_error(std::string("Could not apply patch operation ") + std::to_string(operation_index) + ": "
+                      + message
+                     ),
+        _operation_index(operation_index)
+{ }
+
+patch_error::~patch_error() noexcept = default;
+
+std::size_t patch_error::operation_index() const
+{
+    return _operation_index;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// apply_patch                                                                                                        //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/** Thrown while applying a single operation. \c apply_patch turns it into a \c patch_error for that operation. **/
+struct operation_failure
+{
+    std::string message;
+};
+
+/** Split the RFC 6901 JSON Pointer \a pointer into its reference tokens, undoing the \c "~0" and \c "~1" escapes. **/
+static std::vector<std::string> split_pointer(const std::string& pointer)
+{
+    std::vector<std::string> out;
+    if (pointer.empty())
+        return out;
+    if (pointer[0] != '/')
+        throw operation_failure{ "JSON Pointer \"" + pointer + "\" does not start with '/'" };
+    
+    for (std::size_t pos = 1; ; )
+    {
+        std::size_t end = std::min(pointer.find('/', pos), pointer.size());
+        std::string token;
+        token.reserve(end - pos);
+        for (std::size_t idx = pos; idx < end; ++idx)
+        {
+            if (pointer[idx] != '~')
+                token += pointer[idx];
+            else if (idx + 1 < end && (pointer[idx + 1] == '0' || pointer[idx + 1] == '1'))
+                token += pointer[++idx] == '0' ? '~' : '/';
+            else
+                throw operation_failure{ "Invalid escape in JSON Pointer \"" + pointer + "\"" };
+        }
+        out.emplace_back(std::move(token));
+        
+        if (end == pointer.size())
+            return out;
+        pos = end + 1;
+    }
+}
+
+/** Get the array index \a token refers to. The index \a size (which the token \c "-" also means) is only allowed if
+ *  \a allow_end is set.
+**/
+static value::size_type array_index(const std::string& token, value::size_type size, bool allow_end)
+{
+    if (token == "-")
+    {
+        if (!allow_end)
+            throw operation_failure{ "Index \"-\" does not refer to an element" };
+        return size;
+    }
+    
+    if (  token.empty()
+       || (token.size() > 1 && token[0] == '0')
+       || !std::all_of(token.begin(), token.end(), [] (char c) { return '0' <= c && c <= '9'; })
+       )
+        throw operation_failure{ "Invalid array index \"" + token + "\"" };
+    
+    value::size_type idx = 0;
+    for (char c : token)
+    {
+        // checking as we go keeps idx from overflowing
+        idx = idx * 10U + value::size_type(c - '0');
+        if (idx > size)
+            break;
+    }
+    if (idx > size || (idx == size && !allow_end))
+        throw operation_failure{ "Array index " + token + " is out of range" };
+    return idx;
+}
+
+/** Finds the values a patch refers to. The values along the path to the parent of the last location are kept, so a
+ *  location which shares part of its path with the previous one only walks the rest of the way.
+ *
+ *  An operation only changes the children of the parent it resolved, so the values on the kept path stay valid. The
+ *  \c "move" operation changes two parents, but since the second is resolved after the first is changed, only the part
+ *  of the path they share is kept.
+**/
+class patch_cursor
+{
+public:
+    explicit patch_cursor(value& root) :
+            _nodes({ &root })
+    { }
+    
+    /** Get the parent of the location \a tokens refers to (which must not be the root). **/
+    value& parent(const std::vector<std::string>& tokens)
+    {
+        std::size_t depth = tokens.size() - 1;
+        std::size_t shared = 0;
+        while (shared < std::min(depth, _tokens.size()) && _tokens[shared] == tokens[shared])
+            ++shared;
+        _tokens.resize(shared);
+        _nodes.resize(shared + 1);
+        
+        for (std::size_t idx = shared; idx < depth; ++idx)
+        {
+            value& next = child(*_nodes.back(), tokens[idx]);
+            _tokens.push_back(tokens[idx]);
+            _nodes.push_back(&next);
+        }
+        return *_nodes.back();
+    }
+    
+    /** Get the existing value \a tokens refers to. **/
+    value& get(const std::vector<std::string>& tokens)
+    {
+        return tokens.empty() ? *_nodes.front() : child(parent(tokens), tokens.back());
+    }
+    
+    /** Forget the remembered path, since the root is about to be replaced. **/
+    void reset()
+    {
+        _tokens.clear();
+        _nodes.resize(1);
+    }
+    
+    static value& child(value& from, const std::string& token)
+    {
+        if (from.kind() == kind::object)
+        {
+            auto iter = from.find(token);
+            if (iter == from.end_object())
+                throw operation_failure{ "No member with key \"" + token + "\"" };
+            return iter->second;
+        }
+        else if (from.kind() == kind::array)
+        {
+            return from[array_index(token, from.size(), false)];
+        }
+        else
+        {
+            throw operation_failure{ "Can not look up \"" + token + "\" in a " + to_string(from.kind()) };
+        }
+    }
+    
+private:
+    std::vector<std::string> _tokens;
+    std::vector<value*>      _nodes;
+};
+
+}
+
+static const value& operation_member(const value& operation, const char* key)
+{
+    auto iter = operation.find(key);
+    if (iter == operation.end_object())
+        throw operation_failure{ std::string("Missing member \"") + key + "\"" };
+    return iter->second;
+}
+
+static const std::string& operation_pointer(const value& operation, const char* key)
+{
+    const value& pointer = operation_member(operation, key);
+    if (pointer.kind() != kind::string)
+        throw operation_failure{ std::string("Member \"") + key + "\" is not a string" };
+    return pointer.as_string();
+}
+
+static void patch_add(value& root, patch_cursor& cursor, const std::vector<std::string>& tokens, value&& x)
+{
+    if (tokens.empty())
+    {
+        cursor.reset();
+        root = std::move(x);
+        return;
+    }
+    
+    value& parent = cursor.parent(tokens);
+    if (parent.kind() == kind::object)
+        parent[tokens.back()] = std::move(x);
+    else if (parent.kind() == kind::array)
+        parent.insert(parent.begin_array() + array_index(tokens.back(), parent.size(), true), std::move(x));
+    else
+        throw operation_failure{ "Can not add \"" + tokens.back() + "\" to a " + to_string(parent.kind()) };
+}
+
+static value patch_remove(patch_cursor& cursor, const std::vector<std::string>& tokens)
+{
+    if (tokens.empty())
+        throw operation_failure{ "Can not remove the root" };
+    
+    value& parent = cursor.parent(tokens);
+    value  out;
+    if (parent.kind() == kind::object)
+    {
+        auto iter = parent.find(tokens.back());
+        if (iter == parent.end_object())
+            throw operation_failure{ "No member with key \"" + tokens.back() + "\"" };
+        out = std::move(iter->second);
+        parent.erase(iter);
+    }
+    else if (parent.kind() == kind::array)
+    {
+        auto iter = parent.begin_array() + array_index(tokens.back(), parent.size(), false);
+        out = std::move(*iter);
+        parent.erase(iter);
+    }
+    else
+    {
+        throw operation_failure{ "Can not remove \"" + tokens.back() + "\" from a " + to_string(parent.kind()) };
+    }
+    return out;
+}
+
+static void apply_operation(value& root, patch_cursor& cursor, const value& operation)
+{
+    if (operation.kind() != kind::object)
+        throw operation_failure{ "Operation is a " + to_string(operation.kind()) + " instead of an object" };
+    
+    const value& op_value = operation_member(operation, "op");
+    if (op_value.kind() != kind::string)
+        throw operation_failure{ "Member \"op\" is not a string" };
+    const std::string&       op     = op_value.as_string();
+    std::vector<std::string> tokens = split_pointer(operation_pointer(operation, "path"));
+    
+    if (op == "add")
+    {
+        patch_add(root, cursor, tokens, value(operation_member(operation, "value")));
+    }
+    else if (op == "remove")
+    {
+        patch_remove(cursor, tokens);
+    }
+    else if (op == "replace")
+    {
+        const value& x = operation_member(operation, "value");
+        if (tokens.empty())
+        {
+            cursor.reset();
+            root = x;
+        }
+        else
+        {
+            cursor.get(tokens) = x;
+        }
+    }
+    else if (op == "move")
+    {
+        std::vector<std::string> from = split_pointer(operation_pointer(operation, "from"));
+        if (from == tokens)
+            return;
+        if (from.size() < tokens.size() && std::equal(from.begin(), from.end(), tokens.begin()))
+            throw operation_failure{ "Can not move a value into itself" };
+        patch_add(root, cursor, tokens, patch_remove(cursor, from));
+    }
+    else if (op == "copy")
+    {
+        std::vector<std::string> from = split_pointer(operation_pointer(operation, "from"));
+        patch_add(root, cursor, tokens, value(cursor.get(from)));
+    }
+    else if (op == "test")
+    {
+        if (cursor.get(tokens) != operation_member(operation, "value"))
+            throw operation_failure{ "Test of \"" + operation_pointer(operation, "path") + "\" failed" };
+    }
+    else
+    {
+        throw operation_failure{ "Unknown operation \"" + op + "\"" };
+    }
+}
+
+void apply_patch(value& target, const value& patch)
+{
+    if (patch.kind() != kind::array)
+        throw patch_error(0, "Patch is a " + to_string(patch.kind()) + " instead of an array");
+    
+    patch_cursor cursor(target);
+    for (value::size_type idx = 0; idx < patch.size(); ++idx)
+    {
+        try
+        {
+            apply_operation(target, cursor, patch[idx]);
+        }
+        catch (const operation_failure& failure)
+        {
+            throw patch_error(idx, failure.message);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// apply_merge_patch                                                                                                  //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void apply_merge_patch(value& target, const value& patch)
+{
+    if (patch.kind() != kind::object)
+    {
+        target = patch;
+        return;
+    }
+    
+    if (target.kind() != kind::object)
+        target = object();
+    
+    for (const auto& field : patch.as_object())
+    {
+        if (field.second.kind() == kind::null)
+        {
+            target.erase(field.first);
+        }
+        else
+        {
+            apply_merge_patch(target[field.first], field.second);
+        }
+    }
+}
+
+}
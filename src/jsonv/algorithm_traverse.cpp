@@ -12,6 +12,13 @@
 #include <jsonv/path.hpp>
 #include <jsonv/value.hpp>
 
+#include "detail/parallel.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include <vector>
+
 namespace jsonv
 {
 
@@ -21,37 +28,213 @@ void traverse(const value&                                           tree,
               bool                                                   leafs_only
              )
 {
-    if (!leafs_only || tree.empty() || (tree.kind() != kind::array && tree.kind() != kind::object))
-        func(base_path, tree);
+    std::vector<path_element_view> elements(base_path.begin(), base_path.end());
+    elements.reserve(elements.size() + 16);
+    detail::traverse_view(tree, func, elements, leafs_only);
+}
+
+void traverse(const value&                                           tree,
+              const std::function<void (const path&, const value&)>& func,
+              bool                                                   leafs_only
+             )
+{
+    traverse(tree, func, path(), leafs_only);
+}
+
+/** Each thread gets about this many parts of the tree to work on, so a thread with small subtrees can take on
+ *  more.
+**/
+static constexpr std::size_t parallel_parts_per_thread = 8;
+
+namespace
+{
+
+/** The children <tt>[first, first + count)</tt> of the array or object \c node, which are traversed by one thread. **/
+struct traverse_part
+{
+    const value*                 node;
+    const path*                  node_path;
+    std::size_t                  first;       //!< For arrays: the index of the first child
+    value::const_object_iterator first_entry; //!< For objects: the first child
+    std::size_t                  count;
+};
+
+}
+
+void traverse_parallel(const value&                                           tree,
+                       const std::function<void (const path&, const value&)>& func,
+                       const path&                                            base_path,
+                       bool                                                   leafs_only,
+                       std::size_t                                            threads
+                      )
+{
+    auto is_container = [] (const value& x) { return x.kind() == kind::array || x.kind() == kind::object; };
+    
+    threads = detail::resolve_threads(threads);
+    std::size_t target_parts = threads * parallel_parts_per_thread;
+    
+    // Visit the top of the tree on this thread, one level at a time, until there are enough children to split up
+    std::vector<std::pair<path, const value*>> level;
+    level.emplace_back(base_path, &tree);
+    std::size_t child_count;
+    for (;;)
+    {
+        child_count = 0;
+        for (const auto& node : level)
+        {
+            if (!leafs_only || node.second->empty() || !is_container(*node.second))
+                func(node.first, *node.second);
+            if (is_container(*node.second))
+                child_count += node.second->size();
+        }
+        
+        if (child_count == 0 || child_count >= target_parts || threads == 1)
+            break;
+        
+        std::vector<std::pair<path, const value*>> next;
+        next.reserve(child_count);
+        for (const auto& node : level)
+        {
+            if (node.second->kind() == kind::object)
+            {
+                for (const auto& field : node.second->as_object())
+                    next.emplace_back(node.first + field.first, &field.second);
+            }
+            else if (node.second->kind() == kind::array)
+            {
+                for (value::size_type idx = 0; idx < node.second->size(); ++idx)
+                    next.emplace_back(node.first + idx, &(*node.second)[idx]);
+            }
+        }
+        level = std::move(next);
+    }
     
-    if (tree.kind() == kind::object)
+    // Split the children of the containers in the last level into parts of about the same number of children
+    std::size_t part_size = std::max(std::size_t(1), child_count / target_parts);
+    std::vector<traverse_part> parts;
+    for (const auto& node : level)
     {
-        for (const auto& field : tree.as_object())
+        if (node.second->kind() == kind::object)
+        {
+            auto iter = node.second->begin_object();
+            for (std::size_t first = 0; first < node.second->size(); first += part_size)
+            {
+                std::size_t count = std::min(part_size, node.second->size() - first);
+                parts.push_back({ node.second, &node.first, first, iter, count });
+                std::advance(iter, count);
+            }
+        }
+        else if (node.second->kind() == kind::array)
         {
-            traverse(field.second,
-                     func,
-                     base_path + field.first,
-                     leafs_only
-                    );
+            for (std::size_t first = 0; first < node.second->size(); first += part_size)
+            {
+                std::size_t count = std::min(part_size, node.second->size() - first);
+                parts.push_back({ node.second, &node.first, first, value::const_object_iterator(), count });
+            }
         }
     }
-    else if (tree.kind() == kind::array)
+    
+    detail::run_parallel(parts.size(),
+                         threads,
+                         [&] (std::size_t idx)
+                         {
+                             const traverse_part& part = parts[idx];
+                             if (part.node->kind() == kind::object)
+                             {
+                                 auto iter = part.first_entry;
+                                 for (std::size_t count = 0; count < part.count; ++count, ++iter)
+                                     traverse(iter->second, func, *part.node_path + iter->first, leafs_only);
+                             }
+                             else
+                             {
+                                 for (std::size_t child = part.first; child < part.first + part.count; ++child)
+                                     traverse((*part.node)[child], func, *part.node_path + child, leafs_only);
+                             }
+                         }
+                        );
+}
+
+void traverse_parallel(const value&                                           tree,
+                       const std::function<void (const path&, const value&)>& func,
+                       bool                                                   leafs_only,
+                       std::size_t                                            threads
+                      )
+{
+    traverse_parallel(tree, func, path(), leafs_only, threads);
+}
+
+static bool path_element_less(const path_element& a, const path_element& b)
+{
+    if (a.kind() != b.kind())
+        return a.kind() < b.kind();
+    else if (a.kind() == path_element_kind::array_index)
+        return a.index() < b.index();
+    else
+        return a.key() < b.key();
+}
+
+static const value* select_child(const value& from, const path_element& elem)
+{
+    if (elem.kind() == path_element_kind::array_index)
+    {
+        if (from.kind() != kind::array || elem.index() >= from.size())
+            return nullptr;
+        return &from[elem.index()];
+    }
+    else
     {
-        for (value::size_type idx = 0; idx < tree.size(); ++idx)
-            traverse(tree[idx],
-                     func,
-                     base_path + idx,
-                     leafs_only
-                    );
+        if (from.kind() != kind::object)
+            return nullptr;
+        auto iter = from.find(elem.key());
+        return iter == from.end_object() ? nullptr : &iter->second;
     }
 }
 
-void traverse(const value&                                           tree,
-              const std::function<void (const path&, const value&)>& func,
-              bool                                                   leafs_only
-             )
+/** Fill in \a out for the paths in <tt>[first, last)</tt> of the sorted order, which all start with the \a depth
+ *  elements which lead to \a node. The paths are sorted, so the ones which continue with the same element are next to
+ *  each other.
+**/
+static void select_sorted(const value&                             node,
+                          const std::vector<path>&                 paths,
+                          std::vector<std::size_t>::const_iterator first,
+                          std::vector<std::size_t>::const_iterator last,
+                          std::size_t                              depth,
+                          std::vector<const value*>&               out
+                         )
 {
-    traverse(tree, func, path(), leafs_only);
+    // shorter paths sort first, so the ones which end here are at the front
+    for (; first != last && paths[*first].size() == depth; ++first)
+        out[*first] = &node;
+    
+    while (first != last)
+    {
+        const path_element& elem = paths[*first][depth];
+        auto group_last = std::find_if(first, last,
+                                       [&] (std::size_t idx) { return paths[idx][depth] != elem; }
+                                      );
+        if (const value* child = select_child(node, elem))
+            select_sorted(*child, paths, first, group_last, depth + 1, out);
+        first = group_last;
+    }
+}
+
+std::vector<const value*> select(const value& tree, const std::vector<path>& paths)
+{
+    std::vector<std::size_t> order(paths.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::sort(order.begin(), order.end(),
+              [&] (std::size_t a, std::size_t b)
+              {
+                  return std::lexicographical_compare(paths[a].begin(), paths[a].end(),
+                                                      paths[b].begin(), paths[b].end(),
+                                                      path_element_less
+                                                     );
+              }
+             );
+    
+    std::vector<const value*> out(paths.size(), nullptr);
+    select_sorted(tree, paths, order.begin(), order.end(), 0, out);
+    return out;
 }
 
 }
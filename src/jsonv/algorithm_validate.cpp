@@ -27,6 +27,11 @@ std::ostream& operator<<(std::ostream& os, const validation_error::code& code)
     switch (code)
     {
     case validation_error::code::non_finite_number: return os << "non-finite number";
+    case validation_error::code::wrong_kind:        return os << "wrong kind";
+    case validation_error::code::out_of_range:      return os << "number out of range";
+    case validation_error::code::wrong_size:        return os << "size out of range";
+    case validation_error::code::missing_key:       return os << "missing key";
+    case validation_error::code::unexpected_key:    return os << "unexpected key";
     default:                                        return os << "validation_error::code(" << static_cast<int>(code) << ")";
     }
 }
@@ -58,12 +63,12 @@ const value& validation_error::value() const
 void validate(const value& val)
 {
     traverse(val,
-             [] (const path& p, const value& elem)
+             [] (const path_view& p, const value& elem)
              {
                  if (elem.kind() == kind::decimal)
                  {
                      if (!std::isfinite(elem.as_decimal()))
-                         throw validation_error(validation_error::code::non_finite_number, p, elem);
+                         throw validation_error(validation_error::code::non_finite_number, p.to_path(), elem);
                  }
              }
             );
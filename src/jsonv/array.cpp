@@ -14,6 +14,7 @@
 
 #include <algorithm>
 #include <ostream>
+#include <thread>
 
 namespace jsonv
 {
@@ -36,14 +37,125 @@ value array(std::initializer_list<value> source)
 namespace detail
 {
 
+constexpr std::size_t array_impl::min_packed_size;
+
+array_impl::array_impl(const array_impl& src) :
+        cloneable<array_impl>(src),
+        _encoded(src._encoded),
+        _canonical(src._canonical)
+{
+    if (const packed_numbers* numbers = src.packed())
+    {
+        _packed.reset(new packed_numbers(*numbers));
+        _state.store(state::packed, std::memory_order_relaxed);
+    }
+    else
+    {
+        _values = src._values;
+    }
+}
+
 value::size_type array_impl::size() const
 {
+    if (const packed_numbers* numbers = packed())
+        return numbers->kind == jsonv::kind::integer ? numbers->integers.size() : numbers->decimals.size();
     return _values.size();
 }
 
 bool array_impl::empty() const
 {
-    return _values.empty();
+    return size() == 0U;
+}
+
+/** Is \a item a number which kept the text it was parsed from? Packing it would lose the text. **/
+static bool has_number_text(const value& item)
+{
+    char text[detail::max_lazy_number_length];
+    return detail::lazy_number_text(item, text) != 0;
+}
+
+bool array_impl::pack()
+{
+    if (packed())
+        return true;
+    if (_values.size() < min_packed_size)
+        return false;
+    
+    jsonv::kind kind = _values.front().kind();
+    if (kind != jsonv::kind::integer && kind != jsonv::kind::decimal)
+        return false;
+    
+    std::unique_ptr<packed_numbers> numbers(new packed_numbers{ kind, {}, {} });
+    if (kind == jsonv::kind::integer)
+        numbers->integers.reserve(_values.size());
+    else
+        numbers->decimals.reserve(_values.size());
+    for (const value& element : _values)
+    {
+        if (element.kind() != kind || has_number_text(element))
+            return false;
+        else if (kind == jsonv::kind::integer)
+            numbers->integers.push_back(element.as_integer());
+        else
+            numbers->decimals.push_back(element.as_decimal());
+    }
+    
+    array_type().swap(_values);
+    _packed = std::move(numbers);
+    _state.store(state::packed, std::memory_order_relaxed);
+    return true;
+}
+
+bool array_impl::push_packed(const value& item)
+{
+    if (_state.load(std::memory_order_relaxed) != state::packed || item.kind() != _packed->kind)
+        return false;
+    if (has_number_text(item))
+        return false;
+    
+    if (item.kind() == jsonv::kind::integer)
+        _packed->integers.push_back(item.as_integer());
+    else
+        _packed->decimals.push_back(item.as_decimal());
+    return true;
+}
+
+void array_impl::unpack() const
+{
+    // Readers of shared storage can get here at the same time: one of them makes the values and the rest wait for it
+    state expected = state::packed;
+    if (!_state.compare_exchange_strong(expected, state::unpacking, std::memory_order_acquire))
+    {
+        while (expected == state::unpacking)
+        {
+            std::this_thread::yield();
+            expected = _state.load(std::memory_order_acquire);
+        }
+        return;
+    }
+    
+    try
+    {
+        if (_packed->kind == jsonv::kind::integer)
+        {
+            _values.reserve(_packed->integers.size());
+            for (std::int64_t x : _packed->integers)
+                _values.emplace_back(x);
+        }
+        else
+        {
+            _values.reserve(_packed->decimals.size());
+            for (double x : _packed->decimals)
+                _values.emplace_back(x);
+        }
+    }
+    catch (...)
+    {
+        array_type().swap(_values);
+        _state.store(state::packed, std::memory_order_release);
+        throw;
+    }
+    _state.store(state::both, std::memory_order_release);
 }
 
 }
@@ -63,13 +175,13 @@ value::const_array_iterator value::begin_array() const
 value::array_iterator value::end_array()
 {
     check_type(jsonv::kind::array, kind());
-    return array_iterator(this, _data.array->_values.size());
+    return array_iterator(this, _data.array->size());
 }
 
 value::const_array_iterator value::end_array() const
 {
     check_type(jsonv::kind::array, kind());
-    return const_array_iterator(this, _data.array->_values.size());
+    return const_array_iterator(this, _data.array->size());
 }
 
 value::array_view value::as_array() &
@@ -94,95 +206,151 @@ value::owning_array_view value::as_array() &&
 value& value::operator[](size_type idx)
 {
     check_type(jsonv::kind::array, kind());
-    return _data.array->_values[idx];
+    return detail::pin(_data.array)->values()[idx];
 }
 
 const value& value::operator[](size_type idx) const
 {
     check_type(jsonv::kind::array, kind());
-    return _data.array->_values[idx];
+    return detail::as_const(_data.array)->values()[idx];
 }
 
 value& value::at(size_type idx)
 {
     check_type(jsonv::kind::array, kind());
-    return _data.array->_values.at(idx);
+    return detail::pin(_data.array)->values().at(idx);
 }
 
 const value& value::at(size_type idx) const
 {
     check_type(jsonv::kind::array, kind());
-    return _data.array->_values.at(idx);
+    return detail::as_const(_data.array)->values().at(idx);
+}
+
+value* value::array_data()
+{
+    check_type(jsonv::kind::array, kind());
+    return detail::pin(_data.array)->values().data();
+}
+
+const value* value::array_data() const
+{
+    check_type(jsonv::kind::array, kind());
+    return detail::as_const(_data.array)->values().data();
+}
+
+bool value::pack_numbers()
+{
+    check_type(jsonv::kind::array, kind());
+    if (_data.array->packed())
+        return true;
+    detail::unshare(_data.array);
+    return _data.array->pack();
+}
+
+const std::int64_t* value::packed_integers() const
+{
+    if (kind() != jsonv::kind::array)
+        return nullptr;
+    const detail::array_impl::packed_numbers* numbers = detail::as_const(_data.array)->packed();
+    return numbers && numbers->kind == jsonv::kind::integer ? numbers->integers.data() : nullptr;
+}
+
+const double* value::packed_decimals() const
+{
+    if (kind() != jsonv::kind::array)
+        return nullptr;
+    const detail::array_impl::packed_numbers* numbers = detail::as_const(_data.array)->packed();
+    return numbers && numbers->kind == jsonv::kind::decimal ? numbers->decimals.data() : nullptr;
 }
 
 void value::push_back(value item)
 {
     check_type(jsonv::kind::array, kind());
-    _data.array->_values.emplace_back(std::move(item));
+    detail::unshare(_data.array);
+    if (!_data.array->push_packed(item))
+        _data.array->values().emplace_back(std::move(item));
+}
+
+value& value::emplace_back_value(value&& item)
+{
+    check_type(jsonv::kind::array, kind());
+    detail::pin(_data.array)->values().emplace_back(std::move(item));
+    return _data.array->values().back();
 }
 
 void value::pop_back()
 {
     check_type(jsonv::kind::array, kind());
-    if (_data.array->_values.empty())
+    detail::unshare(_data.array);
+    if (_data.array->values().empty())
         throw std::logic_error("Cannot pop from empty array");
-    _data.array->_values.pop_back();
+    _data.array->values().pop_back();
 }
 
 void value::push_front(value item)
 {
     check_type(jsonv::kind::array, kind());
-    _data.array->_values.emplace_front(std::move(item));
+    detail::unshare(_data.array);
+    _data.array->values().insert(_data.array->values().begin(), std::move(item));
 }
 
 void value::pop_front()
 {
     check_type(jsonv::kind::array, kind());
-    if (_data.array->_values.empty())
+    detail::unshare(_data.array);
+    if (_data.array->values().empty())
         throw std::logic_error("Cannot pop from empty array");
-    _data.array->_values.pop_front();
+    _data.array->values().erase(_data.array->values().begin());
 }
 
 value::array_iterator value::insert(const_array_iterator position, value item)
 {
     check_type(jsonv::kind::array, kind());
-    auto iter = _data.array->_values.begin() + std::distance(const_array_iterator(begin_array()), position);
-    iter = _data.array->_values.insert(iter, std::move(item));
-    return begin_array() + std::distance(_data.array->_values.begin(), iter);
+    detail::unshare(_data.array);
+    auto iter = _data.array->values().begin() + std::distance(const_array_iterator(begin_array()), position);
+    iter = _data.array->values().insert(iter, std::move(item));
+    return begin_array() + std::distance(_data.array->values().begin(), iter);
 }
 
 void value::assign(size_type count, const value& val)
 {
     check_type(jsonv::kind::array, kind());
-    _data.array->_values.assign(count, val);
+    detail::unshare(_data.array);
+    _data.array->values().assign(count, val);
 }
 
 void value::assign(std::initializer_list<value> items)
 {
     check_type(jsonv::kind::array, kind());
-    _data.array->_values.assign(std::move(items));
+    detail::unshare(_data.array);
+    _data.array->values().assign(std::move(items));
 }
 
 void value::resize(size_type count, const value& val)
 {
     check_type(jsonv::kind::array, kind());
-    _data.array->_values.resize(count, val);
+    detail::unshare(_data.array);
+    _data.array->values().resize(count, val);
 }
 
 value::array_iterator value::erase(const_array_iterator position)
 {
     check_type(jsonv::kind::array, kind());
+    detail::unshare(_data.array);
     difference_type dist(position - begin_array());
-    _data.array->_values.erase(_data.array->_values.begin() + dist);
+    _data.array->values().erase(_data.array->values().begin() + dist);
     return array_iterator(this, static_cast<size_type>(dist));
 }
 
 value::array_iterator value::erase(const_array_iterator first, const_array_iterator last)
 {
+    check_type(jsonv::kind::array, kind());
+    detail::unshare(_data.array);
     difference_type fdist(first - begin_array());
     difference_type ldist(last  - begin_array());
-    _data.array->_values.erase(_data.array->_values.begin() + fdist,
-                               _data.array->_values.begin() + ldist
+    _data.array->values().erase(_data.array->values().begin() + fdist,
+                               _data.array->values().begin() + ldist
                               );
     return array_iterator(this, static_cast<size_type>(fdist));
 }
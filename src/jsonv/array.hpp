@@ -15,7 +15,11 @@
 #include <jsonv/value.hpp>
 #include <jsonv/detail.hpp>
 
-#include <deque>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace jsonv
 {
@@ -26,17 +30,127 @@ class JSONV_LOCAL array_impl :
         public cloneable<array_impl>
 {
 public:
-    typedef std::deque<jsonv::value> array_type;
+    typedef std::vector<jsonv::value, node_allocator<jsonv::value>> array_type;
+    
+    /** The elements of an array which only holds integers or only holds decimals, without a \c value around each. **/
+    struct packed_numbers
+    {
+        jsonv::kind               kind;     //!< \c kind::integer or \c kind::decimal
+        std::vector<std::int64_t> integers;
+        std::vector<double>       decimals;
+    };
     
 public:
+    array_impl() = default;
+    
+    /** A copy of packed storage is packed as well. **/
+    array_impl(const array_impl& src);
+    
+    array_impl& operator=(const array_impl&) = delete;
+    
     value::size_type size() const;
     
     bool empty() const;
     
+    /** \see cloneable::forget_cached **/
+    void forget_cached() noexcept
+    {
+        cloneable<array_impl>::forget_cached();
+        _encoded.reset();
+        _canonical.reset();
+    }
+    
+    /** Get the packed elements or \c nullptr if the elements are not packed. They stay valid until this is changed. **/
+    const packed_numbers* packed() const
+    {
+        return _state.load(std::memory_order_acquire) == state::generic ? nullptr : _packed.get();
+    }
+    
+    /** Get the elements as \c value instances, making them out of the packed ones the first time this is called. The
+     *  packed elements are kept, since pointers to them (from \c value::packed_integers) might still be in use. This
+     *  is safe to call on storage which other threads are reading.
+    **/
+    const array_type& values() const
+    {
+        state current = _state.load(std::memory_order_acquire);
+        if (current == state::packed || current == state::unpacking)
+            unpack();
+        return _values;
+    }
+    
+    /** Get the elements as \c value instances if they have been made, without making them. **/
+    const array_type* made_values() const
+    {
+        state current = _state.load(std::memory_order_acquire);
+        return current == state::generic || current == state::both ? &_values : nullptr;
+    }
+    
+    /** Get the elements as \c value instances to change them, which drops the packed elements. The storage must not be
+     *  shared (see \c unshare).
+    **/
+    array_type& values()
+    {
+        if (_state.load(std::memory_order_relaxed) != state::generic)
+        {
+            values_const();
+            _packed.reset();
+            _state.store(state::generic, std::memory_order_relaxed);
+        }
+        return _values;
+    }
+    
+    /** Arrays with fewer elements than this take less memory as \c value instances than packed. **/
+    static constexpr std::size_t min_packed_size = 8;
+    
+    /** Store the elements packed if they are all integers or all decimals (and there are at least
+     *  \c min_packed_size of them). The storage must not be shared.
+     *  
+     *  \returns \c true if the elements are now packed.
+    **/
+    bool pack();
+    
+    /** Add \a item to the packed elements if the elements are packed (and only there) and it is a number of the same
+     *  kind. The storage must not be shared.
+     *  
+     *  \returns \c true if \a item was added.
+    **/
+    bool push_packed(const value& item);
+    
+private:
+    /** Where the elements are. **/
+    enum class state : unsigned char
+    {
+        generic,   //!< Only in \c _values
+        packed,    //!< Only in \c _packed
+        unpacking, //!< In \c _packed and being copied to \c _values by one thread
+        both,      //!< In \c _packed and \c _values
+    };
+    
+    const array_type& values_const() const
+    {
+        return values();
+    }
+    
+    void unpack() const;
+    
 public:
-    array_type _values;
+    /** The JSON text this was parsed from by \c raw_json (copies keep it). It is dropped when this changes. **/
+    std::shared_ptr<const std::string> _encoded;
+    /** The text \c canonical_encoder wrote for this, if it was asked to cache it. **/
+    cached_text                        _canonical;
+    
+private:
+    mutable array_type                 _values;
+    std::unique_ptr<packed_numbers>    _packed;
+    mutable std::atomic<state>         _state {state::generic};
 };
 
+/** Get \a impl as a pointer to const, so only the members which are safe to call on shared storage can be used. **/
+inline const array_impl* as_const(const array_impl* impl)
+{
+    return impl;
+}
+
 }
 }
 
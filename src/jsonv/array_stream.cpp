@@ -0,0 +1,161 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/array_stream.hpp>
+#include <jsonv/tokenizer.hpp>
+#include <jsonv/detail/token_stream.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace jsonv
+{
+
+/** The kind of value which starts with \a kind, for error messages. **/
+static std::string describe(token_kind kind)
+{
+    switch (kind)
+    {
+    case token_kind::array_begin:  return "an array";
+    case token_kind::object_begin: return "an object";
+    case token_kind::string:       return "a string";
+    case token_kind::number:       return "a number";
+    case token_kind::boolean:      return "a boolean";
+    case token_kind::null:         return "null";
+    default:                       return to_string(kind);
+    }
+}
+
+static std::string describe(const path& location)
+{
+    return location.empty() ? std::string("the root") : to_string(location);
+}
+
+array_range::array_range(std::istream& input, path at, const parse_options& options) :
+        _owned_tokens(new tokenizer(input)),
+        _tokens(_owned_tokens.get()),
+        _path(std::move(at)),
+        _options(options),
+        _parsed(0),
+        _started(false),
+        _finished(false)
+{
+    _options.complete_parse(false)
+            .require_document(false);
+}
+
+array_range::array_range(tokenizer& input, path at, const parse_options& options) :
+        _tokens(&input),
+        _path(std::move(at)),
+        _options(options),
+        _parsed(0),
+        _started(false),
+        _finished(false)
+{
+    _options.complete_parse(false)
+            .require_document(false);
+}
+
+array_range::array_range(array_range&&) noexcept = default;
+
+array_range& array_range::operator=(array_range&&) noexcept = default;
+
+array_range::~array_range() noexcept = default;
+
+array_range::iterator array_range::begin()
+{
+    if (!_started)
+    {
+        _started = true;
+        find_array();
+        next();
+    }
+    return _finished ? end() : iterator(this);
+}
+
+array_range::iterator array_range::end()
+{
+    return iterator();
+}
+
+void array_range::find_array()
+{
+    detail::next_token(*_tokens);
+
+    path walked;
+    for (const path_element& elem : _path)
+    {
+        token_kind kind = _tokens->current().kind;
+        bool       found = false;
+        if (elem.kind() == path_element_kind::object_key)
+        {
+            if (kind != token_kind::object_begin)
+                throw kind_error("Expected an object at " + describe(walked) + ", but found " + describe(kind));
+
+            std::string key;
+            for (bool first = true; !found && detail::next_object_entry(*_tokens, first, key); first = false)
+            {
+                if (key == elem.key())
+                    found = true;
+                else
+                    detail::skip_current(*_tokens);
+            }
+        }
+        else
+        {
+            if (kind != token_kind::array_begin)
+                throw kind_error("Expected an array at " + describe(walked) + ", but found " + describe(kind));
+
+            for (std::size_t idx = 0U; !found && detail::next_array_element(*_tokens, idx == 0U); ++idx)
+            {
+                if (idx == elem.index())
+                    found = true;
+                else
+                    detail::skip_current(*_tokens);
+            }
+        }
+
+        walked += elem;
+        if (!found)
+            throw std::out_of_range("Nothing at " + describe(walked));
+    }
+
+    if (_tokens->current().kind != token_kind::array_begin)
+        throw kind_error("Expected an array at " + describe(walked) + ", but found "
+                         + describe(_tokens->current().kind)
+                        );
+}
+
+bool array_range::next()
+{
+    // the first element comes after the '[' of the array and the rest after the last token of the previous element
+    if (!detail::next_array_element(*_tokens, _parsed == 0U))
+    {
+        _finished = true;
+        return false;
+    }
+
+    _current = detail::parse_current(*_tokens, _options);
+    ++_parsed;
+    return true;
+}
+
+array_range array_stream(std::istream& input, path at, const parse_options& options)
+{
+    return array_range(input, std::move(at), options);
+}
+
+array_range array_stream(tokenizer& input, path at, const parse_options& options)
+{
+    return array_range(input, std::move(at), options);
+}
+
+}
@@ -0,0 +1,617 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/cbor.hpp>
+#include <jsonv/value.hpp>
+
+#include "detail/output_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jsonv
+{
+
+// The major types of RFC 8949, which are the top three bits of the first byte of each item
+static constexpr unsigned cbor_major_unsigned = 0;
+static constexpr unsigned cbor_major_negative = 1;
+static constexpr unsigned cbor_major_bytes    = 2;
+static constexpr unsigned cbor_major_text     = 3;
+static constexpr unsigned cbor_major_array    = 4;
+static constexpr unsigned cbor_major_map      = 5;
+static constexpr unsigned cbor_major_tag      = 6;
+static constexpr unsigned cbor_major_simple   = 7;
+
+// The low five bits of the first byte
+static constexpr unsigned cbor_info_one_byte    = 24;
+static constexpr unsigned cbor_info_two_bytes   = 25;
+static constexpr unsigned cbor_info_four_bytes  = 26;
+static constexpr unsigned cbor_info_eight_bytes = 27;
+static constexpr unsigned cbor_info_indefinite  = 31;
+
+static constexpr unsigned cbor_simple_false     = 20;
+static constexpr unsigned cbor_simple_true      = 21;
+static constexpr unsigned cbor_simple_null      = 22;
+static constexpr unsigned cbor_simple_undefined = 23;
+
+static constexpr unsigned char cbor_break = 0xff;
+
+/** The most entries reserved up front for a definite-length array or map. Every nested header can claim the rest of the
+ *  input, so reserving its whole size would take memory quadratic in the input; larger containers grow as their
+ *  entries arrive.
+**/
+static constexpr std::uint64_t cbor_max_reserve = 16;
+
+static std::uint32_t float_bits(float x)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &x, sizeof bits);
+    return bits;
+}
+
+/** Get the IEEE 754 half-precision encoding of \a x if it is exactly representable as one.
+ *
+ *  \returns \c true if it was; \c false if \a half was not set.
+**/
+static bool to_half(float x, std::uint16_t& half)
+{
+    std::uint32_t bits     = float_bits(x);
+    std::uint16_t sign     = static_cast<std::uint16_t>((bits >> 16) & 0x8000U);
+    int           exponent = static_cast<int>((bits >> 23) & 0xffU);
+    std::uint32_t mantissa = bits & 0x7fffffU;
+
+    if (exponent == 0xff)
+    {
+        // Infinity or NaN (every NaN becomes the quiet NaN, which is what RFC 8949 suggests)
+        half = static_cast<std::uint16_t>(sign | 0x7c00U | (mantissa == 0 ? 0U : 0x0200U));
+        return true;
+    }
+    else if (exponent == 0)
+    {
+        // Zero (float subnormals are far too small for a half)
+        half = sign;
+        return mantissa == 0;
+    }
+
+    int unbiased = exponent - 127;
+    if (unbiased >= -14 && unbiased <= 15)
+    {
+        if (mantissa & 0x1fffU)
+            return false;
+        half = static_cast<std::uint16_t>(sign | ((unbiased + 15) << 10) | (mantissa >> 13));
+        return true;
+    }
+    else if (unbiased >= -24 && unbiased < -14)
+    {
+        // A half subnormal holds the significand (with the implicit bit) shifted down
+        std::uint32_t significand = mantissa | 0x800000U;
+        unsigned      shift       = static_cast<unsigned>(-1 - unbiased);
+        if (significand & ((1U << shift) - 1U))
+            return false;
+        half = static_cast<std::uint16_t>(sign | (significand >> shift));
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+static double from_half(std::uint16_t half)
+{
+    int    exponent = (half >> 10) & 0x1f;
+    int    mantissa = half & 0x3ff;
+    double magnitude;
+    if (exponent == 0)
+        magnitude = std::ldexp(mantissa, -24);
+    else if (exponent != 31)
+        magnitude = std::ldexp(mantissa + 1024, exponent - 25);
+    else
+        magnitude = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+    return (half & 0x8000) ? -magnitude : magnitude;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cbor_encoder                                                                                                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+cbor_encoder::cbor_encoder(std::string& output) :
+        cbor_encoder([&output] (string_view chunk) { output.append(chunk.data(), chunk.size()); })
+{ }
+
+cbor_encoder::cbor_encoder(flush_function flush, std::size_t chunk_size) :
+        _buffer(new detail::output_buffer(chunk_size, std::move(flush)))
+{ }
+
+cbor_encoder::~cbor_encoder() noexcept
+{
+    try
+    {
+        _buffer->flush();
+    }
+    catch (...)
+    {
+        // nothing can be done about it here -- callers who care should call flush themselves
+    }
+}
+
+void cbor_encoder::flush()
+{
+    _buffer->flush();
+}
+
+std::size_t cbor_encoder::size() const
+{
+    return _buffer->size();
+}
+
+void cbor_encoder::write_head(unsigned major, std::uint64_t argument)
+{
+    char*       out   = _buffer->reserve(9);
+    std::size_t bytes;
+    unsigned    info;
+    if (argument < cbor_info_one_byte)
+    {
+        bytes = 0;
+        info  = static_cast<unsigned>(argument);
+    }
+    else if (argument <= 0xffU)
+    {
+        bytes = 1;
+        info  = cbor_info_one_byte;
+    }
+    else if (argument <= 0xffffU)
+    {
+        bytes = 2;
+        info  = cbor_info_two_bytes;
+    }
+    else if (argument <= 0xffffffffU)
+    {
+        bytes = 4;
+        info  = cbor_info_four_bytes;
+    }
+    else
+    {
+        bytes = 8;
+        info  = cbor_info_eight_bytes;
+    }
+
+    out[0] = static_cast<char>((major << 5) | info);
+    for (std::size_t idx = 0; idx < bytes; ++idx)
+        out[bytes - idx] = static_cast<char>((argument >> (8 * idx)) & 0xffU);
+    _buffer->commit(bytes + 1);
+}
+
+void cbor_encoder::write_end()
+{
+    bool indefinite = _open_indefinite.back();
+    _open_indefinite.pop_back();
+    if (indefinite)
+        _buffer->put(static_cast<char>(cbor_break));
+}
+
+void cbor_encoder::write_array_begin()
+{
+    _buffer->put(static_cast<char>((cbor_major_array << 5) | cbor_info_indefinite));
+    _open_indefinite.push_back(true);
+}
+
+void cbor_encoder::write_array_begin_sized(std::size_t count)
+{
+    write_head(cbor_major_array, count);
+    _open_indefinite.push_back(false);
+}
+
+void cbor_encoder::write_array_end()
+{
+    write_end();
+}
+
+void cbor_encoder::write_array_delimiter()
+{ }
+
+void cbor_encoder::write_boolean(bool value)
+{
+    _buffer->put(static_cast<char>((cbor_major_simple << 5) | (value ? cbor_simple_true : cbor_simple_false)));
+}
+
+void cbor_encoder::write_float(unsigned info, std::uint64_t bits, std::size_t bytes)
+{
+    // Unlike write_head, the width is fixed: it is part of what the bits mean
+    char* out = _buffer->reserve(9);
+    out[0] = static_cast<char>((cbor_major_simple << 5) | info);
+    for (std::size_t idx = 0; idx < bytes; ++idx)
+        out[bytes - idx] = static_cast<char>((bits >> (8 * idx)) & 0xffU);
+    _buffer->commit(bytes + 1);
+}
+
+void cbor_encoder::write_decimal(double value)
+{
+    float narrow = static_cast<float>(value);
+    if (std::isnan(value) || static_cast<double>(narrow) == value)
+    {
+        std::uint16_t half;
+        if (to_half(narrow, half))
+            write_float(cbor_info_two_bytes, half, 2);
+        else
+            write_float(cbor_info_four_bytes, float_bits(narrow), 4);
+    }
+    else
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        write_float(cbor_info_eight_bytes, bits, 8);
+    }
+}
+
+void cbor_encoder::write_integer(std::int64_t value)
+{
+    if (value >= 0)
+        write_head(cbor_major_unsigned, static_cast<std::uint64_t>(value));
+    else
+        write_head(cbor_major_negative, ~static_cast<std::uint64_t>(value));
+}
+
+void cbor_encoder::write_null()
+{
+    _buffer->put(static_cast<char>((cbor_major_simple << 5) | cbor_simple_null));
+}
+
+void cbor_encoder::write_object_begin()
+{
+    _buffer->put(static_cast<char>((cbor_major_map << 5) | cbor_info_indefinite));
+    _open_indefinite.push_back(true);
+}
+
+void cbor_encoder::write_object_begin_sized(std::size_t count)
+{
+    write_head(cbor_major_map, count);
+    _open_indefinite.push_back(false);
+}
+
+void cbor_encoder::write_object_end()
+{
+    write_end();
+}
+
+void cbor_encoder::write_object_delimiter()
+{ }
+
+void cbor_encoder::write_object_key(string_view key)
+{
+    write_string(key);
+}
+
+void cbor_encoder::write_string(string_view value)
+{
+    write_head(cbor_major_text, value.size());
+    _buffer->write(value.data(), value.size());
+}
+
+std::string encode_cbor(const value& source)
+{
+    std::string out;
+    cbor_encoder encoder(out);
+    encoder.encode(source);
+    encoder.flush();
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// parse_cbor                                                                                                         //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/** Reads a CBOR document into a \c value. Like the text parser, nesting is kept on an explicit stack, so the depth of
+ *  a document is only limited by memory (and \c parse_options::max_structure_depth).
+**/
+class cbor_reader
+{
+public:
+    cbor_reader(string_view input, const parse_options& options) :
+            _begin(input.data()),
+            _current(input.data()),
+            _end(input.data() + input.size()),
+            _options(options)
+    { }
+
+    value read_document()
+    {
+        std::vector<frame> stack;
+        value              result;
+        const char*        tag = nullptr;
+        while (true)
+        {
+            const char*   head    = _current;
+            unsigned char initial = read_byte();
+            unsigned      major   = initial >> 5;
+            unsigned      info    = initial & 0x1fU;
+
+            if (initial == cbor_break)
+            {
+                if (tag)
+                    fail(tag, "Tag without an item");
+                if (stack.empty() || !stack.back().indefinite)
+                    fail(head, "Unexpected break");
+                if (stack.back().have_key)
+                    fail(head, "Object key without a value");
+
+                value done = std::move(stack.back().container);
+                stack.pop_back();
+                if (deliver(stack, std::move(done), result))
+                    break;
+                continue;
+            }
+
+            bool want_key = !stack.empty() && stack.back().container.kind() == kind::object && !stack.back().have_key;
+            if (want_key && major != cbor_major_text && major != cbor_major_tag)
+                fail(head, "Object keys must be text strings");
+
+            value item;
+            switch (major)
+            {
+            case cbor_major_unsigned:
+            {
+                std::uint64_t x = read_argument(info, head);
+                if (x <= std::uint64_t(std::numeric_limits<std::int64_t>::max()))
+                    item = static_cast<std::int64_t>(x);
+                else
+                    item = static_cast<double>(x);
+                break;
+            }
+            case cbor_major_negative:
+            {
+                // the value is -1 - x
+                std::uint64_t x = read_argument(info, head);
+                if (x <= std::uint64_t(std::numeric_limits<std::int64_t>::max()))
+                    item = -1 - static_cast<std::int64_t>(x);
+                else
+                    item = -1.0 - static_cast<double>(x);
+                break;
+            }
+            case cbor_major_bytes:
+                fail(head, "Byte strings are not supported");
+            case cbor_major_text:
+            {
+                std::string text = read_text(info, head);
+                if (want_key)
+                {
+                    stack.back().key      = std::move(text);
+                    stack.back().have_key = true;
+                    tag = nullptr;
+                    continue;
+                }
+                item = std::move(text);
+                break;
+            }
+            case cbor_major_array:
+            case cbor_major_map:
+            {
+                bool          indefinite = info == cbor_info_indefinite;
+                std::uint64_t count      = indefinite ? 0 : read_argument(info, head);
+                // Every element takes at least a byte, so a size larger than the rest of the input is corrupt
+                std::uint64_t per_entry  = major == cbor_major_map ? 2 : 1;
+                if (count > std::uint64_t(_end - _current) / per_entry)
+                    fail(head, "Size of ", count, " is larger than the rest of the input");
+                if (_options.max_structure_depth() > 0 && stack.size() + 1 >= _options.max_structure_depth())
+                    fail(head, "Structure depth reached maximum of ", stack.size() + 1);
+
+                value container = major == cbor_major_array ? array() : object();
+                if (!indefinite && count == 0)
+                {
+                    item = std::move(container);
+                    break;
+                }
+                container.reserve(static_cast<value::size_type>(std::min(count, cbor_max_reserve)));
+                stack.push_back(frame{ std::move(container), count, indefinite, false, std::string() });
+                tag = nullptr;
+                continue;
+            }
+            case cbor_major_tag:
+                // A tag says how to interpret the item after it, which has no meaning in JSON
+                read_argument(info, head);
+                tag = head;
+                continue;
+            case cbor_major_simple:
+            default:
+                item = read_simple(info, head);
+                break;
+            }
+
+            tag = nullptr;
+            if (deliver(stack, std::move(item), result))
+                break;
+        }
+
+        if (_options.complete_parse() && _current != _end)
+            fail(_current, "Found extra data after the value");
+        return result;
+    }
+
+private:
+    struct frame
+    {
+        value         container;
+        std::uint64_t remaining;  //!< Elements (or key-value pairs) left in a definite-length container
+        bool          indefinite;
+        bool          have_key;   //!< For objects: has the key of the next entry been read?
+        std::string   key;
+    };
+
+    /** Add \a item to the container on the top of the \a stack, finishing any containers which are now full.
+     *
+     *  \returns \c true if the top-level item is done (and it is in \a result).
+    **/
+    static bool deliver(std::vector<frame>& stack, value item, value& result)
+    {
+        while (!stack.empty())
+        {
+            frame& top = stack.back();
+            if (top.container.kind() == kind::array)
+            {
+                top.container.push_back(std::move(item));
+            }
+            else
+            {
+                top.container.insert({ std::move(top.key), std::move(item) });
+                top.have_key = false;
+            }
+
+            if (top.indefinite || --top.remaining != 0)
+                return false;
+
+            item = std::move(top.container);
+            stack.pop_back();
+        }
+        result = std::move(item);
+        return true;
+    }
+
+    template <typename... T>
+    [[noreturn]] void fail(const char* where, T&&... message) const
+    {
+        std::ostringstream stream;
+        (void) std::initializer_list<int> { ((stream << std::forward<T>(message)), 0)... };
+        std::size_t offset = std::size_t(where - _begin);
+        throw parse_error({ parse_error::problem(1, offset + 1, offset, stream.str()) }, null);
+    }
+
+    unsigned char read_byte()
+    {
+        if (_current == _end)
+            fail(_current, "Unexpected end of input");
+        return static_cast<unsigned char>(*_current++);
+    }
+
+    std::uint64_t read_uint(std::size_t bytes)
+    {
+        if (std::size_t(_end - _current) < bytes)
+            fail(_end, "Unexpected end of input");
+
+        std::uint64_t out = 0;
+        for (std::size_t idx = 0; idx < bytes; ++idx)
+            out = (out << 8) | static_cast<unsigned char>(_current[idx]);
+        _current += bytes;
+        return out;
+    }
+
+    std::uint64_t read_argument(unsigned info, const char* head)
+    {
+        switch (info)
+        {
+        case cbor_info_one_byte:
+            return read_uint(1);
+        case cbor_info_two_bytes:
+            return read_uint(2);
+        case cbor_info_four_bytes:
+            return read_uint(4);
+        case cbor_info_eight_bytes:
+            return read_uint(8);
+        case cbor_info_indefinite:
+            fail(head, "Indefinite length is not allowed here");
+        default:
+            if (info < cbor_info_one_byte)
+                return info;
+            fail(head, "Reserved additional information ", info);
+        }
+    }
+
+    std::string read_text(unsigned info, const char* head)
+    {
+        std::string out;
+        if (info != cbor_info_indefinite)
+        {
+            append_text(out, read_argument(info, head));
+            return out;
+        }
+
+        // An indefinite-length string is a series of definite-length chunks ending with a break
+        while (true)
+        {
+            const char*   chunk   = _current;
+            unsigned char initial = read_byte();
+            if (initial == cbor_break)
+                return out;
+            if ((initial >> 5) != cbor_major_text || (initial & 0x1fU) == cbor_info_indefinite)
+                fail(chunk, "Chunks of a text string must be definite-length text strings");
+            append_text(out, read_argument(initial & 0x1fU, chunk));
+        }
+    }
+
+    void append_text(std::string& out, std::uint64_t length)
+    {
+        if (length > std::uint64_t(_end - _current))
+            fail(_current, "String of length ", length, " is longer than the rest of the input");
+        out.append(_current, std::size_t(length));
+        _current += length;
+    }
+
+    value read_simple(unsigned info, const char* head)
+    {
+        double decimal;
+        switch (info)
+        {
+        case cbor_simple_false:
+            return false;
+        case cbor_simple_true:
+            return true;
+        case cbor_simple_null:
+        case cbor_simple_undefined:
+            return null;
+        case cbor_info_two_bytes:
+            decimal = from_half(static_cast<std::uint16_t>(read_uint(2)));
+            break;
+        case cbor_info_four_bytes:
+        {
+            std::uint32_t bits = static_cast<std::uint32_t>(read_uint(4));
+            float         narrow;
+            std::memcpy(&narrow, &bits, sizeof narrow);
+            decimal = narrow;
+            break;
+        }
+        case cbor_info_eight_bytes:
+        {
+            std::uint64_t bits = read_uint(8);
+            std::memcpy(&decimal, &bits, sizeof decimal);
+            break;
+        }
+        default:
+            fail(head, "Unsupported simple value ", info);
+        }
+
+        if (_options.require_finite_numbers() && !std::isfinite(decimal))
+            fail(head, "Number ", decimal, " is not finite");
+        return decimal;
+    }
+
+private:
+    const char*          _begin;
+    const char*          _current;
+    const char*          _end;
+    const parse_options& _options;
+};
+
+}
+
+value parse_cbor(string_view input, const parse_options& options)
+{
+    return cbor_reader(input, options).read_document();
+}
+
+}
@@ -16,6 +16,7 @@
 #include <cstdint>
 #include <cwchar>
 #include <iomanip>
+#include <limits>
 #include <locale>
 #include <map>
 #include <ostream>
@@ -23,25 +24,14 @@
 #include <stdexcept>
 
 #include "detail/fixed_map.hpp"
-
-#if __cplusplus >= 201703L || defined __has_include
-#   if __has_include(<alloca.h>)
-#       define JSONV_HAS_ALLOCA 1
-#       include <alloca.h>
-#   else
-#       define JSONV_HAS_ALLOCA 0
-#   endif
-#else
-#   define JSONV_HAS_ALLOCA 0
-#endif
-
-#if JSONV_HAS_ALLOCA
-#   define JSONV_TEMP_BUFFER(type_, name_, elem_count_)                                                                \
-        type_* name_ = reinterpret_cast<type_*>(::alloca(sizeof(type_) * (elem_count_)))
-#else
-#   include <memory>
-#   define JSONV_TEMP_BUFFER(type_, name_, elem_count_)                                                                \
-        std::unique_ptr<type_[]> name_ = std::make_unique<type_[]>((elem_count_))
+#include "detail/output_buffer.hpp"
+#include "detail/string_scan.hpp"
+
+#if defined(_WIN32)
+#   define JSONV_CHAR_CONVERT_WINDOWS 1
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <windows.h>
 #endif
 
 namespace jsonv
@@ -70,15 +60,6 @@ decode_error::~decode_error() noexcept
 #define TUPLE_PLUS_1_GEN(a, b) +1
 typedef detail::fixed_map<char, char, ESCAPES_LIST(TUPLE_PLUS_1_GEN)> converter_map;
 
-/** These entries are sorted by the numeric value of the ASCII character (\c less_entry_cpp).
- *
- *  \note
- *  The encode and decode map must be in a different order (even though they contain the same data) because the ASCII
- *  representations of escape sequences are not in the same order as the characters they are escaping.
-**/
-#define TUPLE_FIRST_SECOND(a, b) { a, b },
-const converter_map encode_map = { ESCAPES_LIST(TUPLE_FIRST_SECOND) };
-
 /** These entries are sorted by the character value of the escape sequence (\c less_entry_json).
 **/
 #define TUPLE_SECOND_FIRST(a, b) { b, a },
@@ -93,22 +74,11 @@ const char* find(const converter_map& source, char key)
         return NULL;
 }
 
-static const char* find_encoding(char native_character)
-{
-    return find(encode_map, native_character);
-}
-
 static const char* find_decoding(char char_after_backslash)
 {
     return find(decode_map, char_after_backslash);
 }
 
-static bool needs_unicode_escaping(char c)
-{
-    return bool(c & '\x80')
-        || !std::isprint(c);
-}
-
 static constexpr bool char_bitmatch(char c, char pos, char neg)
 {
     using u8 = unsigned char;
@@ -206,13 +176,16 @@ static bool utf8_extract_code(const char* c, unsigned length, char bitmask, char
 
 static const char hex_codes[] = "0123456789abcdef";
 
-static void to_hex(std::ostream& stream, uint16_t code)
+/** Write <tt>\\uXXXX</tt> for \a code to \a out, returning the end of what was written. **/
+static char* write_unicode_escape(char* out, uint16_t code)
 {
-    for (int pos = 3; pos >= 0; --pos)
-    {
-        uint16_t local_code = (code >> (4 * pos)) & uint16_t(0x000f);
-        stream << hex_codes[local_code];
-    }
+    out[0] = '\\';
+    out[1] = 'u';
+    out[2] = hex_codes[(code >> 12) & 0xf];
+    out[3] = hex_codes[(code >>  8) & 0xf];
+    out[4] = hex_codes[(code >>  4) & 0xf];
+    out[5] = hex_codes[ code        & 0xf];
+    return out + 6;
 }
 
 static void utf16_create_surrogates(char32_t codepoint, uint16_t* high, uint16_t* low)
@@ -228,72 +201,285 @@ static void utf16_create_surrogates(char32_t codepoint, uint16_t* high, uint16_t
     *low  = uint16_t(val & 0x03ff) | 0xdc00;
 }
 
-std::ostream& string_encode(std::ostream& stream, string_view source, bool ensure_ascii)
+namespace
 {
-    typedef string_view::size_type size_type;
 
-    for (size_type idx = 0, source_size = source.size(); idx < source_size; /* incremented inline */)
+/** What the string encoders do with a byte. **/
+enum class byte_kind : unsigned char
+{
+    plain,      //!< Printable ASCII which is copied as it is
+    short_form, //!< One of the \c ESCAPES_LIST characters, written as a backslash and a letter
+    control,    //!< Any other ASCII control character (or DEL), written as a \c \\u escape
+    high,       //!< The start (or a piece) of a multi-byte UTF-8 sequence
+};
+
+/** A \c byte_kind and the \c ESCAPES_LIST letter for each of the 256 byte values, so the encoders look up a byte
+ *  instead of searching a map and calling \c std::isprint for it.
+**/
+struct byte_table
+{
+    byte_table()
     {
-        const char& current = source[idx];
-        if (const char* replacement = find_encoding(current))
+        for (unsigned c = 0; c < 256U; ++c)
+        {
+            kinds[c]   = c >= 0x80U                ? byte_kind::high
+                       : c < 0x20U || c == 0x7fU   ? byte_kind::control
+                       :                             byte_kind::plain;
+            letters[c] = '\0';
+        }
+        #define TABLE_SHORT_FORM(a, b) kinds[static_cast<unsigned char>(a)]   = byte_kind::short_form; \
+                                       letters[static_cast<unsigned char>(a)] = b;
+        ESCAPES_LIST(TABLE_SHORT_FORM)
+        #undef TABLE_SHORT_FORM
+    }
+
+    byte_kind kind(char c) const
+    {
+        return kinds[static_cast<unsigned char>(c)];
+    }
+
+    char letter(char c) const
+    {
+        return letters[static_cast<unsigned char>(c)];
+    }
+
+    byte_kind kinds[256];
+    char      letters[256];
+};
+
+const byte_table encode_bytes;
+
+/** The longest text \c string_encode_to writes for one character: a surrogate pair. **/
+static constexpr std::size_t max_escaped_length = 12;
+
+/** Escapes are gathered into a local array of this many characters and written a batch at a time. **/
+static constexpr std::size_t escape_batch_size = 256;
+
+}
+
+/** The body of \c string_encode. \a TOutput is anything with the \c put and \c write members of \c std::ostream.
+ *
+ *  Runs of plain ASCII are found a vector at a time and copied a run at a time. Everything between the runs (escapes,
+ *  control characters and UTF-8 sequences) is written into a local array and handed to \a out in one \c write, so
+ *  text which is mostly non-ASCII is not a handful of calls for each character.
+**/
+template <typename TOutput>
+static void string_encode_to(TOutput& out, string_view source, bool ensure_ascii)
+{
+    const char* current = source.data();
+    const char* end     = current + source.size();
+
+    char  batch[escape_batch_size];
+    char* batch_end = batch;
+    auto flush_batch = [&]
+                       {
+                           if (batch_end != batch)
+                           {
+                               out.write(batch, std::size_t(batch_end - batch));
+                               batch_end = batch;
+                           }
+                       };
+
+    while (current != end)
+    {
+        byte_kind kind = encode_bytes.kind(*current);
+        if (kind == byte_kind::plain)
         {
-            stream << "\\" << *replacement;
-            ++idx;
+            const char* run_end = find_string_escape(current, end);
+            if (run_end == current)
+                run_end = current + 1;
+            flush_batch();
+            out.write(current, std::size_t(run_end - current));
+            current = run_end;
+            continue;
+        }
+
+        if (std::size_t(batch + escape_batch_size - batch_end) < max_escaped_length)
+            flush_batch();
+
+        if (kind == byte_kind::short_form)
+        {
+            *batch_end++ = '\\';
+            *batch_end++ = encode_bytes.letter(*current);
+            ++current;
+        }
+        else if (kind == byte_kind::control)
+        {
+            batch_end = write_unicode_escape(batch_end, uint16_t(static_cast<unsigned char>(*current)));
+            ++current;
         }
         else
         {
             unsigned length;
-            char bitmask;
-            bool valid_utf8 = utf8_extract_info(current, length, bitmask);
+            char     bitmask;
+            bool     valid_utf8 = utf8_extract_info(*current, length, bitmask);
+            char32_t code;
+            if (!valid_utf8
+               || length > std::size_t(end - current)
+               || !utf8_extract_code(current, length, bitmask, code)
+               )
+            {
+                // Invalid UTF-8 encoding -- we're either at the end of the string or the bytes were not a valid
+                // UTF-8 sequence. In either case, we will drop in a numeric encoding (\u00NN) for the bytes.
+                length = 1;
+                code = char32_t(*current) & 0xff;
+            }
 
-            if (!needs_unicode_escaping(current))
+            // if the input string is valid UTF-8, let it pass through
+            if (valid_utf8 && !ensure_ascii)
             {
-                stream << current;
+                std::copy(current, current + length, batch_end);
+                batch_end += length;
             }
+            // basic multilingual plane points are encoded in hex
+            else if (code < 0x10000)
+            {
+                batch_end = write_unicode_escape(batch_end, uint16_t(code));
+            }
+            // Codepoints not in the basic multilingual plane must be encoded as surrogate pairs
             else
             {
-                char32_t code;
-                if (!valid_utf8
-                   || idx + length > source_size
-                   || !utf8_extract_code(&current, length, bitmask, code)
-                   )
-                {
-                    // Invalid UTF-8 encoding -- we're either at the end of the string or the bytes were not a valid
-                    // UTF-8 sequence. In either case, we will drop in a numeric encoding (\u00NN) for the bytes.
-                    length = 1;
-                    code = char32_t(current) & 0xff;
-                }
-
-                // if the input string is valid UTF-8, let it pass through
-                if (valid_utf8 && !ensure_ascii)
-                {
-                    stream.write(&current, length);
-                }
-                // basic multilingual plane points are encoded in hex
-                else if (code < 0x10000)
-                {
-                    stream << "\\u";
-                    to_hex(stream, uint16_t(code));
-                }
-                // Codepoints not in the basic multilingual plane must be encoded as surrogate pairs
-                else
-                {
-                    uint16_t high, low;
-                    utf16_create_surrogates(code, &high, &low);
-                    stream << "\\u";
-                    to_hex(stream, high);
-                    stream << "\\u";
-                    to_hex(stream, low);
-                }
+                uint16_t high, low;
+                utf16_create_surrogates(code, &high, &low);
+                batch_end = write_unicode_escape(batch_end, high);
+                batch_end = write_unicode_escape(batch_end, low);
             }
-
-            idx += length;
+            current += length;
         }
     }
+    flush_batch();
+}
 
+std::ostream& string_encode(std::ostream& stream, string_view source, bool ensure_ascii)
+{
+    string_encode_to(stream, source, ensure_ascii);
     return stream;
 }
 
+void string_encode(output_buffer& out, string_view source, bool ensure_ascii)
+{
+    string_encode_to(out, source, ensure_ascii);
+}
+
+namespace
+{
+
+/** An output for \c string_encode_to which appends to an \c std::string. **/
+struct string_output
+{
+    void put(char c)
+    {
+        out.push_back(c);
+    }
+    
+    void write(const char* data, std::size_t length)
+    {
+        out.append(data, length);
+    }
+    
+    std::string& out;
+};
+
+/** An output for \c string_encode_to which only counts what is written to it. **/
+struct counting_output
+{
+    void put(char)
+    {
+        ++count;
+    }
+    
+    void write(const char*, std::size_t length)
+    {
+        count += length;
+    }
+    
+    std::size_t count = 0;
+};
+
+}
+
+void string_encode(std::string& out, string_view source, bool ensure_ascii)
+{
+    string_output adapter { out };
+    string_encode_to(adapter, source, ensure_ascii);
+}
+
+std::size_t string_encoded_size(string_view source, bool ensure_ascii)
+{
+    counting_output out;
+    string_encode_to(out, source, ensure_ascii);
+    return out.count;
+}
+
+void string_canonical_encode(std::string& out, string_view source)
+{
+    const char* current = source.data();
+    const char* end     = current + source.size();
+    
+    out.push_back('\"');
+    while (current != end)
+    {
+        unsigned char c = static_cast<unsigned char>(*current);
+        if (c >= 0x80U)
+        {
+            // Copied as they are, but only a well-formed sequence of a Unicode scalar value has one canonical form
+            static const char32_t min_code[] = { 0, 0, 0x80, 0x800, 0x10000 };
+            unsigned length;
+            char     bitmask;
+            char32_t code;
+            if (!utf8_extract_info(*current, length, bitmask)
+               || length > 4U
+               || length > std::size_t(end - current)
+               || !utf8_extract_code(current, length, bitmask, code)
+               || code < min_code[length]
+               || code > 0x10ffff
+               || (0xd800 <= code && code <= 0xdfff)
+               )
+                throw std::invalid_argument("Canonical JSON requires valid UTF-8, but the sequence at byte "
+                                            + std::to_string(current - source.data()) + " is not"
+                                           );
+            out.append(current, length);
+            current += length;
+        }
+        else if (c == '\"' || c == '\\')
+        {
+            out.push_back('\\');
+            out.push_back(char(c));
+            ++current;
+        }
+        else if (c < 0x20U)
+        {
+            char letter = encode_bytes.letter(char(c));
+            if (letter)
+            {
+                out.push_back('\\');
+                out.push_back(letter);
+            }
+            else
+            {
+                char escaped[6];
+                out.append(escaped, std::size_t(write_unicode_escape(escaped, uint16_t(c)) - escaped));
+            }
+            ++current;
+        }
+        else
+        {
+            // Everything else (including the '/' and DEL which string_encode escapes) is plain, so copy the run of it
+            const char* run_end = current + 1;
+            while (run_end != end)
+            {
+                unsigned char x = static_cast<unsigned char>(*run_end);
+                if (x < 0x20U || x >= 0x80U || x == '\"' || x == '\\')
+                    break;
+                ++run_end;
+            }
+            out.append(current, std::size_t(run_end - current));
+            current = run_end;
+        }
+    }
+    out.push_back('\"');
+}
+
 static uint16_t from_hex_digit(char c, std::size_t idx)
 {
     switch (c)
@@ -409,6 +595,21 @@ static void utf8_append_code(std::string& str, char32_t val)
     str.append(buffer, bufferOut);
 }
 
+/** An output for \c string_decode_to which throws everything away, for checking that a string can be decoded. **/
+struct discard_output
+{
+    void append(const char*, const char*)
+    { }
+    
+    discard_output& operator+=(char)
+    {
+        return *this;
+    }
+};
+
+static void utf8_append_code(discard_output&, char32_t)
+{ }
+
 static bool utf16_combine_surrogates(uint16_t high, uint16_t low, char32_t* out)
 {
     if ((high & 0xfc00U) != 0xd800 || (low & 0xfc00U) != 0xdc00)
@@ -434,18 +635,29 @@ static bool utf16_combine_surrogates(uint16_t high, uint16_t low, char32_t* out)
  *  \tparam require_printable Requires all characters in the sequence to be "printable" (aka: call \c std::isprint on
  *                            them). This will probably eventually eventually transform into a "strict mode."
 **/
-template <parse_options::encoding encoding, bool require_printable>
-std::string string_decode(string_view source)
+template <parse_options::encoding encoding, bool require_printable, typename TOutput>
+static void string_decode_to(TOutput& output, string_view source)
 {
     typedef std::string::size_type size_type;
 
-    std::string output;
     const char* last_pushed_src = source.data();
     size_type utf8_sequence_start = 0;
     unsigned remaining_utf8_sequence = 0;
 
     for (size_type idx = 0; idx < source.size(); /* incremented inline */)
     {
+        if (remaining_utf8_sequence == 0)
+        {
+            // Runs of plain ASCII can be skipped over in bulk
+            idx = size_type(find_string_special(source.data() + idx, source.data() + source.size(), true,
+                                                require_printable
+                                               )
+                            - source.data()
+                           );
+            if (idx == source.size())
+                break;
+        }
+        
         const char& current = source[idx];
         if (remaining_utf8_sequence == 0)
         {
@@ -580,39 +792,54 @@ std::string string_decode(string_view source)
     }
 
     output.append(last_pushed_src, source.end());
-    return output;
 }
 
-template <>
-std::string string_decode<parse_options::encoding::iso8, false>(string_view source)
+template <typename TOutput>
+static void string_decode_iso8_to(TOutput& output, string_view source)
 {
 	typedef std::string::size_type size_type;
-	std::string output;
 
 	for (size_type idx = 0; idx < source.size(); ++idx)
 	{
-		const char& current = source[idx];
-
-		if (current == '\\')
+		// Everything up to the next backslash is copied as-is
+		const char* run_end = find_string_special(source.data() + idx, source.data() + source.size(), false, false);
+		output.append(source.data() + idx, run_end);
+		idx = size_type(run_end - source.data());
+		if (idx == source.size())
+			break;
+
+		const char& next = source[idx + 1];
+		if (const char* replacement = find_decoding(next))
 		{
-			const char& next = source[idx + 1];
-			if (const char* replacement = find_decoding(next))
-			{
-				output += *replacement;
-				idx ++;
-			}
-			else
-			{
-				throw decode_error(idx, std::string("Unknown escape character: ") + next);
-			}
+			output += *replacement;
+			idx ++;
 		}
 		else
 		{
-			output += current;
+			throw decode_error(idx, std::string("Unknown escape character: ") + next);
 		}
 	}
+}
+
+template <parse_options::encoding encoding, bool require_printable>
+std::string string_decode(string_view source)
+{
+    std::string output;
+    if (encoding == parse_options::encoding::iso8)
+        string_decode_iso8_to(output, source);
+    else
+        string_decode_to<encoding, require_printable>(output, source);
+    return output;
+}
 
-	return output;
+template <parse_options::encoding encoding, bool require_printable>
+void string_validate(string_view source)
+{
+    discard_output output;
+    if (encoding == parse_options::encoding::iso8)
+        string_decode_iso8_to(output, source);
+    else
+        string_decode_to<encoding, require_printable>(output, source);
 }
 
 string_decode_fn get_string_decoder(parse_options::encoding encoding)
@@ -632,27 +859,138 @@ string_decode_fn get_string_decoder(parse_options::encoding encoding)
     };
 }
 
+string_validate_fn get_string_validator(parse_options::encoding encoding)
+{
+    switch (encoding)
+    {
+    case parse_options::encoding::cesu8:
+        return string_validate<parse_options::encoding::cesu8, false>;
+    case parse_options::encoding::utf8_strict:
+        return string_validate<parse_options::encoding::utf8, true>;
+    case parse_options::encoding::iso8:
+        return string_validate<parse_options::encoding::iso8, false>;
+    case parse_options::encoding::utf8:
+    default:
+        return string_validate<parse_options::encoding::utf8, false>;
+    }
+}
+
+/** Widen the ASCII characters at the start of \a source into \a out, stopping at the first one which is not ASCII.
+ *
+ *  \returns The number of characters copied.
+**/
+static std::size_t widen_ascii(const char* source, std::size_t source_size, wchar_t* out)
+{
+    std::size_t count = std::size_t(find_non_ascii(source, source + source_size) - source);
+    // a plain loop with no early exit, which compilers turn into vector instructions
+    for (std::size_t idx = 0; idx < count; ++idx)
+        out[idx] = wchar_t(source[idx]);
+    return count;
+}
+
+/** Narrow the ASCII characters at the start of \a source into \a out, stopping at the first one which is not ASCII.
+ *  Blocks of characters are checked and copied at once, which compilers turn into vector instructions.
+ *
+ *  \returns The number of characters copied.
+**/
+static std::size_t narrow_ascii(const wchar_t* source, std::size_t source_size, char* out)
+{
+    constexpr std::size_t block_size = 16;
+
+    std::size_t idx = 0;
+    for (; source_size - idx >= block_size; idx += block_size)
+    {
+        std::uint32_t bits = 0;
+        for (std::size_t sub = 0; sub < block_size; ++sub)
+            bits |= std::uint32_t(source[idx + sub]);
+        if (bits >= 0x80U)
+            break;
+
+        for (std::size_t sub = 0; sub < block_size; ++sub)
+            out[idx + sub] = char(source[idx + sub]);
+    }
+
+    for (; idx < source_size && std::uint32_t(source[idx]) < 0x80U; ++idx)
+        out[idx] = char(source[idx]);
+    return idx;
+}
+
+#if JSONV_CHAR_CONVERT_WINDOWS
+
+std::wstring convert_to_wide(string_view source)
+{
+    // UTF-16 never takes more code units than UTF-8 takes bytes, so the size of the source is enough room
+    std::wstring out(source.size(), L'\0');
+    std::size_t  out_idx = widen_ascii(source.data(), source.size(), &out[0]);
+    if (out_idx == source.size())
+        return out;
+
+    if (source.size() > std::size_t(std::numeric_limits<int>::max()))
+        throw std::length_error("Source is too long to convert");
+
+    int converted = ::MultiByteToWideChar(CP_UTF8,
+                                          MB_ERR_INVALID_CHARS,
+                                          source.data() + out_idx,
+                                          int(source.size() - out_idx),
+                                          &out[out_idx],
+                                          int(out.size() - out_idx)
+                                         );
+    if (converted == 0)
+        throw std::range_error("Invalid UTF-8: Invalid character");
+
+    out.resize(out_idx + std::size_t(converted));
+    return out;
+}
+
+static std::string convert_to_narrow(const wchar_t* source_data, std::size_t source_size)
+{
+    if (source_size == 0)
+        return std::string();
+    if (source_size > std::size_t(std::numeric_limits<int>::max()))
+        throw std::length_error("Source is too long to convert");
+
+    int out_size = ::WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, source_data, int(source_size), nullptr, 0,
+                                         nullptr, nullptr
+                                        );
+    if (out_size == 0)
+        throw std::range_error("Invalid UTF-16: invalid surrogate pair");
+
+    std::string out(std::size_t(out_size), '\0');
+    // Every character outside of ASCII takes at least two bytes per code unit, so matching sizes means all ASCII
+    if (std::size_t(out_size) == source_size)
+        narrow_ascii(source_data, source_size, &out[0]);
+    else
+        ::WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, source_data, int(source_size), &out[0], out_size,
+                              nullptr, nullptr
+                             );
+    return out;
+}
+
+#else
+
 std::wstring convert_to_wide(string_view source)
 {
-    // Step 1: Determine the codepoints from the source
-    JSONV_TEMP_BUFFER(char32_t, unicode_buff, source.size());
-    std::size_t unicode_idx = 0;
-    std::size_t large_codes = 0;
+    // UTF-16 never takes more code units than UTF-8 takes bytes, so the size of the source is enough room
+    std::wstring out(source.size(), L'\0');
+    std::size_t  out_idx = 0;
 
     for (std::size_t source_idx = 0; source_idx < source.size(); /* inline */)
     {
-        auto next_source = [&] () -> char32_t { return static_cast<unsigned char>(source.at(source_idx++)); };
+        auto next_source = [&] () -> char32_t { return static_cast<unsigned char>(source[source_idx++]); };
+
+        if (static_cast<unsigned char>(source[source_idx]) <= 0x7f)
+        {
+            std::size_t count = widen_ascii(source.data() + source_idx, source.size() - source_idx, &out[out_idx]);
+            source_idx += count;
+            out_idx    += count;
+            continue;
+        }
 
         char32_t    codepoint;
         std::size_t steps;
 
         auto c = next_source();
-        if (c <= 0x7f)
-        {
-            codepoint = c;
-            steps     = 0;
-        }
-        else if (c <= 0xbf)
+        if (c <= 0xbf)
         {
             throw std::range_error("Invalid UTF-8: Invalid character");
         }
@@ -694,56 +1032,64 @@ std::wstring convert_to_wide(string_view source)
         if (codepoint > 0x10ffffU)
             throw std::range_error("Invalid UTF-8: code point is too large");
 
-        unicode_buff[unicode_idx++] = codepoint;
-        if (codepoint > 0xffffU)
-            ++large_codes;
-    }
-
-    // Step 2: Fill the string from codepoints
-    std::wstring out;
-    out.reserve(unicode_idx + large_codes);
-
-    for (std::size_t idx = 0; idx < unicode_idx; ++idx)
-    {
-        char32_t code_point = unicode_buff[idx];
-        if (code_point <= 0xffffU)
+        if (codepoint <= 0xffffU)
         {
-            out += wchar_t(code_point);
+            out[out_idx++] = wchar_t(codepoint);
         }
         else
         {
             uint16_t high, low;
-            utf16_create_surrogates(code_point, &high, &low);
-            out += wchar_t(high);
-            out += wchar_t(low);
+            utf16_create_surrogates(codepoint, &high, &low);
+            out[out_idx++] = wchar_t(high);
+            out[out_idx++] = wchar_t(low);
         }
     }
+
+    out.resize(out_idx);
     return out;
 }
 
 static std::string convert_to_narrow(const wchar_t* source_data, std::size_t source_size)
 {
-    // Step 1: Extract codepoints from the source
-    JSONV_TEMP_BUFFER(char32_t, unicode_buff, source_size);
-    std::size_t unicode_idx = 0;
-    std::size_t out_chars   = 0;
+    // Step 1: Count the bytes of output, so the string is only allocated once (a surrogate pair takes 4 bytes)
+    std::size_t out_size = 0;
+    for (std::size_t idx = 0; idx < source_size; ++idx)
+    {
+        auto c = static_cast<std::uint16_t>(source_data[idx]);
+        out_size += (c <= 0x007fU)           ? 1U
+                  : (c <= 0x07ffU)           ? 2U
+                  : ((c & 0xf800U) == 0xd800U) ? 2U
+                  :                            3U;
+    }
+
+    // Step 2: Fill the string, copying runs of ASCII at once
+    std::string out(out_size, '\0');
+    std::size_t out_idx = 0;
 
     for (std::size_t source_idx = 0; source_idx < source_size; /* inline */)
     {
         auto next_source = [&] () -> char32_t { return static_cast<std::uint16_t>(source_data[source_idx++]); };
 
+        if (std::uint32_t(source_data[source_idx]) <= 0x7fU)
+        {
+            std::size_t count = narrow_ascii(source_data + source_idx, source_size - source_idx, &out[out_idx]);
+            source_idx += count;
+            out_idx    += count;
+            continue;
+        }
+
         char32_t codepoint;
         auto     c         = next_source();
 
         // normal
-        if ((c & 0xfc00U) != 0xd800U)
+        if ((c & 0xf800U) != 0xd800U)
         {
             codepoint = c;
         }
         // surrogate start
         else
         {
-            if (source_idx + 1 >= source_size)
+            if (source_idx >= source_size)
                 throw std::range_error("Invalid UTF-16: surrogate extends past end of string");
 
             auto c_lo = next_source();
@@ -751,25 +1097,22 @@ static std::string convert_to_narrow(const wchar_t* source_data, std::size_t sou
                 throw std::range_error("Invalid UTF-16: invalid surrogate pair");
         }
 
-        unicode_buff[unicode_idx++] = codepoint;
-        out_chars += (codepoint <= 0x007fU) ? 1U
-                   : (codepoint <= 0x07ffU) ? 2U
-                   : (codepoint <= 0xffffU) ? 3U
-                   :                          4U;
-    }
-
-    // Step 2: Fill the string from codepoints
-    std::string out;
-    out.reserve(out_chars);
-
-    for (std::size_t idx = 0U; idx < unicode_idx; ++idx)
-    {
-        utf8_append_code(out, unicode_buff[idx]);
+        std::size_t length;
+        char        first;
+        utf8_sequence_info(codepoint, &length, &first);
+        out[out_idx++] = first;
+        for (std::size_t shift = (length - 1) * 6; shift > 0; /* inline */)
+        {
+            shift -= 6;
+            out[out_idx++] = char('\x80' | ('\x3f' & (codepoint >> shift)));
+        }
     }
 
     return out;
 }
 
+#endif
+
 std::string convert_to_narrow(const wchar_t* source)
 {
     return convert_to_narrow(source, wcslen(source));
@@ -782,19 +1125,26 @@ std::string convert_to_narrow(const std::wstring& source)
 
 std::ostream& string_iso_encode(std::ostream& stream, string_view source)
 {
-	typedef string_view::size_type size_type;
-
-	for (size_type idx = 0, source_size = source.size(); idx < source_size; ++idx)
+	// Only the ESCAPES_LIST characters are escaped -- everything else (including control characters and high bytes) is
+	// written as it is, a run at a time
+	const char* current = source.data();
+	const char* end     = current + source.size();
+	while (current != end)
 	{
-		const char& current = source[idx];
-		if (const char* replacement = find_encoding(current))
-		{
-			stream << "\\" << *replacement;
-		}
-		else
+		const char* run_end = current;
+		while (run_end != end && encode_bytes.kind(*run_end) != byte_kind::short_form)
+			++run_end;
+		if (run_end != current)
 		{
-			stream << current;
+			stream.write(current, std::streamsize(run_end - current));
+			current = run_end;
+			if (current == end)
+				break;
 		}
+
+		char escaped[2] = { '\\', encode_bytes.letter(*current) };
+		stream.write(escaped, 2);
+		++current;
 	}
 
 	return stream;
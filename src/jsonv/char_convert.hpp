@@ -15,6 +15,7 @@
 #include <jsonv/parse.hpp>
 #include <jsonv/string_view.hpp>
 
+#include <cstddef>
 #include <string>
 #include <stdexcept>
 
@@ -23,6 +24,8 @@ namespace jsonv
 namespace detail
 {
 
+class output_buffer;
+
 class decode_error :
         public std::runtime_error
 {
@@ -46,6 +49,22 @@ private:
 **/
 std::ostream& string_encode(std::ostream& stream, string_view source, bool ensure_ascii = true);
 
+/** Like \c string_encode for an \c std::ostream, but writing to \a out. **/
+void string_encode(output_buffer& out, string_view source, bool ensure_ascii = true);
+
+/** Like \c string_encode for an \c std::ostream, but appending to \a out. **/
+void string_encode(std::string& out, string_view source, bool ensure_ascii = true);
+
+/** The number of characters \c string_encode writes for \a source. **/
+std::size_t string_encoded_size(string_view source, bool ensure_ascii = true);
+
+/** Append the RFC 8785 canonical form of \a source to \a out, quotes included: only \c ", \c \\ and control
+ *  characters are escaped (with the short form if there is one) and everything else is copied as it is.
+ *  
+ *  \throws std::invalid_argument if \a source is not valid UTF-8.
+**/
+void string_canonical_encode(std::string& out, string_view source);
+
 /** Encodes C++ string \a source into a escaped JSON string with ISO 8-bit encoding into \a stream ready for sending over the wire.
 **/
 std::ostream& string_iso_encode(std::ostream& stream, string_view source);
@@ -56,6 +75,15 @@ typedef std::string (*string_decode_fn)(string_view source);
 /** Get a string decoding function for the given output \a encoding. **/
 string_decode_fn get_string_decoder(parse_options::encoding encoding);
 
+/** A function which checks that the over the wire character sequence \c source can be decoded, without decoding it.
+ *  
+ *  \throws decode_error if the string decoding function would.
+**/
+typedef void (*string_validate_fn)(string_view source);
+
+/** Get a string validation function for the given output \a encoding. **/
+string_validate_fn get_string_validator(parse_options::encoding encoding);
+
 /** Convert the UTF-8 encoded \a source into a UTF-16 encoded \c std::wstring. **/
 std::wstring convert_to_wide(string_view source);
 
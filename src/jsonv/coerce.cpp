@@ -13,7 +13,9 @@
 #include <jsonv/value.hpp>
 #include <jsonv/util.hpp>
 
+#include <iterator>
 #include <limits>
+#include <utility>
 
 #include "detail/fallthrough.hpp"
 
@@ -87,6 +89,25 @@ std::map<std::string, value> coerce_object(const value& from)
         throw kind_error(std::string("Invalid kind for object: ") + to_string(from.kind()));
 }
 
+std::map<std::string, value> coerce_object(value&& from)
+{
+    if (from.kind() != kind::object)
+        throw kind_error(std::string("Invalid kind for object: ") + to_string(from.kind()));
+    
+    std::map<std::string, value> out;
+    for (auto iter = from.begin_object(); iter != from.end_object(); ++iter)
+        out.emplace_hint(out.end(), iter->first, std::move(iter->second));
+    return out;
+}
+
+value::const_object_view coerce_object_view(const value& from)
+{
+    if (from.kind() == kind::object)
+        return from.as_object();
+    else
+        throw kind_error(std::string("Invalid kind for object: ") + to_string(from.kind()));
+}
+
 std::vector<value> coerce_array(const value& from)
 {
     if (from.kind() == kind::array)
@@ -95,6 +116,23 @@ std::vector<value> coerce_array(const value& from)
         throw kind_error(std::string("Invalid kind for array: ") + to_string(from.kind()));
 }
 
+std::vector<value> coerce_array(value&& from)
+{
+    if (from.kind() != kind::array)
+        throw kind_error(std::string("Invalid kind for array: ") + to_string(from.kind()));
+    
+    value* first = from.array_data();
+    return std::vector<value>(std::make_move_iterator(first), std::make_move_iterator(first + from.size()));
+}
+
+value::const_array_view coerce_array_view(const value& from)
+{
+    if (from.kind() == kind::array)
+        return from.as_array();
+    else
+        throw kind_error(std::string("Invalid kind for array: ") + to_string(from.kind()));
+}
+
 std::string coerce_string(const value& from)
 {
     if (from.kind() == kind::string)
@@ -103,6 +141,14 @@ std::string coerce_string(const value& from)
         return to_string(from);
 }
 
+std::string coerce_string(value&& from)
+{
+    if (from.kind() == kind::string)
+        return from.take_string();
+    else
+        return to_string(from);
+}
+
 std::int64_t coerce_integer(const value& from)
 {
     switch (from.kind())
@@ -182,6 +228,30 @@ bool coerce_boolean(const value& from)
     }
 }
 
+void coerce_string_to(value& x)
+{
+    if (x.kind() != kind::string)
+        x = coerce_string(x);
+}
+
+void coerce_integer_to(value& x)
+{
+    if (x.kind() != kind::integer)
+        x = coerce_integer(x);
+}
+
+void coerce_decimal_to(value& x)
+{
+    if (x.kind() != kind::decimal)
+        x = coerce_decimal(x);
+}
+
+void coerce_boolean_to(value& x)
+{
+    if (x.kind() != kind::boolean)
+        x = coerce_boolean(x);
+}
+
 value coerce_merge(value a, value b)
 {
     if (a.kind() == b.kind())
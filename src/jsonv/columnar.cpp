@@ -0,0 +1,283 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/columnar.hpp>
+#include <jsonv/array_stream.hpp>
+#include <jsonv/parse.hpp>
+
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace jsonv
+{
+
+std::ostream& operator<<(std::ostream& os, const column_type& type)
+{
+    switch (type)
+    {
+    case column_type::null:    return os << "null";
+    case column_type::boolean: return os << "boolean";
+    case column_type::integer: return os << "integer";
+    case column_type::decimal: return os << "decimal";
+    case column_type::string:  return os << "string";
+    case column_type::json:    return os << "json";
+    default:                   return os << "column_type(" << static_cast<int>(type) << ")";
+    }
+}
+
+/** Set the bit at \a position of a bitmap which is being filled in order. **/
+static void push_bit(std::vector<std::uint8_t>& bits, std::size_t position, bool set)
+{
+    if (position % 8 == 0)
+        bits.push_back(0);
+    if (set)
+        bits.back() |= std::uint8_t(1U << (position % 8));
+}
+
+/** The type a column which holds values of types \a a and \a b needs to have. **/
+static column_type widest(column_type a, column_type b)
+{
+    if (a == b || b == column_type::null)
+        return a;
+    else if (a == column_type::null)
+        return b;
+    else if (  (a == column_type::integer && b == column_type::decimal)
+            || (a == column_type::decimal && b == column_type::integer)
+            )
+        return column_type::decimal;
+    else
+        return column_type::json;
+}
+
+static column_type type_of(const value& x)
+{
+    switch (x.kind())
+    {
+    case kind::null:    return column_type::null;
+    case kind::boolean: return column_type::boolean;
+    case kind::integer: return column_type::integer;
+    case kind::decimal: return column_type::decimal;
+    case kind::string:  return column_type::string;
+    case kind::array:
+    case kind::object:
+    default:            return column_type::json;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// column                                                                                                             //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+column::column(std::string name) :
+        _name(std::move(name)),
+        _type(column_type::null),
+        _size(0),
+        _null_count(0),
+        _offsets({ 0 })
+{ }
+
+value column::at(std::size_t row) const
+{
+    if (row >= _size)
+        throw std::out_of_range("Row " + std::to_string(row) + " is past the end of column \"" + _name + "\"");
+    if (!valid(row))
+        return null;
+
+    switch (_type)
+    {
+    case column_type::boolean: return ((_booleans[row / 8] >> (row % 8)) & 1U) != 0;
+    case column_type::integer: return _integers[row];
+    case column_type::decimal: return _decimals[row];
+    case column_type::string:  return std::string(dictionary_entry(std::size_t(_indices[row])));
+    case column_type::json:    return parse(dictionary_entry(std::size_t(_indices[row])));
+    case column_type::null:
+    default:                   return null;
+    }
+}
+
+void column::append_null()
+{
+    switch (_type)
+    {
+    case column_type::boolean: push_bit(_booleans, _size, false); break;
+    case column_type::integer: _integers.push_back(0);            break;
+    case column_type::decimal: _decimals.push_back(0.0);          break;
+    case column_type::string:
+    case column_type::json:    _indices.push_back(0);             break;
+    case column_type::null:
+    default:                                                      break;
+    }
+    push_bit(_validity, _size, false);
+    ++_null_count;
+    ++_size;
+}
+
+void column::append_valid()
+{
+    push_bit(_validity, _size, true);
+    ++_size;
+}
+
+void column::append(const value& x, std::unordered_map<std::string, std::int32_t>& dictionary)
+{
+    column_type type = type_of(x);
+    if (type == column_type::null)
+    {
+        append_null();
+        return;
+    }
+
+    column_type target = widest(_type, type);
+    if (target != _type)
+        widen(target, dictionary);
+
+    switch (_type)
+    {
+    case column_type::boolean: push_bit(_booleans, _size, x.as_boolean());    break;
+    case column_type::integer: _integers.push_back(x.as_integer());           break;
+    case column_type::decimal: _decimals.push_back(x.as_decimal());           break;
+    case column_type::string:  append_entry(x.as_string_view(), dictionary);  break;
+    case column_type::json:    append_entry(to_string(x), dictionary);        break;
+    case column_type::null:
+    default:                                                                  break;
+    }
+    append_valid();
+}
+
+void column::append_entry(string_view text, std::unordered_map<std::string, std::int32_t>& dictionary)
+{
+    std::string key(text);
+    auto        found = dictionary.find(key);
+    if (found != dictionary.end())
+    {
+        _indices.push_back(found->second);
+        return;
+    }
+
+    if (text.size() > std::size_t(std::numeric_limits<std::int32_t>::max()) - _data.size())
+        throw std::length_error("Dictionary of column \"" + _name + "\" is too large for 32-bit offsets");
+
+    std::int32_t idx = std::int32_t(dictionary_size());
+    _data.append(text.data(), text.size());
+    _offsets.push_back(std::int32_t(_data.size()));
+    dictionary.emplace(std::move(key), idx);
+    _indices.push_back(idx);
+}
+
+void column::widen(column_type type, std::unordered_map<std::string, std::int32_t>& dictionary)
+{
+    std::vector<value> previous;
+    previous.reserve(_size);
+    for (std::size_t row = 0; row < _size; ++row)
+        previous.push_back(at(row));
+
+    column fresh(std::move(_name));
+    fresh._type = type;
+    *this = std::move(fresh);
+    dictionary.clear();
+    for (const value& x : previous)
+        append(x, dictionary);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// columnar_table                                                                                                     //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+columnar_table::columnar_table() :
+        _rows(0)
+{ }
+
+const column& columnar_table::at(string_view name) const
+{
+    for (const column& col : _columns)
+        if (col.name() == name)
+            return col;
+    throw std::out_of_range("No column named \"" + std::string(name) + "\"");
+}
+
+value columnar_table::row(std::size_t row) const
+{
+    if (row >= _rows)
+        throw std::out_of_range("Row " + std::to_string(row) + " is past the end of the table");
+
+    value out = object();
+    for (const column& col : _columns)
+        if (col.valid(row))
+            out[col.name()] = col.at(row);
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// columnar_builder                                                                                                   //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+columnar_builder::columnar_builder() = default;
+
+void columnar_builder::add_row(const value& row)
+{
+    if (row.kind() != kind::object)
+        detail::throw_kind_error(kind::object, row.kind());
+
+    for (const auto& member : row.as_object())
+    {
+        auto        found = _by_name.find(member.first);
+        std::size_t idx;
+        if (found != _by_name.end())
+        {
+            idx = found->second;
+        }
+        else
+        {
+            idx = _table._columns.size();
+            _table._columns.emplace_back(member.first);
+            for (std::size_t earlier = 0; earlier < _table._rows; ++earlier)
+                _table._columns.back().append_null();
+            _dictionaries.emplace_back();
+            _by_name.emplace(member.first, idx);
+        }
+        _table._columns[idx].append(member.second, _dictionaries[idx]);
+    }
+
+    ++_table._rows;
+    for (column& col : _table._columns)
+        if (col.size() < _table._rows)
+            col.append_null();
+}
+
+columnar_table columnar_builder::finish()
+{
+    columnar_table out = std::move(_table);
+    _table = columnar_table();
+    _by_name.clear();
+    _dictionaries.clear();
+    return out;
+}
+
+columnar_table to_columnar(const value& array_of_objects)
+{
+    if (array_of_objects.kind() != kind::array)
+        detail::throw_kind_error(kind::array, array_of_objects.kind());
+
+    columnar_builder builder;
+    for (const value& row : array_of_objects.as_array())
+        builder.add_row(row);
+    return builder.finish();
+}
+
+columnar_table to_columnar(array_range&& rows)
+{
+    columnar_builder builder;
+    for (const value& row : rows)
+        builder.add_row(row);
+    return builder.finish();
+}
+
+}
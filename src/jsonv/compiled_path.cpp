@@ -0,0 +1,220 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/compiled_path.hpp>
+#include <jsonv/value.hpp>
+#include <jsonv/detail/token_patterns.hpp>
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace jsonv
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// compiled_path                                                                                                      //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+compiled_path::compiled_path(const path& p)
+{
+    _steps.reserve(p.size());
+    for (const path_element& elem : p)
+        _steps.push_back(step{ step_kind::element, elem });
+}
+
+static std::invalid_argument invalid_specification(string_view specification, string_view remaining)
+{
+    return std::invalid_argument(std::string("Invalid specification \"") + std::string(specification) + "\". "
+                                 + "Syntax error at \"" + std::string(remaining) + "\""
+                                );
+}
+
+compiled_path compiled_path::create(string_view specification)
+{
+    compiled_path out;
+    string_view remaining = specification;
+    while (!remaining.empty())
+    {
+        if (remaining.size() >= 2 && remaining[0] == '.' && remaining[1] == '.')
+        {
+            out._steps.push_back(step{ step_kind::descendants, path_element(0) });
+            remaining.remove_prefix(2);
+            if (remaining.empty() || remaining[0] == '.')
+                throw invalid_specification(specification, remaining);
+
+            if (remaining[0] == '*')
+            {
+                out._steps.push_back(step{ step_kind::wildcard, path_element(0) });
+                remaining.remove_prefix(1);
+            }
+            else if (remaining[0] != '[')
+            {
+                // a bare key after the ".." -- match it like the ".key" which starts with the second '.'
+                remaining = string_view(remaining.data() - 1, remaining.size() + 1);
+            }
+            continue;
+        }
+
+        if (remaining.size() >= 2 && remaining[0] == '.' && remaining[1] == '*')
+        {
+            out._steps.push_back(step{ step_kind::wildcard, path_element(0) });
+            remaining.remove_prefix(2);
+            continue;
+        }
+
+        if (remaining.size() >= 3 && remaining[0] == '[' && remaining[1] == '*' && remaining[2] == ']')
+        {
+            out._steps.push_back(step{ step_kind::wildcard, path_element(0) });
+            remaining.remove_prefix(3);
+            continue;
+        }
+
+        string_view match;
+        switch (detail::path_match(remaining, match))
+        {
+        case detail::path_match_result::simple_object:
+        case detail::path_match_result::brace:
+            // path::create knows how to decode the element
+            for (path_element& elem : path::create(match))
+                out._steps.push_back(step{ step_kind::element, std::move(elem) });
+            break;
+        default:
+            throw invalid_specification(specification, remaining);
+        }
+        remaining.remove_prefix(match.size());
+    }
+    return out;
+}
+
+bool compiled_path::exact() const
+{
+    return std::all_of(_steps.begin(), _steps.end(), [] (const step& s) { return s.kind == step_kind::element; });
+}
+
+/** Call \a on_child with each child of \a from (if it is an object or array) until it returns \c false. **/
+template <typename TValue, typename FChild>
+static bool for_each_child(TValue& from, const FChild& on_child)
+{
+    if (from.kind() == kind::object)
+    {
+        for (auto iter = from.begin_object(); iter != from.end_object(); ++iter)
+            if (!on_child(iter->second))
+                return false;
+    }
+    else if (from.kind() == kind::array)
+    {
+        for (auto iter = from.begin_array(); iter != from.end_array(); ++iter)
+            if (!on_child(*iter))
+                return false;
+    }
+    return true;
+}
+
+template <typename TValue, typename FMatch>
+bool compiled_path::evaluate(size_type idx, TValue& from, const FMatch& on_match) const
+{
+    if (idx == _steps.size())
+        return on_match(from);
+
+    const step& current = _steps[idx];
+    switch (current.kind)
+    {
+    case step_kind::element:
+        if (current.elem.kind() == path_element_kind::object_key)
+        {
+            if (from.kind() != kind::object)
+                return true;
+            auto iter = from.find(current.elem.key());
+            return iter == from.end_object() || evaluate(idx + 1, iter->second, on_match);
+        }
+        else
+        {
+            if (from.kind() != kind::array || current.elem.index() >= from.size())
+                return true;
+            return evaluate(idx + 1, from[current.elem.index()], on_match);
+        }
+    case step_kind::wildcard:
+        return for_each_child(from, [&] (TValue& child) { return evaluate(idx + 1, child, on_match); });
+    case step_kind::descendants:
+    default:
+        return evaluate(idx + 1, from, on_match)
+            && for_each_child(from, [&] (TValue& child) { return evaluate(idx, child, on_match); });
+    }
+}
+
+std::vector<const value*> compiled_path::match(const value& from) const
+{
+    std::vector<const value*> out;
+    evaluate(0, from, [&] (const value& x) { out.push_back(&x); return true; });
+    return out;
+}
+
+std::vector<value*> compiled_path::match(value& from) const
+{
+    std::vector<value*> out;
+    evaluate(0, from, [&] (value& x) { out.push_back(&x); return true; });
+    return out;
+}
+
+const value* compiled_path::find(const value& from) const
+{
+    const value* out = nullptr;
+    evaluate(0, from, [&] (const value& x) { out = &x; return false; });
+    return out;
+}
+
+value* compiled_path::find(value& from) const
+{
+    value* out = nullptr;
+    evaluate(0, from, [&] (value& x) { out = &x; return false; });
+    return out;
+}
+
+std::ostream& operator<<(std::ostream& os, const compiled_path& query)
+{
+    bool after_descendants = false;
+    for (const compiled_path::step& s : query._steps)
+    {
+        switch (s.kind)
+        {
+        case compiled_path::step_kind::element:
+            if (after_descendants && s.elem.kind() == path_element_kind::object_key)
+            {
+                // drop the '.' of ".key", since the ".." already has one
+                std::string text = to_string(s.elem);
+                os << (text[0] == '.' ? text.substr(1) : text);
+            }
+            else
+            {
+                os << s.elem;
+            }
+            break;
+        case compiled_path::step_kind::wildcard:
+            os << (after_descendants ? "*" : ".*");
+            break;
+        case compiled_path::step_kind::descendants:
+            os << "..";
+            break;
+        }
+        after_descendants = s.kind == compiled_path::step_kind::descendants;
+    }
+    return os;
+}
+
+std::string to_string(const compiled_path& query)
+{
+    std::ostringstream os;
+    os << query;
+    return os.str();
+}
+
+}
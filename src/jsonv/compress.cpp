@@ -0,0 +1,381 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/compress.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** \def JSONV_ZLIB
+ *  Set by the build (the \c USE_ZLIB option of CMake) when zlib is available for the classes in \c compress.hpp.
+**/
+#ifndef JSONV_ZLIB
+#   define JSONV_ZLIB 0
+#endif
+
+#if JSONV_ZLIB
+#   include <zlib.h>
+#endif
+
+namespace jsonv
+{
+
+constexpr int compressor::default_level;
+
+#if JSONV_ZLIB
+
+/** zlib counts in \c uInt, so a single call is given at most this much input. **/
+static constexpr std::size_t zlib_max_step = 1U << 30;
+
+[[noreturn]] static void throw_zlib_error(const char* what, const z_stream& stream, int rc)
+{
+    throw std::runtime_error(std::string(what) + ": " + (stream.msg ? stream.msg : zError(rc)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// compressor                                                                                                         //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct compressor::impl
+{
+    impl(flush_function output, compression format, int level, std::size_t chunk_size) :
+            output(std::move(output)),
+            buffer(chunk_size == 0 ? 1 : chunk_size)
+    {
+        // 15 is the largest window; adding 16 asks for a gzip header and trailer instead of a zlib one
+        int window = format == compression::gzip ? 15 + 16 : 15;
+        int rc     = deflateInit2(&stream, level, Z_DEFLATED, window, 8, Z_DEFAULT_STRATEGY);
+        if (rc != Z_OK)
+            throw_zlib_error("Could not start compressing", stream, rc);
+        reset_output();
+    }
+
+    ~impl() noexcept
+    {
+        deflateEnd(&stream);
+    }
+
+    void reset_output()
+    {
+        stream.next_out  = reinterpret_cast<Bytef*>(buffer.data());
+        stream.avail_out = static_cast<uInt>(buffer.size());
+    }
+
+    void hand_off()
+    {
+        std::size_t length = buffer.size() - stream.avail_out;
+        reset_output();
+        if (length > 0)
+            output(string_view(buffer.data(), length));
+    }
+
+    /** Run \c deflate over \a data until all of it has been taken in (and, for anything but \c Z_NO_FLUSH, all of the
+     *  output has come out).
+    **/
+    void run(string_view data, int mode)
+    {
+        const char* current   = data.data();
+        std::size_t remaining = data.size();
+        while (true)
+        {
+            std::size_t step = remaining < zlib_max_step ? remaining : zlib_max_step;
+            stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(current));
+            stream.avail_in  = static_cast<uInt>(step);
+            int step_mode    = step == remaining ? mode : Z_NO_FLUSH;
+
+            int rc = deflate(&stream, step_mode);
+            if (rc == Z_STREAM_ERROR)
+                throw_zlib_error("Could not compress", stream, rc);
+
+            current   += step - stream.avail_in;
+            remaining -= step - stream.avail_in;
+            if (stream.avail_out == 0)
+                hand_off();
+            else if (remaining == 0 && (mode != Z_FINISH || rc == Z_STREAM_END))
+                break;
+        }
+    }
+
+    flush_function    output;
+    std::vector<char> buffer;
+    z_stream          stream {};
+    bool              finished = false;
+};
+
+compressor::compressor(flush_function output, compression format, int level, std::size_t chunk_size) :
+        _impl(new impl(std::move(output), format, level, chunk_size))
+{ }
+
+compressor::~compressor() noexcept = default;
+
+void compressor::write(string_view data)
+{
+    if (data.empty())
+        return;
+    if (_impl->finished)
+        throw std::logic_error("Can not write to a compressor after it is finished");
+
+    _impl->run(data, Z_NO_FLUSH);
+}
+
+void compressor::flush()
+{
+    if (_impl->finished)
+        return;
+
+    _impl->run(string_view(), Z_SYNC_FLUSH);
+    _impl->hand_off();
+}
+
+void compressor::finish()
+{
+    if (_impl->finished)
+        return;
+
+    _impl->finished = true;
+    _impl->run(string_view(), Z_FINISH);
+    _impl->hand_off();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// decompressor                                                                                                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/** The state of inflating a stream of gzip or zlib data, shared by \c decompressor and \c decompress_streambuf. **/
+class inflater
+{
+public:
+    inflater()
+    {
+        // 15 is the largest window; adding 32 detects a gzip or zlib header
+        int rc = inflateInit2(&_stream, 15 + 32);
+        if (rc != Z_OK)
+            throw_zlib_error("Could not start decompressing", _stream, rc);
+    }
+
+    inflater(const inflater&) = delete;
+    inflater& operator=(const inflater&) = delete;
+
+    ~inflater() noexcept
+    {
+        inflateEnd(&_stream);
+    }
+
+    /** Decompress from the \a input (which is advanced past what was used) into \a out.
+     *
+     *  \returns The number of bytes written to \a out, which is only 0 if all of \a input was used.
+    **/
+    std::size_t run(string_view& input, char* out, std::size_t out_size)
+    {
+        std::size_t produced = 0;
+        while (produced < out_size && !input.empty())
+        {
+            if (_ended)
+            {
+                // Another gzip member follows the one which just ended
+                inflateReset(&_stream);
+                _ended = false;
+            }
+
+            std::size_t in_step  = input.size() < zlib_max_step ? input.size() : zlib_max_step;
+            std::size_t out_step = out_size - produced < zlib_max_step ? out_size - produced : zlib_max_step;
+            _stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+            _stream.avail_in  = static_cast<uInt>(in_step);
+            _stream.next_out  = reinterpret_cast<Bytef*>(out + produced);
+            _stream.avail_out = static_cast<uInt>(out_step);
+
+            int rc = inflate(&_stream, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR)
+                throw_zlib_error("Invalid compressed data", _stream, rc);
+
+            input.remove_prefix(in_step - _stream.avail_in);
+            produced += out_step - _stream.avail_out;
+            if (rc == Z_STREAM_END)
+                _ended = true;
+            else if (rc == Z_BUF_ERROR && _stream.avail_in == in_step && _stream.avail_out == out_step)
+                break;
+        }
+        return produced;
+    }
+
+    /** Is everything given to \c run a complete stream (so far)? **/
+    bool ended() const
+    {
+        return _ended;
+    }
+
+private:
+    z_stream _stream {};
+    bool     _ended = false;
+};
+
+}
+
+struct decompressor::impl
+{
+    impl(flush_function output, std::size_t chunk_size) :
+            output(std::move(output)),
+            buffer(chunk_size == 0 ? 1 : chunk_size)
+    { }
+
+    flush_function    output;
+    std::vector<char> buffer;
+    inflater          state;
+    bool              started = false;
+};
+
+decompressor::decompressor(flush_function output, std::size_t chunk_size) :
+        _impl(new impl(std::move(output), chunk_size))
+{ }
+
+decompressor::~decompressor() noexcept = default;
+
+void decompressor::write(string_view compressed)
+{
+    _impl->started = _impl->started || !compressed.empty();
+    while (!compressed.empty())
+    {
+        std::size_t produced = _impl->state.run(compressed, _impl->buffer.data(), _impl->buffer.size());
+        if (produced > 0)
+            _impl->output(string_view(_impl->buffer.data(), produced));
+        else if (!compressed.empty())
+            throw std::runtime_error("Invalid compressed data: no progress could be made");
+    }
+}
+
+void decompressor::finish()
+{
+    if (!_impl->started || !_impl->state.ended())
+        throw std::runtime_error("Compressed data ended unexpectedly");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// decompress_streambuf                                                                                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct decompress_streambuf::impl
+{
+    impl(std::istream& source, std::size_t chunk_size) :
+            source(source),
+            input(chunk_size == 0 ? 1 : chunk_size),
+            output(chunk_size == 0 ? 1 : chunk_size)
+    { }
+
+    std::istream&     source;
+    std::vector<char> input;
+    string_view       pending;  //!< The part of \c input which has not been decompressed yet
+    std::vector<char> output;
+    inflater          state;
+    bool              started = false;
+};
+
+decompress_streambuf::decompress_streambuf(std::istream& source, std::size_t chunk_size) :
+        _impl(new impl(source, chunk_size))
+{ }
+
+decompress_streambuf::~decompress_streambuf() noexcept = default;
+
+decompress_streambuf::int_type decompress_streambuf::underflow()
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    while (true)
+    {
+        if (_impl->pending.empty())
+        {
+            _impl->source.read(_impl->input.data(), std::streamsize(_impl->input.size()));
+            std::size_t got = std::size_t(_impl->source.gcount());
+            if (got == 0)
+            {
+                if (_impl->started && _impl->state.ended())
+                    return traits_type::eof();
+                else
+                    throw std::runtime_error("Compressed data ended unexpectedly");
+            }
+            _impl->pending = string_view(_impl->input.data(), got);
+            _impl->started = true;
+        }
+
+        std::size_t produced = _impl->state.run(_impl->pending, _impl->output.data(), _impl->output.size());
+        if (produced > 0)
+        {
+            char* begin = _impl->output.data();
+            setg(begin, begin, begin + produced);
+            return traits_type::to_int_type(*begin);
+        }
+        else if (!_impl->pending.empty())
+        {
+            throw std::runtime_error("Invalid compressed data: no progress could be made");
+        }
+    }
+}
+
+#else
+
+static const char zlib_missing[] = "json-voorhees was built without zlib, so compression is not available";
+
+struct compressor::impl
+{ };
+
+compressor::compressor(flush_function, compression, int, std::size_t)
+{
+    throw std::runtime_error(zlib_missing);
+}
+
+compressor::~compressor() noexcept = default;
+
+void compressor::write(string_view)
+{ }
+
+void compressor::flush()
+{ }
+
+void compressor::finish()
+{ }
+
+struct decompressor::impl
+{ };
+
+decompressor::decompressor(flush_function, std::size_t)
+{
+    throw std::runtime_error(zlib_missing);
+}
+
+decompressor::~decompressor() noexcept = default;
+
+void decompressor::write(string_view)
+{ }
+
+void decompressor::finish()
+{ }
+
+struct decompress_streambuf::impl
+{ };
+
+decompress_streambuf::decompress_streambuf(std::istream&, std::size_t)
+{
+    throw std::runtime_error(zlib_missing);
+}
+
+decompress_streambuf::~decompress_streambuf() noexcept = default;
+
+decompress_streambuf::int_type decompress_streambuf::underflow()
+{
+    return traits_type::eof();
+}
+
+#endif
+
+}
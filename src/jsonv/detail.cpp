@@ -61,15 +61,12 @@ bool kind_valid(kind k)
     }
 }
 
-void check_type(kind expected, kind actual)
+void detail::throw_kind_error(kind expected, kind actual)
 {
-    if (expected != actual)
-    {
-        std::ostringstream stream;
-        stream << "Unexpected type: expected " << kind_desc(expected)
-               << " but found " << kind_desc(actual) << ".";
-        throw kind_error(stream.str());
-    }
+    std::ostringstream stream;
+    stream << "Unexpected type: expected " << kind_desc(expected)
+           << " but found " << kind_desc(actual) << ".";
+    throw kind_error(stream.str());
 }
 
 void check_type(std::initializer_list<kind> expected, kind actual)
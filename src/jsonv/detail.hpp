@@ -13,33 +13,235 @@
 
 #include <jsonv/value.hpp>
 #include <jsonv/string_view.hpp>
+#include <jsonv/detail/node_pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
 
 namespace jsonv
 {
 namespace detail
 {
 
+/** The base of the storage behind objects, arrays and strings. Storage which has been made shareable (by
+ *  \c value::make_shareable) is reference-counted: copying a value which refers to it only bumps the count, and
+ *  changing it gives the changed value a storage of its own first (see \c unshare).
+**/
 template <typename T>
-struct cloneable
+struct cloneable :
+        public pooled_node
 {
+    cloneable() = default;
+    
+    /** A copy is not shared with anything. **/
+    cloneable(const cloneable&) noexcept
+    { }
+    
+    cloneable& operator=(const cloneable&) = delete;
+    
     T* clone() const
     {
         return new T(*static_cast<const T*>(this));
     }
+    
+    /** Get the storage for a new copy of the value referring to this -- this instance if it is shareable. **/
+    T* share() const
+    {
+        if (!_shareable.load(std::memory_order_relaxed))
+            return clone();
+        
+        _refs.fetch_add(1, std::memory_order_relaxed);
+        return const_cast<T*>(static_cast<const T*>(this));
+    }
+    
+    /** Is this referred to by more than one value? **/
+    bool shared() const
+    {
+        return _refs.load(std::memory_order_acquire) != 1;
+    }
+    
+    /** Drop a reference to this, deleting it if it was the last one. **/
+    void release() noexcept
+    {
+        // The value being destroyed is the only one which can make new references, so a count of 1 can not go up
+        if (!shared() || _refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete static_cast<T*>(this);
+    }
+    
+    mutable std::atomic<std::size_t> _refs      {1};
+    std::atomic<bool>                _shareable {false};
+    /** The hash of the value, kept while the storage is shareable (and so can not change). 0 if it is not known. **/
+    mutable std::atomic<std::size_t> _hash      {0};
+    
+    /** Forget everything remembered about the contents, since they are about to change. **/
+    void forget_cached() noexcept
+    {
+        _hash.store(0, std::memory_order_relaxed);
+    }
 };
 
+/** Text worked out from the contents of an object or array, such as its canonical encoding. It is only kept while the
+ *  storage is shareable (like \c cloneable::_hash), so several threads may work it out at once: the first one to
+ *  finish is kept and the others are thrown away. A copy of the storage does not have it.
+**/
+class cached_text
+{
+public:
+    cached_text() = default;
+    
+    cached_text(const cached_text&) noexcept
+    { }
+    
+    cached_text& operator=(const cached_text&) = delete;
+    
+    ~cached_text() noexcept
+    {
+        delete _text.load(std::memory_order_relaxed);
+    }
+    
+    /** The kept text or \c nullptr if there is none. **/
+    const std::string* get() const
+    {
+        return _text.load(std::memory_order_acquire);
+    }
+    
+    /** Keep \a text, unless another thread has already kept one.
+     *  
+     *  \returns The kept text.
+    **/
+    const std::string& set(std::string text) const
+    {
+        std::unique_ptr<std::string> created(new std::string(std::move(text)));
+        std::string*                 kept = nullptr;
+        if (_text.compare_exchange_strong(kept, created.get(), std::memory_order_acq_rel))
+            kept = created.release();
+        return *kept;
+    }
+    
+    /** Forget the text. This is only safe when nothing else refers to the storage (see \c unshare). **/
+    void reset() noexcept
+    {
+        delete _text.exchange(nullptr, std::memory_order_relaxed);
+    }
+    
+private:
+    mutable std::atomic<std::string*> _text {nullptr};
+};
+
+/** Make sure the storage \a impl is not shared with another value before changing it, copying it if it is. Either
+ *  way, \a impl no longer has a cached hash (or encoding).
+ *  
+ *  \returns \c true if \a impl was replaced with a copy.
+**/
+template <typename T>
+bool unshare(T*& impl)
+{
+    if (!impl->shared())
+    {
+        impl->forget_cached();
+        return false;
+    }
+    
+    T* copy = impl->clone();
+    copy->forget_cached();
+    impl->release();
+    impl = copy;
+    return true;
+}
+
+/** Like \c unshare, but also stop \a impl from being shared again. This is used before giving out a reference or
+ *  iterator into the storage, since a copy must not see changes made through it.
+**/
+template <typename T>
+T* pin(T*& impl)
+{
+    unshare(impl);
+    impl->_shareable.store(false, std::memory_order_relaxed);
+    return impl;
+}
+
 class string_impl :
         public cloneable<string_impl>
 {
+public:
+    string_impl() = default;
+    
+    /** Copies of a borrowed string refer to the same memory (and share its owner). **/
+    string_impl(const string_impl& src) :
+            cloneable<string_impl>(src),
+            _string(src._string),
+            _borrowed(src._borrowed),
+            _owner(src._owner)
+    { }
+    
+    /** Refer to \a contents instead of holding a copy of it. If \a owner is set, it keeps \a contents alive. **/
+    string_impl(string_view contents, std::shared_ptr<const void> owner) :
+            _borrowed(contents),
+            _owner(std::move(owner))
+    { }
+    
+    ~string_impl() noexcept
+    {
+        delete _copy.load(std::memory_order_relaxed);
+    }
+    
+    string_impl& operator=(const string_impl&) = delete;
+    
+    string_view view() const
+    {
+        return _borrowed.data() ? _borrowed : string_view(_string);
+    }
+    
+    /** Get the contents as an \c std::string. A borrowed string is copied the first time this is called. This is safe to
+     *  call from multiple threads -- if they race, one copy wins and the others are thrown away.
+    **/
+    const std::string& str() const
+    {
+        if (!_borrowed.data())
+            return _string;
+        
+        std::string* copy = _copy.load(std::memory_order_acquire);
+        if (!copy)
+        {
+            std::unique_ptr<std::string> created(new std::string(_borrowed.data(), _borrowed.size()));
+            if (_copy.compare_exchange_strong(copy, created.get(), std::memory_order_acq_rel))
+                copy = created.release();
+        }
+        return *copy;
+    }
+    
+    /** Does this refer to memory it does not own (instead of holding the contents in \c _string)? **/
+    bool borrowed() const
+    {
+        return _borrowed.data() != nullptr;
+    }
+    
+    /** Add the heap memory held by this string (not including this instance) to \a bytes and \a allocations. **/
+    void add_memory_usage(std::size_t& bytes, std::size_t& allocations) const;
+    
 public:
     std::string _string;
+    
+private:
+    string_view                       _borrowed;
+    std::shared_ptr<const void>       _owner;
+    mutable std::atomic<std::string*> _copy {nullptr};
 };
 
 }
 
 const char* kind_desc(kind type);
 bool kind_valid(kind k);
-void check_type(kind expected, kind actual);
+
+inline void check_type(kind expected, kind actual)
+{
+    if (expected != actual)
+        detail::throw_kind_error(expected, actual);
+}
+
 void check_type(std::initializer_list<kind> expected, kind actual);
 std::ostream& stream_escaped_string(std::ostream& stream, string_view str, bool require_ascii);
 std::ostream& stream_escaped_iso_string(std::ostream& stream, string_view str);
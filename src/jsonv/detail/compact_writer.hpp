@@ -0,0 +1,143 @@
+/** \file jsonv/detail/compact_writer.hpp
+ *  The \c encode_static writer for compact JSON text.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_COMPACT_WRITER_HPP_INCLUDED__
+#define __JSONV_DETAIL_COMPACT_WRITER_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+
+#include "../char_convert.hpp"
+#include "number_convert.hpp"
+#include "output_buffer.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace jsonv
+{
+namespace detail
+{
+
+inline bool is_ascii(string_view text)
+{
+    for (char c : text)
+        if (static_cast<unsigned char>(c) >= 0x80U)
+            return false;
+    return true;
+}
+
+/** Writes compact JSON into an \c output_buffer. This is what \c buffer_encoder writes with; \c to_string uses it
+ *  directly with \c encode_static.
+**/
+class compact_writer
+{
+public:
+    compact_writer(output_buffer& out, bool ensure_ascii) :
+            _out(out),
+            _ensure_ascii(ensure_ascii)
+    { }
+    
+    void write_null()
+    {
+        _out.write("null", 4);
+    }
+    
+    void write_boolean(bool value)
+    {
+        if (value)
+            _out.write("true", 4);
+        else
+            _out.write("false", 5);
+    }
+    
+    void write_integer(std::int64_t value)
+    {
+        char text[max_formatted_integer_length];
+        _out.write(text, format_integer(text, value));
+    }
+    
+    void write_decimal(double value)
+    {
+        if (std::isfinite(value))
+        {
+            char text[max_formatted_decimal_length];
+            _out.write(text, format_decimal(text, value));
+        }
+        else
+        {
+            // non-finite values do not have valid JSON representations, so put it as null
+            write_null();
+        }
+    }
+    
+    void write_string(string_view value)
+    {
+        _out.put('"');
+        string_encode(_out, value, _ensure_ascii);
+        _out.put('"');
+    }
+    
+    void write_array_begin(std::size_t = 0)
+    {
+        _out.put('[');
+    }
+    
+    void write_array_delimiter()
+    {
+        _out.put(',');
+    }
+    
+    void write_array_end()
+    {
+        _out.put(']');
+    }
+    
+    void write_object_begin(std::size_t = 0)
+    {
+        _out.put('{');
+    }
+    
+    void write_object_key(string_view key)
+    {
+        write_string(key);
+        _out.put(':');
+    }
+    
+    void write_object_delimiter()
+    {
+        _out.put(',');
+    }
+    
+    void write_object_end()
+    {
+        _out.put('}');
+    }
+    
+    bool write_raw_json(string_view text)
+    {
+        if (_ensure_ascii && !is_ascii(text))
+            return false;
+        
+        _out.write(text.data(), text.size());
+        return true;
+    }
+    
+private:
+    output_buffer& _out;
+    bool           _ensure_ascii;
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_COMPACT_WRITER_HPP_INCLUDED__*/
@@ -0,0 +1,152 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "file_mapping.hpp"
+
+#include <cerrno>
+#include <system_error>
+
+#if defined(_WIN32)
+#   define JSONV_FILE_MAPPING_WINDOWS 1
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#   define JSONV_FILE_MAPPING_POSIX 1
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#else
+#   include <fstream>
+#   include <sstream>
+#endif
+
+namespace jsonv
+{
+namespace detail
+{
+
+#if JSONV_FILE_MAPPING_POSIX
+
+file_mapping::file_mapping(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Could not open \"" + path + "\"");
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "Could not stat \"" + path + "\"");
+    }
+
+    // Mapping an empty file fails, but there is nothing to map anyway
+    if (info.st_size > 0)
+    {
+        std::size_t size = std::size_t(info.st_size);
+        void*       addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "Could not map \"" + path + "\"");
+        }
+#   if defined(MADV_SEQUENTIAL)
+        ::madvise(addr, size, MADV_SEQUENTIAL);
+#   endif
+        _contents = string_view(static_cast<const char*>(addr), size);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+file_mapping::~file_mapping() noexcept
+{
+    if (!_contents.empty())
+        ::munmap(const_cast<char*>(_contents.data()), _contents.size());
+}
+
+#elif JSONV_FILE_MAPPING_WINDOWS
+
+file_mapping::file_mapping(const std::string& path) :
+        _file(INVALID_HANDLE_VALUE),
+        _mapping(nullptr)
+{
+    auto fail = [&] (const char* what)
+                {
+                    int err = int(::GetLastError());
+                    release();
+                    throw std::system_error(err, std::system_category(), what + (" \"" + path + "\""));
+                };
+
+    _file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                          FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+                         );
+    if (_file == INVALID_HANDLE_VALUE)
+        fail("Could not open");
+
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(_file, &size))
+        fail("Could not get the size of");
+
+    if (size.QuadPart > 0)
+    {
+        _mapping = ::CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_mapping)
+            fail("Could not map");
+
+        const void* addr = ::MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!addr)
+            fail("Could not map");
+        _contents = string_view(static_cast<const char*>(addr), std::size_t(size.QuadPart));
+    }
+}
+
+file_mapping::~file_mapping() noexcept
+{
+    release();
+}
+
+void file_mapping::release() noexcept
+{
+    if (!_contents.empty())
+        ::UnmapViewOfFile(_contents.data());
+    if (_mapping)
+        ::CloseHandle(_mapping);
+    if (_file != INVALID_HANDLE_VALUE)
+        ::CloseHandle(_file);
+    _contents = string_view();
+    _mapping  = nullptr;
+    _file     = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+file_mapping::file_mapping(const std::string& path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+        throw std::system_error(errno, std::generic_category(), "Could not open \"" + path + "\"");
+
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    _buffer   = buffer.str();
+    _contents = _buffer;
+}
+
+file_mapping::~file_mapping() noexcept = default;
+
+#endif
+
+}
+}
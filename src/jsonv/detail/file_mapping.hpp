@@ -0,0 +1,65 @@
+/** \file jsonv/detail/file_mapping.hpp
+ *  A read-only memory mapping of an entire file.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_FILE_MAPPING_HPP_INCLUDED__
+#define __JSONV_DETAIL_FILE_MAPPING_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <string>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Maps the contents of a file into memory with \c mmap (or \c MapViewOfFile on Windows). On platforms without either,
+ *  the file is read into memory instead.
+**/
+class JSONV_LOCAL file_mapping
+{
+public:
+    /** Map the file at \a path.
+     *
+     *  \throws std::system_error if the file could not be opened or mapped.
+    **/
+    explicit file_mapping(const std::string& path);
+
+    file_mapping(const file_mapping&) = delete;
+    file_mapping& operator=(const file_mapping&) = delete;
+
+    ~file_mapping() noexcept;
+
+    /** The contents of the file. **/
+    string_view contents() const
+    {
+        return _contents;
+    }
+
+private:
+#if defined(_WIN32)
+    void release() noexcept;
+#endif
+
+private:
+    string_view _contents;
+    std::string _buffer;    //!< When the file can not be mapped, its contents.
+#if defined(_WIN32)
+    void*       _file;
+    void*       _mapping;
+#endif
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_FILE_MAPPING_HPP_INCLUDED__*/
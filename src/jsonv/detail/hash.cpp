@@ -0,0 +1,108 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "hash.hpp"
+
+#include <cstring>
+
+namespace jsonv
+{
+namespace detail
+{
+
+static constexpr std::uint64_t secret0 = 0xa0761d6478bd642fULL;
+static constexpr std::uint64_t secret1 = 0xe7037ed1a0b428dbULL;
+static constexpr std::uint64_t secret2 = 0x8ebc6af09c88c6e3ULL;
+static constexpr std::uint64_t secret3 = 0x589965cc75374cc3ULL;
+
+// The reads are done with memcpy, which compilers turn into a single unaligned load. The hash is only used within a
+// process, so it does not matter that it comes out differently on big-endian machines.
+
+static std::uint64_t read64(const char* p)
+{
+    std::uint64_t x;
+    std::memcpy(&x, p, sizeof x);
+    return x;
+}
+
+static std::uint64_t read32(const char* p)
+{
+    std::uint32_t x;
+    std::memcpy(&x, p, sizeof x);
+    return x;
+}
+
+static std::uint64_t read_small(const char* p, std::size_t length)
+{
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return (std::uint64_t(u[0]) << 16) | (std::uint64_t(u[length >> 1]) << 8) | u[length - 1];
+}
+
+std::uint64_t hash_bytes(const char* data, std::size_t length, std::uint64_t seed)
+{
+    const char*   p = data;
+    std::uint64_t a;
+    std::uint64_t b;
+    seed ^= hash_mix(seed ^ secret0, secret1);
+    
+    if (length <= 16)
+    {
+        if (length >= 4)
+        {
+            // two overlapping reads from each end cover every byte
+            std::size_t step = (length >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + step);
+            b = (read32(p + length - 4) << 32) | read32(p + length - 4 - step);
+        }
+        else if (length > 0)
+        {
+            a = read_small(p, length);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        std::size_t left = length;
+        if (left > 48)
+        {
+            // three independent lanes so the multiplies can overlap
+            std::uint64_t lane1 = seed;
+            std::uint64_t lane2 = seed;
+            do
+            {
+                seed  = hash_mix(read64(p)      ^ secret1, read64(p + 8)  ^ seed);
+                lane1 = hash_mix(read64(p + 16) ^ secret2, read64(p + 24) ^ lane1);
+                lane2 = hash_mix(read64(p + 32) ^ secret3, read64(p + 40) ^ lane2);
+                p    += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        
+        while (left > 16)
+        {
+            seed  = hash_mix(read64(p) ^ secret1, read64(p + 8) ^ seed);
+            p    += 16;
+            left -= 16;
+        }
+        
+        a = read64(p + left - 16);
+        b = read64(p + left - 8);
+    }
+    
+    return hash_mix(secret1 ^ length, hash_mix(a ^ secret1, b ^ seed));
+}
+
+}
+}
@@ -0,0 +1,67 @@
+/** \file jsonv/detail/hash.hpp
+ *  The mixing functions behind \c std::hash<jsonv::value>.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_HASH_HPP_INCLUDED__
+#define __JSONV_DETAIL_HASH_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#   include <intrin.h>
+#endif
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Combine \a a and \a b into a well-distributed 64-bit value by folding the two halves of their 128-bit product
+ *  together (the mixing step of wyhash).
+**/
+inline std::uint64_t hash_mix(std::uint64_t a, std::uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 product = static_cast<uint128>(a) * b;
+    return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    std::uint64_t high;
+    std::uint64_t low = _umul128(a, b, &high);
+    return low ^ high;
+#else
+    std::uint64_t ha = a >> 32, la = a & 0xffffffffULL;
+    std::uint64_t hb = b >> 32, lb = b & 0xffffffffULL;
+    std::uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    std::uint64_t mid  = (ll >> 32) + (hl & 0xffffffffULL) + (lh & 0xffffffffULL);
+    std::uint64_t low  = (mid << 32) | (ll & 0xffffffffULL);
+    std::uint64_t high = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+    return low ^ high;
+#endif
+}
+
+/** Combine the hash \a x with \a y. Unlike \c hash_mix, this is safe to use with small or zero inputs. The result depends
+ *  on the order of the arguments.
+**/
+inline std::uint64_t hash_combine(std::uint64_t x, std::uint64_t y)
+{
+    return hash_mix(x ^ 0xa0761d6478bd642fULL, y ^ 0xe7037ed1a0b428dbULL);
+}
+
+/** Hash the \a length bytes starting at \a data. Different \a seed values give unrelated hashes for the same bytes. **/
+std::uint64_t hash_bytes(const char* data, std::size_t length, std::uint64_t seed);
+
+}
+}
+
+#endif/*__JSONV_DETAIL_HASH_HPP_INCLUDED__*/
@@ -0,0 +1,135 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "node_pool.hpp"
+
+#include <new>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Blocks are rounded up to a multiple of this, which is enough to keep everything suitably aligned. **/
+static constexpr std::size_t size_granularity = 16;
+
+/** Anything larger than this is not worth recycling and goes straight to the global heap. This is large enough for
+ *  the elements of arrays with up to 32 values.
+**/
+static constexpr std::size_t max_pooled_size = 512;
+
+static constexpr std::size_t size_class_count = max_pooled_size / size_granularity;
+
+/** Each size class keeps at most this many bytes of free blocks, so a thread which frees a huge tree does not hold on
+ *  to all of its memory forever.
+**/
+static constexpr std::size_t max_cached_bytes = 256 * 1024;
+
+namespace
+{
+
+struct free_block
+{
+    free_block* next;
+};
+
+/** The free lists of a thread. This is trivially destructible so it can still be looked at (by values destroyed during
+ *  static destruction, for example) after \c cache_guard has emptied it.
+**/
+struct thread_cache
+{
+    free_block* heads[size_class_count];
+    std::size_t counts[size_class_count];
+    bool        registered;
+    bool        closed;         //!< Set once the thread is exiting -- everything goes to the global heap after that.
+};
+
+thread_local thread_cache cache = {};
+
+/** Returns the cached blocks of a thread to the global heap when it exits. **/
+struct cache_guard
+{
+    ~cache_guard() noexcept
+    {
+        cache.closed = true;
+        for (std::size_t idx = 0; idx < size_class_count; ++idx)
+        {
+            while (free_block* block = cache.heads[idx])
+            {
+                cache.heads[idx] = block->next;
+                ::operator delete(block);
+            }
+            cache.counts[idx] = 0;
+        }
+    }
+};
+
+thread_local cache_guard guard;
+
+}
+
+static std::size_t size_class(std::size_t size)
+{
+    return (size + size_granularity - 1) / size_granularity - 1;
+}
+
+void* node_allocate(std::size_t size)
+{
+    if (size == 0 || size > max_pooled_size)
+        return ::operator new(size);
+
+    // Even once this thread's cache is closed, the block has the full size of its class: another thread can still put
+    // it on a free list, which hands it out for anything up to that size.
+    std::size_t cls = size_class(size);
+    if (cache.closed)
+        return ::operator new((cls + 1) * size_granularity);
+
+    if (free_block* block = cache.heads[cls])
+    {
+        cache.heads[cls] = block->next;
+        --cache.counts[cls];
+        return block;
+    }
+
+    if (!cache.registered)
+    {
+        // touch the guard so it gets destroyed when this thread exits
+        (void) &guard;
+        cache.registered = true;
+    }
+    return ::operator new((cls + 1) * size_granularity);
+}
+
+void node_deallocate(void* p, std::size_t size) noexcept
+{
+    if (!p)
+        return;
+
+    if (size == 0 || size > max_pooled_size || cache.closed || !cache.registered)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    std::size_t cls = size_class(size);
+    if (cache.counts[cls] * (cls + 1) * size_granularity >= max_cached_bytes)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    free_block* block = static_cast<free_block*>(p);
+    block->next       = cache.heads[cls];
+    cache.heads[cls]  = block;
+    ++cache.counts[cls];
+}
+
+}
+}
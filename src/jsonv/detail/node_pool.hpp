@@ -0,0 +1,42 @@
+/** \file jsonv/detail/node_pool.hpp
+ *  Thread-local recycling of the storage behind objects, arrays and strings.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_NODE_POOL_HPP_INCLUDED__
+#define __JSONV_DETAIL_NODE_POOL_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/detail/node_allocator.hpp>
+
+#include <cstddef>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Inherit from this to allocate instances of a class with \c node_allocate. **/
+struct pooled_node
+{
+    static void* operator new(std::size_t size)
+    {
+        return node_allocate(size);
+    }
+
+    static void operator delete(void* p, std::size_t size) noexcept
+    {
+        node_deallocate(p, size);
+    }
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_NODE_POOL_HPP_INCLUDED__*/
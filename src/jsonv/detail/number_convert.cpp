@@ -0,0 +1,371 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "number_convert.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** The most significant digits which are guaranteed to fit in a \c std::uint64_t. **/
+static constexpr int max_mantissa_digits = 19;
+
+/** The largest integer which a \c double can represent along with all of the integers below it. **/
+static constexpr std::uint64_t max_exact_mantissa = std::uint64_t(1) << 53;
+
+/** The largest power of 10 which is exactly representable as a \c double. **/
+static constexpr int max_exact_pow10 = 22;
+
+static const double exact_pow10[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static const std::uint64_t integer_pow10[] =
+{
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+};
+
+// Computing mantissa * 10^exponent with a single rounding is only correct if the intermediate result is not kept with
+// extra precision (as the x87 does)
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+static constexpr bool exact_double_arithmetic = true;
+#else
+static constexpr bool exact_double_arithmetic = false;
+#endif
+
+static bool is_digit(char c)
+{
+    return '0' <= c && c <= '9';
+}
+
+/** Convert with \c std::strtod by writing the digits as an integer with an exponent. Without a decimal point, the
+ *  result does not depend on the locale.
+**/
+static double convert_fallback(bool negative, string_view integer_digits, string_view fraction_digits, long exponent)
+{
+    std::string buffer;
+    buffer.reserve(integer_digits.size() + fraction_digits.size() + 24);
+    if (negative)
+        buffer += '-';
+    buffer.append(integer_digits.data(), integer_digits.size());
+    buffer.append(fraction_digits.data(), fraction_digits.size());
+    buffer += 'e';
+    buffer += std::to_string(exponent - long(fraction_digits.size()));
+    return std::strtod(buffer.c_str(), nullptr);
+}
+
+static number_convert_result convert_decimal(const char* p, const char* end, bool negative, double& decimal)
+{
+    // The exponent is clamped to this magnitude, which is enough to overflow or underflow any number of digits we would
+    // reasonably be given
+    static constexpr long max_exponent = 100000000L;
+    
+    std::uint64_t mantissa      = 0;
+    int           significant   = 0;
+    long          mantissa_exp  = 0;    //!< The power of 10 to multiply the \c mantissa by
+    
+    auto add_digit = [&] (char c, bool fraction)
+                     {
+                         unsigned digit = unsigned(c - '0');
+                         if (mantissa == 0 && digit == 0)
+                         {
+                             if (fraction)
+                                 --mantissa_exp;
+                             return;
+                         }
+                         
+                         if (++significant <= max_mantissa_digits)
+                         {
+                             mantissa = mantissa * 10 + digit;
+                             if (fraction)
+                                 --mantissa_exp;
+                         }
+                         else if (!fraction)
+                         {
+                             ++mantissa_exp;
+                         }
+                     };
+    
+    const char* integer_begin = p;
+    for (; p != end && is_digit(*p); ++p)
+        add_digit(*p, false);
+    string_view integer_digits(integer_begin, std::size_t(p - integer_begin));
+    if (integer_digits.empty())
+        return number_convert_result::invalid;
+    
+    string_view fraction_digits;
+    if (p != end && *p == '.')
+    {
+        const char* fraction_begin = ++p;
+        for (; p != end && is_digit(*p); ++p)
+            add_digit(*p, true);
+        fraction_digits = string_view(fraction_begin, std::size_t(p - fraction_begin));
+        if (fraction_digits.empty())
+            return number_convert_result::invalid;
+    }
+    
+    long exponent = 0;
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool negative_exponent = p != end && *p == '-';
+        if (p != end && (*p == '-' || *p == '+'))
+            ++p;
+        if (p == end || !is_digit(*p))
+            return number_convert_result::invalid;
+        
+        for (; p != end && is_digit(*p); ++p)
+            if (exponent < max_exponent)
+                exponent = exponent * 10 + (*p - '0');
+        if (negative_exponent)
+            exponent = -exponent;
+    }
+    
+    if (p != end)
+        return number_convert_result::invalid;
+    
+    if (mantissa == 0)
+    {
+        decimal = negative ? -0.0 : 0.0;
+        return number_convert_result::decimal;
+    }
+    
+    // Clinger's fast path: when both the mantissa and power of 10 are exactly representable, the correctly-rounded
+    // result is a single multiply or divide.
+    long pow10 = mantissa_exp + exponent;
+    if (exact_double_arithmetic && significant <= max_mantissa_digits && mantissa <= max_exact_mantissa)
+    {
+        if (-max_exact_pow10 <= pow10 && pow10 <= max_exact_pow10)
+        {
+            double value = double(mantissa);
+            value = pow10 < 0 ? value / exact_pow10[-pow10] : value * exact_pow10[pow10];
+            decimal = negative ? -value : value;
+            return number_convert_result::decimal;
+        }
+        
+        // Values like 12e25 can move some of the power of 10 into the mantissa and still be exact
+        long shift = pow10 - max_exact_pow10;
+        if (  0 < shift
+           && shift < long(sizeof integer_pow10 / sizeof integer_pow10[0])
+           && mantissa <= max_exact_mantissa / integer_pow10[shift]
+           )
+        {
+            double value = double(mantissa * integer_pow10[shift]) * exact_pow10[max_exact_pow10];
+            decimal = negative ? -value : value;
+            return number_convert_result::decimal;
+        }
+    }
+    
+    decimal = convert_fallback(negative, integer_digits, fraction_digits, exponent);
+    return number_convert_result::decimal;
+}
+
+number_convert_result convert_number(string_view text, std::int64_t& integer, double& decimal)
+{
+    const char* p   = text.data();
+    const char* end = text.data() + text.size();
+    
+    bool negative = p != end && *p == '-';
+    if (negative)
+        ++p;
+    
+    // Integers are the overwhelmingly common case, so try them first
+    std::uint64_t value    = 0;
+    bool          overflow = false;
+    const char*   digit    = p;
+    for (; digit != end && is_digit(*digit); ++digit)
+    {
+        unsigned x = unsigned(*digit - '0');
+        if (value > (std::numeric_limits<std::uint64_t>::max() - x) / 10)
+            overflow = true;
+        else
+            value = value * 10 + x;
+    }
+    
+    if (digit == end && digit != p && !overflow)
+    {
+        if (!negative)
+        {
+            // For non-negative integer types, the bits of 2^63..2^64-1 are kept -- do not consider it an error, as we can
+            // store the bits properly, but the onus is on the user to know the particular key was in the overflow range.
+            integer = std::int64_t(value);
+            return number_convert_result::integer;
+        }
+        else if (value <= std::uint64_t(std::numeric_limits<std::int64_t>::max()) + 1U)
+        {
+            integer = std::int64_t(0U - value);
+            return number_convert_result::integer;
+        }
+    }
+    
+    // Numbers that do not contain decimals or exponents, but are too large might still be representable as a double
+    return convert_decimal(p, end, negative, decimal);
+}
+
+bool is_number(string_view text)
+{
+    const char* p   = text.data();
+    const char* end = text.data() + text.size();
+    auto skip_digits = [&p, end] ()
+                       {
+                           const char* first = p;
+                           while (p != end && is_digit(*p))
+                               ++p;
+                           return p != first;
+                       };
+    
+    if (p != end && *p == '-')
+        ++p;
+    if (!skip_digits())
+        return false;
+    if (p != end && *p == '.')
+    {
+        ++p;
+        if (!skip_digits())
+            return false;
+    }
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        if (p != end && (*p == '-' || *p == '+'))
+            ++p;
+        if (!skip_digits())
+            return false;
+    }
+    return p == end;
+}
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+std::size_t format_integer(char* out, std::int64_t value)
+{
+    char  digits[max_formatted_integer_length];
+    char* first = digits + sizeof digits;
+    
+    // Negating in unsigned arithmetic keeps -2^63 from overflowing
+    std::uint64_t magnitude = value < 0 ? 0U - std::uint64_t(value) : std::uint64_t(value);
+    while (magnitude >= 100)
+    {
+        unsigned pair = unsigned(magnitude % 100) * 2;
+        magnitude /= 100;
+        *--first = digit_pairs[pair + 1];
+        *--first = digit_pairs[pair];
+    }
+    if (magnitude >= 10)
+    {
+        unsigned pair = unsigned(magnitude) * 2;
+        *--first = digit_pairs[pair + 1];
+        *--first = digit_pairs[pair];
+    }
+    else
+    {
+        *--first = char('0' + magnitude);
+    }
+    if (value < 0)
+        *--first = '-';
+    
+    std::size_t length = std::size_t(digits + sizeof digits - first);
+    std::memcpy(out, first, length);
+    return length;
+}
+
+/** The number of significant digits which is always enough to convert a \c double to text and back exactly. **/
+static constexpr int max_round_trip_digits = 17;
+
+/** Format \a value with \a precision significant digits, as \c "%g" does, and check if it converts back to \a value.
+ *  
+ *  \returns The length of the text if it does or \c 0 if it does not.
+**/
+static std::size_t format_decimal_with(char* out, double value, int precision)
+{
+    int length = std::snprintf(out, max_formatted_decimal_length, "%.*g", precision, value);
+    if (length <= 0 || std::size_t(length) >= max_formatted_decimal_length)
+        return 0;
+    
+    // A locale with a different decimal point would produce JSON nothing could read
+    for (int idx = 0; idx < length; ++idx)
+        if (out[idx] == ',')
+            out[idx] = '.';
+    
+    std::int64_t integer;
+    double       decimal;
+    switch (convert_number(string_view(out, std::size_t(length)), integer, decimal))
+    {
+    case number_convert_result::integer:
+        return double(integer) == value ? std::size_t(length) : 0;
+    case number_convert_result::decimal:
+        return decimal == value ? std::size_t(length) : 0;
+    default:
+        return 0;
+    }
+}
+
+std::size_t format_decimal(char* out, double value)
+{
+    // Whole numbers which a double holds exactly are by far the most common case and their digits are the shortest form
+    if (-9007199254740992.0 <= value && value <= 9007199254740992.0 && value == double(std::int64_t(value))
+       && !(value == 0.0 && std::signbit(value))
+       )
+        return format_integer(out, std::int64_t(value));
+    
+    // Every decimal with at most DBL_DIG significant digits survives a trip through a normal double, so if any text of
+    // that length gives back value, it is the one "%.15g" rounds to (with trailing zeros removed). If it does not, the
+    // only candidates need more digits: rounding to 16 is the closest 16-digit text and 17 digits always works.
+    // Subnormals have fewer bits of precision, so they need to check every length.
+    int precision = std::fabs(value) < DBL_MIN ? 1 : DBL_DIG;
+    for (; precision < max_round_trip_digits; ++precision)
+        if (std::size_t length = format_decimal_with(out, value, precision))
+            return length;
+    
+    int length = std::snprintf(out, max_formatted_decimal_length, "%.*g", max_round_trip_digits, value);
+    for (int idx = 0; idx < length; ++idx)
+        if (out[idx] == ',')
+            out[idx] = '.';
+    return std::size_t(length);
+}
+
+}
+}
@@ -0,0 +1,75 @@
+/** \file jsonv/detail/number_convert.hpp
+ *  Conversion between the text of JSON numbers and integers and doubles.
+ *  
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_NUMBER_CONVERT_HPP_INCLUDED__
+#define __JSONV_DETAIL_NUMBER_CONVERT_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** The result of \c convert_number. **/
+enum class number_convert_result : unsigned char
+{
+    integer,
+    decimal,
+    invalid,
+};
+
+/** Convert the \a text of a number token (as matched by the tokenizer: an optional \c -, digits, an optional fraction
+ *  and an optional exponent) without looking at anything outside of \a text.
+ *  
+ *  Tokens without a fraction or exponent are integers. Non-negative integers up to \c 2^64-1 are stored with the same
+ *  bits in \a integer (so values from \c 2^63 wrap to negative numbers) and negative integers down to \c -2^63 are
+ *  stored exactly. Integers outside of that range and everything else are converted to the nearest \c double, which
+ *  does not depend on the current locale. The common case of at most 19 significant digits and small exponents is
+ *  computed exactly with a single floating-point operation; others fall back to \c std::strtod on a copy of the digits
+ *  written without a decimal point.
+ *  
+ *  \returns Which of \a integer or \a decimal was set, or \c invalid if \a text is not a number.
+**/
+number_convert_result convert_number(string_view text, std::int64_t& integer, double& decimal);
+
+/** Would \c convert_number accept \a text? This only checks the syntax, so it is much cheaper than converting. **/
+bool is_number(string_view text);
+
+/** The most characters \c format_integer will write. **/
+static constexpr std::size_t max_formatted_integer_length = 20;
+
+/** The most characters \c format_decimal will write. **/
+static constexpr std::size_t max_formatted_decimal_length = 32;
+
+/** Write the decimal digits of \a value (with a leading \c - for negative values) to \a out, which must have room for
+ *  \c max_formatted_integer_length characters.
+ *  
+ *  \returns The number of characters written.
+**/
+std::size_t format_integer(char* out, std::int64_t value);
+
+/** Write the shortest text which \c convert_number will turn back into exactly \a value to \a out, which must have
+ *  room for \c max_formatted_decimal_length characters. The text looks like what \c printf's \c "%g" produces (so
+ *  \c 0.1, \c 3 or \c 1e+300) and does not depend on the current locale. \a value must be finite.
+ *  
+ *  \returns The number of characters written.
+**/
+std::size_t format_decimal(char* out, double value);
+
+}
+}
+
+#endif/*__JSONV_DETAIL_NUMBER_CONVERT_HPP_INCLUDED__*/
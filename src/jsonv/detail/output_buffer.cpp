@@ -0,0 +1,70 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "output_buffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace jsonv
+{
+namespace detail
+{
+
+output_buffer::output_buffer(char* buffer, std::size_t size, flush_function flush) :
+        _begin(buffer),
+        _current(buffer),
+        _end(buffer + size),
+        _flush(std::move(flush))
+{ }
+
+output_buffer::output_buffer(std::size_t chunk_size, flush_function flush) :
+        _owned(new char[chunk_size]),
+        _begin(_owned.get()),
+        _current(_begin),
+        _end(_begin + chunk_size),
+        _flush(std::move(flush))
+{ }
+
+void output_buffer::flush()
+{
+    if (!_flush || _current == _begin)
+        return;
+
+    // reset first, so a flush function which throws does not get the same characters again
+    string_view contents(_begin, size());
+    _current = _begin;
+    _flush(contents);
+}
+
+void output_buffer::overflow()
+{
+    if (!_flush)
+        throw std::length_error("Output does not fit in the buffer");
+    flush();
+}
+
+void output_buffer::write_long(const char* data, std::size_t length)
+{
+    while (length > 0)
+    {
+        if (_current == _end)
+            overflow();
+
+        std::size_t count = std::min(length, std::size_t(_end - _current));
+        std::memcpy(_current, data, count);
+        _current += count;
+        data     += count;
+        length   -= count;
+    }
+}
+
+}
+}
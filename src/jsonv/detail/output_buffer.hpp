@@ -0,0 +1,127 @@
+/** \file jsonv/detail/output_buffer.hpp
+ *  A block of characters which is handed off to a callback when it fills up.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_OUTPUT_BUFFER_HPP_INCLUDED__
+#define __JSONV_DETAIL_OUTPUT_BUFFER_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Collects output in a block of memory, giving the contents of the block to a flush function whenever it fills up.
+ *  This has the \c put and \c write members of \c std::ostream, so the same code can write to either, but writing a
+ *  character is only a compare and a store.
+**/
+class output_buffer
+{
+public:
+    using flush_function = std::function<void (string_view)>;
+
+public:
+    /** Write into the \a size bytes at \a buffer. If \a flush is empty, running out of room throws
+     *  \c std::length_error.
+    **/
+    output_buffer(char* buffer, std::size_t size, flush_function flush);
+
+    /** Write into an owned block of \a chunk_size bytes. **/
+    output_buffer(std::size_t chunk_size, flush_function flush);
+
+    output_buffer(const output_buffer&) = delete;
+    output_buffer& operator=(const output_buffer&) = delete;
+
+    void put(char c)
+    {
+        if (_current == _end)
+            overflow();
+        *_current++ = c;
+    }
+
+    void write(const char* data, std::size_t length)
+    {
+        if (length <= std::size_t(_end - _current))
+        {
+            std::memcpy(_current, data, length);
+            _current += length;
+        }
+        else
+        {
+            write_long(data, length);
+        }
+    }
+
+    /** Get room for \a length contiguous characters, flushing first if there is not enough. The caller writes into
+     *  the returned pointer and then calls \c commit with the number of characters it actually used.
+     *
+     *  \a length must not be more than the size of the block.
+    **/
+    char* reserve(std::size_t length)
+    {
+        if (length > std::size_t(_end - _current))
+            overflow();
+        return _current;
+    }
+
+    void commit(std::size_t length)
+    {
+        _current += length;
+    }
+
+    /** The number of characters written since the last flush. **/
+    std::size_t size() const
+    {
+        return std::size_t(_current - _begin);
+    }
+
+    /** Hand everything written so far to the flush function. This does nothing without a flush function. **/
+    void flush();
+
+    /** Throw away everything after the first \a size characters written since the last flush. **/
+    void truncate(std::size_t size)
+    {
+        _current = _begin + size;
+    }
+
+    /** Write into the \a size bytes at \a buffer from now on. Nothing may have been written since the last flush, so
+     *  this is meant to be called by the flush function, to move on to a fresh block while the last is still in use.
+    **/
+    void use_buffer(char* buffer, std::size_t size)
+    {
+        _begin   = buffer;
+        _current = buffer;
+        _end     = buffer + size;
+    }
+
+private:
+    void overflow();
+
+    void write_long(const char* data, std::size_t length);
+
+private:
+    std::unique_ptr<char[]> _owned;
+    char*                   _begin;
+    char*                   _current;
+    char*                   _end;
+    flush_function          _flush;
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_OUTPUT_BUFFER_HPP_INCLUDED__*/
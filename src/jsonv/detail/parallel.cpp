@@ -0,0 +1,91 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "parallel.hpp"
+
+#include <jsonv/detail/scope_exit.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jsonv
+{
+namespace detail
+{
+
+std::size_t resolve_threads(std::size_t threads)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    return std::max(std::size_t(1), threads);
+}
+
+void run_parallel(std::size_t count, std::size_t threads, const std::function<void (std::size_t)>& task)
+{
+    threads = std::min(resolve_threads(threads), count);
+    if (threads <= 1)
+    {
+        for (std::size_t idx = 0; idx < count; ++idx)
+            task(idx);
+        return;
+    }
+
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool>        failed(false);
+    std::mutex               error_lock;
+    std::size_t              error_idx = count;
+    std::exception_ptr       error;
+
+    auto run = [&]
+               {
+                   for (std::size_t idx = next++; idx < count && !failed.load(); idx = next++)
+                   {
+                       try
+                       {
+                           task(idx);
+                       }
+                       catch (...)
+                       {
+                           std::lock_guard<std::mutex> lock(error_lock);
+                           if (idx < error_idx)
+                           {
+                               error_idx = idx;
+                               error     = std::current_exception();
+                           }
+                           failed.store(true);
+                       }
+                   }
+               };
+
+    // The calling thread works on the tasks too
+    {
+        std::vector<std::thread> workers;
+        auto join_workers = on_scope_exit([&workers]
+                                          {
+                                              for (std::thread& worker : workers)
+                                                  worker.join();
+                                          }
+                                         );
+        workers.reserve(threads - 1);
+        for (std::size_t idx = 1; idx < threads; ++idx)
+            workers.emplace_back(run);
+        run();
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+}
+}
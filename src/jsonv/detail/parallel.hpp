@@ -0,0 +1,41 @@
+/** \file jsonv/detail/parallel.hpp
+ *  Running a number of independent tasks on several threads.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_PARALLEL_HPP_INCLUDED__
+#define __JSONV_DETAIL_PARALLEL_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+
+#include <cstddef>
+#include <functional>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Get the number of threads to use when the user asked for \a threads (where 0 means the number of hardware threads).
+ *  The result is at least 1.
+**/
+std::size_t resolve_threads(std::size_t threads);
+
+/** Call \a task with each index in <tt>[0, count)</tt> using up to \a threads threads, including the calling one. Each
+ *  thread takes the next index which has not been started yet, so a thread which gets quick tasks takes more of them.
+ *  
+ *  If a task throws, no more tasks are started. Once every thread has stopped, the exception from the task with the
+ *  lowest index (of the ones which threw) is rethrown.
+**/
+void run_parallel(std::size_t count, std::size_t threads, const std::function<void (std::size_t)>& task);
+
+}
+}
+
+#endif/*__JSONV_DETAIL_PARALLEL_HPP_INCLUDED__*/
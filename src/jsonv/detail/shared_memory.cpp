@@ -0,0 +1,205 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "shared_memory.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+#if defined(_WIN32)
+#   define JSONV_SHARED_MEMORY_WINDOWS 1
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#   define JSONV_SHARED_MEMORY_POSIX 1
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace jsonv
+{
+namespace detail
+{
+
+#if JSONV_SHARED_MEMORY_POSIX
+
+/** POSIX wants names which start with a slash (and have no others). **/
+static std::string posix_name(const std::string& name)
+{
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+shared_memory::shared_memory(const std::string& name, std::size_t size) :
+        _data(nullptr),
+        _size(size)
+{
+    std::string full_name = posix_name(name);
+    int         fd        = ::shm_open(full_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Could not create shared memory \"" + name + "\"");
+
+    auto fail = [&] (const char* what)
+                {
+                    int err = errno;
+                    ::close(fd);
+                    ::shm_unlink(full_name.c_str());
+                    throw std::system_error(err, std::generic_category(), what + (" \"" + name + "\""));
+                };
+
+    if (::ftruncate(fd, off_t(size)) != 0)
+        fail("Could not size shared memory");
+
+    void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+        fail("Could not map shared memory");
+    _data = static_cast<char*>(addr);
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+shared_memory::shared_memory(const std::string& name) :
+        _data(nullptr),
+        _size(0)
+{
+    int fd = ::shm_open(posix_name(name).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Could not open shared memory \"" + name + "\"");
+
+    auto fail = [&] (const char* what)
+                {
+                    int err = errno;
+                    ::close(fd);
+                    throw std::system_error(err, std::generic_category(), what + (" \"" + name + "\""));
+                };
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+        fail("Could not stat shared memory");
+
+    _size = std::size_t(info.st_size);
+    if (_size > 0)
+    {
+        void* addr = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+            fail("Could not map shared memory");
+        _data = static_cast<char*>(addr);
+    }
+
+    ::close(fd);
+}
+
+shared_memory::~shared_memory() noexcept
+{
+    if (_data)
+        ::munmap(_data, _size);
+}
+
+void shared_memory::remove(const std::string& name) noexcept
+{
+    ::shm_unlink(posix_name(name).c_str());
+}
+
+#elif JSONV_SHARED_MEMORY_WINDOWS
+
+shared_memory::shared_memory(const std::string& name, std::size_t size) :
+        _data(nullptr),
+        _size(size),
+        _mapping(nullptr)
+{
+    _mapping = ::CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                    DWORD(std::uint64_t(size) >> 32), DWORD(size & 0xffffffffU), name.c_str()
+                                   );
+    int err = int(::GetLastError());
+    if (_mapping && err == ERROR_ALREADY_EXISTS)
+    {
+        ::CloseHandle(_mapping);
+        throw std::system_error(err, std::system_category(), "Shared memory \"" + name + "\" already exists");
+    }
+    if (!_mapping)
+        throw std::system_error(err, std::system_category(), "Could not create shared memory \"" + name + "\"");
+
+    _data = static_cast<char*>(::MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, size));
+    if (!_data)
+    {
+        err = int(::GetLastError());
+        ::CloseHandle(_mapping);
+        throw std::system_error(err, std::system_category(), "Could not map shared memory \"" + name + "\"");
+    }
+}
+
+shared_memory::shared_memory(const std::string& name) :
+        _data(nullptr),
+        _size(0),
+        _mapping(nullptr)
+{
+    _mapping = ::OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+    if (!_mapping)
+        throw std::system_error(int(::GetLastError()), std::system_category(),
+                                "Could not open shared memory \"" + name + "\""
+                               );
+
+    _data = static_cast<char*>(::MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    MEMORY_BASIC_INFORMATION info;
+    if (!_data || !::VirtualQuery(_data, &info, sizeof info))
+    {
+        int err = int(::GetLastError());
+        if (_data)
+            ::UnmapViewOfFile(_data);
+        ::CloseHandle(_mapping);
+        throw std::system_error(err, std::system_category(), "Could not map shared memory \"" + name + "\"");
+    }
+    // the view is rounded up to a whole page; what is in it says how much of it is used
+    _size = std::size_t(info.RegionSize);
+}
+
+shared_memory::~shared_memory() noexcept
+{
+    if (_data)
+        ::UnmapViewOfFile(_data);
+    if (_mapping)
+        ::CloseHandle(_mapping);
+}
+
+void shared_memory::remove(const std::string&) noexcept
+{ }
+
+#else
+
+shared_memory::shared_memory(const std::string& name, std::size_t) :
+        _data(nullptr),
+        _size(0)
+{
+    throw std::system_error(std::make_error_code(std::errc::function_not_supported),
+                            "Shared memory is not supported on this platform (\"" + name + "\")"
+                           );
+}
+
+shared_memory::shared_memory(const std::string& name) :
+        _data(nullptr),
+        _size(0)
+{
+    throw std::system_error(std::make_error_code(std::errc::function_not_supported),
+                            "Shared memory is not supported on this platform (\"" + name + "\")"
+                           );
+}
+
+shared_memory::~shared_memory() noexcept = default;
+
+void shared_memory::remove(const std::string&) noexcept
+{ }
+
+#endif
+
+}
+}
@@ -0,0 +1,82 @@
+/** \file jsonv/detail/shared_memory.hpp
+ *  Named blocks of memory which several processes on one host can map.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_SHARED_MEMORY_HPP_INCLUDED__
+#define __JSONV_DETAIL_SHARED_MEMORY_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** A named shared-memory segment, mapped into this process with \c shm_open and \c mmap (or \c CreateFileMapping and
+ *  \c MapViewOfFile on Windows). On POSIX systems, the segment exists until \c remove is called with its name; on
+ *  Windows, it exists as long as some process has it open.
+**/
+class JSONV_LOCAL shared_memory
+{
+public:
+    /** Create a new segment called \a name which is \a size bytes long and map it for writing.
+     *
+     *  \throws std::system_error if the segment could not be created (including when one called \a name already exists)
+     *                            or mapped.
+    **/
+    shared_memory(const std::string& name, std::size_t size);
+
+    /** Map the existing segment called \a name for reading.
+     *
+     *  \throws std::system_error if the segment does not exist or could not be mapped.
+    **/
+    explicit shared_memory(const std::string& name);
+
+    shared_memory(const shared_memory&) = delete;
+    shared_memory& operator=(const shared_memory&) = delete;
+
+    ~shared_memory() noexcept;
+
+    /** Remove the name of the segment called \a name, so it can not be opened again. Processes which have it mapped keep
+     *  their mapping. This does nothing on Windows, where the segment goes away with the last handle to it.
+    **/
+    static void remove(const std::string& name) noexcept;
+
+    char* data() const
+    {
+        return _data;
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    string_view contents() const
+    {
+        return string_view(_data, _size);
+    }
+
+private:
+    char*       _data;
+    std::size_t _size;
+#if defined(_WIN32)
+    void*       _mapping;
+#endif
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_SHARED_MEMORY_HPP_INCLUDED__*/
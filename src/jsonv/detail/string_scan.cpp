@@ -0,0 +1,271 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "string_scan.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define JSONV_STRING_SCAN_SSE2 1
+#   include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#   define JSONV_STRING_SCAN_NEON 1
+#   include <arm_neon.h>
+#endif
+
+namespace jsonv
+{
+namespace detail
+{
+
+static constexpr std::size_t chunk_size = 16;
+
+static bool is_special(char c, bool stop_at_high_bytes, bool stop_at_control)
+{
+    auto uc = static_cast<unsigned char>(c);
+    return c == '\\'
+        || (stop_at_high_bytes && uc >= 0x80U)
+        || (stop_at_control && (uc < 0x20U || uc == 0x7fU));
+}
+
+static bool needs_escape(char c)
+{
+    return c < ' ' || '~' < c || c == '\"' || c == '\\' || c == '/';
+}
+
+#if JSONV_STRING_SCAN_SSE2 || JSONV_STRING_SCAN_NEON
+
+static unsigned trailing_zeros(unsigned x)
+{
+#if defined(__GNUC__)
+    return unsigned(__builtin_ctz(x));
+#else
+    unsigned count = 0;
+    for (; !(x & 1U); x >>= 1)
+        ++count;
+    return count;
+#endif
+}
+
+#endif
+
+#if JSONV_STRING_SCAN_SSE2
+
+const char* find_quote_or_backslash(const char* begin, const char* end)
+{
+    const __m128i quote     = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; end - begin >= std::ptrdiff_t(chunk_size); begin += chunk_size)
+    {
+        __m128i  chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        unsigned found = unsigned(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                                 _mm_cmpeq_epi8(chunk, backslash)
+                                                                )
+                                                   )
+                                 );
+        if (found)
+            return begin + trailing_zeros(found);
+    }
+
+    for (; begin != end; ++begin)
+        if (*begin == '\"' || *begin == '\\')
+            return begin;
+    return end;
+}
+
+const char* find_string_special(const char* begin, const char* end, bool stop_at_high_bytes, bool stop_at_control)
+{
+    const __m128i backslash    = _mm_set1_epi8('\\');
+    const __m128i control_max  = _mm_set1_epi8('\x1f');
+    const __m128i delete_char  = _mm_set1_epi8('\x7f');
+    for (; end - begin >= std::ptrdiff_t(chunk_size); begin += chunk_size)
+    {
+        __m128i  chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        unsigned found = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)));
+        if (stop_at_high_bytes)
+            found |= unsigned(_mm_movemask_epi8(chunk));
+        if (stop_at_control)
+        {
+            // chunk <= 0x1f (unsigned) if and only if max(chunk, 0x1f) == 0x1f
+            __m128i control = _mm_or_si128(_mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max),
+                                           _mm_cmpeq_epi8(chunk, delete_char)
+                                          );
+            found |= unsigned(_mm_movemask_epi8(control));
+        }
+        if (found)
+            return begin + trailing_zeros(found);
+    }
+
+    for (; begin != end; ++begin)
+        if (is_special(*begin, stop_at_high_bytes, stop_at_control))
+            return begin;
+    return end;
+}
+
+const char* find_string_escape(const char* begin, const char* end)
+{
+    const __m128i quote       = _mm_set1_epi8('\"');
+    const __m128i backslash   = _mm_set1_epi8('\\');
+    const __m128i slash       = _mm_set1_epi8('/');
+    const __m128i control_max = _mm_set1_epi8('\x1f');
+    const __m128i delete_char = _mm_set1_epi8('\x7f');
+    for (; end - begin >= std::ptrdiff_t(chunk_size); begin += chunk_size)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(chunk, slash), _mm_cmpeq_epi8(chunk, delete_char))
+                                    );
+        match = _mm_or_si128(match, _mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max));
+        // the sign bit of each byte is set for high bytes, which movemask picks up along with the matches
+        unsigned found = unsigned(_mm_movemask_epi8(_mm_or_si128(match, chunk)));
+        if (found)
+            return begin + trailing_zeros(found);
+    }
+
+    for (; begin != end; ++begin)
+        if (needs_escape(*begin))
+            return begin;
+    return end;
+}
+
+const char* find_non_ascii(const char* begin, const char* end)
+{
+    for (; end - begin >= std::ptrdiff_t(chunk_size); begin += chunk_size)
+    {
+        __m128i  chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        unsigned found = unsigned(_mm_movemask_epi8(chunk));
+        if (found)
+            return begin + trailing_zeros(found);
+    }
+
+    for (; begin != end; ++begin)
+        if (static_cast<unsigned char>(*begin) >= 0x80U)
+            return begin;
+    return end;
+}
+
+#elif JSONV_STRING_SCAN_NEON
+
+static unsigned movemask(uint8x16_t x)
+{
+    static const std::uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t masked = vandq_u8(x, vld1q_u8(weights));
+    return unsigned(vaddv_u8(vget_low_u8(masked)))
+         | unsigned(vaddv_u8(vget_high_u8(masked))) << 8;
+}
+
+const char* find_quote_or_backslash(const char* begin, const char* end)
+{
+    for (; end - begin >= std::ptrdiff_t(chunk_size); begin += chunk_size)
+    {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(begin));
+        uint8x16_t match = vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('\"')), vceqq_u8(chunk, vdupq_n_u8('\\')));
+        if (vmaxvq_u8(match))
+            return begin + trailing_zeros(movemask(match));
+    }
+
+    for (; begin != end; ++begin)
+        if (*begin == '\"' || *begin == '\\')
+            return begin;
+    return end;
+}
+
+const char* find_string_special(const char* begin, const char* end, bool stop_at_high_bytes, bool stop_at_control)
+{
+    for (; end - begin >= std::ptrdiff_t(chunk_size); begin += chunk_size)
+    {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(begin));
+        uint8x16_t match = vceqq_u8(chunk, vdupq_n_u8('\\'));
+        if (stop_at_high_bytes)
+            match = vorrq_u8(match, vcgeq_u8(chunk, vdupq_n_u8(0x80)));
+        if (stop_at_control)
+            match = vorrq_u8(match, vorrq_u8(vcltq_u8(chunk, vdupq_n_u8(0x20)), vceqq_u8(chunk, vdupq_n_u8(0x7f))));
+        if (vmaxvq_u8(match))
+            return begin + trailing_zeros(movemask(match));
+    }
+
+    for (; begin != end; ++begin)
+        if (is_special(*begin, stop_at_high_bytes, stop_at_control))
+            return begin;
+    return end;
+}
+
+const char* find_string_escape(const char* begin, const char* end)
+{
+    for (; end - begin >= std::ptrdiff_t(chunk_size); begin += chunk_size)
+    {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(begin));
+        uint8x16_t match = vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('\"')), vceqq_u8(chunk, vdupq_n_u8('\\')));
+        match = vorrq_u8(match, vceqq_u8(chunk, vdupq_n_u8('/')));
+        match = vorrq_u8(match, vorrq_u8(vcltq_u8(chunk, vdupq_n_u8(0x20)), vcgeq_u8(chunk, vdupq_n_u8(0x7f))));
+        if (vmaxvq_u8(match))
+            return begin + trailing_zeros(movemask(match));
+    }
+
+    for (; begin != end; ++begin)
+        if (needs_escape(*begin))
+            return begin;
+    return end;
+}
+
+const char* find_non_ascii(const char* begin, const char* end)
+{
+    for (; end - begin >= std::ptrdiff_t(chunk_size); begin += chunk_size)
+    {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(begin));
+        if (vmaxvq_u8(chunk) >= 0x80U)
+            return begin + trailing_zeros(movemask(vcgeq_u8(chunk, vdupq_n_u8(0x80))));
+    }
+
+    for (; begin != end; ++begin)
+        if (static_cast<unsigned char>(*begin) >= 0x80U)
+            return begin;
+    return end;
+}
+
+#else
+
+const char* find_quote_or_backslash(const char* begin, const char* end)
+{
+    for (; begin != end; ++begin)
+        if (*begin == '\"' || *begin == '\\')
+            return begin;
+    return end;
+}
+
+const char* find_string_special(const char* begin, const char* end, bool stop_at_high_bytes, bool stop_at_control)
+{
+    for (; begin != end; ++begin)
+        if (is_special(*begin, stop_at_high_bytes, stop_at_control))
+            return begin;
+    return end;
+}
+
+const char* find_string_escape(const char* begin, const char* end)
+{
+    for (; begin != end; ++begin)
+        if (needs_escape(*begin))
+            return begin;
+    return end;
+}
+
+const char* find_non_ascii(const char* begin, const char* end)
+{
+    for (; begin != end; ++begin)
+        if (static_cast<unsigned char>(*begin) >= 0x80U)
+            return begin;
+    return end;
+}
+
+#endif
+
+}
+}
@@ -0,0 +1,52 @@
+/** \file jsonv/detail/string_scan.hpp
+ *  Vectorized searches for the bytes that matter when tokenizing, decoding and encoding strings.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_STRING_SCAN_HPP_INCLUDED__
+#define __JSONV_DETAIL_STRING_SCAN_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Find the first quote or backslash in the range from \a begin to \a end.
+ *
+ *  \returns A pointer to the found character or \a end if there is not one.
+**/
+const char* find_quote_or_backslash(const char* begin, const char* end);
+
+/** Find the first character in the range from \a begin to \a end which a string decoder can not copy straight to its
+ *  output: a backslash, a byte with the high bit set (if \a stop_at_high_bytes) or an ASCII control character (if
+ *  \a stop_at_control).
+ *
+ *  \returns A pointer to the found character or \a end if there is not one.
+**/
+const char* find_string_special(const char* begin, const char* end, bool stop_at_high_bytes, bool stop_at_control);
+
+/** Find the first character in the range from \a begin to \a end which a string encoder can not copy straight to its
+ *  output: anything outside of printable ASCII, a quote, a backslash or a forward slash.
+ *
+ *  \returns A pointer to the found character or \a end if there is not one.
+**/
+const char* find_string_escape(const char* begin, const char* end);
+
+/** Find the first byte in the range from \a begin to \a end with the high bit set (the first one which is not ASCII).
+ *
+ *  \returns A pointer to the found character or \a end if there is not one.
+**/
+const char* find_non_ascii(const char* begin, const char* end);
+
+}
+}
+
+#endif/*__JSONV_DETAIL_STRING_SCAN_HPP_INCLUDED__*/
@@ -0,0 +1,244 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "structural_index.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define JSONV_STRUCTURAL_INDEX_SSE2 1
+#   include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#   define JSONV_STRUCTURAL_INDEX_NEON 1
+#   include <arm_neon.h>
+#endif
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Bit masks for a single 64-byte block of input, where bit \c n corresponds to byte \c n of the block. **/
+struct block_masks
+{
+    std::uint64_t quote;
+    std::uint64_t backslash;
+    std::uint64_t structural;
+};
+
+static constexpr std::size_t block_size = 64;
+
+#if JSONV_STRUCTURAL_INDEX_SSE2
+
+static block_masks classify(const char* block)
+{
+    const __m128i quote      = _mm_set1_epi8('\"');
+    const __m128i backslash  = _mm_set1_epi8('\\');
+    const __m128i obj_begin  = _mm_set1_epi8('{');
+    const __m128i obj_end    = _mm_set1_epi8('}');
+    const __m128i arr_begin  = _mm_set1_epi8('[');
+    const __m128i arr_end    = _mm_set1_epi8(']');
+    const __m128i key_delim  = _mm_set1_epi8(':');
+    const __m128i separator  = _mm_set1_epi8(',');
+
+    block_masks out = { 0, 0, 0 };
+    for (std::size_t idx = 0; idx < block_size; idx += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + idx));
+
+        __m128i structural = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, obj_begin),
+                                                       _mm_cmpeq_epi8(chunk, obj_end)
+                                                      ),
+                                          _mm_or_si128(_mm_cmpeq_epi8(chunk, arr_begin),
+                                                       _mm_cmpeq_epi8(chunk, arr_end)
+                                                      )
+                                         );
+        structural = _mm_or_si128(structural,
+                                  _mm_or_si128(_mm_cmpeq_epi8(chunk, key_delim), _mm_cmpeq_epi8(chunk, separator))
+                                 );
+
+        auto bits = [] (__m128i x) { return std::uint64_t(std::uint16_t(_mm_movemask_epi8(x))); };
+        out.quote      |= bits(_mm_cmpeq_epi8(chunk, quote))     << idx;
+        out.backslash  |= bits(_mm_cmpeq_epi8(chunk, backslash)) << idx;
+        out.structural |= bits(structural)                       << idx;
+    }
+    return out;
+}
+
+#elif JSONV_STRUCTURAL_INDEX_NEON
+
+static std::uint64_t movemask(uint8x16_t x)
+{
+    static const std::uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t masked = vandq_u8(x, vld1q_u8(weights));
+    return std::uint64_t(vaddv_u8(vget_low_u8(masked)))
+         | std::uint64_t(vaddv_u8(vget_high_u8(masked))) << 8;
+}
+
+static block_masks classify(const char* block)
+{
+    block_masks out = { 0, 0, 0 };
+    for (std::size_t idx = 0; idx < block_size; idx += 16)
+    {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(block + idx));
+
+        uint8x16_t structural = vorrq_u8(vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('{')), vceqq_u8(chunk, vdupq_n_u8('}'))),
+                                         vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('[')), vceqq_u8(chunk, vdupq_n_u8(']')))
+                                        );
+        structural = vorrq_u8(structural,
+                              vorrq_u8(vceqq_u8(chunk, vdupq_n_u8(':')), vceqq_u8(chunk, vdupq_n_u8(',')))
+                             );
+
+        out.quote      |= movemask(vceqq_u8(chunk, vdupq_n_u8('\"'))) << idx;
+        out.backslash  |= movemask(vceqq_u8(chunk, vdupq_n_u8('\\'))) << idx;
+        out.structural |= movemask(structural)                        << idx;
+    }
+    return out;
+}
+
+#else
+
+static block_masks classify(const char* block)
+{
+    block_masks out = { 0, 0, 0 };
+    for (std::size_t idx = 0; idx < block_size; ++idx)
+    {
+        std::uint64_t bit = std::uint64_t(1) << idx;
+        switch (block[idx])
+        {
+        case '\"':
+            out.quote |= bit;
+            break;
+        case '\\':
+            out.backslash |= bit;
+            break;
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ':':
+        case ',':
+            out.structural |= bit;
+            break;
+        default:
+            break;
+        }
+    }
+    return out;
+}
+
+#endif
+
+static bool add_overflow(std::uint64_t a, std::uint64_t b, std::uint64_t& result)
+{
+    result = a + b;
+    return result < a;
+}
+
+/** Find the characters in the block which are escaped by a backslash. A character is escaped if it is preceded by an
+ *  odd-length run of backslashes. Sequences of backslashes are found with carry propagation: adding the start of each
+ *  run to the run itself clears the run and sets the bit just past its end. Whether or not the final character of the
+ *  block escapes the first character of the next block is carried in \a prev_escaped.
+**/
+static std::uint64_t find_escaped(std::uint64_t backslash, std::uint64_t& prev_escaped)
+{
+    static constexpr std::uint64_t even_bits = 0x5555555555555555ULL;
+
+    backslash &= ~prev_escaped;
+    std::uint64_t follows_escape      = backslash << 1 | prev_escaped;
+    std::uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+    std::uint64_t sequences_starting_on_even_bits;
+    prev_escaped = add_overflow(odd_sequence_starts, backslash, sequences_starting_on_even_bits) ? 1U : 0U;
+    std::uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+
+    return (even_bits ^ invert_mask) & follows_escape;
+}
+
+/** Compute the running XOR of every bit up to and including the current one. Given the mask of unescaped quotes, this
+ *  is the mask of characters between an opening and closing quote.
+**/
+static std::uint64_t prefix_xor(std::uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+static unsigned trailing_zeros(std::uint64_t x)
+{
+#if defined(__GNUC__)
+    return unsigned(__builtin_ctzll(x));
+#else
+    unsigned count = 0;
+    for (; !(x & 1U); x >>= 1)
+        ++count;
+    return count;
+#endif
+}
+
+structural_index::structural_index(string_view input) :
+        _input(input)
+{
+    assert(input.size() <= max_input_size);
+
+    // Structural characters are usually somewhere around one in every six or eight bytes of a typical document
+    _offsets.reserve(input.size() / 8);
+
+    std::uint64_t prev_escaped   = 0;
+    std::uint64_t prev_in_string = 0;
+    char          tail[block_size];
+    for (std::size_t base = 0; base < input.size(); base += block_size)
+    {
+        const char* block = input.data() + base;
+        if (input.size() - base < block_size)
+        {
+            std::memset(tail, ' ', sizeof tail);
+            std::memcpy(tail, block, input.size() - base);
+            block = tail;
+        }
+
+        block_masks   masks     = classify(block);
+        std::uint64_t escaped   = find_escaped(masks.backslash, prev_escaped);
+        std::uint64_t quotes    = masks.quote & ~escaped;
+        std::uint64_t in_string = prefix_xor(quotes) ^ prev_in_string;
+        prev_in_string = std::uint64_t(0) - (in_string >> 63);
+
+        for (std::uint64_t found = (masks.structural & ~in_string) | quotes; found; found &= found - 1)
+            _offsets.push_back(size_type(base + trailing_zeros(found)));
+    }
+}
+
+bool structural_index::find_string_end(std::size_t open, std::size_t& cursor, std::size_t& close) const
+{
+    while (cursor < _offsets.size() && _offsets[cursor] < open)
+        ++cursor;
+
+    if (cursor == _offsets.size() || _offsets[cursor] != open || _input[open] != '\"')
+        return false;
+
+    for (std::size_t idx = cursor + 1; idx < _offsets.size(); ++idx)
+    {
+        if (_input[_offsets[idx]] == '\"')
+        {
+            close  = _offsets[idx];
+            cursor = idx + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+}
@@ -0,0 +1,73 @@
+/** \file jsonv/detail/structural_index.hpp
+ *  A first-pass index of the structural characters in a JSON document.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_STRUCTURAL_INDEX_HPP_INCLUDED__
+#define __JSONV_DETAIL_STRUCTURAL_INDEX_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/string_view.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** An index of the offsets of every unescaped quote character and every structural character (\c {, \c }, \c [, \c ],
+ *  \c : and \c ,) which does not appear between quotes. The input is classified 64 bytes at a time (with SSE2 or NEON
+ *  when available) and the escape and in-string states are carried between blocks with bit arithmetic, so the cost of
+ *  building the index does not depend on the content of the input.
+ *
+ *  The index performs no validation. The offsets of unescaped quotes are correct for any input, since a quote is
+ *  escaped if and only if it is preceded by an odd-length run of backslashes. The in-string state used to filter the
+ *  other structural characters can be thrown off by a quote appearing inside of a comment or garbage input, so users of
+ *  the index should fall back to a regular scan when the index disagrees with what they see.
+**/
+class structural_index
+{
+public:
+    using size_type = std::uint32_t;
+
+    /** The largest input which can be indexed. Offsets are stored as 32-bit integers to keep the index compact. **/
+    static constexpr std::size_t max_input_size = std::size_t(0xffffffffU);
+
+public:
+    /** Build the index for \a input. The \a input must be no larger than \c max_input_size. **/
+    explicit structural_index(string_view input);
+
+    /** Get the offsets of the indexed characters, in ascending order. **/
+    const std::vector<size_type>& offsets() const
+    {
+        return _offsets;
+    }
+
+    /** Find the end of a string token which starts with the quote at offset \a open.
+     *
+     *  \param open The offset of the opening quote.
+     *  \param[in,out] cursor A position in \c offsets to start searching from. Callers stepping forward through the
+     *                        input should keep this between calls so the search is amortized constant time.
+     *  \param[out] close The offset of the closing quote, if found.
+     *  \returns \c true if the string was found in the index; \c false if \a open is not an unescaped quote or the
+     *           string is not terminated.
+    **/
+    bool find_string_end(std::size_t open, std::size_t& cursor, std::size_t& close) const;
+
+private:
+    string_view            _input;
+    std::vector<size_type> _offsets;
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_STRUCTURAL_INDEX_HPP_INCLUDED__*/
@@ -0,0 +1,250 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include "syntax_validator.hpp"
+#include "number_convert.hpp"
+#include "token_patterns.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace jsonv
+{
+namespace detail
+{
+
+syntax_validator::syntax_validator(string_view input, const parse_options& options) :
+        _input(input),
+        _options(options),
+        _validate_string(get_string_validator(options.string_encoding())),
+        _problem(0, 0, 0, std::string())
+{ }
+
+token_kind syntax_validator::skipped_tokens() const
+{
+    return _options.comments() ? (token_kind::whitespace | token_kind::comment) : token_kind::whitespace;
+}
+
+bool syntax_validator::run()
+{
+    tokenizer        tokens(_input);
+    tokenizer::token batch[64];
+    while (std::size_t count = tokens.next_batch(batch, skipped_tokens()))
+    {
+        for (std::size_t idx = 0; idx < count; ++idx)
+        {
+            if (!accept(batch[idx]))
+                return false;
+            // Without a complete parse, whatever follows the document is left for someone else
+            if (complete() && !_options.complete_parse())
+                return true;
+        }
+    }
+    return finish();
+}
+
+bool syntax_validator::finish()
+{
+    if (_expect == expect::root)
+        return fail(nullptr, "No input");
+    else if (_expect != expect::done)
+        return fail(nullptr, _open.empty() || _open.top_is_array() ? "Unexpected end: unmatched '['"
+                                                                   : "Unexpected end inside of object."
+                   );
+    else if (_scalar_root)
+        return fail(nullptr, "JSON requires the root of a payload to be an array or object");
+    else
+        return true;
+}
+
+bool syntax_validator::accept(const tokenizer::token& tok)
+{
+    if (tok.kind == token_kind::comment)
+        return fail(&tok, "JSON comment is not allowed");
+
+    switch (_expect)
+    {
+    case expect::root:
+    case expect::value:
+        return value(tok);
+    case expect::array_first:
+    case expect::array_after_comma:
+        if (tok.kind == token_kind::array_end)
+        {
+            if (_expect == expect::array_after_comma && !trailing_commas())
+                return fail(&tok, "Array contained a trailing comma");
+            return close();
+        }
+        return value(tok);
+    case expect::array_next:
+        if (tok.kind == token_kind::array_end)
+            return close();
+        else if (tok.kind != token_kind::separator)
+            return fail(&tok, "Invalid entry when looking for ',' or ']'");
+        _expect = expect::array_after_comma;
+        return true;
+    case expect::object_first:
+    case expect::object_after_comma:
+        if (tok.kind == token_kind::object_end)
+        {
+            if (_expect == expect::object_after_comma && !trailing_commas())
+                return fail(&tok, "Trailing comma at end of object.");
+            return close();
+        }
+        else if (tok.kind != token_kind::string)
+        {
+            return fail(&tok, "Expecting a key, but found ", tok.kind);
+        }
+        _expect = expect::object_colon;
+        return string(tok);
+    case expect::object_colon:
+        if (tok.kind != token_kind::object_key_delimiter)
+            return fail(&tok, "Invalid key-value delimiter...expecting ':' after key");
+        _expect = expect::value;
+        return true;
+    case expect::object_next:
+        if (tok.kind == token_kind::object_end)
+            return close();
+        else if (tok.kind != token_kind::separator)
+            return fail(&tok, "Invalid token while searching for next value in object.");
+        _expect = expect::object_after_comma;
+        return true;
+    case expect::done:
+    default:
+        // At the end of input, we might have a few nulls -- this is expected for string literals, so ignore them.
+        if (  tok.kind == token_kind::unknown
+           || std::all_of(tok.text.begin(), tok.text.end(), [] (char c) { return c == '\0'; })
+           )
+            return true;
+        return fail(&tok, "Found non-trivial data after final token. ", tok.kind);
+    }
+}
+
+bool syntax_validator::value(const tokenizer::token& tok)
+{
+    bool root = _expect == expect::root;
+    if (  root
+       && _options.require_document()
+       && tok.kind != token_kind::array_begin
+       && tok.kind != token_kind::object_begin
+       )
+    {
+        // Like parse, this is only checked once the rest of the input has been (so a problem after the value comes
+        // first and this one is at the end of the input)
+        if (_options.complete_parse())
+            _scalar_root = true;
+        else
+            return fail(&tok, "JSON requires the root of a payload to be an array or object");
+    }
+
+    switch (tok.kind)
+    {
+    case token_kind::array_begin:
+    case token_kind::object_begin:
+        _open.push(tok.kind == token_kind::array_begin);
+        if (_open.size() == _options.max_structure_depth())
+            return fail(&tok, "Structure depth reached maximum of ", _open.size());
+        _expect = tok.kind == token_kind::array_begin ? expect::array_first : expect::object_first;
+        return true;
+    case token_kind::boolean:
+        if (tok.text != "true" && tok.text != "false")
+            return fail(&tok, "Failed to match a boolean");
+        return finish_value();
+    case token_kind::null:
+        if (tok.text != "null")
+            return fail(&tok, "Failed to match \"null\"");
+        return finish_value();
+    case token_kind::number:
+        return number(tok) && finish_value();
+    case token_kind::string:
+        return string(tok) && finish_value();
+    default:
+        return fail(&tok, "Encountered invalid token ", tok.kind);
+    }
+}
+
+bool syntax_validator::number(const tokenizer::token& tok)
+{
+    string_view characters  = tok.text;
+    std::size_t first_digit = (!characters.empty() && characters[0] == '-') ? 1U : 0U;
+    if (  _options.number_encoding() != parse_options::numbers::decimal
+       && characters.size() > first_digit + 1U
+       && characters[first_digit] == '0'
+       && '0' <= characters[first_digit + 1U] && characters[first_digit + 1U] <= '9'
+       )
+        return fail(&tok, "Numbers cannot start with a leading '0'");
+
+    if (!_options.require_finite_numbers())
+        return is_number(characters) || fail(&tok, "Could not extract number from");
+
+    // Only numbers which have to be checked for being finite are converted
+    std::int64_t integer;
+    double       decimal;
+    switch (convert_number(characters, integer, decimal))
+    {
+    case number_convert_result::integer:
+        return true;
+    case number_convert_result::decimal:
+        return std::isfinite(decimal) || fail(&tok, "Number is not finite");
+    case number_convert_result::invalid:
+    default:
+        return fail(&tok, "Could not extract number from");
+    }
+}
+
+bool syntax_validator::string(const tokenizer::token& tok)
+{
+    string_view source = tok.text;
+    if (source.size() < 2 || source.back() != '"')
+        return fail(&tok, "Unterminated string");
+
+    source.remove_prefix(1);
+    source.remove_suffix(1);
+    try
+    {
+        _validate_string(source);
+        return true;
+    }
+    catch (const decode_error& err)
+    {
+        return fail(&tok, "Error decoding string:", err.what());
+    }
+}
+
+bool syntax_validator::finish_value()
+{
+    if (_open.empty())
+        _expect = expect::done;
+    else
+        _expect = _open.top_is_array() ? expect::array_next : expect::object_next;
+    return true;
+}
+
+bool syntax_validator::close()
+{
+    _open.pop();
+    return finish_value();
+}
+
+bool syntax_validator::trailing_commas() const
+{
+    return _options.comma_policy() == parse_options::commas::allow_trailing;
+}
+
+bool syntax_validator::fail_at(const char* where, std::string message)
+{
+    tokenizer::location loc = { 1, 1, 0 };
+    advance_location(loc, _input.data(), where);
+    _problem = parse_error::problem(loc.line, loc.column, loc.character, std::move(message));
+    return false;
+}
+
+}
+}
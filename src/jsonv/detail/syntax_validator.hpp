@@ -0,0 +1,177 @@
+/** \file jsonv/detail/syntax_validator.hpp
+ *  Checking a stream of tokens against the grammar of JSON without building a \c value.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_SYNTAX_VALIDATOR_HPP_INCLUDED__
+#define __JSONV_DETAIL_SYNTAX_VALIDATOR_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/string_view.hpp>
+#include <jsonv/tokenizer.hpp>
+
+#include "../char_convert.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** The arrays and objects which have been opened, but not yet closed, as one bit each. The first 64 levels do not need
+ *  any memory beyond this.
+**/
+class JSONV_LOCAL container_stack
+{
+public:
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    bool top_is_array() const
+    {
+        std::size_t idx = _size - 1;
+        return idx < 64 ? ((_bits >> idx) & 1U) != 0 : _more[idx - 64];
+    }
+
+    void push(bool is_array)
+    {
+        if (_size < 64)
+            _bits = is_array ? (_bits | (std::uint64_t(1) << _size)) : (_bits & ~(std::uint64_t(1) << _size));
+        else if (_size - 64 < _more.size())
+            _more[_size - 64] = is_array;
+        else
+            _more.push_back(is_array);
+        ++_size;
+    }
+
+    void pop()
+    {
+        --_size;
+    }
+
+private:
+    std::uint64_t     _bits = 0;
+    std::size_t       _size = 0;
+    std::vector<bool> _more;
+};
+
+/** Checks a stream of tokens against the grammar of JSON (as relaxed by \c parse_options), stopping at the first
+ *  problem. This is used by \c is_valid and \c minify; strings are checked, but never decoded.
+**/
+class JSONV_LOCAL syntax_validator
+{
+public:
+    /** Create a validator for the tokens of \a input. Neither \a input nor \a options are copied. **/
+    syntax_validator(string_view input, const parse_options& options);
+
+    /** Check the next token \a tok, which must be from the \c input. Whitespace must be left out, as should comments if
+     *  the \c parse_options allow them.
+     *
+     *  \returns \c false if there is a problem (see \c problem).
+    **/
+    bool accept(const tokenizer::token& tok);
+
+    /** Check that the input did not end before the document did.
+     *
+     *  \returns \c false if there is a problem (see \c problem).
+    **/
+    bool finish();
+
+    /** Has the value at the root of the document been completed? **/
+    bool complete() const
+    {
+        return _expect == expect::done;
+    }
+
+    /** Go through all of the \c input with a \c tokenizer (stopping after the document if the \c parse_options do not
+     *  require a complete parse).
+     *
+     *  \returns \c true if there was no problem; otherwise, \c problem describes the first one.
+    **/
+    bool run();
+
+    /** The first problem found. **/
+    const parse_error::problem& problem() const
+    {
+        return _problem;
+    }
+
+    /** The tokens \c accept should not be given. **/
+    token_kind skipped_tokens() const;
+
+private:
+    /** What the next token can be. **/
+    enum class expect
+    {
+        root,                   //!< The value at the root of the document.
+        value,                  //!< A value in an array or object.
+        array_first,            //!< An element of an array or the end of it (right after the \c [).
+        array_after_comma,      //!< An element of an array (or the end, with trailing commas allowed).
+        array_next,             //!< A \c , or the end of an array.
+        object_first,           //!< A key of an object or the end of it (right after the \c {).
+        object_after_comma,     //!< A key of an object (or the end, with trailing commas allowed).
+        object_colon,           //!< The \c : after a key.
+        object_next,            //!< A \c , or the end of an object.
+        done,                   //!< Nothing but whitespace (unless \c parse_options::complete_parse is \c false).
+    };
+
+private:
+    bool value(const tokenizer::token& tok);
+    bool number(const tokenizer::token& tok);
+    bool string(const tokenizer::token& tok);
+
+    /** A value was just completed, so go on with whatever contains it. **/
+    bool finish_value();
+
+    bool close();
+
+    bool trailing_commas() const;
+
+    /** Record a problem at \a tok (or the end of the input if it is \c nullptr), with the message made of \a message.
+     *
+     *  \returns \c false, so this can end a check.
+    **/
+    template <typename... T>
+    bool fail(const tokenizer::token* tok, T&&... message)
+    {
+        std::ostringstream stream;
+        using expand = int[];
+        (void) expand { 0, ((void) (stream << std::forward<T>(message)), 0)... };
+        if (tok)
+            stream << ": \"" << tok->text << "\"";
+        return fail_at(tok ? tok->text.data() : _input.data() + _input.size(), stream.str());
+    }
+
+    bool fail_at(const char* where, std::string message);
+
+private:
+    string_view                  _input;
+    const parse_options&         _options;
+    string_validate_fn           _validate_string;
+    expect                       _expect = expect::root;
+    container_stack              _open;
+    bool                         _scalar_root = false;  //!< The root is not a document, which is checked in \c finish.
+    parse_error::problem         _problem;
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_SYNTAX_VALIDATOR_HPP_INCLUDED__*/
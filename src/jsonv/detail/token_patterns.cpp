@@ -9,6 +9,7 @@
  *  \author Travis Gockel (travis@gockelhut.com)
 **/
 #include <jsonv/detail/token_patterns.hpp>
+#include <jsonv/detail/string_scan.hpp>
 
 #include <algorithm>
 #include <cassert>
@@ -329,24 +330,23 @@ static match_result match_string(const char* begin, const char* end, token_kind&
     
     while (true)
     {
-        if (begin + length == end)
+        const char* found = find_quote_or_backslash(begin + length, end);
+        length = std::size_t(found - begin);
+        if (found == end)
             return match_result::unmatched;
         
-        if (begin[length] == '\"')
+        if (*found == '\"')
         {
             ++length;
             return match_result::complete;
         }
-        else if (begin[length] == '\\')
+        else if (found + 1 == end)
         {
-            if (begin + length + 1 == end)
-                return match_result::unmatched;
-            else
-                length += 2;
+            return match_result::unmatched;
         }
         else
         {
-            ++length;
+            length += 2;
         }
     }
 }
@@ -493,6 +493,34 @@ match_result attempt_match(const char* begin, const char* end, token_kind& kind,
     }
 }
 
+bool match_may_continue(match_result result, token_kind kind, const char* match_end, const char* end)
+{
+    if (result == match_result::unmatched)
+        return match_end == end || (kind == token_kind::string && match_end + 1 == end);
+    else
+        return match_end == end && (kind == token_kind::number || kind == token_kind::whitespace);
+}
+
+void advance_location(tokenizer::location& loc, const char* from, const char* to)
+{
+    auto is_newline = [] (char c) { return c == '\n' || c == '\r'; };
+
+    auto newlines = tokenizer::size_type(std::count_if(from, to, is_newline));
+    if (newlines == 0)
+    {
+        loc.column += tokenizer::size_type(to - from);
+    }
+    else
+    {
+        using reverse_iterator = std::reverse_iterator<const char*>;
+        const char* line_start = std::find_if(reverse_iterator(to), reverse_iterator(from), is_newline).base();
+
+        loc.line   += newlines;
+        loc.column  = 1 + tokenizer::size_type(to - line_start);
+    }
+    loc.character += tokenizer::size_type(to - from);
+}
+
 path_match_result path_match(string_view input, string_view& match_contents)
 {
     if (input.length() < 2)
@@ -42,6 +42,22 @@ match_result attempt_match(const char*  begin,
                            std::size_t& length
                           );
 
+/** Move the location \a loc at \a from forward to \a to, counting the lines and columns in between. Newlines are found
+ *  with \c std::count_if, which is easily vectorized, so this is not much slower than a \c std::memchr over the range.
+**/
+void advance_location(tokenizer::location& loc, const char* from, const char* to);
+
+/** Could the token matched by \c attempt_match be different if there was more input after \a end? This is the case for
+ *  an unmatched token which ran all the way to \a end (or a string which stopped one character short because it ends
+ *  with the start of an escape sequence) and for numbers and whitespace, which can always be longer.
+ *  
+ *  \param result The result of \c attempt_match.
+ *  \param kind The \c token_kind found by \c attempt_match.
+ *  \param match_end The end of the match (\c begin plus the length found by \c attempt_match).
+ *  \param end The end of the available input.
+**/
+bool match_may_continue(match_result result, token_kind kind, const char* match_end, const char* end);
+
 enum class path_match_result : char
 {
     simple_object = '.',
@@ -0,0 +1,64 @@
+/** \file jsonv/detail/trace_scope.hpp
+ *  The calls to the installed \c tracer around an operation.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#ifndef __JSONV_DETAIL_TRACE_SCOPE_HPP_INCLUDED__
+#define __JSONV_DETAIL_TRACE_SCOPE_HPP_INCLUDED__
+
+#include <jsonv/config.hpp>
+#include <jsonv/trace.hpp>
+
+#include <atomic>
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** The \c tracer from \c set_tracer. **/
+extern JSONV_LOCAL std::atomic<tracer*> installed_tracer;
+
+/** The number of operations of each \c trace_operation which are running on this thread, so only the outermost is
+ *  reported.
+**/
+JSONV_LOCAL unsigned int& trace_nesting(trace_operation operation);
+
+/** Tells the installed \c tracer about the operation which runs for the lifetime of this instance (if it is not inside
+ *  of another operation of the same kind). When there is no tracer, nothing else is touched.
+**/
+class JSONV_LOCAL trace_scope
+{
+public:
+    explicit trace_scope(trace_operation operation, std::size_t bytes = 0, const std::type_info* type = nullptr) :
+            _tracer(installed_tracer.load(std::memory_order_acquire)),
+            _span{ operation, bytes, type }
+    {
+        if (_tracer && trace_nesting(operation)++ == 0)
+            _tracer->begin(_span);
+    }
+
+    ~trace_scope() noexcept
+    {
+        if (_tracer && --trace_nesting(_span.operation) == 0)
+            _tracer->end(_span);
+    }
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+private:
+    tracer*    _tracer;
+    trace_span _span;
+};
+
+}
+}
+
+#endif/*__JSONV_DETAIL_TRACE_SCOPE_HPP_INCLUDED__*/
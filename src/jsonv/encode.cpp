@@ -10,73 +10,193 @@
  *  \author Travis Gockel (travis@gockelhut.com)
 **/
 #include <jsonv/encode.hpp>
+#include <jsonv/encode_static.hpp>
+#include <jsonv/stats.hpp>
 #include <jsonv/value.hpp>
+#include <jsonv/detail/scope_exit.hpp>
 
+#include "char_convert.hpp"
 #include "detail.hpp"
-
+#include "detail/compact_writer.hpp"
+#include "detail/number_convert.hpp"
+#include "detail/output_buffer.hpp"
+#include "detail/parallel.hpp"
+#include "detail/trace_scope.hpp"
+
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <ostream>
+#include <vector>
 
 namespace jsonv
 {
 
+using detail::is_ascii;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // encoder                                                                                                            //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 encoder::~encoder() noexcept = default;
 
+/** The \c encode_static writer which \c encoder::encode uses, which calls the virtual members of an \c encoder. **/
+class encoder::virtual_writer
+{
+public:
+    explicit virtual_writer(encoder& target) :
+            _target(target)
+    { }
+    
+    void write_null()                       { _target.write_null(); }
+    void write_boolean(bool value)          { _target.write_boolean(value); }
+    void write_integer(std::int64_t value)  { _target.write_integer(value); }
+    void write_decimal(double value)        { _target.write_decimal(value); }
+    void write_string(string_view value)    { _target.write_string(value); }
+    void write_array_begin(std::size_t n)   { _target.write_array_begin_sized(n); }
+    void write_array_delimiter()            { _target.write_array_delimiter(); }
+    void write_array_end()                  { _target.write_array_end(); }
+    void write_object_begin(std::size_t n)  { _target.write_object_begin_sized(n); }
+    void write_object_key(string_view key)  { _target.write_object_key(key); }
+    void write_object_delimiter()           { _target.write_object_delimiter(); }
+    void write_object_end()                 { _target.write_object_end(); }
+    bool write_raw_json(string_view text)   { return _target.write_raw_json(text); }
+    
+private:
+    encoder& _target;
+};
+
 void encoder::encode(const value& source)
 {
-    switch (source.kind())
+    detail::trace_scope trace(trace_operation::encode);
+    virtual_writer      out(*this);
+    encode_static(source, out);
+}
+
+/** An \c encode_static writer which counts and times what goes through to the \c TWriter it wraps. **/
+template <typename TWriter>
+class stats_writer
+{
+public:
+    using clock = std::chrono::steady_clock;
+    
+    explicit stats_writer(TWriter& target, encode_stats& stats) :
+            _target(target),
+            _stats(stats),
+            _depth(0)
+    { }
+    
+    void write_null()                       { count(kind::null); _target.write_null(); }
+    void write_boolean(bool value)          { count(kind::boolean); _target.write_boolean(value); }
+    void write_array_delimiter()            { _target.write_array_delimiter(); }
+    void write_object_delimiter()           { _target.write_object_delimiter(); }
+    void write_array_end()                  { --_depth; _target.write_array_end(); }
+    void write_object_end()                 { --_depth; _target.write_object_end(); }
+    bool write_raw_json(string_view text)   { return _target.write_raw_json(text); }
+    
+    void write_integer(std::int64_t value)
     {
-    case kind::array:
-        write_array_begin();
-        {
-            bool first = true;
-            for (const value& sub : source.as_array())
-            {
-                if (first)
-                    first = false;
-                else
-                    write_array_delimiter();
-                encode(sub);
-            }
-        }
-        write_array_end();
-        break;
-    case kind::boolean:
-        write_boolean(source.as_boolean());
-        break;
-    case kind::decimal:
-        write_decimal(source.as_decimal());
-        break;
-    case kind::integer:
-        write_integer(source.as_integer());
-        break;
-    case kind::null:
-        write_null();
-        break;
-    case kind::object:
-        write_object_begin();
-        {
-            bool first = true;
-            for (const value::object_value_type& entry : source.as_object())
-            {
-                if (first)
-                    first = false;
-                else
-                    write_object_delimiter();
-                
-                write_object_key(entry.first);
-                encode(entry.second);
-            }
-        }
-        write_object_end();
-        break;
-    case kind::string:
-        write_string(source.as_string());
-        break;
+        count(kind::integer);
+        auto start = clock::now();
+        _target.write_integer(value);
+        add_time(_stats.number_time, start);
+    }
+    
+    void write_decimal(double value)
+    {
+        count(kind::decimal);
+        auto start = clock::now();
+        _target.write_decimal(value);
+        add_time(_stats.number_time, start);
+    }
+    
+    void write_string(string_view value)
+    {
+        count(kind::string);
+        _stats.string_bytes += value.size();
+        auto start = clock::now();
+        _target.write_string(value);
+        add_time(_stats.string_time, start);
     }
+    
+    void write_object_key(string_view key)
+    {
+        ++_stats.keys;
+        _stats.string_bytes += key.size();
+        auto start = clock::now();
+        _target.write_object_key(key);
+        add_time(_stats.string_time, start);
+    }
+    
+    void write_array_begin(std::size_t count)
+    {
+        open(kind::array);
+        _target.write_array_begin(count);
+    }
+    
+    void write_object_begin(std::size_t count)
+    {
+        open(kind::object);
+        _target.write_object_begin(count);
+    }
+    
+private:
+    void count(kind of_kind)
+    {
+        ++_stats.value_counts[static_cast<std::size_t>(of_kind)];
+    }
+    
+    void open(kind of_kind)
+    {
+        count(of_kind);
+        _stats.max_depth = std::max(_stats.max_depth, ++_depth);
+    }
+    
+    static void add_time(encode_stats::duration& total, clock::time_point start)
+    {
+        total += std::chrono::duration_cast<encode_stats::duration>(clock::now() - start);
+    }
+    
+private:
+    TWriter&      _target;
+    encode_stats& _stats;
+    std::size_t   _depth;
+};
+
+void encoder::encode(const value& source, encode_stats& stats)
+{
+    using clock = stats_writer<virtual_writer>::clock;
+    
+    detail::trace_scope trace(trace_operation::encode);
+    
+    auto start     = clock::now();
+    auto add_total = detail::on_scope_exit([&]
+                                           {
+                                               stats.total_time += std::chrono::duration_cast<encode_stats::duration>(
+                                                                       clock::now() - start
+                                                                   );
+                                           }
+                                          );
+    ++stats.documents;
+    
+    virtual_writer               target(*this);
+    stats_writer<virtual_writer> out(target, stats);
+    encode_static(source, out);
+}
+
+void encoder::write_object_begin_sized(std::size_t)
+{
+    write_object_begin();
+}
+
+void encoder::write_array_begin_sized(std::size_t)
+{
+    write_array_begin();
+}
+
+bool encoder::write_raw_json(string_view)
+{
+    return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -118,15 +238,21 @@ void ostream_encoder::write_boolean(bool value)
 void ostream_encoder::write_decimal(double value)
 {
     if (std::isfinite(value))
-        _output << value;
+    {
+        char text[detail::max_formatted_decimal_length];
+        _output.write(text, std::streamsize(detail::format_decimal(text, value)));
+    }
     else
+    {
         // non-finite values do not have valid JSON representations, so put it as null
         write_null();
+    }
 }
 
 void ostream_encoder::write_integer(std::int64_t value)
 {
-    _output << value;
+    char text[detail::max_formatted_integer_length];
+    _output.write(text, std::streamsize(detail::format_integer(text, value)));
 }
 
 void ostream_encoder::write_null()
@@ -160,11 +286,25 @@ void ostream_encoder::write_string(string_view value)
     stream_escaped_string(_output, value, _ensure_ascii);
 }
 
+bool ostream_encoder::write_raw_json(string_view text)
+{
+    if (_ensure_ascii && !is_ascii(text))
+        return false;
+    
+    _output.write(text.data(), std::streamsize(text.size()));
+    return true;
+}
+
 std::ostream& ostream_encoder::output()
 {
     return _output;
 }
 
+bool ostream_encoder::ensure_ascii() const
+{
+    return _ensure_ascii;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ostream_pretty_encoder                                                                                             //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -173,115 +313,528 @@ ostream_pretty_encoder::ostream_pretty_encoder(std::ostream& output, std::size_t
         ostream_encoder(output),
         _indent(0),
         _indent_size(indent_size),
-        _defer_indent(false)
+        _depth(0),
+        _defer_indent(false),
+        _compact_arrays(false),
+        _eol("\n"),
+        _compact_start(std::string::npos)
 { }
 
-ostream_pretty_encoder::~ostream_pretty_encoder() noexcept = default;
+ostream_pretty_encoder::~ostream_pretty_encoder() noexcept
+{
+    try
+    {
+        flush_text();
+    }
+    catch (...)
+    {
+        // nothing can be done about it here
+    }
+}
+
+void ostream_pretty_encoder::compact_arrays(bool value)
+{
+    _compact_arrays = value;
+}
+
+/** Once this much text is waiting, it is written out at the next line which is not part of a compact array. **/
+static constexpr std::size_t pretty_flush_size = 1U << 16;
+
+void ostream_pretty_encoder::flush_text()
+{
+    if (!_text.empty())
+    {
+        output().write(_text.data(), std::streamsize(_text.size()));
+        _text.clear();
+    }
+}
 
 void ostream_pretty_encoder::write_prefix()
 {
     if (_defer_indent)
     {
-        write_eol();
+        if (_compact_start != std::string::npos)
+            _compact_elements.push_back(_text.size());
+        else
+            write_eol();
         _defer_indent = false;
     }
 }
 
 void ostream_pretty_encoder::write_eol()
 {
-    output() << std::endl;
-    for (std::size_t x = 0; x < _indent; ++x)
-        output() << ' ';
+    if (_text.size() >= pretty_flush_size && _compact_start == std::string::npos)
+        flush_text();
+    
+    if (_eol.size() < _indent + 1)
+        _eol.resize(std::max(_indent + 1, _eol.size() * 2), ' ');
+    _text.append(_eol.data(), _indent + 1);
+}
+
+void ostream_pretty_encoder::write_value_end()
+{
+    if (_depth == 0)
+        flush_text();
+}
+
+void ostream_pretty_encoder::expand_compact()
+{
+    if (_compact_start == std::string::npos)
+        return;
+    
+    // Everything after the '[' is elements separated by ", " -- the last one has just been started
+    std::string elements = _text.substr(_compact_start + 1);
+    std::size_t offset   = _compact_start + 1;
+    _text.resize(offset);
+    _compact_start = std::string::npos;
+    for (std::size_t idx = 0; idx < _compact_elements.size(); ++idx)
+    {
+        std::size_t begin = _compact_elements[idx] - offset;
+        std::size_t end   = idx + 1 < _compact_elements.size() ? _compact_elements[idx + 1] - offset - 2
+                                                               : elements.size();
+        if (idx > 0)
+            _text.push_back(',');
+        write_eol();
+        _text.append(elements, begin, end - begin);
+    }
+    _compact_elements.clear();
 }
 
 void ostream_pretty_encoder::write_array_begin()
 {
     write_prefix();
-    ostream_encoder::write_array_begin();
+    expand_compact();
+    _text.push_back('[');
+    if (_compact_arrays)
+        _compact_start = _text.size() - 1;
     _indent += _indent_size;
+    ++_depth;
     _defer_indent = true;
 }
 
 void ostream_pretty_encoder::write_array_end()
 {
     _indent -= _indent_size;
-    if (!_defer_indent)
+    --_depth;
+    if (_compact_start != std::string::npos)
+    {
+        _compact_start = std::string::npos;
+        _compact_elements.clear();
+    }
+    else if (!_defer_indent)
     {
         write_eol();
     }
     _defer_indent = false;
-    ostream_encoder::write_array_end();
+    _text.push_back(']');
+    write_value_end();
 }
 
 void ostream_pretty_encoder::write_array_delimiter()
 {
     write_prefix();
-    ostream_encoder::write_array_delimiter();
-    write_eol();
+    if (_compact_start != std::string::npos)
+    {
+        _text.append(", ", 2);
+        _defer_indent = true;
+    }
+    else
+    {
+        _text.push_back(',');
+        write_eol();
+    }
 }
 
 void ostream_pretty_encoder::write_boolean(bool value)
 {
     write_prefix();
-    ostream_encoder::write_boolean(value);
+    if (value)
+        _text.append("true", 4);
+    else
+        _text.append("false", 5);
+    write_value_end();
 }
 
 void ostream_pretty_encoder::write_decimal(double value)
 {
-    write_prefix();
-    ostream_encoder::write_decimal(value);
+    if (std::isfinite(value))
+    {
+        write_prefix();
+        char text[detail::max_formatted_decimal_length];
+        _text.append(text, detail::format_decimal(text, value));
+        write_value_end();
+    }
+    else
+    {
+        // non-finite values do not have valid JSON representations, so put it as null
+        write_null();
+    }
 }
 
 void ostream_pretty_encoder::write_integer(int64_t value)
 {
     write_prefix();
-    ostream_encoder::write_integer(value);
+    char text[detail::max_formatted_integer_length];
+    _text.append(text, detail::format_integer(text, value));
+    write_value_end();
 }
 
 void ostream_pretty_encoder::write_null()
 {
     write_prefix();
-    ostream_encoder::write_null();
+    _text.append("null", 4);
+    write_value_end();
 }
 
 void ostream_pretty_encoder::write_object_begin()
 {
     write_prefix();
-    ostream_encoder::write_object_begin();
+    expand_compact();
+    _text.push_back('{');
     _indent += _indent_size;
+    ++_depth;
     _defer_indent = true;
 }
 
 void ostream_pretty_encoder::write_object_end()
 {
     _indent -= _indent_size;
+    --_depth;
     if (!_defer_indent)
     {
         write_eol();
     }
     _defer_indent = false;
-    ostream_encoder::write_object_end();
+    _text.push_back('}');
+    write_value_end();
 }
 
 void ostream_pretty_encoder::write_object_delimiter()
 {
-    ostream_encoder::write_object_delimiter();
+    _text.push_back(',');
     _defer_indent = true;
 }
 
 void ostream_pretty_encoder::write_object_key(string_view key)
 {
     write_prefix();
-    ostream_encoder::write_object_key(key);
-    output() << ' ';
+    _text.push_back('"');
+    detail::string_encode(_text, key, ensure_ascii());
+    _text.append("\": ", 3);
 }
 
 void ostream_pretty_encoder::write_string(string_view value)
 {
     write_prefix();
-    ostream_encoder::write_string(value);
+    _text.push_back('"');
+    detail::string_encode(_text, value, ensure_ascii());
+    _text.push_back('"');
+    write_value_end();
+}
+
+bool ostream_pretty_encoder::write_raw_json(string_view text)
+{
+    // Containers are walked so they get indented, but the text of a number has no layout to change
+    if (text.empty() || text[0] == '[' || text[0] == '{')
+        return false;
+    
+    write_prefix();
+    _text.append(text.data(), text.size());
+    write_value_end();
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// buffer_encoder                                                                                                     //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+buffer_encoder::buffer_encoder(std::string& output) :
+        buffer_encoder([&output] (string_view chunk) { output.append(chunk.data(), chunk.size()); })
+{ }
+
+buffer_encoder::buffer_encoder(char* buffer, std::size_t size, flush_function flush) :
+        _buffer(new detail::output_buffer(buffer, size, std::move(flush))),
+        _ensure_ascii(true)
+{ }
+
+buffer_encoder::buffer_encoder(flush_function flush, std::size_t chunk_size) :
+        _buffer(new detail::output_buffer(chunk_size, std::move(flush))),
+        _ensure_ascii(true)
+{ }
+
+buffer_encoder::~buffer_encoder() noexcept
+{
+    try
+    {
+        _buffer->flush();
+    }
+    catch (...)
+    {
+        // nothing can be done about it here -- callers who care should call flush themselves
+    }
 }
 
+void buffer_encoder::ensure_ascii(bool value)
+{
+    _ensure_ascii = value;
+}
+
+void buffer_encoder::flush()
+{
+    _buffer->flush();
+}
+
+std::size_t buffer_encoder::size() const
+{
+    return _buffer->size();
+}
+
+void buffer_encoder::use_buffer(char* buffer, std::size_t size)
+{
+    _buffer->use_buffer(buffer, size);
+}
+
+void buffer_encoder::truncate(std::size_t size)
+{
+    _buffer->truncate(size);
+}
+
+detail::compact_writer buffer_encoder::writer()
+{
+    return detail::compact_writer(*_buffer, _ensure_ascii);
+}
+
+void buffer_encoder::write_array_begin()
+{
+    writer().write_array_begin();
+}
+
+void buffer_encoder::write_array_end()
+{
+    writer().write_array_end();
+}
+
+void buffer_encoder::write_array_delimiter()
+{
+    writer().write_array_delimiter();
+}
+
+void buffer_encoder::write_boolean(bool value)
+{
+    writer().write_boolean(value);
+}
+
+void buffer_encoder::write_decimal(double value)
+{
+    writer().write_decimal(value);
+}
+
+void buffer_encoder::write_integer(std::int64_t value)
+{
+    writer().write_integer(value);
+}
+
+void buffer_encoder::write_null()
+{
+    writer().write_null();
+}
+
+void buffer_encoder::write_object_begin()
+{
+    writer().write_object_begin();
+}
+
+void buffer_encoder::write_object_end()
+{
+    writer().write_object_end();
+}
+
+void buffer_encoder::write_object_delimiter()
+{
+    writer().write_object_delimiter();
+}
+
+void buffer_encoder::write_object_key(string_view key)
+{
+    writer().write_object_key(key);
+}
+
+void buffer_encoder::write_string(string_view value)
+{
+    writer().write_string(value);
+}
+
+bool buffer_encoder::write_raw_json(string_view text)
+{
+    return writer().write_raw_json(text);
+}
+
+/** Containers with fewer elements than this are not worth splitting up for parallel encoding. **/
+static constexpr std::size_t parallel_min_elements = 256;
+
+/** Each thread gets about this many ranges of elements to encode, so a thread with cheap elements can take on more. **/
+static constexpr std::size_t parallel_parts_per_thread = 8;
+
+static bool is_splittable(const value& source)
+{
+    return (source.kind() == kind::array || source.kind() == kind::object) && !detail::encoded_json(source);
+}
+
+void buffer_encoder::encode_parallel(const value& source, std::size_t threads)
+{
+    threads = detail::resolve_threads(threads);
+    
+    // Go down into the largest child for as long as it is bigger than its parent
+    std::vector<const value*> spine = { &source };
+    while (is_splittable(*spine.back()) && spine.back()->size() < threads * parallel_parts_per_thread)
+    {
+        const value* largest = nullptr;
+        auto consider = [&] (const value& child)
+                        {
+                            if (is_splittable(child) && (!largest || child.size() > largest->size()))
+                                largest = &child;
+                        };
+        if (spine.back()->kind() == kind::array)
+            for (const value& child : spine.back()->as_array())
+                consider(child);
+        else
+            for (const auto& entry : spine.back()->as_object())
+                consider(entry.second);
+        
+        if (!largest || largest->size() <= spine.back()->size())
+            break;
+        spine.push_back(largest);
+    }
+    
+    if (threads == 1 || !is_splittable(*spine.back()) || spine.back()->size() < parallel_min_elements)
+        encode(source);
+    else
+        encode_spine(spine, 0, threads);
+}
+
+void buffer_encoder::encode_spine(const std::vector<const value*>& spine, std::size_t depth, std::size_t threads)
+{
+    const value& current = *spine[depth];
+    if (depth + 1 == spine.size())
+    {
+        encode_elements_parallel(current, threads);
+    }
+    else if (current.kind() == kind::array)
+    {
+        write_array_begin_sized(current.size());
+        bool first = true;
+        for (const value& sub : current.as_array())
+        {
+            if (first)
+                first = false;
+            else
+                write_array_delimiter();
+            
+            if (&sub == spine[depth + 1])
+                encode_spine(spine, depth + 1, threads);
+            else
+                encode(sub);
+        }
+        write_array_end();
+    }
+    else
+    {
+        write_object_begin_sized(current.size());
+        bool first = true;
+        for (const value::object_value_type& entry : current.as_object())
+        {
+            if (first)
+                first = false;
+            else
+                write_object_delimiter();
+            
+            write_object_key(entry.first);
+            if (&entry.second == spine[depth + 1])
+                encode_spine(spine, depth + 1, threads);
+            else
+                encode(entry.second);
+        }
+        write_object_end();
+    }
+}
+
+void buffer_encoder::encode_elements_parallel(const value& container, std::size_t threads)
+{
+    bool                                         is_object = container.kind() == kind::object;
+    std::vector<const value*>                    elements;
+    std::vector<const value::object_value_type*> entries;
+    if (is_object)
+    {
+        entries.reserve(container.size());
+        for (const value::object_value_type& entry : container.as_object())
+            entries.push_back(&entry);
+    }
+    else
+    {
+        elements.reserve(container.size());
+        for (const value& sub : container.as_array())
+            elements.push_back(&sub);
+    }
+    
+    std::size_t              count = is_object ? entries.size() : elements.size();
+    std::size_t              parts = std::min(count, threads * parallel_parts_per_thread);
+    std::vector<std::string> results(parts);
+    detail::run_parallel(parts,
+                         threads,
+                         [&] (std::size_t part)
+                         {
+                             std::string&          result = results[part];
+                             detail::output_buffer buffer(4096,
+                                                          [&] (string_view chunk)
+                                                          {
+                                                              result.append(chunk.data(), chunk.size());
+                                                          }
+                                                         );
+                             detail::compact_writer out(buffer, _ensure_ascii);
+                             std::size_t first = count * part / parts;
+                             std::size_t last  = count * (part + 1) / parts;
+                             for (std::size_t idx = first; idx < last; ++idx)
+                             {
+                                 if (is_object)
+                                 {
+                                     if (idx != first)
+                                         out.write_object_delimiter();
+                                     out.write_object_key(entries[idx]->first);
+                                     encode_static(entries[idx]->second, out);
+                                 }
+                                 else
+                                 {
+                                     if (idx != first)
+                                         out.write_array_delimiter();
+                                     encode_static(*elements[idx], out);
+                                 }
+                             }
+                             buffer.flush();
+                         }
+                        );
+    
+    if (is_object)
+        write_object_begin_sized(count);
+    else
+        write_array_begin_sized(count);
+    for (std::size_t part = 0; part < parts; ++part)
+    {
+        if (part != 0 && is_object)
+            write_object_delimiter();
+        else if (part != 0)
+            write_array_delimiter();
+        _buffer->write(results[part].data(), results[part].size());
+        std::string().swap(results[part]);
+    }
+    if (is_object)
+        write_object_end();
+    else
+        write_array_end();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ostream_iso_encoder                                                                                                //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 ostream_iso_encoder::ostream_iso_encoder(std::ostream& output) :
 	ostream_encoder(output)
@@ -293,4 +846,129 @@ void ostream_iso_encoder::write_string(string_view value)
 	stream_escaped_iso_string(output(), value);
 }
 
+bool ostream_iso_encoder::write_raw_json(string_view text)
+{
+	if (!is_ascii(text))
+		return false;
+	
+	output().write(text.data(), std::streamsize(text.size()));
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// encoded_size                                                                                                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/** Counts the characters \c buffer_encoder would write, without writing them. **/
+class size_writer
+{
+public:
+    explicit size_writer(bool ensure_ascii) :
+            _ensure_ascii(ensure_ascii),
+            _size(0)
+    { }
+    
+    std::size_t size() const
+    {
+        return _size;
+    }
+    
+    void write_null()
+    {
+        _size += 4;
+    }
+    
+    void write_boolean(bool value)
+    {
+        _size += value ? 4 : 5;
+    }
+    
+    void write_integer(std::int64_t value)
+    {
+        char text[detail::max_formatted_integer_length];
+        _size += detail::format_integer(text, value);
+    }
+    
+    void write_decimal(double value)
+    {
+        char text[detail::max_formatted_decimal_length];
+        _size += std::isfinite(value) ? detail::format_decimal(text, value) : 4;
+    }
+    
+    void write_string(string_view value)
+    {
+        _size += 2 + detail::string_encoded_size(value, _ensure_ascii);
+    }
+    
+    void write_array_begin(std::size_t)
+    {
+        ++_size;
+    }
+    
+    void write_array_delimiter()
+    {
+        ++_size;
+    }
+    
+    void write_array_end()
+    {
+        ++_size;
+    }
+    
+    void write_object_begin(std::size_t)
+    {
+        ++_size;
+    }
+    
+    void write_object_key(string_view key)
+    {
+        write_string(key);
+        ++_size;
+    }
+    
+    void write_object_delimiter()
+    {
+        ++_size;
+    }
+    
+    void write_object_end()
+    {
+        ++_size;
+    }
+    
+    bool write_raw_json(string_view text)
+    {
+        if (_ensure_ascii && !is_ascii(text))
+            return false;
+        
+        _size += text.size();
+        return true;
+    }
+    
+private:
+    bool        _ensure_ascii;
+    std::size_t _size;
+};
+
+}
+
+std::size_t encoded_size(const value& source, bool ensure_ascii)
+{
+    size_writer counter(ensure_ascii);
+    encode_static(source, counter);
+    return counter.size();
+}
+
+std::string to_string_parallel(const value& source, std::size_t threads)
+{
+    std::string out;
+    buffer_encoder encoder(out);
+    encoder.encode_parallel(source, threads);
+    encoder.flush();
+    return out;
+}
+
 }
@@ -0,0 +1,343 @@
+/** \file
+ *  Writing values as canonical JSON (RFC 8785).
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/encode.hpp>
+#include <jsonv/value.hpp>
+
+#include "array.hpp"
+#include "char_convert.hpp"
+#include "object.hpp"
+#include "detail/number_convert.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jsonv
+{
+
+/** Write \a x the way ECMAScript's \c Number.prototype.toString does, which is the canonical form of a number. **/
+static void write_number(double x, std::string& out)
+{
+    if (!std::isfinite(x))
+        throw std::domain_error(std::string("Canonical JSON can not represent ")
+                                + (std::isnan(x) ? "NaN" : "infinity")
+                               );
+
+    // This covers -0 as well
+    if (x == 0.0)
+    {
+        out.push_back('0');
+        return;
+    }
+
+    // format_decimal already finds the shortest digits which give back x (the closest ones if there are several), so
+    // only the layout of them needs to change: split the text into those digits and the n for which x = 0.digits * 10^n
+    char        text[detail::max_formatted_decimal_length];
+    const char* end      = text + detail::format_decimal(text, x);
+    const char* current  = text;
+    char        digits[detail::max_formatted_decimal_length];
+    int         k        = 0;
+    int         n        = 0;
+    bool        in_point = false;
+    if (*current == '-')
+    {
+        out.push_back('-');
+        ++current;
+    }
+    for (; current != end && *current != 'e'; ++current)
+    {
+        if (*current == '.')
+        {
+            in_point = true;
+        }
+        else if (k == 0 && *current == '0')
+        {
+            if (in_point)
+                --n;
+        }
+        else
+        {
+            digits[k++] = *current;
+            if (!in_point)
+                ++n;
+        }
+    }
+    if (current != end)
+        n += std::atoi(current + 1);
+    while (k > 1 && digits[k - 1] == '0')
+        --k;
+
+    if (k <= n && n <= 21)
+    {
+        out.append(digits, std::size_t(k));
+        out.append(std::size_t(n - k), '0');
+    }
+    else if (0 < n && n <= 21)
+    {
+        out.append(digits, std::size_t(n));
+        out.push_back('.');
+        out.append(digits + n, std::size_t(k - n));
+    }
+    else if (-6 < n && n <= 0)
+    {
+        out.append("0.", 2);
+        out.append(std::size_t(-n), '0');
+        out.append(digits, std::size_t(k));
+    }
+    else
+    {
+        out.push_back(digits[0]);
+        if (k > 1)
+        {
+            out.push_back('.');
+            out.append(digits + 1, std::size_t(k - 1));
+        }
+        out.push_back('e');
+        out.push_back(n - 1 < 0 ? '-' : '+');
+        out += std::to_string(std::abs(n - 1));
+    }
+}
+
+static void write_integer(std::int64_t x, std::string& out)
+{
+    // Canonical numbers are doubles, so integers which one can not hold exactly are written as the closest one
+    static constexpr std::int64_t max_exact = std::int64_t(1) << 53;
+    if (-max_exact <= x && x <= max_exact)
+    {
+        char text[detail::max_formatted_integer_length];
+        out.append(text, detail::format_integer(text, x));
+    }
+    else
+    {
+        write_number(double(x), out);
+    }
+}
+
+/** The UTF-16 code units of \a key, which is what RFC 8785 sorts the members of an object by. Invalid UTF-8 does not
+ *  matter here, since writing the key will fail anyway.
+**/
+static std::u16string utf16_units(string_view key)
+{
+    std::u16string out;
+    for (std::size_t idx = 0; idx < key.size(); )
+    {
+        unsigned    lead   = static_cast<unsigned char>(key[idx]);
+        std::size_t length = lead < 0x80U ? 1 : lead < 0xe0U ? 2 : lead < 0xf0U ? 3 : 4;
+        char32_t    code   = length == 1 ? lead : lead & (0x3fU >> (length - 1));
+        for (std::size_t offset = 1; offset < length && idx + offset < key.size(); ++offset)
+            code = (code << 6) | (static_cast<unsigned char>(key[idx + offset]) & 0x3fU);
+        idx += length;
+
+        if (code >= 0x10000)
+        {
+            out.push_back(char16_t(0xd800 + ((code - 0x10000) >> 10)));
+            out.push_back(char16_t(0xdc00 + ((code - 0x10000) & 0x3ff)));
+        }
+        else
+        {
+            out.push_back(char16_t(code));
+        }
+    }
+    return out;
+}
+
+/** Is the (UTF-8 byte) order of \a members different from the UTF-16 order canonical JSON wants? The orders only
+ *  differ between characters from U+E000 to U+FFFF and the ones past U+FFFF, which are stored as surrogates (U+D800 to
+ *  U+DFFF) in UTF-16. Both start with a byte of at least \c 0xee in UTF-8, so keys without one are in the right order.
+**/
+static bool needs_utf16_sort(const value::object_storage_type& members)
+{
+    for (const auto& member : members)
+        for (char c : member.first)
+            if (static_cast<unsigned char>(c) >= 0xeeU)
+                return true;
+    return false;
+}
+
+/** Write the contents of \a impl (an object or array) with \a write_contents, or copy the text kept from the last time
+ *  that was done. See \c canonical_encoder::cache_subtrees.
+**/
+template <typename TImpl, typename FWrite>
+static void write_cached(const TImpl* impl, bool cache, std::string& out, const FWrite& write_contents)
+{
+    if (!cache || !impl->_shareable.load(std::memory_order_relaxed))
+    {
+        write_contents(out);
+        return;
+    }
+
+    const std::string* text = impl->_canonical.get();
+    if (!text)
+    {
+        std::string created;
+        write_contents(created);
+        text = &impl->_canonical.set(std::move(created));
+    }
+    out += *text;
+}
+
+canonical_encoder::canonical_encoder(std::string& output) :
+        _string(&output),
+        _stream(nullptr),
+        _cache_subtrees(false)
+{ }
+
+canonical_encoder::canonical_encoder(std::ostream& output) :
+        _string(nullptr),
+        _stream(&output),
+        _cache_subtrees(false)
+{ }
+
+canonical_encoder::~canonical_encoder() noexcept = default;
+
+void canonical_encoder::cache_subtrees(bool value)
+{
+    _cache_subtrees = value;
+}
+
+void canonical_encoder::encode(const value& source)
+{
+    if (_string)
+    {
+        write(source, *_string);
+    }
+    else
+    {
+        std::string text;
+        write(source, text);
+        _stream->write(text.data(), std::streamsize(text.size()));
+    }
+}
+
+void canonical_encoder::write(const value& source, std::string& out) const
+{
+    switch (source.kind())
+    {
+    case kind::null:
+        out.append("null", 4);
+        break;
+    case kind::boolean:
+        if (source.as_boolean())
+            out.append("true", 4);
+        else
+            out.append("false", 5);
+        break;
+    case kind::integer:
+        write_integer(source.as_integer(), out);
+        break;
+    case kind::decimal:
+        write_number(source.as_decimal(), out);
+        break;
+    case kind::string:
+        detail::string_canonical_encode(out, source.as_string_view());
+        break;
+    case kind::array:
+        write_cached(source._data.array, _cache_subtrees, out,
+                     [&] (std::string& text)
+                     {
+                         text.push_back('[');
+                         std::size_t count = source.size();
+                         if (const std::int64_t* integers = source.packed_integers())
+                         {
+                             for (std::size_t idx = 0; idx < count; ++idx)
+                             {
+                                 if (idx > 0)
+                                     text.push_back(',');
+                                 write_integer(integers[idx], text);
+                             }
+                         }
+                         else if (const double* decimals = source.packed_decimals())
+                         {
+                             for (std::size_t idx = 0; idx < count; ++idx)
+                             {
+                                 if (idx > 0)
+                                     text.push_back(',');
+                                 write_number(decimals[idx], text);
+                             }
+                         }
+                         else
+                         {
+                             bool first = true;
+                             for (const value& element : detail::as_const(source._data.array)->values())
+                             {
+                                 if (!first)
+                                     text.push_back(',');
+                                 first = false;
+                                 write(element, text);
+                             }
+                         }
+                         text.push_back(']');
+                     }
+                    );
+        break;
+    case kind::object:
+        write_cached(source._data.object, _cache_subtrees, out,
+                     [&] (std::string& text)
+                     {
+                         using member_type = value::object_value_type;
+
+                         bool first = true;
+                         auto write_member = [&] (const member_type& member)
+                                             {
+                                                 if (!first)
+                                                     text.push_back(',');
+                                                 first = false;
+                                                 detail::string_canonical_encode(text, member.first);
+                                                 text.push_back(':');
+                                                 write(member.second, text);
+                                             };
+
+                         const value::object_storage_type& members = source._data.object->_values;
+                         text.push_back('{');
+                         if (!needs_utf16_sort(members))
+                         {
+                             for (const member_type& member : members)
+                                 write_member(member);
+                         }
+                         else
+                         {
+                             std::vector<std::pair<std::u16string, const member_type*>> sorted;
+                             sorted.reserve(members.size());
+                             for (const member_type& member : members)
+                                 sorted.emplace_back(utf16_units(member.first), &member);
+                             std::sort(sorted.begin(), sorted.end(),
+                                       [] (const std::pair<std::u16string, const member_type*>& a,
+                                           const std::pair<std::u16string, const member_type*>& b
+                                          )
+                                       {
+                                           return a.first < b.first;
+                                       }
+                                      );
+                             for (const auto& entry : sorted)
+                                 write_member(*entry.second);
+                         }
+                         text.push_back('}');
+                     }
+                    );
+        break;
+    }
+}
+
+std::string to_canonical_string(const value& source)
+{
+    std::string       out;
+    canonical_encoder encoder(out);
+    encoder.encode(source);
+    return out;
+}
+
+}
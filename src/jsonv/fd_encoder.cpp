@@ -0,0 +1,274 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/fd_encoder.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#   define JSONV_FD_ENCODER_WINDOWS 1
+#   include <io.h>
+#else
+#   define JSONV_FD_ENCODER_POSIX 1
+#   include <sys/uio.h>
+#   include <unistd.h>
+#endif
+
+namespace jsonv
+{
+namespace detail
+{
+
+/** Blocks are aligned to (and a multiple of) this many bytes, which is the page size nearly everywhere. **/
+static constexpr std::size_t fd_block_alignment = 4096;
+
+/** The number of blocks a background writer cycles through: one being filled and the rest waiting or being written. **/
+static constexpr std::size_t fd_background_blocks = 4;
+
+/** A piece of output which is ready to be written. **/
+struct fd_chunk
+{
+    const char* data;
+    std::size_t size;
+};
+
+/** Write all of the \a chunks to \a fd, retrying after partial writes and interruptions. **/
+static void write_all(int fd, std::vector<fd_chunk> chunks)
+{
+    std::size_t first = 0;
+    while (first < chunks.size())
+    {
+        if (chunks[first].size == 0)
+        {
+            ++first;
+            continue;
+        }
+
+#if JSONV_FD_ENCODER_POSIX
+        std::vector<iovec> pieces;
+        pieces.reserve(chunks.size() - first);
+        for (std::size_t idx = first; idx < chunks.size(); ++idx)
+            pieces.push_back(iovec{ const_cast<char*>(chunks[idx].data), chunks[idx].size });
+        ssize_t written = ::writev(fd, pieces.data(), static_cast<int>(pieces.size()));
+#else
+        unsigned int request = static_cast<unsigned int>(std::min<std::size_t>(chunks[first].size, 1U << 30));
+        int written = ::_write(fd, chunks[first].data, request);
+#endif
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "Could not write to file descriptor");
+        }
+
+        // Step past whatever was written, which can end in the middle of a chunk
+        std::size_t remaining = static_cast<std::size_t>(written);
+        while (remaining > 0)
+        {
+            std::size_t step = std::min(remaining, chunks[first].size);
+            chunks[first].data += step;
+            chunks[first].size -= step;
+            remaining          -= step;
+            if (chunks[first].size == 0)
+                ++first;
+        }
+    }
+}
+
+class fd_writer
+{
+public:
+    fd_writer(int fd, std::size_t block_size, bool background) :
+            _fd(fd),
+            _block_size((block_size + fd_block_alignment - 1) / fd_block_alignment * fd_block_alignment),
+            _writing(false),
+            _stopping(false)
+    {
+        if (_block_size == 0)
+            _block_size = fd_block_alignment;
+
+        std::size_t blocks = background ? fd_background_blocks : 1;
+        _storage.reset(new char[blocks * _block_size + fd_block_alignment]);
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(_storage.get());
+        _blocks = _storage.get() + (fd_block_alignment - address % fd_block_alignment) % fd_block_alignment;
+        for (std::size_t idx = 0; idx < blocks; ++idx)
+            _free.push_back(_blocks + idx * _block_size);
+
+        if (background)
+            _thread = std::thread([this] { run_background(); });
+    }
+
+    ~fd_writer() noexcept
+    {
+        if (_thread.joinable())
+        {
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                _stopping = true;
+            }
+            _changed.notify_all();
+            _thread.join();
+        }
+    }
+
+    fd_writer(const fd_writer&) = delete;
+    fd_writer& operator=(const fd_writer&) = delete;
+
+    std::size_t block_size() const
+    {
+        return _block_size;
+    }
+
+    /** Get a block to write into. This is only called once, for the first block; the rest come from \c hand_off. **/
+    char* first_block()
+    {
+        char* out = _free.back();
+        _free.pop_back();
+        return out;
+    }
+
+    /** Write (or queue) \a contents, which is in a block from \c first_block or \c hand_off, and get the block to fill
+     *  in next.
+    **/
+    char* hand_off(string_view contents)
+    {
+        if (!_thread.joinable())
+        {
+            write_all(_fd, { fd_chunk{ contents.data(), contents.size() } });
+            return const_cast<char*>(contents.data());
+        }
+
+        std::unique_lock<std::mutex> lock(_lock);
+        rethrow_failure();
+        _queue.push_back(fd_chunk{ contents.data(), contents.size() });
+        _changed.notify_all();
+        _changed.wait(lock, [this] { return !_free.empty(); });
+        char* out = _free.back();
+        _free.pop_back();
+        return out;
+    }
+
+    /** Wait for everything given to \c hand_off to be written. **/
+    void wait()
+    {
+        if (!_thread.joinable())
+            return;
+
+        std::unique_lock<std::mutex> lock(_lock);
+        _changed.wait(lock, [this] { return _queue.empty() && !_writing; });
+        rethrow_failure();
+    }
+
+private:
+    /** Failures stick, since the output after a failed write would be missing a piece. **/
+    void rethrow_failure()
+    {
+        if (_failure)
+            std::rethrow_exception(_failure);
+    }
+
+    void run_background()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        while (true)
+        {
+            _changed.wait(lock, [this] { return !_queue.empty() || _stopping; });
+            if (_queue.empty())
+                return;
+
+            std::vector<fd_chunk> batch;
+            batch.swap(_queue);
+            _writing = true;
+            lock.unlock();
+
+            std::exception_ptr failure;
+            try
+            {
+                // Only this thread sets _failure, so it can be read without the lock
+                if (!_failure)
+                    write_all(_fd, batch);
+            }
+            catch (...)
+            {
+                failure = std::current_exception();
+            }
+
+            lock.lock();
+            if (failure)
+                _failure = failure;
+            for (const fd_chunk& chunk : batch)
+            {
+                // write_all only advanced its own copies of the chunks, so each of these is the start of a block
+                _free.push_back(const_cast<char*>(chunk.data));
+            }
+            _writing = false;
+            _changed.notify_all();
+        }
+    }
+
+private:
+    int                     _fd;
+    std::size_t             _block_size;
+    std::unique_ptr<char[]> _storage;
+    char*                   _blocks;   //!< The first page-aligned block in \c _storage
+    std::vector<char*>      _free;
+    std::vector<fd_chunk>   _queue;
+    bool                    _writing;
+    bool                    _stopping;
+    std::exception_ptr      _failure;
+    std::mutex              _lock;
+    std::condition_variable _changed;
+    std::thread             _thread;
+};
+
+}
+
+fd_encoder::fd_encoder(int fd, std::size_t block_size, bool background) :
+        fd_encoder(std::unique_ptr<detail::fd_writer>(new detail::fd_writer(fd, block_size, background)))
+{ }
+
+fd_encoder::fd_encoder(std::unique_ptr<detail::fd_writer> writer) :
+        buffer_encoder(writer->first_block(),
+                       writer->block_size(),
+                       [this, target = writer.get()] (string_view contents)
+                       {
+                           use_buffer(target->hand_off(contents), target->block_size());
+                       }
+                      ),
+        _writer(std::move(writer))
+{ }
+
+fd_encoder::~fd_encoder() noexcept
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        // nothing can be done about it here -- callers who care should call flush themselves
+    }
+}
+
+void fd_encoder::flush()
+{
+    buffer_encoder::flush();
+    _writer->wait();
+}
+
+}
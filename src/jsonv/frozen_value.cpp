@@ -0,0 +1,786 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/frozen_value.hpp>
+#include <jsonv/encode.hpp>
+
+#include "detail.hpp"
+#include "detail/file_mapping.hpp"
+#include "detail/shared_memory.hpp"
+
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace jsonv
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tape Layout                                                                                                        //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every value starts with a word holding its tag in the top 8 bits and a payload in the other 56. Some kinds need a
+// second word after that:
+//
+//  - null, false, true:  1 word; no payload
+//  - small_integer:      1 word; the payload is the integer (sign-extended from 56 bits)
+//  - integer:            2 words; the second is the integer
+//  - decimal:            2 words; the second is the bits of the double
+//  - short_string:       1 word; the payload is the offset into the string pool (high 32 bits) and length (low 24)
+//  - long_string:        2 words; the payload is the offset into the string pool; the second word is the length
+//  - array, object:      2 words, then the contents; the payload is the position just after the last word of the
+//                        contents and the second word is the number of elements. The contents of an object are a
+//                        string for the key followed by the value, for each entry.
+
+enum class tape_tag : std::uint8_t
+{
+    null,
+    boolean_false,
+    boolean_true,
+    small_integer,
+    integer,
+    decimal,
+    short_string,
+    long_string,
+    array,
+    object,
+};
+
+static constexpr std::uint64_t payload_mask       = (std::uint64_t(1) << 56) - 1;
+static constexpr std::uint64_t short_length_limit = std::uint64_t(1) << 24;
+static constexpr std::uint64_t short_offset_limit = std::uint64_t(1) << 32;
+static constexpr std::int64_t  small_integer_max  = (std::int64_t(1) << 55) - 1;
+static constexpr std::int64_t  small_integer_min  = -(std::int64_t(1) << 55);
+
+static std::uint64_t make_word(tape_tag tag, std::uint64_t payload)
+{
+    return (std::uint64_t(tag) << 56) | (payload & payload_mask);
+}
+
+static tape_tag word_tag(std::uint64_t word)
+{
+    return tape_tag(word >> 56);
+}
+
+static std::uint64_t word_payload(std::uint64_t word)
+{
+    return word & payload_mask;
+}
+
+/** The tape and strings of a document. They are either kept in \c tape_storage and \c string_storage or refer into
+ *  \c memory, which is the saved form of a document (a file mapped by \c load_frozen or a shared-memory segment).
+**/
+struct JSONV_LOCAL frozen_value::document
+{
+    const std::uint64_t*                  tape         = nullptr;
+    std::size_t                           tape_size    = 0;
+    const char*                           strings      = nullptr;
+    std::size_t                           strings_size = 0;
+
+    std::vector<std::uint64_t>            tape_storage;
+    std::string                           string_storage;
+    std::shared_ptr<const void>           memory;
+
+    /** Point \c tape and \c strings at \c tape_storage and \c string_storage. **/
+    void use_storage()
+    {
+        tape         = tape_storage.data();
+        tape_size    = tape_storage.size();
+        strings      = string_storage.data();
+        strings_size = string_storage.size();
+    }
+
+    tape_tag tag(std::size_t position) const
+    {
+        return word_tag(tape[position]);
+    }
+
+    std::uint64_t payload(std::size_t position) const
+    {
+        return word_payload(tape[position]);
+    }
+
+    string_view string_at(std::size_t position) const
+    {
+        std::uint64_t payload = this->payload(position);
+        if (tag(position) == tape_tag::short_string)
+            return string_view(strings + (payload >> 24), std::size_t(payload & (short_length_limit - 1)));
+        else
+            return string_view(strings + payload, std::size_t(tape[position + 1]));
+    }
+
+    /** Get the position just past the value at \a position. **/
+    std::size_t skip(std::size_t position) const
+    {
+        switch (tag(position))
+        {
+        case tape_tag::integer:
+        case tape_tag::decimal:
+        case tape_tag::long_string:
+            return position + 2;
+        case tape_tag::array:
+        case tape_tag::object:
+            return std::size_t(payload(position));
+        default:
+            return position + 1;
+        }
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// frozen_value::builder                                                                                              //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Writes the values it is given onto the tape of a document. **/
+class JSONV_LOCAL frozen_value::builder :
+        public encoder
+{
+public:
+    builder() :
+            _doc(std::make_shared<document>())
+    { }
+
+    std::shared_ptr<const document> finish()
+    {
+        // the parser can stop in the middle of a container if it is ignoring errors
+        while (!_open.empty())
+            close(tag(_open.back()));
+        if (_doc->tape_storage.empty())
+            write_null();
+
+        _doc->tape_storage.shrink_to_fit();
+        _doc->string_storage.shrink_to_fit();
+        _doc->use_storage();
+        return std::move(_doc);
+    }
+
+protected:
+    virtual void write_null() override
+    {
+        element();
+        push(make_word(tape_tag::null, 0));
+    }
+
+    virtual void write_object_begin() override
+    {
+        element();
+        open(tape_tag::object);
+    }
+
+    virtual void write_object_end() override
+    {
+        close(tape_tag::object);
+    }
+
+    virtual void write_object_key(string_view key) override
+    {
+        ++_doc->tape_storage[_open.back() + 1];
+
+        // keys repeat a lot (every object in an array of records has the same ones), so they are only stored once
+        auto iter = _keys.find(std::string(key));
+        if (iter == _keys.end())
+            iter = _keys.emplace(std::string(key), add_string(key)).first;
+        push_string(iter->second, key.size());
+    }
+
+    virtual void write_object_delimiter() override
+    { }
+
+    virtual void write_array_begin() override
+    {
+        element();
+        open(tape_tag::array);
+    }
+
+    virtual void write_array_end() override
+    {
+        close(tape_tag::array);
+    }
+
+    virtual void write_array_delimiter() override
+    { }
+
+    virtual void write_string(string_view value) override
+    {
+        element();
+        push_string(add_string(value), value.size());
+    }
+
+    virtual void write_integer(std::int64_t value) override
+    {
+        element();
+        if (small_integer_min <= value && value <= small_integer_max)
+        {
+            push(make_word(tape_tag::small_integer, std::uint64_t(value)));
+        }
+        else
+        {
+            push(make_word(tape_tag::integer, 0));
+            push(std::uint64_t(value));
+        }
+    }
+
+    virtual void write_decimal(double value) override
+    {
+        element();
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        push(make_word(tape_tag::decimal, 0));
+        push(bits);
+    }
+
+    virtual void write_boolean(bool value) override
+    {
+        element();
+        push(make_word(value ? tape_tag::boolean_true : tape_tag::boolean_false, 0));
+    }
+
+private:
+    tape_tag tag(std::size_t position) const
+    {
+        return word_tag(_doc->tape_storage[position]);
+    }
+
+    void push(std::uint64_t word)
+    {
+        _doc->tape_storage.push_back(word);
+    }
+
+    /** Called at the start of every value, which counts it as an element of the array it is in. Entries of objects are
+     *  counted by their key.
+    **/
+    void element()
+    {
+        if (!_open.empty() && tag(_open.back()) == tape_tag::array)
+            ++_doc->tape_storage[_open.back() + 1];
+    }
+
+    void open(tape_tag kind)
+    {
+        _open.push_back(_doc->tape_storage.size());
+        push(make_word(kind, 0));
+        push(0);
+    }
+
+    void close(tape_tag kind)
+    {
+        if (_open.empty() || tag(_open.back()) != kind)
+            throw std::logic_error("frozen_value: unbalanced container end");
+        _doc->tape_storage[_open.back()] = make_word(kind, _doc->tape_storage.size());
+        _open.pop_back();
+    }
+
+    std::uint64_t add_string(string_view value)
+    {
+        std::uint64_t offset = _doc->string_storage.size();
+        _doc->string_storage.append(value.data(), value.size());
+        return offset;
+    }
+
+    void push_string(std::uint64_t offset, std::size_t length)
+    {
+        if (offset < short_offset_limit && length < short_length_limit)
+        {
+            push(make_word(tape_tag::short_string, (offset << 24) | length));
+        }
+        else
+        {
+            push(make_word(tape_tag::long_string, offset));
+            push(length);
+        }
+    }
+
+private:
+    std::shared_ptr<document>                      _doc;
+    std::vector<std::size_t>                       _open;  //!< The positions of the containers being written.
+    std::unordered_map<std::string, std::uint64_t> _keys;  //!< The offsets of the keys which are already stored.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// frozen_value                                                                                                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+frozen_value::frozen_value() :
+        _position(0)
+{
+    // every default-constructed instance shares the same document
+    static const std::shared_ptr<const document> empty = builder().finish();
+    _doc = empty;
+}
+
+frozen_value::frozen_value(const value& source)
+{
+    builder out;
+    out.encode(source);
+    _doc      = out.finish();
+    _position = 0;
+}
+
+frozen_value::frozen_value(std::shared_ptr<const document> doc, std::size_t position) :
+        _doc(std::move(doc)),
+        _position(position)
+{ }
+
+frozen_value::frozen_value(const frozen_value&) = default;
+
+frozen_value& frozen_value::operator=(const frozen_value&) = default;
+
+frozen_value::frozen_value(frozen_value&&) noexcept = default;
+
+frozen_value& frozen_value::operator=(frozen_value&&) noexcept = default;
+
+frozen_value::~frozen_value() noexcept = default;
+
+frozen_value parse_frozen(const string_view& input, const parse_options& options)
+{
+    frozen_value::builder out;
+    parse(input, out, options);
+    return frozen_value(out.finish(), 0);
+}
+
+jsonv::kind frozen_value::kind() const
+{
+    switch (_doc->tag(_position))
+    {
+    case tape_tag::null:
+        return jsonv::kind::null;
+    case tape_tag::boolean_false:
+    case tape_tag::boolean_true:
+        return jsonv::kind::boolean;
+    case tape_tag::small_integer:
+    case tape_tag::integer:
+        return jsonv::kind::integer;
+    case tape_tag::decimal:
+        return jsonv::kind::decimal;
+    case tape_tag::short_string:
+    case tape_tag::long_string:
+        return jsonv::kind::string;
+    case tape_tag::array:
+        return jsonv::kind::array;
+    case tape_tag::object:
+    default:
+        return jsonv::kind::object;
+    }
+}
+
+void frozen_value::check_kind(jsonv::kind expected) const
+{
+    check_type(expected, kind());
+}
+
+std::size_t frozen_value::next() const
+{
+    return _doc->skip(_position);
+}
+
+value frozen_value::to_value() const
+{
+    switch (kind())
+    {
+    case jsonv::kind::array:
+    {
+        value out = array();
+        for (auto iter = begin_array(); iter != end_array(); ++iter)
+            out.push_back(iter->to_value());
+        return out;
+    }
+    case jsonv::kind::object:
+    {
+        value out = object();
+        for (auto iter = begin_object(); iter != end_object(); ++iter)
+            out.insert({ std::string(iter->first), iter->second.to_value() });
+        return out;
+    }
+    case jsonv::kind::string:
+        return value(std::string(as_string()));
+    case jsonv::kind::integer:
+        return value(as_integer());
+    case jsonv::kind::decimal:
+        return value(as_decimal());
+    case jsonv::kind::boolean:
+        return value(as_boolean());
+    case jsonv::kind::null:
+    default:
+        return null;
+    }
+}
+
+frozen_value frozen_value::at(size_type idx) const
+{
+    check_kind(jsonv::kind::array);
+    if (idx >= size())
+        throw std::out_of_range("frozen_value::at: index out of range");
+
+    auto iter = begin_array();
+    for ( ; idx > 0; --idx)
+        ++iter;
+    return *iter;
+}
+
+frozen_value frozen_value::operator[](size_type idx) const
+{
+    return at(idx);
+}
+
+frozen_value frozen_value::at(string_view key) const
+{
+    auto iter = find(key);
+    if (iter == end_object())
+        throw std::out_of_range("frozen_value::at: key \"" + std::string(key) + "\" not found");
+    return iter->second;
+}
+
+frozen_value frozen_value::operator[](string_view key) const
+{
+    return at(key);
+}
+
+frozen_value::size_type frozen_value::count(string_view key) const
+{
+    size_type out = 0;
+    for (auto iter = begin_object(), end = end_object(); iter != end; ++iter)
+        if (iter->first == key)
+            ++out;
+    return out;
+}
+
+frozen_value::object_iterator frozen_value::find(string_view key) const
+{
+    auto iter = begin_object();
+    for (auto end = end_object(); iter != end; ++iter)
+        if (iter->first == key)
+            break;
+    return iter;
+}
+
+frozen_value frozen_value::at_path(const path& p) const
+{
+    frozen_value current = *this;
+    for (const path_element& elem : p)
+    {
+        if (elem.kind() == path_element_kind::array_index)
+            current = current.at(elem.index());
+        else
+            current = current.at(elem.key());
+    }
+    return current;
+}
+
+frozen_value frozen_value::at_path(string_view p) const
+{
+    return at_path(path::create(p));
+}
+
+frozen_value::size_type frozen_value::size() const
+{
+    switch (kind())
+    {
+    case jsonv::kind::array:
+    case jsonv::kind::object:
+        return size_type(_doc->tape[_position + 1]);
+    case jsonv::kind::string:
+        return as_string().size();
+    default:
+        check_type({ jsonv::kind::object, jsonv::kind::array, jsonv::kind::string }, kind());
+        return 0;
+    }
+}
+
+frozen_value::array_iterator frozen_value::begin_array() const
+{
+    check_kind(jsonv::kind::array);
+    return array_iterator(*this, _position + 2);
+}
+
+frozen_value::array_iterator frozen_value::end_array() const
+{
+    check_kind(jsonv::kind::array);
+    return array_iterator(*this, next());
+}
+
+frozen_value::object_iterator frozen_value::begin_object() const
+{
+    check_kind(jsonv::kind::object);
+    return object_iterator(*this, _position + 2, next());
+}
+
+frozen_value::object_iterator frozen_value::end_object() const
+{
+    check_kind(jsonv::kind::object);
+    return object_iterator(*this, next(), next());
+}
+
+string_view frozen_value::as_string() const
+{
+    check_kind(jsonv::kind::string);
+    return _doc->string_at(_position);
+}
+
+std::int64_t frozen_value::as_integer() const
+{
+    check_kind(jsonv::kind::integer);
+    if (_doc->tag(_position) == tape_tag::integer)
+        return std::int64_t(_doc->tape[_position + 1]);
+
+    // sign-extend the 56-bit payload
+    std::uint64_t payload = _doc->payload(_position);
+    if (payload & (std::uint64_t(1) << 55))
+        payload |= ~payload_mask;
+    return std::int64_t(payload);
+}
+
+double frozen_value::as_decimal() const
+{
+    if (kind() == jsonv::kind::integer)
+        return double(as_integer());
+
+    check_kind(jsonv::kind::decimal);
+    double out;
+    std::memcpy(&out, &_doc->tape[_position + 1], sizeof out);
+    return out;
+}
+
+bool frozen_value::as_boolean() const
+{
+    check_kind(jsonv::kind::boolean);
+    return _doc->tag(_position) == tape_tag::boolean_true;
+}
+
+std::size_t frozen_value::memory_size() const
+{
+    return sizeof(document)
+         + _doc->tape_storage.capacity() * sizeof(std::uint64_t)
+         + _doc->string_storage.capacity()
+         + (_doc->memory ? _doc->tape_size * sizeof(std::uint64_t) + _doc->strings_size : 0U);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Saving and Loading                                                                                                 //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A saved document is this header, then the tape, then the strings. Every position in the tape is relative to the start
+// of the tape and every string offset is relative to the start of the strings, so the file can be used right where it
+// is mapped. The header is a multiple of 8 bytes long, so the tape is aligned if the file is.
+
+struct frozen_file_header
+{
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;   //!< \c frozen_byte_order as written by the machine which saved the file.
+    std::uint64_t tape_size;    //!< The number of words in the tape.
+    std::uint64_t strings_size; //!< The number of bytes of strings.
+};
+
+static_assert(sizeof(frozen_file_header) == 32, "frozen_file_header must not have padding");
+
+static constexpr char          frozen_magic[8]    = { 'j', 's', 'o', 'n', 'v', 'f', 'z', '\0' };
+static constexpr std::uint32_t frozen_version     = 1;
+static constexpr std::uint32_t frozen_byte_order  = 0x01020304;
+
+std::size_t frozen_value::image_size() const
+{
+    return sizeof(frozen_file_header) + (next() - _position) * sizeof(std::uint64_t) + _doc->strings_size;
+}
+
+void frozen_value::write_image(const std::function<void (const char*, std::size_t)>& write) const
+{
+    // the positions of containers are absolute, so a value from the middle of a document is moved to the front
+    std::size_t                end = next();
+    std::vector<std::uint64_t> moved;
+    const std::uint64_t*       tape = _doc->tape + _position;
+    if (_position != 0)
+    {
+        moved.assign(tape, _doc->tape + end);
+        for (std::size_t position = 0; position < moved.size(); /* inline */)
+        {
+            tape_tag tag = word_tag(moved[position]);
+            if (tag == tape_tag::array || tag == tape_tag::object)
+            {
+                moved[position] = make_word(tag, word_payload(moved[position]) - _position);
+                // step into the container instead of over it
+                position += 2;
+            }
+            else
+            {
+                position = _doc->skip(_position + position) - _position;
+            }
+        }
+        tape = moved.data();
+    }
+
+    frozen_file_header header;
+    std::memcpy(header.magic, frozen_magic, sizeof header.magic);
+    header.version      = frozen_version;
+    header.byte_order   = frozen_byte_order;
+    header.tape_size    = end - _position;
+    header.strings_size = _doc->strings_size;
+
+    write(reinterpret_cast<const char*>(&header), sizeof header);
+    write(reinterpret_cast<const char*>(tape), std::size_t(header.tape_size) * sizeof(std::uint64_t));
+    write(_doc->strings, _doc->strings_size);
+}
+
+void frozen_value::save(std::ostream& out) const
+{
+    write_image([&] (const char* data, std::size_t size) { out.write(data, std::streamsize(size)); });
+}
+
+frozen_value frozen_value::load_image(std::shared_ptr<const void> memory, string_view image, const std::string& source)
+{
+    auto invalid = [&] (const char* problem)
+                   {
+                       return std::runtime_error("Invalid frozen_value in " + source + ": " + problem);
+                   };
+
+    frozen_file_header header;
+    if (image.size() < sizeof header)
+        throw invalid("too short");
+    std::memcpy(&header, image.data(), sizeof header);
+    if (std::memcmp(header.magic, frozen_magic, sizeof header.magic) != 0)
+        throw invalid("not a saved frozen_value");
+    if (header.version != frozen_version)
+        throw invalid("unsupported version");
+    if (header.byte_order != frozen_byte_order)
+        throw invalid("saved with a different byte order");
+
+    // shared memory can be rounded up to a whole page, so there can be more than the header says
+    std::size_t body_size = image.size() - sizeof header;
+    if (header.tape_size == 0
+        || header.tape_size > body_size / sizeof(std::uint64_t)
+        || header.strings_size > body_size - header.tape_size * sizeof(std::uint64_t)
+       )
+        throw invalid("sizes do not fit");
+
+    auto        doc  = std::make_shared<document>();
+    const char* tape = image.data() + sizeof header;
+    doc->memory       = std::move(memory);
+    doc->tape_size    = std::size_t(header.tape_size);
+    doc->strings      = tape + doc->tape_size * sizeof(std::uint64_t);
+    doc->strings_size = std::size_t(header.strings_size);
+    if (reinterpret_cast<std::uintptr_t>(tape) % alignof(std::uint64_t) == 0)
+    {
+        doc->tape = reinterpret_cast<const std::uint64_t*>(tape);
+    }
+    else
+    {
+        // only when a file could not be mapped and was read into a buffer which is not aligned
+        doc->tape_storage.resize(doc->tape_size);
+        std::memcpy(doc->tape_storage.data(), tape, doc->tape_size * sizeof(std::uint64_t));
+        doc->tape = doc->tape_storage.data();
+    }
+
+    // nothing else is checked, so loading takes the same time no matter how large the document is
+    if (doc->skip(0) != doc->tape_size)
+        throw invalid("the root value does not fill the tape");
+
+    return frozen_value(std::move(doc), 0);
+}
+
+frozen_value load_frozen(const std::string& path)
+{
+    auto mapping = std::make_shared<const detail::file_mapping>(path);
+    return frozen_value::load_image(mapping, mapping->contents(), "\"" + path + "\"");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// frozen_segment                                                                                                     //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+frozen_segment::frozen_segment(const std::string& name, const frozen_value& doc) :
+        _name(name)
+{
+    auto memory = std::make_shared<detail::shared_memory>(name, doc.image_size());
+    char* out   = memory->data();
+    doc.write_image([&] (const char* data, std::size_t size) { std::memcpy(out, data, size); out += size; });
+    _memory = std::move(memory);
+}
+
+frozen_segment::~frozen_segment() noexcept
+{
+    detail::shared_memory::remove(_name);
+}
+
+const std::string& frozen_segment::name() const
+{
+    return _name;
+}
+
+frozen_value frozen_segment::get() const
+{
+    return frozen_value::load_image(_memory, _memory->contents(), "shared memory \"" + _name + "\"");
+}
+
+frozen_value attach_frozen(const std::string& name)
+{
+    auto memory = std::make_shared<const detail::shared_memory>(name);
+    return frozen_value::load_image(memory, memory->contents(), "shared memory \"" + name + "\"");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// frozen_value::array_iterator                                                                                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+frozen_value::array_iterator::array_iterator(const frozen_value& parent, std::size_t position) :
+        _current(parent._doc, position)
+{ }
+
+frozen_value::array_iterator& frozen_value::array_iterator::operator++()
+{
+    _current._position = _current.next();
+    return *this;
+}
+
+frozen_value::array_iterator frozen_value::array_iterator::operator++(int)
+{
+    array_iterator out = *this;
+    ++*this;
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// frozen_value::object_iterator                                                                                      //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+frozen_value::object_iterator::object_iterator(const frozen_value& parent, std::size_t position, std::size_t end) :
+        _current(string_view(), frozen_value(parent._doc, position)),
+        _position(position),
+        _end(end)
+{
+    load();
+}
+
+void frozen_value::object_iterator::load()
+{
+    if (_position == _end)
+        return;
+
+    const document& doc = *_current.second._doc;
+    _current.first            = doc.string_at(_position);
+    _current.second._position = doc.skip(_position);
+}
+
+frozen_value::object_iterator& frozen_value::object_iterator::operator++()
+{
+    _position = _current.second.next();
+    load();
+    return *this;
+}
+
+frozen_value::object_iterator frozen_value::object_iterator::operator++(int)
+{
+    object_iterator out = *this;
+    ++*this;
+    return out;
+}
+
+}
@@ -0,0 +1,101 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/key_dictionary.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace jsonv
+{
+
+namespace
+{
+
+/** FNV-1a, since \c std::hash can not look at a \c string_view without copying it into a \c std::string. **/
+struct view_hash
+{
+    std::size_t operator()(string_view text) const
+    {
+        std::uint64_t x = 14695981039346656037ULL;
+        for (char c : text)
+        {
+            x ^= static_cast<unsigned char>(c);
+            x *= 1099511628211ULL;
+        }
+        return std::size_t(x);
+    }
+};
+
+struct entry
+{
+    std::string encoded;
+    std::string decoded;
+};
+
+}
+
+struct key_dictionary::impl
+{
+    using lookup_map = std::unordered_map<string_view, const entry*, view_hash>;
+
+    size_type                       max_keys;
+    mutable std::shared_timed_mutex lock;
+    std::deque<entry>               entries;    //!< The storage for the keys -- \c lookup refers into it.
+    lookup_map                      lookup;
+};
+
+key_dictionary::key_dictionary(size_type max_keys) :
+        _impl(new impl)
+{
+    _impl->max_keys = max_keys;
+}
+
+key_dictionary::~key_dictionary() noexcept = default;
+
+const std::string* key_dictionary::find(string_view encoded) const
+{
+    std::shared_lock<std::shared_timed_mutex> guard(_impl->lock);
+    auto iter = _impl->lookup.find(encoded);
+    return iter == _impl->lookup.end() ? nullptr : &iter->second->decoded;
+}
+
+const std::string* key_dictionary::insert(string_view encoded, std::string decoded)
+{
+    std::unique_lock<std::shared_timed_mutex> guard(_impl->lock);
+    auto iter = _impl->lookup.find(encoded);
+    if (iter != _impl->lookup.end())
+        return &iter->second->decoded;
+    if (_impl->entries.size() >= _impl->max_keys)
+        return nullptr;
+
+    // a deque never moves its elements on insertion, so the view of the encoded text stays valid
+    _impl->entries.push_back({ std::string(encoded), std::move(decoded) });
+    const entry& added = _impl->entries.back();
+    _impl->lookup.emplace(string_view(added.encoded), &added);
+    return &added.decoded;
+}
+
+key_dictionary::size_type key_dictionary::size() const
+{
+    std::shared_lock<std::shared_timed_mutex> guard(_impl->lock);
+    return _impl->entries.size();
+}
+
+key_dictionary::size_type key_dictionary::max_size() const
+{
+    return _impl->max_keys;
+}
+
+}
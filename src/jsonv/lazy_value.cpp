@@ -0,0 +1,557 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/lazy_value.hpp>
+#include <jsonv/detail/number_convert.hpp>
+#include <jsonv/detail/structural_index.hpp>
+#include <jsonv/detail/token_patterns.hpp>
+
+#include "char_convert.hpp"
+#include "detail.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace jsonv
+{
+
+static constexpr std::size_t no_position = std::numeric_limits<std::size_t>::max();
+
+static bool is_whitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static string_view checked_input(string_view input)
+{
+    if (input.size() > detail::structural_index::max_input_size)
+        throw parse_error({ parse_error::problem(1, 1, 0, "Input is too large to be indexed") }, null);
+    return input;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// lazy_value::document                                                                                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct JSONV_LOCAL lazy_value::document
+{
+    using size_type = detail::structural_index::size_type;
+
+    std::shared_ptr<const std::string> owner;
+    string_view                        input;
+    parse_options                      options;
+    detail::structural_index           index;
+    std::vector<size_type>             partner;     //!< For a bracket, the position of the one matching it.
+
+    document(std::shared_ptr<const std::string> owner_, string_view input_, const parse_options& options_) :
+            owner(std::move(owner_)),
+            input(checked_input(input_)),
+            options(options_),
+            index(input)
+    {
+        const auto& offsets = index.offsets();
+        partner.resize(offsets.size(), size_type(0));
+
+        std::vector<size_type> open;
+        for (std::size_t pos = 0; pos < offsets.size(); ++pos)
+        {
+            char c = input[offsets[pos]];
+            if (c == '[' || c == '{')
+            {
+                open.push_back(size_type(pos));
+            }
+            else if (c == ']' || c == '}')
+            {
+                if (open.empty() || input[offsets[open.back()]] != (c == ']' ? '[' : '{'))
+                    fail(offsets[pos], std::string("Unexpected '") + c + "'");
+                partner[pos]         = open.back();
+                partner[open.back()] = size_type(pos);
+                open.pop_back();
+            }
+        }
+
+        if (!open.empty())
+            fail(offsets[open.back()], input[offsets[open.back()]] == '[' ? "Unexpected end: unmatched '['"
+                                                                          : "Unexpected end inside of object."
+                );
+    }
+
+    [[noreturn]]
+    void fail(std::size_t at, std::string message) const
+    {
+        tokenizer::location loc = { 1, 1, 0 };
+        detail::advance_location(loc, input.data(), input.data() + std::min(at, input.size()));
+        throw parse_error({ parse_error::problem(loc.line, loc.column, loc.character, std::move(message)) }, null);
+    }
+
+    std::size_t structural_count() const
+    {
+        return index.offsets().size();
+    }
+
+    std::size_t offset(std::size_t pos) const
+    {
+        if (pos >= structural_count())
+            fail(input.size(), "Unexpected end of input");
+        return index.offsets()[pos];
+    }
+
+    char structural(std::size_t pos) const
+    {
+        return input[offset(pos)];
+    }
+
+    std::size_t skip_whitespace(std::size_t from) const
+    {
+        while (from < input.size() && is_whitespace(input[from]))
+            ++from;
+        return from;
+    }
+
+    /** Find the value starting from the byte offset \a from, where \a next is the position of the first structural
+     *  character at or after \a from.
+     *
+     *  \param[out] begin The byte offset of the start of the value.
+     *  \param[out] end The byte offset just past the end of the value.
+     *  \param[out] position The position of the first character of the value if it is structural (a bracket or
+     *                       quote) or \c no_position if it is not.
+     *  \returns The position of the first structural character after the value.
+    **/
+    std::size_t read_value(std::size_t  from,
+                           std::size_t  next,
+                           std::size_t& begin,
+                           std::size_t& end,
+                           std::size_t& position
+                          ) const
+    {
+        begin = skip_whitespace(from);
+        if (begin == input.size())
+            fail(begin, "Unexpected end of input");
+
+        char c = input[begin];
+        if (c == '[' || c == '{')
+        {
+            if (offset(next) != begin)
+                fail(begin, "Invalid structure");
+            position = next;
+            std::size_t close = partner[next];
+            end = offset(close) + 1;
+            return close + 1;
+        }
+        else if (c == '\"')
+        {
+            if (offset(next) != begin || structural(next + 1) != '\"')
+                fail(begin, "Unterminated string");
+            position = next;
+            end      = offset(next + 1) + 1;
+            return next + 2;
+        }
+        else
+        {
+            // Scalars run up to the next structural character
+            position = no_position;
+            end      = next < structural_count() ? offset(next) : input.size();
+            while (end > begin && is_whitespace(input[end - 1]))
+                --end;
+            if (end == begin)
+                fail(begin, "Expecting a value");
+            return next;
+        }
+    }
+
+    /** Get the cursor for the first element of the array or object opened at \a open. **/
+    std::size_t first(std::size_t open) const
+    {
+        std::size_t close = partner[open];
+        if (open + 1 == close && skip_whitespace(offset(open) + 1) == offset(close))
+            return close;
+        else
+            return open;
+    }
+
+    /** Get the cursor for the element after the structural at \a next, which should be a separator or \a close. **/
+    std::size_t advance(std::size_t next, std::size_t close) const
+    {
+        if (next == close)
+            return close;
+        else if (next > close || structural(next) != ',')
+            fail(next < structural_count() ? offset(next) : input.size(),
+                 input[offset(close)] == ']' ? "Invalid entry when looking for ',' or ']'"
+                                             : "Invalid token while searching for next value in object."
+                );
+
+        if (next + 1 == close && skip_whitespace(offset(next) + 1) == offset(close))
+        {
+            if (options.comma_policy() != parse_options::commas::allow_trailing)
+                fail(offset(next), input[offset(close)] == ']' ? "Array contained a trailing comma"
+                                                               : "Trailing comma at end of object.");
+            return close;
+        }
+        return next;
+    }
+
+    /** Read the object entry after the structural at \a cursor.
+     *
+     *  \param[out] key The raw (undecoded) contents of the key.
+     *  \returns The position of the first structural character after the value.
+    **/
+    std::size_t read_entry(std::size_t  cursor,
+                           string_view& key,
+                           std::size_t& begin,
+                           std::size_t& end,
+                           std::size_t& position
+                          ) const
+    {
+        std::size_t key_begin = skip_whitespace(offset(cursor) + 1);
+        if (key_begin == input.size() || input[key_begin] != '\"' || offset(cursor + 1) != key_begin)
+            fail(key_begin, "Expecting a key");
+        if (structural(cursor + 2) != '\"')
+            fail(key_begin, "Unterminated string");
+        key = string_view(input.data() + key_begin + 1, offset(cursor + 2) - key_begin - 1);
+
+        if (structural(cursor + 3) != ':' || skip_whitespace(offset(cursor + 2) + 1) != offset(cursor + 3))
+            fail(offset(cursor + 2) + 1, "Invalid key-value delimiter...expecting ':' after key");
+
+        return read_value(offset(cursor + 3) + 1, cursor + 4, begin, end, position);
+    }
+
+    std::string decode_key(string_view key) const
+    {
+        try
+        {
+            return detail::get_string_decoder(options.string_encoding())(key);
+        }
+        catch (const detail::decode_error& err)
+        {
+            fail(std::size_t(key.data() - input.data()) + err.offset(), std::string("Error decoding string:") + err.what());
+        }
+    }
+
+    /** Is the raw \a key the same as the decoded \a expected? **/
+    bool key_matches(string_view key, string_view expected) const
+    {
+        if (std::find(key.begin(), key.end(), '\\') == key.end())
+            return key == expected;
+        else
+            return decode_key(key) == expected;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// lazy_value                                                                                                         //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+lazy_value::lazy_value(string_view input, const parse_options& options) :
+        lazy_value(std::make_shared<document>(nullptr, input, options), 0, 0, no_position)
+{ }
+
+lazy_value::lazy_value(std::shared_ptr<const std::string> input, const parse_options& options) :
+        lazy_value(std::make_shared<document>(input, *input, options), 0, 0, no_position)
+{ }
+
+lazy_value::lazy_value(std::shared_ptr<const document> doc, std::size_t begin, std::size_t end, std::size_t position) :
+        _doc(std::move(doc)),
+        _begin(begin),
+        _end(end),
+        _position(position)
+{
+    // The root is found here, since the public constructors do not know where it is yet
+    if (_begin == 0 && _end == 0)
+    {
+        if (_doc->skip_whitespace(0) == _doc->input.size())
+            _doc->fail(0, "No input");
+
+        std::size_t next = _doc->read_value(0, 0, _begin, _end, _position);
+        if (_doc->options.complete_parse()
+           && (next != _doc->structural_count() || _doc->skip_whitespace(_end) != _doc->input.size())
+           )
+            _doc->fail(_doc->skip_whitespace(_end), "Found non-trivial data after final token.");
+
+        if (_doc->options.require_document() && kind() != jsonv::kind::array && kind() != jsonv::kind::object)
+            _doc->fail(_begin, "JSON requires the root of a payload to be an array or object, not " + to_string(kind()));
+    }
+}
+
+lazy_value::lazy_value(const lazy_value&) = default;
+
+lazy_value& lazy_value::operator=(const lazy_value&) = default;
+
+lazy_value::lazy_value(lazy_value&&) noexcept = default;
+
+lazy_value& lazy_value::operator=(lazy_value&&) noexcept = default;
+
+lazy_value::~lazy_value() noexcept = default;
+
+jsonv::kind lazy_value::kind() const
+{
+    switch (_doc->input[_begin])
+    {
+    case '[':
+        return jsonv::kind::array;
+    case '{':
+        return jsonv::kind::object;
+    case '\"':
+        return jsonv::kind::string;
+    case 't':
+    case 'f':
+        return jsonv::kind::boolean;
+    case 'n':
+        return jsonv::kind::null;
+    default:
+    {
+        std::int64_t integer;
+        double       decimal;
+        switch (detail::convert_number(text(), integer, decimal))
+        {
+        case detail::number_convert_result::integer:
+            return jsonv::kind::integer;
+        case detail::number_convert_result::decimal:
+            return jsonv::kind::decimal;
+        case detail::number_convert_result::invalid:
+        default:
+            _doc->fail(_begin, "Encountered invalid token: \"" + std::string(text()) + "\"");
+        }
+    }
+    }
+}
+
+void lazy_value::check_kind(jsonv::kind expected) const
+{
+    check_type(expected, kind());
+}
+
+string_view lazy_value::text() const
+{
+    return _doc->input.substr(_begin, _end - _begin);
+}
+
+value lazy_value::to_value() const
+{
+    parse_options options = _doc->options;
+    options.require_document(false);
+    return parse(text(), options);
+}
+
+lazy_value lazy_value::at(size_type idx) const
+{
+    check_kind(jsonv::kind::array);
+
+    auto iter = begin_array();
+    for (auto end = end_array(); iter != end && idx > 0; ++iter, --idx)
+    { }
+    if (iter == end_array())
+        throw std::out_of_range("lazy_value::at: index out of range");
+    return *iter;
+}
+
+lazy_value lazy_value::operator[](size_type idx) const
+{
+    return at(idx);
+}
+
+lazy_value lazy_value::at(string_view key) const
+{
+    check_kind(jsonv::kind::object);
+
+    std::size_t close = _doc->partner[_position];
+    for (std::size_t cursor = _doc->first(_position); cursor != close; )
+    {
+        string_view entry_key;
+        std::size_t begin, end, position;
+        std::size_t next = _doc->read_entry(cursor, entry_key, begin, end, position);
+        if (_doc->key_matches(entry_key, key))
+            return lazy_value(_doc, begin, end, position);
+        cursor = _doc->advance(next, close);
+    }
+    throw std::out_of_range("lazy_value::at: key \"" + std::string(key) + "\" not found");
+}
+
+lazy_value lazy_value::operator[](string_view key) const
+{
+    return at(key);
+}
+
+lazy_value::size_type lazy_value::count(string_view key) const
+{
+    check_kind(jsonv::kind::object);
+
+    size_type   out   = 0;
+    std::size_t close = _doc->partner[_position];
+    for (std::size_t cursor = _doc->first(_position); cursor != close; )
+    {
+        string_view entry_key;
+        std::size_t begin, end, position;
+        std::size_t next = _doc->read_entry(cursor, entry_key, begin, end, position);
+        if (_doc->key_matches(entry_key, key))
+            ++out;
+        cursor = _doc->advance(next, close);
+    }
+    return out;
+}
+
+lazy_value lazy_value::at_path(const path& p) const
+{
+    lazy_value current = *this;
+    for (const path_element& elem : p)
+    {
+        if (elem.kind() == path_element_kind::array_index)
+            current = current.at(elem.index());
+        else
+            current = current.at(elem.key());
+    }
+    return current;
+}
+
+lazy_value lazy_value::at_path(string_view p) const
+{
+    return at_path(path::create(p));
+}
+
+lazy_value::size_type lazy_value::size() const
+{
+    switch (kind())
+    {
+    case jsonv::kind::array:
+        return size_type(std::distance(begin_array(), end_array()));
+    case jsonv::kind::object:
+        return size_type(std::distance(begin_object(), end_object()));
+    case jsonv::kind::string:
+        return to_value().size();
+    default:
+        check_type({ jsonv::kind::object, jsonv::kind::array, jsonv::kind::string }, kind());
+        return 0;
+    }
+}
+
+lazy_value::array_iterator lazy_value::begin_array() const
+{
+    check_kind(jsonv::kind::array);
+    return array_iterator(*this, _doc->first(_position));
+}
+
+lazy_value::array_iterator lazy_value::end_array() const
+{
+    check_kind(jsonv::kind::array);
+    return array_iterator(*this, _doc->partner[_position]);
+}
+
+lazy_value::object_iterator lazy_value::begin_object() const
+{
+    check_kind(jsonv::kind::object);
+    return object_iterator(*this, _doc->first(_position));
+}
+
+lazy_value::object_iterator lazy_value::end_object() const
+{
+    check_kind(jsonv::kind::object);
+    return object_iterator(*this, _doc->partner[_position]);
+}
+
+std::string lazy_value::as_string() const
+{
+    return to_value().as_string();
+}
+
+std::int64_t lazy_value::as_integer() const
+{
+    return to_value().as_integer();
+}
+
+double lazy_value::as_decimal() const
+{
+    return to_value().as_decimal();
+}
+
+bool lazy_value::as_boolean() const
+{
+    return to_value().as_boolean();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// lazy_value::array_iterator                                                                                         //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+lazy_value::array_iterator::array_iterator(const lazy_value& parent, std::size_t cursor) :
+        _current(parent),
+        _cursor(cursor),
+        _next(cursor),
+        _close(parent._doc->partner[parent._position])
+{
+    load();
+}
+
+void lazy_value::array_iterator::load()
+{
+    if (_cursor == _close)
+        return;
+
+    const document& doc = *_current._doc;
+    _next = doc.read_value(doc.offset(_cursor) + 1,
+                           _cursor + 1,
+                           _current._begin,
+                           _current._end,
+                           _current._position
+                          );
+}
+
+lazy_value::array_iterator& lazy_value::array_iterator::operator++()
+{
+    _cursor = _current._doc->advance(_next, _close);
+    load();
+    return *this;
+}
+
+lazy_value::array_iterator lazy_value::array_iterator::operator++(int)
+{
+    array_iterator clone = *this;
+    ++*this;
+    return clone;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// lazy_value::object_iterator                                                                                        //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+lazy_value::object_iterator::object_iterator(const lazy_value& parent, std::size_t cursor) :
+        _current(std::string(), parent),
+        _cursor(cursor),
+        _next(cursor),
+        _close(parent._doc->partner[parent._position])
+{
+    load();
+}
+
+void lazy_value::object_iterator::load()
+{
+    if (_cursor == _close)
+        return;
+
+    const document& doc = *_current.second._doc;
+    string_view     key;
+    _next = doc.read_entry(_cursor, key, _current.second._begin, _current.second._end, _current.second._position);
+    _current.first = doc.decode_key(key);
+}
+
+lazy_value::object_iterator& lazy_value::object_iterator::operator++()
+{
+    _cursor = _current.second._doc->advance(_next, _close);
+    load();
+    return *this;
+}
+
+lazy_value::object_iterator lazy_value::object_iterator::operator++(int)
+{
+    object_iterator clone = *this;
+    ++*this;
+    return clone;
+}
+
+}
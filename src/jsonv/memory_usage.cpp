@@ -0,0 +1,139 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/memory_usage.hpp>
+
+#include "array.hpp"
+#include "detail.hpp"
+#include "object.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace jsonv
+{
+
+/** Get the heap memory used by \a str, which is nothing if its contents are small enough to live inside of it. **/
+static std::size_t string_heap_bytes(const std::string& str, std::size_t& allocations)
+{
+    const char* self = reinterpret_cast<const char*>(&str);
+    std::less_equal<const char*> le;
+    std::less<const char*>       lt;
+    if (le(self, str.data()) && lt(str.data(), self + sizeof str))
+        return 0;
+    
+    ++allocations;
+    return str.capacity() + 1;
+}
+
+void detail::string_impl::add_memory_usage(std::size_t& bytes, std::size_t& allocations) const
+{
+    bytes += string_heap_bytes(_string, allocations);
+    if (const std::string* copy = _copy.load(std::memory_order_acquire))
+    {
+        ++allocations;
+        bytes += sizeof *copy + string_heap_bytes(*copy, allocations);
+    }
+}
+
+memory_breakdown& memory_breakdown::operator+=(const memory_breakdown& other)
+{
+    string_bytes += other.string_bytes;
+    object_bytes += other.object_bytes;
+    array_bytes  += other.array_bytes;
+    header_bytes += other.header_bytes;
+    allocations  += other.allocations;
+    return *this;
+}
+
+memory_breakdown memory_usage(const value& source)
+{
+    using object_entry = value::object_storage_type::value_type;
+    
+#if JSONV_OBJECT_FLAT_STORAGE
+    static constexpr std::size_t object_node_size = 0;
+#else
+    // a red-black tree node is the entry after a color and three links
+    static constexpr std::size_t object_node_size = sizeof(object_entry) + 4 * sizeof(void*);
+#endif
+    
+    memory_breakdown out;
+    std::vector<const value*> pending = { &source };
+    while (!pending.empty())
+    {
+        const value* current = pending.back();
+        pending.pop_back();
+        switch (current->_kind)
+        {
+        case jsonv::kind::object:
+        {
+            const auto& values = current->_data.object->_values;
+            out.header_bytes += sizeof(detail::object_impl);
+            ++out.allocations;
+#if JSONV_OBJECT_FLAT_STORAGE
+            if (values.capacity() > 0)
+            {
+                out.object_bytes += values.capacity() * sizeof(object_entry);
+                ++out.allocations;
+            }
+#else
+            out.object_bytes += values.size() * object_node_size;
+            out.allocations  += values.size();
+#endif
+            for (const auto& entry : values)
+            {
+                out.string_bytes += string_heap_bytes(entry.first, out.allocations);
+                pending.push_back(&entry.second);
+            }
+            break;
+        }
+        case jsonv::kind::array:
+        {
+            const detail::array_impl* impl = detail::as_const(current->_data.array);
+            out.header_bytes += sizeof(detail::array_impl);
+            ++out.allocations;
+            if (const detail::array_impl::packed_numbers* numbers = impl->packed())
+            {
+                out.array_bytes += sizeof *numbers
+                                 + numbers->integers.capacity() * sizeof(std::int64_t)
+                                 + numbers->decimals.capacity() * sizeof(double);
+                out.allocations += 2;
+            }
+            
+            // Packed elements might not have been made into values yet (and are only numbers if they have)
+            const detail::array_impl::array_type* made = impl->made_values();
+            if (!made)
+                break;
+            const auto& values = *made;
+            if (values.capacity() > 0)
+            {
+                out.array_bytes += values.capacity() * sizeof(value);
+                ++out.allocations;
+            }
+            for (const value& element : values)
+                pending.push_back(&element);
+            break;
+        }
+        case jsonv::kind::string:
+            out.header_bytes += sizeof(detail::string_impl);
+            ++out.allocations;
+            current->_data.string->add_memory_usage(out.string_bytes, out.allocations);
+            break;
+        case jsonv::kind::integer:
+        case jsonv::kind::decimal:
+        case jsonv::kind::boolean:
+        case jsonv::kind::null:
+            break;
+        }
+    }
+    return out;
+}
+
+}
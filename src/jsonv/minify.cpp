@@ -0,0 +1,47 @@
+/** \file
+ *  Removing the whitespace and comments from JSON text without parsing it into a \c value.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/parse.hpp>
+#include <jsonv/tokenizer.hpp>
+
+#include "detail/syntax_validator.hpp"
+
+namespace jsonv
+{
+
+void minify(string_view input, std::string& out, const parse_options& options)
+{
+    detail::syntax_validator validator(input, options);
+    tokenizer                tokens(input);
+    tokenizer::token         batch[64];
+
+    // Tokens are copied as they are, so the output is never longer than the input
+    out.reserve(out.size() + input.size());
+    while (std::size_t count = tokens.next_batch(batch, validator.skipped_tokens()))
+    {
+        for (std::size_t idx = 0; idx < count; ++idx)
+        {
+            // Anything accepted after the document is the padding at the end of the input
+            bool after_document = validator.complete();
+            if (!validator.accept(batch[idx]))
+                throw parse_error({ validator.problem() }, null);
+            if (!after_document)
+                out.append(batch[idx].text.data(), batch[idx].text.size());
+            if (validator.complete() && !options.complete_parse())
+                return;
+        }
+    }
+
+    if (!validator.finish())
+        throw parse_error({ validator.problem() }, null);
+}
+
+}
@@ -0,0 +1,627 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/msgpack.hpp>
+#include <jsonv/value.hpp>
+
+#include "detail/output_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jsonv
+{
+
+// The format codes of the MessagePack specification which are not part of a "fix" range
+static constexpr unsigned char msgpack_nil      = 0xc0;
+static constexpr unsigned char msgpack_false    = 0xc2;
+static constexpr unsigned char msgpack_true     = 0xc3;
+static constexpr unsigned char msgpack_float32  = 0xca;
+static constexpr unsigned char msgpack_float64  = 0xcb;
+static constexpr unsigned char msgpack_uint8    = 0xcc;
+static constexpr unsigned char msgpack_uint16   = 0xcd;
+static constexpr unsigned char msgpack_uint32   = 0xce;
+static constexpr unsigned char msgpack_uint64   = 0xcf;
+static constexpr unsigned char msgpack_int8     = 0xd0;
+static constexpr unsigned char msgpack_int16    = 0xd1;
+static constexpr unsigned char msgpack_int32    = 0xd2;
+static constexpr unsigned char msgpack_int64    = 0xd3;
+static constexpr unsigned char msgpack_str8     = 0xd9;
+static constexpr unsigned char msgpack_str16    = 0xda;
+static constexpr unsigned char msgpack_str32    = 0xdb;
+static constexpr unsigned char msgpack_array16  = 0xdc;
+static constexpr unsigned char msgpack_array32  = 0xdd;
+static constexpr unsigned char msgpack_map16    = 0xde;
+static constexpr unsigned char msgpack_map32    = 0xdf;
+
+static constexpr unsigned char msgpack_fixmap   = 0x80;
+static constexpr unsigned char msgpack_fixarray = 0x90;
+static constexpr unsigned char msgpack_fixstr   = 0xa0;
+
+/** The longest head of anything: a code and an 8-byte argument. **/
+static constexpr std::size_t msgpack_max_head = 9;
+
+/** The most entries reserved up front for an array or map. Every nested head can claim the rest of the input, so
+ *  reserving its whole length would take memory quadratic in the input; larger containers grow as their entries arrive.
+**/
+static constexpr std::uint64_t msgpack_max_reserve = 16;
+
+/** Write \a code followed by the low \a bytes of \a x (big-endian) to \a out.
+ *
+ *  \returns The number of bytes written.
+**/
+static std::size_t format_code(char* out, unsigned char code, std::uint64_t x, std::size_t bytes)
+{
+    out[0] = static_cast<char>(code);
+    for (std::size_t idx = 0; idx < bytes; ++idx)
+        out[bytes - idx] = static_cast<char>((x >> (8 * idx)) & 0xffU);
+    return bytes + 1;
+}
+
+static std::size_t format_string_head(char* out, std::size_t length)
+{
+    if (length < 32)
+        return format_code(out, static_cast<unsigned char>(msgpack_fixstr | length), 0, 0);
+    else if (length <= 0xffU)
+        return format_code(out, msgpack_str8, length, 1);
+    else if (length <= 0xffffU)
+        return format_code(out, msgpack_str16, length, 2);
+    else if (length <= 0xffffffffU)
+        return format_code(out, msgpack_str32, length, 4);
+    else
+        throw std::length_error("String is too long for MessagePack");
+}
+
+static std::size_t format_container_head(char* out, bool is_object, std::size_t count)
+{
+    if (count < 16)
+    {
+        unsigned char fix = is_object ? msgpack_fixmap : msgpack_fixarray;
+        return format_code(out, static_cast<unsigned char>(fix | count), 0, 0);
+    }
+    else if (count <= 0xffffU)
+        return format_code(out, is_object ? msgpack_map16 : msgpack_array16, count, 2);
+    else if (count <= 0xffffffffU)
+        return format_code(out, is_object ? msgpack_map32 : msgpack_array32, count, 4);
+    else
+        throw std::length_error("Container is too large for MessagePack");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// msgpack_encoder                                                                                                    //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+msgpack_encoder::msgpack_encoder(std::string& output) :
+        msgpack_encoder([&output] (string_view chunk) { output.append(chunk.data(), chunk.size()); })
+{ }
+
+msgpack_encoder::msgpack_encoder(flush_function flush, std::size_t chunk_size) :
+        _buffer(new detail::output_buffer(chunk_size, std::move(flush))),
+        _unsized_open(0)
+{ }
+
+msgpack_encoder::~msgpack_encoder() noexcept
+{
+    try
+    {
+        _buffer->flush();
+    }
+    catch (...)
+    {
+        // nothing can be done about it here -- callers who care should call flush themselves
+    }
+}
+
+void msgpack_encoder::flush()
+{
+    _buffer->flush();
+}
+
+std::size_t msgpack_encoder::size() const
+{
+    return _buffer->size();
+}
+
+void msgpack_encoder::write_bytes(const char* data, std::size_t length)
+{
+    if (_unsized_open > 0)
+        _pending.append(data, length);
+    else
+        _buffer->write(data, length);
+}
+
+void msgpack_encoder::start_entry(bool is_key)
+{
+    // An object is counted by its keys, an array by its values
+    if (!_open.empty() && !_open.back().sized && _open.back().is_object == is_key)
+        ++_open.back().count;
+}
+
+void msgpack_encoder::begin_container(bool is_object, bool sized, std::size_t count)
+{
+    start_entry(false);
+    if (sized)
+    {
+        char head[msgpack_max_head];
+        write_bytes(head, format_container_head(head, is_object, count));
+        _open.push_back(open_container{ is_object, true, 0, 0 });
+    }
+    else
+    {
+        _open.push_back(open_container{ is_object, false, 0, _pending.size() });
+        ++_unsized_open;
+    }
+}
+
+void msgpack_encoder::end_container()
+{
+    open_container done = _open.back();
+    _open.pop_back();
+    if (done.sized)
+        return;
+
+    // Now that the size is known, the head goes in front of the contents
+    char head[msgpack_max_head];
+    _pending.insert(done.start, head, format_container_head(head, done.is_object, done.count));
+    if (--_unsized_open == 0)
+    {
+        _buffer->write(_pending.data(), _pending.size());
+        _pending.clear();
+    }
+}
+
+void msgpack_encoder::write_array_begin()
+{
+    begin_container(false, false, 0);
+}
+
+void msgpack_encoder::write_array_begin_sized(std::size_t count)
+{
+    begin_container(false, true, count);
+}
+
+void msgpack_encoder::write_array_end()
+{
+    end_container();
+}
+
+void msgpack_encoder::write_array_delimiter()
+{ }
+
+void msgpack_encoder::write_boolean(bool value)
+{
+    start_entry(false);
+    char code = static_cast<char>(value ? msgpack_true : msgpack_false);
+    write_bytes(&code, 1);
+}
+
+void msgpack_encoder::write_decimal(double value)
+{
+    start_entry(false);
+    char  out[msgpack_max_head];
+    float narrow = static_cast<float>(value);
+    if (std::isnan(value) || static_cast<double>(narrow) == value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &narrow, sizeof bits);
+        write_bytes(out, format_code(out, msgpack_float32, bits, 4));
+    }
+    else
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        write_bytes(out, format_code(out, msgpack_float64, bits, 8));
+    }
+}
+
+void msgpack_encoder::write_integer(std::int64_t value)
+{
+    start_entry(false);
+    char        out[msgpack_max_head];
+    std::size_t length;
+    if (value >= 0)
+    {
+        std::uint64_t x = static_cast<std::uint64_t>(value);
+        if (x < 0x80U)
+            length = format_code(out, static_cast<unsigned char>(x), 0, 0);
+        else if (x <= 0xffU)
+            length = format_code(out, msgpack_uint8, x, 1);
+        else if (x <= 0xffffU)
+            length = format_code(out, msgpack_uint16, x, 2);
+        else if (x <= 0xffffffffU)
+            length = format_code(out, msgpack_uint32, x, 4);
+        else
+            length = format_code(out, msgpack_uint64, x, 8);
+    }
+    else
+    {
+        // format_code takes the low bytes, which is the two's complement of the narrower type
+        std::uint64_t x = static_cast<std::uint64_t>(value);
+        if (value >= -32)
+            length = format_code(out, static_cast<unsigned char>(x & 0xffU), 0, 0);
+        else if (value >= std::numeric_limits<std::int8_t>::min())
+            length = format_code(out, msgpack_int8, x, 1);
+        else if (value >= std::numeric_limits<std::int16_t>::min())
+            length = format_code(out, msgpack_int16, x, 2);
+        else if (value >= std::numeric_limits<std::int32_t>::min())
+            length = format_code(out, msgpack_int32, x, 4);
+        else
+            length = format_code(out, msgpack_int64, x, 8);
+    }
+    write_bytes(out, length);
+}
+
+void msgpack_encoder::write_null()
+{
+    start_entry(false);
+    char code = static_cast<char>(msgpack_nil);
+    write_bytes(&code, 1);
+}
+
+void msgpack_encoder::write_object_begin()
+{
+    begin_container(true, false, 0);
+}
+
+void msgpack_encoder::write_object_begin_sized(std::size_t count)
+{
+    begin_container(true, true, count);
+}
+
+void msgpack_encoder::write_object_end()
+{
+    end_container();
+}
+
+void msgpack_encoder::write_object_delimiter()
+{ }
+
+void msgpack_encoder::write_object_key(string_view key)
+{
+    start_entry(true);
+    char head[msgpack_max_head];
+    write_bytes(head, format_string_head(head, key.size()));
+    write_bytes(key.data(), key.size());
+}
+
+void msgpack_encoder::write_string(string_view value)
+{
+    start_entry(false);
+    char head[msgpack_max_head];
+    write_bytes(head, format_string_head(head, value.size()));
+    write_bytes(value.data(), value.size());
+}
+
+std::string encode_msgpack(const value& source)
+{
+    std::string out;
+    msgpack_encoder encoder(out);
+    encoder.encode(source);
+    encoder.flush();
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// parse_msgpack                                                                                                      //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/** Reads a MessagePack document into a \c value, keeping nesting on an explicit stack (like \c parse_cbor). **/
+class msgpack_reader
+{
+public:
+    msgpack_reader(string_view input, const parse_options& options, bool borrow, std::shared_ptr<const void> owner) :
+            _begin(input.data()),
+            _current(input.data()),
+            _end(input.data() + input.size()),
+            _options(options),
+            _borrow(borrow),
+            _owner(std::move(owner))
+    { }
+
+    value read_document()
+    {
+        std::vector<frame> stack;
+        value              result;
+        while (true)
+        {
+            const char*   head     = _current;
+            unsigned char code     = read_byte();
+            bool          want_key = !stack.empty() && stack.back().container.kind() == kind::object
+                                  && !stack.back().have_key;
+
+            std::uint64_t length;
+            if (is_string(code, length))
+            {
+                string_view text = read_string(length);
+                if (want_key)
+                {
+                    stack.back().key.assign(text.data(), text.size());
+                    stack.back().have_key = true;
+                    continue;
+                }
+                if (deliver(stack, make_string(text), result))
+                    break;
+                continue;
+            }
+            else if (want_key)
+            {
+                fail(head, "Object keys must be strings");
+            }
+
+            bool is_object;
+            if (is_container(code, is_object, length))
+            {
+                // Every entry takes at least a byte, so a size larger than the rest of the input is corrupt
+                if (length > std::uint64_t(_end - _current) / (is_object ? 2 : 1))
+                    fail(head, "Size of ", length, " is larger than the rest of the input");
+                if (_options.max_structure_depth() > 0 && stack.size() + 1 >= _options.max_structure_depth())
+                    fail(head, "Structure depth reached maximum of ", stack.size() + 1);
+
+                value container = is_object ? object() : array();
+                if (length > 0)
+                {
+                    container.reserve(static_cast<value::size_type>(std::min(length, msgpack_max_reserve)));
+                    stack.push_back(frame{ std::move(container), length, false, std::string() });
+                    continue;
+                }
+                if (deliver(stack, std::move(container), result))
+                    break;
+                continue;
+            }
+
+            if (deliver(stack, read_scalar(code, head), result))
+                break;
+        }
+
+        if (_options.complete_parse() && _current != _end)
+            fail(_current, "Found extra data after the value");
+        return result;
+    }
+
+private:
+    struct frame
+    {
+        value         container;
+        std::uint64_t remaining;  //!< Elements (or key-value pairs) left to read
+        bool          have_key;   //!< For objects: has the key of the next entry been read?
+        std::string   key;
+    };
+
+    /** Add \a item to the container on the top of the \a stack, finishing any containers which are now full.
+     *
+     *  \returns \c true if the top-level item is done (and it is in \a result).
+    **/
+    static bool deliver(std::vector<frame>& stack, value item, value& result)
+    {
+        while (!stack.empty())
+        {
+            frame& top = stack.back();
+            if (top.container.kind() == kind::array)
+            {
+                top.container.push_back(std::move(item));
+            }
+            else
+            {
+                top.container.insert({ std::move(top.key), std::move(item) });
+                top.have_key = false;
+            }
+
+            if (--top.remaining != 0)
+                return false;
+
+            item = std::move(top.container);
+            stack.pop_back();
+        }
+        result = std::move(item);
+        return true;
+    }
+
+    template <typename... T>
+    [[noreturn]] void fail(const char* where, T&&... message) const
+    {
+        std::ostringstream stream;
+        (void) std::initializer_list<int> { ((stream << std::forward<T>(message)), 0)... };
+        std::size_t offset = std::size_t(where - _begin);
+        throw parse_error({ parse_error::problem(1, offset + 1, offset, stream.str()) }, null);
+    }
+
+    unsigned char read_byte()
+    {
+        if (_current == _end)
+            fail(_current, "Unexpected end of input");
+        return static_cast<unsigned char>(*_current++);
+    }
+
+    std::uint64_t read_uint(std::size_t bytes)
+    {
+        if (std::size_t(_end - _current) < bytes)
+            fail(_end, "Unexpected end of input");
+
+        std::uint64_t out = 0;
+        for (std::size_t idx = 0; idx < bytes; ++idx)
+            out = (out << 8) | static_cast<unsigned char>(_current[idx]);
+        _current += bytes;
+        return out;
+    }
+
+    bool is_string(unsigned char code, std::uint64_t& length)
+    {
+        if ((code & 0xe0U) == msgpack_fixstr)
+            length = code & 0x1fU;
+        else if (code == msgpack_str8)
+            length = read_uint(1);
+        else if (code == msgpack_str16)
+            length = read_uint(2);
+        else if (code == msgpack_str32)
+            length = read_uint(4);
+        else
+            return false;
+        return true;
+    }
+
+    bool is_container(unsigned char code, bool& is_object, std::uint64_t& length)
+    {
+        if ((code & 0xf0U) == msgpack_fixmap || (code & 0xf0U) == msgpack_fixarray)
+        {
+            is_object = (code & 0xf0U) == msgpack_fixmap;
+            length    = code & 0x0fU;
+        }
+        else if (code == msgpack_array16 || code == msgpack_map16)
+        {
+            is_object = code == msgpack_map16;
+            length    = read_uint(2);
+        }
+        else if (code == msgpack_array32 || code == msgpack_map32)
+        {
+            is_object = code == msgpack_map32;
+            length    = read_uint(4);
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    string_view read_string(std::uint64_t length)
+    {
+        if (length > std::uint64_t(_end - _current))
+            fail(_current, "String of length ", length, " is longer than the rest of the input");
+        string_view out(_current, std::size_t(length));
+        _current += length;
+        return out;
+    }
+
+    value make_string(string_view text) const
+    {
+        if (_borrow)
+            return detail::make_borrowed_string(text, _owner);
+        else
+            return std::string(text.data(), text.size());
+    }
+
+    static value from_unsigned(std::uint64_t x)
+    {
+        if (x <= std::uint64_t(std::numeric_limits<std::int64_t>::max()))
+            return static_cast<std::int64_t>(x);
+        else
+            return static_cast<double>(x);
+    }
+
+    value read_scalar(unsigned char code, const char* head)
+    {
+        if (code < 0x80U)
+            return static_cast<std::int64_t>(code);
+        else if (code >= 0xe0U)
+            return static_cast<std::int64_t>(static_cast<std::int8_t>(code));
+
+        switch (code)
+        {
+        case msgpack_nil:
+            return null;
+        case msgpack_false:
+            return false;
+        case msgpack_true:
+            return true;
+        case msgpack_uint8:
+            return from_unsigned(read_uint(1));
+        case msgpack_uint16:
+            return from_unsigned(read_uint(2));
+        case msgpack_uint32:
+            return from_unsigned(read_uint(4));
+        case msgpack_uint64:
+            return from_unsigned(read_uint(8));
+        case msgpack_int8:
+            return static_cast<std::int64_t>(static_cast<std::int8_t>(read_uint(1)));
+        case msgpack_int16:
+            return static_cast<std::int64_t>(static_cast<std::int16_t>(read_uint(2)));
+        case msgpack_int32:
+            return static_cast<std::int64_t>(static_cast<std::int32_t>(read_uint(4)));
+        case msgpack_int64:
+            return static_cast<std::int64_t>(read_uint(8));
+        case msgpack_float32:
+        {
+            std::uint32_t bits = static_cast<std::uint32_t>(read_uint(4));
+            float         narrow;
+            std::memcpy(&narrow, &bits, sizeof narrow);
+            return check_finite(narrow, head);
+        }
+        case msgpack_float64:
+        {
+            std::uint64_t bits = read_uint(8);
+            double        decimal;
+            std::memcpy(&decimal, &bits, sizeof decimal);
+            return check_finite(decimal, head);
+        }
+        case 0xc4:
+        case 0xc5:
+        case 0xc6:
+            fail(head, "Binary data is not supported");
+        case 0xc7:
+        case 0xc8:
+        case 0xc9:
+        case 0xd4:
+        case 0xd5:
+        case 0xd6:
+        case 0xd7:
+        case 0xd8:
+            fail(head, "Extension types are not supported");
+        default:
+            fail(head, "Invalid format code ", unsigned(code));
+        }
+    }
+
+    value check_finite(double decimal, const char* head) const
+    {
+        if (_options.require_finite_numbers() && !std::isfinite(decimal))
+            fail(head, "Number ", decimal, " is not finite");
+        return decimal;
+    }
+
+private:
+    const char*                 _begin;
+    const char*                 _current;
+    const char*                 _end;
+    const parse_options&        _options;
+    bool                        _borrow;
+    std::shared_ptr<const void> _owner;
+};
+
+}
+
+value parse_msgpack(string_view input, const parse_options& options)
+{
+    switch (options.string_storage())
+    {
+    case parse_options::strings::borrow:
+        return msgpack_reader(input, options, true, nullptr).read_document();
+    case parse_options::strings::share:
+    {
+        auto buffer = std::make_shared<const std::string>(input.data(), input.size());
+        return msgpack_reader(*buffer, options, true, buffer).read_document();
+    }
+    case parse_options::strings::copy:
+    default:
+        return msgpack_reader(input, options, false, nullptr).read_document();
+    }
+}
+
+}
@@ -0,0 +1,233 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/ndjson_writer.hpp>
+#include <jsonv/encode.hpp>
+#include <jsonv/value.hpp>
+#include <jsonv/writer.hpp>
+#include <jsonv/detail/scope_exit.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace jsonv
+{
+namespace detail
+{
+
+class ndjson_lines;
+
+/** What an \c ndjson_writer shares with the buffers of the threads writing to it. **/
+class ndjson_state
+{
+public:
+    ndjson_state(ndjson_writer::sink_function sink, std::size_t batch_size);
+
+    /** Get the buffer of the calling thread, creating it if this is the first time the thread has written. **/
+    ndjson_lines& local();
+
+    /** Hand what is in every thread's buffer to the sink. **/
+    void flush();
+
+public:
+    ndjson_writer::sink_function sink;
+    std::mutex                   sink_lock;     //!< Held while calling the \c sink.
+    std::size_t                  batch_size;
+
+private:
+    std::uint64_t                              _id;     //!< Unique to this instance (addresses can be reused).
+    std::mutex                                 _lines_lock;
+    std::vector<std::shared_ptr<ndjson_lines>> _lines;
+};
+
+/** The buffer of one thread. Lines are encoded straight into the block of the \c buffer_encoder. When a line does not
+ *  fit in what is left of the block, the block is moved to \c _spill so the line is not split between batches.
+**/
+class ndjson_lines :
+        public buffer_encoder
+{
+public:
+    explicit ndjson_lines(ndjson_state& state) :
+            buffer_encoder([this] (string_view chunk) { take(chunk); }, state.batch_size),
+            _state(state),
+            _direct(false)
+    { }
+
+    /** Write a line with \a write, which is given this encoder. If it throws, the line is taken back. **/
+    template <typename FWrite>
+    void write_line(FWrite&& write)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        std::size_t start   = size();
+        std::size_t spilled = _spill.size();
+        try
+        {
+            write(static_cast<encoder&>(*this));
+            write_raw_json("\n");
+        }
+        catch (...)
+        {
+            // Everything in the block before the line was spilled along with the start of the line
+            if (_spill.size() == spilled)
+            {
+                truncate(start);
+            }
+            else
+            {
+                _spill.resize(spilled + start);
+                truncate(0);
+            }
+            throw;
+        }
+
+        if (!_spill.empty() || size() >= _state.batch_size / 2)
+            ship();
+    }
+
+    /** Hand the lines in this buffer to the sink. The \c lock must be held. **/
+    void ship()
+    {
+        std::lock_guard<std::mutex> guard(_state.sink_lock);
+        if (!_spill.empty())
+        {
+            _state.sink(_spill);
+            _spill.clear();
+        }
+
+        _direct = true;
+        auto reset = on_scope_exit([this] { _direct = false; });
+        buffer_encoder::flush();
+    }
+
+public:
+    /** Only the thread which owns this buffer locks it, except during a \c flush. **/
+    std::mutex lock;
+
+private:
+    void take(string_view chunk)
+    {
+        if (_direct)
+            _state.sink(chunk);
+        else
+            _spill.append(chunk.data(), chunk.size());
+    }
+
+private:
+    ndjson_state& _state;
+    std::string   _spill;
+    bool          _direct;   //!< Should a flush of the block go straight to the sink?
+};
+
+/** A buffer of the thread for the \c ndjson_state with the unique \c owner. **/
+struct ndjson_slot
+{
+    std::uint64_t               owner;
+    ndjson_lines*               lines;
+    std::weak_ptr<ndjson_lines> alive;   //!< Used to clear out slots for instances which are gone.
+};
+
+static std::atomic<std::uint64_t> ndjson_next_id(1);
+
+static thread_local std::vector<ndjson_slot> ndjson_slots;
+
+ndjson_state::ndjson_state(ndjson_writer::sink_function sink, std::size_t batch_size) :
+        sink(std::move(sink)),
+        batch_size(std::max<std::size_t>(batch_size, 64)),
+        _id(ndjson_next_id++)
+{ }
+
+ndjson_lines& ndjson_state::local()
+{
+    // A matching owner can only be this instance, which is alive, so its buffer is as well
+    for (const ndjson_slot& slot : ndjson_slots)
+        if (slot.owner == _id)
+            return *slot.lines;
+
+    auto created = std::make_shared<ndjson_lines>(*this);
+    {
+        std::lock_guard<std::mutex> guard(_lines_lock);
+        _lines.push_back(created);
+    }
+    ndjson_slots.erase(std::remove_if(ndjson_slots.begin(), ndjson_slots.end(),
+                                      [] (const ndjson_slot& slot) { return slot.alive.expired(); }
+                                     ),
+                       ndjson_slots.end()
+                      );
+    ndjson_slots.push_back({ _id, created.get(), created });
+    return *created;
+}
+
+void ndjson_state::flush()
+{
+    std::vector<std::shared_ptr<ndjson_lines>> all;
+    {
+        std::lock_guard<std::mutex> guard(_lines_lock);
+        all = _lines;
+    }
+
+    for (const auto& lines : all)
+    {
+        std::lock_guard<std::mutex> guard(lines->lock);
+        lines->ship();
+    }
+}
+
+}
+
+ndjson_writer::ndjson_writer(std::ostream& output, std::size_t batch_size) :
+        ndjson_writer([&output] (string_view chunk) { output.write(chunk.data(), chunk.size()); }, batch_size)
+{ }
+
+ndjson_writer::ndjson_writer(sink_function sink, std::size_t batch_size) :
+        _state(std::make_shared<detail::ndjson_state>(std::move(sink), batch_size))
+{ }
+
+ndjson_writer::~ndjson_writer() noexcept
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        // nothing can be done about it here -- callers who care should call flush themselves
+    }
+}
+
+void ndjson_writer::write(const value& line)
+{
+    _state->local().write_line([&line] (encoder& out) { out.encode(line); });
+}
+
+void ndjson_writer::write_with(const std::function<void (writer&)>& write)
+{
+    _state->local().write_line([&write] (encoder& out)
+                               {
+                                   writer line(out);
+                                   write(line);
+                                   if (!line.complete())
+                                       throw std::logic_error("ndjson_writer::write_with must write a complete document");
+                               }
+                              );
+}
+
+void ndjson_writer::flush()
+{
+    _state->flush();
+}
+
+}
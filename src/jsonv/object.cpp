@@ -89,10 +89,27 @@ value object(std::initializer_list<std::pair<std::wstring, value>> source)
     return x;
 }
 
+/** Make the object storage \a impl unique before changing it. If that copies the storage, \a position (which might have
+ *  come from a const accessor, so refer to the storage which was shared) is moved to the same entry of the copy.
+**/
+static detail::object_impl::const_iterator unshare_at(detail::object_impl*&             impl,
+                                                      detail::object_impl::const_iterator position
+                                                     )
+{
+    if (!impl->shared())
+        return position;
+    
+    // the key has to be taken before letting go of the old storage, since another value might delete it
+    bool        at_end = position == impl->_values.end();
+    std::string key    = at_end ? std::string() : position->first;
+    detail::unshare(impl);
+    return at_end ? impl->_values.end() : impl->_values.find(key);
+}
+
 value::object_iterator value::begin_object()
 {
     check_type(jsonv::kind::object, kind());
-    return object_iterator(_data.object->_values.begin());
+    return object_iterator(detail::pin(_data.object)->_values.begin());
 }
 
 value::const_object_iterator value::begin_object() const
@@ -104,7 +121,7 @@ value::const_object_iterator value::begin_object() const
 value::object_iterator value::end_object()
 {
     check_type(jsonv::kind::object, kind());
-    return object_iterator(_data.object->_values.end());
+    return object_iterator(detail::pin(_data.object)->_values.end());
 }
 
 value::const_object_iterator value::end_object() const
@@ -132,40 +149,51 @@ value::owning_object_view value::as_object() &&
                              );
 }
 
-value& value::operator[](const std::string& key)
+value& value::operator[](string_view key)
 {
     check_type(jsonv::kind::object, kind());
-    return _data.object->_values[key];
+    auto& values = detail::pin(_data.object)->_values;
+    auto  iter   = values.lower_bound(key);
+    if (iter == values.end() || values.key_comp()(key, iter->first))
+        iter = values.insert(iter, { std::string(key), value() });
+    return iter->second;
 }
 
 value& value::operator[](std::string&& key)
 {
     check_type(jsonv::kind::object, kind());
-    return _data.object->_values[std::move(key)];
+    return detail::pin(_data.object)->_values[std::move(key)];
 }
 
 value& value::operator[](const std::wstring& key)
 {
     check_type(jsonv::kind::object, kind());
-    return _data.object->_values[detail::convert_to_narrow(key)];
+    return detail::pin(_data.object)->_values[detail::convert_to_narrow(key)];
 }
 
-value& value::at(const std::string& key)
+value& value::at(string_view key)
 {
     check_type(jsonv::kind::object, kind());
-    return _data.object->_values.at(key);
+    auto& values = detail::pin(_data.object)->_values;
+    auto  iter   = values.find(key);
+    if (iter == values.end())
+        throw std::out_of_range("value::at: key \"" + std::string(key) + "\" not found");
+    return iter->second;
 }
 
-const value& value::at(const std::string& key) const
+const value& value::at(string_view key) const
 {
     check_type(jsonv::kind::object, kind());
-    return _data.object->_values.at(key);
+    auto iter = _data.object->_values.find(key);
+    if (iter == _data.object->_values.end())
+        throw std::out_of_range("value::at: key \"" + std::string(key) + "\" not found");
+    return iter->second;
 }
 
 value& value::at(const std::wstring& key)
 {
     check_type(jsonv::kind::object, kind());
-    return _data.object->_values.at(detail::convert_to_narrow(key));
+    return detail::pin(_data.object)->_values.at(detail::convert_to_narrow(key));
 }
 
 const value& value::at(const std::wstring& key) const
@@ -174,7 +202,7 @@ const value& value::at(const std::wstring& key) const
     return _data.object->_values.at(detail::convert_to_narrow(key));
 }
 
-value::size_type value::count(const std::string& key) const
+value::size_type value::count(string_view key) const
 {
     check_type(jsonv::kind::object, kind());
     return _data.object->_values.count(key);
@@ -186,19 +214,19 @@ value::size_type value::count(const std::wstring& key) const
     return _data.object->_values.count(detail::convert_to_narrow(key));
 }
 
-value::object_iterator value::find(const std::string& key)
+value::object_iterator value::find(string_view key)
 {
     check_type(jsonv::kind::object, kind());
-    return object_iterator(_data.object->_values.find(key));
+    return object_iterator(detail::pin(_data.object)->_values.find(key));
 }
 
 value::object_iterator value::find(const std::wstring& key)
 {
     check_type(jsonv::kind::object, kind());
-    return object_iterator(_data.object->_values.find(detail::convert_to_narrow(key)));
+    return object_iterator(detail::pin(_data.object)->_values.find(detail::convert_to_narrow(key)));
 }
 
-value::const_object_iterator value::find(const std::string& key) const
+value::const_object_iterator value::find(string_view key) const
 {
     check_type(jsonv::kind::object, kind());
     return const_object_iterator(_data.object->_values.find(key));
@@ -213,7 +241,8 @@ value::const_object_iterator value::find(const std::wstring& key) const
 value::object_iterator value::insert(value::const_object_iterator hint, std::pair<std::string, value> pair)
 {
     check_type(jsonv::kind::object, kind());
-    return object_iterator(_data.object->_values.insert(hint._impl, std::move(pair)));
+    auto place = unshare_at(_data.object, hint._impl);
+    return object_iterator(detail::pin(_data.object)->_values.insert(place, std::move(pair)));
 }
 
 value::object_iterator value::insert(value::const_object_iterator hint, std::pair<std::wstring, value> pair)
@@ -225,20 +254,41 @@ value::object_iterator value::insert(value::const_object_iterator hint, std::pai
 std::pair<value::object_iterator, bool> value::insert(std::pair<std::string, value> pair)
 {
     check_type(jsonv::kind::object, kind());
-    auto ret = _data.object->_values.insert(pair);
+    auto ret = detail::pin(_data.object)->_values.insert(pair);
     return { object_iterator(ret.first), ret.second };
 }
 
 std::pair<value::object_iterator, bool> value::insert(std::pair<std::wstring, value> pair)
 {
     check_type(jsonv::kind::object, kind());
-    auto ret = _data.object->_values.insert({ detail::convert_to_narrow(pair.first), std::move(pair.second) });
+    auto ret = detail::pin(_data.object)->_values.insert({ detail::convert_to_narrow(pair.first),
+                                                           std::move(pair.second)
+                                                         }
+                                                        );
     return { object_iterator(ret.first), ret.second };
 }
 
+std::pair<value::object_iterator, bool> value::emplace_entry(std::string&& key, value&& item)
+{
+    check_type(jsonv::kind::object, kind());
+    auto& values = detail::pin(_data.object)->_values;
+    auto  iter   = values.lower_bound(key);
+    if (iter != values.end() && !values.key_comp()(key, iter->first))
+        return { object_iterator(iter), false };
+    return { object_iterator(values.emplace_hint(iter, std::move(key), std::move(item))), true };
+}
+
+value::object_iterator value::emplace_entry(const_object_iterator hint, std::string&& key, value&& item)
+{
+    check_type(jsonv::kind::object, kind());
+    auto place = unshare_at(_data.object, hint._impl);
+    return object_iterator(detail::pin(_data.object)->_values.emplace_hint(place, std::move(key), std::move(item)));
+}
+
 void value::insert(std::initializer_list<std::pair<std::string, value>> items)
 {
     check_type(jsonv::kind::object, kind());
+    detail::unshare(_data.object);
     for (auto& pair : items)
          _data.object->_values.insert(std::move(pair));
 }
@@ -256,7 +306,7 @@ value::object_insert_return_type value::insert(object_node_handle&& handle)
     if (handle.empty())
         return { end_object(), false };
 
-    auto insert_rc = _data.object->_values.insert({ std::move(handle.key()), std::move(handle.mapped()) });
+    auto insert_rc = detail::pin(_data.object)->_values.insert({ std::move(handle.key()), std::move(handle.mapped()) });
     return { const_object_iterator(insert_rc.first), insert_rc.second };
 }
 
@@ -266,7 +316,7 @@ value::object_iterator value::insert(const_object_iterator, object_node_handle&&
     if (handle.empty())
         return end_object();
 
-    auto place = _data.object->_values.find(handle.key());
+    auto place = detail::pin(_data.object)->_values.find(handle.key());
     if (place == _data.object->_values.end())
     {
         return insert({ std::move(handle.key()), std::move(handle.mapped()) }).first;
@@ -277,28 +327,44 @@ value::object_iterator value::insert(const_object_iterator, object_node_handle&&
     }
 }
 
-value::size_type value::erase(const std::string& key)
+value::size_type value::erase(string_view key)
 {
     check_type(jsonv::kind::object, kind());
-    return _data.object->_values.erase(key);
+    detail::unshare(_data.object);
+    auto iter = _data.object->_values.find(key);
+    if (iter == _data.object->_values.end())
+        return 0;
+    _data.object->_values.erase(iter);
+    return 1;
 }
 
 value::size_type value::erase(const std::wstring& key)
 {
     check_type(jsonv::kind::object, kind());
+    detail::unshare(_data.object);
     return _data.object->_values.erase(detail::convert_to_narrow(key));
 }
 
 value::object_iterator value::erase(const_object_iterator position)
 {
     check_type(jsonv::kind::object, kind());
-    return object_iterator(_data.object->_values.erase(position._impl));
+    auto place = unshare_at(_data.object, position._impl);
+    return object_iterator(detail::pin(_data.object)->_values.erase(place));
 }
 
 value::object_iterator value::erase(const_object_iterator first, const_object_iterator last)
 {
     check_type(jsonv::kind::object, kind());
-    return object_iterator(_data.object->_values.erase(first._impl, last._impl));
+    if (_data.object->shared())
+    {
+        // erase by index, since the positions refer to the shared storage
+        auto offset = std::distance(detail::object_impl::const_iterator(_data.object->_values.begin()), first._impl);
+        auto count  = std::distance(first._impl, last._impl);
+        detail::unshare(_data.object);
+        auto place = std::next(_data.object->_values.begin(), offset);
+        return object_iterator(detail::pin(_data.object)->_values.erase(place, std::next(place, count)));
+    }
+    return object_iterator(detail::pin(_data.object)->_values.erase(first._impl, last._impl));
 }
 
 template <typename TMap>
@@ -347,8 +413,9 @@ object_node_handle extract_impl(TMapImpl& impl, TIterator position, FCreate&& cr
 object_node_handle value::extract(const_object_iterator position)
 {
     check_type(jsonv::kind::object, kind());
+    auto place = unshare_at(_data.object, position._impl);
     return extract_impl(_data.object->_values,
-                        position._impl,
+                        place,
                         [] (std::string key, value x)
                         {
                             return object_node_handle(object_node_handle::purposeful_construction(),
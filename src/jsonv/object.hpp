@@ -16,6 +16,8 @@
 #include <jsonv/detail.hpp>
 
 #include <map>
+#include <memory>
+#include <string>
 
 namespace jsonv
 {
@@ -26,7 +28,7 @@ class JSONV_LOCAL object_impl :
         public cloneable<object_impl>
 {
 public:
-    using map_type       = std::map<std::string, jsonv::value>;
+    using map_type       = value::object_storage_type;
     using iterator       = map_type::iterator;
     using const_iterator = map_type::const_iterator;
     
@@ -35,8 +37,20 @@ public:
     
     value::size_type size() const;
         
+    /** \see cloneable::forget_cached **/
+    void forget_cached() noexcept
+    {
+        cloneable<object_impl>::forget_cached();
+        _encoded.reset();
+        _canonical.reset();
+    }
+    
 public:
     map_type _values;
+    /** The JSON text this was parsed from by \c raw_json (copies keep it). It is dropped when this changes. **/
+    std::shared_ptr<const std::string> _encoded;
+    /** The text \c canonical_encoder wrote for this, if it was asked to cache it. **/
+    cached_text                        _canonical;
 };
 
 }
@@ -11,18 +11,34 @@
 #include <jsonv/parse.hpp>
 #include <jsonv/array.hpp>
 #include <jsonv/encode.hpp>
+#include <jsonv/key_dictionary.hpp>
 #include <jsonv/object.hpp>
+#include <jsonv/schema.hpp>
+#include <jsonv/stats.hpp>
 #include <jsonv/tokenizer.hpp>
+#include <jsonv/detail/file_mapping.hpp>
+#include <jsonv/detail/number_convert.hpp>
+#include <jsonv/detail/scope_exit.hpp>
+#include <jsonv/detail/string_scan.hpp>
+#include <jsonv/detail/structural_index.hpp>
+#include <jsonv/detail/token_patterns.hpp>
+#include <jsonv/detail/token_stream.hpp>
 
 #include "char_convert.hpp"
+#include "detail/trace_scope.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cctype>
+#include <cmath>
 #include <cstdlib>
+#include <functional>
 #include <istream>
 #include <set>
 #include <sstream>
 #include <streambuf>
+#include <thread>
 #include <vector>
 
 #if 0
@@ -111,6 +127,65 @@ std::string to_string(const parse_error& p)
     return os.str();
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// parse_limit_error                                                                                                  //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::ostream& operator<<(std::ostream& os, const parse_limit& which)
+{
+    switch (which)
+    {
+    case parse_limit::nodes:          return os << "max_nodes";
+    case parse_limit::string_length:  return os << "max_string_length";
+    case parse_limit::object_members: return os << "max_object_members";
+    case parse_limit::bytes:          return os << "max_bytes";
+    case parse_limit::time:           return os << "max_parse_time";
+    default:                          return os << "parse_limit(" << static_cast<int>(which) << ")";
+    }
+}
+
+parse_limit_error::parse_limit_error(parse_limit which, problem_list problems) :
+        parse_error(std::move(problems), null),
+        _limit(which)
+{ }
+
+parse_limit_error::~parse_limit_error() noexcept
+{ }
+
+parse_limit parse_limit_error::limit() const
+{
+    return _limit;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// parse_errc                                                                                                         //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::ostream& operator<<(std::ostream& os, const parse_errc& code)
+{
+    switch (code)
+    {
+    case parse_errc::none:              return os << "none";
+    case parse_errc::unexpected_end:    return os << "unexpected_end";
+    case parse_errc::invalid_token:     return os << "invalid_token";
+    case parse_errc::invalid_literal:   return os << "invalid_literal";
+    case parse_errc::invalid_number:    return os << "invalid_number";
+    case parse_errc::invalid_string:    return os << "invalid_string";
+    case parse_errc::missing_separator: return os << "missing_separator";
+    case parse_errc::missing_key:       return os << "missing_key";
+    case parse_errc::missing_colon:     return os << "missing_colon";
+    case parse_errc::trailing_comma:    return os << "trailing_comma";
+    case parse_errc::duplicate_key:     return os << "duplicate_key";
+    case parse_errc::comment:           return os << "comment";
+    case parse_errc::too_deep:          return os << "too_deep";
+    case parse_errc::trailing_data:     return os << "trailing_data";
+    case parse_errc::not_a_document:    return os << "not_a_document";
+    case parse_errc::schema_mismatch:   return os << "schema_mismatch";
+    case parse_errc::limit_exceeded:    return os << "limit_exceeded";
+    default:                            return os << "parse_errc(" << static_cast<int>(code) << ")";
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // parse_options                                                                                                      //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -237,6 +312,149 @@ parse_options& parse_options::comments(bool val)
     return *this;
 }
 
+parse_options::strings parse_options::string_storage() const
+{
+    return _string_storage;
+}
+
+parse_options& parse_options::string_storage(strings storage)
+{
+    _string_storage = storage;
+    return *this;
+}
+
+const std::vector<path>& parse_options::selection() const
+{
+    return _selection;
+}
+
+parse_options& parse_options::select(std::vector<path> paths)
+{
+    _selection = std::move(paths);
+    return *this;
+}
+
+parse_options::size_type parse_options::parallelism() const
+{
+    return _parallelism;
+}
+
+parse_options& parse_options::parallelism(size_type threads)
+{
+    _parallelism = threads;
+    return *this;
+}
+
+const std::shared_ptr<key_dictionary>& parse_options::keys() const
+{
+    return _keys;
+}
+
+parse_options& parse_options::keys(std::shared_ptr<key_dictionary> dictionary)
+{
+    _keys = std::move(dictionary);
+    return *this;
+}
+
+bool parse_options::require_finite_numbers() const
+{
+    return _require_finite;
+}
+
+parse_options& parse_options::require_finite_numbers(bool require)
+{
+    _require_finite = require;
+    return *this;
+}
+
+bool parse_options::pack_numbers() const
+{
+    return _pack_numbers;
+}
+
+parse_options& parse_options::pack_numbers(bool pack)
+{
+    _pack_numbers = pack;
+    return *this;
+}
+
+const std::shared_ptr<const schema>& parse_options::validation_schema() const
+{
+    return _schema;
+}
+
+parse_options& parse_options::validation_schema(std::shared_ptr<const schema> rules)
+{
+    _schema = std::move(rules);
+    return *this;
+}
+
+const std::shared_ptr<parse_stats>& parse_options::stats() const
+{
+    return _stats;
+}
+
+parse_options& parse_options::stats(std::shared_ptr<parse_stats> collector)
+{
+    _stats = std::move(collector);
+    return *this;
+}
+
+parse_options::size_type parse_options::max_nodes() const
+{
+    return _max_nodes;
+}
+
+parse_options& parse_options::max_nodes(size_type limit)
+{
+    _max_nodes = limit;
+    return *this;
+}
+
+parse_options::size_type parse_options::max_string_length() const
+{
+    return _max_string_len;
+}
+
+parse_options& parse_options::max_string_length(size_type limit)
+{
+    _max_string_len = limit;
+    return *this;
+}
+
+parse_options::size_type parse_options::max_object_members() const
+{
+    return _max_members;
+}
+
+parse_options& parse_options::max_object_members(size_type limit)
+{
+    _max_members = limit;
+    return *this;
+}
+
+std::size_t parse_options::max_bytes() const
+{
+    return _max_bytes;
+}
+
+parse_options& parse_options::max_bytes(std::size_t limit)
+{
+    _max_bytes = limit;
+    return *this;
+}
+
+std::chrono::nanoseconds parse_options::max_parse_time() const
+{
+    return _max_parse_time;
+}
+
+parse_options& parse_options::max_parse_time(std::chrono::nanoseconds limit)
+{
+    _max_parse_time = limit;
+    return *this;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // parsing internals                                                                                                  //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -244,88 +462,255 @@ parse_options& parse_options::comments(bool val)
 namespace detail
 {
 
-struct JSONV_LOCAL parse_context
+/** Adds the time from its creation to its destruction to \a target, unless \a target is \c nullptr (which is the case
+ *  when no \c parse_options::stats are being collected).
+**/
+class JSONV_LOCAL stats_timer
+{
+public:
+    using clock = std::chrono::steady_clock;
+    
+    explicit stats_timer(parse_stats::duration* target) :
+            _target(target),
+            _start(target ? clock::now() : clock::time_point())
+    { }
+    
+    ~stats_timer() noexcept
+    {
+        if (_target)
+            *_target += std::chrono::duration_cast<parse_stats::duration>(clock::now() - _start);
+    }
+    
+    stats_timer(const stats_timer&) = delete;
+    stats_timer& operator=(const stats_timer&) = delete;
+    
+private:
+    parse_stats::duration* _target;
+    clock::time_point      _start;
+};
+
+/** Access to the storage of the values of an old tree, which \c parse_into refills in place instead of building a new
+ *  tree. Storage is only given out when no other value shares it.
+**/
+class JSONV_LOCAL reusable_storage
+{
+public:
+    using entries_type = value::object_storage_type;
+
+    /** If \a source is an array, make sure it has storage of its own to overwrite.
+     *
+     *  \returns \c false if \a source is not an array.
+    **/
+    static bool array(value& source)
+    {
+        if (source._kind != kind::array)
+            return false;
+        unshare(source._data.array);
+        return true;
+    }
+
+    /** If \a source is a string holding its own contents, get those contents to overwrite (or \c nullptr). **/
+    static std::string* string(value& source)
+    {
+        if (source._kind != kind::string || source._data.string->borrowed() || source._data.string->shared())
+            return nullptr;
+        source._data.string->forget_cached();
+        return &source._data.string->_string;
+    }
+
+    /** If \a source is an object no other value shares, move its entries to \a entries and leave it empty.
+     *
+     *  \returns \c false if \a source can not be reused.
+    **/
+    static bool take_entries(value& source, entries_type& entries)
+    {
+        if (source._kind != kind::object || source._data.object->shared())
+            return false;
+        source._data.object->forget_cached();
+        std::swap(entries, source._data.object->_values);
+        source._data.object->_values.clear();
+        return true;
+    }
+
+    /** Move the entry for \a key from \a entries (from \c take_entries) into the object \a target, putting its old value
+     *  into \a previous. With \c std::map storage in C++17, the node of the entry itself is moved, so nothing is
+     *  allocated; otherwise the entry is made again (but the storage of its value is still reused).
+     *
+     *  \returns where the new value of the entry goes or \c nullptr if there was no entry for \a key.
+    **/
+    static value* move_entry(value& target, entries_type& entries, const std::string& key, value& previous)
+    {
+        auto iter = entries.find(key);
+        if (iter == entries.end())
+            return nullptr;
+
+        entries_type& values = target._data.object->_values;
+#if JSONV_OBJECT_FLAT_STORAGE || __cplusplus < 201703L
+        previous = std::move(iter->second);
+        auto inserted = values.insert({ iter->first, value() });
+        return inserted.second ? &inserted.first->second : nullptr;
+#else
+        auto node = entries.extract(iter);
+        previous = std::move(node.mapped());
+        auto inserted = values.insert(std::move(node));
+        return inserted.inserted ? &inserted.position->second : nullptr;
+#endif
+    }
+};
+
+struct JSONV_LOCAL parse_frame;
+
+/** The parts of parsing shared between the recursive \c parse functions and \c incremental_parser: options, string
+ *  decoding and the collection of problems. The \a options are not copied (this is set up for every document, which can
+ *  be a very short one), so they must outlive the context.
+**/
+struct JSONV_LOCAL parse_context_base
 {
     using size_type = std::size_t;
     
-    tokenizer&       input;
-    parse_options    options;
-    string_decode_fn string_decode;
+    const parse_options& options;
+    string_decode_fn     string_decode;
     
-    size_type line;
-    size_type column;
-    size_type character;
+    bool successful;
+    /** This is not a \c parse_error::problem_list, since an empty \c std::deque still allocates. **/
+    std::vector<jsonv::parse_error::problem> problems;
     
-    bool                             successful;
-    jsonv::parse_error::problem_list problems;
-    bool                             complete;
+    /** Storage for the stack of \c parse_document to reuse (or \c nullptr to use a new one each time). **/
+    std::vector<parse_frame>* frames;
     
-    explicit parse_context(const parse_options& options, tokenizer& input) :
-            input(input),
+    /** The token being looked at (or \c nullptr if there has not been one yet). **/
+    const tokenizer::token* token;
+    
+    /** Should strings which do not need decoding refer into the input? See \c parse_options::strings. **/
+    bool                        borrow_strings;
+    std::shared_ptr<const void> string_owner;
+    
+    /** Where to count what parsing does (or \c nullptr). See \c parse_options::stats. **/
+    parse_stats* stats;
+    
+    /** Should \c parse_document keep to the budgets of the \c options (see \c start_budget)? **/
+    bool                                  budgeted;
+    size_type                             nodes_used;
+    std::size_t                           bytes_used;
+    size_type                             ticks;      //!< Tokens since the clock was last checked.
+    std::chrono::steady_clock::time_point deadline;
+    
+    /** Should problems be recorded in \c failure instead of being reported (for \c try_parse)? The first problem halts
+     *  parsing: \c next acts like the input ended, so \c parse_document winds down without throwing.
+    **/
+    bool          quiet;
+    bool          halted;
+    parse_failure failure;
+    
+    explicit parse_context_base(const parse_options& options) :
             options(options),
             string_decode(get_string_decoder(options.string_encoding())),
-            line(0),
-            column(1),
-            character(0),
             successful(true),
             problems(),
-            complete(false)
+            frames(nullptr),
+            token(nullptr),
+            borrow_strings(false),
+            stats(options.stats().get()),
+            budgeted(false),
+            nodes_used(0),
+            bytes_used(0),
+            ticks(0),
+            quiet(false),
+            halted(false)
     { }
     
-    parse_context(const parse_context&) = delete;
-    parse_context& operator=(const parse_context&) = delete;
+    /** Does \a options set any of the budgets \c start_budget looks at? **/
+    static bool has_budget(const parse_options& options)
+    {
+        return options.max_nodes() > 0
+            || options.max_string_length() > 0
+            || options.max_object_members() > 0
+            || options.max_bytes() > 0
+            || options.max_parse_time() > std::chrono::nanoseconds(0);
+    }
     
-    bool next()
+    /** Start keeping to the budgets of the \c options (if there are any), with the clock starting now. **/
+    void start_budget()
     {
-        if (!complete && line != 0)
-        {
-            character += current().text.size();
-            for (const char c : current().text)
-            {
-                if (c == '\n' || c == '\r')
-                {
-                    ++line;
-                    column = 1;
-                }
-                else
-                {
-                    ++column;
-                }
-            }
-        }
-        else
-        {
-            ++line;
-        }
+        budgeted = has_budget(options);
+        if (options.max_parse_time() > std::chrono::nanoseconds(0))
+            deadline = std::chrono::steady_clock::now()
+                     + std::chrono::duration_cast<std::chrono::steady_clock::duration>(options.max_parse_time());
+    }
+    
+    /** Count a value against the budget. **/
+    void charge_value()
+    {
+        if (++nodes_used > options.max_nodes() && options.max_nodes() > 0)
+            exceed(parse_limit::nodes, "Document has more than the maximum of ", options.max_nodes(), " values");
+        charge_bytes(sizeof(value));
+    }
+    
+    /** Count a string (or object key) with \a length characters between its quotes against the budget. **/
+    void charge_string(size_type length)
+    {
+        if (length > options.max_string_length() && options.max_string_length() > 0)
+            exceed(parse_limit::string_length, "String of ", length, " characters is longer than the maximum of ",
+                   options.max_string_length()
+                  );
+        charge_bytes(length);
+    }
+    
+    /** Count the key of a new member of an object which already has \a members against the budget. **/
+    void charge_member(size_type members)
+    {
+        if (members >= options.max_object_members() && options.max_object_members() > 0)
+            exceed(parse_limit::object_members, "Object has more than the maximum of ", options.max_object_members(),
+                   " members"
+                  );
+        charge_bytes(sizeof(std::string));
+    }
+    
+    void charge_bytes(std::size_t bytes)
+    {
+        bytes_used += bytes;
+        if (bytes_used > options.max_bytes() && options.max_bytes() > 0)
+            exceed(parse_limit::bytes, "Document takes up more than the maximum of ", options.max_bytes(), " bytes");
+    }
+    
+    /** Check the clock against the \c deadline, but only every so often, since that is not free. **/
+    void tick()
+    {
+        static constexpr size_type ticks_per_check = 256;
         
-        if (input.next())
-        {
-            JSONV_DBG_NEXT("(" << input.current().text << " cxt:" << input.current().kind << ")");
-            if (current_kind() == token_kind::whitespace)
-            {
-                return next();
-            }
-            else if (current_kind() == token_kind::comment)
-            {
-                if (!options.comments())
-                    parse_error("JSON comment is not allowed");
-                return next();
-            }
-            else
-            {
-                return true;
-            }
-        }
-        else
+        if (++ticks == ticks_per_check)
         {
-            complete = true;
-            return false;
+            ticks = 0;
+            if (options.max_parse_time() > std::chrono::nanoseconds(0) && std::chrono::steady_clock::now() > deadline)
+                exceed(parse_limit::time, "Parsing took longer than the maximum of ",
+                       std::chrono::duration_cast<std::chrono::microseconds>(options.max_parse_time()).count(), "us"
+                      );
         }
     }
     
+    /** The \c problems for a \c parse_error. **/
+    jsonv::parse_error::problem_list problem_list() const
+    {
+        return jsonv::parse_error::problem_list(problems.begin(), problems.end());
+    }
+    
+    /** Get the \c parse_stats duration selected by \a member to time something with a \c stats_timer. **/
+    parse_stats::duration* stats_time(parse_stats::duration parse_stats::* member) const
+    {
+        return stats ? &(stats->*member) : nullptr;
+    }
+    
+    parse_context_base(const parse_context_base&) = delete;
+    parse_context_base& operator=(const parse_context_base&) = delete;
+    
+    virtual ~parse_context_base() noexcept = default;
+    
     const tokenizer::token& current() const
     {
-        return input.current();
+        if (token)
+            return *token;
+        else
+            throw std::logic_error("Cannot get token -- call next() and make sure it returns true.");
     }
     
     const token_kind& current_kind() const
@@ -334,12 +719,24 @@ struct JSONV_LOCAL parse_context
     }
     
     template <typename... T>
-    void parse_error(T&&... message)
+    void parse_error(parse_errc code, T&&... message)
     {
+        if (quiet)
+        {
+            halt(code);
+            return;
+        }
+        
         std::ostringstream stream;
         parse_error_impl(stream, std::forward<T>(message)...);
     }
     
+protected:
+    /** Get the location of the \c current token. This is only called when there is a problem, so the line and column
+     *  do not need to be tracked while parsing.
+    **/
+    virtual tokenizer::location current_location() const = 0;
+    
 private:
     void parse_error_impl(std::ostringstream& stream)
     {
@@ -350,47 +747,251 @@ private:
         }
         catch (const std::logic_error&)
         { }
-        jsonv::parse_error::problem problem(line, column, character, stream.str());
         if (options.failure_mode() == parse_options::on_error::fail_immediately)
         {
-            throw jsonv::parse_error({ problem }, null);
+            throw jsonv::parse_error({ make_problem(stream.str()) }, null);
         }
         else
         {
             successful = false;
             if (problems.size() < options.max_failures())
-                problems.emplace_back(std::move(problem));
+                problems.emplace_back(make_problem(stream.str()));
+        }
+    }
+    
+    /** Record the first problem of a \c quiet parse. **/
+    void halt(parse_errc code)
+    {
+        successful = false;
+        if (!halted)
+        {
+            halted         = true;
+            failure.code   = code;
+            failure.offset = current_location().character;
         }
     }
     
+    jsonv::parse_error::problem make_problem(std::string message)
+    {
+        tokenizer::location loc = current_location();
+        return jsonv::parse_error::problem(loc.line, loc.column, loc.character, std::move(message));
+    }
+    
     template <typename T, typename... TRest>
     void parse_error_impl(std::ostringstream& stream, T&& current, TRest&&... rest)
     {
         stream << std::forward<T>(current);
         parse_error_impl(stream, std::forward<TRest>(rest)...);
     }
+    
+    /** Stop parsing, since the budget for \a which has been gone over. This does not care about the failure mode (but a
+     *  \c quiet parse halts like it does for any other problem).
+    **/
+    template <typename... T>
+    void exceed(parse_limit which, T&&... message)
+    {
+        if (quiet)
+        {
+            halt(parse_errc::limit_exceeded);
+            return;
+        }
+        
+        std::ostringstream stream;
+        using expand = int[];
+        (void) expand { 0, ((void) (stream << std::forward<T>(message)), 0)... };
+        stream << " (" << which << ")";
+        
+        jsonv::parse_error::problem_list all = problem_list();
+        all.emplace_back(make_problem(stream.str()));
+        throw parse_limit_error(which, std::move(all));
+    }
 };
 
-static bool parse_generic(parse_context& context, value& out, bool advance = true);
-
-static void check_token(parse_context& context, string_view expected_token)
-{
-    if (context.current().text != expected_token)
-        context.parse_error("Failed to match \"", expected_token, "\""
-            , "\t", context.current().text.length(), " ", expected_token.length(), "\t",
-            std::equal(expected_token.begin(), expected_token.end(), context.current().text.begin())
-        );
-}
-
-static bool parse_boolean(parse_context& context, value& out)
+struct JSONV_LOCAL parse_context :
+        public parse_context_base
 {
-    assert(context.current_kind() == token_kind::boolean);
-    switch (context.current().text.at(0))
+    tokenizer& input;
+    bool       complete;
+    
+    explicit parse_context(const parse_options& options, tokenizer& input) :
+            parse_context_base(options),
+            input(input),
+            complete(false)
+    { }
+    
+    bool next()
     {
-    case 't':
-        out = true;
-        check_token(context, "true");
-        return true;
+        if (halted)
+            return false;
+        
+        bool advanced;
+        {
+            stats_timer timer(stats_time(&parse_stats::tokenize_time));
+            advanced = input.next();
+        }
+        
+        if (advanced)
+        {
+            JSONV_DBG_NEXT("(" << input.current().text << " cxt:" << input.current().kind << ")");
+            token = &input.current();
+            if (stats)
+                count_token();
+            if (budgeted)
+                tick();
+            if (current_kind() == token_kind::whitespace)
+            {
+                return next();
+            }
+            else if (current_kind() == token_kind::comment)
+            {
+                if (!options.comments())
+                    parse_error(parse_errc::comment, "JSON comment is not allowed");
+                return next();
+            }
+            else
+            {
+                return true;
+            }
+        }
+        else
+        {
+            complete = true;
+            return false;
+        }
+    }
+    
+protected:
+    virtual tokenizer::location current_location() const override
+    {
+        return input.current_location();
+    }
+    
+private:
+    void count_token()
+    {
+        stats->add_token(current_kind());
+        if (current_kind() == token_kind::string)
+            stats->string_bytes += current().text.size() - 2;
+        else if (current_kind() == token_kind::number)
+            stats->number_bytes += current().text.size();
+    }
+};
+
+/** The paths from \c parse_options::selection which lead through the value being parsed. **/
+class JSONV_LOCAL selection
+{
+public:
+    /** Create a selection of everything. **/
+    selection() :
+            _depth(0),
+            _all(true)
+    { }
+    
+    /** Create the selection for the root of the document from \a paths. **/
+    explicit selection(const std::vector<path>& paths) :
+            _depth(0),
+            _all(false)
+    {
+        for (const path& p : paths)
+            add(p);
+    }
+    
+    /** Is the entire value selected? **/
+    bool all() const
+    {
+        return _all;
+    }
+    
+    /** Get the selection for the element of this array at \a idx. If nothing under it is selected, \c all and
+     *  \c empty will both be \c false.
+    **/
+    selection child(std::size_t idx) const
+    {
+        return child_if([idx] (const path_element& elem)
+                        {
+                            return elem.kind() == path_element_kind::array_index && elem.index() == idx;
+                        }
+                       );
+    }
+    
+    /** Get the selection for the value of this object at \a key. **/
+    selection child(string_view key) const
+    {
+        return child_if([key] (const path_element& elem)
+                        {
+                            return elem.kind() == path_element_kind::object_key && elem.key() == key;
+                        }
+                       );
+    }
+    
+    /** Is nothing under this value selected? **/
+    bool empty() const
+    {
+        return !_all && _paths.empty();
+    }
+    
+    /** Get the number of array elements which need to be looked at to find every selected index. **/
+    std::size_t array_extent() const
+    {
+        std::size_t out = 0;
+        for (const path* p : _paths)
+        {
+            if ((*p)[_depth].kind() == path_element_kind::array_index)
+                out = std::max(out, (*p)[_depth].index() + 1);
+        }
+        return out;
+    }
+    
+private:
+    explicit selection(std::size_t depth) :
+            _depth(depth),
+            _all(false)
+    { }
+    
+    template <typename FMatch>
+    selection child_if(FMatch match) const
+    {
+        selection out(_depth + 1);
+        for (const path* p : _paths)
+        {
+            if (match((*p)[_depth]))
+                out.add(*p);
+        }
+        return out;
+    }
+    
+    void add(const path& p)
+    {
+        if (p.size() == _depth)
+            _all = true;
+        else
+            _paths.push_back(&p);
+    }
+    
+private:
+    std::vector<const path*> _paths;    //!< Paths which continue past this value.
+    std::size_t              _depth;
+    bool                     _all;
+};
+
+static void check_token(parse_context_base& context, string_view expected_token)
+{
+    if (context.current().text != expected_token)
+        context.parse_error(parse_errc::invalid_literal, "Failed to match \"", expected_token, "\""
+            , "\t", context.current().text.length(), " ", expected_token.length(), "\t",
+            std::equal(expected_token.begin(), expected_token.end(), context.current().text.begin())
+        );
+}
+
+static bool parse_boolean(parse_context_base& context, value& out)
+{
+    assert(context.current_kind() == token_kind::boolean);
+    switch (context.current().text.at(0))
+    {
+    case 't':
+        out = true;
+        check_token(context, "true");
+        return true;
     case 'f':
         out = false;
         check_token(context, "false");
@@ -401,7 +1002,7 @@ static bool parse_boolean(parse_context& context, value& out)
     }
 }
 
-static bool parse_null(parse_context& context, value& out)
+static bool parse_null(parse_context_base& context, value& out)
 {
     assert(context.current_kind() == token_kind::null);
     out = null;
@@ -409,72 +1010,70 @@ static bool parse_null(parse_context& context, value& out)
     return true;
 }
 
-static bool parse_number(parse_context& context, value& out)
+/** Does the number \a characters start with a \c 0 followed by more digits, which only \c parse_options::numbers::decimal
+ *  allows?
+**/
+static bool has_leading_zero(const parse_context_base& context, string_view characters)
+{
+    std::size_t first_digit = (!characters.empty() && characters[0] == '-') ? 1U : 0U;
+    return context.options.number_encoding() != parse_options::numbers::decimal
+        && characters.size() > first_digit + 1U
+        && characters[first_digit] == '0'
+        && '0' <= characters[first_digit + 1U] && characters[first_digit + 1U] <= '9';
+}
+
+static bool parse_number(parse_context_base& context, value& out)
 {
     JSONV_DBG_STRUCT("#");
     string_view characters = context.current().text;
+    const bool  lazy       = context.options.number_encoding() == parse_options::numbers::lazy
+                          && !context.options.require_finite_numbers()
+                          && characters.size() <= detail::max_lazy_number_length;
 
-    if (  context.options.number_encoding() == parse_options::numbers::strict
-       && characters.size() > 1U
-       && characters.at(0) == '0'
+    if (has_leading_zero(context, characters))
+        context.parse_error(parse_errc::invalid_number, "Numbers cannot start with a leading '0'");
+
+    // Only integers are converted right away, since those are cheap and exact; the text is kept for anything else
+    if (lazy && std::any_of(characters.begin(), characters.end(),
+                            [] (char c) { return c == '.' || c == 'e' || c == 'E'; }
+                           )
        )
     {
-        context.parse_error("Numbers cannot start with a leading '0'");
+        out = detail::make_lazy_number(characters);
+        return true;
     }
 
-    auto end = const_cast<char*>(characters.data() + characters.length());
-
-    // optimization: a numeric token is "decimal-like" if it has . in it
-    if (characters.find_first_of(".Ee") != string_view::npos)
-    {
-        auto scan_end = end;
-        auto val = std::strtod(characters.data(), &scan_end);
-        if (end == scan_end)
-        {
-            out = val;
-            return true;
-        }
-    }
-    else if (characters[0] == '-')
+    std::int64_t                  integer;
+    double                        decimal;
+    detail::number_convert_result converted;
     {
-        auto scan_end = end;
-        auto val      = std::strtoul(characters.data(), &scan_end, 10);
-        if (end == scan_end)
-        {
-            out = val;
-            return true;
-        }
-    }
-    else
-    {
-        // For non-negative integer types, use lexical_cast of a uint64_t then static_cast to an int64_t. This is done
-        // to deal with the values 2^63..2^64-1 -- do not consider it an exception, as we can store the bits properly,
-        // but the onus is on the user to know the particular key was in the overflow range.
-        auto scan_end = end;
-        auto val      = std::strtoull(characters.data(), &scan_end, 10);
-        if (end == scan_end)
-        {
-            out = val;
-            return true;
-        }
+        stats_timer timer(context.stats_time(&parse_stats::number_time));
+        converted = detail::convert_number(characters, integer, decimal);
     }
-
-    // Numbers that do not contain decimals or exponents, but are too large might still be representable as a double
+    switch (converted)
     {
-        auto scan_end = end;
-        auto val = std::strtod(characters.data(), &scan_end);
-        if (end == scan_end)
-        {
-            out = val;
-            return true;
-        }
+    case detail::number_convert_result::integer:
+        out = integer;
+        return true;
+    case detail::number_convert_result::decimal:
+        if (context.options.require_finite_numbers() && !std::isfinite(decimal))
+            context.parse_error(parse_errc::invalid_number, "Number \"", characters, "\" is not finite");
+        if (lazy)
+            out = detail::make_lazy_number(characters);
+        else
+            out = decimal;
+        return true;
+    case detail::number_convert_result::invalid:
+    default:
+        break;
     }
 
-    context.parse_error("Could not extract number from \"", characters, "\"");
+    context.parse_error(parse_errc::invalid_number, "Could not extract number from \"", characters, "\"");
     return true;
 }
 
-static std::string parse_string(parse_context& context)
+/** Get the contents of the current string token without the quotes. **/
+static string_view string_contents(parse_context_base& context)
 {
     assert(context.current_kind() == token_kind::string);
     
@@ -483,148 +1082,88 @@ static std::string parse_string(parse_context& context)
     // chop off the ""s
     source.remove_prefix(1);
     source.remove_suffix(1);
+    return source;
+}
+
+/** Would decoding \a source give back exactly \a source? This is conservative: it only checks for strings without
+ *  escape sequences or any characters which would need to be validated.
+**/
+static bool decodes_to_itself(const parse_context_base& context, string_view source)
+{
+    const bool require_printable = context.options.string_encoding() == parse_options::encoding::utf8_strict;
+    const bool allow_high_bytes  = context.options.string_encoding() == parse_options::encoding::iso8;
+    const char* end = source.data() + source.size();
+    return detail::find_string_special(source.data(), end, !allow_high_bytes, require_printable) == end;
+}
+
+static std::string parse_string(parse_context_base& context)
+{
+    string_view source = string_contents(context);
     
     try
     {
+        stats_timer timer(context.stats_time(&parse_stats::string_time));
         return context.string_decode(source);
     }
     catch (const detail::decode_error& err)
     {
-        context.parse_error("Error decoding string:", err.what());
+        context.parse_error(parse_errc::invalid_string, "Error decoding string:", err.what());
         // return it un-decoded
         return std::string(source);
     }
 }
 
-static bool parse_string(parse_context& context, value& out)
+/** Get the key of an object from the current string token, going through the \c key_dictionary if there is one. **/
+static std::string parse_key(parse_context_base& context)
 {
-    out = parse_string(context);
-    return true;
-}
-
-static bool parse_array(parse_context& context, value& arr)
-{
-    JSONV_DBG_STRUCT('[');
-    arr = array();
-    bool trailing_comma = false;
+    key_dictionary* keys = context.options.keys().get();
+    if (!keys)
+        return parse_string(context);
+    
+    string_view source = string_contents(context);
+    if (const std::string* interned = keys->find(source))
+        return *interned;
     
-    while (true)
+    std::string decoded;
+    try
     {
-        if (!context.next())
-            break;
-        
-        value val;
-        if (context.current_kind() == token_kind::array_end)
-        {
-            if (trailing_comma && context.options.comma_policy() != parse_options::commas::allow_trailing)
-                context.parse_error("Array contained a trailing comma");
-            JSONV_DBG_STRUCT(']');
-            return true;
-        }
-        else if (parse_generic(context, val, false))
-        {
-            JSONV_DBG_STRUCT(val);
-            arr.push_back(std::move(val));
-            trailing_comma = false;
-        }
-        else
-        {
-            JSONV_DBG_STRUCT("parse error:" << context.current().text << " kind:" << context.current_kind());
-            // a parse error, but parse_generic will have complained about it
-        }
-        
-        if (!context.next())
-        {
-            break;
-        }
-        
-        if (context.current_kind() == token_kind::array_end)
-        {
-            JSONV_DBG_STRUCT(']');
-            return true;
-        }
-        else if (context.current_kind() == token_kind::separator)
-        {
-            JSONV_DBG_STRUCT(',');
-            trailing_comma = true;
-        }
-        else
-        {
-            context.parse_error("Invalid entry when looking for ',' or ']'");
-        }
+        stats_timer timer(context.stats_time(&parse_stats::string_time));
+        decoded = context.string_decode(source);
     }
-    context.parse_error("Unexpected end: unmatched '['");
-    return false;
+    catch (const detail::decode_error& err)
+    {
+        context.parse_error(parse_errc::invalid_string, "Error decoding string:", err.what());
+        // return it un-decoded (and do not remember it)
+        return std::string(source);
+    }
+    keys->insert(source, decoded);
+    return decoded;
 }
 
-static bool parse_object(parse_context& context, value& out)
+/** Parse the current string token into \a out. If \a previous is a string with storage of its own (see \c parse_into),
+ *  that storage is overwritten and moved to \a out instead of allocating another.
+**/
+static bool parse_string(parse_context_base& context, value& out, value& previous)
 {
-    out = object();
-    bool trailing_comma = false;
+    string_view source = string_contents(context);
+    if (context.borrow_strings && decodes_to_itself(context, source))
+    {
+        out = make_borrowed_string(source, context.string_owner);
+        return true;
+    }
     
-    while (context.next())
+    if (std::string* storage = reusable_storage::string(previous))
     {
-        std::string key;
-        if (context.current_kind() == token_kind::string)
-        {
-            key = parse_string(context);
-            trailing_comma = false;
-        }
-        else if (context.current_kind() == token_kind::object_end)
-        {
-            if (trailing_comma && context.options.comma_policy() != parse_options::commas::allow_trailing)
-                context.parse_error("Trailing comma at end of object.");
-            return true;
-        }
-        else
-        {
-            context.parse_error("Expecting a key, but found ", context.current_kind());
-            // simulate a new key
-            key = std::string(context.current().text);
-        }
-        
-        if (!context.next())
-        {
-            context.parse_error("Unexpected end: missing ':' for key '", key, "'");
-            return false;
-        }
-        
-        if (context.current_kind() != token_kind::object_key_delimiter)
-            context.parse_error("Invalid key-value delimiter...expecting ':' after key '", key, "'");
-        
-        value val;
-        if (!parse_generic(context, val))
-        {
-            context.parse_error("Unexpected end: incomplete value for key '", key, "'");
-            return false;
-        }
-        
-        auto iter = out.find(key);
-        if (iter == out.end_object())
-        {
-            out.insert({ std::move(key), std::move(val) });
-        }
-        else
-        {
-            context.parse_error("Duplicate entries for key '", key, "'. ",
-                                "Updating old value ", iter->second, " with new value ", val, "."
-                               );
-            iter->second = std::move(val);
-        }
-        
-        if (!context.next())
-            break;
-        
-        if (context.current_kind() == token_kind::object_end)
-            return true;
-        else if (context.current_kind() == token_kind::separator)
-            trailing_comma = true;
+        if (decodes_to_itself(context, source))
+            storage->assign(source.data(), source.size());
         else
-            context.parse_error("Invalid token while searching for next value in object.");
+            *storage = parse_string(context);
+        out = std::move(previous);
+        return true;
     }
     
-    context.parse_error("Unexpected end inside of object.");
-    return false;
+    out = parse_string(context);
+    return true;
 }
 
 /** This function skips over anything that isn't one of the "separator" characters. It is intended to make parse errors
@@ -655,84 +1194,468 @@ static bool forward_to_separator(parse_context& context)
     return false;
 }
 
-static bool parse_generic(parse_context& context, value& out, bool advance)
+/** Skip over the value starting at the current token without decoding it. Only the brackets are checked.
+ *  
+ *  \returns \c false if the input ran out before the end of the value.
+**/
+static bool skip_value(parse_context& context)
 {
-    if (advance && !context.next())
-        return false;
-    
-    switch (context.current().kind)
+    std::vector<token_kind> open;
+    do
     {
-    case token_kind::array_begin:
-        return parse_array(context, out);
-    case token_kind::boolean:
-        return parse_boolean(context, out);
-    case token_kind::null:
-        return parse_null(context, out);
-    case token_kind::number:
-        return parse_number(context, out);
-    case token_kind::object_begin:
-        return parse_object(context, out);
-    case token_kind::string:
-        return parse_string(context, out);
-    case token_kind::comment:
-    case token_kind::whitespace:
-        // ignore
-        return parse_generic(context, out);
-    case token_kind::unknown:
-    case token_kind::array_end:
-    case token_kind::object_end:
-    case token_kind::object_key_delimiter:
-    case token_kind::separator:
-    case token_kind::parse_error_indicator:
-    default:
-        context.parse_error("Encountered invalid token ", context.current().kind, ": \"", context.current().text, "\"");
-        return forward_to_separator(context);
-    }
+        token_kind tok_kind = context.current_kind();
+        switch (tok_kind)
+        {
+        case token_kind::array_begin:
+        case token_kind::object_begin:
+            open.push_back(tok_kind);
+            break;
+        case token_kind::array_end:
+        case token_kind::object_end:
+            if (open.empty())
+            {
+                context.parse_error(parse_errc::invalid_token,
+                                    "Encountered invalid token ", tok_kind, ": \"", context.current().text, "\"");
+                return true;
+            }
+            else if (open.back() != (tok_kind == token_kind::array_end ? token_kind::array_begin
+                                                                   : token_kind::object_begin))
+            {
+                context.parse_error(parse_errc::invalid_token, "Unexpected ", tok_kind, " while skipping a value");
+            }
+            open.pop_back();
+            break;
+        default:
+            break;
+        }
+        
+        if (open.empty())
+            return true;
+    } while (context.next());
+    
+    return false;
 }
 
-class JSONV_LOCAL depth_checker :
-        private encoder
+/** An array or object which has been opened, but not yet closed. **/
+struct JSONV_LOCAL parse_frame
 {
-public:
-    explicit depth_checker(parse_context& context) :
-            _context(context),
-            _current_depth(0)
-    { }
-    
-    void check(const value& val)
-    {
-        encode(val);
-    }
-    
-private:
-    virtual void write_null() override                      { }
-    virtual void write_object_key(string_view) override      { }
-    virtual void write_object_delimiter() override          { }
-    virtual void write_array_delimiter() override           { }
-    virtual void write_string(string_view) override          { }
-    virtual void write_integer(std::int64_t) override       { }
-    virtual void write_decimal(double) override             { }
-    virtual void write_boolean(bool) override               { }
-    
-    virtual void write_object_begin() override { increase_depth(); }
-    virtual void write_array_begin() override  { increase_depth(); }
-    virtual void write_object_end() override   { --_current_depth; }
-    virtual void write_array_end() override    { --_current_depth; }
+    value         container;
+    selection     select;         //!< What to keep from this container.
+    std::size_t   extent;         //!< For filtered arrays, the number of elements to keep.
+    std::string   key;            //!< For objects, the key of the value being parsed.
+    bool          keep;           //!< For objects, should the value being parsed be kept?
+    bool          trailing_comma;
+    const schema* rules;          //!< What the container has to match (\c nullptr if anything goes).
+    std::size_t   filled;         //!< For arrays, the number of elements parsed (old ones after that are reused).
+    reusable_storage::entries_type previous; //!< For reused objects, the old entries which were not parsed again yet.
+    value*        slot;           //!< For reused objects, where the value being parsed goes (\c nullptr if new).
     
-private:
-    void increase_depth()
-    {
-        if (++_current_depth == _context.options.max_structure_depth())
-        {
-            _context.parse_error("Structure depth reached maximum of ", _current_depth);
-        }
-    }
-    
-private:
-    parse_context&           _context;
-    parse_options::size_type _current_depth;
+    /** Create the frame for a container which was just opened. Nothing has been parsed into it yet: there is no key or
+     *  trailing comma, values are kept and there are no old entries (the caller takes those if it reuses storage).
+    **/
+    parse_frame(selection select, std::size_t extent, const schema* rules) :
+            container(),
+            select(std::move(select)),
+            extent(extent),
+            key(),
+            keep(true),
+            trailing_comma(false),
+            rules(rules),
+            filled(0),
+            previous(),
+            slot(nullptr)
+    { }
 };
 
+/** Complain if \a x does not match \a rules (if there are any). **/
+static void check_schema(parse_context_base& context, const schema* rules, const value& x)
+{
+    validation_error::code failure;
+    if (rules && !rules->check(x, failure))
+        context.parse_error(parse_errc::schema_mismatch, "Value does not match the schema (", failure, ")");
+}
+
+/** Parse a document into \a out. Arrays and objects are tracked with an explicit stack instead of recursion, so the
+ *  depth of a document is only limited by memory (and \c parse_options::max_structure_depth). If \a advance_first is
+ *  \c false, the document starts at the current token instead of the next one.
+ *  
+ *  Whatever \a out held before is the old tree for \c parse_into: where the new document has an array, object or string
+ *  in the same place as the old one, its storage is refilled instead of allocating another.
+ *  
+ *  \returns \c false if the input ended before the document was complete.
+**/
+static bool parse_document(parse_context& context, value& out, selection root_select, bool advance_first = true)
+{
+    enum class step
+    {
+        value,                  //!< Parse a value, then continue with whatever contains it.
+        array_element,          //!< Expecting an element of an array or the end of it.
+        array_after_element,    //!< An element of an array was just parsed into \c current.
+        object_entry,           //!< Expecting a key of an object or the end of it.
+        object_after_value,     //!< A value of an object was just parsed into \c current.
+        done,
+    };
+    
+    std::vector<parse_frame>  own_stack;
+    std::vector<parse_frame>& stack     = context.frames ? *context.frames : own_stack;
+    auto                      cleanup   = on_scope_exit([&stack] { stack.clear(); });
+    selection                 select    = std::move(root_select);  // for the value about to be parsed
+    const schema*             rules     = context.options.validation_schema().get();
+    bool                      advance   = advance_first;           // move to the next token before parsing a value
+    value                     current;                             // the value which was just parsed
+    value                     previous  = std::move(out);          // the old value where the next one will be parsed
+    bool                      ok        = false;                   // was the value complete?
+    step                      next_step = step::value;
+    
+    // Continue with whatever contains the value which was just parsed
+    auto resume = [&] ()
+                  {
+                      if (stack.empty())
+                          return step::done;
+                      else if (stack.back().container.kind() == kind::array)
+                          return step::array_after_element;
+                      else
+                          return step::object_after_value;
+                  };
+    auto finish_container = [&] (bool complete)
+                            {
+                                if (complete && stack.back().select.all())
+                                    check_schema(context, stack.back().rules, stack.back().container);
+                                parse_frame& top = stack.back();
+                                if (  top.container.kind() == kind::array
+                                   && top.select.all()
+                                   && top.filled < top.container.size()
+                                   )
+                                {
+                                    top.container.erase(top.container.begin_array() + top.filled,
+                                                        top.container.end_array()
+                                                       );
+                                }
+                                current = std::move(top.container);
+                                stack.pop_back();
+                                if (complete && context.options.pack_numbers() && current.kind() == kind::array)
+                                    current.pack_numbers();
+                                ok        = complete;
+                                next_step = resume();
+                            };
+    auto begin_value = [&] (selection value_select, bool advance_first, const schema* value_rules)
+                       {
+                           select    = std::move(value_select);
+                           rules     = value_rules;
+                           advance   = advance_first;
+                           current   = value();
+                           next_step = step::value;
+                       };
+    
+    while (true) switch (next_step)
+    {
+    case step::value:
+        if (advance && !context.next())
+        {
+            ok        = false;
+            next_step = resume();
+            break;
+        }
+        
+        if (  context.budgeted
+           && context.current_kind() != token_kind::whitespace
+           && context.current_kind() != token_kind::comment
+           )
+            context.charge_value();
+        
+        switch (context.current().kind)
+        {
+        case token_kind::array_begin:
+        case token_kind::object_begin:
+        {
+            bool        is_array = context.current_kind() == token_kind::array_begin;
+            std::size_t extent   = select.all() ? 0 : select.array_extent();
+            JSONV_DBG_STRUCT((is_array ? '[' : '{'));
+            stack.emplace_back(std::move(select), extent, rules);
+            parse_frame& top = stack.back();
+            bool reuse = top.select.all()
+                      && (is_array ? reusable_storage::array(previous)
+                                   : reusable_storage::take_entries(previous, top.previous)
+                         );
+            if (reuse)
+                top.container = std::move(previous);
+            else
+                top.container = is_array ? array() : object();
+            previous = value();
+            if (stack.size() == context.options.max_structure_depth())
+                context.parse_error(parse_errc::too_deep, "Structure depth reached maximum of ", stack.size());
+            if (context.stats)
+                context.stats->max_depth = std::max(context.stats->max_depth, stack.size());
+            next_step = is_array ? step::array_element : step::object_entry;
+            break;
+        }
+        case token_kind::boolean:
+            ok        = parse_boolean(context, current);
+            if (ok)
+                check_schema(context, rules, current);
+            next_step = resume();
+            break;
+        case token_kind::null:
+            ok        = parse_null(context, current);
+            if (ok)
+                check_schema(context, rules, current);
+            next_step = resume();
+            break;
+        case token_kind::number:
+            ok        = parse_number(context, current);
+            if (ok)
+                check_schema(context, rules, current);
+            next_step = resume();
+            break;
+        case token_kind::string:
+            if (context.budgeted)
+                context.charge_string(context.current().text.size() - 2);
+            ok        = parse_string(context, current, previous);
+            if (ok)
+                check_schema(context, rules, current);
+            next_step = resume();
+            break;
+        case token_kind::comment:
+        case token_kind::whitespace:
+            // ignore
+            advance = true;
+            break;
+        case token_kind::unknown:
+        case token_kind::array_end:
+        case token_kind::object_end:
+        case token_kind::object_key_delimiter:
+        case token_kind::separator:
+        case token_kind::parse_error_indicator:
+        default:
+            context.parse_error(parse_errc::invalid_token,
+                                "Encountered invalid token ", context.current().kind, ": \"", context.current().text,
+                                "\""
+                               );
+            ok        = forward_to_separator(context);
+            next_step = resume();
+            break;
+        }
+        previous = value();
+        break;
+    case step::array_element:
+    {
+        parse_frame& top = stack.back();
+        if (!context.next())
+        {
+            context.parse_error(parse_errc::unexpected_end, "Unexpected end: unmatched '['");
+            finish_container(false);
+        }
+        else if (context.current_kind() == token_kind::array_end)
+        {
+            if (top.trailing_comma && context.options.comma_policy() != parse_options::commas::allow_trailing)
+                context.parse_error(parse_errc::trailing_comma, "Array contained a trailing comma");
+            JSONV_DBG_STRUCT(']');
+            finish_container(true);
+        }
+        else if (top.select.all())
+        {
+            begin_value(selection(), false, top.rules ? top.rules->element_rules() : nullptr);
+            if (top.filled < top.container.size())
+                previous = std::move(top.container[top.filled]);
+        }
+        else
+        {
+            selection sub = top.select.child(top.container.size());
+            if (sub.empty())
+            {
+                skip_value(context);
+                current   = value();
+                next_step = step::array_after_element;
+            }
+            else
+            {
+                begin_value(std::move(sub), false, top.rules ? top.rules->element_rules() : nullptr);
+            }
+        }
+        break;
+    }
+    case step::array_after_element:
+    {
+        parse_frame& top = stack.back();
+        if (!top.select.all())
+        {
+            // Elements which are not selected still take up their index, up until the last selected one
+            if (top.container.size() < top.extent)
+                top.container.push_back(std::move(current));
+            top.trailing_comma = false;
+        }
+        else if (ok)
+        {
+            JSONV_DBG_STRUCT(current);
+            if (top.filled < top.container.size())
+                top.container[top.filled] = std::move(current);
+            else
+                top.container.push_back(std::move(current));
+            ++top.filled;
+            top.trailing_comma = false;
+        }
+        else
+        {
+            JSONV_DBG_STRUCT("parse error:" << context.current().text << " kind:" << context.current_kind());
+            // a parse error, but it will have been complained about already
+        }
+        
+        if (!context.next())
+        {
+            context.parse_error(parse_errc::unexpected_end, "Unexpected end: unmatched '['");
+            finish_container(false);
+        }
+        else if (context.current_kind() == token_kind::array_end)
+        {
+            JSONV_DBG_STRUCT(']');
+            finish_container(true);
+        }
+        else
+        {
+            if (context.current_kind() == token_kind::separator)
+            {
+                JSONV_DBG_STRUCT(',');
+                top.trailing_comma = true;
+            }
+            else
+            {
+                context.parse_error(parse_errc::missing_separator, "Invalid entry when looking for ',' or ']'");
+            }
+            next_step = step::array_element;
+        }
+        break;
+    }
+    case step::object_entry:
+    {
+        parse_frame& top = stack.back();
+        if (!context.next())
+        {
+            context.parse_error(parse_errc::unexpected_end, "Unexpected end inside of object.");
+            finish_container(false);
+            break;
+        }
+        
+        if (context.current_kind() == token_kind::string)
+        {
+            if (context.budgeted)
+            {
+                context.charge_member(top.container.size());
+                context.charge_string(context.current().text.size() - 2);
+            }
+            top.key            = parse_key(context);
+            top.trailing_comma = false;
+        }
+        else if (context.current_kind() == token_kind::object_end)
+        {
+            if (top.trailing_comma && context.options.comma_policy() != parse_options::commas::allow_trailing)
+                context.parse_error(parse_errc::trailing_comma, "Trailing comma at end of object.");
+            finish_container(true);
+            break;
+        }
+        else
+        {
+            context.parse_error(parse_errc::missing_key, "Expecting a key, but found ", context.current_kind());
+            // simulate a new key
+            top.key = std::string(context.current().text);
+        }
+        
+        if (!context.next())
+        {
+            context.parse_error(parse_errc::unexpected_end, "Unexpected end: missing ':' for key '", top.key, "'");
+            finish_container(false);
+            break;
+        }
+        
+        if (context.current_kind() != token_kind::object_key_delimiter)
+            context.parse_error(parse_errc::missing_colon,
+                                "Invalid key-value delimiter...expecting ':' after key '", top.key, "'");
+        
+        const schema* member_rules = top.rules ? top.rules->find_member(top.key) : nullptr;
+        if (top.select.all())
+        {
+            top.keep = true;
+            begin_value(selection(), true, member_rules);
+            if (!top.previous.empty() && top.container.count(top.key) == 0)
+                top.slot = reusable_storage::move_entry(top.container, top.previous, top.key, previous);
+        }
+        else
+        {
+            selection sub = top.select.child(top.key);
+            top.keep = !sub.empty();
+            if (top.keep)
+            {
+                begin_value(std::move(sub), true, member_rules);
+            }
+            else
+            {
+                ok        = context.next() && skip_value(context);
+                current   = value();
+                next_step = step::object_after_value;
+            }
+        }
+        break;
+    }
+    case step::object_after_value:
+    {
+        parse_frame& top = stack.back();
+        if (!ok)
+        {
+            context.parse_error(parse_errc::unexpected_end, "Unexpected end: incomplete value for key '", top.key, "'");
+            if (top.slot)
+                top.container.erase(top.key);
+            top.slot = nullptr;
+            finish_container(false);
+            break;
+        }
+        
+        if (top.slot)
+        {
+            *top.slot = std::move(current);
+            top.slot  = nullptr;
+        }
+        else if (top.keep)
+        {
+            auto iter = top.container.find(top.key);
+            if (iter == top.container.end_object())
+            {
+                top.container.insert({ std::move(top.key), std::move(current) });
+            }
+            else
+            {
+                context.parse_error(parse_errc::duplicate_key, "Duplicate entries for key '", top.key, "'. ",
+                                    "Updating old value ", iter->second, " with new value ", current, "."
+                                   );
+                iter->second = std::move(current);
+            }
+        }
+        
+        if (!context.next())
+        {
+            context.parse_error(parse_errc::unexpected_end, "Unexpected end inside of object.");
+            finish_container(false);
+        }
+        else if (context.current_kind() == token_kind::object_end)
+        {
+            finish_container(true);
+        }
+        else
+        {
+            if (context.current_kind() == token_kind::separator)
+                top.trailing_comma = true;
+            else
+                context.parse_error(parse_errc::missing_separator,
+                                    "Invalid token while searching for next value in object.");
+            next_step = step::object_entry;
+        }
+        break;
+    }
+    case step::done:
+    default:
+        out = std::move(current);
+        return ok;
+    }
+}
+
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -756,7 +1679,8 @@ static value post_parse(detail::parse_context& context, value&& out_)
                 // them.
                 string_view current_text = context.current().text;
                 if (std::any_of(current_text.begin(), current_text.end(), [] (char c) { return c != '\0'; }))
-                    context.parse_error("Found non-trivial data after final token. ", context.current_kind());
+                    context.parse_error(parse_errc::trailing_data,
+                                        "Found non-trivial data after final token. ", context.current_kind());
             }
         }
     }
@@ -765,29 +1689,73 @@ static value post_parse(detail::parse_context& context, value&& out_)
     {
         if (out.kind() != kind::array && out.kind() != kind::object)
         {
-            context.parse_error("JSON requires the root of a payload to be an array or object, not ", out.kind());
+            context.parse_error(parse_errc::not_a_document,
+                                "JSON requires the root of a payload to be an array or object, not ", out.kind());
         }
     }
     
-    if (context.options.max_structure_depth() > 0)
-    {
-        detail::depth_checker depth_checker(context);
-        depth_checker.check(out);
-    }
-    
-    if (context.successful || context.options.failure_mode() == parse_options::on_error::ignore)
+    if (context.successful || context.quiet || context.options.failure_mode() == parse_options::on_error::ignore)
         return out;
     else
-        throw parse_error(context.problems, out);
+        throw parse_error(context.problem_list(), out);
+}
+
+/** Parse the document from the tokens of \a context, which the caller has set up. **/
+static value parse_in_context(detail::parse_context& context, value* reuse = nullptr)
+{
+    context.start_budget();
+    
+    detail::stats_timer timer(context.stats_time(&parse_stats::total_time));
+    if (context.stats)
+        ++context.stats->documents;
+    
+
+    value out = reuse ? std::move(*reuse) : value();
+    detail::selection select = context.options.selection().empty() ? detail::selection()
+                                                                   : detail::selection(context.options.selection());
+    if (!detail::parse_document(context, out, std::move(select)))
+        context.parse_error(parse_errc::unexpected_end, "No input");
+    
+    return post_parse(context, std::move(out));
+}
+
+/** Parse the document in \a input. If \a reuse is not \c nullptr, the tree it holds is refilled (see \c parse_into). **/
+static value parse_tokens(tokenizer&                          input,
+                          const parse_options&                options,
+                          bool                                borrow_strings,
+                          std::shared_ptr<const void>         string_owner,
+                          std::vector<detail::parse_frame>*   frames = nullptr,
+                          value*                              reuse  = nullptr
+                         )
+{
+    detail::parse_context context(options, input);
+    context.borrow_strings = borrow_strings;
+    context.string_owner   = std::move(string_owner);
+    context.frames         = frames;
+    return parse_in_context(context, reuse);
 }
 
 value parse(tokenizer& input, const parse_options& options)
+{
+    detail::trace_scope trace(trace_operation::parse);
+    return parse_tokens(input, options, false, nullptr);
+}
+
+value detail::parse_current(tokenizer& input)
+{
+    static const parse_options options = parse_options().complete_parse(false);
+    return parse_current(input, options);
+}
+
+value detail::parse_current(tokenizer& input, const parse_options& options)
 {
     detail::parse_context context(options, input);
-    value out;
-    if (!detail::parse_generic(context, out))
-        context.parse_error("No input");
+    context.token = &input.current();
+    context.start_budget();
     
+    value out;
+    if (!detail::parse_document(context, out, detail::selection(), false))
+        context.parse_error(parse_errc::unexpected_end, "Unexpected end of input");
     return post_parse(context, std::move(out));
 }
 
@@ -797,10 +1765,276 @@ value parse(std::istream& input, const parse_options& options)
     return parse(tokens, options);
 }
 
+/** Documents smaller than this are not worth splitting up for parallel parsing. **/
+static constexpr std::size_t parallel_min_input_size = 1024 * 1024;
+
+/** Find the text of each element of the top-level array in \a input with a structural scan.
+ *  
+ *  \returns \c false if \a input is not a simple top-level array or the scan could not be trusted.
+**/
+static bool find_array_elements(string_view input, const parse_options& options, std::vector<string_view>& elements)
+{
+    auto is_space = [] (char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+    
+    if (input.size() > detail::structural_index::max_input_size)
+        return false;
+    
+    std::size_t begin = std::size_t(std::find_if_not(input.begin(), input.end(), is_space) - input.begin());
+    if (begin == input.size() || input[begin] != '[')
+        return false;
+    
+    detail::structural_index index(input);
+    const auto&              offsets = index.offsets();
+    
+    std::vector<char> open;
+    bool              in_string     = false;
+    std::size_t       element_begin = begin + 1;
+    std::size_t       close         = input.size();
+    for (std::size_t pos = 0; pos < offsets.size() && close == input.size(); ++pos)
+    {
+        std::size_t at = offsets[pos];
+        
+        // The index can not see through comments, so give up if there might be one
+        if (options.comments() && !in_string && pos > 0)
+        {
+            const char* gap_end = input.data() + at;
+            if (std::find(input.data() + offsets[pos - 1], gap_end, '/') != gap_end)
+                return false;
+        }
+        
+        switch (char c = input[at])
+        {
+        case '\"':
+            in_string = !in_string;
+            break;
+        case '[':
+        case '{':
+            open.push_back(c);
+            break;
+        case ']':
+        case '}':
+            if (open.empty() || open.back() != (c == ']' ? '[' : '{'))
+                return false;
+            open.pop_back();
+            if (open.empty())
+            {
+                elements.push_back(input.substr(element_begin, at - element_begin));
+                close = at;
+            }
+            break;
+        case ',':
+            if (open.size() == 1)
+            {
+                elements.push_back(input.substr(element_begin, at - element_begin));
+                element_begin = at + 1;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    
+    if (close == input.size())
+        return false;
+    if (options.complete_parse() && !std::all_of(input.begin() + close + 1, input.end(), is_space))
+        return false;
+    
+    auto is_blank = [&] (string_view element) { return std::all_of(element.begin(), element.end(), is_space); };
+    if (is_blank(elements.back()))
+    {
+        if (elements.size() > 1 && options.comma_policy() != parse_options::commas::allow_trailing)
+            return false;
+        elements.pop_back();
+    }
+    return std::none_of(elements.begin(), elements.end(), is_blank);
+}
+
+/** Attempt to parse \a input as a top-level array with its elements split among multiple threads.
+ *  
+ *  \returns \c false if \a input is not suitable for parallel parsing or there was a problem parsing any element. In
+ *           either case, the caller should parse it normally.
+**/
+static bool parse_array_parallel(string_view                 input,
+                                 const parse_options&        options,
+                                 bool                        borrow_strings,
+                                 std::shared_ptr<const void> string_owner,
+                                 value&                      out
+                                )
+{
+    std::size_t threads = options.parallelism() == 0 ? std::thread::hardware_concurrency() : options.parallelism();
+    if (  threads < 2
+       || input.size() < parallel_min_input_size
+       || !options.selection().empty()
+       || options.max_structure_depth() == 1
+       || options.stats()
+       || detail::parse_context_base::has_budget(options)
+       )
+        return false;
+    
+    std::vector<string_view> elements;
+    if (!find_array_elements(input, options, elements) || elements.size() < threads)
+        return false;
+    
+    // Elements are one level down from the root, so the depth limit is one less for them
+    parse_options element_options = options;
+    element_options.failure_mode(parse_options::on_error::fail_immediately)
+                   .require_document(false)
+                   .complete_parse(true)
+                   .parallelism(1);
+    if (options.max_structure_depth() > 0)
+        element_options.max_structure_depth(options.max_structure_depth() - 1);
+    
+    // Elements are checked against the rules for them (sharing ownership of the whole schema) and the array itself is
+    // checked once it has been put together
+    const schema* root_rules = options.validation_schema().get();
+    if (root_rules)
+        element_options.validation_schema(std::shared_ptr<const schema>(options.validation_schema(),
+                                                                        root_rules->element_rules()
+                                                                       )
+                                         );
+    
+    struct part
+    {
+        std::size_t        begin;
+        std::size_t        end;
+        std::vector<value> values;
+        bool               failed;
+        std::exception_ptr error;
+    };
+    std::vector<part> parts;
+    for (std::size_t idx = 0; idx < threads; ++idx)
+        parts.push_back({ elements.size() * idx / threads, elements.size() * (idx + 1) / threads, {}, false, nullptr });
+    
+    auto run = [&] (part& work)
+               {
+                   try
+                   {
+                       work.values.reserve(work.end - work.begin);
+                       for (std::size_t idx = work.begin; idx < work.end; ++idx)
+                       {
+                           tokenizer tokens(elements[idx]);
+                           work.values.emplace_back(parse_tokens(tokens,
+                                                                 element_options,
+                                                                 borrow_strings,
+                                                                 string_owner
+                                                                )
+                                                   );
+                       }
+                   }
+                   catch (const parse_error&)
+                   {
+                       work.failed = true;
+                   }
+                   catch (...)
+                   {
+                       work.error = std::current_exception();
+                   }
+               };
+    
+    // The calling thread takes the first part itself
+    {
+        std::vector<std::thread> workers;
+        auto join_workers = detail::on_scope_exit([&workers]
+                                                  {
+                                                      for (std::thread& worker : workers)
+                                                          worker.join();
+                                                  }
+                                                 );
+        workers.reserve(parts.size() - 1);
+        for (std::size_t idx = 1; idx < parts.size(); ++idx)
+            workers.emplace_back(run, std::ref(parts[idx]));
+        run(parts[0]);
+    }
+    
+    for (const part& work : parts)
+    {
+        if (work.error)
+            std::rethrow_exception(work.error);
+        else if (work.failed)
+            return false;
+    }
+    
+    out = array();
+    for (part& work : parts)
+        for (value& val : work.values)
+            out.push_back(std::move(val));
+    
+    validation_error::code failure;
+    return !root_rules || root_rules->check(out, failure);
+}
+
+/** Parse the document in \a text, which is kept alive by \a string_owner (if there is one). **/
+static value parse_text(string_view                         text,
+                        const parse_options&                options,
+                        bool                                borrow_strings,
+                        std::shared_ptr<const void>         string_owner,
+                        std::vector<detail::parse_frame>*   frames = nullptr,
+                        value*                              reuse  = nullptr
+                       )
+{
+    detail::trace_scope trace(trace_operation::parse, text.size());
+    
+    value out;
+    if (options.parallelism() != 1 && parse_array_parallel(text, options, borrow_strings, string_owner, out))
+        return out;
+    
+    tokenizer tokens(text);
+    return parse_tokens(tokens, options, borrow_strings, std::move(string_owner), frames, reuse);
+}
+
+/** Parse \a input with the \c parse_options::string_storage of \a options. **/
+static value parse_input(const string_view&                input,
+                         const parse_options&              options,
+                         std::vector<detail::parse_frame>* frames,
+                         value*                            reuse = nullptr
+                        )
+{
+    switch (options.string_storage())
+    {
+    case parse_options::strings::borrow:
+        return parse_text(input, options, true, nullptr, frames, reuse);
+    case parse_options::strings::share:
+    {
+        auto buffer = std::make_shared<const std::string>(input.data(), input.size());
+        return parse_text(*buffer, options, true, buffer, frames, reuse);
+    }
+    case parse_options::strings::copy:
+    default:
+        return parse_text(input, options, false, nullptr, frames, reuse);
+    }
+}
+
 value parse(const string_view& input, const parse_options& options)
 {
-    tokenizer tokens(input);
-    return parse(tokens, options);
+    return parse_input(input, options, nullptr);
+}
+
+void parse_into(value& target, const string_view& input, const parse_options& options)
+{
+    target = parse_input(input, options, nullptr, &target);
+}
+
+value parse_file(const std::string& path, const parse_options& options)
+{
+    // The mapping never goes away before the strings which refer into it, so borrowing is the same as sharing
+    auto mapping = std::make_shared<const detail::file_mapping>(path);
+    bool borrow  = options.string_storage() != parse_options::strings::copy;
+    return parse_text(mapping->contents(), options, borrow, borrow ? mapping : nullptr);
+}
+
+value raw_json(std::string text)
+{
+    static const char whitespace[] = " \t\r\n";
+    text.erase(0, text.find_first_not_of(whitespace));
+    text.erase(text.find_last_not_of(whitespace) + 1);
+    
+    auto          encoded = std::make_shared<const std::string>(std::move(text));
+    parse_options options = parse_options::create_strict()
+                            .max_structure_depth(parse_options().max_structure_depth())
+                            .require_document(false);
+    value out = parse_text(*encoded, options, true, encoded);
+    detail::set_encoded_json(out, std::move(encoded));
+    return out;
 }
 
 value parse(const char* begin, const char* end, const parse_options& options)
@@ -808,9 +2042,754 @@ value parse(const char* begin, const char* end, const parse_options& options)
     return parse(string_view(begin, std::distance(begin, end)), options);
 }
 
-value operator"" _json(const char* str, std::size_t len)
+parse_result try_parse(string_view input, const parse_options& options, failure_details details)
+{
+    detail::trace_scope trace(trace_operation::parse, input.size());
+    
+    // Like parse_input, except that it is never done in parallel (since the elements would throw)
+    std::shared_ptr<const void> string_owner;
+    string_view                 text = input;
+    if (options.string_storage() == parse_options::strings::share)
+    {
+        auto buffer  = std::make_shared<const std::string>(input.data(), input.size());
+        text         = *buffer;
+        string_owner = std::move(buffer);
+    }
+    
+    parse_failure failure;
+    {
+        tokenizer             tokens(text);
+        detail::parse_context context(options, tokens);
+        context.borrow_strings = options.string_storage() != parse_options::strings::copy;
+        context.string_owner   = std::move(string_owner);
+        context.quiet          = true;
+        value out = parse_in_context(context);
+        if (context.successful)
+            return out;
+        failure = context.failure;
+    }
+    
+    if (details == failure_details::full)
+    {
+        try
+        {
+            parse(input, options);
+        }
+        catch (const parse_limit_error& ex)
+        {
+            failure.details = std::make_shared<parse_limit_error>(ex);
+        }
+        catch (const parse_error& ex)
+        {
+            failure.details = std::make_shared<parse_error>(ex);
+        }
+    }
+    return failure;
+}
+
+value operator"" _json(const char* str, std::size_t len)
 {
     return parse(string_view(str, len));
 }
 
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// event parsing                                                                                                      //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+static bool is_garbage(token_kind kind)
+{
+    switch (kind)
+    {
+    case token_kind::boolean:
+    case token_kind::null:
+    case token_kind::number:
+    case token_kind::string:
+    case token_kind::unknown:
+        return true;
+    default:
+        return (kind & token_kind::parse_error_indicator) == token_kind::parse_error_indicator;
+    }
+}
+
+/** Calls an \c encoder for each part of the document as tokens are found, using an explicit stack instead of recursion
+ *  so that tokens can be fed one at a time. The tokens come from the \c current token of the \c parse_context_base,
+ *  which is also used to report problems. The encoder sees the same sequence of calls that \c encoder::encode would
+ *  make for the parsed value.
+**/
+class JSONV_LOCAL event_parser
+{
+public:
+    /** If \a raw_numbers is set, the text of numbers is given to \c encoder::write_raw_json before converting it. **/
+    explicit event_parser(parse_context_base& context, encoder& out, bool raw_numbers = false) :
+            _context(context),
+            _out(out),
+            _expect(expect::value),
+            _skipping(false),
+            _raw_numbers(raw_numbers),
+            _root_kind(kind::null)
+    { }
+    
+    /** Has the root value been completed? **/
+    bool complete() const
+    {
+        return _expect == expect::done;
+    }
+    
+    /** Handle the \c current token of the context. **/
+    void accept()
+    {
+        token_kind tok_kind = _context.current_kind();
+        if (tok_kind == token_kind::whitespace)
+        {
+            return;
+        }
+        else if (tok_kind == token_kind::comment)
+        {
+            if (!_context.options.comments())
+                _context.parse_error(parse_errc::comment, "JSON comment is not allowed");
+            return;
+        }
+        else if (_expect == expect::done)
+        {
+            // At the end of input, we might have a few nulls -- this is expected for string literals, so ignore them.
+            string_view text = _context.current().text;
+            if (  _context.options.complete_parse()
+               && _context.successful
+               && tok_kind != token_kind::unknown
+               && std::any_of(text.begin(), text.end(), [] (char c) { return c != '\0'; })
+               )
+                _context.parse_error(parse_errc::trailing_data, "Found non-trivial data after final token. ", tok_kind);
+            return;
+        }
+        else if (_skipping)
+        {
+            if (is_garbage(tok_kind))
+                return;
+            _skipping = false;
+        }
+        
+        switch (_expect)
+        {
+        case expect::array_value_or_end:
+            if (tok_kind == token_kind::array_end)
+                return close("Array contained a trailing comma");
+            return accept_value();
+        case expect::value:
+            return accept_value();
+        case expect::array_separator_or_end:
+            if (tok_kind == token_kind::array_end)
+                return close("Array contained a trailing comma");
+            else if (tok_kind == token_kind::separator)
+                _stack.back().trailing_comma = true;
+            else
+                _context.parse_error(parse_errc::missing_separator, "Invalid entry when looking for ',' or ']'");
+            _expect = expect::array_value_or_end;
+            return;
+        case expect::object_key_or_end:
+            if (tok_kind == token_kind::object_end)
+                return close("Trailing comma at end of object.");
+            
+            if (!_stack.back().empty)
+                _out.write_object_delimiter();
+            if (tok_kind == token_kind::string)
+            {
+                _out.write_object_key(parse_key(_context));
+            }
+            else
+            {
+                _context.parse_error(parse_errc::missing_key, "Expecting a key, but found ", tok_kind);
+                // simulate a new key
+                _out.write_object_key(_context.current().text);
+            }
+            _expect = expect::object_key_delimiter;
+            return;
+        case expect::object_key_delimiter:
+            if (tok_kind != token_kind::object_key_delimiter)
+                _context.parse_error(parse_errc::missing_colon,
+                                     "Invalid key-value delimiter...expecting ':' after key");
+            _expect = expect::value;
+            return;
+        case expect::object_separator_or_end:
+            if (tok_kind == token_kind::object_end)
+                return close("Trailing comma at end of object.");
+            else if (tok_kind == token_kind::separator)
+                _stack.back().trailing_comma = true;
+            else
+                _context.parse_error(parse_errc::missing_separator,
+                                     "Invalid token while searching for next value in object.");
+            _expect = expect::object_key_or_end;
+            return;
+        case expect::done:
+            return;
+        }
+    }
+    
+    /** Signal the end of the input. Problems are reported for an incomplete document and anything left open is closed,
+     *  so the \c encoder always sees a balanced document.
+    **/
+    void finish()
+    {
+        if (_expect != expect::done)
+        {
+            if (_stack.empty())
+                _context.parse_error(parse_errc::unexpected_end, "No input");
+            
+            while (!_stack.empty())
+            {
+                bool is_object = _stack.back().object;
+                _context.parse_error(parse_errc::unexpected_end,
+                                     is_object ? "Unexpected end inside of object." : "Unexpected end: unmatched '['");
+                _stack.pop_back();
+                if (is_object)
+                    _out.write_object_end();
+                else
+                    _out.write_array_end();
+                end_value();
+            }
+        }
+        
+        if (_context.successful && _context.options.require_document())
+        {
+            if (_root_kind != kind::array && _root_kind != kind::object)
+                _context.parse_error(parse_errc::not_a_document,
+                                     "JSON requires the root of a payload to be an array or object, not ", _root_kind);
+        }
+    }
+    
+private:
+    enum class expect : unsigned char
+    {
+        value,
+        array_value_or_end,
+        array_separator_or_end,
+        object_key_or_end,
+        object_key_delimiter,
+        object_separator_or_end,
+        done,
+    };
+    
+    /** An array or object which has been opened, but not yet closed. **/
+    struct frame
+    {
+        bool object;
+        bool trailing_comma;
+        bool empty;
+    };
+    
+private:
+    void accept_value()
+    {
+        if (!_stack.empty() && !_stack.back().object && !_stack.back().empty)
+            _out.write_array_delimiter();
+        
+        value scalar;
+        kind  found = kind::null;
+        switch (_context.current_kind())
+        {
+        case token_kind::array_begin:
+            _out.write_array_begin();
+            return push(false);
+        case token_kind::object_begin:
+            _out.write_object_begin();
+            return push(true);
+        case token_kind::boolean:
+            parse_boolean(_context, scalar);
+            _out.write_boolean(scalar.as_boolean());
+            found = kind::boolean;
+            break;
+        case token_kind::null:
+            parse_null(_context, scalar);
+            _out.write_null();
+            break;
+        case token_kind::number:
+            if (_raw_numbers && write_raw_number())
+            {
+                found = kind::decimal;
+                break;
+            }
+            parse_number(_context, scalar);
+            found = scalar.kind();
+            if (found == kind::integer)
+                _out.write_integer(scalar.as_integer());
+            else if (found == kind::decimal)
+                _out.write_decimal(scalar.as_decimal());
+            else
+                _out.write_null();
+            break;
+        case token_kind::string:
+            // Strings which do not need decoding can be handed over without a copy
+            if (decodes_to_itself(_context, string_contents(_context)))
+                _out.write_string(string_contents(_context));
+            else
+                _out.write_string(parse_string(_context));
+            found = kind::string;
+            break;
+        default:
+            _context.parse_error(parse_errc::invalid_token,
+                                 "Encountered invalid token ", _context.current_kind(), ": \"", _context.current().text,
+                                 "\""
+                                );
+            _skipping = true;
+            _out.write_null();
+            break;
+        }
+        
+        if (_stack.empty())
+            _root_kind = found;
+        end_value();
+    }
+    
+    void push(bool object)
+    {
+        if (_stack.empty())
+            _root_kind = object ? kind::object : kind::array;
+        
+        _stack.push_back({ object, false, true });
+        _expect = object ? expect::object_key_or_end : expect::array_value_or_end;
+        if (_stack.size() == _context.options.max_structure_depth())
+            _context.parse_error(parse_errc::too_deep, "Structure depth reached maximum of ", _stack.size());
+        if (_context.stats)
+            _context.stats->max_depth = std::max(_context.stats->max_depth, _stack.size());
+    }
+    
+    /** Give the text of the current number token to the encoder as it is, unless it needs to be checked by converting
+     *  it (or the encoder does not take it).
+    **/
+    bool write_raw_number()
+    {
+        string_view text = _context.current().text;
+        return !_context.options.require_finite_numbers()
+            && !has_leading_zero(_context, text)
+            && detail::is_number(text)
+            && _out.write_raw_json(text);
+    }
+    
+    /** A value was completed -- figure out what should come after it. **/
+    void end_value()
+    {
+        if (_stack.empty())
+        {
+            _expect = expect::done;
+        }
+        else
+        {
+            frame& top = _stack.back();
+            top.empty          = false;
+            top.trailing_comma = false;
+            _expect = top.object ? expect::object_separator_or_end : expect::array_separator_or_end;
+        }
+    }
+    
+    void close(const char* trailing_comma_message)
+    {
+        if (_stack.back().trailing_comma && _context.options.comma_policy() != parse_options::commas::allow_trailing)
+            _context.parse_error(parse_errc::trailing_comma, trailing_comma_message);
+        
+        bool is_object = _stack.back().object;
+        _stack.pop_back();
+        if (is_object)
+            _out.write_object_end();
+        else
+            _out.write_array_end();
+        end_value();
+    }
+    
+private:
+    parse_context_base& _context;
+    encoder&            _out;
+    std::vector<frame>  _stack;
+    expect              _expect;
+    bool                _skipping;  //!< After an invalid value, skip over scalars until the next structural token.
+    bool                _raw_numbers;
+    kind                _root_kind;
+};
+
+/** An \c encoder which builds a \c value from the calls it receives. **/
+class JSONV_LOCAL value_builder :
+        public encoder
+{
+public:
+    explicit value_builder(parse_context_base& context) :
+            _context(context)
+    { }
+    
+    value& result()
+    {
+        return _result;
+    }
+    
+protected:
+    virtual void write_null() override                       { deliver(value()); }
+    virtual void write_string(string_view value) override    { deliver(std::string(value)); }
+    virtual void write_integer(std::int64_t value) override  { deliver(value); }
+    virtual void write_decimal(double value) override        { deliver(value); }
+    virtual void write_boolean(bool value) override          { deliver(value); }
+    virtual void write_object_delimiter() override           { }
+    virtual void write_array_delimiter() override            { }
+    
+    virtual void write_object_begin() override
+    {
+        _stack.push_back({ object(), std::string() });
+    }
+    
+    virtual void write_array_begin() override
+    {
+        _stack.push_back({ array(), std::string() });
+    }
+    
+    virtual void write_object_key(string_view key) override
+    {
+        _stack.back().key.assign(key.data(), key.size());
+    }
+    
+    virtual void write_object_end() override { end_container(); }
+    virtual void write_array_end() override  { end_container(); }
+    
+private:
+    struct frame
+    {
+        value       container;
+        std::string key;        //!< For objects, the key of the value being built.
+    };
+    
+private:
+    void end_container()
+    {
+        value out = std::move(_stack.back().container);
+        _stack.pop_back();
+        deliver(std::move(out));
+    }
+    
+    void deliver(value&& val)
+    {
+        if (_stack.empty())
+        {
+            _result = std::move(val);
+        }
+        else if (_stack.back().container.kind() == kind::array)
+        {
+            _stack.back().container.push_back(std::move(val));
+        }
+        else
+        {
+            frame& top  = _stack.back();
+            auto   iter = top.container.find(top.key);
+            if (iter == top.container.end_object())
+            {
+                top.container.insert({ std::move(top.key), std::move(val) });
+            }
+            else
+            {
+                _context.parse_error(parse_errc::duplicate_key, "Duplicate entries for key '", top.key, "'. ",
+                                     "Updating old value ", iter->second, " with new value ", val, "."
+                                    );
+                iter->second = std::move(val);
+            }
+        }
+    }
+    
+private:
+    parse_context_base& _context;
+    std::vector<frame>  _stack;
+    value               _result;
+};
+
+}
+
+/** Parse \a input into calls to \a handler. See \c detail::event_parser for \a raw_numbers. **/
+static void parse_events(tokenizer& input, encoder& handler, const parse_options& options, bool raw_numbers)
+{
+    detail::parse_context context(options, input);
+    detail::event_parser  events(context, handler, raw_numbers);
+    detail::stats_timer   timer(context.stats_time(&parse_stats::total_time));
+    if (context.stats)
+        ++context.stats->documents;
+    
+    // With complete_parse disabled, leave input after the document in the tokenizer for the next parse
+    while (!(events.complete() && !options.complete_parse()) && context.next())
+        events.accept();
+    events.finish();
+    
+    if (!context.successful && options.failure_mode() != parse_options::on_error::ignore)
+        throw parse_error(context.problem_list(), null);
+}
+
+void parse(tokenizer& input, encoder& handler, const parse_options& options)
+{
+    detail::trace_scope trace(trace_operation::parse);
+    parse_events(input, handler, options, false);
+}
+
+void parse(std::istream& input, encoder& handler, const parse_options& options)
+{
+    tokenizer tokens(input);
+    parse(tokens, handler, options);
+}
+
+void parse(const string_view& input, encoder& handler, const parse_options& options)
+{
+    detail::trace_scope trace(trace_operation::parse, input.size());
+    tokenizer           tokens(input);
+    parse(tokens, handler, options);
+}
+
+void reformat(const string_view& input, encoder& handler, const parse_options& options)
+{
+    detail::trace_scope trace(trace_operation::parse, input.size());
+    tokenizer           tokens(input);
+    parse_events(tokens, handler, options, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// parser                                                                                                             //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct JSONV_LOCAL parser::data
+{
+    parse_options                    options;
+    std::vector<detail::parse_frame> frames;
+    
+    explicit data(const parse_options& options) :
+            options(options)
+    { }
+};
+
+parser::parser(const parse_options& options) :
+        _data(new data(options))
+{ }
+
+parser::parser(parser&&) noexcept = default;
+
+parser& parser::operator=(parser&&) noexcept = default;
+
+parser::~parser() noexcept = default;
+
+const parse_options& parser::options() const
+{
+    return _data->options;
+}
+
+value parser::parse(const string_view& input)
+{
+    return parse_input(input, _data->options, &_data->frames);
+}
+
+void parser::parse_into(value& target, const string_view& input)
+{
+    target = parse_input(input, _data->options, &_data->frames, &target);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// incremental_parser                                                                                                 //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Holds the options the \c parse_context_base of an \c incremental_parser refers to (it is a base so it is constructed
+ *  first).
+**/
+struct JSONV_LOCAL incremental_parser_options
+{
+    parse_options stored_options;
+};
+
+struct JSONV_LOCAL incremental_parser::data :
+        private incremental_parser_options,
+        public detail::parse_context_base
+{
+    detail::value_builder builder;
+    detail::event_parser  events;
+    
+    /** A token at the end of the last chunk which might be continued by the next one. **/
+    std::string pending;
+    
+    tokenizer::token current_token;
+    
+    /** The location of \c location_ptr; if \c location_ptr is \c nullptr, this is the location of the point the parser
+     *  has reached (the start of \c pending if there is one).
+    **/
+    mutable tokenizer::location location;
+    mutable const char*         location_ptr;
+    
+    explicit data(const parse_options& options) :
+            incremental_parser_options{ options },
+            parse_context_base(stored_options),
+            builder(*this),
+            events(*this, builder),
+            location{ 1, 1, 0 },
+            location_ptr(nullptr)
+    {
+        // this does its own tokenizing, so only part of the parse_stats would be collected
+        stats = nullptr;
+    }
+    
+    /** Move the tracked location forward to \a to, which is in the same buffer as \c location_ptr. **/
+    void advance_location_to(const char* to) const
+    {
+        if (location_ptr)
+            detail::advance_location(location, location_ptr, to);
+        location_ptr = to;
+    }
+    
+    virtual tokenizer::location current_location() const override
+    {
+        if (token && location_ptr)
+            advance_location_to(token->text.data());
+        return location;
+    }
+    
+    /** Handle a single token. **/
+    void accept(const tokenizer::token& tok)
+    {
+        current_token = tok;
+        token         = &current_token;
+        events.accept();
+    }
+    
+    /** Tokenize and accept everything in [\a begin, \a end) without waiting for more input. **/
+    void accept_all(const char* begin, const char* end)
+    {
+        while (begin != end)
+        {
+            token_kind  kind;
+            std::size_t length;
+            if (detail::attempt_match(begin, end, kind, length) == detail::match_result::unmatched)
+                kind = kind | token_kind::parse_error_indicator;
+            accept({ string_view(begin, length), kind });
+            begin += length;
+            advance_location_to(begin);
+        }
+    }
+    
+    /** Try to finish the \c pending token with the start of a new chunk [\a begin, \a end).
+     *  
+     *  \returns The position in the chunk after the \c pending token.
+    **/
+    const char* feed_pending(const char* begin, const char* end)
+    {
+        // Tokens which straddle chunks are rare and usually short, so only copy a little of the chunk at a time
+        static constexpr std::size_t piece_size = 64;
+        
+        const std::size_t original_size = pending.size();
+        const char*       pos           = begin;
+        while (true)
+        {
+            std::size_t take = std::min(std::size_t(end - pos), piece_size);
+            pending.append(pos, take);
+            pos += take;
+            
+            const char* pending_end = pending.data() + pending.size();
+            token_kind  kind;
+            std::size_t length;
+            auto result = detail::attempt_match(pending.data(), pending_end, kind, length);
+            if (detail::match_may_continue(result, kind, pending.data() + length, pending_end))
+            {
+                if (pos == end)
+                    return end;
+                else
+                    continue;
+            }
+            
+            if (result == detail::match_result::unmatched)
+                kind = kind | token_kind::parse_error_indicator;
+            
+            assert(length >= original_size);
+            location_ptr = pending.data();
+            accept({ string_view(pending.data(), length), kind });
+            advance_location_to(pending.data() + length);
+            
+            pending.clear();
+            location_ptr = nullptr;
+            return begin + (length - original_size);
+        }
+    }
+};
+
+incremental_parser::incremental_parser(const parse_options& options) :
+        _data(new data(options))
+{ }
+
+incremental_parser::incremental_parser(incremental_parser&&) noexcept = default;
+
+incremental_parser& incremental_parser::operator=(incremental_parser&&) noexcept = default;
+
+incremental_parser::~incremental_parser() noexcept = default;
+
+bool incremental_parser::feed(string_view chunk)
+{
+    data&       self = *_data;
+    const char* pos  = chunk.data();
+    const char* end  = chunk.data() + chunk.size();
+    
+    // Make sure location_ptr and the current token are cleared no matter how we leave, since they point into the chunk
+    auto cleanup = detail::on_scope_exit([&]
+                                         {
+                                             self.location_ptr = nullptr;
+                                             self.token        = nullptr;
+                                         }
+                                        );
+    
+    if (!self.pending.empty())
+        pos = self.feed_pending(pos, end);
+    
+    self.location_ptr = pos;
+    while (pos != end)
+    {
+        if (self.events.complete() && !self.options.complete_parse())
+            break;
+        
+        token_kind  kind;
+        std::size_t length;
+        auto result = detail::attempt_match(pos, end, kind, length);
+        if (detail::match_may_continue(result, kind, pos + length, end))
+        {
+            self.advance_location_to(pos);
+            self.pending.assign(pos, end);
+            break;
+        }
+        
+        if (result == detail::match_result::unmatched)
+            kind = kind | token_kind::parse_error_indicator;
+        
+        self.accept({ string_view(pos, length), kind });
+        pos += length;
+    }
+    self.advance_location_to(pos);
+    
+    return complete();
+}
+
+bool incremental_parser::complete() const
+{
+    return _data->events.complete();
+}
+
+value incremental_parser::finish()
+{
+    data& self = *_data;
+    auto cleanup = detail::on_scope_exit([this] { reset(); });
+    
+    if (!self.pending.empty())
+    {
+        self.location_ptr = self.pending.data();
+        self.accept_all(self.pending.data(), self.pending.data() + self.pending.size());
+    }
+    self.location_ptr = nullptr;
+    self.token        = nullptr;
+    
+    self.events.finish();
+    
+    if (self.successful || self.options.failure_mode() == parse_options::on_error::ignore)
+        return std::move(self.builder.result());
+    else
+        throw parse_error(self.problem_list(), self.builder.result());
+}
+
+void incremental_parser::reset()
+{
+    _data.reset(new data(_data->options));
+}
+
 }
@@ -0,0 +1,179 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/parse_cache.hpp>
+#include <jsonv/memory_usage.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace jsonv
+{
+
+namespace
+{
+
+/** Hashes 8 bytes at a time, since the whole document is hashed on every lookup. **/
+struct text_hash
+{
+    static std::uint64_t mix(std::uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    std::size_t operator()(string_view text) const
+    {
+        const char*   iter = text.data();
+        std::size_t   left = text.size();
+        std::uint64_t h    = 0x9e3779b97f4a7c15ULL ^ left;
+        for (; left >= sizeof(std::uint64_t); iter += sizeof(std::uint64_t), left -= sizeof(std::uint64_t))
+        {
+            std::uint64_t word;
+            std::memcpy(&word, iter, sizeof word);
+            h = (h ^ mix(word)) * 0x9ddfea08eb382d69ULL;
+        }
+        if (left > 0)
+        {
+            std::uint64_t word = 0;
+            std::memcpy(&word, iter, left);
+            h = (h ^ mix(word)) * 0x9ddfea08eb382d69ULL;
+        }
+        return std::size_t(mix(h));
+    }
+};
+
+struct entry
+{
+    std::string text;
+    value       result;
+    std::size_t bytes;
+};
+
+}
+
+struct parse_cache::impl
+{
+    using entry_list = std::list<entry>;
+    using lookup_map = std::unordered_map<string_view, entry_list::iterator, text_hash>;
+
+    size_type          max_bytes;
+    parse_options      options;
+    mutable std::mutex lock;
+    entry_list         entries;     //!< Most-recently used first -- \c lookup refers into it.
+    lookup_map         lookup;
+    size_type          bytes  = 0;
+    size_type          hits   = 0;
+    size_type          misses = 0;
+
+    void evict_to(size_type limit)
+    {
+        while (bytes > limit && !entries.empty())
+        {
+            const entry& victim = entries.back();
+            bytes -= victim.bytes;
+            lookup.erase(string_view(victim.text));
+            entries.pop_back();
+        }
+    }
+};
+
+parse_cache::parse_cache(size_type max_bytes, const parse_options& options) :
+        _impl(new impl)
+{
+    _impl->max_bytes = max_bytes;
+    _impl->options   = options;
+    if (options.string_storage() == parse_options::strings::borrow)
+        _impl->options.string_storage(parse_options::strings::share);
+}
+
+parse_cache::~parse_cache() noexcept = default;
+
+value parse_cache::parse(string_view input)
+{
+    {
+        std::lock_guard<std::mutex> guard(_impl->lock);
+        auto iter = _impl->lookup.find(input);
+        if (iter != _impl->lookup.end())
+        {
+            ++_impl->hits;
+            _impl->entries.splice(_impl->entries.begin(), _impl->entries, iter->second);
+            return iter->second->result;
+        }
+        ++_impl->misses;
+    }
+
+    // parse without holding the lock, so a slow document does not hold up lookups of others
+    value result = jsonv::parse(input, _impl->options);
+    result.make_shareable();
+    std::size_t bytes = input.size() + memory_usage(result).total_bytes() + sizeof(entry);
+    if (bytes > _impl->max_bytes)
+        return result;
+
+    std::lock_guard<std::mutex> guard(_impl->lock);
+    // another thread might have parsed the same text in the meantime
+    if (_impl->lookup.find(input) != _impl->lookup.end())
+        return result;
+
+    _impl->evict_to(_impl->max_bytes - bytes);
+    _impl->entries.push_front(entry{ std::string(input), result, bytes });
+    _impl->lookup.emplace(string_view(_impl->entries.front().text), _impl->entries.begin());
+    _impl->bytes += bytes;
+    return result;
+}
+
+void parse_cache::clear()
+{
+    std::lock_guard<std::mutex> guard(_impl->lock);
+    _impl->evict_to(0);
+}
+
+parse_cache::size_type parse_cache::size() const
+{
+    std::lock_guard<std::mutex> guard(_impl->lock);
+    return _impl->entries.size();
+}
+
+parse_cache::size_type parse_cache::bytes() const
+{
+    std::lock_guard<std::mutex> guard(_impl->lock);
+    return _impl->bytes;
+}
+
+parse_cache::size_type parse_cache::max_bytes() const
+{
+    return _impl->max_bytes;
+}
+
+parse_cache::size_type parse_cache::hits() const
+{
+    std::lock_guard<std::mutex> guard(_impl->lock);
+    return _impl->hits;
+}
+
+parse_cache::size_type parse_cache::misses() const
+{
+    std::lock_guard<std::mutex> guard(_impl->lock);
+    return _impl->misses;
+}
+
+const parse_options& parse_cache::options() const
+{
+    return _impl->options;
+}
+
+}
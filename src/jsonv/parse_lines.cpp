@@ -0,0 +1,249 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/parse_lines.hpp>
+#include <jsonv/detail/scope_exit.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <istream>
+#include <thread>
+
+namespace jsonv
+{
+
+static bool is_blank(string_view line)
+{
+    return std::all_of(line.begin(), line.end(), [] (char c) { return c == ' ' || c == '\t' || c == '\r'; });
+}
+
+/** Parse a single \a line, which starts at \a offset of the full input. Problems are moved to the \a line_number and
+ *  offset of the \a line in the full input.
+**/
+static value parse_line(string_view line, std::size_t line_number, std::size_t offset, const parse_options& options)
+{
+    try
+    {
+        return parse(line, options);
+    }
+    catch (const parse_error& err)
+    {
+        parse_error::problem_list problems;
+        for (const parse_error::problem& p : err.problems())
+            problems.emplace_back(line_number + p.line() - 1, p.column(), offset + p.character(), p.message());
+        throw parse_error(std::move(problems), err.partial_result());
+    }
+}
+
+/** Find the next line of \a text starting at \a position, which is moved past it.
+ *
+ *  \returns \c false if there are no more lines.
+**/
+static bool next_line(string_view text, std::size_t& position, string_view& line)
+{
+    if (position >= text.size())
+        return false;
+
+    const char* begin = text.data() + position;
+    const char* end   = std::find(begin, text.data() + text.size(), '\n');
+    line     = string_view(begin, std::size_t(end - begin));
+    position = std::size_t(end - text.data()) + 1;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// line_range                                                                                                         //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+line_range::line_range(std::istream& input, const parse_options& options) :
+        _stream(&input),
+        _position(0),
+        _options(options),
+        _line(0),
+        _next_line(1),
+        _started(false),
+        _finished(false)
+{ }
+
+line_range::line_range(string_view input, const parse_options& options) :
+        _stream(nullptr),
+        _text(input),
+        _position(0),
+        _options(options),
+        _line(0),
+        _next_line(1),
+        _started(false),
+        _finished(false)
+{ }
+
+line_range::line_range(line_range&&) noexcept = default;
+
+line_range& line_range::operator=(line_range&&) noexcept = default;
+
+line_range::~line_range() noexcept = default;
+
+line_range::iterator line_range::begin()
+{
+    if (!_started)
+    {
+        _started = true;
+        next();
+    }
+    return _finished ? end() : iterator(this);
+}
+
+line_range::iterator line_range::end()
+{
+    return iterator();
+}
+
+bool line_range::next()
+{
+    string_view line;
+    std::size_t offset;
+    do
+    {
+        offset = _position;
+        bool found;
+        if (_stream)
+        {
+            found      = bool(std::getline(*_stream, _buffer));
+            line       = _buffer;
+            _position += _buffer.size() + 1;
+        }
+        else
+        {
+            found = next_line(_text, _position, line);
+        }
+
+        if (!found)
+        {
+            _finished = true;
+            return false;
+        }
+        _line = _next_line++;
+    } while (is_blank(line));
+
+    _current = parse_line(line, _line, offset, _options);
+    return true;
+}
+
+line_range parse_lines(std::istream& input, const parse_options& options)
+{
+    return line_range(input, options);
+}
+
+line_range parse_lines(string_view input, const parse_options& options)
+{
+    return line_range(input, options);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// parse_lines_parallel                                                                                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Chunks are large enough that starting a thread for each one is cheap in comparison to parsing it. **/
+static constexpr std::size_t parallel_chunk_size = 1024 * 1024;
+
+namespace
+{
+
+/** A range of whole lines which is parsed by a single worker. **/
+struct chunk
+{
+    string_view        text;
+    std::size_t        offset;      //!< The offset of \c text in the full input.
+    std::size_t        first_line;
+    std::vector<value> documents;
+    std::exception_ptr error;       //!< The first error encountered -- every document before it is in \c documents.
+
+    void run(const parse_options& options)
+    {
+        try
+        {
+            std::size_t position = 0;
+            std::size_t line_num = first_line;
+            string_view line;
+            for (std::size_t start = 0; next_line(text, position, line); start = position, ++line_num)
+            {
+                if (!is_blank(line))
+                    documents.emplace_back(parse_line(line, line_num, offset + start, options));
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+    }
+};
+
+}
+
+void parse_lines_parallel(string_view                        input,
+                          const std::function<void (value)>& on_document,
+                          const parse_options&               options,
+                          std::size_t                        threads
+                         )
+{
+    if (threads == 0)
+        threads = std::max(1U, std::thread::hardware_concurrency());
+
+    std::size_t position = 0;
+    std::size_t line_num = 1;
+    while (position < input.size())
+    {
+        // Split the next batch of the input on line boundaries
+        std::vector<chunk> batch;
+        while (batch.size() < threads && position < input.size())
+        {
+            const char* input_end = input.data() + input.size();
+            const char* limit     = input.data() + std::min(input.size(), position + parallel_chunk_size);
+            const char* newline   = std::find(limit - 1, input_end, '\n');
+            std::size_t end       = newline == input_end ? input.size() : std::size_t(newline - input.data()) + 1;
+
+            string_view text = input.substr(position, end - position);
+            batch.push_back({ text, position, line_num, {}, nullptr });
+            line_num += std::size_t(std::count(text.begin(), text.end(), '\n'));
+            position  = end;
+        }
+
+        // The calling thread takes the first chunk itself
+        {
+            std::vector<std::thread> workers;
+            auto join_workers = detail::on_scope_exit([&workers]
+                                                      {
+                                                          for (std::thread& worker : workers)
+                                                              worker.join();
+                                                      }
+                                                     );
+            workers.reserve(batch.size() - 1);
+            for (std::size_t idx = 1; idx < batch.size(); ++idx)
+                workers.emplace_back([&batch, &options, idx] { batch[idx].run(options); });
+            batch[0].run(options);
+        }
+
+        for (chunk& part : batch)
+        {
+            for (value& doc : part.documents)
+                on_document(std::move(doc));
+            if (part.error)
+                std::rethrow_exception(part.error);
+        }
+    }
+}
+
+std::vector<value> parse_lines_parallel(string_view input, const parse_options& options, std::size_t threads)
+{
+    std::vector<value> out;
+    parse_lines_parallel(input, [&out] (value doc) { out.emplace_back(std::move(doc)); }, options, threads);
+    return out;
+}
+
+}
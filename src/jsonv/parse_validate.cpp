@@ -0,0 +1,33 @@
+/** \file
+ *  Checking the syntax of JSON without building a \c value.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/parse.hpp>
+
+#include "detail/syntax_validator.hpp"
+
+namespace jsonv
+{
+
+bool is_valid(string_view input, const parse_options& options)
+{
+    return detail::syntax_validator(input, options).run();
+}
+
+optional<parse_error::problem> validate_syntax(string_view input, const parse_options& options)
+{
+    detail::syntax_validator validator(input, options);
+    if (validator.run())
+        return nullopt;
+    else
+        return validator.problem();
+}
+
+}
@@ -211,7 +211,8 @@ bool path_element::operator!=(const path_element& other) const
     return !operator==(other);
 }
 
-static std::ostream& stream_path_element(std::ostream& os, const path_element& elem)
+template <typename TElement>
+static std::ostream& stream_path_element(std::ostream& os, const TElement& elem)
 {
     switch (elem.kind())
     {
@@ -219,7 +220,7 @@ static std::ostream& stream_path_element(std::ostream& os, const path_element& e
         return os << '[' << elem.index() << ']';
     case path_element_kind::object_key:
         // if any of the elements is not alphanumeric (or it is an empty string), use the [] notation
-        if (elem.key().empty() || std::any_of(begin(elem.key()), end(elem.key()), [] (char c) { return !std::isalnum(c); }))
+        if (elem.key().empty() || std::any_of(elem.key().begin(), elem.key().end(), [] (char c) { return !std::isalnum(c); }))
             return os << "[\"" << elem.key() << "\"]";
         else
             return os << '.' << elem.key();
@@ -342,4 +343,109 @@ std::string to_string(const path& val)
     return os.str();
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// path_element_view                                                                                                  //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+path_element_view::path_element_view(const path_element& elem) :
+        _kind(elem.kind()),
+        _index(elem.kind() == path_element_kind::array_index ? elem.index() : 0)
+{
+    if (_kind == path_element_kind::object_key)
+        _key = elem.key();
+}
+
+std::size_t path_element_view::index() const
+{
+    if (_kind != path_element_kind::array_index)
+        throw kind_error("Cannot get index on object_key path_element_view");
+    else
+        return _index;
+}
+
+string_view path_element_view::key() const
+{
+    if (_kind != path_element_kind::object_key)
+        throw kind_error("Cannot get key on array_index path_element_view");
+    else
+        return _key;
+}
+
+path_element path_element_view::to_element() const
+{
+    if (_kind == path_element_kind::object_key)
+        return path_element(_key);
+    else
+        return path_element(_index);
+}
+
+bool path_element_view::operator==(const path_element_view& other) const
+{
+    if (kind() != other.kind())
+        return false;
+    else if (kind() == path_element_kind::object_key)
+        return key() == other.key();
+    else
+        return index() == other.index();
+}
+
+bool path_element_view::operator!=(const path_element_view& other) const
+{
+    return !operator==(other);
+}
+
+std::ostream& operator<<(std::ostream& os, const path_element_view& elem)
+{
+    return stream_path_element(os, elem);
+}
+
+std::string to_string(const path_element_view& val)
+{
+    std::ostringstream os;
+    os << val;
+    return os.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// path_view                                                                                                          //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+path path_view::to_path() const
+{
+    path::storage_type elements;
+    elements.reserve(size());
+    for (const path_element_view& elem : *this)
+        elements.emplace_back(elem.to_element());
+    return path(std::move(elements));
+}
+
+path_view::operator path() const
+{
+    return to_path();
+}
+
+bool path_view::operator==(const path_view& other) const
+{
+    return size() == other.size() && std::equal(begin(), end(), other.begin());
+}
+
+bool path_view::operator!=(const path_view& other) const
+{
+    return !operator==(other);
+}
+
+std::ostream& operator<<(std::ostream& os, const path_view& val)
+{
+    for (const path_element_view& elem : val)
+        stream_path_element(os, elem);
+    return os;
+}
+
+std::string to_string(const path_view& val)
+{
+    std::ostringstream os;
+    os << val;
+    return os.str();
+}
+
 }
@@ -0,0 +1,1135 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/query.hpp>
+#include <jsonv/encode.hpp>
+#include <jsonv/tokenizer.hpp>
+#include <jsonv/value.hpp>
+#include <jsonv/writer.hpp>
+#include <jsonv/detail/token_stream.hpp>
+
+#include "char_convert.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace jsonv
+{
+namespace detail
+{
+
+enum class query_op
+{
+    identity,   //!< \c .
+    literal,    //!< A constant (in \c literal).
+    key,        //!< \c .name of \c children[0] (the name is in \c name).
+    index,      //!< \c .[n] of \c children[0] (the index is in \c index).
+    each,       //!< \c .[] of \c children[0].
+    pipe,       //!< Every child, each given the results of the one before it.
+    comma,      //!< The results of every child, one after another.
+    collect,    //!< \c [children[0]]
+    construct,  //!< An object, with the key and value filters of each entry one after the other in \c children.
+    binary,     //!< The operator (\c +, \c ==, ...) in \c name on \c children[0] and \c children[1].
+    logical,    //!< \c and or \c or (in \c name) on \c children[0] and \c children[1].
+    call,       //!< The builtin \c name, with its arguments in \c children.
+};
+
+struct JSONV_LOCAL query_node
+{
+    using ptr = std::shared_ptr<const query_node>;
+
+    query_op         kind;
+    std::vector<ptr> children;
+    value            literal;
+    std::string      name;
+    std::int64_t     index = 0;
+
+    explicit query_node(query_op kind, std::vector<ptr> children = std::vector<ptr>()) :
+            kind(kind),
+            children(std::move(children))
+    { }
+};
+
+}
+
+using detail::query_node;
+using detail::query_op;
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Compilation                                                                                                        //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+query_node::ptr make_node(query_op kind, std::vector<query_node::ptr> children = std::vector<query_node::ptr>())
+{
+    return std::make_shared<query_node>(kind, std::move(children));
+}
+
+query_node::ptr make_literal(value literal)
+{
+    auto out = std::make_shared<query_node>(query_op::literal);
+    out->literal = std::move(literal);
+    return out;
+}
+
+query_node::ptr make_named(query_op kind, std::string name, std::vector<query_node::ptr> children)
+{
+    auto out = std::make_shared<query_node>(kind, std::move(children));
+    out->name = std::move(name);
+    return out;
+}
+
+bool is_identifier_start(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool is_identifier_char(char c)
+{
+    return is_identifier_start(c) || (c >= '0' && c <= '9');
+}
+
+bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/** A recursive-descent parser for the filter language, from the loosest binding operator (\c |) to the tightest. **/
+class query_compiler
+{
+public:
+    explicit query_compiler(string_view program) :
+            _program(program),
+            _pos(0)
+    { }
+
+    query_node::ptr compile()
+    {
+        query_node::ptr out = parse_pipe();
+        skip_whitespace();
+        if (_pos != _program.size())
+            throw error("Unexpected text");
+        return out;
+    }
+
+private:
+    std::invalid_argument error(const std::string& message) const
+    {
+        return std::invalid_argument("Invalid query \"" + std::string(_program) + "\". " + message + " at \""
+                                     + std::string(_program.substr(_pos)) + "\""
+                                    );
+    }
+
+    void skip_whitespace()
+    {
+        while (_pos < _program.size()
+               && (_program[_pos] == ' ' || _program[_pos] == '\t' || _program[_pos] == '\r' || _program[_pos] == '\n')
+              )
+            ++_pos;
+    }
+
+    /** Look at the next character which is not whitespace (or \c '\0' at the end). **/
+    char peek()
+    {
+        skip_whitespace();
+        return _pos < _program.size() ? _program[_pos] : '\0';
+    }
+
+    /** Consume \a text if it is next. **/
+    bool accept(string_view text)
+    {
+        skip_whitespace();
+        if (_program.size() - _pos < text.size() || _program.substr(_pos, text.size()) != text)
+            return false;
+        // don't take the "or" from "order" or "==" as "="
+        std::size_t end = _pos + text.size();
+        if (is_identifier_start(text[0]) && end < _program.size() && is_identifier_char(_program[end]))
+            return false;
+        _pos = end;
+        return true;
+    }
+
+    void expect(string_view text)
+    {
+        if (!accept(text))
+            throw error("Expected \"" + std::string(text) + "\"");
+    }
+
+    query_node::ptr parse_pipe()
+    {
+        std::vector<query_node::ptr> stages = { parse_comma() };
+        while (accept("|"))
+            stages.push_back(parse_comma());
+        return stages.size() == 1U ? stages[0] : make_node(query_op::pipe, std::move(stages));
+    }
+
+    query_node::ptr parse_comma()
+    {
+        std::vector<query_node::ptr> parts = { parse_or() };
+        while (accept(","))
+            parts.push_back(parse_or());
+        return parts.size() == 1U ? parts[0] : make_node(query_op::comma, std::move(parts));
+    }
+
+    query_node::ptr parse_or()
+    {
+        query_node::ptr out = parse_and();
+        while (accept("or"))
+            out = make_named(query_op::logical, "or", { out, parse_and() });
+        return out;
+    }
+
+    query_node::ptr parse_and()
+    {
+        query_node::ptr out = parse_comparison();
+        while (accept("and"))
+            out = make_named(query_op::logical, "and", { out, parse_comparison() });
+        return out;
+    }
+
+    query_node::ptr parse_comparison()
+    {
+        static const char* const operators[] = { "==", "!=", "<=", ">=", "<", ">" };
+
+        query_node::ptr out = parse_additive();
+        for (const char* op : operators)
+            if (accept(op))
+                return make_named(query_op::binary, op, { out, parse_additive() });
+        return out;
+    }
+
+    query_node::ptr parse_additive()
+    {
+        query_node::ptr out = parse_multiplicative();
+        while (true)
+        {
+            if (accept("+"))
+                out = make_named(query_op::binary, "+", { out, parse_multiplicative() });
+            else if (accept("-"))
+                out = make_named(query_op::binary, "-", { out, parse_multiplicative() });
+            else
+                return out;
+        }
+    }
+
+    query_node::ptr parse_multiplicative()
+    {
+        query_node::ptr out = parse_unary();
+        while (true)
+        {
+            if (accept("*"))
+                out = make_named(query_op::binary, "*", { out, parse_unary() });
+            else if (accept("/"))
+                out = make_named(query_op::binary, "/", { out, parse_unary() });
+            else if (accept("%"))
+                out = make_named(query_op::binary, "%", { out, parse_unary() });
+            else
+                return out;
+        }
+    }
+
+    query_node::ptr parse_unary()
+    {
+        if (accept("-"))
+            return make_named(query_op::binary, "-", { make_literal(0), parse_unary() });
+        return parse_postfix(parse_primary());
+    }
+
+    /** Parse the \c .name, \c ."name", \c [n] and \c [] which follow \a subject. **/
+    query_node::ptr parse_postfix(query_node::ptr subject)
+    {
+        while (true)
+        {
+            skip_whitespace();
+            if (_pos + 1 < _program.size() && _program[_pos] == '.'
+                && (is_identifier_start(_program[_pos + 1]) || _program[_pos + 1] == '"' || _program[_pos + 1] == '[')
+               )
+            {
+                ++_pos;
+                if (_program[_pos] == '[')
+                    subject = parse_bracket(std::move(subject));
+                else
+                    subject = parse_key(std::move(subject));
+            }
+            else if (_pos < _program.size() && _program[_pos] == '[')
+            {
+                subject = parse_bracket(std::move(subject));
+            }
+            else
+            {
+                return subject;
+            }
+        }
+    }
+
+    /** Parse the \c name or \c "name" of a \c .name step. **/
+    query_node::ptr parse_key(query_node::ptr subject)
+    {
+        std::string name = _program[_pos] == '"' ? parse_string() : parse_identifier();
+        return make_named(query_op::key, std::move(name), { std::move(subject) });
+    }
+
+    /** Parse a \c [], \c [n] or \c ["name"] step. **/
+    query_node::ptr parse_bracket(query_node::ptr subject)
+    {
+        expect("[");
+        if (accept("]"))
+            return make_node(query_op::each, { std::move(subject) });
+
+        query_node::ptr out;
+        if (peek() == '"')
+        {
+            out = make_named(query_op::key, parse_string(), { std::move(subject) });
+        }
+        else
+        {
+            bool negative = accept("-");
+            skip_whitespace();
+            value number = parse_number();
+            if (number.kind() != kind::integer)
+                throw error("Expected an integer index");
+            auto node   = std::make_shared<query_node>(query_op::index, std::vector<query_node::ptr>{ subject });
+            node->index = negative ? -number.as_integer() : number.as_integer();
+            out         = node;
+        }
+        expect("]");
+        return out;
+    }
+
+    query_node::ptr parse_primary()
+    {
+        char c = peek();
+        if (c == '.')
+        {
+            ++_pos;
+            if (_pos < _program.size() && _program[_pos] == '.')
+                throw error("Recursive descent is not supported");
+            if (_pos < _program.size() && (is_identifier_start(_program[_pos]) || _program[_pos] == '"'))
+                return parse_key(make_node(query_op::identity));
+            if (_pos < _program.size() && _program[_pos] == '[')
+                return parse_bracket(make_node(query_op::identity));
+            return make_node(query_op::identity);
+        }
+        else if (c == '"')
+        {
+            return make_literal(parse_string());
+        }
+        else if (is_digit(c))
+        {
+            return make_literal(parse_number());
+        }
+        else if (c == '(')
+        {
+            ++_pos;
+            query_node::ptr out = parse_pipe();
+            expect(")");
+            return out;
+        }
+        else if (c == '[')
+        {
+            ++_pos;
+            if (accept("]"))
+                return make_literal(array());
+            query_node::ptr out = make_node(query_op::collect, { parse_pipe() });
+            expect("]");
+            return out;
+        }
+        else if (c == '{')
+        {
+            ++_pos;
+            return parse_object();
+        }
+        else if (is_identifier_start(c))
+        {
+            return parse_call();
+        }
+        else
+        {
+            throw error(c == '\0' ? "Unexpected end of query" : "Unexpected character");
+        }
+    }
+
+    query_node::ptr parse_object()
+    {
+        std::vector<query_node::ptr> entries;
+        if (accept("}"))
+            return make_literal(object());
+
+        do
+        {
+            query_node::ptr key;
+            query_node::ptr val;
+            std::string     name;
+            char            c = peek();
+            if (c == '(')
+            {
+                ++_pos;
+                key = parse_pipe();
+                expect(")");
+            }
+            else
+            {
+                name = c == '"' ? parse_string() : parse_identifier();
+                key  = make_literal(name);
+            }
+
+            if (accept(":"))
+                val = parse_or();
+            else if (name.empty() && key->kind != query_op::literal)
+                throw error("Expected \":\" after a computed key");
+            else
+                val = make_named(query_op::key, name, { make_node(query_op::identity) });
+
+            entries.push_back(std::move(key));
+            entries.push_back(std::move(val));
+        } while (accept(","));
+        expect("}");
+        return make_node(query_op::construct, std::move(entries));
+    }
+
+    query_node::ptr parse_call()
+    {
+        std::string name = parse_identifier();
+        if (name == "true")
+            return make_literal(true);
+        else if (name == "false")
+            return make_literal(false);
+        else if (name == "null")
+            return make_literal(null);
+        else if (name == "length" || name == "keys" || name == "not" || name == "empty")
+            return make_named(query_op::call, std::move(name), {});
+        else if (name == "select" || name == "map")
+        {
+            expect("(");
+            query_node::ptr arg = parse_pipe();
+            expect(")");
+            return make_named(query_op::call, std::move(name), { std::move(arg) });
+        }
+        else
+        {
+            _pos -= name.size();
+            throw error("Unsupported function \"" + name + "\"");
+        }
+    }
+
+    std::string parse_identifier()
+    {
+        skip_whitespace();
+        std::size_t start = _pos;
+        if (_pos >= _program.size() || !is_identifier_start(_program[_pos]))
+            throw error("Expected a name");
+        while (_pos < _program.size() && is_identifier_char(_program[_pos]))
+            ++_pos;
+        return std::string(_program.substr(start, _pos - start));
+    }
+
+    /** Parse a string literal, which has the same escapes as a JSON string. **/
+    std::string parse_string()
+    {
+        skip_whitespace();
+        std::size_t start = ++_pos;
+        while (_pos < _program.size() && _program[_pos] != '"')
+            _pos += _program[_pos] == '\\' ? 2 : 1;
+        if (_pos >= _program.size())
+        {
+            _pos = start - 1;
+            throw error("Unterminated string");
+        }
+
+        string_view source = _program.substr(start, _pos - start);
+        ++_pos;
+        try
+        {
+            static const detail::string_decode_fn decode = detail::get_string_decoder(parse_options::encoding::utf8);
+            return decode(source);
+        }
+        catch (const detail::decode_error& err)
+        {
+            _pos = start - 1;
+            throw error(std::string("Invalid string (") + err.what() + ")");
+        }
+    }
+
+    value parse_number()
+    {
+        std::size_t start   = _pos;
+        bool        decimal = false;
+        while (_pos < _program.size())
+        {
+            char c = _program[_pos];
+            if (c == '.' || c == 'e' || c == 'E')
+                decimal = true;
+            else if ((c == '+' || c == '-') && (_program[_pos - 1] == 'e' || _program[_pos - 1] == 'E'))
+                decimal = true;
+            else if (!is_digit(c))
+                break;
+            ++_pos;
+        }
+
+        std::string text(_program.substr(start, _pos - start));
+        char*       end = nullptr;
+        value       out;
+        if (!decimal)
+        {
+            errno = 0;
+            out   = std::int64_t(std::strtoll(text.c_str(), &end, 10));
+            // an integer literal too large for 64 bits is a decimal, just like one in a document
+            decimal = errno == ERANGE;
+        }
+        if (decimal)
+            out = std::strtod(text.c_str(), &end);
+        if (text.empty() || end != text.c_str() + text.size())
+        {
+            _pos = start;
+            throw error("Invalid number");
+        }
+        return out;
+    }
+
+private:
+    string_view _program;
+    std::size_t _pos;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Evaluation                                                                                                         //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** A reference to something callable with each result of a filter. This is not an \c std::function, since one is
+ *  made at every level of the filter for every value.
+**/
+class emitter
+{
+public:
+    template <typename FEmit>
+    emitter(const FEmit& emit) :
+            _target(&emit),
+            _call([] (const void* target, const value& result) { (*static_cast<const FEmit*>(target))(result); })
+    { }
+
+    void operator()(const value& result) const
+    {
+        _call(_target, result);
+    }
+
+private:
+    const void* _target;
+    void      (*_call)(const void*, const value&);
+};
+
+const value& null_value()
+{
+    static const value instance;
+    return instance;
+}
+
+bool truthy(const value& x)
+{
+    return !(x.kind() == kind::null || (x.kind() == kind::boolean && !x.as_boolean()));
+}
+
+[[noreturn]]
+void throw_kind_error(const std::string& what, const value& subject)
+{
+    throw kind_error(what + " a value of kind " + to_string(subject.kind()));
+}
+
+/** Apply the path \a step (a \c key, \c index or \c each) to \a subject instead of to the results of its child. **/
+void apply_step(const query_node& step, const value& subject, const emitter& emit)
+{
+    switch (step.kind)
+    {
+    case query_op::key:
+        if (subject.kind() == kind::null)
+        {
+            emit(null_value());
+        }
+        else if (subject.kind() == kind::object)
+        {
+            auto iter = subject.find(step.name);
+            emit(iter == subject.end_object() ? null_value() : iter->second);
+        }
+        else
+        {
+            throw_kind_error("Can not look up \"" + step.name + "\" in", subject);
+        }
+        break;
+    case query_op::index:
+        if (subject.kind() == kind::null)
+        {
+            emit(null_value());
+        }
+        else if (subject.kind() == kind::array)
+        {
+            std::int64_t idx = step.index < 0 ? std::int64_t(subject.size()) + step.index : step.index;
+            emit(idx < 0 || std::size_t(idx) >= subject.size() ? null_value() : subject.at(std::size_t(idx)));
+        }
+        else
+        {
+            throw_kind_error("Can not look up index " + std::to_string(step.index) + " in", subject);
+        }
+        break;
+    case query_op::each:
+        if (subject.kind() == kind::array)
+        {
+            for (value::size_type idx = 0U; idx < subject.size(); ++idx)
+                emit(subject.at(idx));
+        }
+        else if (subject.kind() == kind::object)
+        {
+            for (auto iter = subject.begin_object(); iter != subject.end_object(); ++iter)
+                emit(iter->second);
+        }
+        else
+        {
+            throw_kind_error("Can not iterate over", subject);
+        }
+        break;
+    default:
+        throw std::logic_error("Not a path step");
+    }
+}
+
+// Integer results which do not fit in 64 bits come back as decimals (as jq does) instead of wrapping around.
+
+static value add_integers(std::int64_t a, std::int64_t b)
+{
+    if (  (b > 0 && a > std::numeric_limits<std::int64_t>::max() - b)
+       || (b < 0 && a < std::numeric_limits<std::int64_t>::min() - b)
+       )
+        return double(a) + double(b);
+    return a + b;
+}
+
+static value subtract_integers(std::int64_t a, std::int64_t b)
+{
+    if (  (b < 0 && a > std::numeric_limits<std::int64_t>::max() + b)
+       || (b > 0 && a < std::numeric_limits<std::int64_t>::min() + b)
+       )
+        return double(a) - double(b);
+    return a - b;
+}
+
+static value multiply_integers(std::int64_t a, std::int64_t b)
+{
+    constexpr std::int64_t max = std::numeric_limits<std::int64_t>::max();
+    constexpr std::int64_t min = std::numeric_limits<std::int64_t>::min();
+
+    bool overflow;
+    if (a > 0)
+        overflow = b > 0 ? a > max / b : b < min / a;
+    else
+        overflow = b > 0 ? a < min / b : a != 0 && b < max / a;
+    if (overflow)
+        return double(a) * double(b);
+    return a * b;
+}
+
+/** The integer part of the number \a x, clamped to the 64-bit range (\c NaN is 0). **/
+static std::int64_t truncate_integer(const value& x)
+{
+    if (x.kind() == kind::integer)
+        return x.as_integer();
+
+    double d = x.as_decimal();
+    if (std::isnan(d))
+        return 0;
+    else if (d <= -9223372036854775808.0)
+        return std::numeric_limits<std::int64_t>::min();
+    else if (d >= 9223372036854775808.0)
+        return std::numeric_limits<std::int64_t>::max();
+    else
+        return std::int64_t(d);
+}
+
+value arithmetic(const std::string& op, const value& a, const value& b)
+{
+    bool numbers  = (a.kind() == kind::integer || a.kind() == kind::decimal)
+                 && (b.kind() == kind::integer || b.kind() == kind::decimal);
+    bool integers = a.kind() == kind::integer && b.kind() == kind::integer;
+
+    if (op == "+")
+    {
+        if (a.kind() == kind::null)
+            return b;
+        else if (b.kind() == kind::null)
+            return a;
+        else if (integers)
+            return add_integers(a.as_integer(), b.as_integer());
+        else if (numbers)
+            return a.as_decimal() + b.as_decimal();
+        else if (a.kind() == kind::string && b.kind() == kind::string)
+            return a.as_string() + b.as_string();
+        else if (a.kind() == kind::array && b.kind() == kind::array)
+        {
+            value out = a;
+            for (value::size_type idx = 0U; idx < b.size(); ++idx)
+                out.push_back(b.at(idx));
+            return out;
+        }
+        else if (a.kind() == kind::object && b.kind() == kind::object)
+        {
+            value out = a;
+            for (auto iter = b.begin_object(); iter != b.end_object(); ++iter)
+                out[iter->first] = iter->second;
+            return out;
+        }
+    }
+    else if (op == "-")
+    {
+        if (integers)
+            return subtract_integers(a.as_integer(), b.as_integer());
+        else if (numbers)
+            return a.as_decimal() - b.as_decimal();
+        else if (a.kind() == kind::array && b.kind() == kind::array)
+        {
+            value out = array();
+            for (value::size_type idx = 0U; idx < a.size(); ++idx)
+            {
+                bool removed = false;
+                for (value::size_type jdx = 0U; !removed && jdx < b.size(); ++jdx)
+                    removed = a.at(idx) == b.at(jdx);
+                if (!removed)
+                    out.push_back(a.at(idx));
+            }
+            return out;
+        }
+    }
+    else if (op == "*")
+    {
+        if (integers)
+            return multiply_integers(a.as_integer(), b.as_integer());
+        else if (numbers)
+            return a.as_decimal() * b.as_decimal();
+    }
+    else if (op == "/" && numbers)
+    {
+        if (b.as_decimal() == 0.0)
+            throw std::domain_error("Division by zero in query");
+        // -1 is checked first: the smallest integer divided by it does not fit (and traps in the hardware divide)
+        if (integers && b.as_integer() == -1)
+            return subtract_integers(0, a.as_integer());
+        if (integers && a.as_integer() % b.as_integer() == 0)
+            return a.as_integer() / b.as_integer();
+        return a.as_decimal() / b.as_decimal();
+    }
+    else if (op == "%" && numbers)
+    {
+        std::int64_t divisor = truncate_integer(b);
+        if (divisor == 0)
+            throw std::domain_error("Division by zero in query");
+        if (divisor == -1)
+            return 0;
+        return truncate_integer(a) % divisor;
+    }
+    else
+    {
+        int cmp = a.compare(b);
+        if (op == "==") return cmp == 0;
+        if (op == "!=") return cmp != 0;
+        if (op == "<")  return cmp <  0;
+        if (op == "<=") return cmp <= 0;
+        if (op == ">")  return cmp >  0;
+        if (op == ">=") return cmp >= 0;
+    }
+
+    throw kind_error("Can not apply \"" + op + "\" to values of kind " + to_string(a.kind()) + " and "
+                     + to_string(b.kind())
+                    );
+}
+
+value length_of(const value& subject)
+{
+    switch (subject.kind())
+    {
+    case kind::null:
+        return 0;
+    case kind::integer:
+        return subject.as_integer() < 0 ? subtract_integers(0, subject.as_integer()) : value(subject.as_integer());
+    case kind::decimal:
+        return std::abs(subject.as_decimal());
+    case kind::string:
+    {
+        // the number of code points, not bytes
+        std::int64_t count = 0;
+        for (char c : subject.as_string_view())
+            if ((static_cast<unsigned char>(c) & 0xc0) != 0x80)
+                ++count;
+        return count;
+    }
+    case kind::array:
+    case kind::object:
+        return std::int64_t(subject.size());
+    default:
+        throw_kind_error("Can not take the length of", subject);
+    }
+}
+
+value keys_of(const value& subject)
+{
+    value out = array();
+    if (subject.kind() == kind::object)
+    {
+        std::vector<std::string> names;
+        for (auto iter = subject.begin_object(); iter != subject.end_object(); ++iter)
+            names.push_back(iter->first);
+        std::sort(names.begin(), names.end());
+        for (std::string& name : names)
+            out.push_back(std::move(name));
+    }
+    else if (subject.kind() == kind::array)
+    {
+        for (value::size_type idx = 0U; idx < subject.size(); ++idx)
+            out.push_back(std::int64_t(idx));
+    }
+    else
+    {
+        throw_kind_error("Can not take the keys of", subject);
+    }
+    return out;
+}
+
+void evaluate(const query_node& node, const value& input, const emitter& emit);
+
+/** Evaluate \c children[idx] and the stages after it of a \c pipe. **/
+void evaluate_pipe(const query_node& node, std::size_t idx, const value& input, const emitter& emit)
+{
+    if (idx + 1 == node.children.size())
+        return evaluate(*node.children[idx], input, emit);
+
+    auto next = [&] (const value& x) { evaluate_pipe(node, idx + 1, x, emit); };
+    evaluate(*node.children[idx], input, next);
+}
+
+/** Build the objects for the entries of a \c construct starting at \a idx, with the earlier ones in \a partial. **/
+void evaluate_construct(const query_node& node, std::size_t idx, const value& input, value& partial,
+                        const emitter& emit
+                       )
+{
+    if (idx == node.children.size())
+        return emit(partial);
+
+    auto on_key = [&] (const value& key)
+    {
+        if (key.kind() != kind::string)
+            throw_kind_error("Object keys must be strings, not", key);
+        auto on_value = [&] (const value& val)
+        {
+            value next = partial;
+            next[key.as_string()] = val;
+            evaluate_construct(node, idx + 2, input, next, emit);
+        };
+        evaluate(*node.children[idx + 1], input, on_value);
+    };
+    evaluate(*node.children[idx], input, on_key);
+}
+
+void evaluate(const query_node& node, const value& input, const emitter& emit)
+{
+    switch (node.kind)
+    {
+    case query_op::identity:
+        emit(input);
+        break;
+    case query_op::literal:
+        emit(node.literal);
+        break;
+    case query_op::key:
+    case query_op::index:
+    case query_op::each:
+    {
+        auto on_subject = [&] (const value& subject) { apply_step(node, subject, emit); };
+        evaluate(*node.children[0], input, on_subject);
+        break;
+    }
+    case query_op::pipe:
+        evaluate_pipe(node, 0U, input, emit);
+        break;
+    case query_op::comma:
+        for (const auto& child : node.children)
+            evaluate(*child, input, emit);
+        break;
+    case query_op::collect:
+    {
+        value out = array();
+        auto  add = [&] (const value& x) { out.push_back(x); };
+        evaluate(*node.children[0], input, add);
+        emit(out);
+        break;
+    }
+    case query_op::construct:
+    {
+        value partial = object();
+        evaluate_construct(node, 0U, input, partial, emit);
+        break;
+    }
+    case query_op::binary:
+    {
+        // like jq, the right side is the outer loop
+        auto on_rhs = [&] (const value& rhs)
+        {
+            auto on_lhs = [&] (const value& lhs) { emit(arithmetic(node.name, lhs, rhs)); };
+            evaluate(*node.children[0], input, on_lhs);
+        };
+        evaluate(*node.children[1], input, on_rhs);
+        break;
+    }
+    case query_op::logical:
+    {
+        bool is_and = node.name == "and";
+        auto on_lhs = [&] (const value& lhs)
+        {
+            if (truthy(lhs) != is_and)
+            {
+                emit(value(!is_and));
+            }
+            else
+            {
+                auto on_rhs = [&] (const value& rhs) { emit(value(truthy(rhs))); };
+                evaluate(*node.children[1], input, on_rhs);
+            }
+        };
+        evaluate(*node.children[0], input, on_lhs);
+        break;
+    }
+    case query_op::call:
+        if (node.name == "length")
+        {
+            emit(length_of(input));
+        }
+        else if (node.name == "keys")
+        {
+            emit(keys_of(input));
+        }
+        else if (node.name == "not")
+        {
+            emit(value(!truthy(input)));
+        }
+        else if (node.name == "select")
+        {
+            auto on_condition = [&] (const value& condition)
+            {
+                if (truthy(condition))
+                    emit(input);
+            };
+            evaluate(*node.children[0], input, on_condition);
+        }
+        else if (node.name == "map")
+        {
+            value out = array();
+            auto  add = [&] (const value& x) { out.push_back(x); };
+            auto  on_element = [&] (const value& element) { evaluate(*node.children[0], element, add); };
+            apply_step(query_node(query_op::each), input, on_element);
+            emit(out);
+        }
+        // empty has no results
+        break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Streaming                                                                                                          //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Follows the leading path steps of a query on the tokens of a document. All of the functions are called with the
+ *  first token of a value current and return with its last token current (like those in \c detail::token_stream).
+**/
+class query_streamer
+{
+public:
+    query_streamer(const std::vector<const query_node*>& steps, const query_node& rest, const emitter& emit) :
+            _steps(steps),
+            _rest(rest),
+            _emit(emit)
+    { }
+
+    /** Follow the steps from \a idx on the current value of \a from. **/
+    void walk(tokenizer& from, std::size_t idx) const
+    {
+        if (idx == _steps.size())
+            return finish(detail::parse_current(from), idx);
+
+        const query_node& step = *_steps[idx];
+        token_kind        kind = from.current().kind;
+        if (kind == token_kind::object_begin && step.kind == query_op::key)
+        {
+            bool        found = false;
+            std::string key;
+            for (bool first = true; detail::next_object_entry(from, first, key); first = false)
+            {
+                if (!found && key == step.name)
+                {
+                    found = true;
+                    walk(from, idx + 1);
+                }
+                else
+                {
+                    detail::skip_current(from);
+                }
+            }
+            if (!found)
+                finish(null_value(), idx + 1);
+        }
+        else if (kind == token_kind::object_begin && step.kind == query_op::each)
+        {
+            std::string key;
+            for (bool first = true; detail::next_object_entry(from, first, key); first = false)
+                walk(from, idx + 1);
+        }
+        else if (kind == token_kind::array_begin && step.kind == query_op::index && step.index >= 0)
+        {
+            std::int64_t position = 0;
+            for (; detail::next_array_element(from, position == 0); ++position)
+            {
+                if (position == step.index)
+                    walk(from, idx + 1);
+                else
+                    detail::skip_current(from);
+            }
+            if (position <= step.index)
+                finish(null_value(), idx + 1);
+        }
+        else if (kind == token_kind::array_begin && step.kind == query_op::each)
+        {
+            for (bool first = true; detail::next_array_element(from, first); first = false)
+                walk(from, idx + 1);
+        }
+        else
+        {
+            // scalars, negative indexes and mismatched kinds (which will throw)
+            finish(detail::parse_current(from), idx);
+        }
+    }
+
+private:
+    /** Apply the steps from \a idx and then the rest of the query to \a subject. **/
+    void finish(const value& subject, std::size_t idx) const
+    {
+        if (idx == _steps.size())
+            return evaluate(_rest, subject, _emit);
+
+        auto next = [&] (const value& x) { finish(x, idx + 1); };
+        apply_step(*_steps[idx], subject, next);
+    }
+
+private:
+    const std::vector<const query_node*>& _steps;
+    const query_node&                     _rest;
+    emitter                               _emit;
+};
+
+/** Move to the first token of the next document in \a from.
+ *
+ *  \returns \c false at the end of the input.
+**/
+bool next_document(tokenizer& from)
+{
+    while (from.next())
+    {
+        token_kind kind = from.current().kind;
+        if (kind != token_kind::whitespace && kind != token_kind::comment)
+            return true;
+    }
+    return false;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// query                                                                                                              //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+query query::compile(string_view program)
+{
+    query out;
+    out._program = std::string(program);
+    out._root    = query_compiler(out._program).compile();
+
+    // The leading path of the first stage of the pipe (if it starts from the input) is followed on the tokens
+    const query_node*              node = out._root->kind == query_op::pipe ? out._root->children[0].get()
+                                                                            : out._root.get();
+    std::vector<const query_node*> steps;
+    while (node->kind == query_op::key || node->kind == query_op::index || node->kind == query_op::each)
+    {
+        steps.push_back(node);
+        node = node->children[0].get();
+    }
+
+    if (steps.empty() || node->kind != query_op::identity)
+    {
+        out._rest = out._root;
+    }
+    else
+    {
+        out._stream_steps.assign(steps.rbegin(), steps.rend());
+        if (out._root->kind != query_op::pipe)
+            out._rest = make_node(query_op::identity);
+        else if (out._root->children.size() == 2U)
+            out._rest = out._root->children[1];
+        else
+        {
+            std::vector<query_node::ptr> rest(out._root->children.begin() + 1, out._root->children.end());
+            out._rest = make_node(query_op::pipe, std::move(rest));
+        }
+    }
+    return out;
+}
+
+const std::string& query::program() const
+{
+    return _program;
+}
+
+query::size_type query::streamed_steps() const
+{
+    return _stream_steps.size();
+}
+
+std::vector<value> query::run(const value& input) const
+{
+    std::vector<value> out;
+    auto add = [&] (const value& x) { out.push_back(x); };
+    evaluate(*_root, input, add);
+    return out;
+}
+
+void query::run(const value& input, const result_handler& on_result) const
+{
+    evaluate(*_root, input, on_result);
+}
+
+query::size_type query::run(tokenizer& input, const result_handler& on_result) const
+{
+    size_type      count = 0;
+    auto           emit  = [&] (const value& x) { ++count; on_result(x); };
+    query_streamer streamer(_stream_steps, *_rest, emit);
+    while (next_document(input))
+        streamer.walk(input, 0U);
+    return count;
+}
+
+query::size_type query::run(tokenizer& input, encoder& out) const
+{
+    writer    output(out);
+    output.begin_array();
+    size_type count = run(input, [&] (const value& x) { output.value(x); });
+    output.end_array();
+    return count;
+}
+
+}
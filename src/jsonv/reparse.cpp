@@ -0,0 +1,187 @@
+/** \file
+ *  Parsing only the part of a document which an edit changed.
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/parse.hpp>
+#include <jsonv/tokenizer.hpp>
+#include <jsonv/value.hpp>
+
+#include "char_convert.hpp"
+#include "detail/syntax_validator.hpp"
+
+#include <limits>
+#include <vector>
+
+namespace jsonv
+{
+
+namespace
+{
+
+/** An array or object which has been opened, but not closed yet. **/
+struct open_container
+{
+    std::size_t offset;             //!< The position of the \c [ or \c {.
+    bool        is_array;
+    bool        expect_key;         //!< For objects: the next string is a key.
+    std::size_t children;           //!< The elements or entries so far.
+    string_view key;                //!< For objects: the token of the key of the last entry.
+};
+
+static constexpr std::size_t not_found = std::numeric_limits<std::size_t>::max();
+
+}
+
+/** Find the value in \a tree which \a chain (the containers around the edited one, from the root in) leads to, checking
+ *  that every container on the way has the same number of children in \a tree as it has in the new text (\a totals).
+ *  If the edit moved where one of them ends, it would have a different number.
+ *
+ *  \returns The value to replace or \c nullptr if \a tree does not match.
+**/
+static value* find_edited(value&                             tree,
+                          const std::vector<open_container>& chain,
+                          const std::vector<std::size_t>&    totals,
+                          const parse_options&               options
+                         )
+{
+    auto decode_key = detail::get_string_decoder(options.string_encoding());
+
+    value* node = &tree;
+    for (std::size_t depth = 0; depth < chain.size(); ++depth)
+    {
+        const open_container& container = chain[depth];
+        if (container.is_array)
+        {
+            if (node->kind() != kind::array || node->size() != totals[depth])
+                return nullptr;
+            node = &(*node)[container.children - 1];
+        }
+        else
+        {
+            if (node->kind() != kind::object || node->size() != totals[depth])
+                return nullptr;
+            auto iter = node->find(decode_key(container.key.substr(1, container.key.size() - 2)));
+            if (iter == node->end_object())
+                return nullptr;
+            node = &iter->second;
+        }
+    }
+    return node;
+}
+
+void reparse(value& tree, string_view new_text, const edit_range& edit, const parse_options& options)
+{
+    std::size_t edit_begin = edit.offset;
+    std::size_t edit_end   = edit.offset + edit.inserted;
+    if (edit_end > new_text.size() || !options.complete_parse())
+    {
+        tree = parse(new_text, options);
+        return;
+    }
+
+    // Go through the structure of the new text, looking for the innermost container which starts before the edit and
+    // ends after it. The text before the edit is the same as it was, so the path to that container is too.
+    detail::syntax_validator    validator(new_text, options);
+    tokenizer                   tokens(new_text);
+    tokenizer::token            batch[64];
+    std::vector<open_container> open;
+    std::vector<open_container> chain;          //!< The containers around the edited one, from the root in.
+    std::vector<std::size_t>    totals;         //!< The number of children of each of the \c chain.
+    std::size_t                 found_begin = not_found;
+    std::size_t                 found_end   = not_found;
+    bool                        valid       = true;
+
+    auto start_value = [&] ()
+                       {
+                           if (!open.empty() && open.back().is_array)
+                               ++open.back().children;
+                       };
+
+    while (valid)
+    {
+        std::size_t count = tokens.next_batch(batch, validator.skipped_tokens());
+        if (count == 0)
+            break;
+
+        for (std::size_t idx = 0; valid && idx < count; ++idx)
+        {
+            const tokenizer::token& tok = batch[idx];
+            if (!validator.accept(tok))
+            {
+                valid = false;
+                break;
+            }
+
+            std::size_t offset = std::size_t(tok.text.data() - new_text.data());
+            switch (tok.kind)
+            {
+            case token_kind::array_begin:
+            case token_kind::object_begin:
+                start_value();
+                open.push_back({ offset, tok.kind == token_kind::array_begin, true, 0, string_view() });
+                break;
+            case token_kind::array_end:
+            case token_kind::object_end:
+                if (found_begin == not_found && open.back().offset < edit_begin && offset >= edit_end)
+                {
+                    found_begin = open.back().offset;
+                    found_end   = offset + 1;
+                    chain.assign(open.begin(), open.end() - 1);
+                    totals.resize(chain.size());
+                }
+                else if (  found_begin != not_found
+                        && open.size() <= chain.size()
+                        && open.back().offset == chain[open.size() - 1].offset
+                        )
+                {
+                    // the containers around the found one are not done counting until they close (later siblings at
+                    // the same depth close here too, but they are not on the chain)
+                    totals[open.size() - 1] = open.back().children;
+                }
+                open.pop_back();
+                break;
+            case token_kind::string:
+                if (!open.empty() && !open.back().is_array && open.back().expect_key)
+                {
+                    ++open.back().children;
+                    open.back().key        = tok.text;
+                    open.back().expect_key = false;
+                }
+                else
+                {
+                    start_value();
+                }
+                break;
+            case token_kind::separator:
+                if (!open.empty() && !open.back().is_array)
+                    open.back().expect_key = true;
+                break;
+            case token_kind::boolean:
+            case token_kind::null:
+            case token_kind::number:
+                start_value();
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    value* target = nullptr;
+    if (valid && validator.finish() && found_begin != not_found)
+        target = find_edited(tree, chain, totals, options);
+
+    if (target)
+        *target = parse(new_text.substr(found_begin, found_end - found_begin), options);
+    else
+        tree = parse(new_text, options);
+}
+
+}
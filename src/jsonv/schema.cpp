@@ -0,0 +1,210 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/schema.hpp>
+
+#include <limits>
+
+#include "detail/fallthrough.hpp"
+
+namespace jsonv
+{
+
+static constexpr std::uint8_t kind_bit(kind x)
+{
+    return std::uint8_t(1U << static_cast<unsigned>(x));
+}
+
+static constexpr std::uint8_t all_kinds = 0x7f;
+
+schema::schema() :
+        _kinds(all_kinds),
+        _minimum(-std::numeric_limits<double>::infinity()),
+        _maximum(std::numeric_limits<double>::infinity()),
+        _min_size(0),
+        _max_size(std::numeric_limits<size_type>::max()),
+        _additional_keys(true)
+{ }
+
+schema::~schema() noexcept = default;
+
+schema& schema::kinds(std::initializer_list<kind> allowed)
+{
+    _kinds = 0;
+    for (kind x : allowed)
+    {
+        _kinds |= kind_bit(x);
+        if (x == kind::decimal)
+            _kinds |= kind_bit(kind::integer);
+    }
+    return *this;
+}
+
+bool schema::allows(kind x) const
+{
+    return (_kinds & kind_bit(x)) != 0;
+}
+
+schema& schema::minimum(double x)
+{
+    _minimum = x;
+    return *this;
+}
+
+schema& schema::maximum(double x)
+{
+    _maximum = x;
+    return *this;
+}
+
+schema& schema::min_size(size_type x)
+{
+    _min_size = x;
+    return *this;
+}
+
+schema& schema::max_size(size_type x)
+{
+    _max_size = x;
+    return *this;
+}
+
+schema& schema::required(std::string key, schema rules)
+{
+    _members[std::move(key)] = member_rules{ std::make_shared<const schema>(std::move(rules)), true };
+    return *this;
+}
+
+schema& schema::member(std::string key, schema rules)
+{
+    _members[std::move(key)] = member_rules{ std::make_shared<const schema>(std::move(rules)), false };
+    return *this;
+}
+
+schema& schema::additional_keys(bool allow)
+{
+    _additional_keys = allow;
+    return *this;
+}
+
+schema& schema::elements(schema rules)
+{
+    _elements = std::make_shared<const schema>(std::move(rules));
+    return *this;
+}
+
+const schema* schema::find_member(const std::string& key) const
+{
+    auto iter = _members.find(key);
+    return iter == _members.end() ? nullptr : iter->second.rules.get();
+}
+
+const schema* schema::element_rules() const
+{
+    return _elements.get();
+}
+
+bool schema::check(const value& x, validation_error::code& failure) const
+{
+    if (!allows(x.kind()))
+    {
+        failure = validation_error::code::wrong_kind;
+        return false;
+    }
+
+    switch (x.kind())
+    {
+    case kind::integer:
+    case kind::decimal:
+    {
+        double number = x.as_decimal();
+        if (number < _minimum || number > _maximum)
+        {
+            failure = validation_error::code::out_of_range;
+            return false;
+        }
+        return true;
+    }
+    case kind::object:
+        for (const auto& rule : _members)
+        {
+            if (rule.second.required && x.count(rule.first) == 0)
+            {
+                failure = validation_error::code::missing_key;
+                return false;
+            }
+        }
+        if (!_additional_keys)
+        {
+            for (const auto& field : x.as_object())
+            {
+                if (_members.count(field.first) == 0)
+                {
+                    failure = validation_error::code::unexpected_key;
+                    return false;
+                }
+            }
+        }
+        // sizes are checked like arrays and strings
+        JSONV_FALLTHROUGH();
+    case kind::array:
+    case kind::string:
+    {
+        size_type size = x.kind() == kind::string ? x.as_string_view().size() : x.size();
+        if (size < _min_size || size > _max_size)
+        {
+            failure = validation_error::code::wrong_size;
+            return false;
+        }
+        return true;
+    }
+    case kind::boolean:
+    case kind::null:
+    default:
+        return true;
+    }
+}
+
+static void validate_impl(const schema& rules, const value& x, path& current_path)
+{
+    validation_error::code failure;
+    if (!rules.check(x, failure))
+        throw validation_error(failure, current_path, x);
+
+    if (x.kind() == kind::object)
+    {
+        for (const auto& field : x.as_object())
+        {
+            if (const schema* sub = rules.find_member(field.first))
+            {
+                current_path.push_back(path_element(field.first));
+                validate_impl(*sub, field.second, current_path);
+                current_path.pop_back();
+            }
+        }
+    }
+    else if (x.kind() == kind::array && rules.element_rules())
+    {
+        for (value::size_type idx = 0; idx < x.size(); ++idx)
+        {
+            current_path.push_back(path_element(idx));
+            validate_impl(*rules.element_rules(), x[idx], current_path);
+            current_path.pop_back();
+        }
+    }
+}
+
+void schema::validate(const value& x) const
+{
+    path current_path;
+    validate_impl(*this, x, current_path);
+}
+
+}
@@ -12,12 +12,23 @@
 #include <jsonv/serialization.hpp>
 #include <jsonv/coerce.hpp>
 #include <jsonv/demangle.hpp>
+#include <jsonv/encode.hpp>
 #include <jsonv/serialization_util.hpp>
+#include <jsonv/tokenizer.hpp>
 #include <jsonv/value.hpp>
+#include <jsonv/writer.hpp>
+#include <jsonv/detail/scope_exit.hpp>
 
+#include "detail/trace_scope.hpp"
+
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <exception>
+#include <mutex>
 #include <set>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -30,12 +41,27 @@ namespace jsonv
 
 extractor::~extractor() noexcept = default;
 
+void extractor::extract(const extraction_context& context, value&& from, void* into) const
+{
+    extract(context, static_cast<const value&>(from), into);
+}
+
+void extractor::extract(const extraction_context& context, tokenizer& from, void* into) const
+{
+    extract(context, detail::parse_current(from), into);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // serializer                                                                                                         //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 serializer::~serializer() noexcept = default;
 
+void serializer::encode(const serialization_context& context, const void* from, encoder& out) const
+{
+    out.encode(to_json(context, from));
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // adapter                                                                                                            //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -69,13 +95,13 @@ std::type_index duplicate_type_error::type_index() const
 // extraction_error                                                                                                   //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-static std::string make_extraction_error_errmsg(const extraction_context& context, const std::string& message)
+static std::string make_extraction_error_errmsg(const path& where, const std::string& message)
 {
     std::ostringstream os;
     os << "Extraction error";
 
-    if (!context.path().empty())
-        os << " at " << context.path();
+    if (!where.empty())
+        os << " at " << where;
 
     if (!message.empty())
         os << ": " << message;
@@ -83,10 +109,16 @@ static std::string make_extraction_error_errmsg(const extraction_context& contex
     return os.str();
 }
 
+extraction_error::extraction_error(jsonv::path where, const std::string& message) :
+        std::runtime_error(make_extraction_error_errmsg(where, message)),
+        nested_exception(),
+        _path(std::move(where))
+{ }
+
 extraction_error::extraction_error(const extraction_context& context, const std::string& message) :
-        std::runtime_error(make_extraction_error_errmsg(context, message)),
+        std::runtime_error(context.quiet() ? message : make_extraction_error_errmsg(context.path(), message)),
         nested_exception(),
-        _path(context.path())
+        _path(context.quiet() ? jsonv::path() : context.path())
 { }
 
 extraction_error::~extraction_error() noexcept = default;
@@ -96,6 +128,23 @@ const path& extraction_error::path() const
     return _path;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// extract_errc                                                                                                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::ostream& operator<<(std::ostream& os, const extract_errc& code)
+{
+    switch (code)
+    {
+    case extract_errc::none:          return os << "none";
+    case extract_errc::no_extractor:  return os << "no_extractor";
+    case extract_errc::kind_mismatch: return os << "kind_mismatch";
+    case extract_errc::out_of_range:  return os << "out_of_range";
+    case extract_errc::invalid:       return os << "invalid";
+    default:                          return os << "extract_errc(" << static_cast<int>(code) << ")";
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // no_extractor                                                                                                       //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -169,6 +218,28 @@ public:
     using serializer_map  = std::unordered_map<std::type_index, const serializer*>;
     using owned_items_set = std::unordered_set<std::shared_ptr<const void>>;
 
+    /** Everything which can be found from a \c data (and all of its roots), flattened into a single table so a lookup
+     *  is a single probe no matter how deep the composition goes.
+    **/
+    struct resolved
+    {
+        /// Every \c data the table was built from along with its \c version at the time, which is what needs to be
+        /// checked to see if this table is still accurate.
+        std::vector<std::pair<const data*, std::uint64_t>> sources;
+
+        extractor_map extractors;
+
+        serializer_map serializers;
+
+        bool is_current() const
+        {
+            for (const auto& source : sources)
+                if (source.first->version.load(std::memory_order_acquire) != source.second)
+                    return false;
+            return true;
+        }
+    };
+
 public:
     /// The previous data this comes from...this allows us to make a huge tree of formats with custom extension points.
     roots_list roots;
@@ -179,55 +250,84 @@ public:
 
     serializer_map serializers;
 
+    /// Incremented every time something is registered, which invalidates any \c resolved table built from this.
+    std::atomic<std::uint64_t> version;
+
+    /// The most recently built \c resolved table or \c null if nothing has been looked up yet.
+    mutable std::atomic<const resolved*> resolved_cache;
+
+    /// Owns every \c resolved table built for this instance. Tables are only replaced when something is registered
+    /// after a lookup (which is rare), and an old table might still be in use by another thread, so they are only
+    /// freed along with the \c data.
+    mutable std::vector<std::unique_ptr<const resolved>> resolved_history;
+
+    mutable std::mutex resolved_mutex;
+
     explicit data(roots_list roots) :
-            roots(std::move(roots))
+            roots(std::move(roots)),
+            version(0),
+            resolved_cache(nullptr)
     { }
 
 public:
     const extractor* find_extractor(const std::type_index& typeidx) const
     {
-        return find_impl<extractor>(this,
-                                    typeidx,
-                                    [] (const data* self) -> const extractor_map& { return self->extractors; }
-                                   );
+        const auto& map = get_resolved().extractors;
+        auto iter = map.find(typeidx);
+        return iter == map.end() ? nullptr : iter->second;
     }
 
     const serializer* find_serializer(const std::type_index& typeidx) const
     {
-        return find_impl<serializer>(this,
-                                     typeidx,
-                                     [] (const data* self) -> const serializer_map& { return self->serializers; }
-                                    );
+        const auto& map = get_resolved().serializers;
+        auto iter = map.find(typeidx);
+        return iter == map.end() ? nullptr : iter->second;
     }
 
-    template <typename T, typename FSelectMap>
-    static const T* find_impl(const data* self,
-                              const std::type_index& typeidx,
-                              const FSelectMap&      select_map
-                             )
+    const resolved& get_resolved() const
     {
-        const auto& map = select_map(self);
-        auto iter = map.find(typeidx);
-        if (iter != std::end(map))
-        {
-            return iter->second;
-        }
+        const resolved* current = resolved_cache.load(std::memory_order_acquire);
+        if (current && current->is_current())
+            return *current;
         else
-        {
-            for (const auto& sub : self->roots)
-            {
-                auto ptr = find_impl<T>(sub.get(), typeidx, select_map);
-                if (ptr)
-                    return ptr;
-            }
-            return nullptr;
-        }
+            return build_resolved();
+    }
+
+    const resolved& build_resolved() const
+    {
+        std::lock_guard<std::mutex> lock(resolved_mutex);
+        const resolved* current = resolved_cache.load(std::memory_order_acquire);
+        if (current && current->is_current())
+            return *current;
+
+        // Visiting the graph depth-first with this instance first and only adding types which have not been seen gives
+        // each type the same entry a search of the graph in that order would find first.
+        std::unique_ptr<resolved> table(new resolved);
+        std::unordered_set<const data*> visited;
+        add_to_resolved(*table, visited, this);
+
+        resolved_history.push_back(std::move(table));
+        resolved_cache.store(resolved_history.back().get(), std::memory_order_release);
+        return *resolved_history.back();
+    }
+
+    static void add_to_resolved(resolved& table, std::unordered_set<const data*>& visited, const data* self)
+    {
+        if (!visited.insert(self).second)
+            return;
+
+        table.sources.emplace_back(self, self->version.load(std::memory_order_acquire));
+        table.extractors.insert(self->extractors.begin(), self->extractors.end());
+        table.serializers.insert(self->serializers.begin(), self->serializers.end());
+        for (const auto& sub : self->roots)
+            add_to_resolved(table, visited, sub.get());
     }
 
 public:
     extractor_map::iterator insert_extractor(const extractor* ex, duplicate_type_action action)
     {
         std::type_index typeidx(ex->get_type());
+        version.fetch_add(1, std::memory_order_acq_rel);
         auto iter = extractors.find(typeidx);
         if (iter != end(extractors))
         {
@@ -259,6 +359,7 @@ public:
     serializer_map::iterator insert_serializer(const serializer* ser, duplicate_type_action action)
     {
         std::type_index typeidx(ser->get_type());
+        version.fetch_add(1, std::memory_order_acq_rel);
         auto iter = serializers.find(typeidx);
         if (iter != end(serializers))
         {
@@ -319,6 +420,9 @@ formats::formats() :
         formats(data::roots_list())
 { }
 
+formats::formats(empty_tag) noexcept
+{ }
+
 formats formats::compose(const list& bases)
 {
     data::roots_list roots;
@@ -353,6 +457,27 @@ void formats::extract(const std::type_info&     type,
                       const extraction_context& context
                      ) const
 {
+    detail::trace_scope trace(trace_operation::extract, 0, &type);
+    get_extractor(type).extract(context, from, into);
+}
+
+void formats::extract(const std::type_info&     type,
+                      value&&                   from,
+                      void*                     into,
+                      const extraction_context& context
+                     ) const
+{
+    detail::trace_scope trace(trace_operation::extract, 0, &type);
+    get_extractor(type).extract(context, std::move(from), into);
+}
+
+void formats::extract(const std::type_info&     type,
+                      tokenizer&                from,
+                      void*                     into,
+                      const extraction_context& context
+                     ) const
+{
+    detail::trace_scope trace(trace_operation::extract, 0, &type);
     get_extractor(type).extract(context, from, into);
 }
 
@@ -375,9 +500,20 @@ value formats::to_json(const std::type_info& type,
                        const serialization_context& context
                       ) const
 {
+    detail::trace_scope trace(trace_operation::to_json, 0, &type);
     return get_serializer(type).to_json(context, from);
 }
 
+void formats::encode(const std::type_info&        type,
+                     const void*                  from,
+                     const serialization_context& context,
+                     encoder&                     out
+                    ) const
+{
+    detail::trace_scope trace(trace_operation::encode, 0, &type);
+    get_serializer(type).encode(context, from, out);
+}
+
 void formats::register_extractor(const extractor* ex, duplicate_type_action action)
 {
     _data->insert_extractor(ex, action);
@@ -422,14 +558,89 @@ bool formats::operator!=(const formats& other) const
 // formats::defaults                                                                                                  //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/** A \c function_adapter for a type which a \c writer can write directly, so \c encode does not build a \c value. **/
+template <typename T, typename FExtract, typename FToJson>
+class direct_function_adapter :
+        public function_adapter<T, FExtract, FToJson>
+{
+public:
+    using function_adapter<T, FExtract, FToJson>::function_adapter;
+
+protected:
+    virtual void encode(const serialization_context&, const T& from, writer& out) const override
+    {
+        out.value(from);
+    }
+};
+
+template <typename FExtract, typename FToJson>
+static auto make_direct_adapter(FExtract extract, FToJson to_json_)
+    -> direct_function_adapter<decltype(extract(std::declval<const value&>())), FExtract, FToJson>
+{
+    return direct_function_adapter<decltype(extract(std::declval<const value&>())), FExtract, FToJson>
+            (std::move(extract), std::move(to_json_));
+}
+
+/** The adapter for \c value itself, which takes over the whole of a \c value it is given ownership of. **/
+class value_adapter :
+        public adapter_for<value>
+{
+protected:
+    virtual value create(const extraction_context&, const value& from) const override
+    {
+        return from;
+    }
+
+    virtual value create(const extraction_context&, value&& from) const override
+    {
+        return std::move(from);
+    }
+
+    virtual value to_json(const serialization_context&, const value& from) const override
+    {
+        return from;
+    }
+
+    virtual void encode(const serialization_context&, const value& from, writer& out) const override
+    {
+        out.value(from);
+    }
+};
+
+/** The adapter for \c std::string, which moves the characters out of a \c value it is given ownership of. **/
+class string_adapter :
+        public adapter_for<std::string>
+{
+protected:
+    virtual std::string create(const extraction_context&, const value& from) const override
+    {
+        return from.as_string();
+    }
+
+    virtual std::string create(const extraction_context&, value&& from) const override
+    {
+        return from.take_string();
+    }
+
+    virtual value to_json(const serialization_context&, const std::string& from) const override
+    {
+        return value(from);
+    }
+
+    virtual void encode(const serialization_context&, const std::string& from, writer& out) const override
+    {
+        out.value(from);
+    }
+};
+
 template <typename T>
 static void register_integer_adapter(formats&              fmt,
                                      duplicate_type_action on_duplicate = duplicate_type_action::exception
                                     )
 {
-    static auto instance = make_adapter([] (const value& from) { return T(from.as_integer()); },
-                                        [] (const T& from) { return value(static_cast<std::int64_t>(from)); }
-                                       );
+    static auto instance = make_direct_adapter([] (const value& from) { return T(from.as_integer()); },
+                                               [] (const T& from) { return value(static_cast<std::int64_t>(from)); }
+                                              );
     fmt.register_adapter(&instance, on_duplicate);
 }
 
@@ -437,19 +648,15 @@ static formats create_default_formats()
 {
     formats fmt;
 
-    static auto json_extractor = make_adapter([] (const value& from) { return from; },
-                                              [] (const value& from) { return from; }
-                                             );
+    static value_adapter json_extractor;
     fmt.register_adapter(&json_extractor);
 
-    static auto string_extractor = make_adapter([] (const value& from) { return from.as_string(); },
-                                                [] (const std::string& from) { return value(from); }
-                                               );
+    static string_adapter string_extractor;
     fmt.register_adapter(&string_extractor);
 
-    static auto string_view_adapter = make_adapter([] (const value& from) { return from.as_string_view(); },
-                                                   [] (const string_view& from) { return value(from); }
-                                                  );
+    static auto string_view_adapter = make_direct_adapter([] (const value& from) { return from.as_string_view(); },
+                                                          [] (const string_view& from) { return value(from); }
+                                                         );
     fmt.register_adapter(&string_view_adapter);
 
     static auto cchar_ptr_serializer = make_serializer<const char*>([] (const char* from) { return value(from); });
@@ -457,9 +664,9 @@ static formats create_default_formats()
     static auto char_ptr_serializer = make_serializer<char*>([] (char* from) { return value(from); });
     fmt.register_serializer(&char_ptr_serializer);
 
-    static auto bool_extractor = make_adapter([] (const value& from) { return from.as_boolean(); },
-                                              [] (const bool& from) { return value(from); }
-                                             );
+    static auto bool_extractor = make_direct_adapter([] (const value& from) { return from.as_boolean(); },
+                                                     [] (const bool& from) { return value(from); }
+                                                    );
     fmt.register_adapter(&bool_extractor);
 
     register_integer_adapter<std::int8_t>(fmt);
@@ -478,13 +685,13 @@ static formats create_default_formats()
     register_integer_adapter<long>(fmt, duplicate_type_action::ignore);
     register_integer_adapter<unsigned long>(fmt, duplicate_type_action::ignore);
 
-    static auto double_extractor = make_adapter([] (const value& from) { return from.as_decimal(); },
-                                                [] (const double& from) { return value(from); }
-                                               );
+    static auto double_extractor = make_direct_adapter([] (const value& from) { return from.as_decimal(); },
+                                                       [] (const double& from) { return value(from); }
+                                                      );
     fmt.register_adapter(&double_extractor);
-    static auto float_extractor = make_adapter([] (const value& from) { return float(from.as_decimal()); },
-                                               [] (const float& from) { return value(from); }
-                                              );
+    static auto float_extractor = make_direct_adapter([] (const value& from) { return float(from.as_decimal()); },
+                                                      [] (const float& from) { return value(from); }
+                                                     );
     fmt.register_adapter(&float_extractor);
 
     return fmt;
@@ -505,23 +712,61 @@ formats formats::defaults()
 // formats::global                                                                                                    //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-static formats& global_formats_ref()
+namespace
+{
+
+/** The global formats are read far more often than they are set, so reading them is a single atomic load. Every
+ *  instance which has been global stays alive until exit, since contexts made on other threads refer to it without
+ *  holding a reference.
+**/
+class global_formats_state
+{
+public:
+    global_formats_state() :
+            _current(nullptr)
+    {
+        set(default_formats_ref());
+    }
+
+    const formats& get() const
+    {
+        return *_current.load(std::memory_order_acquire);
+    }
+
+    /** Make \a fmt the global instance, returning the previous one (if there was one). **/
+    const formats* set(const formats& fmt)
+    {
+        std::lock_guard<std::mutex> lock(_set_lock);
+        auto iter = std::find_if(_instances.begin(), _instances.end(),
+                                 [&] (const std::unique_ptr<const formats>& instance) { return *instance == fmt; }
+                                );
+        if (iter == _instances.end())
+            iter = _instances.emplace(_instances.end(), new formats(fmt));
+        return _current.exchange(iter->get(), std::memory_order_acq_rel);
+    }
+
+private:
+    std::atomic<const formats*>                 _current;
+    std::mutex                                  _set_lock;
+    std::vector<std::unique_ptr<const formats>> _instances;
+};
+
+}
+
+static global_formats_state& global_formats()
 {
-    static formats instance = default_formats_ref();
+    static global_formats_state instance;
     return instance;
 }
 
 formats formats::global()
 {
-    return formats::compose({ global_formats_ref() });
+    return formats::compose({ global_formats().get() });
 }
 
 formats formats::set_global(formats fmt)
 {
-    using std::swap;
-
-    swap(global_formats_ref(), fmt);
-    return fmt;
+    return *global_formats().set(fmt);
 }
 
 formats formats::reset_global()
@@ -541,11 +786,27 @@ static void register_integer_coerce_extractor(formats&              fmt,
     fmt.register_extractor(&instance, on_duplicate);
 }
 
+/** Strings extracted from a value the caller is done with are moved out of it instead of copied. **/
+class coerce_string_extractor :
+        public extractor_for<std::string>
+{
+protected:
+    virtual std::string create(const extraction_context&, const value& from) const override
+    {
+        return coerce_string(from);
+    }
+
+    virtual std::string create(const extraction_context&, value&& from) const override
+    {
+        return coerce_string(std::move(from));
+    }
+};
+
 static formats create_coerce_formats()
 {
     formats fmt;
 
-    static auto string_extractor = make_extractor([] (const value& from) { return coerce_string(from); });
+    static coerce_string_extractor string_extractor;
     fmt.register_extractor(&string_extractor);
 
     static auto bool_extractor = make_extractor([] (const value& from) { return coerce_boolean(from); });
@@ -595,14 +856,44 @@ context_base::context_base(jsonv::formats        fmt,
                            const void*           userdata
                           ) :
         _formats(std::move(fmt)),
+        _formats_ref(&_formats),
+        _version(ver),
+        _user_data(userdata)
+{ }
+
+context_base::context_base(std::reference_wrapper<const jsonv::formats> fmt,
+                           const jsonv::version&                        ver,
+                           const void*                                  userdata
+                          ) :
+        _formats(jsonv::formats::empty_tag()),
+        _formats_ref(&fmt.get()),
         _version(ver),
         _user_data(userdata)
 { }
 
 context_base::context_base() :
-        context_base(formats::global())
+        context_base(std::cref(global_formats().get()))
 { }
 
+context_base::context_base(const context_base& src) :
+        _formats(src._formats),
+        _formats_ref(src._formats_ref == &src._formats ? &_formats : src._formats_ref),
+        _version(src._version),
+        _user_data(src._user_data)
+{ }
+
+context_base& context_base::operator=(const context_base& src)
+{
+    if (this != &src)
+    {
+        _formats     = src._formats;
+        _formats_ref = src._formats_ref == &src._formats ? &_formats : src._formats_ref;
+        _version     = src._version;
+        _user_data   = src._user_data;
+    }
+    return *this;
+}
+
 context_base::~context_base() noexcept = default;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -615,33 +906,199 @@ extraction_context::extraction_context(jsonv::formats        fmt,
                                        const void*           userdata
                                       ) :
         context_base(std::move(fmt), ver, userdata),
-        _path(std::move(p))
+        _path(std::move(p)),
+        _parent(nullptr),
+        _subpath(nullptr),
+        _elem(nullptr),
+        _parallelism(1),
+        _failure(nullptr),
+        _quiet(false)
+{ }
+
+extraction_context::extraction_context(std::reference_wrapper<const jsonv::formats> fmt,
+                                       const jsonv::version&                        ver,
+                                       jsonv::path                                  p,
+                                       const void*                                  userdata
+                                      ) :
+        context_base(fmt, ver, userdata),
+        _path(std::move(p)),
+        _parent(nullptr),
+        _subpath(nullptr),
+        _elem(nullptr),
+        _parallelism(1),
+        _failure(nullptr),
+        _quiet(false)
 { }
 
 extraction_context::extraction_context() :
-        context_base()
+        context_base(),
+        _parent(nullptr),
+        _subpath(nullptr),
+        _elem(nullptr),
+        _parallelism(1),
+        _failure(nullptr),
+        _quiet(false)
+{ }
+
+extraction_context::extraction_context(const extraction_context& parent,
+                                       const jsonv::path*        subpath,
+                                       const path_element*       elem
+                                      ) :
+        context_base(std::cref(parent.formats()), parent.version(), parent.user_data()),
+        _parent(&parent),
+        _subpath(subpath),
+        _elem(elem),
+        _parallelism(parent._parallelism),
+        _failure(parent._failure),
+        _quiet(parent._quiet)
+{ }
+
+extraction_context::extraction_context(const extraction_context& src) :
+        context_base(src),
+        _path(src.path()),
+        _parent(nullptr),
+        _subpath(nullptr),
+        _elem(nullptr),
+        _parallelism(src._parallelism),
+        _failure(nullptr),
+        _quiet(false)
 { }
 
+extraction_context& extraction_context::operator=(const extraction_context& src)
+{
+    if (this != &src)
+    {
+        context_base::operator=(src);
+        _path        = src.path();
+        _parent      = nullptr;
+        _subpath     = nullptr;
+        _elem        = nullptr;
+        _parallelism = src._parallelism;
+        _failure     = nullptr;
+        _quiet       = false;
+    }
+    return *this;
+}
+
 extraction_context::~extraction_context() noexcept = default;
 
-void extraction_context::extract(const std::type_info& type, const value& from, void* into) const
+path extraction_context::path() const
+{
+    if (!_parent)
+        return _path;
+
+    jsonv::path out = _parent->path();
+    if (_subpath)
+        out += *_subpath;
+    else
+        out += *_elem;
+    return out;
+}
+
+void extraction_context::record_failure(extract_errc code) const
+{
+    if (_failure && _failure->code == extract_errc::none)
+        _failure->code = code;
+}
+
+/** The \c extract_errc for the exception \a ex thrown by an extractor. **/
+static extract_errc classify_failure(const std::exception& ex)
+{
+    if (dynamic_cast<const no_extractor*>(&ex))
+        return extract_errc::no_extractor;
+    else if (dynamic_cast<const kind_error*>(&ex))
+        return extract_errc::kind_mismatch;
+    else if (dynamic_cast<const std::out_of_range*>(&ex))
+        return extract_errc::out_of_range;
+    else
+        return extract_errc::invalid;
+}
+
+/** Call \a extract, turning anything other than an \c extraction_error it throws into one for \a context. **/
+template <typename FExtract>
+static void extract_in_context(const extraction_context& context, FExtract&& extract)
 {
     try
     {
-        formats().extract(type, from, into, *this);
+        extract();
     }
     catch (const extraction_error&)
     {
+        context.record_failure(extract_errc::invalid);
         throw;
     }
     catch (const std::exception& ex)
     {
-        throw extraction_error(*this, ex.what());
+        context.record_failure(classify_failure(ex));
+        throw extraction_error(context, ex.what());
     }
     catch (...)
     {
-        throw extraction_error(*this, std::string("Exception with type ") + current_exception_type_name());
+        context.record_failure(extract_errc::invalid);
+        throw extraction_error(context,
+                               context.quiet() ? std::string()
+                                               : std::string("Exception with type ") + current_exception_type_name()
+                              );
+    }
+}
+
+/** Find the element \a elem of \a from, just like \c at_path does, without making a path for it. **/
+template <typename TValue>
+static TValue& find_element(TValue& from, const path_element& elem)
+{
+    if (elem.kind() == path_element_kind::array_index)
+    {
+        if (from.kind() == kind::array && elem.index() < from.size())
+            return from[elem.index()];
+    }
+    else if (from.kind() == kind::object)
+    {
+        auto iter = from.find(elem.key());
+        if (iter != from.end_object())
+            return iter->second;
+    }
+
+    // only for the error
+    return from.at_path(jsonv::path({ elem }));
+}
+
+void extraction_context::extract(const std::type_info& type, const value& from, void* into) const
+{
+    extract_in_context(*this, [&] { formats().extract(type, from, into, *this); });
+}
+
+extract_failure extraction_context::try_extract(const std::type_info& type,
+                                                const value&          from,
+                                                void*                 into,
+                                                failure_details       details
+                                               )
+{
+    extract_failure failure;
+    _failure = &failure;
+    _quiet   = details == failure_details::code;
+    auto reset = detail::on_scope_exit([this] { _failure = nullptr; _quiet = false; });
+    
+    try
+    {
+        extract(type, from, into);
+    }
+    catch (const extraction_error& ex)
+    {
+        record_failure(extract_errc::invalid);
+        if (!_quiet)
+            failure.details = std::make_shared<extraction_error>(ex);
     }
+    return failure;
+}
+
+void extraction_context::extract(const std::type_info& type, value&& from, void* into) const
+{
+    extract_in_context(*this, [&] { formats().extract(type, std::move(from), into, *this); });
+}
+
+void extraction_context::extract(const std::type_info& type, tokenizer& from, void* into) const
+{
+    extract_in_context(*this, [&] { formats().extract(type, from, into, *this); });
 }
 
 void extraction_context::extract_sub(const std::type_info& type,
@@ -650,26 +1107,165 @@ void extraction_context::extract_sub(const std::type_info& type,
                                      void*                 into
                                     ) const
 {
-    extraction_context sub(*this);
-    sub._path += subpath;
-    try
+    extraction_context sub(*this, &subpath, nullptr);
+    extract_in_context(sub, [&] { sub.extract(type, from.at_path(subpath), into); });
+}
+
+void extraction_context::extract_sub(const std::type_info& type,
+                                     const value&          from,
+                                     path_element          elem,
+                                     void*                 into
+                                    ) const
+{
+    extraction_context sub(*this, nullptr, &elem);
+    extract_in_context(sub, [&] { sub.extract(type, find_element(from, elem), into); });
+}
+
+void extraction_context::extract_sub(const std::type_info& type,
+                                     value&&               from,
+                                     path_element          elem,
+                                     void*                 into
+                                    ) const
+{
+    extraction_context sub(*this, nullptr, &elem);
+    extract_in_context(sub, [&] { sub.extract(type, std::move(find_element(from, elem)), into); });
+}
+
+void extraction_context::extract_sub(const std::type_info& type,
+                                     tokenizer&            from,
+                                     path_element          elem,
+                                     void*                 into
+                                    ) const
+{
+    extraction_context sub(*this, nullptr, &elem);
+    extract_in_context(sub, [&] { sub.extract(type, from, into); });
+}
+
+void extraction_context::extract_element(const std::type_info& type,
+                                         const value&          element,
+                                         path_element          elem,
+                                         void*                 into
+                                        ) const
+{
+    extraction_context sub(*this, nullptr, &elem);
+    extract_in_context(sub, [&] { sub.extract(type, element, into); });
+}
+
+void extraction_context::extract_element(const std::type_info& type,
+                                         value&&               element,
+                                         path_element          elem,
+                                         void*                 into
+                                        ) const
+{
+    extraction_context sub(*this, nullptr, &elem);
+    extract_in_context(sub, [&] { sub.extract(type, std::move(element), into); });
+}
+
+/** Each thread in \c extract_elements gets at least this many elements, so that starting it is cheap in comparison. **/
+static constexpr std::size_t parallel_min_elements_per_thread = 1024;
+
+/** Extract \a count elements of \a type from \a elements into \a into (see \c extraction_context::extract_elements).
+ *  \a TValue is \c value if the elements can be moved from and \c const \c value if they can not.
+**/
+template <typename TValue>
+static void extract_elements_impl(const extraction_context& context,
+                                  const std::type_info&     type,
+                                  TValue*                   elements,
+                                  std::size_t               count,
+                                  void*                     into,
+                                  std::size_t               size,
+                                  void                      (*destroy)(void*)
+                                 )
+{
+    std::size_t threads = context.parallelism() == 0 ? std::thread::hardware_concurrency() : context.parallelism();
+    threads = std::max<std::size_t>(1U, std::min(threads, count / parallel_min_elements_per_thread));
+
+    // Elements do not split their own elements any further, since every thread is already busy
+    std::unique_ptr<extraction_context> serial_context;
+    if (threads > 1)
     {
-        return sub.extract(type, from.at_path(subpath), into);
+        serial_context.reset(new extraction_context(context));
+        serial_context->parallelism(1);
     }
-    catch (const extraction_error&)
+    const extraction_context& element_context = serial_context ? *serial_context : context;
+
+    struct part
     {
-        throw;
+        std::size_t        begin;
+        std::size_t        end;
+        std::size_t        done;  //!< The elements in [begin, done) have been extracted
+        std::exception_ptr error;
+    };
+    std::vector<part> parts;
+    for (std::size_t idx = 0; idx < threads; ++idx)
+    {
+        std::size_t begin = count * idx / threads;
+        parts.push_back({ begin, count * (idx + 1) / threads, begin, nullptr });
     }
-    catch (const std::exception& ex)
+
+    auto run = [&] (part& work)
+               {
+                   try
+                   {
+                       for (; work.done < work.end; ++work.done)
+                           element_context.extract_element(type,
+                                                           std::move(elements[work.done]),
+                                                           work.done,
+                                                           static_cast<char*>(into) + work.done * size
+                                                          );
+                   }
+                   catch (...)
+                   {
+                       work.error = std::current_exception();
+                   }
+               };
+
+    // The calling thread takes the first part itself
     {
-        throw extraction_error(sub, ex.what());
+        std::vector<std::thread> workers;
+        auto join_workers = detail::on_scope_exit([&workers]
+                                                  {
+                                                      for (std::thread& worker : workers)
+                                                          worker.join();
+                                                  }
+                                                 );
+        workers.reserve(parts.size() - 1);
+        for (std::size_t idx = 1; idx < parts.size(); ++idx)
+            workers.emplace_back(run, std::ref(parts[idx]));
+        run(parts[0]);
     }
-    catch (...)
+
+    // Each part stops at its first error, so the first part with an error has the error for the first element
+    auto failed = std::find_if(parts.begin(), parts.end(), [] (const part& work) { return bool(work.error); });
+    if (failed != parts.end())
     {
-        throw extraction_error(sub, std::string("Exception with type ") + current_exception_type_name());
+        for (const part& work : parts)
+            for (std::size_t idx = work.begin; idx < work.done; ++idx)
+                destroy(static_cast<char*>(into) + idx * size);
+        std::rethrow_exception(failed->error);
     }
 }
 
+void extraction_context::extract_elements(const std::type_info& type,
+                                          const value&          from,
+                                          void*                 into,
+                                          std::size_t           size,
+                                          void                  (*destroy)(void*)
+                                         ) const
+{
+    extract_elements_impl(*this, type, from.array_data(), from.size(), into, size, destroy);
+}
+
+void extraction_context::extract_elements(const std::type_info& type,
+                                          value&&               from,
+                                          void*                 into,
+                                          std::size_t           size,
+                                          void                  (*destroy)(void*)
+                                         ) const
+{
+    extract_elements_impl(*this, type, from.array_data(), from.size(), into, size, destroy);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // serialization_context                                                                                              //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -681,6 +1277,13 @@ serialization_context::serialization_context(jsonv::formats        fmt,
         context_base(std::move(fmt), ver, userdata)
 { }
 
+serialization_context::serialization_context(std::reference_wrapper<const jsonv::formats> fmt,
+                                             const jsonv::version&                        ver,
+                                             const void*                                  userdata
+                                            ) :
+        context_base(fmt, ver, userdata)
+{ }
+
 serialization_context::serialization_context() :
         context_base()
 { }
@@ -692,4 +1295,14 @@ value serialization_context::to_json(const std::type_info& type, const void* fro
     return formats().to_json(type, from, *this);
 }
 
+void serialization_context::encode(const std::type_info& type, const void* from, encoder& out) const
+{
+    formats().encode(type, from, *this, out);
+}
+
+void serialization_context::encode(const std::type_info& type, const void* from, writer& out) const
+{
+    out.value_with([&] (encoder& sub) { formats().encode(type, from, *this, sub); });
+}
+
 }
@@ -0,0 +1,146 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/stats.hpp>
+#include <jsonv/tokenizer.hpp>
+#include <jsonv/value.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <ostream>
+
+namespace jsonv
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// parse_stats                                                                                                        //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+parse_stats::size_type parse_stats::tokens(token_kind kinds) const
+{
+    size_type out = 0;
+    for (std::size_t bit = 0; bit < token_counts.size(); ++bit)
+        if (static_cast<unsigned int>(kinds) & (1U << bit))
+            out += token_counts[bit];
+    return out;
+}
+
+parse_stats::size_type parse_stats::total_tokens() const
+{
+    return std::accumulate(token_counts.begin(), token_counts.end(), size_type(0));
+}
+
+parse_stats::duration parse_stats::build_time() const
+{
+    duration out = total_time - tokenize_time - string_time - number_time;
+    return std::max(out, duration(0));
+}
+
+void parse_stats::add_token(token_kind kind)
+{
+    unsigned int bits = static_cast<unsigned int>(kind);
+    for (std::size_t bit = 0; bit < token_counts.size(); ++bit)
+        if (bits & (1U << bit))
+            ++token_counts[bit];
+}
+
+parse_stats& parse_stats::operator+=(const parse_stats& other)
+{
+    documents += other.documents;
+    for (std::size_t idx = 0; idx < token_counts.size(); ++idx)
+        token_counts[idx] += other.token_counts[idx];
+    string_bytes  += other.string_bytes;
+    number_bytes  += other.number_bytes;
+    max_depth      = std::max(max_depth, other.max_depth);
+    total_time    += other.total_time;
+    tokenize_time += other.tokenize_time;
+    string_time   += other.string_time;
+    number_time   += other.number_time;
+    return *this;
+}
+
+std::ostream& operator<<(std::ostream& os, const parse_stats& stats)
+{
+    static const char* const token_names[] =
+        {
+            "array_begin", "array_end", "boolean", "null", "number", "separator", "string", "object_begin",
+            "object_key_delimiter", "object_end", "whitespace", "comment",
+        };
+
+    os << "{\"documents\": " << stats.documents;
+    os << ", \"tokens\": {";
+    for (std::size_t bit = 0; bit < stats.token_counts.size(); ++bit)
+        os << (bit == 0 ? "" : ", ") << '"' << token_names[bit] << "\": " << stats.token_counts[bit];
+    os << '}';
+    os << ", \"string_bytes\": "  << stats.string_bytes;
+    os << ", \"number_bytes\": "  << stats.number_bytes;
+    os << ", \"max_depth\": "     << stats.max_depth;
+    os << ", \"total_ns\": "      << stats.total_time.count();
+    os << ", \"tokenize_ns\": "   << stats.tokenize_time.count();
+    os << ", \"string_ns\": "     << stats.string_time.count();
+    os << ", \"number_ns\": "     << stats.number_time.count();
+    os << ", \"build_ns\": "      << stats.build_time().count();
+    os << '}';
+    return os;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// encode_stats                                                                                                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+encode_stats::size_type encode_stats::values(kind of_kind) const
+{
+    return value_counts.at(static_cast<std::size_t>(of_kind));
+}
+
+encode_stats::size_type encode_stats::total_values() const
+{
+    return std::accumulate(value_counts.begin(), value_counts.end(), size_type(0));
+}
+
+encode_stats::duration encode_stats::structure_time() const
+{
+    duration out = total_time - string_time - number_time;
+    return std::max(out, duration(0));
+}
+
+encode_stats& encode_stats::operator+=(const encode_stats& other)
+{
+    documents += other.documents;
+    for (std::size_t idx = 0; idx < value_counts.size(); ++idx)
+        value_counts[idx] += other.value_counts[idx];
+    keys         += other.keys;
+    string_bytes += other.string_bytes;
+    max_depth     = std::max(max_depth, other.max_depth);
+    total_time   += other.total_time;
+    string_time  += other.string_time;
+    number_time  += other.number_time;
+    return *this;
+}
+
+std::ostream& operator<<(std::ostream& os, const encode_stats& stats)
+{
+    os << "{\"documents\": " << stats.documents;
+    os << ", \"values\": {";
+    for (std::size_t idx = 0; idx < stats.value_counts.size(); ++idx)
+        os << (idx == 0 ? "" : ", ") << '"' << static_cast<kind>(idx) << "\": " << stats.value_counts[idx];
+    os << '}';
+    os << ", \"keys\": "          << stats.keys;
+    os << ", \"string_bytes\": "  << stats.string_bytes;
+    os << ", \"max_depth\": "     << stats.max_depth;
+    os << ", \"total_ns\": "      << stats.total_time.count();
+    os << ", \"string_ns\": "     << stats.string_time.count();
+    os << ", \"number_ns\": "     << stats.number_time.count();
+    os << ", \"structure_ns\": "  << stats.structure_time().count();
+    os << '}';
+    return os;
+}
+
+}
@@ -0,0 +1,117 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/detail/token_stream.hpp>
+#include <jsonv/parse.hpp>
+#include <jsonv/tokenizer.hpp>
+
+#include "char_convert.hpp"
+
+namespace jsonv
+{
+namespace detail
+{
+
+[[noreturn]]
+static void throw_stream_error(const tokenizer& from, std::string message)
+{
+    tokenizer::location loc = from.current_location();
+    throw parse_error({ parse_error::problem(loc.line, loc.column, loc.character, std::move(message)) }, null);
+}
+
+tokenizer& next_token(tokenizer& from)
+{
+    while (from.next())
+    {
+        token_kind kind = from.current().kind;
+        if (kind != token_kind::whitespace && kind != token_kind::comment)
+            return from;
+    }
+    throw_stream_error(from, "Unexpected end of input");
+}
+
+void skip_current(tokenizer& from)
+{
+    std::size_t depth = 0;
+    do
+    {
+        switch (from.current().kind)
+        {
+        case token_kind::array_begin:
+        case token_kind::object_begin:
+            ++depth;
+            break;
+        case token_kind::array_end:
+        case token_kind::object_end:
+            if (depth == 0)
+                throw_stream_error(from, "Unexpected end of container");
+            --depth;
+            break;
+        default:
+            break;
+        }
+        
+        if (depth != 0)
+            next_token(from);
+    } while (depth != 0);
+}
+
+bool next_array_element(tokenizer& from, bool first)
+{
+    next_token(from);
+    if (from.current().kind == token_kind::array_end)
+        return false;
+    
+    if (!first)
+    {
+        if (from.current().kind != token_kind::separator)
+            throw_stream_error(from, "Expected ',' or ']' after an array element");
+        next_token(from);
+    }
+    return true;
+}
+
+bool next_object_entry(tokenizer& from, bool first, std::string& key)
+{
+    next_token(from);
+    if (from.current().kind == token_kind::object_end)
+        return false;
+    
+    if (!first)
+    {
+        if (from.current().kind != token_kind::separator)
+            throw_stream_error(from, "Expected ',' or '}' after an object value");
+        next_token(from);
+    }
+    
+    if (from.current().kind != token_kind::string)
+        throw_stream_error(from, "Expected a string for an object key");
+    string_view source = from.current().text;
+    source.remove_prefix(1);
+    source.remove_suffix(1);
+    try
+    {
+        static const string_decode_fn decode = get_string_decoder(parse_options::encoding::utf8);
+        key = decode(source);
+    }
+    catch (const decode_error& err)
+    {
+        throw_stream_error(from, std::string("Error decoding string: ") + err.what());
+    }
+    
+    next_token(from);
+    if (from.current().kind != token_kind::object_key_delimiter)
+        throw_stream_error(from, "Expected ':' after an object key");
+    next_token(from);
+    return true;
+}
+
+}
+}
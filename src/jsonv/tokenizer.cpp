@@ -9,10 +9,12 @@
  *  \author Travis Gockel (travis@gockelhut.com)
 **/
 #include <jsonv/tokenizer.hpp>
+#include <jsonv/detail/structural_index.hpp>
 #include <jsonv/detail/token_patterns.hpp>
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iomanip>
 #include <istream>
 #include <iterator>
@@ -109,34 +111,64 @@ void tokenizer::set_min_buffer_size(tokenizer::size_type sz)
     min_buffer_size_ref() = std::max(sz, tokenizer::size_type(1));
 }
 
-tokenizer::tokenizer(string_view input) :
-        _input(input),
-        _position(_input.data())
-{ }
+/** Inputs smaller than this are scanned a byte at a time -- the time to build a \c detail::structural_index only pays
+ *  off when the strings in the input are scanned quickly enough to make up for it.
+**/
+static constexpr std::size_t structural_index_min_input_size = 4 * 1024;
 
-tokenizer::tokenizer(std::shared_ptr<std::string> input) :
-        _input(*input),
-        _position(_input.data()),
-        _track(std::move(input))
-{ }
+static std::shared_ptr<const detail::structural_index> create_structural_index(string_view input)
+{
+    if (structural_index_min_input_size <= input.size() && input.size() <= detail::structural_index::max_input_size)
+        return std::make_shared<detail::structural_index>(input);
+    else
+        return nullptr;
+}
 
-static std::string load_single_string(std::istream& input)
+/** The state of a \c tokenizer reading from an \c std::istream. The valid data is in <tt>[0, used)</tt> of \c buffer
+ *  and is always followed by a \c '\0', so functions like \c std::strtod which look for a terminator do not run off
+ *  into stale data.
+**/
+struct tokenizer::stream_state
 {
-    std::string out;
-    char buffer[16 * 1024];
+    std::istream& input;
+    std::string   buffer;
+    size_type     used;      //!< The number of characters of \c buffer which are valid
+    size_type     discarded; //!< The number of characters discarded from the front of the \c buffer
+    bool          eof;       //!< Has \c input run out of data?
+
+    explicit stream_state(std::istream& input, size_type capacity) :
+            input(input),
+            buffer(capacity + 1, '\0'),
+            used(0),
+            discarded(0),
+            eof(false)
+    { }
 
-    while (input.read(buffer, sizeof buffer))
+    size_type capacity() const
     {
-        out.append(buffer, sizeof buffer);
+        return buffer.size() - 1;
     }
-    out.append(buffer, input.gcount());
+};
 
-    return out;
-}
+tokenizer::tokenizer(string_view input) :
+        _input(input),
+        _position(_input.data()),
+        _index(create_structural_index(_input)),
+        _index_cursor(0),
+        _location_ptr(_position),
+        _location(location{ 1, 1, 0 })
+{ }
 
 tokenizer::tokenizer(std::istream& input) :
-        tokenizer(std::make_shared<std::string>(load_single_string(input)))
-{ }
+        _input(),
+        _index_cursor(0),
+        _stream(std::make_shared<stream_state>(input, min_buffer_size())),
+        _location(location{ 1, 1, 0 })
+{
+    _input        = string_view(_stream->buffer.data(), 0);
+    _position     = _input.data();
+    _location_ptr = _position;
+}
 
 tokenizer::~tokenizer() noexcept
 { }
@@ -154,7 +186,83 @@ const tokenizer::token& tokenizer::current() const
         throw std::logic_error("Cannot get token -- call next() and make sure it returns true.");
 }
 
+tokenizer::location tokenizer::current_location() const
+{
+    detail::advance_location(_location, _location_ptr, _position);
+    _location_ptr = _position;
+    return _location;
+}
+
+bool tokenizer::refill()
+{
+    if (!_stream || _stream->eof)
+        return false;
+
+    stream_state& state = *_stream;
+
+    // The buffer is full, so make room by discarding everything before the current token. The current token is kept
+    // even though next() is moving past it so it is still valid if we reach the end of the input.
+    if (state.used == state.capacity())
+    {
+        const char* keep_from = _current.text.data() ? std::min(_current.text.data(), _position) : _position;
+        auto        discard   = size_type(keep_from - state.buffer.data());
+
+        if (_location_ptr < keep_from)
+        {
+            detail::advance_location(_location, _location_ptr, keep_from);
+            _location_ptr = keep_from;
+        }
+        std::memmove(&state.buffer[0], keep_from, state.used - discard);
+        state.used      -= discard;
+        state.discarded += discard;
+
+        _position     -= discard;
+        _location_ptr -= discard;
+        if (_current.text.data())
+            _current.text = string_view(_current.text.data() - discard, _current.text.size());
+
+        // a single token takes up the entire buffer, so it has to get bigger
+        if (state.used == state.capacity())
+            buffer_reserve(state.capacity() * 2);
+    }
+
+    state.input.read(&state.buffer[state.used], std::streamsize(state.capacity() - state.used));
+    auto count = size_type(state.input.gcount());
+    state.used += count;
+    state.buffer[state.used] = '\0';
+    if (!state.input)
+        state.eof = true;
+
+    _input = string_view(state.buffer.data(), state.used);
+    return count > 0;
+}
+
 bool tokenizer::next()
+{
+    return advance(true);
+}
+
+tokenizer::size_type tokenizer::next_batch(token* out, size_type max_tokens, token_kind skip)
+{
+    size_type count = 0;
+    while (count < max_tokens)
+    {
+        // Refilling the buffer of a stream moves the text of the tokens already in the batch, so only the first token
+        // can ask for more input
+        if (!advance(count == 0 || !_stream))
+            break;
+
+        // Tokens with a problem are never skipped, even if they look like a kind which is (a stray '/' is a broken
+        // comment)
+        if (  (_current.kind & skip) == token_kind::unknown
+           || (_current.kind & token_kind::parse_error_indicator) != token_kind::unknown
+           )
+            out[count++] = _current;
+    }
+    return count;
+}
+
+bool tokenizer::advance(bool may_refill)
 {
     auto valid = [this] (const string_view& new_current, token_kind new_kind)
                  {
@@ -163,15 +271,31 @@ bool tokenizer::next()
                      return true;
                  };
     
-    if (!_current.text.empty())
+    // Only step over the current token once, since next() can be called again after it has returned false
+    if (_current.text.data() == _position)
         _position += _current.text.size();
 
-    while (_position < _input.end())
+    while (_position < _input.end() || (may_refill && refill()))
     {
+        // Strings are the only tokens which can be long and the index knows where they end, so jump right there
+        std::size_t offset = std::size_t(_position - _input.data());
+        std::size_t close;
+        if (_index && *_position == '\"' && _index->find_string_end(offset, _index_cursor, close))
+            return valid(string_view(_position, close + 1 - offset), token_kind::string);
+
         token_kind kind;
         size_type  match_len;
         auto       result = detail::attempt_match(_position, _input.end(), *&kind, *&match_len);
 
+        // The token runs up to the end of what has been read so far, so more input might change it
+        if (_stream && !_stream->eof && detail::match_may_continue(result, kind, _position + match_len, _input.end()))
+        {
+            if (!may_refill)
+                return false;
+            refill();
+            continue;
+        }
+
         if (result == detail::match_result::unmatched)
         {
             // unmatched entry -- this token is invalid
@@ -183,7 +307,23 @@ bool tokenizer::next()
     return false;
 }
 
-void tokenizer::buffer_reserve(size_type)
-{ }
+void tokenizer::buffer_reserve(size_type sz)
+{
+    if (!_stream || sz <= _stream->capacity())
+        return;
+
+    // Growing the buffer moves it, so everything pointing into it needs to move along with it
+    stream_state& state    = *_stream;
+    const char*   old_base = state.buffer.data();
+    state.buffer.resize(sz + 1, '\0');
+    const char*   new_base = state.buffer.data();
+
+    auto rebase = [&] (const char* p) { return p ? new_base + (p - old_base) : p; };
+    _position     = rebase(_position);
+    _location_ptr = rebase(_location_ptr);
+    if (_current.text.data())
+        _current.text = string_view(rebase(_current.text.data()), _current.text.size());
+    _input = string_view(new_base, state.used);
+}
 
 }
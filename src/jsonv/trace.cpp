@@ -0,0 +1,57 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/trace.hpp>
+
+#include "detail/trace_scope.hpp"
+
+#include <ostream>
+
+namespace jsonv
+{
+
+std::ostream& operator<<(std::ostream& os, const trace_operation& operation)
+{
+    switch (operation)
+    {
+    case trace_operation::parse:   return os << "parse";
+    case trace_operation::extract: return os << "extract";
+    case trace_operation::to_json: return os << "to_json";
+    case trace_operation::encode:  return os << "encode";
+    default:                       return os << "trace_operation(" << static_cast<int>(operation) << ")";
+    }
+}
+
+tracer::~tracer() noexcept = default;
+
+tracer* set_tracer(tracer* handler)
+{
+    return detail::installed_tracer.exchange(handler, std::memory_order_acq_rel);
+}
+
+tracer* get_tracer()
+{
+    return detail::installed_tracer.load(std::memory_order_acquire);
+}
+
+namespace detail
+{
+
+std::atomic<tracer*> installed_tracer { nullptr };
+
+unsigned int& trace_nesting(trace_operation operation)
+{
+    static thread_local unsigned int nesting[4] = {};
+    return nesting[static_cast<std::size_t>(operation)];
+}
+
+}
+
+}
@@ -11,11 +11,15 @@
 #include <jsonv/value.hpp>
 #include <jsonv/algorithm.hpp>
 #include <jsonv/encode.hpp>
+#include <jsonv/encode_static.hpp>
 #include <jsonv/path.hpp>
 
 #include "array.hpp"
 #include "char_convert.hpp"
 #include "detail.hpp"
+#include "detail/compact_writer.hpp"
+#include "detail/hash.hpp"
+#include "detail/number_convert.hpp"
 #include "object.hpp"
 
 #include <algorithm>
@@ -24,6 +28,7 @@
 #include <iterator>
 #include <ostream>
 #include <sstream>
+#include <vector>
 
 namespace jsonv
 {
@@ -77,6 +82,95 @@ value::value(const std::string& val) :
     _data.string->_string = val;
 }
 
+value::value(std::string&& val) :
+        _kind(jsonv::kind::null)
+{
+    _data.string = new detail::string_impl;
+    _kind = jsonv::kind::string;
+    _data.string->_string = std::move(val);
+}
+
+namespace detail
+{
+
+value make_borrowed_string(string_view contents, std::shared_ptr<const void> owner)
+{
+    value out;
+    out._data.string = new string_impl(contents, std::move(owner));
+    out._kind        = jsonv::kind::string;
+    return out;
+}
+
+void set_encoded_json(value& target, std::shared_ptr<const std::string> text)
+{
+    if (target._kind == jsonv::kind::array)
+        target._data.array->_encoded = std::move(text);
+    else if (target._kind == jsonv::kind::object)
+        target._data.object->_encoded = std::move(text);
+}
+
+const std::string* encoded_json(const value& source)
+{
+    if (source._kind == jsonv::kind::array)
+        return source._data.array->_encoded.get();
+    else if (source._kind == jsonv::kind::object)
+        return source._data.object->_encoded.get();
+    else
+        return nullptr;
+}
+
+/** The characters a number can have, in the order of the 4-bit codes \c make_lazy_number packs them as. **/
+static const char lazy_number_chars[] = "0123456789.eE-+";
+
+value make_lazy_number(string_view text)
+{
+    unsigned char packed[sizeof(value_storage) + sizeof value::_text] = {};
+    for (std::size_t idx = 0; idx < text.size(); ++idx)
+    {
+        char     c    = text[idx];
+        unsigned code = ('0' <= c && c <= '9') ? unsigned(c - '0')
+                      : c == '.'               ? 10U
+                      : c == 'e'               ? 11U
+                      : c == 'E'               ? 12U
+                      : c == '-'               ? 13U
+                      :                          14U;
+        packed[idx / 2] |= static_cast<unsigned char>(code << (idx % 2 * 4));
+    }
+
+    value out;
+    std::memcpy(&out._data, packed, sizeof out._data);
+    std::memcpy(out._text, packed + sizeof out._data, sizeof out._text);
+    out._text_size = static_cast<std::uint8_t>(text.size());
+    out._kind      = jsonv::kind::decimal;
+    return out;
+}
+
+std::size_t lazy_number_text(const value& source, char* out)
+{
+    if (source._kind != jsonv::kind::decimal || !source._text_size)
+        return 0;
+
+    unsigned char packed[sizeof(value_storage) + sizeof value::_text];
+    std::memcpy(packed, &source._data, sizeof source._data);
+    std::memcpy(packed + sizeof source._data, source._text, sizeof source._text);
+    for (std::size_t idx = 0; idx < source._text_size; ++idx)
+        out[idx] = lazy_number_chars[(packed[idx / 2] >> (idx % 2 * 4)) & 0xfU];
+    return source._text_size;
+}
+
+}
+
+double value::lazy_decimal() const
+{
+    char         text[detail::max_lazy_number_length];
+    std::size_t  length  = detail::lazy_number_text(*this, text);
+    std::int64_t integer = 0;
+    double       decimal = 0.0;
+    if (detail::convert_number(string_view(text, length), integer, decimal) == detail::number_convert_result::integer)
+        return double(integer);
+    return decimal;
+}
+
 value::value(const string_view& val) :
         value(std::string(val))
 { }
@@ -134,13 +228,13 @@ value::value(const value& other) :
     switch (other.kind())
     {
     case jsonv::kind::object:
-        _data.object = other._data.object->clone();
+        _data.object = other._data.object->share();
         break;
     case jsonv::kind::array:
-        _data.array = other._data.array->clone();
+        _data.array = other._data.array->share();
         break;
     case jsonv::kind::string:
-        _data.string = other._data.string->clone();
+        _data.string = other._data.string->share();
         break;
     case jsonv::kind::integer:
         _data.integer = other._data.integer;
@@ -154,6 +248,8 @@ value::value(const value& other) :
     case jsonv::kind::null:
         break;
     }
+    _text_size = other._text_size;
+    std::copy(std::begin(other._text), std::end(other._text), _text);
 }
 
 value& value::operator=(const value& other)
@@ -165,10 +261,13 @@ value& value::operator=(const value& other)
 
 value::value(value&& other) noexcept :
         _data(other._data),
-        _kind(other._kind)
+        _kind(other._kind),
+        _text_size(other._text_size)
 {
+    std::copy(std::begin(other._text), std::end(other._text), _text);
     other._data.object = 0;
     other._kind = jsonv::kind::null;
+    other._text_size = 0;
 }
 
 value& value::operator=(value&& source) noexcept
@@ -179,48 +278,16 @@ value& value::operator=(value&& source) noexcept
         
         _data = source._data;
         _kind = source._kind;
+        _text_size = source._text_size;
+        std::copy(std::begin(source._text), std::end(source._text), _text);
         source._data.object = 0;
         source._kind = jsonv::kind::null;
+        source._text_size = 0;
     }
     
     return *this;
 }
 
-bool value::is_array() const
-{
-    return kind() == jsonv::kind::array;
-}
-
-bool value::is_boolean() const
-{
-    return kind() == jsonv::kind::boolean;
-}
-
-bool value::is_decimal() const
-{
-    return kind() == jsonv::kind::decimal || kind() == jsonv::kind::integer;
-}
-
-bool value::is_integer() const
-{
-    return kind() == jsonv::kind::integer;
-}
-
-bool value::is_null() const
-{
-    return kind() == jsonv::kind::null;
-}
-
-bool value::is_string() const
-{
-    return kind() == jsonv::kind::string;
-}
-
-bool value::is_object() const
-{
-    return kind() == jsonv::kind::object;
-}
-
 template <typename TValueRef, typename TPathIterator, typename FOnNonexistantPath>
 TValueRef walk_path(TValueRef&&               current,
                     TPathIterator             first,
@@ -359,6 +426,43 @@ value::size_type value::count_path(size_type p) const
     return count_path(jsonv::path({ p }));
 }
 
+void value::make_shareable()
+{
+    // Storage which is already shareable has not been changed since it was made so, which means nothing under it has
+    // been changed either. This saves walking the whole tree again when a snapshot is taken from a mostly-unchanged
+    // tree.
+    std::vector<value*> pending = { this };
+    while (!pending.empty())
+    {
+        value* current = pending.back();
+        pending.pop_back();
+        switch (current->_kind)
+        {
+        case jsonv::kind::object:
+            if (!current->_data.object->_shareable.exchange(true, std::memory_order_relaxed))
+                for (auto& entry : current->_data.object->_values)
+                    pending.push_back(&entry.second);
+            break;
+        case jsonv::kind::array:
+            // Packed elements are numbers, so there is nothing in them to make shareable
+            if (!current->_data.array->_shareable.exchange(true, std::memory_order_relaxed)
+               && !current->_data.array->packed()
+               )
+                for (value& element : current->_data.array->values())
+                    pending.push_back(&element);
+            break;
+        case jsonv::kind::string:
+            current->_data.string->_shareable.store(true, std::memory_order_relaxed);
+            break;
+        case jsonv::kind::integer:
+        case jsonv::kind::decimal:
+        case jsonv::kind::boolean:
+        case jsonv::kind::null:
+            break;
+        }
+    }
+}
+
 void value::swap(value& other) noexcept
 {
     using std::swap;
@@ -366,6 +470,8 @@ void value::swap(value& other) noexcept
     // All types of this union a trivially swappable
     swap(_data, other._data);
     swap(_kind, other._kind);
+    swap(_text_size, other._text_size);
+    swap(_text, other._text);
 }
 
 void value::clear()
@@ -373,13 +479,13 @@ void value::clear()
     switch (_kind)
     {
     case jsonv::kind::object:
-        delete _data.object;
+        _data.object->release();
         break;
     case jsonv::kind::array:
-        delete _data.array;
+        _data.array->release();
         break;
     case jsonv::kind::string:
-        delete _data.string;
+        _data.string->release();
         break;
     case jsonv::kind::integer:
     case jsonv::kind::decimal:
@@ -391,63 +497,121 @@ void value::clear()
     
     _kind = jsonv::kind::null;
     _data.object = 0;
+    _text_size = 0;
 }
 
 const std::string& value::as_string() const
 {
     check_type(jsonv::kind::string, _kind);
-    return _data.string->_string;
+    return _data.string->str();
 }
 
-string_view value::as_string_view() const &
+std::string value::take_string()
 {
     check_type(jsonv::kind::string, _kind);
-    return string_view(_data.string->_string);
+    
+    std::string out;
+    if (_data.string->shared() || _data.string->borrowed())
+        out = _data.string->str();
+    else
+        out = std::move(_data.string->_string);
+    clear();
+    return out;
 }
 
-std::wstring value::as_wstring() const
+string_view value::as_string_view() const &
 {
-    return detail::convert_to_wide(as_string());
+    check_type(jsonv::kind::string, _kind);
+    return _data.string->view();
 }
 
-int64_t value::as_integer() const
+std::wstring value::as_wstring() const
 {
-    check_type(jsonv::kind::integer, _kind);
-    return _data.integer;
+    return detail::convert_to_wide(as_string());
 }
 
-double value::as_decimal() const
+template <>
+string_view value::get_unchecked<string_view>() const
 {
-    if (_kind == jsonv::kind::integer)
-        return double(as_integer());
-    check_type(jsonv::kind::decimal, _kind);
-    return _data.decimal;
+    if (JSONV_DEBUG && _kind != jsonv::kind::string)
+        detail::throw_kind_error(jsonv::kind::string, _kind);
+    return _data.string->view();
 }
 
-bool value::as_boolean() const
+/** Do the hashes remembered by the storage \a a and \a b (see \c hash_aggregate) show they hold different values?
+ *  Nothing is known unless both have one.
+**/
+template <typename TImpl>
+static bool known_different(const TImpl* a, const TImpl* b)
 {
-    check_type(jsonv::kind::boolean, _kind);
-    return _data.boolean;
+    std::size_t x = a->_hash.load(std::memory_order_relaxed);
+    std::size_t y = b->_hash.load(std::memory_order_relaxed);
+    return x != 0 && y != 0 && x != y;
 }
 
 bool value::operator==(const value& other) const
 {
-    if (this == &other && kind_valid(kind()))
-        return true;
-    else
-        return compare(other) == 0;
+    if (this == &other)
+        return kind_valid(kind());
+    
+    // Unlike compare, equality can give up as soon as the sizes differ (or the storage is shared by both values)
+    if (kind() == other.kind())
+    {
+        switch (kind())
+        {
+        case jsonv::kind::string:
+        {
+            string_view a = as_string_view();
+            string_view b = other.as_string_view();
+            return a.size() == b.size() && (a.data() == b.data() || std::memcmp(a.data(), b.data(), a.size()) == 0);
+        }
+        case jsonv::kind::array:
+        {
+            if (_data.array == other._data.array)
+                return true;
+            if (size() != other.size() || known_different(_data.array, other._data.array))
+                return false;
+            
+            const std::int64_t* aints = packed_integers();
+            const std::int64_t* bints = other.packed_integers();
+            if (aints && bints)
+                return std::equal(aints, aints + size(), bints);
+            
+            const value* aiter = detail::as_const(_data.array)->values().data();
+            const value* biter = detail::as_const(other._data.array)->values().data();
+            for (const value* aend = aiter + size(); aiter != aend; ++aiter, ++biter)
+                if (!(*aiter == *biter))
+                    return false;
+            return true;
+        }
+        case jsonv::kind::object:
+        {
+            if (_data.object == other._data.object)
+                return true;
+            if (size() != other.size() || known_different(_data.object, other._data.object))
+                return false;
+            
+            auto biter = other._data.object->_values.begin();
+            for (const auto& entry : _data.object->_values)
+            {
+                if (entry.first != biter->first || !(entry.second == biter->second))
+                    return false;
+                ++biter;
+            }
+            return true;
+        }
+        default:
+            break;
+        }
+    }
+    
+    return compare(other) == 0;
 }
 
 bool value::operator !=(const value& other) const
 {
-    // must be first: an invalid type is not equal to itself
-    if (!kind_valid(kind()))
-        return true;
-    
-    if (this == &other)
-        return false;
-    else
-        return compare(other) != 0;
+    // an invalid type is not equal to anything (even itself), which operator== already takes care of
+    return !operator==(other);
 }
 
 int value::compare(const value& other) const
@@ -486,9 +650,12 @@ std::ostream& operator<<(std::ostream& stream, const value& val)
 
 std::string to_string(const value& val)
 {
-    std::ostringstream os;
-    os << val;
-    return os.str();
+    // Knowing the size up front means the text is encoded straight into the result, with no growing or copying
+    std::string            out(encoded_size(val), '\0');
+    detail::output_buffer  buffer(&out[0], out.size(), detail::output_buffer::flush_function());
+    detail::compact_writer writer(buffer, true);
+    encode_static(val, writer);
+    return out;
 }
 
 bool value::empty() const noexcept
@@ -500,7 +667,7 @@ bool value::empty() const noexcept
     case jsonv::kind::array:
         return _data.array->empty();
     case jsonv::kind::string:
-        return _data.string->_string.empty();
+        return _data.string->view().empty();
     case jsonv::kind::null:
         return true; // by definition a null value is empty
     case jsonv::kind::integer:
@@ -524,7 +691,7 @@ value::size_type value::size() const
     case jsonv::kind::array:
         return _data.array->size();
     case jsonv::kind::string:
-        return _data.string->_string.size();
+        return _data.string->view().size();
     case jsonv::kind::integer:
     case jsonv::kind::decimal:
     case jsonv::kind::boolean:
@@ -535,6 +702,24 @@ value::size_type value::size() const
     }
 }
 
+void value::reserve(size_type count)
+{
+    check_type({ jsonv::kind::object, jsonv::kind::array }, kind());
+    
+    if (kind() == jsonv::kind::array)
+    {
+        detail::unshare(_data.array);
+        _data.array->values().reserve(count);
+    }
+    else
+    {
+#if JSONV_OBJECT_FLAT_STORAGE
+        detail::unshare(_data.object);
+        _data.object->_values.reserve(count);
+#endif
+    }
+}
+
 value value::map(const std::function<value (const value&)>& func) const&
 {
     return jsonv::map(func, *this);
@@ -559,40 +744,98 @@ const value null = value();
 namespace std
 {
 
-template <typename TForwardIterator, typename FHasher>
-static std::size_t hash_range(TForwardIterator first, TForwardIterator last, const FHasher& hasher)
+// Each kind starts from a different seed, so (for example) an empty array and an empty object do not collide.
+static constexpr std::uint64_t hash_seed_null    = 0x51afb2fe9467d0f7ULL;
+static constexpr std::uint64_t hash_seed_boolean = 0x9e3779b97f4a7c15ULL;
+static constexpr std::uint64_t hash_seed_number  = 0xc2b2ae3d27d4eb4fULL;
+static constexpr std::uint64_t hash_seed_string  = 0x165667b19e3779f9ULL;
+static constexpr std::uint64_t hash_seed_array   = 0x27d4eb2f165667c5ULL;
+static constexpr std::uint64_t hash_seed_object  = 0x85ebca77c2b2ae63ULL;
+
+/** Integers and decimals which compare equal must hash the same, so whole decimals are hashed as integers. **/
+static std::uint64_t hash_number(double x)
+{
+    if (x >= -9223372036854775808.0 && x < 9223372036854775808.0)
+    {
+        std::int64_t whole = static_cast<std::int64_t>(x);
+        if (static_cast<double>(whole) == x)
+            return jsonv::detail::hash_combine(hash_seed_number, static_cast<std::uint64_t>(whole));
+    }
+    
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof bits);
+    return jsonv::detail::hash_combine(~hash_seed_number, bits);
+}
+
+static std::uint64_t hash_string(jsonv::string_view x, std::uint64_t seed)
+{
+    return jsonv::detail::hash_bytes(x.data(), x.size(), seed);
+}
+
+/** Hash an object or array, or get the hash from \a impl if it was already worked out. Hashes are only kept while the
+ *  storage is shareable, since the storage can not change until \c detail::unshare forgets the hash.
+**/
+template <typename TImpl, typename FHash>
+static std::size_t hash_aggregate(const TImpl* impl, const FHash& compute)
 {
-    std::size_t x = 0;
-    for ( ; first != last; ++first)
-        x = (x << 1) ^ hasher(*first);
+    bool cacheable = impl->_shareable.load(std::memory_order_relaxed);
+    if (cacheable)
+        if (std::size_t cached = impl->_hash.load(std::memory_order_relaxed))
+            return cached;
     
+    std::size_t x = static_cast<std::size_t>(compute());
+    if (cacheable)
+        impl->_hash.store(x, std::memory_order_relaxed);
     return x;
 }
 
 size_t hash<jsonv::value>::operator()(const jsonv::value& val) const noexcept
 {
     using namespace jsonv;
+    using jsonv::detail::hash_combine;
     
     switch (val.kind())
     {
     case jsonv::kind::object:
-        return hash_range(val.begin_object(), val.end_object(),
-                          [] (const value::object_value_type& x) { return std::hash<std::string>()(x.first)
-                                                                        ^ std::hash<value>()(x.second);
-                                                                 }
-                         );
+        return hash_aggregate(val._data.object,
+                              [&]
+                              {
+                                  std::uint64_t x = hash_combine(hash_seed_object, val.size());
+                                  for (const auto& entry : val._data.object->_values)
+                                      x = hash_combine(hash_combine(x, hash_string(entry.first, hash_seed_string)),
+                                                       (*this)(entry.second)
+                                                      );
+                                  return x;
+                              }
+                             );
     case jsonv::kind::array:
-        return hash_range(val.begin_array(), val.end_array(), hash<jsonv::value>());
+        return hash_aggregate(val._data.array,
+                              [&]
+                              {
+                                  std::uint64_t x = hash_combine(hash_seed_array, val.size());
+                                  // Packed elements hash the same as the values they would be made into
+                                  if (const std::int64_t* integers = val.packed_integers())
+                                      for (std::size_t idx = 0, count = val.size(); idx < count; ++idx)
+                                          x = hash_combine(x, (*this)(value(integers[idx])));
+                                  else if (const double* decimals = val.packed_decimals())
+                                      for (std::size_t idx = 0, count = val.size(); idx < count; ++idx)
+                                          x = hash_combine(x, (*this)(value(decimals[idx])));
+                                  else
+                                      for (const value& elem : jsonv::detail::as_const(val._data.array)->values())
+                                          x = hash_combine(x, (*this)(elem));
+                                  return x;
+                              }
+                             );
     case jsonv::kind::string:
-        return std::hash<std::string>()(val.as_string());
+        return static_cast<std::size_t>(hash_string(val.as_string_view(), hash_seed_string));
     case jsonv::kind::integer:
-        return std::hash<std::int64_t>()(val.as_integer());
+        return static_cast<std::size_t>(hash_combine(hash_seed_number, static_cast<std::uint64_t>(val.as_integer())));
     case jsonv::kind::decimal:
-        return std::hash<double>()(val.as_decimal());
+        return static_cast<std::size_t>(hash_number(val.as_decimal()));
     case jsonv::kind::boolean:
-        return std::hash<bool>()(val.as_boolean());
+        return static_cast<std::size_t>(hash_combine(hash_seed_boolean, val.as_boolean() ? 1U : 0U));
     case jsonv::kind::null:
-        return 0x51afb2fe9467d0f7ULL;
+        return static_cast<std::size_t>(hash_seed_null);
     default:
         // Should never hit this...
         return 0ULL;
@@ -0,0 +1,169 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/value_index.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace jsonv
+{
+
+constexpr value_index::size_type value_index::npos;
+
+value_index::value_index(const value& source, const path& key_path) :
+        value_index(source, std::vector<path>({ key_path }))
+{ }
+
+value_index::value_index(const value& source, const std::vector<path>& key_paths) :
+        _source(&source),
+        _key_paths(key_paths.begin(), key_paths.end())
+{
+    if (key_paths.empty())
+        throw std::invalid_argument("A value_index needs at least one key path");
+    if (source.kind() != kind::array)
+        throw kind_error(std::string("A value_index can only be built over an array, not a ")
+                         + to_string(source.kind())
+                        );
+
+    rebuild();
+}
+
+value_index::size_type value_index::size() const
+{
+    return _entries.size();
+}
+
+value_index::size_type value_index::find(const value& key) const
+{
+    auto iter = _entries.find(key);
+    return iter == _entries.end() ? npos : iter->second.front();
+}
+
+const std::vector<value_index::size_type>& value_index::find_all(const value& key) const
+{
+    static const std::vector<size_type> none;
+
+    auto iter = _entries.find(key);
+    return iter == _entries.end() ? none : iter->second;
+}
+
+value_index::size_type value_index::count(const value& key) const
+{
+    auto iter = _entries.find(key);
+    return iter == _entries.end() ? 0U : iter->second.size();
+}
+
+const value* value_index::key_of(size_type idx) const
+{
+    const entry* ent = _element_entries.at(idx);
+    return ent ? &ent->first : nullptr;
+}
+
+bool value_index::element_key(const value& element, value& out) const
+{
+    if (_key_paths.size() == 1)
+    {
+        const value* found = _key_paths.front().find(element);
+        if (!found)
+            return false;
+        out = *found;
+        return true;
+    }
+
+    out = array();
+    out.reserve(_key_paths.size());
+    for (const compiled_path& key_path : _key_paths)
+    {
+        const value* found = key_path.find(element);
+        if (!found)
+            return false;
+        out.push_back(*found);
+    }
+    return true;
+}
+
+void value_index::add(size_type idx)
+{
+    value key;
+    if (!element_key((*_source)[idx], key))
+    {
+        _element_entries[idx] = nullptr;
+        return;
+    }
+
+    entry& ent = *_entries.emplace(std::move(key), std::vector<size_type>()).first;
+    ent.second.insert(std::upper_bound(ent.second.begin(), ent.second.end(), idx), idx);
+    _element_entries[idx] = &ent;
+}
+
+void value_index::remove(size_type idx)
+{
+    entry* ent = _element_entries[idx];
+    if (!ent)
+        return;
+
+    ent->second.erase(std::lower_bound(ent->second.begin(), ent->second.end(), idx));
+    if (ent->second.empty())
+        _entries.erase(_entries.find(ent->first));
+    _element_entries[idx] = nullptr;
+}
+
+void value_index::insert(size_type idx)
+{
+    if (idx >= _source->size() || _element_entries.size() + 1 != _source->size())
+        throw std::out_of_range("The array did not have an element inserted at " + std::to_string(idx));
+
+    if (idx != _element_entries.size())
+    {
+        for (entry& ent : _entries)
+            for (size_type& x : ent.second)
+                if (x >= idx)
+                    ++x;
+    }
+    _element_entries.insert(_element_entries.begin() + idx, nullptr);
+    add(idx);
+}
+
+void value_index::erase(size_type idx)
+{
+    if (idx >= _element_entries.size())
+        throw std::out_of_range("No element at " + std::to_string(idx) + " to erase");
+
+    remove(idx);
+    _element_entries.erase(_element_entries.begin() + idx);
+    if (idx != _element_entries.size())
+    {
+        for (entry& ent : _entries)
+            for (size_type& x : ent.second)
+                if (x > idx)
+                    --x;
+    }
+}
+
+void value_index::update(size_type idx)
+{
+    if (idx >= _element_entries.size())
+        throw std::out_of_range("No element at " + std::to_string(idx) + " to update");
+
+    remove(idx);
+    add(idx);
+}
+
+void value_index::rebuild()
+{
+    _entries.clear();
+    _element_entries.assign(_source->size(), nullptr);
+    _entries.reserve(_source->size());
+    for (size_type idx = 0; idx < _source->size(); ++idx)
+        add(idx);
+}
+
+}
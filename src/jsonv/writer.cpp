@@ -0,0 +1,194 @@
+/** \file
+ *
+ *  Copyright (c) 2018 by Travis Gockel. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the Apache License
+ *  as published by the Apache Software Foundation, either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  \author Travis Gockel (travis@gockelhut.com)
+**/
+#include <jsonv/writer.hpp>
+#include <jsonv/encode.hpp>
+#include <jsonv/value.hpp>
+
+#include <stdexcept>
+
+namespace jsonv
+{
+
+writer::writer(encoder& out) :
+        _out(out),
+        _complete(false)
+{ }
+
+writer::~writer() noexcept = default;
+
+void writer::before_value()
+{
+    if (_complete)
+        throw std::logic_error("writer: the document is already complete");
+    if (_stack.empty())
+        return;
+
+    frame& top = _stack.back();
+    if (top.object)
+    {
+        if (!top.has_key)
+            throw std::logic_error("writer: a value in an object must follow a key");
+    }
+    else if (!top.empty)
+    {
+        _out.write_array_delimiter();
+    }
+}
+
+void writer::after_value()
+{
+    if (_stack.empty())
+    {
+        _complete = true;
+    }
+    else
+    {
+        frame& top = _stack.back();
+        top.empty   = false;
+        top.has_key = false;
+    }
+}
+
+writer& writer::begin_object()
+{
+    before_value();
+    _out.write_object_begin();
+    _stack.push_back(frame{ true, true, false });
+    return *this;
+}
+
+writer& writer::end_object()
+{
+    if (_stack.empty() || !_stack.back().object)
+        throw std::logic_error("writer: end_object without a matching begin_object");
+    if (_stack.back().has_key)
+        throw std::logic_error("writer: end_object after a key without a value");
+
+    _out.write_object_end();
+    _stack.pop_back();
+    after_value();
+    return *this;
+}
+
+writer& writer::begin_array()
+{
+    before_value();
+    _out.write_array_begin();
+    _stack.push_back(frame{ false, true, false });
+    return *this;
+}
+
+writer& writer::end_array()
+{
+    if (_stack.empty() || _stack.back().object)
+        throw std::logic_error("writer: end_array without a matching begin_array");
+
+    _out.write_array_end();
+    _stack.pop_back();
+    after_value();
+    return *this;
+}
+
+writer& writer::key(string_view key)
+{
+    if (_stack.empty() || !_stack.back().object)
+        throw std::logic_error("writer: a key can only be written in an object");
+
+    frame& top = _stack.back();
+    if (top.has_key)
+        throw std::logic_error("writer: two keys in a row");
+
+    if (!top.empty)
+        _out.write_object_delimiter();
+    _out.write_object_key(key);
+    top.has_key = true;
+    return *this;
+}
+
+writer& writer::value(const jsonv::value& value)
+{
+    before_value();
+    _out.encode(value);
+    after_value();
+    return *this;
+}
+
+writer& writer::value(std::nullptr_t)
+{
+    return null();
+}
+
+writer& writer::value(bool value)
+{
+    before_value();
+    _out.write_boolean(value);
+    after_value();
+    return *this;
+}
+
+writer& writer::value(string_view value)
+{
+    return write_string(value);
+}
+
+writer& writer::value(const std::string& value)
+{
+    return write_string(value);
+}
+
+writer& writer::value(const char* value)
+{
+    return write_string(value);
+}
+
+writer& writer::null()
+{
+    before_value();
+    _out.write_null();
+    after_value();
+    return *this;
+}
+
+writer& writer::write_integer(std::int64_t value)
+{
+    before_value();
+    _out.write_integer(value);
+    after_value();
+    return *this;
+}
+
+writer& writer::write_decimal(double value)
+{
+    before_value();
+    _out.write_decimal(value);
+    after_value();
+    return *this;
+}
+
+writer& writer::write_string(string_view value)
+{
+    before_value();
+    _out.write_string(value);
+    after_value();
+    return *this;
+}
+
+std::size_t writer::depth() const
+{
+    return _stack.size();
+}
+
+bool writer::complete() const
+{
+    return _complete;
+}
+
+}